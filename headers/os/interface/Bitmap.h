@@ -140,7 +140,7 @@ private:
 			BWindow*			fWindow;
 			int32				fServerToken;
 			int32				fAreaOffset;
-			uint8				unused;
+			bool				fBitsChanged;
 			area_id				fArea;
 			area_id				fServerArea;
 			uint32				fFlags;
@@ -15,6 +15,7 @@ class BShape;
 
 namespace BPrivate {
 	class ServerLink;
+	class PictureDisplayList;
 	class PicturePlayer;
 };
 
@@ -93,6 +94,7 @@ private:
 	friend class BShapeIterator;
 	friend class BView;
 	friend class BFont;
+	friend class BPrivate::PictureDisplayList;
 	friend class BPrivate::PicturePlayer;
 	friend class BPrivate::ServerLink;
 
@@ -343,6 +343,7 @@ private:
 			bool				IsFilePanel() const;
 
 			void				_CreateTopView();
+			void				_CreateLinkRing();
 			void				_AdoptResize();
 			void				_SetFocus(BView* focusView,
 									bool notifyIputServer = false);
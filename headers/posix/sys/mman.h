@@ -39,6 +39,11 @@
 #define POSIX_MADV_WILLNEED		4
 #define POSIX_MADV_DONTNEED		5
 
+/* Haiku extension: the contents of the range are no longer needed, and its
+   pages may be reused; they read as zeros afterwards, unless the range is
+   shared with others. */
+#define MADV_FREE				6
+
 
 __BEGIN_DECLS
 
@@ -21,6 +21,8 @@ class BRegion;
 
 namespace BPrivate {
 
+struct link_ring;
+
 class LinkReceiver {
 	public:
 		LinkReceiver(port_id port);
@@ -29,6 +31,8 @@ class LinkReceiver {
 		void SetPort(port_id port);
 		port_id	Port(void) const { return fReceivePort; }
 
+		void SetRing(link_ring* ring, sem_id spaceSemaphore);
+
 		status_t GetNextMessage(int32& code, bigtime_t timeout = B_INFINITE_TIMEOUT);
 		bool HasMessages() const;
 		bool NeedsReply() const;
@@ -60,6 +64,19 @@ class LinkReceiver {
 		int32	fReplySize;	//size of current reply message
 
 		status_t fReadError;	//Read failed for current message
+
+	private:
+		status_t _ReadFromRing(bool& _waiting);
+		status_t _ReadRingRecord();
+		void _AdvanceRing(uint32 size);
+		void _StopWaitingForRing();
+		int32 _RingWakeupsInPort() const;
+
+		link_ring* fRing;
+		sem_id	fRingSpaceSemaphore;
+		uint32	fRingReadPosition;
+		uint32	fRingReads;
+		int32	fRingWakeupsRead;	// wake-up messages read from the port
 };
 
 }	// namespace BPrivate
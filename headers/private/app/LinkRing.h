@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _LINK_RING_H
+#define _LINK_RING_H
+
+
+#include <SupportDefs.h>
+
+
+namespace BPrivate {
+
+
+static const uint32 kLinkRingSize = 128 * 1024;
+	// must be a power of two, and hold at least one full link buffer
+
+static const uint32 kLinkRingWrapCode = 'lrwp';
+	// fills the rest of the ring, the next record starts at its beginning
+
+
+/*!	A ring buffer in memory shared between a LinkSender and a LinkReceiver
+	of different teams. It carries the same data a port message would, and
+	the port is only used to wake up the receiver when it is waiting.
+
+	The positions only ever grow, and are taken modulo kLinkRingSize. The
+	two sides are kept in different cache lines.
+*/
+struct link_ring {
+	// written by the sender
+	int32			write_position;
+	int32			writer_waiting;
+	int32			wakeups;		// wake-up messages written to the port
+	uint8			_reserved0[52];
+
+	// written by the receiver
+	int32			read_position;
+	int32			reader_waiting;
+	uint8			_reserved1[56];
+
+	uint8			data[kLinkRingSize];
+};
+
+struct link_ring_record {
+	uint32			size;
+	uint32			code;
+};
+
+
+static inline uint32
+link_ring_record_size(uint32 dataSize)
+{
+	return sizeof(link_ring_record) + ((dataSize + 7) & ~(uint32)7);
+}
+
+
+}	// namespace BPrivate
+
+
+#endif	// _LINK_RING_H
@@ -16,6 +16,8 @@
 
 namespace BPrivate {
 	
+struct link_ring;
+
 class LinkSender {
 	public:
 		LinkSender(port_id sendport);
@@ -27,6 +29,9 @@ class LinkSender {
 		team_id TargetTeam() const;
 		void SetTargetTeam(team_id team);
 
+		void SetRing(link_ring* ring, sem_id spaceSemaphore);
+		link_ring* Ring() const { return fRing; }
+
 		status_t StartMessage(int32 code, size_t minSize = 0);
 		void CancelMessage(void);
 		status_t EndMessage(bool needsReply = false);
@@ -57,6 +62,16 @@ class LinkSender {
 		uint32	fCurrentStart;		// start of current message
 
 		status_t fCurrentStatus;
+
+	private:
+		status_t _FlushToRing(bigtime_t timeout);
+		status_t _WaitForRingSpace(uint32 size, bigtime_t timeout);
+		void _WriteRingRecord(uint32 position, uint32 code, const void* data,
+			uint32 size);
+		void _PublishRing(uint32 position);
+
+		link_ring* fRing;
+		sem_id	fRingSpaceSemaphore;
 };
 
 
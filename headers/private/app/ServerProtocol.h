@@ -108,6 +108,7 @@ enum {
 	AS_SET_SIZE_LIMITS,
 	AS_ACTIVATE_WINDOW,
 	AS_IS_FRONT_WINDOW,
+	AS_CREATE_LINK_RING,
 
 	// BPicture definitions
 	AS_CREATE_PICTURE,
@@ -351,6 +352,7 @@ enum {
 	// debugging helper
 	AS_DUMP_ALLOCATOR,
 	AS_DUMP_BITMAPS,
+	AS_DUMP_BACKING_STORES,
 
 	// transformation in addition to origin/scale
 	AS_VIEW_SET_TRANSFORM,
@@ -91,6 +91,7 @@ struct ViewDrawBitmapInfo {
 	uint32						options;
 	BRect						viewRect;
 	BRect						bitmapRect;
+	bool						bitsChanged;
 };
 
 
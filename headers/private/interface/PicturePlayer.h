@@ -17,6 +17,7 @@
 #include <InterfaceDefs.h>
 #include <Point.h>
 #include <Rect.h>
+#include <Referenceable.h>
 
 
 class BAffineTransform;
@@ -114,6 +115,37 @@ private:
 	BList*		fPictures;
 };
 
+
+/*!	The ops of picture data, parsed and validated once, so that they can be
+	played any number of times without looking at the data again. The list
+	points into the picture data, which must not change while it is in use.
+*/
+class PictureDisplayList : public BReferenceable {
+public:
+	PictureDisplayList();
+	virtual	~PictureDisplayList();
+
+	status_t	Compile(const void* data, size_t size);
+	status_t	Play(const picture_player_callbacks& callbacks,
+					size_t callbacksSize, void* userData) const;
+
+	int32		CountOps() const { return fCount; }
+	uint16		OpAt(int32 index) const;
+	const void*	OpDataAt(int32 index) const;
+
+private:
+	struct op_entry;
+
+	status_t	_Compile(const void* data, size_t length, uint16 parentOp);
+	status_t	_AddOp(uint16 op, uint16 flags, uint32 count,
+					const void* data);
+
+	op_entry*	fOps;
+	int32		fCount;
+	int32		fCapacity;
+	status_t	fStatus;
+};
+
 } // namespace BPrivate
 
 #endif // _PICTURE_PLAYER_H
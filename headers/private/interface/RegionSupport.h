@@ -77,6 +77,10 @@ class BRegion::Support {
 	static	int					XRectInRegion(const BRegion* region,
 									const clipping_rect& rect);
 
+	static	void				AcquireSpareData(BRegion* region,
+									int32 count);
+	static	void				RecycleData(clipping_rect* data, int32 size);
+
  private:
 	static	BRegion*			CreateRegion();
 	static	void				DestroyRegion(BRegion* r);
@@ -67,7 +67,8 @@ enum fd_types {
 	FDTYPE_INDEX,
 	FDTYPE_INDEX_DIR,
 	FDTYPE_QUERY,
-	FDTYPE_SOCKET
+	FDTYPE_SOCKET,
+	FDTYPE_EVENT_QUEUE
 };
 
 // additional open mode - kernel special
@@ -78,6 +79,8 @@ enum fd_types {
 extern struct file_descriptor *alloc_fd(void);
 extern int new_fd_etc(struct io_context *, struct file_descriptor *, int firstIndex);
 extern int new_fd(struct io_context *, struct file_descriptor *);
+extern status_t replace_fd(struct io_context *, int,
+	struct file_descriptor *);
 extern struct file_descriptor *get_fd(struct io_context *, int);
 extern struct file_descriptor *get_open_fd(struct io_context *, int);
 extern void close_fd(struct file_descriptor *descriptor);
@@ -88,6 +91,7 @@ extern void inc_fd_ref_count(struct file_descriptor *descriptor);
 extern int dup_foreign_fd(team_id fromTeam, int fd, bool kernel);
 extern status_t select_fd(int32 fd, struct select_info *info, bool kernel);
 extern status_t deselect_fd(int32 fd, struct select_info *info, bool kernel);
+extern void deselect_all_fds(struct io_context *context);
 extern bool fd_is_valid(int fd, bool kernel);
 extern struct vnode *fd_vnode(struct file_descriptor *descriptor);
 
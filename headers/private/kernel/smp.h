@@ -91,6 +91,10 @@ int32 smp_get_current_cpu(void);
 
 int smp_intercpu_int_handler(int32 cpu);
 
+#if B_DEBUG_SPINLOCK_CONTENTION
+uint64 get_spinlock_counter(spinlock* lock);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -277,6 +277,11 @@ struct Team : TeamThreadIteratorEntry<team_id>, KernelReferenceable,
 	bigtime_t		cpu_clock_offset;
 	spinlock		time_lock;
 
+	// page faults of the team's threads, updated atomically; major faults
+	// are the ones that had to read the page from its backing store
+	int64			minor_faults;
+	int64			major_faults;
+
 	// user group information; protected by fLock
 	uid_t			saved_set_uid;
 	uid_t			real_uid;
@@ -6,7 +6,7 @@
 #define _KERNEL_USER_MUTEX_H
 
 
-#include <SupportDefs.h>
+#include <KernelExport.h>
 
 
 #ifdef __cplusplus
@@ -14,12 +14,17 @@ extern "C" {
 #endif
 
 void		user_mutex_init();
+#if B_DEBUG_SPINLOCK_CONTENTION
+uint64		user_mutex_get_spinlock_counter();
+#endif
 
 status_t	_user_mutex_lock(int32* mutex, const char* name, uint32 flags,
 				bigtime_t timeout);
 status_t	_user_mutex_unlock(int32* mutex, uint32 flags);
 status_t	_user_mutex_switch_lock(int32* fromMutex, int32* toMutex,
 				const char* name, uint32 flags, bigtime_t timeout);
+status_t	_user_mutex_requeue(int32* mutex, int32* toMutex,
+				int32 wakeCount);
 status_t	_user_mutex_sem_acquire(int32* sem, const char* name, uint32 flags,
 				bigtime_t timeout);
 status_t	_user_mutex_sem_release(int32* sem);
@@ -70,6 +70,8 @@ status_t	vfs_init(struct kernel_args *args);
 status_t	vfs_bootstrap_file_systems(void);
 void		vfs_mount_boot_file_system(struct kernel_args *args);
 void		vfs_exec_io_context(io_context *context);
+status_t	vfs_open_in_io_context(io_context* context, int fd,
+				const char* path, int openMode, int perms);
 io_context*	vfs_new_io_context(io_context* parentContext,
 				bool purgeCloseOnExec);
 void		vfs_get_io_context(io_context *context);
@@ -39,6 +39,13 @@ public:
 									vm_page_reservation* reservation) = 0;
 	virtual	status_t			Unmap(addr_t start, addr_t end) = 0;
 
+	// large pages -- optional
+	virtual	size_t				LargePageSize() const;
+	virtual	status_t			MapLargePage(addr_t virtualAddress,
+									phys_addr_t physicalAddress,
+									uint32 attributes, uint32 memoryType,
+									vm_page_reservation* reservation);
+
 	virtual	status_t			DebugMarkRangePresent(addr_t start, addr_t end,
 									bool markPresent);
 
@@ -16,6 +16,8 @@
 struct kernel_args;
 
 extern int32 gMappedPagesCount;
+extern int32 gMappedLargePagesCount;
+extern int32 gLargePageSplitCount;
 
 
 struct vm_page_reservation {
@@ -63,6 +65,8 @@ bool vm_page_try_reserve_pages(vm_page_reservation* reservation, uint32 count,
 
 struct vm_page *vm_page_allocate_page(vm_page_reservation* reservation,
 	uint32 flags);
+void vm_page_allocate_pages(vm_page_reservation* reservation, uint32 flags,
+	struct vm_page** pages, uint32 count);
 struct vm_page *vm_page_allocate_page_run(uint32 flags, page_num_t length,
 	const physical_address_restrictions* restrictions, int priority);
 struct vm_page *vm_page_at_index(int32 index);
@@ -21,12 +21,15 @@ typedef struct select_info {
 	uint16				selected_events;
 } select_info;
 
-typedef struct select_sync {
+#ifdef __cplusplus
+struct select_sync {
 	int32				ref_count;
-	sem_id				sem;
-	uint32				count;
-	struct select_info*	set;
-} select_sync;
+
+	virtual				~select_sync();
+
+	virtual	status_t	Notify(select_info* info, uint16 events) = 0;
+};
+#endif
 
 #define SELECT_FLAG(type) (1L << (type - 1))
 
@@ -39,6 +39,7 @@ void __heap_terminate_after(void);
 void __heap_before_fork(void);
 void __heap_after_fork_child(void);
 void __heap_after_fork_parent(void);
+void __heap_thread_exit(void);
 
 void __init_time(addr_t commPageTable);
 void __arch_init_time(struct real_time_data *data, bool setDefaults);
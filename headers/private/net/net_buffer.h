@@ -35,8 +35,17 @@ typedef struct net_buffer {
 	uint32					flags;
 	uint32					size;
 	uint8					protocol;
+	uint8					offload_flags;
+	uint16					segment_size;
+		// if non-zero, the buffer carries a TCP super-segment that has to be
+		// split into segments with that much payload before it hits the wire
 } net_buffer;
 
+// net_buffer::offload_flags
+#define NET_BUFFER_CHECKSUM_VERIFIED	0x01
+	// the transport checksum has already been verified, and may no longer
+	// match the contents
+
 struct ancillary_data_container;
 
 struct net_buffer_module_info {
@@ -31,12 +31,18 @@ typedef struct net_device {
 	uint64	link_speed;
 	uint32	link_quality;
 	size_t	header_length;
+	uint32	offload_flags;	// NET_DEVICE_OFFLOAD_*
 
 	struct net_hardware_address address;
 
 	struct ifreq_stats stats;
 } net_device;
 
+// net_device::offload_flags
+#define NET_DEVICE_OFFLOAD_TCP_SEGMENTATION	0x01
+	// the device accepts buffers with a net_buffer::segment_size, and
+	// takes care of splitting them itself
+
 
 struct net_device_module_info {
 	struct module_info info;
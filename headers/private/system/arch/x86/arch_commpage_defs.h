@@ -18,5 +18,11 @@
 									(COMMPAGE_ENTRY_FIRST_ARCH_SPECIFIC + 4)
 #define COMMPAGE_ENTRY_X86_THREAD_EXIT \
 									(COMMPAGE_ENTRY_FIRST_ARCH_SPECIFIC + 5)
+#define COMMPAGE_ENTRY_X86_CPU_FEATURES \
+									(COMMPAGE_ENTRY_FIRST_ARCH_SPECIFIC + 6)
+
+/* bits in the COMMPAGE_ENTRY_X86_CPU_FEATURES word: instruction set extensions
+   all CPUs support, and whose register state the kernel preserves */
+#define X86_CPU_FEATURE_AVX2	0x01
 
 #endif	/* _SYSTEM_ARCH_x86_COMMPAGE_DEFS_H */
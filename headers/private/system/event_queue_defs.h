@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_EVENT_QUEUE_DEFS_H
+#define _SYSTEM_EVENT_QUEUE_DEFS_H
+
+
+#include <OS.h>
+
+
+// operations for _kern_event_queue_control()
+enum {
+	B_EVENT_QUEUE_ADD		= 1,
+	B_EVENT_QUEUE_MODIFY,
+	B_EVENT_QUEUE_REMOVE
+};
+
+// additional flags for event_wait_info::events
+#define B_EVENT_LEVEL_TRIGGERED		0x00000000
+	// the event is reported as long as the condition is true (default)
+#define B_EVENT_EDGE_TRIGGERED		0x00100000
+	// the event is only reported when the condition becomes true
+#define B_EVENT_ONE_SHOT			0x00200000
+	// the object is disabled after the event has been reported once, until
+	// it is modified again
+
+#define B_EVENT_QUEUE_FLAGS			(B_EVENT_EDGE_TRIGGERED | B_EVENT_ONE_SHOT)
+
+
+typedef struct event_wait_info {
+	int32		object;
+	uint16		type;		// only B_OBJECT_TYPE_FD is supported
+	int32		events;
+	void*		user_data;
+} event_wait_info;
+
+
+#endif	/* _SYSTEM_EVENT_QUEUE_DEFS_H */
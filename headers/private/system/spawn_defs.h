@@ -0,0 +1,43 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_SPAWN_DEFS_H
+#define _SYSTEM_SPAWN_DEFS_H
+
+
+#include <signal.h>
+
+#include <SupportDefs.h>
+
+
+#define MAX_SPAWN_FILE_ACTIONS	1024
+
+
+// spawn_file_action::type
+enum {
+	SPAWN_FILE_ACTION_OPEN	= 0,
+	SPAWN_FILE_ACTION_CLOSE,
+	SPAWN_FILE_ACTION_DUP2
+};
+
+
+struct spawn_file_action {
+	int32		type;
+	int32		fd;
+	int32		source_fd;		// SPAWN_FILE_ACTION_DUP2
+	int32		open_mode;		// SPAWN_FILE_ACTION_OPEN
+	mode_t		permissions;	// SPAWN_FILE_ACTION_OPEN
+	const char*	path;			// SPAWN_FILE_ACTION_OPEN
+};
+
+
+struct spawn_attributes {
+	uint32		flags;			// POSIX_SPAWN_* flags from <spawn.h>
+	pid_t		process_group;
+	sigset_t	signal_mask;
+	sigset_t	default_signals;
+};
+
+
+#endif	/* _SYSTEM_SPAWN_DEFS_H */
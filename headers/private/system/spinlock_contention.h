@@ -15,6 +15,7 @@
 typedef struct spinlock_contention_info {
 	uint64	thread_spinlock_counter;
 	uint64	team_spinlock_counter;
+	uint64	user_mutex_spinlock_counter;
 } spinlock_contention_info;
 
 
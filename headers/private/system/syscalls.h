@@ -23,6 +23,7 @@ extern "C" {
 
 struct attr_info;
 struct dirent;
+struct event_wait_info;
 struct fd_info;
 struct fd_set;
 struct fs_info;
@@ -37,6 +38,8 @@ struct sembuf;
 union semun;
 struct sigaction;
 struct signal_frame_data;
+struct spawn_attributes;
+struct spawn_file_action;
 struct stat;
 struct system_profiler_parameters;
 struct user_timer_info;
@@ -74,12 +77,22 @@ extern status_t		_kern_get_safemode_option(const char *parameter,
 extern ssize_t		_kern_wait_for_objects(object_wait_info* infos, int numInfos,
 						uint32 flags, bigtime_t timeout);
 
+/* event queue functions */
+extern int			_kern_event_queue_create(int openFlags);
+extern status_t		_kern_event_queue_control(int queue, int operation,
+						struct event_wait_info* info);
+extern ssize_t		_kern_event_queue_wait(int queue,
+						struct event_wait_info* infos, int numInfos,
+						uint32 flags, bigtime_t timeout);
+
 /* user mutex functions */
 extern status_t		_kern_mutex_lock(int32* mutex, const char* name,
 						uint32 flags, bigtime_t timeout);
 extern status_t		_kern_mutex_unlock(int32* mutex, uint32 flags);
 extern status_t		_kern_mutex_switch_lock(int32* fromMutex, int32* toMutex,
 						const char* name, uint32 flags, bigtime_t timeout);
+extern status_t		_kern_mutex_requeue(int32* mutex, int32* toMutex,
+						int32 wakeCount);
 extern status_t		_kern_mutex_sem_acquire(int32* sem, const char* name,
 						uint32 flags, bigtime_t timeout);
 extern status_t		_kern_mutex_sem_release(int32* sem);
@@ -146,6 +159,12 @@ extern status_t		_kern_exec(const char *path, const char* const* flatArgs,
 						size_t flatArgsSize, int32 argCount, int32 envCount,
 						mode_t umask);
 extern thread_id	_kern_fork(void);
+extern thread_id	_kern_spawn(const char* path,
+						const char* const* flatArgs, size_t flatArgsSize,
+						int32 argCount, int32 envCount, mode_t umask,
+						const struct spawn_file_action* fileActions,
+						int32 fileActionCount,
+						const struct spawn_attributes* attributes);
 extern pid_t		_kern_process_info(pid_t process, int32 which);
 extern pid_t		_kern_setpgid(pid_t process, pid_t group);
 extern pid_t		_kern_setsid(void);
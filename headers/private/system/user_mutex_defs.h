@@ -12,6 +12,12 @@
 	// state will be locked.
 
 
+// returned by _kern_mutex_switch_lock() instead of B_OK, when the waiting
+// thread has been moved over to fromMutex by _kern_mutex_requeue(), and has
+// then been handed fromMutex
+#define B_USER_MUTEX_REQUEUED		1
+
+
 // mutex value flags
 #define B_USER_MUTEX_LOCKED		0x01
 #define B_USER_MUTEX_WAITING	0x02
@@ -34,8 +34,14 @@
 #define B_KERNEL_AREA			0x4000
 	// Usable from userland according to its protection flags, but the area
 	// itself is not deletable, resizable, etc from userland.
-
-#define B_USER_AREA_FLAGS		(B_USER_PROTECTION | B_OVERCOMMITTING_AREA)
+#define B_LARGE_PAGE_AREA		0x8000
+	// Map the area with large pages where possible. Only for anonymous
+	// B_NO_LOCK, B_FULL_LOCK and B_CONTIGUOUS areas that don't overcommit,
+	// creating any other area with it fails. B_NO_LOCK areas are populated
+	// when they are created then.
+
+#define B_USER_AREA_FLAGS \
+	(B_USER_PROTECTION | B_OVERCOMMITTING_AREA)
 #define B_KERNEL_AREA_FLAGS \
 	(B_KERNEL_PROTECTION | B_USER_CLONEABLE_AREA | B_SHARED_AREA)
 
@@ -61,6 +61,8 @@ loopback_init(const char *name, net_device **_device)
 	device->type = IFT_LOOP;
 	device->mtu = 16384;
 	device->media = IFM_ACTIVE;
+	device->offload_flags = NET_DEVICE_OFFLOAD_TCP_SEGMENTATION;
+		// super-segments can just be passed through as is
 
 	*_device = device;
 	return B_OK;
@@ -2103,6 +2103,21 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 		uint32 segmentMaxSize = fSendMaxSegmentSize
 			- tcp_options_length(segment);
 		uint32 segmentLength = min_c(length, segmentMaxSize);
+		uint32 segmentCount = 1;
+
+		if (!retransmit && length >= 2 * segmentMaxSize
+			&& _CanOffloadSegmentation(segment)) {
+			// Send as many full sized segments as possible in one buffer, and
+			// let the datalink layer (or the device) split them up
+			uint32 count = min_c(length, TCP_MAX_SEGMENTATION_SIZE)
+				/ segmentMaxSize;
+			if (fState == ESTABLISHED)
+				count = min_c(count, fSendMaxSegments);
+			if (count > 1) {
+				segmentCount = count;
+				segmentLength = count * segmentMaxSize;
+			}
+		}
 
 		if (fSendNext + segmentLength == fSendQueue.LastSequence()) {
 			if (state_needs_finish(fState))
@@ -2112,8 +2127,8 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 		}
 
 		// Determine if we should really send this segment
-		if (!force && !retransmit && !_ShouldSendSegment(segment, segmentLength,
-				segmentMaxSize, flightSize)) {
+		if (!force && !retransmit && !_ShouldSendSegment(segment,
+				segmentLength / segmentCount, segmentMaxSize, flightSize)) {
 			if (fSendQueue.Available()
 				&& !gStackModule->is_timer_active(&fPersistTimer)
 				&& !gStackModule->is_timer_active(&fRetransmitTimer))
@@ -2133,6 +2148,9 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 			return status;
 		}
 
+		if (segmentCount > 1)
+			buffer->segment_size = segmentMaxSize;
+
 		LocalAddress().CopyTo(buffer->source);
 		PeerAddress().CopyTo(buffer->destination);
 
@@ -2182,7 +2200,7 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 			+ ((uint32)segment.advertised_window << fReceiveWindowShift);
 
 		if (segmentLength != 0 && fState == ESTABLISHED)
-			--fSendMaxSegments;
+			fSendMaxSegments -= segmentCount;
 
 		status = next->module->send_routed_data(next, fRoute, buffer);
 		if (status < B_OK) {
@@ -2224,6 +2242,22 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 }
 
 
+/*!	Returns whether or not the segment may be sent as part of a super-segment
+	that the lower layers split into full sized segments (generic segmentation
+	offload).
+*/
+bool
+TCPEndpoint::_CanOffloadSegmentation(const tcp_segment_header& segment) const
+{
+	// Only the datalink layer's IPv4 segmentation is available, and neither
+	// connection establishment nor urgent data can be spread over several
+	// segments
+	return Domain()->family == AF_INET
+		&& (segment.flags & (TCP_FLAG_SYNCHRONIZE | TCP_FLAG_RESET
+			| TCP_FLAG_URGENT)) == 0;
+}
+
+
 int
 TCPEndpoint::_MaxSegmentSize(const sockaddr* address) const
 {
@@ -74,6 +74,8 @@ private:
 			void		_Close();
 			void		_CancelConnectionTimers();
 			uint8		_CurrentFlags();
+			bool		_CanOffloadSegmentation(
+							const tcp_segment_header& segment) const;
 			bool		_ShouldSendSegment(tcp_segment_header& segment,
 							uint32 length, uint32 segmentMaxSize,
 							uint32 flightSize);
@@ -677,7 +677,8 @@ tcp_receive_data(net_buffer* buffer)
 	if (headerLength < sizeof(tcp_header))
 		return B_BAD_DATA;
 
-	if (Checksum::PseudoHeader(addressModule, gBufferModule, buffer,
+	if ((buffer->offload_flags & NET_BUFFER_CHECKSUM_VERIFIED) == 0
+		&& Checksum::PseudoHeader(addressModule, gBufferModule, buffer,
 			IPPROTO_TCP) != 0)
 		return B_BAD_DATA;
 
@@ -186,6 +186,9 @@ operator==(tcp_sequence a, tcp_sequence b)
 #define TCP_MAX_WINDOW					65535
 #define TCP_MAX_SEGMENT_LIFETIME		60000000	// 60 secs
 #define TCP_PERSIST_TIMEOUT				1000000		// 1 sec
+#define TCP_MAX_SEGMENTATION_SIZE		(65535 - 60 - 60)
+	// maximum payload of a super-segment, leaving room for the largest
+	// possible IP and TCP headers
 
 // Initial estimate for packet round trip time (RTT)
 #define TCP_INITIAL_RTT					2000000		// 2 secs
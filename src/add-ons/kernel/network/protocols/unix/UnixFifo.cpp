@@ -9,8 +9,12 @@
 
 #include <AutoDeleter.h>
 
+#include <KernelExport.h>
+
 #include <net_stack.h>
+#include <team.h>
 #include <util/ring_buffer.h>
+#include <vm/vm.h>
 
 #include "unix.h"
 
@@ -266,8 +270,11 @@ UnixFifo::UnixFifo(size_t capacity)
 	fWriters(),
 	fReadRequested(0),
 	fWriteRequested(0),
-	fShutdown(0)
-
+	fShutdown(0),
+	fDirectWriter(NULL),
+	fDirectTeam(-1),
+	fDirectData(NULL),
+	fDirectSize(0)
 {
 	fReadCondition.Init(this, "unix fifo read");
 	fWriteCondition.Init(this, "unix fifo write");
@@ -311,7 +318,7 @@ UnixFifo::Read(const iovec* vecs, size_t vecCount,
 	TRACE("[%ld] %p->UnixFifo::Read(%p, %ld, %lld)\n", find_thread(NULL),
 		this, vecs, vecCount, timeout);
 
-	if (IsReadShutdown() && fBuffer.Readable() == 0)
+	if (IsReadShutdown() && _BufferReadable() == 0)
 		RETURN_ERROR(UNIX_FIFO_SHUTDOWN);
 
 	UnixRequest request(vecs, vecCount, NULL);
@@ -324,16 +331,17 @@ UnixFifo::Read(const iovec* vecs, size_t vecCount,
 	fReaders.Remove(&request);
 	fReadRequested -= request.TotalSize();
 
-	if (firstInQueue && !fReaders.IsEmpty() && fBuffer.Readable() > 0
+	if (firstInQueue && !fReaders.IsEmpty() && _BufferReadable() > 0
 			&& !IsReadShutdown()) {
 		// There's more to read, other readers, and we were first in the queue.
 		// So we need to notify the others.
 		fReadCondition.NotifyAll();
 	}
 
-	if (request.BytesTransferred() > 0 && !fWriters.IsEmpty()
-			&& !IsWriteShutdown()) {
-		// We read something and there are writers. Notify them
+	if ((request.BytesTransferred() > 0 || fDirectWriter != NULL)
+		&& !fWriters.IsEmpty() && !IsWriteShutdown()) {
+		// We read something and there are writers, or a writer might wait
+		// for us to read its data directly. Notify them.
 		fWriteCondition.NotifyAll();
 	}
 
@@ -398,7 +406,7 @@ UnixFifo::Write(const iovec* vecs, size_t vecCount,
 size_t
 UnixFifo::Readable() const
 {
-	size_t readable = fBuffer.Readable();
+	size_t readable = _BufferReadable();
 	return (off_t)readable > fReadRequested ? readable - fReadRequested : 0;
 }
 
@@ -445,7 +453,7 @@ UnixFifo::_Read(UnixRequest& request, bigtime_t timeout)
 		RETURN_ERROR(B_WOULD_BLOCK);
 
 	while (fReaders.Head() != &request
-		&& !(IsReadShutdown() && fBuffer.Readable() == 0)) {
+		&& !(IsReadShutdown() && _BufferReadable() == 0)) {
 		ConditionVariableEntry entry;
 		fReadCondition.Add(&entry);
 
@@ -458,7 +466,7 @@ UnixFifo::_Read(UnixRequest& request, bigtime_t timeout)
 			RETURN_ERROR(error);
 	}
 
-	if (fBuffer.Readable() == 0) {
+	if (_BufferReadable() == 0) {
 		if (IsReadShutdown())
 			RETURN_ERROR(UNIX_FIFO_SHUTDOWN);
 
@@ -471,7 +479,7 @@ UnixFifo::_Read(UnixRequest& request, bigtime_t timeout)
 
 	// wait for any data to become available
 // TODO: Support low water marks!
-	while (fBuffer.Readable() == 0
+	while (_BufferReadable() == 0
 			&& !IsReadShutdown() && !IsWriteShutdown()) {
 		ConditionVariableEntry entry;
 		fReadCondition.Add(&entry);
@@ -485,14 +493,21 @@ UnixFifo::_Read(UnixRequest& request, bigtime_t timeout)
 			RETURN_ERROR(error);
 	}
 
-	if (fBuffer.Readable() == 0) {
+	if (_BufferReadable() == 0) {
 		if (IsReadShutdown())
 			RETURN_ERROR(UNIX_FIFO_SHUTDOWN);
 		if (IsWriteShutdown())
 			RETURN_ERROR(0);
 	}
 
-	RETURN_ERROR(fBuffer.Read(request));
+	status_t error = fBuffer.Read(request);
+
+	// A writer only offers its data directly when the buffer is empty, so
+	// this doesn't change the order of the data.
+	if (error == B_OK && fDirectSize > 0 && request.BytesRemaining() > 0)
+		error = _ReadDirect(request);
+
+	RETURN_ERROR(error);
 }
 
 
@@ -527,7 +542,20 @@ UnixFifo::_Write(UnixRequest& request, bigtime_t timeout)
 
 	status_t error = B_OK;
 
+	bool direct = gStackModule->is_syscall() && request.AncillaryData() == NULL
+		&& request.TotalSize() >= UNIX_FIFO_DIRECT_TRANSFER_THRESHOLD;
+
 	while (error == B_OK && request.BytesRemaining() > 0) {
+		// If a reader is already waiting for data, let it copy the data
+		// directly from our buffer, instead of going through the FIFO buffer.
+		if (direct && fBuffer.Readable() == 0 && !fReaders.IsEmpty()
+			&& request.BytesRemaining() >= UNIX_FIFO_DIRECT_TRANSFER_THRESHOLD) {
+			error = _WriteDirect(request, timeout);
+			if (error != B_OK)
+				RETURN_ERROR(error);
+			continue;
+		}
+
 		// wait for any space to become available
 		while (error == B_OK && fBuffer.Writable() == 0 && !IsWriteShutdown()
 				&& !IsReadShutdown()) {
@@ -576,3 +604,112 @@ UnixFifo::_WriteNonBlocking(UnixRequest& request)
 	RETURN_ERROR(fBuffer.Write(request));
 }
 
+
+/*!	Offers the current chunk of the writer's \a request to the readers, and
+	waits until they have read it directly from the writer's buffer.
+	The memory of the chunk is locked meanwhile, so that the readers can copy
+	it from the physical pages, no matter which team they are in. At most
+	\c UNIX_FIFO_MAXIMAL_DIRECT_TRANSFER bytes are offered at once; the caller
+	is expected to call this method again for the rest of the chunk.
+	Returns \c B_OK also when there are no more readers before the whole chunk
+	has been read; the caller can then continue to write the remaining data
+	into the FIFO buffer.
+*/
+status_t
+UnixFifo::_WriteDirect(UnixRequest& request, bigtime_t timeout)
+{
+	void* data;
+	size_t size;
+	if (!request.GetCurrentChunk(data, size))
+		return B_OK;
+
+	// don't let a single huge write lock down an unbounded amount of memory
+	size = min_c(size, (size_t)UNIX_FIFO_MAXIMAL_DIRECT_TRANSFER);
+
+	team_id team = team_get_current_team_id();
+	status_t error = lock_memory_etc(team, data, size, 0);
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	fDirectWriter = &request;
+	fDirectTeam = team;
+	fDirectData = (uint8*)data;
+	fDirectSize = size;
+
+	fReadCondition.NotifyAll();
+
+	while (fDirectSize > 0 && !fReaders.IsEmpty() && !IsWriteShutdown()
+			&& !IsReadShutdown()) {
+		ConditionVariableEntry entry;
+		fWriteCondition.Add(&entry);
+
+		mutex_unlock(&fLock);
+		error = entry.Wait(B_ABSOLUTE_TIMEOUT | B_CAN_INTERRUPT, timeout);
+		mutex_lock(&fLock);
+
+		if (error != B_OK)
+			break;
+	}
+
+	fDirectWriter = NULL;
+	fDirectTeam = -1;
+	fDirectData = NULL;
+	fDirectSize = 0;
+
+	unlock_memory_etc(team, data, size, 0);
+
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	if (IsWriteShutdown())
+		RETURN_ERROR(UNIX_FIFO_SHUTDOWN);
+
+	if (IsReadShutdown())
+		RETURN_ERROR(EPIPE);
+
+	return B_OK;
+}
+
+
+/*!	Copies the data offered by the first writer directly into the reader's
+	\a request.
+*/
+status_t
+UnixFifo::_ReadDirect(UnixRequest& request)
+{
+	bool user = gStackModule->is_syscall();
+	void* data;
+	size_t size;
+
+	while (fDirectSize > 0 && request.GetCurrentChunk(data, size)) {
+		if (size > fDirectSize)
+			size = fDirectSize;
+
+		physical_entry entries[8];
+		uint32 entryCount = B_COUNT_OF(entries);
+		status_t error = get_memory_map_etc(fDirectTeam, fDirectData, size,
+			entries, &entryCount);
+		if (error != B_OK && error != B_BUFFER_OVERFLOW)
+			RETURN_ERROR(error);
+
+		size_t bytesRead = 0;
+		for (uint32 i = 0; i < entryCount; i++) {
+			error = vm_memcpy_from_physical((uint8*)data + bytesRead,
+				entries[i].address, entries[i].size, user);
+			if (error != B_OK)
+				break;
+
+			bytesRead += entries[i].size;
+		}
+
+		request.AddBytesTransferred(bytesRead);
+		fDirectWriter->AddBytesTransferred(bytesRead);
+		fDirectData += bytesRead;
+		fDirectSize -= bytesRead;
+
+		if (error != B_OK)
+			RETURN_ERROR(error);
+	}
+
+	return B_OK;
+}
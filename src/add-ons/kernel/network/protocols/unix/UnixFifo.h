@@ -24,6 +24,13 @@
 #define UNIX_FIFO_MINIMAL_CAPACITY	1024
 #define UNIX_FIFO_MAXIMAL_CAPACITY	(128 * 1024)
 
+#define UNIX_FIFO_DIRECT_TRANSFER_THRESHOLD	(16 * 1024)
+	// minimal size of a userland write to be copied directly into the
+	// reader's buffer
+#define UNIX_FIFO_MAXIMAL_DIRECT_TRANSFER	UNIX_FIFO_MAXIMAL_CAPACITY
+	// maximal amount of the writer's memory locked for a direct transfer
+	// at a time
+
 
 struct ring_buffer;
 
@@ -130,6 +137,13 @@ private:
 	status_t _Read(UnixRequest& request, bigtime_t timeout);
 	status_t _Write(UnixRequest& request, bigtime_t timeout);
 	status_t _WriteNonBlocking(UnixRequest& request);
+	status_t _WriteDirect(UnixRequest& request, bigtime_t timeout);
+	status_t _ReadDirect(UnixRequest& request);
+
+	size_t _BufferReadable() const
+	{
+		return fBuffer.Readable() + fDirectSize;
+	}
 
 private:
 	mutex				fLock;
@@ -141,6 +155,12 @@ private:
 	ConditionVariable	fReadCondition;
 	ConditionVariable	fWriteCondition;
 	uint32				fShutdown;
+
+	// the chunk of the first writer that is directly read from its buffer
+	UnixRequest*		fDirectWriter;
+	team_id				fDirectTeam;
+	uint8*				fDirectData;
+	size_t				fDirectSize;
 };
 
 
@@ -28,6 +28,7 @@
 #include "domains.h"
 #include "interfaces.h"
 #include "routes.h"
+#include "segmentation.h"
 #include "stack_private.h"
 #include "utility.h"
 
@@ -370,8 +371,8 @@ datalink_send_routed_data(struct net_route* route, net_buffer* buffer)
 		set_interface_address(buffer->interface_address, address);
 
 		// this one goes back to the domain directly
-		return fifo_enqueue_buffer(
-			&interface->DeviceInterface()->receive_queue, buffer);
+		return device_interface_enqueue_buffer(interface->DeviceInterface(),
+			buffer);
 	}
 
 	if ((route->flags & RTF_GATEWAY) != 0) {
@@ -387,6 +388,13 @@ datalink_send_routed_data(struct net_route* route, net_buffer* buffer)
 	// this goes out to the datalink protocols
 	domain_datalink* datalink
 		= interface->DomainDatalink(address->domain->family);
+
+	if (buffer->segment_size != 0 && (interface->device->offload_flags
+			& NET_DEVICE_OFFLOAD_TCP_SEGMENTATION) == 0) {
+		// the device can't handle super-segments, we need to split it first
+		return send_segmented_buffer(datalink, buffer);
+	}
+
 	return datalink->first_info->send_data(datalink->first_protocol, buffer);
 }
 
@@ -10,12 +10,14 @@
 #include "device_interfaces.h"
 #include "domains.h"
 #include "interfaces.h"
+#include "segmentation.h"
 #include "stack_private.h"
 #include "utility.h"
 
 #include <net_device.h>
 
 #include <lock.h>
+#include <smp.h>
 #include <util/AutoLock.h>
 
 #include <KernelExport.h>
@@ -36,14 +38,88 @@
 #endif
 
 
+static const uint32 kMaxReceiveQueues = 16;
+static const size_t kReceiveQueueBytes = 16 * 1024 * 1024;
+	// this is shared by all receive queues of a device interface, any one of
+	// them may use all of it
+
 static mutex sLock;
 static DeviceInterfaceList sInterfaces;
 static uint32 sDeviceIndex;
 
 
+/*!	Computes a hash over the addresses and ports of the IPv4/IPv6 packet in
+	\a buffer, so that all packets of a flow end up in the same receive queue.
+	Anything else (including fragments of a later offset) is just hashed by
+	its addresses, or ends up in the first queue.
+*/
+static uint32
+flow_hash(net_buffer* buffer)
+{
+	int family;
+	if (buffer->interface_address != NULL) {
+		// locally delivered
+		if (buffer->interface_address->domain == NULL)
+			return 0;
+		family = buffer->interface_address->domain->family;
+	} else if (buffer->type == B_NET_FRAME_TYPE_IPV4)
+		family = AF_INET;
+	else if (buffer->type == B_NET_FRAME_TYPE_IPV6)
+		family = AF_INET6;
+	else
+		return 0;
+
+	uint32 words[10];
+	uint8* header = (uint8*)words;
+	uint32 hash = 0;
+	uint8 protocol;
+	size_t transportOffset;
+
+	if (family == AF_INET) {
+		if (gNetBufferModule.read(buffer, 0, header, 20) != B_OK
+			|| (header[0] >> 4) != 4)
+			return 0;
+
+		hash = words[3] ^ words[4];
+
+		protocol = header[9];
+		transportOffset = (header[0] & 0xf) << 2;
+
+		if (((header[6] << 8 | header[7]) & 0x3fff) != 0) {
+			// fragmented packet, only the first one has the ports
+			protocol = 0;
+		}
+	} else if (family == AF_INET6) {
+		if (gNetBufferModule.read(buffer, 0, header, 40) != B_OK
+			|| (header[0] >> 4) != 6)
+			return 0;
+
+		for (int i = 2; i < 10; i++)
+			hash ^= words[i];
+
+		protocol = header[6];
+		transportOffset = 40;
+	} else
+		return 0;
+
+	if (protocol == IPPROTO_TCP || protocol == IPPROTO_UDP) {
+		uint32 ports;
+		if (gNetBufferModule.read(buffer, transportOffset, &ports,
+				sizeof(ports)) == B_OK)
+			hash ^= ports;
+	}
+
+	// mix the bits, so that the lower ones are usable
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3b;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+
 /*!	A service thread for each device interface. It just reads as many packets
-	as availabe, deframes them, and puts them into the receive queue of the
-	device interface.
+	as availabe, deframes them, and puts them into one of the receive queues of
+	the device interface.
 */
 static status_t
 device_reader_thread(void* _interface)
@@ -67,7 +143,8 @@ device_reader_thread(void* _interface)
 				continue;
 			}
 
-			fifo_enqueue_buffer(&interface->receive_queue, buffer);
+			if (device_interface_enqueue_buffer(interface, buffer) != B_OK)
+				gNetBufferModule.free(buffer);
 		} else if (status == B_DEVICE_NOT_FOUND) {
 				device_removed(device);
 		} else {
@@ -81,20 +158,68 @@ device_reader_thread(void* _interface)
 }
 
 
+/*!	A service thread for each receive queue of a device interface. It pushes
+	the buffers of its queue up the stack; since each flow is always put into
+	the same queue, the threads can work in parallel without reordering the
+	packets of a flow.
+*/
 static status_t
-device_consumer_thread(void* _interface)
+device_consumer_thread(void* _queue)
 {
-	net_device_interface* interface = (net_device_interface*)_interface;
+	net_device_receive_queue* queue = (net_device_receive_queue*)_queue;
+	net_device_interface* interface = queue->interface;
 	net_device* device = interface->device;
 	net_buffer* buffer;
+	net_buffer* next = NULL;
 
 	while (true) {
-		ssize_t status = fifo_dequeue_buffer(&interface->receive_queue, 0,
-			B_INFINITE_TIMEOUT, &buffer);
-		if (status != B_OK) {
-			if (status == B_INTERRUPTED)
+		if (next != NULL) {
+			buffer = next;
+			next = NULL;
+		} else {
+			ssize_t status = fifo_dequeue_buffer(&queue->fifo, 0,
+				B_INFINITE_TIMEOUT, &buffer);
+			if (status != B_OK) {
+				if (status == B_INTERRUPTED)
+					continue;
+				break;
+			}
+
+			atomic_add(&interface->receive_queue_bytes, -(int32)buffer->size);
+		}
+
+		queue->packets++;
+		queue->bytes += buffer->size;
+
+		if (is_coalescable_segment(buffer)) {
+			// Merge the TCP segments of the same flow that are already
+			// waiting behind this one, so that they only need to travel up
+			// the stack once
+			while (fifo_dequeue_buffer(&queue->fifo, MSG_DONTWAIT, 0, &next)
+					== B_OK) {
+				size_t size = next->size;
+				atomic_add(&interface->receive_queue_bytes, -(int32)size);
+
+				bool consumed;
+				status_t status = coalesce_segments(buffer, next, consumed);
+				if (consumed) {
+					queue->packets++;
+					queue->bytes += size;
+					queue->coalesced++;
+					next = NULL;
+				}
+				if (status != B_OK) {
+					if (consumed) {
+						// the merged segment could not be completed
+						gNetBufferModule.free(buffer);
+						buffer = NULL;
+					}
+					break;
+				}
+			}
+
+			if (buffer == NULL)
 				continue;
-			break;
 		}
 
 		if (buffer->interface_address != NULL) {
@@ -113,7 +238,7 @@ device_consumer_thread(void* _interface)
 
 			// Find handler for this packet
 
-			RecursiveLocker locker(interface->receive_lock);
+			ReadLocker locker(interface->receive_funcs_lock);
 
 			DeviceHandlerList::Iterator iterator
 				= interface->receive_funcs.GetIterator();
@@ -171,14 +296,18 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	if (interface == NULL)
 		return NULL;
 
+	uint32 queueCount = min_c((uint32)smp_get_num_cpus(), kMaxReceiveQueues);
+	interface->receive_queues
+		= new(std::nothrow) net_device_receive_queue[queueCount];
+	if (interface->receive_queues == NULL) {
+		delete interface;
+		return NULL;
+	}
+
 	recursive_lock_init(&interface->receive_lock, "device interface receive");
 	recursive_lock_init(&interface->monitor_lock, "device interface monitors");
-
-	char name[128];
-	snprintf(name, sizeof(name), "%s receive queue", device->name);
-
-	if (init_fifo(&interface->receive_queue, name, 16 * 1024 * 1024) < B_OK)
-		goto error1;
+	rw_lock_init(&interface->receive_funcs_lock,
+		"device interface receive funcs");
 
 	interface->device = device;
 	interface->up_count = 0;
@@ -187,15 +316,47 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	interface->monitor_count = 0;
 	interface->deframe_func = NULL;
 	interface->deframe_ref_count = 0;
+	interface->reader_thread = -1;
+	interface->receive_queue_count = 0;
+	interface->receive_queue_bytes = 0;
+
+	for (uint32 i = 0; i < queueCount; i++) {
+		net_device_receive_queue& queue = interface->receive_queues[i];
+		queue.interface = interface;
+		queue.packets = 0;
+		queue.bytes = 0;
+		queue.coalesced = 0;
+		queue.dropped = 0;
+
+		char name[128];
+		snprintf(name, sizeof(name), "%s receive queue %" B_PRIu32,
+			device->name, i);
+
+		if (init_fifo(&queue.fifo, name, kReceiveQueueBytes) < B_OK)
+			break;
+
+		snprintf(name, sizeof(name), "%s consumer %" B_PRIu32, device->name,
+			i);
 
-	snprintf(name, sizeof(name), "%s consumer", device->name);
+		queue.consumer_thread = spawn_kernel_thread(device_consumer_thread,
+			name, B_DISPLAY_PRIORITY, &queue);
+		if (queue.consumer_thread < B_OK) {
+			uninit_fifo(&queue.fifo);
+			break;
+		}
+
+		resume_thread(queue.consumer_thread);
+		interface->receive_queue_count++;
+	}
 
-	interface->reader_thread   = -1;
-	interface->consumer_thread = spawn_kernel_thread(device_consumer_thread,
-		name, B_DISPLAY_PRIORITY, interface);
-	if (interface->consumer_thread < B_OK)
-		goto error2;
-	resume_thread(interface->consumer_thread);
+	if (interface->receive_queue_count == 0) {
+		recursive_lock_destroy(&interface->receive_lock);
+		recursive_lock_destroy(&interface->monitor_lock);
+		rw_lock_destroy(&interface->receive_funcs_lock);
+		delete[] interface->receive_queues;
+		delete interface;
+		return NULL;
+	}
 
 	// TODO: proper interface index allocation
 	device->index = ++sDeviceIndex;
@@ -203,15 +364,6 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 
 	sInterfaces.Add(interface);
 	return interface;
-
-error2:
-	uninit_fifo(&interface->receive_queue);
-error1:
-	recursive_lock_destroy(&interface->receive_lock);
-	recursive_lock_destroy(&interface->monitor_lock);
-	delete interface;
-
-	return NULL;
 }
 
 
@@ -249,7 +401,6 @@ dump_device_interface(int argc, char** argv)
 	kprintf("ref_count:         %" B_PRId32 "\n", interface->ref_count);
 	kprintf("deframe_func:      %p\n", interface->deframe_func);
 	kprintf("deframe_ref_count: %" B_PRId32 "\n", interface->ref_count);
-	kprintf("consumer_thread:   %" B_PRId32 "\n", interface->consumer_thread);
 
 	kprintf("monitor_count:     %" B_PRId32 "\n", interface->monitor_count);
 	kprintf("monitor_lock:      %p\n", &interface->monitor_lock);
@@ -260,7 +411,16 @@ dump_device_interface(int argc, char** argv)
 		kprintf("  %p\n", monitorIterator.Next());
 
 	kprintf("receive_lock:      %p\n", &interface->receive_lock);
-	kprintf("receive_queue:     %p\n", &interface->receive_queue);
+	kprintf("receive_queues:    %" B_PRIu32 ", %" B_PRId32 " of %" B_PRIuSIZE
+		" bytes used\n", interface->receive_queue_count,
+		interface->receive_queue_bytes, kReceiveQueueBytes);
+	for (uint32 i = 0; i < interface->receive_queue_count; i++) {
+		net_device_receive_queue& queue = interface->receive_queues[i];
+		kprintf("  %p  consumer %" B_PRId32 ", %" B_PRId64 " packets, %"
+			B_PRId64 " bytes, %" B_PRId64 " coalesced, %" B_PRId64
+			" dropped\n", &queue.fifo, queue.consumer_thread, queue.packets,
+			queue.bytes, queue.coalesced, queue.dropped);
+	}
 	kprintf("receive_funcs:\n");
 	DeviceHandlerList::Iterator handlerIterator
 		= interface->receive_funcs.GetIterator();
@@ -384,9 +544,14 @@ put_device_interface(struct net_device_interface* interface)
 	sInterfaces.Remove(interface);
 	locker.Unlock();
 
-	uninit_fifo(&interface->receive_queue);
-	status_t status;
-	wait_for_thread(interface->consumer_thread, &status);
+	for (uint32 i = 0; i < interface->receive_queue_count; i++) {
+		net_device_receive_queue& queue = interface->receive_queues[i];
+
+		uninit_fifo(&queue.fifo);
+		status_t status;
+		wait_for_thread(queue.consumer_thread, &status);
+	}
+	delete[] interface->receive_queues;
 
 	net_device* device = interface->device;
 	const char* moduleName = device->module->info.name;
@@ -396,6 +561,7 @@ put_device_interface(struct net_device_interface* interface)
 
 	recursive_lock_destroy(&interface->monitor_lock);
 	recursive_lock_destroy(&interface->receive_lock);
+	rw_lock_destroy(&interface->receive_funcs_lock);
 	delete interface;
 }
 
@@ -499,6 +665,38 @@ device_interface_monitor_receive(net_device_interface* interface,
 }
 
 
+/*!	Puts the \a buffer into the receive queue of the \a interface that is
+	responsible for the flow it belongs to. The queues share their memory, so
+	that a single busy flow can use all of it, and the buffer is only refused
+	when all queues together hold kReceiveQueueBytes.
+	If this function fails, the caller still owns the buffer.
+*/
+status_t
+device_interface_enqueue_buffer(net_device_interface* interface,
+	net_buffer* buffer)
+{
+	uint32 index = 0;
+	if (interface->receive_queue_count > 1)
+		index = flow_hash(buffer) % interface->receive_queue_count;
+
+	net_device_receive_queue& queue = interface->receive_queues[index];
+
+	int32 size = buffer->size;
+	status_t status = ENOBUFS;
+	if ((size_t)atomic_add(&interface->receive_queue_bytes, size) + size
+			<= kReceiveQueueBytes) {
+		status = fifo_enqueue_buffer(&queue.fifo, buffer);
+	}
+
+	if (status != B_OK) {
+		atomic_add(&interface->receive_queue_bytes, -size);
+		atomic_add64(&queue.dropped, 1);
+	}
+
+	return status;
+}
+
+
 status_t
 up_device_interface(net_device_interface* interface)
 {
@@ -648,6 +846,7 @@ register_device_handler(struct net_device* device, int32 type,
 		return B_DEVICE_NOT_FOUND;
 
 	RecursiveLocker _(interface->receive_lock);
+	WriteLocker handlerLocker(interface->receive_funcs_lock);
 
 	// see if such a handler already for this device
 
@@ -684,6 +883,7 @@ unregister_device_handler(struct net_device* device, int32 type)
 		return B_DEVICE_NOT_FOUND;
 
 	RecursiveLocker _(interface->receive_lock);
+	WriteLocker handlerLocker(interface->receive_funcs_lock);
 
 	// search for the handler
 
@@ -813,7 +1013,7 @@ device_enqueue_buffer(net_device* device, net_buffer* buffer)
 	if (interface == NULL)
 		return B_DEVICE_NOT_FOUND;
 
-	status_t status = fifo_enqueue_buffer(&interface->receive_queue, buffer);
+	status_t status = device_interface_enqueue_buffer(interface, buffer);
 
 	put_device_interface(interface);
 	return status;
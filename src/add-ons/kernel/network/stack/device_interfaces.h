@@ -26,6 +26,18 @@ typedef DoublyLinkedList<net_device_handler> DeviceHandlerList;
 typedef DoublyLinkedList<net_device_monitor,
 	DoublyLinkedListCLink<net_device_monitor> > DeviceMonitorList;
 
+struct net_device_receive_queue {
+	struct net_device_interface* interface;
+	thread_id			consumer_thread;
+	net_fifo			fifo;
+
+	// statistics
+	int64				packets;
+	int64				bytes;
+	int64				coalesced;
+	int64				dropped;
+};
+
 struct net_device_interface : DoublyLinkedListLinkImpl<net_device_interface> {
 	struct net_device*	device;
 	thread_id			reader_thread;
@@ -42,10 +54,14 @@ struct net_device_interface : DoublyLinkedListLinkImpl<net_device_interface> {
 	DeviceMonitorList	monitor_funcs;
 
 	DeviceHandlerList	receive_funcs;
+	rw_lock				receive_funcs_lock;
 	recursive_lock		receive_lock;
 
-	thread_id			consumer_thread;
-	net_fifo			receive_queue;
+	net_device_receive_queue* receive_queues;
+	uint32				receive_queue_count;
+		// one queue per CPU, received frames are distributed by their flow
+	int32				receive_queue_bytes;
+		// the bytes waiting in all receive queues
 };
 
 typedef DoublyLinkedList<net_device_interface> DeviceInterfaceList;
@@ -63,6 +79,8 @@ struct net_device_interface* get_device_interface(const char* name,
 	bool create = true);
 void device_interface_monitor_receive(net_device_interface* interface,
 	net_buffer* buffer);
+status_t device_interface_enqueue_buffer(net_device_interface* interface,
+	net_buffer* buffer);
 status_t up_device_interface(net_device_interface* interface);
 void down_device_interface(net_device_interface* interface);
 
@@ -71,6 +71,9 @@ dump_domains(int argc, char** argv)
 		kprintf("domain: %p, %s, %d\n", domain, domain->name, domain->family);
 		kprintf("  module:         %p\n", domain->module);
 		kprintf("  address_module: %p\n", domain->address_module);
+		kprintf("  route cache:    generation %" B_PRIu32 ", %" B_PRId64
+			" hits, %" B_PRId64 " misses\n", domain->route_generation,
+			domain->route_cache_hits, domain->route_cache_misses);
 
 		if (!domain->routes.IsEmpty())
 			kprintf("  routes:\n");
@@ -132,7 +135,12 @@ register_domain(int family, const char* name,
 	if (domain == NULL)
 		return B_NO_MEMORY;
 
-	recursive_lock_init(&domain->lock, name);
+	rw_lock_init(&domain->lock, name);
+
+	memset(domain->route_cache, 0, sizeof(domain->route_cache));
+	domain->route_generation = 1;
+	domain->route_cache_hits = 0;
+	domain->route_cache_misses = 0;
 
 	domain->family = family;
 	domain->name = name;
@@ -157,7 +165,7 @@ unregister_domain(net_domain* _domain)
 
 	sDomains.Remove(domain);
 
-	recursive_lock_destroy(&domain->lock);
+	rw_lock_destroy(&domain->lock);
 	delete domain;
 	return B_OK;
 }
@@ -19,12 +19,28 @@
 struct net_device_interface;
 
 
+#define ROUTE_CACHE_SIZE	128
+
+
+struct route_cache_entry {
+	int32				sequence;
+	uint32				generation;
+	net_route_private*	route;
+	sockaddr_storage	destination;
+};
+
+
 struct net_domain_private : net_domain,
 		DoublyLinkedListLinkImpl<net_domain_private> {
-	recursive_lock		lock;
+	rw_lock				lock;
 
 	RouteList			routes;
 	RouteInfoList		route_infos;
+
+	uint32				route_generation;
+	route_cache_entry	route_cache[ROUTE_CACHE_SIZE];
+	int64				route_cache_hits;
+	int64				route_cache_misses;
 };
 
 
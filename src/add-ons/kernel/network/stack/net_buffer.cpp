@@ -1080,6 +1080,8 @@ copy_metadata(net_buffer* destination, const net_buffer* source)
 
 	destination->offset = source->offset;
 	destination->protocol = source->protocol;
+	destination->offload_flags = source->offload_flags;
+	destination->segment_size = source->segment_size;
 	destination->type = source->type;
 }
 
@@ -1128,6 +1130,8 @@ create_buffer(size_t headerSpace)
 	buffer->offset = 0;
 	buffer->flags = 0;
 	buffer->size = 0;
+	buffer->offload_flags = 0;
+	buffer->segment_size = 0;
 
 	CHECK_BUFFER(buffer);
 	CREATE_PARANOIA_CHECK_SET(buffer, "net_buffer");
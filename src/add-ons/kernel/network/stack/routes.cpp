@@ -137,8 +137,15 @@ find_route(struct net_domain* _domain, const net_route* description)
 }
 
 
+/*!	Finds the most specific route to \a address. Routes whose device has no
+	link are only used if there is no other route.
+	If \a _cacheable is given, it is set to whether or not the result could
+	change with the link state of a device other than that of the route
+	found, ie. whether or not it may be put into the route cache.
+*/
 static net_route_private*
-find_route(net_domain* _domain, const sockaddr* address)
+find_route(net_domain* _domain, const sockaddr* address,
+	bool* _cacheable = NULL)
 {
 	net_domain_private* domain = (net_domain_private*)_domain;
 
@@ -152,6 +159,9 @@ find_route(net_domain* _domain, const sockaddr* address)
 
 	// TODO: alternate equal default routes
 
+	if (_cacheable != NULL)
+		*_cacheable = false;
+
 	while (iterator.HasNext()) {
 		net_route_private* route = iterator.Next();
 
@@ -180,6 +190,8 @@ find_route(net_domain* _domain, const sockaddr* address)
 		TRACE("  found route: %s, flags %lx\n",
 			AddressString(domain, route->destination).Data(), route->flags);
 
+		if (_cacheable != NULL)
+			*_cacheable = candidate == NULL;
 		return route;
 	}
 
@@ -187,10 +199,97 @@ find_route(net_domain* _domain, const sockaddr* address)
 }
 
 
+/*!	Invalidates all entries in the route cache of the \a domain. Must be
+	called whenever the route list changes.
+	You need to have the domain write locked when calling this function.
+*/
+static void
+invalidate_route_cache(net_domain_private* domain)
+{
+	ASSERT_WRITE_LOCKED_RW_LOCK(&domain->lock);
+
+	atomic_add((int32*)&domain->route_generation, 1);
+}
+
+
+static inline uint32
+route_cache_slot(net_domain_private* domain, const sockaddr* address)
+{
+	// the address hash is usually in network byte order, so mix in all bits
+	uint32 hash = domain->address_module->hash_address(address, false);
+	hash ^= hash >> 16;
+	hash ^= hash >> 8;
+	return hash % ROUTE_CACHE_SIZE;
+}
+
+
+/*!	Looks up the route to \a address in the route cache of the \a domain.
+	The cache entries are updated by concurrent readers; each entry is
+	protected by a sequence counter that is odd while the entry is being
+	written, so that readers never have to lock it.
+	You need to have the domain read locked when calling this function; this
+	guarantees that the route of an entry with the current generation is still
+	part of the route list.
+*/
+static net_route_private*
+lookup_route_cache(net_domain_private* domain, const sockaddr* address)
+{
+	route_cache_entry& entry = domain->route_cache[
+		route_cache_slot(domain, address)];
+
+	int32 sequence = atomic_get(&entry.sequence);
+	if ((sequence & 1) != 0
+		|| entry.generation
+			!= (uint32)atomic_get((int32*)&domain->route_generation)
+		|| !domain->address_module->equal_addresses(
+			(const sockaddr*)&entry.destination, address))
+		return NULL;
+
+	net_route_private* route = entry.route;
+	if (atomic_get(&entry.sequence) != sequence)
+		return NULL;
+
+	// the link state may have changed since the route has been cached
+	if ((route->interface_address->interface->device->flags & IFF_LINK) == 0)
+		return NULL;
+
+	return route;
+}
+
+
+/*!	Stores the \a route to \a address in the route cache of the \a domain.
+	If the entry is currently being updated by someone else, the route is
+	simply not cached.
+	You need to have the domain read locked when calling this function.
+*/
+static void
+update_route_cache(net_domain_private* domain, const sockaddr* address,
+	net_route_private* route)
+{
+	if (address->sa_len > sizeof(sockaddr_storage))
+		return;
+
+	route_cache_entry& entry = domain->route_cache[
+		route_cache_slot(domain, address)];
+
+	int32 sequence = atomic_get(&entry.sequence);
+	if ((sequence & 1) != 0
+		|| atomic_test_and_set(&entry.sequence, sequence + 1, sequence)
+			!= sequence)
+		return;
+
+	memcpy(&entry.destination, address, address->sa_len);
+	entry.route = route;
+	entry.generation = atomic_get((int32*)&domain->route_generation);
+
+	atomic_set(&entry.sequence, sequence + 2);
+}
+
+
 static void
 put_route_internal(struct net_domain_private* domain, net_route* _route)
 {
-	ASSERT_LOCKED_RECURSIVE(&domain->lock);
+	ASSERT_READ_LOCKED_RW_LOCK(&domain->lock);
 
 	net_route_private* route = (net_route_private*)_route;
 	if (route == NULL || atomic_add(&route->ref_count, -1) != 1)
@@ -208,7 +307,7 @@ static struct net_route*
 get_route_internal(struct net_domain_private* domain,
 	const struct sockaddr* address)
 {
-	ASSERT_LOCKED_RECURSIVE(&domain->lock);
+	ASSERT_READ_LOCKED_RW_LOCK(&domain->lock);
 	net_route_private* route = NULL;
 
 	if (address->sa_family == AF_LINK) {
@@ -229,8 +328,19 @@ get_route_internal(struct net_domain_private* domain,
 							device->address.length)))
 				break;
 		}
-	} else
-		route = find_route(domain, address);
+	} else {
+		route = lookup_route_cache(domain, address);
+		if (route != NULL)
+			atomic_add64(&domain->route_cache_hits, 1);
+		else {
+			atomic_add64(&domain->route_cache_misses, 1);
+
+			bool cacheable;
+			route = find_route(domain, address, &cacheable);
+			if (route != NULL && cacheable)
+				update_route_cache(domain, address, route);
+		}
+	}
 
 	if (route != NULL && atomic_add(&route->ref_count, 1) == 0) {
 		// route has been deleted already
@@ -244,7 +354,7 @@ get_route_internal(struct net_domain_private* domain,
 static void
 update_route_infos(struct net_domain_private* domain)
 {
-	ASSERT_LOCKED_RECURSIVE(&domain->lock);
+	ASSERT_WRITE_LOCKED_RW_LOCK(&domain->lock);
 	RouteInfoList::Iterator iterator = domain->route_infos.GetIterator();
 
 	while (iterator.HasNext()) {
@@ -293,7 +403,7 @@ fill_route_entry(route_entry* target, void* _buffer, size_t bufferSize,
 uint32
 route_table_size(net_domain_private* domain)
 {
-	RecursiveLocker locker(domain->lock);
+	ReadLocker locker(domain->lock);
 	uint32 size = 0;
 
 	RouteList::Iterator iterator = domain->routes.GetIterator();
@@ -320,7 +430,7 @@ route_table_size(net_domain_private* domain)
 status_t
 list_routes(net_domain_private* domain, void* buffer, size_t size)
 {
-	RecursiveLocker _(domain->lock);
+	ReadLocker _(domain->lock);
 
 	RouteList::Iterator iterator = domain->routes.GetIterator();
 	const size_t kBaseSize = IF_NAMESIZE + sizeof(route_entry);
@@ -464,7 +574,7 @@ add_route(struct net_domain* _domain, const struct net_route* newRoute)
 		|| !domain->address_module->check_mask(newRoute->mask))
 		return B_BAD_VALUE;
 
-	RecursiveLocker _(domain->lock);
+	WriteLocker _(domain->lock);
 
 	net_route_private* route = find_route(domain, newRoute);
 	if (route != NULL)
@@ -514,6 +624,7 @@ add_route(struct net_domain* _domain, const struct net_route* newRoute)
 	}
 
 	domain->routes.Insert(before, route);
+	invalidate_route_cache(domain);
 	update_route_infos(domain);
 
 	return B_OK;
@@ -535,13 +646,14 @@ remove_route(struct net_domain* _domain, const struct net_route* removeRoute)
 			? removeRoute->gateway : NULL).Data(),
 		removeRoute->flags);
 
-	RecursiveLocker locker(domain->lock);
+	WriteLocker locker(domain->lock);
 
 	net_route_private* route = find_route(domain, removeRoute);
 	if (route == NULL)
 		return B_ENTRY_NOT_FOUND;
 
 	domain->routes.Remove(route);
+	invalidate_route_cache(domain);
 
 	put_route_internal(domain, route);
 	update_route_infos(domain);
@@ -567,7 +679,7 @@ get_route_information(struct net_domain* _domain, void* value, size_t length)
 	if (status != B_OK)
 		return status;
 
-	RecursiveLocker locker(domain->lock);
+	ReadLocker locker(domain->lock);
 
 	net_route_private* route = find_route(domain, (sockaddr*)&destination);
 	if (route == NULL)
@@ -585,7 +697,7 @@ void
 invalidate_routes(net_domain* _domain, net_interface* interface)
 {
 	net_domain_private* domain = (net_domain_private*)_domain;
-	RecursiveLocker locker(domain->lock);
+	WriteLocker locker(domain->lock);
 
 	TRACE("invalidate_routes(%i, %s)\n", domain->family, interface->name);
 
@@ -607,7 +719,7 @@ invalidate_routes(InterfaceAddress* address)
 	TRACE("invalidate_routes(%s)\n",
 		AddressString(domain, address->local).Data());
 
-	RecursiveLocker locker(domain->lock);
+	WriteLocker locker(domain->lock);
 
 	RouteList::Iterator iterator = domain->routes.GetIterator();
 	while (iterator.HasNext()) {
@@ -623,7 +735,7 @@ struct net_route*
 get_route(struct net_domain* _domain, const struct sockaddr* address)
 {
 	struct net_domain_private* domain = (net_domain_private*)_domain;
-	RecursiveLocker locker(domain->lock);
+	ReadLocker locker(domain->lock);
 
 	return get_route_internal(domain, address);
 }
@@ -652,7 +764,7 @@ get_buffer_route(net_domain* _domain, net_buffer* buffer, net_route** _route)
 {
 	net_domain_private* domain = (net_domain_private*)_domain;
 
-	RecursiveLocker _(domain->lock);
+	ReadLocker _(domain->lock);
 
 	net_route* route = get_route_internal(domain, buffer->destination);
 	if (route == NULL)
@@ -686,7 +798,7 @@ put_route(struct net_domain* _domain, net_route* route)
 	if (domain == NULL || route == NULL)
 		return;
 
-	RecursiveLocker locker(domain->lock);
+	ReadLocker locker(domain->lock);
 
 	put_route_internal(domain, (net_route*)route);
 }
@@ -696,7 +808,7 @@ status_t
 register_route_info(struct net_domain* _domain, struct net_route_info* info)
 {
 	struct net_domain_private* domain = (net_domain_private*)_domain;
-	RecursiveLocker locker(domain->lock);
+	WriteLocker locker(domain->lock);
 
 	domain->route_infos.Add(info);
 	info->route = get_route_internal(domain, &info->address);
@@ -709,7 +821,7 @@ status_t
 unregister_route_info(struct net_domain* _domain, struct net_route_info* info)
 {
 	struct net_domain_private* domain = (net_domain_private*)_domain;
-	RecursiveLocker locker(domain->lock);
+	WriteLocker locker(domain->lock);
 
 	domain->route_infos.Remove(info);
 	if (info->route != NULL)
@@ -723,7 +835,7 @@ status_t
 update_route_info(struct net_domain* _domain, struct net_route_info* info)
 {
 	struct net_domain_private* domain = (net_domain_private*)_domain;
-	RecursiveLocker locker(domain->lock);
+	WriteLocker locker(domain->lock);
 
 	put_route_internal(domain, info->route);
 	info->route = get_route_internal(domain, &info->address);
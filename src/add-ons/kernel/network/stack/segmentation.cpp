@@ -0,0 +1,407 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Generic segmentation and receive offload for TCP over IPv4.
+
+	On the sending side, TCP may hand down a single super-segment carrying
+	several full sized segments (marked with net_buffer::segment_size). Unless
+	the device can handle those itself, it is split into individual segments
+	right before it is passed to the datalink protocols.
+
+	On the receiving side, consecutive in-order segments of the same flow
+	that are waiting in a device receive queue are merged into a single buffer
+	before they travel up the stack.
+*/
+
+
+#include "segmentation.h"
+
+#include "interfaces.h"
+#include "stack_private.h"
+#include "utility.h"
+
+#include <net_datalink_protocol.h>
+#include <NetUtilities.h>
+
+#include <ByteOrder.h>
+#include <KernelExport.h>
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <string.h>
+
+
+//#define TRACE_SEGMENTATION
+#ifdef TRACE_SEGMENTATION
+#	define TRACE(x...) dprintf(STACK_DEBUG_PREFIX x)
+#else
+#	define TRACE(x...) ;
+#endif
+
+
+// We cannot use the protocol headers directly, as they are private to their
+// modules, so we just duplicate the parts we need to know about here.
+
+struct segment_ipv4_header {
+	uint8		version_header_length;
+	uint8		service_type;
+	uint16		total_length;
+	uint16		id;
+	uint16		fragment_offset;
+	uint8		time_to_live;
+	uint8		protocol;
+	uint16		checksum;
+	in_addr_t	source;
+	in_addr_t	destination;
+
+	uint8 Version() const { return version_header_length >> 4; }
+	size_t HeaderLength() const { return (version_header_length & 0xf) << 2; }
+} _PACKED;
+
+struct segment_tcp_header {
+	uint16		source_port;
+	uint16		destination_port;
+	uint32		sequence;
+	uint32		acknowledge;
+	uint8		header_length;
+	uint8		flags;
+	uint16		advertised_window;
+	uint16		checksum;
+	uint16		urgent_offset;
+
+	size_t HeaderLength() const { return (header_length >> 4) << 2; }
+} _PACKED;
+
+#define IPV4_MORE_FRAGMENTS		0x2000
+#define IPV4_FRAGMENT_OFFSET	0x1fff
+
+#define TCP_FLAG_FINISH			0x01
+#define TCP_FLAG_PUSH			0x08
+#define TCP_FLAG_ACKNOWLEDGE	0x10
+
+static const size_t kMaxHeaderLength = 60 + 60;
+	// maximum IPv4 and TCP header lengths, including options
+
+
+struct segment_headers {
+	uint8		data[kMaxHeaderLength];
+	size_t		ip_length;
+	size_t		length;
+
+	segment_ipv4_header& IPv4()
+		{ return *(segment_ipv4_header*)data; }
+	segment_tcp_header& TCP()
+		{ return *(segment_tcp_header*)(data + ip_length); }
+	size_t TCPLength() const
+		{ return length - ip_length; }
+};
+
+
+/*!	Reads the IPv4 and TCP headers at the start of \a buffer into \a headers,
+	and makes sure they can be parsed.
+*/
+static status_t
+read_headers(net_buffer* buffer, segment_headers& headers)
+{
+	size_t bytes = min_c(buffer->size, kMaxHeaderLength);
+	if (bytes < sizeof(segment_ipv4_header) + sizeof(segment_tcp_header))
+		return B_BAD_DATA;
+
+	status_t status = gNetBufferModule.read(buffer, 0, headers.data, bytes);
+	if (status != B_OK)
+		return status;
+
+	segment_ipv4_header& ip = headers.IPv4();
+	if (ip.Version() != 4 || ip.protocol != IPPROTO_TCP)
+		return B_BAD_TYPE;
+
+	headers.ip_length = ip.HeaderLength();
+	if (headers.ip_length < sizeof(segment_ipv4_header)
+		|| headers.ip_length + sizeof(segment_tcp_header) > bytes)
+		return B_BAD_DATA;
+
+	size_t tcpLength = headers.TCP().HeaderLength();
+	if (tcpLength < sizeof(segment_tcp_header)
+		|| headers.ip_length + tcpLength > bytes)
+		return B_BAD_DATA;
+
+	headers.length = headers.ip_length + tcpLength;
+	return B_OK;
+}
+
+
+/*!	Computes the TCP checksum of \a buffer including the pseudo header.
+	The TCP header is taken from \a headers, the payload from the buffer.
+	If the checksum field is already filled in, the result is zero for a
+	valid segment.
+*/
+static uint16
+tcp_checksum(net_buffer* buffer, segment_headers& headers)
+{
+	segment_ipv4_header& ip = headers.IPv4();
+	size_t payloadLength = buffer->size - headers.length;
+
+	Checksum checksum;
+	checksum << (uint32)ip.source << (uint32)ip.destination
+		<< (uint16)htons(IPPROTO_TCP)
+		<< (uint16)htons(headers.TCPLength() + payloadLength)
+		<< (uint32)compute_checksum(headers.data + headers.ip_length,
+			headers.TCPLength());
+
+	if (payloadLength > 0) {
+		checksum << (uint32)(uint16)gNetBufferModule.checksum(buffer,
+			headers.length, payloadLength, false);
+	}
+
+	return checksum;
+}
+
+
+//	#pragma mark - segmentation offload
+
+
+/*!	Splits the TCP super-segment \a buffer into segments of at most
+	net_buffer::segment_size bytes of payload, and sends them one by one
+	through the \a datalink protocols.
+	The segments only reference the data of the original buffer, no data is
+	copied. As usual, if this function succeeds, the buffer is consumed.
+*/
+status_t
+send_segmented_buffer(domain_datalink* datalink, net_buffer* buffer)
+{
+	segment_headers headers;
+	status_t status = read_headers(buffer, headers);
+	if (status != B_OK)
+		return status;
+
+	segment_ipv4_header& ip = headers.IPv4();
+	segment_tcp_header& tcp = headers.TCP();
+
+	const size_t segmentSize = buffer->segment_size;
+	const size_t payloadSize = buffer->size - headers.length;
+	const uint8 flags = tcp.flags;
+	uint32 sequence = B_BENDIAN_TO_HOST_INT32(tcp.sequence);
+	uint16 id = B_BENDIAN_TO_HOST_INT16(ip.id);
+
+	TRACE("send_segmented_buffer(%p): %" B_PRIuSIZE " bytes in segments of "
+		"%" B_PRIuSIZE "\n", buffer, payloadSize, segmentSize);
+
+	for (size_t offset = 0; offset < payloadSize; offset += segmentSize) {
+		size_t length = min_c(segmentSize, payloadSize - offset);
+		bool last = offset + length == payloadSize;
+
+		net_buffer* segment = gNetBufferModule.clone(buffer, false);
+		if (segment == NULL)
+			return B_NO_MEMORY;
+
+		segment->segment_size = 0;
+
+		status = gNetBufferModule.remove_header(segment,
+			headers.length + offset);
+		if (status == B_OK)
+			status = gNetBufferModule.trim(segment, length);
+
+		if (status == B_OK) {
+			// Only the last segment may carry the FIN and PSH flags
+			ip.total_length = B_HOST_TO_BENDIAN_INT16(headers.length + length);
+			ip.id = B_HOST_TO_BENDIAN_INT16(id++);
+			ip.checksum = 0;
+			ip.checksum = checksum(headers.data, headers.ip_length);
+
+			tcp.sequence = B_HOST_TO_BENDIAN_INT32(sequence);
+			tcp.flags = last
+				? flags : flags & ~(TCP_FLAG_FINISH | TCP_FLAG_PUSH);
+			tcp.checksum = 0;
+
+			status = gNetBufferModule.prepend(segment, headers.data,
+				headers.length);
+		}
+		if (status == B_OK) {
+			tcp.checksum = tcp_checksum(segment, headers);
+			status = gNetBufferModule.write(segment,
+				headers.ip_length + offsetof(segment_tcp_header, checksum),
+				&tcp.checksum, sizeof(tcp.checksum));
+		}
+		if (status == B_OK) {
+			status = datalink->first_info->send_data(datalink->first_protocol,
+				segment);
+		}
+		if (status != B_OK) {
+			// The segments that were already sent will just be sent again
+			// by TCP
+			gNetBufferModule.free(segment);
+			return status;
+		}
+
+		sequence += length;
+	}
+
+	gNetBufferModule.free(buffer);
+	return B_OK;
+}
+
+
+//	#pragma mark - receive offload
+
+
+/*!	Returns whether or not \a buffer is an IPv4 packet that could be a
+	candidate for coalescing with the packets following it.
+	This is only a quick check to avoid looking at the receive queue in vain;
+	coalesce_segments() does the actual validation.
+*/
+bool
+is_coalescable_segment(net_buffer* buffer)
+{
+	if (buffer->interface_address != NULL) {
+		// locally delivered
+		return buffer->interface_address->domain != NULL
+			&& buffer->interface_address->domain->family == AF_INET;
+	}
+
+	return buffer->type == B_NET_FRAME_TYPE_IPV4;
+}
+
+
+/*!	Returns whether \a address is one of our own IPv4 addresses.
+*/
+static bool
+is_local_destination(in_addr_t address)
+{
+	sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_len = sizeof(sockaddr_in);
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = address;
+
+	InterfaceAddress* interfaceAddress = get_interface_address(
+		(sockaddr*)&local);
+	if (interfaceAddress == NULL)
+		return false;
+
+	interfaceAddress->ReleaseReference();
+	return true;
+}
+
+
+/*!	Checks whether the segment described by \a headers may take part in
+	receive offload at all.
+*/
+static bool
+is_plain_segment(net_buffer* buffer, segment_headers& headers)
+{
+	segment_ipv4_header& ip = headers.IPv4();
+	segment_tcp_header& tcp = headers.TCP();
+
+	// Only plain data segments, no IP options or fragments; the total length
+	// must match exactly (ie. no link layer padding).
+	return headers.ip_length == sizeof(segment_ipv4_header)
+		&& (B_BENDIAN_TO_HOST_INT16(ip.fragment_offset)
+			& (IPV4_MORE_FRAGMENTS | IPV4_FRAGMENT_OFFSET)) == 0
+		&& B_BENDIAN_TO_HOST_INT16(ip.total_length) == buffer->size
+		&& buffer->size > headers.length
+		&& (tcp.flags & ~TCP_FLAG_PUSH) == TCP_FLAG_ACKNOWLEDGE
+		&& checksum(headers.data, headers.ip_length) == 0;
+}
+
+
+/*!	Tries to append the payload of segment \a next to \a buffer, which must
+	both be IPv4 TCP segments of the same flow with \a next directly
+	following \a buffer in sequence space.
+	Both segments must have identical headers except for the sequence number,
+	the IP ID, and the PSH flag. Once \a buffer carries a PSH flag, no more
+	segments are appended to it.
+	The TCP checksum of both segments is verified here, and the result is
+	marked with NET_BUFFER_CHECKSUM_VERIFIED, so that TCP does not need to
+	(and cannot) check it again. Since the checksum in the TCP header is not
+	updated, only segments that are delivered locally are merged; forwarded
+	ones have to leave the way they came in.
+
+	\a _nextConsumed is set to \c true once \a next has been freed, which is
+	the case when the segments have been merged and \c B_OK is returned. If
+	an error is returned nonetheless, \a buffer could not be updated after
+	the merge, and must be dropped. Otherwise, both buffers are left
+	untouched.
+*/
+status_t
+coalesce_segments(net_buffer* buffer, net_buffer* next, bool& _nextConsumed)
+{
+	_nextConsumed = false;
+
+	if (buffer->interface_address != next->interface_address
+		|| !is_coalescable_segment(next))
+		return B_MISMATCHED_VALUES;
+
+	segment_headers headers;
+	segment_headers nextHeaders;
+	if (read_headers(buffer, headers) != B_OK
+		|| read_headers(next, nextHeaders) != B_OK
+		|| headers.length != nextHeaders.length
+		|| !is_plain_segment(buffer, headers)
+		|| !is_plain_segment(next, nextHeaders))
+		return B_MISMATCHED_VALUES;
+
+	segment_ipv4_header& ip = headers.IPv4();
+	segment_ipv4_header& nextIP = nextHeaders.IPv4();
+	segment_tcp_header& tcp = headers.TCP();
+	segment_tcp_header& nextTCP = nextHeaders.TCP();
+
+	size_t payloadSize = buffer->size - headers.length;
+	size_t nextPayloadSize = next->size - nextHeaders.length;
+
+	if ((tcp.flags & TCP_FLAG_PUSH) != 0
+		|| buffer->size + nextPayloadSize > 0xffff
+		|| ip.source != nextIP.source
+		|| ip.destination != nextIP.destination
+		|| ip.service_type != nextIP.service_type
+		|| tcp.source_port != nextTCP.source_port
+		|| tcp.destination_port != nextTCP.destination_port
+		|| tcp.acknowledge != nextTCP.acknowledge
+		|| tcp.advertised_window != nextTCP.advertised_window
+		|| B_BENDIAN_TO_HOST_INT32(tcp.sequence) + payloadSize
+			!= B_BENDIAN_TO_HOST_INT32(nextTCP.sequence)
+		|| memcmp(headers.data + headers.ip_length + sizeof(segment_tcp_header),
+			nextHeaders.data + nextHeaders.ip_length
+				+ sizeof(segment_tcp_header),
+			headers.TCPLength() - sizeof(segment_tcp_header)) != 0)
+		return B_MISMATCHED_VALUES;
+
+	if (buffer->interface_address == NULL
+		&& !is_local_destination(ip.destination))
+		return B_MISMATCHED_VALUES;
+
+	if ((buffer->offload_flags & NET_BUFFER_CHECKSUM_VERIFIED) == 0
+		&& tcp_checksum(buffer, headers) != 0)
+		return B_BAD_DATA;
+	if ((next->offload_flags & NET_BUFFER_CHECKSUM_VERIFIED) == 0
+		&& tcp_checksum(next, nextHeaders) != 0)
+		return B_BAD_DATA;
+
+	if (gNetBufferModule.remove_header(next, nextHeaders.length) != B_OK)
+		return B_ERROR;
+	if (gNetBufferModule.merge(buffer, next, true) != B_OK) {
+		// The headers of next are gone by now; since merging only fails when
+		// we are running out of memory, we just drop the segment, and let
+		// TCP recover it
+		gNetBufferModule.free(next);
+		_nextConsumed = true;
+		return B_OK;
+	}
+
+	// next belongs to buffer now, whatever happens
+	_nextConsumed = true;
+
+	TRACE("coalesce_segments(%p): appended %" B_PRIuSIZE " bytes\n", buffer,
+		nextPayloadSize);
+
+	ip.total_length = B_HOST_TO_BENDIAN_INT16(buffer->size);
+	ip.checksum = 0;
+	ip.checksum = checksum(headers.data, headers.ip_length);
+	tcp.flags |= nextTCP.flags;
+
+	buffer->offload_flags |= NET_BUFFER_CHECKSUM_VERIFIED;
+
+	return gNetBufferModule.write(buffer, 0, headers.data, headers.length);
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SEGMENTATION_H
+#define SEGMENTATION_H
+
+
+#include <net_buffer.h>
+
+
+struct domain_datalink;
+
+
+// generic segmentation offload
+status_t	send_segmented_buffer(domain_datalink* datalink,
+				net_buffer* buffer);
+
+// generic receive offload
+bool		is_coalescable_segment(net_buffer* buffer);
+status_t	coalesce_segments(net_buffer* buffer, net_buffer* next,
+				bool& _nextConsumed);
+
+
+#endif	// SEGMENTATION_H
@@ -6,6 +6,7 @@
  *		Michael Lotz <mmlr@mlotz.ch>
  */
 
+#include "BitmapTiles.h"
 #include "NetReceiver.h"
 #include "NetSender.h"
 #include "RemoteMessage.h"
@@ -67,6 +68,7 @@ RemoteView::RemoteView(BRect frame, const char *remoteHost, uint16 remotePort)
 	fStopThread(false),
 	fOffscreenBitmap(NULL),
 	fOffscreen(NULL),
+	fTileStore(NULL),
 	fViewCursor(kCursorData),
 	fCursorBitmap(NULL),
 	fCursorVisible(false)
@@ -141,6 +143,13 @@ RemoteView::RemoteView(BRect frame, const char *remoteHost, uint16 remotePort)
 	fOffscreenBitmap->AddChild(fOffscreen);
 	fOffscreen->SetDrawingMode(B_OP_COPY);
 
+	fTileStore = new(std::nothrow) BitmapTileStore();
+	if (fTileStore != NULL && fTileStore->InitCheck() != B_OK) {
+		// we just don't announce that we can do tiled bitmaps
+		delete fTileStore;
+		fTileStore = NULL;
+	}
+
 	fDrawThread = spawn_thread(&_DrawEntry, "draw thread", B_NORMAL_PRIORITY,
 		this);
 	if (fDrawThread < 0) {
@@ -173,6 +182,8 @@ RemoteView::~RemoteView()
 
 	int32 result;
 	wait_for_thread(fDrawThread, &result);
+
+	delete fTileStore;
 }
 
 
@@ -442,7 +453,12 @@ RemoteView::_DrawThread()
 	// cursor
 	BPoint cursorHotSpot(0, 0);
 
+	uint32 capabilities = 0;
+	if (fTileStore != NULL)
+		capabilities |= RP_CAPABILITY_TILED_BITMAPS;
+
 	reply.Start(RP_INIT_CONNECTION);
+	reply.Add(capabilities);
 	reply.Flush();
 
 	while (!fStopThread) {
@@ -774,6 +790,27 @@ RemoteView::_DrawThread()
 				break;
 			}
 
+			case RP_DRAW_BITMAP_TILED:
+			{
+				BBitmap *bitmap;
+				BRect bitmapRect, viewRect;
+				uint32 options;
+
+				message.Read(bitmapRect);
+				message.Read(viewRect);
+				message.Read(options);
+				if (fTileStore == NULL
+					|| message.ReadTiledBitmap(&bitmap, *fTileStore) != B_OK
+					|| bitmap == NULL) {
+					continue;
+				}
+
+				offscreen->DrawBitmap(bitmap, bitmapRect, viewRect, options);
+				invalidRegion.Include(viewRect);
+				delete bitmap;
+				break;
+			}
+
 			case RP_DRAW_BITMAP_RECTS:
 			{
 				color_space colorSpace;
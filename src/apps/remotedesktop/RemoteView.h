@@ -14,6 +14,7 @@
 #include <View.h>
 
 class BBitmap;
+class BitmapTileStore;
 class NetReceiver;
 class NetSender;
 class StreamingRingBuffer;
@@ -75,6 +76,7 @@ static	int32						_DrawEntry(void *data);
 
 		BBitmap *					fOffscreenBitmap;
 		BView *						fOffscreen;
+		BitmapTileStore *			fTileStore;
 
 		BCursor						fViewCursor;
 		BBitmap *					fCursorBitmap;
@@ -19,6 +19,7 @@
 #include <string.h>
 #include <new>
 
+#include <LinkRing.h>
 #include <ServerProtocol.h>
 #include <String.h>
 #include <Region.h>
@@ -50,11 +51,17 @@
 namespace BPrivate {
 
 
+static const uint32 kRingPortCheckInterval = 16;
+	// how many ring records may be read before the port is looked at
+
+
 LinkReceiver::LinkReceiver(port_id port)
 	:
 	fReceivePort(port), fRecvBuffer(NULL), fRecvPosition(0), fRecvStart(0),
 	fRecvBufferSize(0), fDataSize(0),
-	fReplySize(0), fReadError(B_OK)
+	fReplySize(0), fReadError(B_OK),
+	fRing(NULL), fRingSpaceSemaphore(-1), fRingReadPosition(0), fRingReads(0),
+	fRingWakeupsRead(0)
 {
 }
 
@@ -72,6 +79,21 @@ LinkReceiver::SetPort(port_id port)
 }
 
 
+/*!	Lets the receiver read from \a ring first, and only wait on the port
+	when the ring is empty. Pass \c NULL to only use the port again.
+	The ring must be empty, and stay empty while there is no receiver.
+*/
+void
+LinkReceiver::SetRing(link_ring* ring, sem_id spaceSemaphore)
+{
+	fRing = ring;
+	fRingSpaceSemaphore = spaceSemaphore;
+	fRingReadPosition = ring != NULL ? (uint32)ring->read_position : 0;
+	fRingReads = 0;
+	fRingWakeupsRead = ring != NULL ? ring->wakeups : 0;
+}
+
+
 status_t
 LinkReceiver::GetNextMessage(int32 &code, bigtime_t timeout)
 {
@@ -122,8 +144,18 @@ LinkReceiver::GetNextMessage(int32 &code, bigtime_t timeout)
 bool
 LinkReceiver::HasMessages() const
 {
-	return fDataSize - (fRecvStart + fReplySize) > 0
-		|| port_count(fReceivePort) > 0;
+	if (fDataSize - (fRecvStart + fReplySize) > 0)
+		return true;
+
+	if (fRing != NULL) {
+		if ((uint32)atomic_get(&fRing->write_position) != fRingReadPosition)
+			return true;
+
+		// the port might only contain wake-up calls
+		return port_count(fReceivePort) > _RingWakeupsInPort();
+	}
+
+	return port_count(fReceivePort) > 0;
 }
 
 
@@ -220,44 +252,67 @@ LinkReceiver::ReadFromPort(bigtime_t timeout)
 	// we are here so it means we finished reading the buffer contents
 	ResetBuffer();
 
-	status_t err = AdjustReplyBuffer(timeout);
-	if (err < B_OK)
-		return err;
+	while (true) {
+		bool waiting = false;
+		if (fRing != NULL) {
+			status_t status = _ReadFromRing(waiting);
+			if (status != B_WOULD_BLOCK)
+				return status;
+		}
 
-	int32 code;
-	ssize_t bytesRead;
+		status_t err = AdjustReplyBuffer(timeout);
+		if (err < B_OK) {
+			if (waiting)
+				_StopWaitingForRing();
+			return err;
+		}
 
-	STRACE(("info: LinkReceiver reading port %ld.\n", fReceivePort));
-	while (true) {
-		if (timeout != B_INFINITE_TIMEOUT) {
-			do {
-				bytesRead = read_port_etc(fReceivePort, &code, fRecvBuffer,
-					fRecvBufferSize, B_TIMEOUT, timeout);
-			} while (bytesRead == B_INTERRUPTED);
-		} else {
-			do {
-				bytesRead = read_port(fReceivePort, &code, fRecvBuffer,
-					fRecvBufferSize);
-			} while (bytesRead == B_INTERRUPTED);
+		int32 code;
+		ssize_t bytesRead;
+
+		STRACE(("info: LinkReceiver reading port %ld.\n", fReceivePort));
+		while (true) {
+			if (timeout != B_INFINITE_TIMEOUT) {
+				do {
+					bytesRead = read_port_etc(fReceivePort, &code, fRecvBuffer,
+						fRecvBufferSize, B_TIMEOUT, timeout);
+				} while (bytesRead == B_INTERRUPTED);
+			} else {
+				do {
+					bytesRead = read_port(fReceivePort, &code, fRecvBuffer,
+						fRecvBufferSize);
+				} while (bytesRead == B_INTERRUPTED);
+			}
+
+			STRACE(("info: LinkReceiver read %ld bytes.\n", bytesRead));
+			if (bytesRead < B_OK)
+				break;
+
+			// we just ignore incorrect messages, and don't bother our caller
+
+			if (code != kLinkCode) {
+				STRACE(("wrong port message %lx received.\n", code));
+				continue;
+			}
+
+			// port read seems to be valid
+			break;
 		}
 
-		STRACE(("info: LinkReceiver read %ld bytes.\n", bytesRead));
+		if (waiting)
+			_StopWaitingForRing();
 		if (bytesRead < B_OK)
 			return bytesRead;
 
-		// we just ignore incorrect messages, and don't bother our caller
-
-		if (code != kLinkCode) {
-			STRACE(("wrong port message %lx received.\n", code));
+		if (bytesRead == 0 && fRing != NULL) {
+			// the ring sender woke us up
+			fRingWakeupsRead++;
 			continue;
 		}
 
-		// port read seems to be valid
-		break;
+		fDataSize = bytesRead;
+		return B_OK;
 	}
-
-	fDataSize = bytesRead;
-	return B_OK;
 }
 
 
@@ -587,4 +642,125 @@ LinkReceiver::ReadGradient(BGradient** _gradient)
 }
 
 
+/*!	Reads the next record from the ring into the receive buffer. If the ring
+	is empty, \c B_WOULD_BLOCK is returned, and \a _waiting is set when the
+	sender has been asked to wake us up through the port.
+*/
+status_t
+LinkReceiver::_ReadFromRing(bool& _waiting)
+{
+	// Have a look at the port from time to time, so that messages that
+	// don't come from the ring sender are not held up by a busy ring
+	if (++fRingReads % kRingPortCheckInterval == 0
+		&& port_count(fReceivePort) > _RingWakeupsInPort())
+		return B_WOULD_BLOCK;
+
+	status_t status = _ReadRingRecord();
+	if (status == B_WOULD_BLOCK) {
+		// Ask the sender to wake us up, and look again, as it might have
+		// written to the ring before it could see the flag
+		atomic_get_and_set(&fRing->reader_waiting, 1);
+		_waiting = true;
+
+		status = _ReadRingRecord();
+		if (status != B_WOULD_BLOCK) {
+			_StopWaitingForRing();
+			_waiting = false;
+		}
+	}
+
+	if (status == B_BAD_DATA) {
+		// the sender doesn't play by the rules, stop using the ring
+		fRing = NULL;
+	}
+
+	return status;
+}
+
+
+status_t
+LinkReceiver::_ReadRingRecord()
+{
+	while (true) {
+		uint32 available = (uint32)atomic_get(&fRing->write_position)
+			- fRingReadPosition;
+		if (available == 0)
+			return B_WOULD_BLOCK;
+
+		// The sender can change the ring at any time, so we only trust our
+		// own copy of the record header, and check it before using it
+		uint32 offset = fRingReadPosition % kLinkRingSize;
+		link_ring_record record;
+		memcpy(&record, fRing->data + offset, sizeof(link_ring_record));
+
+		if (available > kLinkRingSize || record.size > kLinkRingSize
+			|| link_ring_record_size(record.size) > available
+			|| link_ring_record_size(record.size) > kLinkRingSize - offset) {
+			STRACE(("error info: LinkReceiver bad ring record of %lu bytes.\n",
+				record.size));
+			return B_BAD_DATA;
+		}
+
+		if (record.code == kLinkRingWrapCode) {
+			_AdvanceRing(link_ring_record_size(record.size));
+			continue;
+		}
+
+		if (record.code != (uint32)kLinkCode || record.size == 0
+			|| record.size > kMaxBufferSize) {
+			STRACE(("error info: LinkReceiver bad ring record code %lx.\n",
+				record.code));
+			return B_BAD_DATA;
+		}
+
+		if ((int32)record.size > fRecvBufferSize) {
+			char* buffer = (char*)malloc(kMaxBufferSize);
+			if (buffer == NULL)
+				return B_NO_MEMORY;
+
+			free(fRecvBuffer);
+			fRecvBuffer = buffer;
+			fRecvBufferSize = kMaxBufferSize;
+		}
+
+		memcpy(fRecvBuffer, fRing->data + offset + sizeof(link_ring_record),
+			record.size);
+		fDataSize = record.size;
+
+		_AdvanceRing(link_ring_record_size(record.size));
+		return B_OK;
+	}
+}
+
+
+void
+LinkReceiver::_AdvanceRing(uint32 size)
+{
+	fRingReadPosition += size;
+	atomic_get_and_set(&fRing->read_position, (int32)fRingReadPosition);
+
+	if (atomic_get_and_set(&fRing->writer_waiting, 0) != 0)
+		release_sem_etc(fRingSpaceSemaphore, 1, B_DO_NOT_RESCHEDULE);
+}
+
+
+void
+LinkReceiver::_StopWaitingForRing()
+{
+	// If the sender already took the flag, its wake-up call will show up
+	// in fRing->wakeups once it has been written to the port
+	atomic_get_and_set(&fRing->reader_waiting, 0);
+}
+
+
+/*!	Returns how many of the messages in the port are wake-up calls from the
+	ring sender that have not been read yet.
+*/
+int32
+LinkReceiver::_RingWakeupsInPort() const
+{
+	return atomic_get(&fRing->wakeups) - fRingWakeupsRead;
+}
+
+
 }	// namespace BPrivate
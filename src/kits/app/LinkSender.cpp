@@ -15,6 +15,7 @@
 #include <new>
 
 #include <ServerProtocol.h>
+#include <LinkRing.h>
 #include <LinkSender.h>
 
 #include "link_message.h"
@@ -43,7 +44,10 @@ LinkSender::LinkSender(port_id port)
 
 	fCurrentEnd(0),
 	fCurrentStart(0),
-	fCurrentStatus(B_OK)
+	fCurrentStatus(B_OK),
+
+	fRing(NULL),
+	fRingSpaceSemaphore(-1)
 {
 }
 
@@ -61,6 +65,19 @@ LinkSender::SetPort(port_id port)
 }
 
 
+/*!	Lets all further flushes go to \a ring instead of the port, which is
+	then only used to wake up the receiver. When the ring is full, the
+	receiver releases \a spaceSemaphore once it has made room.
+	Pass \c NULL to use the port again.
+*/
+void
+LinkSender::SetRing(link_ring* ring, sem_id spaceSemaphore)
+{
+	fRing = ring;
+	fRingSpaceSemaphore = spaceSemaphore;
+}
+
+
 status_t
 LinkSender::StartMessage(int32 code, size_t minSize)
 {
@@ -306,7 +323,9 @@ LinkSender::Flush(bigtime_t timeout, bool needsReply)
 		fCurrentEnd, fPort));
 
 	status_t err;
-	if (timeout != B_INFINITE_TIMEOUT) {
+	if (fRing != NULL)
+		err = _FlushToRing(timeout);
+	else if (timeout != B_INFINITE_TIMEOUT) {
 		do {
 			err = write_port_etc(fPort, kLinkCode, fBuffer,
 				fCurrentEnd, B_RELATIVE_TIMEOUT, timeout);
@@ -332,4 +351,129 @@ LinkSender::Flush(bigtime_t timeout, bool needsReply)
 	return B_OK;
 }
 
+
+status_t
+LinkSender::_FlushToRing(bigtime_t timeout)
+{
+	uint32 recordSize = link_ring_record_size(fCurrentEnd);
+	uint32 position = fRing->write_position;
+	uint32 wrapSize = 0;
+
+	uint32 contiguous = kLinkRingSize - position % kLinkRingSize;
+	if (recordSize > contiguous) {
+		// the record has to start at the beginning of the ring
+		wrapSize = contiguous;
+
+		if (wrapSize + recordSize > kLinkRingSize) {
+			// we can't wait for both to fit, let the receiver skip the end
+			// of the ring first
+			status_t status = _WaitForRingSpace(wrapSize, timeout);
+			if (status != B_OK)
+				return status;
+
+			_WriteRingRecord(position, kLinkRingWrapCode, NULL, wrapSize);
+			position += wrapSize;
+			_PublishRing(position);
+			wrapSize = 0;
+		}
+	}
+
+	status_t status = _WaitForRingSpace(wrapSize + recordSize, timeout);
+	if (status != B_OK)
+		return status;
+
+	if (wrapSize > 0) {
+		_WriteRingRecord(position, kLinkRingWrapCode, NULL, wrapSize);
+		position += wrapSize;
+	}
+
+	_WriteRingRecord(position, kLinkCode, fBuffer, fCurrentEnd);
+	_PublishRing(position + recordSize);
+	return B_OK;
+}
+
+
+status_t
+LinkSender::_WaitForRingSpace(uint32 size, bigtime_t timeout)
+{
+	if (timeout != B_INFINITE_TIMEOUT)
+		timeout += system_time();
+
+	while (true) {
+		uint32 used = (uint32)fRing->write_position
+			- (uint32)atomic_get(&fRing->read_position);
+		if (kLinkRingSize - used >= size)
+			return B_OK;
+
+		// Tell the receiver that we are waiting, and look again, as it
+		// might have made room before it saw the flag
+		atomic_get_and_set(&fRing->writer_waiting, 1);
+
+		used = (uint32)fRing->write_position
+			- (uint32)atomic_get(&fRing->read_position);
+		if (kLinkRingSize - used >= size)
+			return B_OK;
+
+		status_t status;
+		do {
+			if (timeout != B_INFINITE_TIMEOUT) {
+				status = acquire_sem_etc(fRingSpaceSemaphore, 1,
+					B_ABSOLUTE_TIMEOUT, timeout);
+			} else
+				status = acquire_sem(fRingSpaceSemaphore);
+		} while (status == B_INTERRUPTED);
+
+		if (status != B_OK)
+			return status;
+	}
+}
+
+
+/*!	Writes a record at \a position. For a wrap record, \a size is the
+	number of bytes to skip, including the record header.
+*/
+void
+LinkSender::_WriteRingRecord(uint32 position, uint32 code, const void* data,
+	uint32 size)
+{
+	link_ring_record* record = (link_ring_record*)(fRing->data
+		+ position % kLinkRingSize);
+	record->code = code;
+
+	if (code == kLinkRingWrapCode) {
+		record->size = size - sizeof(link_ring_record);
+		return;
+	}
+
+	record->size = size;
+	memcpy(record + 1, data, size);
+}
+
+
+void
+LinkSender::_PublishRing(uint32 position)
+{
+	atomic_get_and_set(&fRing->write_position, (int32)position);
+
+	// only bother the port if the receiver is about to wait on it
+	if (atomic_get_and_set(&fRing->reader_waiting, 0) != 0) {
+		// Count the wake-up call before it can be read, so that the receiver
+		// never takes it for a real message, and take it back if it could
+		// not be written.
+		atomic_add(&fRing->wakeups, 1);
+
+		status_t status;
+		do {
+			status = write_port_etc(fPort, kLinkCode, NULL, 0,
+				B_RELATIVE_TIMEOUT, 0);
+		} while (status == B_INTERRUPTED);
+
+		if (status != B_OK) {
+			// B_WOULD_BLOCK means the port is full, so there are messages
+			// pending that will wake up the receiver anyway
+			atomic_add(&fRing->wakeups, -1);
+		}
+	}
+}
+
 }	// namespace BPrivate
@@ -180,6 +180,7 @@ BBitmap::BBitmap(BRect bounds, uint32 flags, color_space colorSpace,
 	fWindow(NULL),
 	fServerToken(-1),
 	fAreaOffset(-1),
+	fBitsChanged(true),
 	fArea(-1),
 	fServerArea(-1),
 	fFlags(0),
@@ -209,6 +210,7 @@ BBitmap::BBitmap(BRect bounds, color_space colorSpace, bool acceptsViews,
 	fWindow(NULL),
 	fServerToken(-1),
 	fAreaOffset(-1),
+	fBitsChanged(true),
 	fArea(-1),
 	fServerArea(-1),
 	fFlags(0),
@@ -239,6 +241,7 @@ BBitmap::BBitmap(const BBitmap* source, bool acceptsViews, bool needsContiguous)
 	fWindow(NULL),
 	fServerToken(-1),
 	fAreaOffset(-1),
+	fBitsChanged(true),
 	fArea(-1),
 	fServerArea(-1),
 	fFlags(0),
@@ -267,6 +270,7 @@ BBitmap::BBitmap(const BBitmap& source, uint32 flags)
 	fWindow(NULL),
 	fServerToken(-1),
 	fAreaOffset(-1),
+	fBitsChanged(true),
 	fArea(-1),
 	fServerArea(-1),
 	fFlags(0),
@@ -293,6 +297,7 @@ BBitmap::BBitmap(const BBitmap& source)
 	fWindow(NULL),
 	fServerToken(-1),
 	fAreaOffset(-1),
+	fBitsChanged(true),
 	fArea(-1),
 	fServerArea(-1),
 	fFlags(0),
@@ -324,6 +329,7 @@ BBitmap::BBitmap(BMessage* data)
 	fWindow(NULL),
 	fServerToken(-1),
 	fAreaOffset(-1),
+	fBitsChanged(true),
 	fArea(-1),
 	fServerArea(-1),
 	fFlags(0),
@@ -535,6 +541,10 @@ BBitmap::Bits() const
 {
 	const_cast<BBitmap*>(this)->_AssertPointer();
 
+	// the caller may write to the bits, so the app_server has to assume
+	// they changed the next time the bitmap is drawn
+	const_cast<BBitmap*>(this)->fBitsChanged = true;
+
 	if ((fFlags & B_BITMAP_WILL_OVERLAY) != 0) {
 		overlay_client_data* data = (overlay_client_data*)fBasePointer;
 		return data->buffer;
@@ -697,6 +707,7 @@ BBitmap::ImportBits(const void* data, int32 length, int32 bpr, int32 offset,
 			return B_BAD_VALUE;
 	}
 
+	fBitsChanged = true;
 	return BPrivate::ConvertBits(data, (uint8*)fBasePointer + offset, length,
 		fSize - offset, bpr, fBytesPerRow, colorSpace, fColorSpace, width,
 		fBounds.IntegerHeight() + 1);
@@ -744,6 +755,7 @@ BBitmap::ImportBits(const void* data, int32 length, int32 bpr,
 			return B_BAD_VALUE;
 	}
 
+	fBitsChanged = true;
 	return BPrivate::ConvertBits(data, fBasePointer, length, fSize, bpr,
 		fBytesPerRow, colorSpace, fColorSpace, from, to, width, height);
 }
@@ -1017,6 +1029,8 @@ BBitmap::_InitObject(BRect bounds, color_space colorSpace, uint32 flags,
 
 	_CleanUp();
 
+	fBitsChanged = true;
+
 	// check params
 	if (!bounds.IsValid() || !bitmaps_support_space(colorSpace, NULL)) {
 		error = B_BAD_VALUE;
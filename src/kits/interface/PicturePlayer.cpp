@@ -21,6 +21,7 @@
 #include <Shape.h>
 
 
+using BPrivate::PictureDisplayList;
 using BPrivate::PicturePlayer;
 
 
@@ -1311,3 +1312,773 @@ PicturePlayer::_Play(const picture_player_callbacks& callbacks, void* userData,
 #endif
 	return B_OK;
 }
+
+
+// #pragma mark - PictureDisplayList
+
+
+static const uint16 kExitOp = 0x01;
+	// marks the end of a state change or font state
+static const uint16 kClosedPolygon = 0x02;
+
+
+struct PictureDisplayList::op_entry {
+	uint16		op;
+	uint16		flags;
+	uint32		count;
+	const void*	data;
+};
+
+
+/*!	Reads the arguments of an op, that have already been validated by
+	PictureDisplayList::Compile().
+*/
+class ValidatedReader {
+public:
+		ValidatedReader(const void* data)
+			:
+			fData((const uint8*)data)
+		{
+		}
+
+		template<typename T>
+		const T*
+		Get(size_t count = 1)
+		{
+			const T* typed = reinterpret_cast<const T*>(fData);
+			fData += sizeof(T) * count;
+			return typed;
+		}
+
+private:
+		const uint8*	fData;
+};
+
+
+template<typename T>
+static bool
+get_array(DataReader& reader, const T*& array, uint32 count)
+{
+	// the size must not overflow
+	if (count > reader.Remaining() / sizeof(T))
+		return false;
+
+	return reader.Get(array, count);
+}
+
+
+PictureDisplayList::PictureDisplayList()
+	:
+	fOps(NULL),
+	fCount(0),
+	fCapacity(0),
+	fStatus(B_NO_INIT)
+{
+}
+
+
+PictureDisplayList::~PictureDisplayList()
+{
+	free(fOps);
+}
+
+
+/*!	Parses the picture data, and keeps all ops that would be played. An op
+	whose arguments don't fit its data is left out, as PicturePlayer would
+	skip it. If the data is damaged, the ops up to that point are kept, and
+	B_BAD_DATA is returned, by this method as well as by Play().
+*/
+status_t
+PictureDisplayList::Compile(const void* data, size_t size)
+{
+	fCount = 0;
+	fStatus = _Compile(data, size, 0);
+	return fStatus;
+}
+
+
+status_t
+PictureDisplayList::Play(const picture_player_callbacks& callbacks,
+	size_t callbacksSize, void* userData) const
+{
+	if (fStatus == B_NO_INIT || fStatus == B_NO_MEMORY)
+		return fStatus;
+
+	for (int32 i = 0; i < fCount; i++) {
+		const op_entry& entry = fOps[i];
+		ValidatedReader reader(entry.data);
+
+		switch (entry.op) {
+			case B_PIC_MOVE_PEN_BY:
+				if (callbacks.move_pen_by != NULL)
+					callbacks.move_pen_by(userData, *reader.Get<BPoint>());
+				break;
+
+			case B_PIC_STROKE_LINE:
+				if (callbacks.stroke_line != NULL) {
+					const BPoint* points = reader.Get<BPoint>(2);
+					callbacks.stroke_line(userData, points[0], points[1]);
+				}
+				break;
+
+			case B_PIC_STROKE_RECT:
+			case B_PIC_FILL_RECT:
+				if (callbacks.draw_rect != NULL) {
+					callbacks.draw_rect(userData, *reader.Get<BRect>(),
+						entry.op == B_PIC_FILL_RECT);
+				}
+				break;
+
+			case B_PIC_STROKE_ROUND_RECT:
+			case B_PIC_FILL_ROUND_RECT:
+				if (callbacks.draw_round_rect != NULL) {
+					const BRect* rect = reader.Get<BRect>();
+					callbacks.draw_round_rect(userData, *rect,
+						*reader.Get<BPoint>(),
+						entry.op == B_PIC_FILL_ROUND_RECT);
+				}
+				break;
+
+			case B_PIC_STROKE_BEZIER:
+			case B_PIC_FILL_BEZIER:
+				if (callbacks.draw_bezier != NULL) {
+					callbacks.draw_bezier(userData, 4, reader.Get<BPoint>(4),
+						entry.op == B_PIC_FILL_BEZIER);
+				}
+				break;
+
+			case B_PIC_STROKE_ARC:
+			case B_PIC_FILL_ARC:
+				if (callbacks.draw_arc != NULL) {
+					const BPoint* center = reader.Get<BPoint>();
+					const BPoint* radii = reader.Get<BPoint>();
+					const float* startTheta = reader.Get<float>();
+					callbacks.draw_arc(userData, *center, *radii, *startTheta,
+						*reader.Get<float>(), entry.op == B_PIC_FILL_ARC);
+				}
+				break;
+
+			case B_PIC_STROKE_ELLIPSE:
+			case B_PIC_FILL_ELLIPSE:
+				if (callbacks.draw_ellipse != NULL) {
+					callbacks.draw_ellipse(userData, *reader.Get<BRect>(),
+						entry.op == B_PIC_FILL_ELLIPSE);
+				}
+				break;
+
+			case B_PIC_STROKE_POLYGON:
+			case B_PIC_FILL_POLYGON:
+				if (callbacks.draw_polygon != NULL) {
+					reader.Get<uint32>();
+					callbacks.draw_polygon(userData, entry.count,
+						reader.Get<BPoint>(entry.count),
+						(entry.flags & kClosedPolygon) != 0,
+						entry.op == B_PIC_FILL_POLYGON);
+				}
+				break;
+
+			case B_PIC_STROKE_SHAPE:
+			case B_PIC_FILL_SHAPE:
+				if (callbacks.draw_shape != NULL) {
+					uint32 opCount = *reader.Get<uint32>();
+					uint32 pointCount = *reader.Get<uint32>();
+					const uint32* opList = reader.Get<uint32>(opCount);
+
+					// TODO: remove BShape data copying
+					BShape shape;
+					shape.SetData(opCount, pointCount, opList,
+						reader.Get<BPoint>(pointCount));
+
+					callbacks.draw_shape(userData, shape,
+						entry.op == B_PIC_FILL_SHAPE);
+				}
+				break;
+
+			case B_PIC_DRAW_STRING:
+				if (callbacks.draw_string != NULL) {
+					const float* escapements = reader.Get<float>(2);
+					callbacks.draw_string(userData, reader.Get<char>(),
+						entry.count, escapements[0], escapements[1]);
+				}
+				break;
+
+			case B_PIC_DRAW_PIXELS:
+				if (callbacks.draw_pixels != NULL) {
+					const BRect* rects = reader.Get<BRect>(2);
+					const uint32* values = reader.Get<uint32>(5);
+					callbacks.draw_pixels(userData, rects[0], rects[1],
+						values[0], values[1], values[2],
+						(color_space)values[3], values[4],
+						reader.Get<uint8>(), entry.count);
+				}
+				break;
+
+			case B_PIC_DRAW_PICTURE:
+				if (callbacks.draw_picture != NULL) {
+					const BPoint* where = reader.Get<BPoint>();
+					callbacks.draw_picture(userData, *where,
+						*reader.Get<int32>());
+				}
+				break;
+
+			case B_PIC_SET_CLIPPING_RECTS:
+				if (callbacks.set_clipping_rects != NULL) {
+					reader.Get<uint32>();
+					callbacks.set_clipping_rects(userData, entry.count,
+						reader.Get<BRect>(entry.count));
+				}
+				break;
+
+			case B_PIC_CLEAR_CLIPPING_RECTS:
+				if (callbacks.set_clipping_rects != NULL)
+					callbacks.set_clipping_rects(userData, 0, NULL);
+				break;
+
+			case B_PIC_CLIP_TO_PICTURE:
+				if (callbacks.clip_to_picture != NULL) {
+					const int32* token = reader.Get<int32>();
+					const BPoint* where = reader.Get<BPoint>();
+					callbacks.clip_to_picture(userData, *token, *where,
+						*reader.Get<bool>());
+				}
+				break;
+
+			case B_PIC_PUSH_STATE:
+				if (callbacks.push_state != NULL)
+					callbacks.push_state(userData);
+				break;
+
+			case B_PIC_POP_STATE:
+				if (callbacks.pop_state != NULL)
+					callbacks.pop_state(userData);
+				break;
+
+			case B_PIC_ENTER_STATE_CHANGE:
+				if ((entry.flags & kExitOp) != 0) {
+					if (callbacks.exit_state_change != NULL)
+						callbacks.exit_state_change(userData);
+				} else if (callbacks.enter_state_change != NULL)
+					callbacks.enter_state_change(userData);
+				break;
+
+			case B_PIC_ENTER_FONT_STATE:
+				if ((entry.flags & kExitOp) != 0) {
+					if (callbacks.exit_font_state != NULL)
+						callbacks.exit_font_state(userData);
+				} else if (callbacks.enter_font_state != NULL)
+					callbacks.enter_font_state(userData);
+				break;
+
+			case B_PIC_SET_ORIGIN:
+				if (callbacks.set_origin != NULL)
+					callbacks.set_origin(userData, *reader.Get<BPoint>());
+				break;
+
+			case B_PIC_SET_PEN_LOCATION:
+				if (callbacks.set_pen_location != NULL)
+					callbacks.set_pen_location(userData, *reader.Get<BPoint>());
+				break;
+
+			case B_PIC_SET_DRAWING_MODE:
+				if (callbacks.set_drawing_mode != NULL) {
+					callbacks.set_drawing_mode(userData,
+						(drawing_mode)*reader.Get<uint16>());
+				}
+				break;
+
+			case B_PIC_SET_LINE_MODE:
+				if (callbacks.set_line_mode != NULL) {
+					const uint16* modes = reader.Get<uint16>(2);
+					callbacks.set_line_mode(userData, (cap_mode)modes[0],
+						(join_mode)modes[1], *reader.Get<float>());
+				}
+				break;
+
+			case B_PIC_SET_PEN_SIZE:
+				if (callbacks.set_pen_size != NULL)
+					callbacks.set_pen_size(userData, *reader.Get<float>());
+				break;
+
+			case B_PIC_SET_FORE_COLOR:
+				if (callbacks.set_fore_color != NULL)
+					callbacks.set_fore_color(userData, *reader.Get<rgb_color>());
+				break;
+
+			case B_PIC_SET_BACK_COLOR:
+				if (callbacks.set_back_color != NULL)
+					callbacks.set_back_color(userData, *reader.Get<rgb_color>());
+				break;
+
+			case B_PIC_SET_STIPLE_PATTERN:
+				if (callbacks.set_stipple_pattern != NULL) {
+					callbacks.set_stipple_pattern(userData,
+						*reader.Get<pattern>());
+				}
+				break;
+
+			case B_PIC_SET_SCALE:
+				if (callbacks.set_scale != NULL)
+					callbacks.set_scale(userData, *reader.Get<float>());
+				break;
+
+			case B_PIC_SET_FONT_FAMILY:
+				if (callbacks.set_font_family != NULL) {
+					callbacks.set_font_family(userData, reader.Get<char>(),
+						entry.count);
+				}
+				break;
+
+			case B_PIC_SET_FONT_STYLE:
+				if (callbacks.set_font_style != NULL) {
+					callbacks.set_font_style(userData, reader.Get<char>(),
+						entry.count);
+				}
+				break;
+
+			case B_PIC_SET_FONT_SPACING:
+				if (callbacks.set_font_spacing != NULL)
+					callbacks.set_font_spacing(userData, *reader.Get<uint32>());
+				break;
+
+			case B_PIC_SET_FONT_SIZE:
+				if (callbacks.set_font_size != NULL)
+					callbacks.set_font_size(userData, *reader.Get<float>());
+				break;
+
+			case B_PIC_SET_FONT_ROTATE:
+				if (callbacks.set_font_rotation != NULL)
+					callbacks.set_font_rotation(userData, *reader.Get<float>());
+				break;
+
+			case B_PIC_SET_FONT_ENCODING:
+				if (callbacks.set_font_encoding != NULL) {
+					callbacks.set_font_encoding(userData,
+						*reader.Get<uint32>());
+				}
+				break;
+
+			case B_PIC_SET_FONT_FLAGS:
+				if (callbacks.set_font_flags != NULL)
+					callbacks.set_font_flags(userData, *reader.Get<uint32>());
+				break;
+
+			case B_PIC_SET_FONT_SHEAR:
+				if (callbacks.set_font_shear != NULL)
+					callbacks.set_font_shear(userData, *reader.Get<float>());
+				break;
+
+			case B_PIC_SET_FONT_FACE:
+				if (callbacks.set_font_face != NULL)
+					callbacks.set_font_face(userData, *reader.Get<uint32>());
+				break;
+
+			case B_PIC_SET_BLENDING_MODE:
+				if (callbacks.set_blending_mode != NULL) {
+					const uint16* modes = reader.Get<uint16>(2);
+					callbacks.set_blending_mode(userData,
+						(source_alpha)modes[0], (alpha_function)modes[1]);
+				}
+				break;
+
+			case B_PIC_SET_TRANSFORM:
+				if (callbacks.set_transform != NULL) {
+					callbacks.set_transform(userData,
+						*reader.Get<BAffineTransform>());
+				}
+				break;
+
+			case B_PIC_AFFINE_TRANSLATE:
+				if (callbacks.translate_by != NULL) {
+					const double* values = reader.Get<double>(2);
+					callbacks.translate_by(userData, values[0], values[1]);
+				}
+				break;
+
+			case B_PIC_AFFINE_SCALE:
+				if (callbacks.scale_by != NULL) {
+					const double* values = reader.Get<double>(2);
+					callbacks.scale_by(userData, values[0], values[1]);
+				}
+				break;
+
+			case B_PIC_AFFINE_ROTATE:
+				if (callbacks.rotate_by != NULL)
+					callbacks.rotate_by(userData, *reader.Get<double>());
+				break;
+
+			case B_PIC_BLEND_LAYER:
+				if (callbacks.blend_layer != NULL)
+					callbacks.blend_layer(userData, *reader.Get<Layer*>());
+				break;
+
+			case B_PIC_CLIP_TO_RECT:
+				if (callbacks.clip_to_rect != NULL) {
+					const bool* inverse = reader.Get<bool>();
+					callbacks.clip_to_rect(userData, *reader.Get<BRect>(),
+						*inverse);
+				}
+				break;
+
+			case B_PIC_CLIP_TO_SHAPE:
+				if (callbacks.clip_to_shape != NULL) {
+					const bool* inverse = reader.Get<bool>();
+					uint32 opCount = *reader.Get<uint32>();
+					uint32 pointCount = *reader.Get<uint32>();
+					const uint32* opList = reader.Get<uint32>(opCount);
+					callbacks.clip_to_shape(userData, opCount, opList,
+						pointCount, reader.Get<BPoint>(pointCount), *inverse);
+				}
+				break;
+		}
+	}
+
+	return fStatus;
+}
+
+
+uint16
+PictureDisplayList::OpAt(int32 index) const
+{
+	return fOps[index].op;
+}
+
+
+/*!	Returns the arguments of the op at \a index, as they are in the picture
+	data.
+*/
+const void*
+PictureDisplayList::OpDataAt(int32 index) const
+{
+	return fOps[index].data;
+}
+
+
+status_t
+PictureDisplayList::_Compile(const void* buffer, size_t length,
+	uint16 parentOp)
+{
+	DataReader pictureReader(buffer, length);
+
+	while (pictureReader.Remaining() > 0) {
+		const picture_data_entry_header* header;
+		const uint8* opData = NULL;
+		if (!pictureReader.Get(header)
+			|| !pictureReader.Get(opData, header->size)) {
+			return B_BAD_DATA;
+		}
+
+		// Disallow ops that don't fit the parent, like PicturePlayer.
+		if (parentOp == B_PIC_ENTER_STATE_CHANGE) {
+			if (header->op <= B_PIC_ENTER_STATE_CHANGE
+				|| header->op > B_PIC_SET_TRANSFORM) {
+				return B_BAD_DATA;
+			}
+		} else if (parentOp == B_PIC_ENTER_FONT_STATE) {
+			if (header->op < B_PIC_SET_FONT_FAMILY
+				|| header->op > B_PIC_SET_FONT_FACE) {
+				return B_BAD_DATA;
+			}
+		}
+
+		DataReader reader(opData, header->size);
+		uint16 flags = 0;
+		uint32 count = 0;
+		bool valid = false;
+
+		switch (header->op) {
+			case B_PIC_MOVE_PEN_BY:
+			case B_PIC_SET_ORIGIN:
+			case B_PIC_SET_PEN_LOCATION:
+			{
+				const BPoint* point;
+				valid = reader.Get(point);
+				break;
+			}
+
+			case B_PIC_STROKE_LINE:
+			case B_PIC_STROKE_ROUND_RECT:
+			case B_PIC_FILL_ROUND_RECT:
+			{
+				// two points, or a rect and a point
+				const BPoint* points;
+				valid = reader.Get(points,
+					header->op == B_PIC_STROKE_LINE ? 2 : 3);
+				break;
+			}
+
+			case B_PIC_STROKE_RECT:
+			case B_PIC_FILL_RECT:
+			case B_PIC_STROKE_ELLIPSE:
+			case B_PIC_FILL_ELLIPSE:
+			{
+				const BRect* rect;
+				valid = reader.Get(rect);
+				break;
+			}
+
+			case B_PIC_STROKE_BEZIER:
+			case B_PIC_FILL_BEZIER:
+			{
+				const BPoint* controlPoints;
+				valid = reader.Get(controlPoints, 4);
+				break;
+			}
+
+			case B_PIC_STROKE_ARC:
+			case B_PIC_FILL_ARC:
+			{
+				const BPoint* points;
+				const float* angles;
+				valid = reader.Get(points, 2) && reader.Get(angles, 2);
+				break;
+			}
+
+			case B_PIC_STROKE_POLYGON:
+			case B_PIC_FILL_POLYGON:
+			{
+				const uint32* numPoints;
+				const BPoint* points;
+				if (!reader.Get(numPoints)
+					|| !get_array(reader, points, *numPoints)) {
+					break;
+				}
+
+				count = *numPoints;
+				if (header->op == B_PIC_FILL_POLYGON) {
+					flags = kClosedPolygon;
+					valid = true;
+				} else {
+					const bool* isClosed;
+					valid = reader.Get(isClosed);
+					if (valid && *isClosed)
+						flags = kClosedPolygon;
+				}
+				break;
+			}
+
+			case B_PIC_STROKE_SHAPE:
+			case B_PIC_FILL_SHAPE:
+			case B_PIC_CLIP_TO_SHAPE:
+			{
+				const bool* inverse;
+				const uint32* opCount;
+				const uint32* pointCount;
+				const uint32* opList;
+				const BPoint* pointList;
+				valid = (header->op != B_PIC_CLIP_TO_SHAPE
+						|| reader.Get(inverse))
+					&& reader.Get(opCount) && reader.Get(pointCount)
+					&& get_array(reader, opList, *opCount)
+					&& get_array(reader, pointList, *pointCount);
+				break;
+			}
+
+			case B_PIC_DRAW_STRING:
+			{
+				const float* escapements;
+				const char* string;
+				size_t stringLength;
+				valid = reader.Get(escapements, 2)
+					&& reader.GetRemaining(string, stringLength);
+				count = stringLength;
+				break;
+			}
+
+			case B_PIC_DRAW_PIXELS:
+			{
+				const BRect* rects;
+				const uint32* values;
+				const uint8* data;
+				size_t dataLength;
+				valid = reader.Get(rects, 2) && reader.Get(values, 5)
+					&& reader.GetRemaining(data, dataLength);
+				count = dataLength;
+				break;
+			}
+
+			case B_PIC_DRAW_PICTURE:
+			{
+				const BPoint* where;
+				const int32* token;
+				valid = reader.Get(where) && reader.Get(token);
+				break;
+			}
+
+			case B_PIC_SET_CLIPPING_RECTS:
+			{
+				const uint32* numRects;
+				const BRect* rects;
+				valid = reader.Get(numRects)
+					&& get_array(reader, rects, *numRects);
+				if (valid)
+					count = *numRects;
+				break;
+			}
+
+			case B_PIC_CLIP_TO_PICTURE:
+			{
+				const int32* token;
+				const BPoint* where;
+				const bool* inverse;
+				valid = reader.Get(token) && reader.Get(where)
+					&& reader.Get(inverse);
+				break;
+			}
+
+			case B_PIC_CLEAR_CLIPPING_RECTS:
+			case B_PIC_PUSH_STATE:
+			case B_PIC_POP_STATE:
+				valid = true;
+				break;
+
+			case B_PIC_ENTER_STATE_CHANGE:
+			case B_PIC_ENTER_FONT_STATE:
+			{
+				const uint8* data;
+				size_t dataLength;
+				if (!reader.GetRemaining(data, dataLength))
+					break;
+
+				status_t status = _AddOp(header->op, 0, 0, opData);
+				if (status == B_OK)
+					status = _Compile(data, dataLength, header->op);
+				if (status == B_OK)
+					status = _AddOp(header->op, kExitOp, 0, opData);
+				if (status != B_OK)
+					return status;
+				continue;
+			}
+
+			case B_PIC_SET_DRAWING_MODE:
+			{
+				const uint16* mode;
+				valid = reader.Get(mode);
+				break;
+			}
+
+			case B_PIC_SET_LINE_MODE:
+			case B_PIC_SET_BLENDING_MODE:
+			{
+				const uint16* modes;
+				const float* miterLimit;
+				valid = reader.Get(modes, 2)
+					&& (header->op == B_PIC_SET_BLENDING_MODE
+						|| reader.Get(miterLimit));
+				break;
+			}
+
+			case B_PIC_SET_PEN_SIZE:
+			case B_PIC_SET_SCALE:
+			case B_PIC_SET_FONT_SIZE:
+			case B_PIC_SET_FONT_ROTATE:
+			case B_PIC_SET_FONT_SHEAR:
+			{
+				const float* value;
+				valid = reader.Get(value);
+				break;
+			}
+
+			case B_PIC_SET_FORE_COLOR:
+			case B_PIC_SET_BACK_COLOR:
+			{
+				const rgb_color* color;
+				valid = reader.Get(color);
+				break;
+			}
+
+			case B_PIC_SET_STIPLE_PATTERN:
+			{
+				const pattern* stipplePattern;
+				valid = reader.Get(stipplePattern);
+				break;
+			}
+
+			case B_PIC_SET_FONT_FAMILY:
+			case B_PIC_SET_FONT_STYLE:
+			{
+				const char* name;
+				size_t nameLength;
+				valid = reader.GetRemaining(name, nameLength);
+				count = nameLength;
+				break;
+			}
+
+			case B_PIC_SET_FONT_SPACING:
+			case B_PIC_SET_FONT_ENCODING:
+			case B_PIC_SET_FONT_FLAGS:
+			case B_PIC_SET_FONT_FACE:
+			{
+				const uint32* value;
+				valid = reader.Get(value);
+				break;
+			}
+
+			case B_PIC_SET_TRANSFORM:
+			{
+				const BAffineTransform* transform;
+				valid = reader.Get(transform);
+				break;
+			}
+
+			case B_PIC_AFFINE_TRANSLATE:
+			case B_PIC_AFFINE_SCALE:
+			case B_PIC_AFFINE_ROTATE:
+			{
+				const double* values;
+				valid = reader.Get(values,
+					header->op == B_PIC_AFFINE_ROTATE ? 1 : 2);
+				break;
+			}
+
+			case B_PIC_BLEND_LAYER:
+			{
+				Layer* const* layer;
+				valid = reader.Get<Layer*>(layer);
+				break;
+			}
+
+			case B_PIC_CLIP_TO_RECT:
+			{
+				const bool* inverse;
+				const BRect* rect;
+				valid = reader.Get(inverse) && reader.Get(rect);
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		if (!valid)
+			continue;
+
+		status_t status = _AddOp(header->op, flags, count, opData);
+		if (status != B_OK)
+			return status;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PictureDisplayList::_AddOp(uint16 op, uint16 flags, uint32 count,
+	const void* data)
+{
+	if (fCount == fCapacity) {
+		int32 capacity = fCapacity > 0 ? fCapacity * 2 : 32;
+		op_entry* ops = (op_entry*)realloc(fOps, capacity * sizeof(op_entry));
+		if (ops == NULL)
+			return B_NO_MEMORY;
+
+		fOps = ops;
+		fCapacity = capacity;
+	}
+
+	op_entry& entry = fOps[fCount++];
+	entry.op = op;
+	entry.flags = flags;
+	entry.count = count;
+	entry.data = data;
+	return B_OK;
+}
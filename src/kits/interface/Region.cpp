@@ -22,15 +22,24 @@
 const static int32 kDataBlockSize = 8;
 
 
-// Initializes an empty region.
+// Returns whether the two rects in internal format have any area in common.
+static inline bool
+overlaps(const clipping_rect& a, const clipping_rect& b)
+{
+	return a.left < b.right && a.right > b.left && a.top < b.bottom
+		&& a.bottom > b.top;
+}
+
+
+// Initializes an empty region. Nothing is allocated until it holds more than
+// one rect.
 BRegion::BRegion()
 	:
 	fCount(0),
-	fDataSize(0),
+	fDataSize(1),
 	fBounds((clipping_rect){ 0, 0, 0, 0 }),
-	fData(NULL)
+	fData(&fBounds)
 {
-	_SetSize(kDataBlockSize);
 }
 
 
@@ -38,9 +47,9 @@ BRegion::BRegion()
 BRegion::BRegion(const BRegion& other)
 	:
 	fCount(0),
-	fDataSize(0),
+	fDataSize(1),
 	fBounds((clipping_rect){ 0, 0, 0, 0 }),
-	fData(NULL)
+	fData(&fBounds)
 {
 	*this = other;
 }
@@ -77,7 +86,7 @@ BRegion::BRegion(const clipping_rect& clipping)
 BRegion::~BRegion()
 {
 	if (fData != &fBounds)
-		free(fData);
+		Support::RecycleData(fData, fDataSize);
 }
 
 
@@ -89,8 +98,8 @@ BRegion::operator=(const BRegion& other)
 		return *this;
 
 	// handle reallocation if we're too small to contain
-	// the other other
-	if (_SetSize(other.fDataSize)) {
+	// the other region
+	if (_SetSize(other.fCount)) {
 		memcpy(fData, other.fData, other.fCount * sizeof(clipping_rect));
 
 		fBounds = other.fBounds;
@@ -362,10 +371,7 @@ BRegion::Include(clipping_rect clipping)
 	// use private clipping_rect constructor which avoids malloc()
 	BRegion temp(clipping);
 
-	BRegion result;
-	Support::XUnionRegion(this, &temp, &result);
-
-	_AdoptRegionData(result);
+	Include(&temp);
 }
 
 
@@ -373,7 +379,20 @@ BRegion::Include(clipping_rect clipping)
 void
 BRegion::Include(const BRegion* region)
 {
+	if (region == this || region->fCount == 0)
+		return;
+
+	if (fCount == 0
+		|| (region->fCount == 1 && rect_contains(region->fBounds, fBounds))) {
+		*this = *region;
+		return;
+	}
+
+	if (fCount == 1 && rect_contains(fBounds, region->fBounds))
+		return;
+
 	BRegion result;
+	Support::AcquireSpareData(&result, max_c(fCount, region->fCount) * 2);
 	Support::XUnionRegion(this, region, &result);
 
 	_AdoptRegionData(result);
@@ -404,10 +423,7 @@ BRegion::Exclude(clipping_rect clipping)
 	// use private clipping_rect constructor which avoids malloc()
 	BRegion temp(clipping);
 
-	BRegion result;
-	Support::XSubtractRegion(this, &temp, &result);
-
-	_AdoptRegionData(result);
+	Exclude(&temp);
 }
 
 
@@ -415,7 +431,18 @@ BRegion::Exclude(clipping_rect clipping)
 void
 BRegion::Exclude(const BRegion* region)
 {
+	if (fCount == 0 || region->fCount == 0
+		|| !overlaps(fBounds, region->fBounds))
+		return;
+
+	if (region == this
+		|| (region->fCount == 1 && rect_contains(region->fBounds, fBounds))) {
+		MakeEmpty();
+		return;
+	}
+
 	BRegion result;
+	Support::AcquireSpareData(&result, max_c(fCount, region->fCount) * 2);
 	Support::XSubtractRegion(this, region, &result);
 
 	_AdoptRegionData(result);
@@ -427,7 +454,31 @@ BRegion::Exclude(const BRegion* region)
 void
 BRegion::IntersectWith(const BRegion* region)
 {
+	if (region == this || fCount == 0)
+		return;
+
+	if (region->fCount == 0 || !overlaps(fBounds, region->fBounds)) {
+		MakeEmpty();
+		return;
+	}
+
+	if (region->fCount == 1 && rect_contains(region->fBounds, fBounds))
+		return;
+
+	if (fCount == 1) {
+		if (rect_contains(fBounds, region->fBounds)) {
+			*this = *region;
+			return;
+		}
+		if (region->fCount == 1) {
+			fBounds = sect_rect(fBounds, region->fBounds);
+			fData[0] = fBounds;
+			return;
+		}
+	}
+
 	BRegion result;
+	Support::AcquireSpareData(&result, max_c(fCount, region->fCount) * 2);
 	Support::XIntersectRegion(this, region, &result);
 
 	_AdoptRegionData(result);
@@ -440,6 +491,7 @@ void
 BRegion::ExclusiveInclude(const BRegion* region)
 {
 	BRegion result;
+	Support::AcquireSpareData(&result, (fCount + region->fCount) * 2);
 	Support::XXorRegion(this, region, &result);
 
 	_AdoptRegionData(result);
@@ -458,11 +510,12 @@ BRegion::ExclusiveInclude(const BRegion* region)
 void
 BRegion::_AdoptRegionData(BRegion& region)
 {
+	if (fData != &fBounds)
+		Support::RecycleData(fData, fDataSize);
+
 	fCount = region.fCount;
 	fDataSize = region.fDataSize;
 	fBounds = region.fBounds;
-	if (fData != &fBounds)
-		free(fData);
 	if (region.fData != &region.fBounds)
 		fData = region.fData;
 	else
@@ -74,12 +74,15 @@ SOFTWARE.
 
 #include "RegionSupport.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <new>
 
 using std::nothrow;
 
+#include <OS.h>
 #include <SupportDefs.h>
+#include <TLS.h>
 
 
 #ifdef DEBUG
@@ -181,6 +184,26 @@ using std::nothrow;
 
 
 
+/*
+ *  Returns the first rectangle at or after "rect" that has scanlines below
+ *  "y". Since all rectangles of a band have the same bottom, and the bands
+ *  are sorted, this is always the first rectangle of a band, and it can be
+ *  found with a binary search.
+ */
+static clipping_rect*
+FindBand(clipping_rect* rect, clipping_rect* rectEnd, int y)
+{
+    while (rect < rectEnd) {
+        clipping_rect* middle = rect + (rectEnd - rect) / 2;
+        if (middle->bottom <= y)
+            rect = middle + 1;
+        else
+            rectEnd = middle;
+    }
+    return rect;
+}
+
+
 /*	Create a new empty region	*/
 BRegion*
 BRegion::Support::CreateRegion(void)
@@ -907,6 +930,25 @@ BRegion::Support::miRegionOp(
     
     do
     {
+	/*
+	 * Bands that only one of the regions has, and that are of no interest
+	 * for the operation, can be skipped all at once.
+	 */
+	if (nonOverlap1Func == NULL && r1->bottom <= r2->top)
+	{
+	    r1 = FindBand(r1, r1End, r2->top);
+	    ybot = (r1 - 1)->bottom;
+	    if (r1 == r1End)
+		break;
+	}
+	else if (nonOverlap2Func == NULL && r2->bottom <= r1->top)
+	{
+	    r2 = FindBand(r2, r2End, r1->top);
+	    ybot = (r2 - 1)->bottom;
+	    if (r2 == r2End)
+		break;
+	}
+
 	curBand = newReg->fCount;
 
 	/*
@@ -1543,16 +1585,20 @@ BRegion::Support::XPointInRegion(
     const BRegion* pRegion,
     int x, int y)
 {
-	// TODO: binary search by "y"!
-    int i;
+    clipping_rect* rect;
+    clipping_rect* rectEnd;
 
     if (pRegion->fCount == 0)
         return false;
     if (!INBOX(pRegion->fBounds, x, y))
         return false;
-    for (i=0; i<pRegion->fCount; i++)
+
+    rectEnd = pRegion->fData + pRegion->fCount;
+    for (rect = FindBand(pRegion->fData, rectEnd, y);
+	 rect < rectEnd && rect->top <= y && rect->left <= x;
+	 rect++)
     {
-        if (INBOX (pRegion->fData[i], x, y))
+        if (rect->right > x)
 	    return true;
     }
     return false;
@@ -1579,7 +1625,8 @@ BRegion::Support::XRectInRegion(
     partIn = false;
 
     /* can stop when both partOut and partIn are true, or we reach prect->bottom */
-    for (pbox = region->fData, pboxEnd = pbox + region->fCount;
+    pboxEnd = region->fData + region->fCount;
+    for (pbox = FindBand(region->fData, pboxEnd, ry);
 	 pbox < pboxEnd;
 	 pbox++)
     {
@@ -1635,3 +1682,124 @@ BRegion::Support::XRectInRegion(
     return(partIn ? ((ry < prect->bottom) ? RectanglePart : RectangleIn) : 
 		RectangleOut);
 }
+
+
+//	#pragma mark - spare rect arrays
+
+
+/*	The operations compute their result into a new array of rects, that then
+	replaces the one of the region. Every thread keeps the last array that
+	was replaced, so that the next operation can use it instead of allocating
+	one, which makes them free of allocations once the arrays are large
+	enough.
+*/
+
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+
+static const int32 kMaxSpareDataSize = 4096;
+	// larger arrays are not kept around
+
+struct spare_data {
+	clipping_rect*	data;
+	int32			size;
+};
+
+static pthread_once_t sSpareDataInitOnce = PTHREAD_ONCE_INIT;
+static int32 sSpareDataSlot = -1;
+static spare_data sThreadExiting;
+	// put into the slot once the spare has been freed; regions destroyed
+	// after that (by static destructors run from exit(), for example) just
+	// free their arrays
+
+
+static void
+init_spare_data_slot()
+{
+	sSpareDataSlot = tls_allocate();
+}
+
+
+static void
+free_spare_data(void* _spare)
+{
+	spare_data* spare = (spare_data*)_spare;
+	tls_set(sSpareDataSlot, &sThreadExiting);
+
+	free(spare->data);
+	free(spare);
+}
+
+
+static spare_data*
+get_spare_data(bool create)
+{
+	pthread_once(&sSpareDataInitOnce, &init_spare_data_slot);
+	if (sSpareDataSlot < 0)
+		return NULL;
+
+	spare_data* spare = (spare_data*)tls_get(sSpareDataSlot);
+	if (spare == &sThreadExiting)
+		return NULL;
+	if (spare != NULL || !create)
+		return spare;
+
+	spare = (spare_data*)malloc(sizeof(spare_data));
+	if (spare == NULL)
+		return NULL;
+
+	if (on_exit_thread(free_spare_data, spare) != B_OK) {
+		free(spare);
+		return NULL;
+	}
+
+	spare->data = NULL;
+	spare->size = 0;
+	tls_set(sSpareDataSlot, spare);
+	return spare;
+}
+
+#endif	// HAIKU_TARGET_PLATFORM_HAIKU
+
+
+/*!	Gives the thread's spare array to \a region, if that does not have an
+	array of its own yet, and the spare one can hold at least \a count rects.
+*/
+void
+BRegion::Support::AcquireSpareData(BRegion* region, int32 count)
+{
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	if (region->fData != &region->fBounds)
+		return;
+
+	spare_data* spare = get_spare_data(false);
+	if (spare == NULL || spare->data == NULL || spare->size < count)
+		return;
+
+	region->fData = spare->data;
+	region->fDataSize = spare->size;
+	spare->data = NULL;
+	spare->size = 0;
+#endif
+}
+
+
+/*!	Keeps \a data as the thread's spare array if it is larger than the
+	current one, or frees it.
+*/
+void
+BRegion::Support::RecycleData(clipping_rect* data, int32 size)
+{
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	if (data != NULL && size <= kMaxSpareDataSize) {
+		spare_data* spare = get_spare_data(true);
+		if (spare != NULL && size > spare->size) {
+			free(spare->data);
+			spare->data = data;
+			spare->size = size;
+			return;
+		}
+	}
+#endif
+
+	free(data);
+}
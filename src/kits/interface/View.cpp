@@ -3007,6 +3007,8 @@ BView::DrawBitmapAsync(const BBitmap* bitmap, BRect bitmapRect, BRect viewRect,
 	info.options = options;
 	info.viewRect = viewRect;
 	info.bitmapRect = bitmapRect;
+	info.bitsChanged = bitmap->fBitsChanged;
+	const_cast<BBitmap*>(bitmap)->fBitsChanged = false;
 
 	fOwner->fLink->StartMessage(AS_VIEW_DRAW_BITMAP);
 	fOwner->fLink->Attach<ViewDrawBitmapInfo>(info);
@@ -3045,6 +3047,8 @@ BView::DrawBitmapAsync(const BBitmap* bitmap, BPoint where)
 	info.options = 0;
 	info.bitmapRect = bitmap->Bounds().OffsetToCopy(B_ORIGIN);
 	info.viewRect = info.bitmapRect.OffsetToCopy(where);
+	info.bitsChanged = bitmap->fBitsChanged;
+	const_cast<BBitmap*>(bitmap)->fBitsChanged = false;
 
 	fOwner->fLink->StartMessage(AS_VIEW_DRAW_BITMAP);
 	fOwner->fLink->Attach<ViewDrawBitmapInfo>(info);
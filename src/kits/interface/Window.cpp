@@ -30,6 +30,7 @@
 #include <InputServerTypes.h>
 #include <Layout.h>
 #include <LayoutUtils.h>
+#include <LinkRing.h>
 #include <MenuBar.h>
 #include <MenuItem.h>
 #include <MenuPrivate.h>
@@ -42,6 +43,7 @@
 #include <Roster.h>
 #include <RosterPrivate.h>
 #include <Screen.h>
+#include <ServerMemoryAllocator.h>
 #include <ServerProtocol.h>
 #include <String.h>
 #include <TextView.h>
@@ -728,6 +730,8 @@ BWindow::MessageReceived(BMessage* message)
 			_KeyboardNavigation();
 
 		if (message->what == (int32)kMsgAppServerRestarted) {
+			// the ring belonged to the old server
+			fLink->Sender().SetRing(NULL, -1);
 			fLink->SetSenderPort(
 				BApplication::Private::ServerLink()->SenderPort());
 
@@ -770,6 +774,8 @@ BWindow::MessageReceived(BMessage* message)
 
 			// Redirect our link to the new window connection
 			fLink->SetSenderPort(sendPort);
+			if (sendPort >= 0)
+				_CreateLinkRing();
 
 			// connect all views to the server again
 			fTopView->_CreateSelf();
@@ -3018,6 +3024,8 @@ BWindow::_InitData(BRect frame, const char* title, window_look look,
 
 		// Redirect our link to the new window connection
 		fLink->SetSenderPort(sendPort);
+		if (sendPort >= 0)
+			_CreateLinkRing();
 	}
 
 	STRACE(("Server says that our send port is %ld\n", sendPort));
@@ -3272,6 +3280,50 @@ BWindow::_DecomposeType(window_type type, window_look* _look,
 }
 
 
+/*!	Asks the app_server for a ring buffer in shared memory, through which
+	all further messages to our window are sent. Without it, we just keep
+	using the port.
+	The caller must hold the application's server link lock, as the ring is
+	mapped through the server memory allocator.
+*/
+void
+BWindow::_CreateLinkRing()
+{
+	fLink->StartMessage(AS_CREATE_LINK_RING);
+
+	int32 code;
+	if (fLink->FlushWithReply(code) != B_OK || code != B_OK)
+		return;
+
+	uint8 allocationFlags;
+	area_id serverArea;
+	int32 areaOffset;
+	sem_id spaceSemaphore;
+	fLink->Read<uint8>(&allocationFlags);
+	fLink->Read<area_id>(&serverArea);
+	fLink->Read<int32>(&areaOffset);
+	if (fLink->Read<sem_id>(&spaceSemaphore) != B_OK)
+		return;
+
+	BPrivate::ServerMemoryAllocator* allocator
+		= BApplication::Private::ServerAllocator();
+
+	area_id area;
+	uint8* base;
+	status_t status;
+	if ((allocationFlags & kNewAllocatorArea) != 0) {
+		status = allocator->AddArea(serverArea, area, base,
+			areaOffset + sizeof(BPrivate::link_ring));
+	} else
+		status = allocator->AreaAndBaseFor(serverArea, area, base);
+	if (status != B_OK)
+		return;
+
+	fLink->Sender().SetRing((BPrivate::link_ring*)(base + areaOffset),
+		spaceSemaphore);
+}
+
+
 void
 BWindow::_CreateTopView()
 {
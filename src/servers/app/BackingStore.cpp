@@ -0,0 +1,356 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "BackingStore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <Autolock.h>
+#include <OS.h>
+#include <driver_settings.h>
+
+#include "DrawingEngine.h"
+
+
+static const size_t kDefaultMemoryLimit = 64 * 1024 * 1024;
+static const uint64 kLowMemoryThreshold = 32 * 1024 * 1024;
+
+
+static int64
+count_pixels(const BRegion& region)
+{
+	int64 pixels = 0;
+	for (int32 i = 0; i < region.CountRects(); i++) {
+		clipping_rect rect = region.RectAtInt(i);
+		pixels += (int64)(rect.right - rect.left + 1)
+			* (rect.bottom - rect.top + 1);
+	}
+	return pixels;
+}
+
+
+BackingStore::BackingStore(BackingStoreManager& manager)
+	:
+	fManager(manager),
+	fBits(NULL),
+	fWidth(0),
+	fHeight(0)
+{
+}
+
+
+BackingStore::~BackingStore()
+{
+	fManager._Free(this);
+}
+
+
+/*!	Sets the size of the window contents. Changing it drops all retained
+	contents.
+*/
+void
+BackingStore::SetSize(int32 width, int32 height)
+{
+	if (width == fWidth && height == fHeight)
+		return;
+
+	fManager._Free(this);
+	fWidth = width;
+	fHeight = height;
+}
+
+
+/*!	Copies \a region from the screen, where the window contents start at
+	\a left, \a top. The region has to be on screen.
+*/
+status_t
+BackingStore::Retain(DrawingEngine* engine, const BRegion& region,
+	int32 left, int32 top)
+{
+	BRegion retain(BRect(0, 0, fWidth - 1, fHeight - 1));
+	retain.IntersectWith(&region);
+	if (retain.CountRects() == 0)
+		return B_OK;
+
+	if (fBits == NULL) {
+		status_t status = fManager._Allocate(this);
+		if (status != B_OK)
+			return status;
+	}
+
+	if (!engine->LockParallelAccess())
+		return B_ERROR;
+
+	retain.OffsetBy(left, top);
+	status_t status = engine->ReadRegion(retain, fBits, fWidth * 4, left,
+		top);
+	retain.OffsetBy(-left, -top);
+
+	engine->UnlockParallelAccess();
+
+	if (status != B_OK)
+		return status;
+
+	fValidRegion.Include(&retain);
+	fExposedRegion.Exclude(&retain);
+	fManager._Used(this);
+
+	atomic_add64(&fManager.fStats.retained_pixels, count_pixels(retain));
+	return B_OK;
+}
+
+
+/*!	Called when the window's visible contents changed: the retained parts
+	that are visible now are moved to the exposed region, so that they can be
+	restored by Restore(). Exposed parts from before are forgotten.
+*/
+void
+BackingStore::Expose(const BRegion& visibleRegion)
+{
+	fExposedRegion = fValidRegion;
+	fExposedRegion.IntersectWith(&visibleRegion);
+	fValidRegion.Exclude(&visibleRegion);
+}
+
+
+/*!	Writes the exposed parts of \a region back to the screen, where the
+	window contents start at \a left, \a top. On return, \a region only
+	contains what has been restored.
+*/
+void
+BackingStore::Restore(DrawingEngine* engine, BRegion& region, int32 left,
+	int32 top)
+{
+	region.IntersectWith(&fExposedRegion);
+	if (region.CountRects() == 0)
+		return;
+
+	if (!engine->LockParallelAccess()) {
+		region.MakeEmpty();
+		return;
+	}
+
+	region.OffsetBy(left, top);
+	status_t status = engine->WriteRegion(region, fBits, fWidth * 4, left,
+		top);
+	region.OffsetBy(-left, -top);
+
+	engine->UnlockParallelAccess();
+
+	if (status != B_OK) {
+		region.MakeEmpty();
+		return;
+	}
+
+	fExposedRegion.Exclude(&region);
+	fManager._Used(this);
+}
+
+
+/*!	The window contents in \a region have changed, or are about to. This
+	also forgets the exposed contents that have not been restored, since the
+	window is being drawn to.
+*/
+void
+BackingStore::Discard(const BRegion& region)
+{
+	if (fValidRegion.Intersects(region.Frame())) {
+		BRegion discarded(fValidRegion);
+		discarded.IntersectWith(&region);
+		if (discarded.CountRects() > 0) {
+			fValidRegion.Exclude(&discarded);
+			atomic_add64(&fManager.fStats.discarded_pixels,
+				count_pixels(discarded));
+		}
+	}
+
+	fExposedRegion.MakeEmpty();
+}
+
+
+void
+BackingStore::MakeEmpty()
+{
+	fValidRegion.MakeEmpty();
+	fExposedRegion.MakeEmpty();
+}
+
+
+// #pragma mark - BackingStoreManager
+
+
+BackingStoreManager::BackingStoreManager()
+	:
+	fLock("backing stores"),
+	fMemoryUsed(0),
+	fMemoryLimit(kDefaultMemoryLimit),
+	fEnabled(true)
+{
+	memset(&fStats, 0, sizeof(fStats));
+
+	void* handle = load_driver_settings("app_server");
+	if (handle != NULL) {
+		fEnabled = get_driver_boolean_parameter(handle, "backing_store", true,
+			true);
+		unload_driver_settings(handle);
+	}
+
+	// don't use more than a small share of the memory on smaller systems
+	system_info info;
+	if (get_system_info(&info) == B_OK) {
+		uint64 limit = info.max_pages * B_PAGE_SIZE / 32;
+		if (limit < fMemoryLimit)
+			fMemoryLimit = limit;
+	}
+}
+
+
+BackingStoreManager::~BackingStoreManager()
+{
+	BAutolock _(fLock);
+
+	while (BackingStore* store = fStores.Head())
+		_Evict(store);
+}
+
+
+/*!	Counts a dirty region that has been served from a backing store.
+	\a complete is \c true if the client did not have to redraw anything.
+*/
+void
+BackingStoreManager::CountRestore(const BRegion& restored, bool complete)
+{
+	atomic_add64(&fStats.restored_pixels, count_pixels(restored));
+	atomic_add64(complete ? &fStats.redraws_avoided : &fStats.redraws_reduced,
+		1);
+}
+
+
+void
+BackingStoreManager::GetStats(backing_store_stats& stats)
+{
+	BAutolock _(fLock);
+
+	stats = fStats;
+	stats.memory_used = fMemoryUsed;
+	stats.memory_limit = fMemoryLimit;
+	stats.stores = fStores.Count();
+}
+
+
+void
+BackingStoreManager::Dump()
+{
+	backing_store_stats stats;
+	GetStats(stats);
+
+	debug_printf("Backing stores: %" B_PRId32 ", %" B_PRIuSIZE " of %"
+		B_PRIuSIZE " KB used%s\n", stats.stores, stats.memory_used / 1024,
+		stats.memory_limit / 1024, fEnabled ? "" : " (disabled)");
+	debug_printf("  redraws avoided: %" B_PRId64 ", reduced: %" B_PRId64 "\n",
+		stats.redraws_avoided, stats.redraws_reduced);
+	debug_printf("  pixels retained: %" B_PRId64 ", restored: %" B_PRId64
+		", discarded: %" B_PRId64 "\n", stats.retained_pixels,
+		stats.restored_pixels, stats.discarded_pixels);
+	debug_printf("  evictions: %" B_PRId64 ", on low memory: %" B_PRId64
+		", failed allocations: %" B_PRId64 "\n", stats.evictions,
+		stats.low_memory_evictions, stats.failed_allocations);
+}
+
+
+status_t
+BackingStoreManager::_Allocate(BackingStore* store)
+{
+	size_t size = (size_t)store->fWidth * store->fHeight * 4;
+	if (size == 0)
+		return B_BAD_VALUE;
+
+	BAutolock _(fLock);
+
+	if (size > fMemoryLimit) {
+		fStats.failed_allocations++;
+		return B_NO_MEMORY;
+	}
+
+	if (_IsLowOnMemory()) {
+		// give everything back, and let the clients redraw instead
+		while (BackingStore* victim = fStores.Head()) {
+			_Evict(victim);
+			fStats.low_memory_evictions++;
+		}
+		fStats.failed_allocations++;
+		return B_NO_MEMORY;
+	}
+
+	// the least recently used stores are at the head of the list
+	while (fMemoryUsed + size > fMemoryLimit) {
+		BackingStore* victim = fStores.Head();
+		if (victim == NULL)
+			break;
+
+		_Evict(victim);
+		fStats.evictions++;
+	}
+
+	store->fBits = (uint8*)malloc(size);
+	if (store->fBits == NULL) {
+		fStats.failed_allocations++;
+		return B_NO_MEMORY;
+	}
+
+	fMemoryUsed += size;
+	fStores.Add(store);
+	return B_OK;
+}
+
+
+void
+BackingStoreManager::_Free(BackingStore* store)
+{
+	BAutolock _(fLock);
+
+	if (store->fBits != NULL)
+		_Evict(store);
+}
+
+
+void
+BackingStoreManager::_Used(BackingStore* store)
+{
+	BAutolock _(fLock);
+
+	if (store->fBits == NULL)
+		return;
+
+	fStores.Remove(store);
+	fStores.Add(store);
+}
+
+
+//!	The lock must be held.
+void
+BackingStoreManager::_Evict(BackingStore* store)
+{
+	fStores.Remove(store);
+	fMemoryUsed -= (size_t)store->fWidth * store->fHeight * 4;
+
+	free(store->fBits);
+	store->fBits = NULL;
+	store->MakeEmpty();
+}
+
+
+bool
+BackingStoreManager::_IsLowOnMemory() const
+{
+	system_info info;
+	if (get_system_info(&info) != B_OK)
+		return false;
+
+	return info.free_memory < kLowMemoryThreshold
+		|| info.free_memory < info.max_pages * B_PAGE_SIZE / 16;
+}
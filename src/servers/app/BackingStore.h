@@ -0,0 +1,120 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BACKING_STORE_H
+#define BACKING_STORE_H
+
+
+#include <Locker.h>
+#include <Region.h>
+
+#include <util/DoublyLinkedList.h>
+
+
+class BackingStoreManager;
+class DrawingEngine;
+
+
+/*!	\brief Server side copy of the hidden parts of a window's contents.
+
+	The pixels are retained when a part of the window gets covered, or the
+	window is hidden, and are written back to the screen when it is exposed
+	again, without the client having to redraw them.
+	All regions are relative to the left top of the window's content frame.
+*/
+class BackingStore : public DoublyLinkedListLinkImpl<BackingStore> {
+public:
+								BackingStore(BackingStoreManager& manager);
+								~BackingStore();
+
+			void				SetSize(int32 width, int32 height);
+
+			status_t			Retain(DrawingEngine* engine,
+									const BRegion& region, int32 left,
+									int32 top);
+			void				Expose(const BRegion& visibleRegion);
+			void				ForgetExposedContents()
+									{ fExposedRegion.MakeEmpty(); }
+			void				Restore(DrawingEngine* engine,
+									BRegion& region, int32 left, int32 top);
+			void				Discard(const BRegion& region);
+			void				MakeEmpty();
+
+			bool				IsEmpty() const
+									{ return fValidRegion.CountRects() == 0
+										&& !HasExposedContents(); }
+			bool				HasExposedContents() const
+									{ return fExposedRegion.CountRects()
+										> 0; }
+
+private:
+			friend class BackingStoreManager;
+
+			BackingStoreManager& fManager;
+			uint8*				fBits;
+			int32				fWidth;
+			int32				fHeight;
+			BRegion				fValidRegion;
+			BRegion				fExposedRegion;
+};
+
+
+typedef DoublyLinkedList<BackingStore> BackingStoreList;
+
+
+struct backing_store_stats {
+	size_t				memory_used;
+	size_t				memory_limit;
+	int32				stores;
+	int64				retained_pixels;
+	int64				restored_pixels;
+	int64				discarded_pixels;
+	int64				redraws_avoided;
+	int64				redraws_reduced;
+	int64				evictions;
+	int64				low_memory_evictions;
+	int64				failed_allocations;
+};
+
+
+/*!	\brief Keeps the memory of all backing stores within a limit.
+
+	When the limit would be exceeded, or the system runs low on memory, the
+	least recently used stores lose their contents; the affected windows are
+	then redrawn by their clients, as without a backing store.
+	Backing stores can be turned off with "backing_store false" in the
+	app_server driver settings file.
+*/
+class BackingStoreManager {
+public:
+								BackingStoreManager();
+								~BackingStoreManager();
+
+			void				CountRestore(const BRegion& restored,
+									bool complete);
+			bool				IsEnabled() const
+									{ return fEnabled; }
+
+			void				GetStats(backing_store_stats& stats);
+			void				Dump();
+
+private:
+			friend class BackingStore;
+
+			status_t			_Allocate(BackingStore* store);
+			void				_Free(BackingStore* store);
+			void				_Used(BackingStore* store);
+			void				_Evict(BackingStore* store);
+			bool				_IsLowOnMemory() const;
+
+			BLocker				fLock;
+			BackingStoreList	fStores;
+			size_t				fMemoryUsed;
+			size_t				fMemoryLimit;
+			bool				fEnabled;
+			backing_store_stats	fStats;
+};
+
+
+#endif	// BACKING_STORE_H
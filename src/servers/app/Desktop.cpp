@@ -2659,6 +2659,10 @@ Desktop::_DispatchMessage(int32 code, BPrivate::LinkReceiver& link)
 			break;
 		}
 
+		case AS_DUMP_BACKING_STORES:
+			fBackingStoreManager.Dump();
+			break;
+
 		case AS_EVENT_STREAM_CLOSED:
 			_LaunchInputServer();
 			break;
@@ -25,6 +25,7 @@
 
 #include <ServerProtocolStructs.h>
 
+#include "BackingStore.h"
 #include "CursorManager.h"
 #include "DelayedMessage.h"
 #include "DesktopListener.h"
@@ -136,6 +137,8 @@ public:
 									{ return fVirtualScreen.DrawingEngine(); }
 			::HWInterface*		HWInterface() const
 									{ return fVirtualScreen.HWInterface(); }
+			BackingStoreManager& GetBackingStoreManager()
+									{ return fBackingStoreManager; }
 
 			void				RebuildAndRedrawAfterWindowChange(
 									Window* window, BRegion& dirty);
@@ -360,6 +363,8 @@ private:
 			BRegion				fBackgroundRegion;
 			BRegion				fScreenRegion;
 
+			BackingStoreManager	fBackingStoreManager;
+
 			Window*				fMouseEventWindow;
 			const Window*		fWindowUnderMouse;
 			const Window*		fLockedFocusWindow;
@@ -91,6 +91,7 @@ string_for_message_code(uint32 code, BString& string)
 		CODE(AS_SET_SIZE_LIMITS);
 		CODE(AS_ACTIVATE_WINDOW);
 		CODE(AS_IS_FRONT_WINDOW);
+		CODE(AS_CREATE_LINK_RING);
 
 		// BPicture definitions
 		CODE(AS_CREATE_PICTURE);
@@ -95,6 +95,9 @@ public:
 
 			BPrivate::BTokenSpace& ViewTokens() { return fViewTokens; }
 
+			ClientMemoryAllocator* MemoryAllocator() const
+									{ return fMemoryAllocator; }
+
 			void				NotifyDeleteClientArea(area_id serverArea);
 
 private:
@@ -16,6 +16,7 @@
 #include <string.h>
 
 #include "BitmapManager.h"
+#include "BitmapScaleKernels.h"
 #include "ClientMemoryAllocator.h"
 #include "ColorConversion.h"
 #include "HWInterface.h"
@@ -28,6 +29,43 @@ using std::nothrow;
 using namespace BPrivate;
 
 
+static const int32 kMaxMipLevels = 16;
+
+
+/*!	Returns a new bitmap of half the size of  source, each pixel being the
+	average of a 2x2 block. If the size is odd, the last column or row is
+	left out.
+*/
+static UtilityBitmap*
+create_mip_level(const ServerBitmap* source)
+{
+	int32 width = source->Width() / 2;
+	int32 height = source->Height() / 2;
+	if (width < 1 || height < 1)
+		return NULL;
+
+	UtilityBitmap* level = new(std::nothrow) UtilityBitmap(
+		BRect(0, 0, width - 1, height - 1), source->ColorSpace(), 0);
+	if (level == NULL)
+		return NULL;
+	if (!level->IsValid()) {
+		level->ReleaseReference();
+		return NULL;
+	}
+
+	const uint8* sourceRow = source->Bits();
+	uint8* row = level->Bits();
+	for (int32 y = 0; y < height; y++) {
+		gBitmapScaleKernels->box_downscale_row(row, sourceRow,
+			source->BytesPerRow(), width);
+		sourceRow += 2 * source->BytesPerRow();
+		row += level->BytesPerRow();
+	}
+
+	return level;
+}
+
+
 /*!	A word about memory housekeeping and why it's implemented this way:
 
 	The reason why this looks so complicated is to optimize the most common
@@ -71,12 +109,17 @@ ServerBitmap::ServerBitmap(BRect rect, color_space space, uint32 flags,
 	fBytesPerRow(0),
 	fSpace(space),
 	fFlags(flags),
-	fOwner(NULL)
+	fOwner(NULL),
 	// fToken is initialized (if used) by the BitmapManager
+	fMipLevels(NULL),
+	fMipLevelsGeneration(0),
+	fGeneration(0)
 {
 	int32 minBytesPerRow = get_bytes_per_row(space, fWidth);
 
 	fBytesPerRow = max_c(bytesPerRow, minBytesPerRow);
+
+	mutex_init(&fMipLevelLock, "bitmap mip levels");
 }
 
 
@@ -86,8 +129,13 @@ ServerBitmap::ServerBitmap(const ServerBitmap* bitmap)
 	fMemory(NULL),
 	fOverlay(NULL),
 	fBuffer(NULL),
-	fOwner(NULL)
+	fOwner(NULL),
+	fMipLevels(NULL),
+	fMipLevelsGeneration(0),
+	fGeneration(0)
 {
+	mutex_init(&fMipLevelLock, "bitmap mip levels");
+
 	if (bitmap) {
 		fWidth = bitmap->fWidth;
 		fHeight = bitmap->fHeight;
@@ -106,6 +154,10 @@ ServerBitmap::ServerBitmap(const ServerBitmap* bitmap)
 
 ServerBitmap::~ServerBitmap()
 {
+	_ReleaseMipLevels();
+	delete[] fMipLevels;
+	mutex_destroy(&fMipLevelLock);
+
 	if (fMemory != NULL) {
 		if (fMemory != &fClientMemory)
 			delete fMemory;
@@ -140,8 +192,13 @@ ServerBitmap::ImportBits(const void *bits, int32 bitsLength, int32 bytesPerRow,
 	if (!bits || bitsLength < 0 || bytesPerRow <= 0)
 		return B_BAD_VALUE;
 
-	return BPrivate::ConvertBits(bits, fBuffer, bitsLength, BitsLength(),
-		bytesPerRow, fBytesPerRow, colorSpace, fSpace, fWidth, fHeight);
+	status_t status = BPrivate::ConvertBits(bits, fBuffer, bitsLength,
+		BitsLength(), bytesPerRow, fBytesPerRow, colorSpace, fSpace, fWidth,
+		fHeight);
+	if (status == B_OK)
+		BitsChanged();
+
+	return status;
 }
 
 
@@ -152,9 +209,13 @@ ServerBitmap::ImportBits(const void *bits, int32 bitsLength, int32 bytesPerRow,
 	if (!bits || bitsLength < 0 || bytesPerRow <= 0 || width < 0 || height < 0)
 		return B_BAD_VALUE;
 
-	return BPrivate::ConvertBits(bits, fBuffer, bitsLength, BitsLength(),
-		bytesPerRow, fBytesPerRow, colorSpace, fSpace, from, to, width,
-		height);
+	status_t status = BPrivate::ConvertBits(bits, fBuffer, bitsLength,
+		BitsLength(), bytesPerRow, fBytesPerRow, colorSpace, fSpace, from, to,
+		width, height);
+	if (status == B_OK)
+		BitsChanged();
+
+	return status;
 }
 
 
@@ -206,6 +267,70 @@ ServerBitmap::Owner() const
 }
 
 
+/*!	\brief Returns the bitmap scaled down by 2^\a level with a box filter.
+
+	The returned bitmap has a reference acquired for the caller. Only
+	B_RGB32 and B_RGBA32 bitmaps have mip levels, \c NULL is returned for
+	all others, or if the bitmap is too small for the level.
+
+	The levels are built on first use, and kept until BitsChanged() is
+	called.
+*/
+ServerBitmap*
+ServerBitmap::AcquireMipLevel(int32 level) const
+{
+	if (level < 1 || level > kMaxMipLevels || fBuffer == NULL
+		|| (fSpace != B_RGB32 && fSpace != B_RGBA32)
+		|| (fWidth >> level) < 1 || (fHeight >> level) < 1) {
+		return NULL;
+	}
+
+	MutexLocker locker(fMipLevelLock);
+
+	if (fMipLevels == NULL) {
+		fMipLevels = new(std::nothrow) ServerBitmap*[kMaxMipLevels];
+		if (fMipLevels == NULL)
+			return NULL;
+		memset(fMipLevels, 0, sizeof(ServerBitmap*) * kMaxMipLevels);
+	}
+
+	int32 generation = atomic_get(&fGeneration);
+	if (generation != fMipLevelsGeneration) {
+		_ReleaseMipLevels();
+		fMipLevelsGeneration = generation;
+	}
+
+	for (int32 i = 0; i < level; i++) {
+		if (fMipLevels[i] != NULL)
+			continue;
+
+		fMipLevels[i] = create_mip_level(i == 0 ? this : fMipLevels[i - 1]);
+		if (fMipLevels[i] == NULL)
+			return NULL;
+	}
+
+	fMipLevels[level - 1]->AcquireReference();
+	return fMipLevels[level - 1];
+}
+
+
+/*!	\brief Invalidates the cached mip levels.
+
+	Must be called whenever the bits of a bitmap that might have been drawn
+	scaled down before may have changed: when the server writes them, and
+	for bitmaps in client memory, when the application draws them after it
+	accessed or imported their bits, as it can write them any time without
+	the server noticing.
+	The levels are only rebuilt when they are used the next time, so this is
+	cheap enough to be called for every change.
+*/
+void
+ServerBitmap::BitsChanged()
+{
+	atomic_add(&fGeneration, 1);
+}
+
+
 void
 ServerBitmap::PrintToStream()
 {
@@ -215,6 +340,22 @@ ServerBitmap::PrintToStream()
 }
 
 
+//! The caller must hold fMipLevelLock.
+void
+ServerBitmap::_ReleaseMipLevels() const
+{
+	if (fMipLevels == NULL)
+		return;
+
+	for (int32 i = 0; i < kMaxMipLevels; i++) {
+		if (fMipLevels[i] != NULL) {
+			fMipLevels[i]->ReleaseReference();
+			fMipLevels[i] = NULL;
+		}
+	}
+}
+
+
 //	#pragma mark -
 
 
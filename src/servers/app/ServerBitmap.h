@@ -15,6 +15,7 @@
 #include <OS.h>
 
 #include <Referenceable.h>
+#include <locks.h>
 
 #include "ClientMemoryAllocator.h"
 
@@ -80,6 +81,9 @@ public:
 								BPoint from, BPoint to, int32 width,
 								int32 height);
 
+			ServerBitmap*	AcquireMipLevel(int32 level) const;
+			void			BitsChanged();
+
 			void			PrintToStream();
 
 protected:
@@ -93,6 +97,9 @@ protected:
 
 			void			AllocateBuffer();
 
+private:
+			void			_ReleaseMipLevels() const;
+
 protected:
 			ClientMemory	fClientMemory;
 			AreaMemory*		fMemory;
@@ -107,6 +114,11 @@ protected:
 
 			ServerApp*		fOwner;
 			int32			fToken;
+
+	mutable	mutex			fMipLevelLock;
+	mutable	ServerBitmap**	fMipLevels;
+	mutable	int32			fMipLevelsGeneration;
+	mutable	int32			fGeneration;
 };
 
 class UtilityBitmap : public ServerBitmap {
@@ -138,6 +150,8 @@ ServerBitmap::ShallowCopy(const ServerBitmap* from)
 	fSpace = from->fSpace;
 	fFlags = from->fFlags;
 	fToken = from->fToken;
+
+	BitsChanged();
 }
 
 #endif	// SERVER_BITMAP_H
@@ -12,14 +12,19 @@
 #include "ServerPicture.h"
 
 #include <new>
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <stack>
 
 #include "AlphaMask.h"
+#include "BitmapHWInterface.h"
 #include "DrawingEngine.h"
 #include "DrawState.h"
 #include "FontManager.h"
+#include "IntRect.h"
 #include "Layer.h"
+#include "PictureBoundingBoxPlayer.h"
 #include "ServerApp.h"
 #include "ServerBitmap.h"
 #include "ServerFont.h"
@@ -36,6 +41,7 @@
 #include <ServerProtocol.h>
 #include <ShapePrivate.h>
 
+#include <Autolock.h>
 #include <Bitmap.h>
 #include <Debug.h>
 #include <List.h>
@@ -43,6 +49,7 @@
 
 
 using std::stack;
+using BPrivate::PictureDisplayList;
 
 
 class ShapePainter : public BShapeIterator {
@@ -443,7 +450,7 @@ draw_picture(void* _canvas, const BPoint& where, int32 token)
 		canvas->SetDrawingOrigin(where);
 
 		canvas->PushState();
-		picture->Play(canvas);
+		picture->Draw(canvas);
 		canvas->PopState();
 
 		canvas->PopState();
@@ -886,6 +893,221 @@ static const BPrivate::picture_player_callbacks kPicturePlayerCallbacks = {
 };
 
 
+// #pragma mark - picture cache
+
+
+static const int32 kMaxCachedBitmaps = 2;
+	// per picture, for different scales
+static const int32 kMissesBeforeCaching = 2;
+static const int64 kMaxCachedPixels = 512 * 512;
+static const int32 kMaxCachedRegionRects = 256;
+static const size_t kMaxCacheMemory = 16 * 1024 * 1024;
+
+static const uint32 kTransparentBackground = 0x00000000;
+static const uint32 kOpaqueBackground = 0xffffffff;
+
+static BLocker sPictureCacheLock("picture cache");
+static size_t sPictureCacheMemory;
+
+
+/*!	The pixels a picture painted with a certain draw state. They can be
+	copied to the screen instead of playing the picture again when it is
+	drawn with an equivalent state. If the picture could not be cached for
+	the state, \c bitmap is \c NULL.
+*/
+struct ServerPicture::CachedBitmap {
+	CachedBitmap(const DrawState& drawState)
+		:
+		next(NULL),
+		state(new(std::nothrow) DrawState(drawState)),
+		bitmap(NULL),
+		memory(0)
+	{
+	}
+
+	~CachedBitmap()
+	{
+		delete state;
+		if (bitmap != NULL)
+			bitmap->ReleaseReference();
+		sPictureCacheMemory -= memory;
+	}
+
+	CachedBitmap*	next;
+	DrawState*		state;
+	BRect			frame;
+		// in the coordinates of the state
+	BRegion			region;
+		// the painted pixels, relative to the left top of the frame
+	UtilityBitmap*	bitmap;
+	size_t			memory;
+};
+
+
+static bool
+is_constant_drawing_mode(drawing_mode mode)
+{
+	// the result of the other modes depends on what is already there in
+	// ways the rendering over two backgrounds cannot tell
+	return mode == B_OP_COPY || mode == B_OP_OVER || mode == B_OP_ERASE
+		|| mode == B_OP_ALPHA;
+}
+
+
+/*!	Returns whether the ops can be rendered to a bitmap on their own: they
+	must not depend on other pictures, or change the clipping.
+*/
+static bool
+is_cacheable(const PictureDisplayList* displayList)
+{
+	for (int32 i = 0; i < displayList->CountOps(); i++) {
+		switch (displayList->OpAt(i)) {
+			case B_PIC_DRAW_PICTURE:
+			case B_PIC_BLEND_LAYER:
+			case B_PIC_SET_CLIPPING_RECTS:
+			case B_PIC_CLEAR_CLIPPING_RECTS:
+			case B_PIC_CLIP_TO_PICTURE:
+			case B_PIC_CLIP_TO_RECT:
+			case B_PIC_CLIP_TO_SHAPE:
+				return false;
+
+			case B_PIC_SET_DRAWING_MODE:
+			{
+				uint16 mode;
+				memcpy(&mode, displayList->OpDataAt(i), sizeof(mode));
+				if (!is_constant_drawing_mode((drawing_mode)mode))
+					return false;
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/*!	Returns whether a picture drawn with \a state paints the same pixels as
+	it did with \a cached, only moved by a whole number of pixels.
+	The cached bitmaps are rendered without any clipping, so states with
+	user clipping or an alpha mask never match.
+*/
+static bool
+is_equivalent_state(const DrawState& cached, const DrawState& state)
+{
+	if (state.HasClipping() || state.GetAlphaMask() != NULL
+		|| cached.HasClipping() || cached.GetAlphaMask() != NULL)
+		return false;
+
+	BPoint offset = state.CombinedOrigin() - cached.CombinedOrigin();
+	if (offset.x != floorf(offset.x) || offset.y != floorf(offset.y))
+		return false;
+
+	return state.CombinedScale() == cached.CombinedScale()
+		&& state.PenLocation() == cached.PenLocation()
+		&& state.PenSize() == cached.PenSize()
+		&& state.HighColor() == cached.HighColor()
+		&& state.LowColor() == cached.LowColor()
+		&& state.GetPattern() == cached.GetPattern()
+		&& state.GetDrawingMode() == cached.GetDrawingMode()
+		&& state.AlphaSrcMode() == cached.AlphaSrcMode()
+		&& state.AlphaFncMode() == cached.AlphaFncMode()
+		&& state.LineCapMode() == cached.LineCapMode()
+		&& state.LineJoinMode() == cached.LineJoinMode()
+		&& state.MiterLimit() == cached.MiterLimit()
+		&& state.FillRule() == cached.FillRule()
+		&& state.SubPixelPrecise() == cached.SubPixelPrecise()
+		&& state.ForceFontAliasing() == cached.ForceFontAliasing()
+		&& state.Font() == cached.Font();
+}
+
+
+static UtilityBitmap*
+render_picture(const PictureDisplayList* displayList, const DrawState& state,
+	const BRect& frame, uint32 background)
+{
+	UtilityBitmap* bitmap = new(std::nothrow) UtilityBitmap(frame, B_RGBA32,
+		0);
+	if (bitmap == NULL)
+		return NULL;
+	if (!bitmap->IsValid()) {
+		delete bitmap;
+		return NULL;
+	}
+
+	uint32* bits = (uint32*)bitmap->Bits();
+	uint32 count = bitmap->BitsLength() / 4;
+	for (uint32 i = 0; i < count; i++)
+		bits[i] = background;
+
+	BitmapHWInterface interface(bitmap);
+	DrawingEngine* engine = interface.CreateDrawingEngine();
+	if (engine == NULL) {
+		bitmap->ReleaseReference();
+		return NULL;
+	}
+	engine->SetRendererOffset((int32)frame.left, (int32)frame.top);
+
+	OffscreenCanvas canvas(engine, state, IntRect(frame));
+	canvas.PushState();
+	canvas.ResyncDrawState();
+
+	if (engine->LockParallelAccess()) {
+		BRegion clipping(frame);
+		engine->ConstrainClippingRegion(&clipping);
+		displayList->Play(kPicturePlayerCallbacks,
+			sizeof(kPicturePlayerCallbacks), &canvas);
+		engine->UnlockParallelAccess();
+	}
+
+	delete engine;
+	return bitmap;
+}
+
+
+/*!	Compares the renderings of a picture over two different backgrounds.
+	Pixels that are the same in both have been painted regardless of what
+	was there before, pixels that still have their background have not been
+	touched. If there are any other pixels, the picture blended with the
+	background, and cannot be cached.
+*/
+static bool
+get_painted_region(const UtilityBitmap* transparent,
+	const UtilityBitmap* opaque, BRegion& region)
+{
+	int32 width = transparent->Width();
+	int32 height = transparent->Height();
+
+	for (int32 y = 0; y < height; y++) {
+		const uint32* first = (const uint32*)(transparent->Bits()
+			+ y * transparent->BytesPerRow());
+		const uint32* second = (const uint32*)(opaque->Bits()
+			+ y * opaque->BytesPerRow());
+
+		int32 x = 0;
+		while (x < width) {
+			if (first[x] == kTransparentBackground
+				&& second[x] == kOpaqueBackground) {
+				x++;
+				continue;
+			}
+
+			int32 start = x;
+			while (x < width && first[x] == second[x])
+				x++;
+			if (x == start)
+				return false;
+
+			clipping_rect rect = { start, y, x - 1, y };
+			region.Include(rect);
+			if (region.CountRects() > kMaxCachedRegionRects)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+
 // #pragma mark - ServerPicture
 
 
@@ -894,7 +1116,11 @@ ServerPicture::ServerPicture()
 	fFile(NULL),
 	fPictures(NULL),
 	fPushed(NULL),
-	fOwner(NULL)
+	fOwner(NULL),
+	fDisplayList(NULL),
+	fDisplayListSize(0),
+	fCachedBitmaps(NULL),
+	fCacheMisses(0)
 {
 	fToken = gTokenSpace.NewToken(kPictureToken, this);
 	fData = new(std::nothrow) BMallocIO();
@@ -909,7 +1135,11 @@ ServerPicture::ServerPicture(const ServerPicture& picture)
 	fData(NULL),
 	fPictures(NULL),
 	fPushed(NULL),
-	fOwner(NULL)
+	fOwner(NULL),
+	fDisplayList(NULL),
+	fDisplayListSize(0),
+	fCachedBitmaps(NULL),
+	fCacheMisses(0)
 {
 	fToken = gTokenSpace.NewToken(kPictureToken, this);
 
@@ -936,7 +1166,11 @@ ServerPicture::ServerPicture(const char* fileName, int32 offset)
 	fData(NULL),
 	fPictures(NULL),
 	fPushed(NULL),
-	fOwner(NULL)
+	fOwner(NULL),
+	fDisplayList(NULL),
+	fDisplayListSize(0),
+	fCachedBitmaps(NULL),
+	fCacheMisses(0)
 {
 	fToken = gTokenSpace.NewToken(kPictureToken, this);
 
@@ -961,6 +1195,10 @@ ServerPicture::~ServerPicture()
 {
 	ASSERT(fOwner == NULL);
 
+	sPictureCacheLock.Lock();
+	_Invalidate();
+	sPictureCacheLock.Unlock();
+
 	delete fData;
 	delete fFile;
 	gTokenSpace.RemoveToken(fToken);
@@ -1118,6 +1356,14 @@ ServerPicture::SetFontFromLink(BPrivate::LinkReceiver& link)
 void
 ServerPicture::Play(Canvas* target)
 {
+	PictureDisplayList* displayList = _AcquireDisplayList();
+	if (displayList != NULL) {
+		displayList->Play(kPicturePlayerCallbacks,
+			sizeof(kPicturePlayerCallbacks), target);
+		displayList->ReleaseReference();
+		return;
+	}
+
 	// TODO: for now: then change PicturePlayer
 	// to accept a BPositionIO object
 	BMallocIO* mallocIO = dynamic_cast<BMallocIO*>(fData);
@@ -1131,6 +1377,19 @@ ServerPicture::Play(Canvas* target)
 }
 
 
+/*!	Draws the picture like Play() does, but copies the pixels from an earlier
+	rendering with an equivalent state, if there is one. The state changes
+	of the picture are not applied then, so \a target has to push its state
+	before, and pop it afterwards.
+*/
+void
+ServerPicture::Draw(Canvas* target)
+{
+	if (!_DrawCached(target))
+		Play(target);
+}
+
+
 /*!	Acquires a reference to the pushed picture.
 */
 void
@@ -1208,6 +1467,11 @@ ServerPicture::ImportData(BPrivate::LinkReceiver& link)
 	}
 
 	fData->Seek(oldPosition, SEEK_SET);
+
+	sPictureCacheLock.Lock();
+	_Invalidate();
+	sPictureCacheLock.Unlock();
+
 	return status;
 }
 
@@ -1253,3 +1517,252 @@ ServerPicture::ExportData(BPrivate::PortLink& link)
 	fData->Seek(oldPosition, SEEK_SET);
 	return status;
 }
+
+
+/*!	Returns a reference to the compiled ops of the picture, compiling them
+	first if needed, or \c NULL if that is not possible.
+*/
+PictureDisplayList*
+ServerPicture::_AcquireDisplayList()
+{
+	BMallocIO* mallocIO = dynamic_cast<BMallocIO*>(fData);
+	if (mallocIO == NULL)
+		return NULL;
+
+	BAutolock _(sPictureCacheLock);
+
+	if (fDisplayList != NULL
+		&& fDisplayListSize != (off_t)mallocIO->BufferLength()) {
+		// ops have been recorded since
+		_Invalidate();
+	}
+
+	if (fDisplayList == NULL) {
+		fDisplayList = new(std::nothrow) PictureDisplayList;
+		if (fDisplayList == NULL)
+			return NULL;
+
+		// Invalid data is not an error here: the valid ops are still played,
+		// as PicturePlayer would
+		if (fDisplayList->Compile(mallocIO->Buffer(),
+				mallocIO->BufferLength()) == B_NO_MEMORY) {
+			fDisplayList->ReleaseReference();
+			fDisplayList = NULL;
+			return NULL;
+		}
+
+		fDisplayListSize = mallocIO->BufferLength();
+	}
+
+	fDisplayList->AcquireReference();
+	return fDisplayList;
+}
+
+
+//!	Forgets the compiled ops and cached bitmaps. The cache lock must be held.
+void
+ServerPicture::_Invalidate()
+{
+	while (CachedBitmap* cached = fCachedBitmaps) {
+		fCachedBitmaps = cached->next;
+		delete cached;
+	}
+
+	if (fDisplayList != NULL) {
+		fDisplayList->ReleaseReference();
+		fDisplayList = NULL;
+	}
+
+	fDisplayListSize = 0;
+	fCacheMisses = 0;
+}
+
+
+/*!	Copies the pixels the picture painted with an equivalent state to
+	\a target, and creates the bitmap with them once the picture has been
+	drawn often enough. Returns \c false if the picture has to be played.
+*/
+bool
+ServerPicture::_DrawCached(Canvas* target)
+{
+	const DrawState& state = *target->CurrentState();
+	DrawingEngine* engine = target->GetDrawingEngine();
+	if (engine == NULL || state.GetAlphaMask() != NULL
+		|| state.HasClipping()
+		|| !state.CombinedTransform().IsIdentity()
+		|| !is_constant_drawing_mode(state.GetDrawingMode()))
+		return false;
+
+	PictureDisplayList* displayList = _AcquireDisplayList();
+	if (displayList == NULL)
+		return false;
+
+	BReference<PictureDisplayList> displayListReference(displayList, true);
+	BAutolock locker(sPictureCacheLock);
+
+	if (displayList != fDisplayList)
+		return false;
+
+	CachedBitmap* cached = _FindCachedBitmap(state);
+	if (cached == NULL) {
+		if (++fCacheMisses < kMissesBeforeCaching
+			|| sPictureCacheMemory >= kMaxCacheMemory
+			|| !is_cacheable(displayList))
+			return false;
+
+		fCacheMisses = 0;
+
+		// render without holding the lock, the picture might have been
+		// changed in the mean time, though
+		locker.Unlock();
+		cached = _CreateCachedBitmap(displayList, state);
+		locker.Lock();
+
+		if (cached == NULL)
+			return false;
+		if (displayList != fDisplayList) {
+			delete cached;
+			return false;
+		}
+
+		_AddCachedBitmap(cached);
+	}
+
+	if (cached->bitmap == NULL)
+		return false;
+
+	BPoint leftTop = cached->frame.LeftTop() + state.CombinedOrigin()
+		- cached->state->CombinedOrigin();
+	target->LocalToScreenTransform().Apply(&leftTop);
+	if (leftTop.x != floorf(leftTop.x) || leftTop.y != floorf(leftTop.y))
+		return false;
+
+	BReference<UtilityBitmap> bitmap(cached->bitmap);
+	BRegion region(cached->region);
+	locker.Unlock();
+
+	int32 left = (int32)leftTop.x;
+	int32 top = (int32)leftTop.y;
+
+	region.OffsetBy(left, top);
+	const BRegion* clipping = engine->ClippingRegion();
+	if (clipping != NULL)
+		region.IntersectWith(clipping);
+
+	// Off-screen canvases like those of layers and alpha masks draw into
+	// a bitmap that is offset from their coordinates, but WriteRegion()
+	// writes to the buffer directly
+	int32 offsetX;
+	int32 offsetY;
+	engine->GetRendererOffset(&offsetX, &offsetY);
+	region.OffsetBy(-offsetX, -offsetY);
+	left -= offsetX;
+	top -= offsetY;
+
+	return engine->WriteRegion(region, bitmap->Bits(), bitmap->BytesPerRow(),
+		left, top) == B_OK;
+}
+
+
+//!	The cache lock must be held.
+ServerPicture::CachedBitmap*
+ServerPicture::_FindCachedBitmap(const DrawState& state) const
+{
+	for (CachedBitmap* cached = fCachedBitmaps; cached != NULL;
+			cached = cached->next) {
+		if (is_equivalent_state(*cached->state, state))
+			return cached;
+	}
+
+	return NULL;
+}
+
+
+/*!	Renders the picture with \a state over two different backgrounds, and
+	keeps what it painted, if it did not depend on the background. Returns
+	\c NULL if there was not enough memory.
+*/
+ServerPicture::CachedBitmap*
+ServerPicture::_CreateCachedBitmap(PictureDisplayList* displayList,
+	const DrawState& state)
+{
+	CachedBitmap* cached = new(std::nothrow) CachedBitmap(state);
+	if (cached == NULL || cached->state == NULL) {
+		delete cached;
+		return NULL;
+	}
+
+	BRect frame;
+	PictureBoundingBoxPlayer::Play(this, &state, &frame);
+	if (!frame.IsValid())
+		return cached;
+
+	// Leave some room for the rounding in Painter, as Layer does, and then
+	// some, since the pixels outside would be lost
+	frame.left = floorf(frame.left) - 2;
+	frame.top = floorf(frame.top) - 2;
+	frame.right = ceilf(frame.right) + 4;
+	frame.bottom = ceilf(frame.bottom) + 4;
+
+	if ((int64)(frame.IntegerWidth() + 1) * (frame.IntegerHeight() + 1)
+			> kMaxCachedPixels)
+		return cached;
+
+	cached->frame = frame;
+
+	UtilityBitmap* transparent = render_picture(displayList, *cached->state,
+		frame, kTransparentBackground);
+	if (transparent == NULL) {
+		delete cached;
+		return NULL;
+	}
+
+	UtilityBitmap* opaque = render_picture(displayList, *cached->state, frame,
+		kOpaqueBackground);
+	if (opaque == NULL) {
+		transparent->ReleaseReference();
+		delete cached;
+		return NULL;
+	}
+
+	if (get_painted_region(transparent, opaque, cached->region))
+		cached->bitmap = transparent;
+	else {
+		cached->region.MakeEmpty();
+		transparent->ReleaseReference();
+	}
+
+	opaque->ReleaseReference();
+	return cached;
+}
+
+
+/*!	Adds \a cached as the most recent bitmap, replacing the one for the same
+	scale, and the oldest one if there are too many. The cache lock must be
+	held.
+*/
+void
+ServerPicture::_AddCachedBitmap(CachedBitmap* cached)
+{
+	if (cached->bitmap != NULL) {
+		cached->memory = cached->bitmap->BitsLength();
+		sPictureCacheMemory += cached->memory;
+	}
+
+	cached->next = fCachedBitmaps;
+	fCachedBitmaps = cached;
+
+	int32 count = 1;
+	CachedBitmap** link = &cached->next;
+	while (CachedBitmap* other = *link) {
+		if (count == kMaxCachedBitmaps || other->state->CombinedScale()
+				== cached->state->CombinedScale()) {
+			*link = other->next;
+			delete other;
+			continue;
+		}
+
+		count++;
+		link = &other->next;
+	}
+}
@@ -20,11 +20,13 @@
 
 class BFile;
 class Canvas;
+class DrawState;
 class ServerApp;
 class View;
 
 namespace BPrivate {
 	class LinkReceiver;
+	class PictureDisplayList;
 	class PortLink;
 }
 class BList;
@@ -51,6 +53,7 @@ public:
 			void				SetFontFromLink(BPrivate::LinkReceiver& link);
 
 			void				Play(Canvas* target);
+			void				Draw(Canvas* target);
 
 			void 				PushPicture(ServerPicture* picture);
 			ServerPicture*		PopPicture();
@@ -67,6 +70,17 @@ private:
 	friend class PictureBoundingBoxPlayer;
 
 			typedef BObjectList<ServerPicture> PictureList;
+			struct CachedBitmap;
+
+			BPrivate::PictureDisplayList* _AcquireDisplayList();
+			void				_Invalidate();
+
+			bool				_DrawCached(Canvas* target);
+			CachedBitmap*		_FindCachedBitmap(const DrawState& state) const;
+			CachedBitmap*		_CreateCachedBitmap(
+									BPrivate::PictureDisplayList* displayList,
+									const DrawState& state);
+			void				_AddCachedBitmap(CachedBitmap* cached);
 
 			int32				fToken;
 			BFile*				fFile;
@@ -74,6 +88,11 @@ private:
 			PictureList*		fPictures;
 			ServerPicture*		fPushed;
 			ServerApp*			fOwner;
+
+			BPrivate::PictureDisplayList* fDisplayList;
+			off_t				fDisplayListSize;
+			CachedBitmap*		fCachedBitmaps;
+			int32				fCacheMisses;
 };
 
 
@@ -43,6 +43,7 @@
 #include <GradientDiamond.h>
 #include <GradientConic.h>
 
+#include <LinkRing.h>
 #include <MessagePrivate.h>
 #include <PortLink.h>
 #include <ShapePrivate.h>
@@ -178,7 +179,9 @@ ServerWindow::ServerWindow(const char* title, ServerApp* app,
 	fCurrentDrawingRegionValid(false),
 
 	fDirectWindowInfo(NULL),
-	fIsDirectlyAccessing(false)
+	fIsDirectlyAccessing(false),
+
+	fLinkRingSemaphore(-1)
 {
 	STRACE(("ServerWindow(%s)::ServerWindow()\n", title));
 
@@ -221,6 +224,10 @@ ServerWindow::~ServerWindow()
 	BPrivate::gDefaultTokens.RemoveToken(fServerToken);
 
 	delete fDirectWindowInfo;
+
+	fLink.Receiver().SetRing(NULL, -1);
+	delete_sem(fLinkRingSemaphore);
+
 	STRACE(("ServerWindow(%p) will exit NOW\n", this));
 
 	delete_sem(fDeathSemaphore);
@@ -1074,6 +1081,32 @@ ServerWindow::_DispatchMessage(int32 code, BPrivate::LinkReceiver& link)
 			break;
 		}
 
+		case AS_CREATE_LINK_RING:
+		{
+			DTRACE(("ServerWindow %s: Message AS_CREATE_LINK_RING\n",
+				Title()));
+
+			// Returns
+			// 1) uint8 allocation flags
+			// 2) area_id id of the area in which the ring resides
+			// 3) int32 offset of the ring in that area
+			// 4) sem_id semaphore to wait on for space in the ring
+
+			bool newArea = false;
+			status_t status = _CreateLinkRing(newArea);
+
+			fLink.StartMessage(status);
+			if (status == B_OK) {
+				fLink.Attach<uint8>(kAllocator
+					| (newArea ? kNewAllocatorArea : 0));
+				fLink.Attach<area_id>(fLinkRingMemory.Area());
+				fLink.Attach<int32>(fLinkRingMemory.AreaOffset());
+				fLink.Attach<sem_id>(fLinkRingSemaphore);
+			}
+			fLink.Flush();
+			break;
+		}
+
 		// BDirectWindow communication
 
 		case AS_DIRECT_WINDOW_GET_SYNC_DATA:
@@ -2029,6 +2062,9 @@ fDesktop->LockSingleWindow();
 					bool wasOverlay = fCurrentView->ViewBitmap() != NULL
 						&& fCurrentView->ViewBitmap()->Overlay() != NULL;
 
+					if (bitmap != NULL)
+						bitmap->BitsChanged();
+
 					fCurrentView->SetViewBitmap(bitmap, srcRect, dstRect,
 						resizingMode, options);
 
@@ -2240,6 +2276,11 @@ fDesktop->LockSingleWindow();
 					&& !fWindow->TopView()->HasView(view))
 					break;
 
+				// this is how the application tells us that it changed the
+				// bits of the view bitmap
+				if (view->ViewBitmap() != NULL)
+					view->ViewBitmap()->BitsChanged();
+
 				BRegion dirty(invalidRect);
 				fWindow->InvalidateView(view, dirty);
 			}
@@ -2285,6 +2326,9 @@ fDesktop->LockSingleWindow();
 					region.Frame().left, region.Frame().top,
 					region.Frame().right, region.Frame().bottom));
 
+			if (fCurrentView->ViewBitmap() != NULL)
+				fCurrentView->ViewBitmap()->BitsChanged();
+
 			fWindow->InvalidateView(fCurrentView, region);
 			break;
 		}
@@ -2465,6 +2509,12 @@ void
 ServerWindow::_DispatchViewDrawingMessage(int32 code,
 	BPrivate::LinkReceiver &link)
 {
+	if (!fWindow->InUpdate()) {
+		// the view is changing its contents outside of an update, which the
+		// retained contents of its hidden parts won't reflect
+		fWindow->DiscardRetainedContents(fCurrentView);
+	}
+
 	if (!fCurrentView->IsVisible() || !fWindow->IsVisible()) {
 		if (link.NeedsReply()) {
 			debug_printf("ServerWindow::DispatchViewDrawingMessage() got "
@@ -2634,6 +2684,11 @@ ServerWindow::_DispatchViewDrawingMessage(int32 code,
 
 				fCurrentView->PenToScreenTransform().Apply(&info.viewRect);
 
+				// The application may have written to the bits since it
+				// drew the bitmap the last time
+				if (info.bitsChanged)
+					bitmap->BitsChanged();
+
 // TODO: Unbreak...
 //				if ((info.options & B_WAIT_FOR_RETRACE) != 0)
 //					fDesktop->HWInterface()->WaitForRetrace(20000);
@@ -3183,7 +3238,7 @@ ServerWindow::_DispatchViewDrawingMessage(int32 code,
 					fCurrentView->SetDrawingOrigin(where);
 
 					fCurrentView->PushState();
-					picture->Play(fCurrentView);
+					picture->Draw(fCurrentView);
 					fCurrentView->PopState();
 
 					fCurrentView->PopState();
@@ -4248,6 +4303,32 @@ ServerWindow::_EnableDirectWindowMode()
 }
 
 
+/*!	Lets the client send its messages through a ring buffer in memory shared
+	with it, instead of writing each batch to our message port.
+*/
+status_t
+ServerWindow::_CreateLinkRing(bool& _newArea)
+{
+	if (fLinkRingMemory.Address() != NULL)
+		return B_NOT_ALLOWED;
+
+	BPrivate::link_ring* ring = (BPrivate::link_ring*)fLinkRingMemory.Allocate(
+		App()->MemoryAllocator(), sizeof(BPrivate::link_ring), _newArea);
+	if (ring == NULL)
+		return B_NO_MEMORY;
+
+	fLinkRingSemaphore = create_sem(0, "link ring space");
+	if (fLinkRingSemaphore < B_OK)
+		return fLinkRingSemaphore;
+
+	// the memory might have been used before
+	memset(ring, 0, offsetof(BPrivate::link_ring, data));
+
+	fLink.Receiver().SetRing(ring, fLinkRingSemaphore);
+	return B_OK;
+}
+
+
 void
 ServerWindow::_DirectWindowSetFullScreen(bool enable)
 {
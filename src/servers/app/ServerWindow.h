@@ -25,6 +25,7 @@
 #include <PortLink.h>
 #include <TokenSpace.h>
 
+#include "ClientMemoryAllocator.h"
 #include "EventDispatcher.h"
 #include "MessageLooper.h"
 
@@ -138,6 +139,7 @@ private:
 
 			void				_ResizeToFullScreen();
 			status_t			_EnableDirectWindowMode();
+			status_t			_CreateLinkRing(bool& _newArea);
 			void				_DirectWindowSetFullScreen(bool set);
 
 			void				_SetCurrentView(View* view);
@@ -175,6 +177,9 @@ private:
 
 			DirectWindowInfo*	fDirectWindowInfo;
 			bool				fIsDirectlyAccessing;
+
+			ClientMemory		fLinkRingMemory;
+			sem_id				fLinkRingSemaphore;
 };
 
 #endif	// SERVER_WINDOW_H
@@ -25,6 +25,7 @@
 #include <ViewPrivate.h>
 #include <WindowPrivate.h>
 
+#include "BackingStore.h"
 #include "ClickTarget.h"
 #include "Decorator.h"
 #include "DecorManager.h"
@@ -96,6 +97,10 @@ Window::Window(const BRect& frame, const char *name,
 	fDrawingEngine(drawingEngine),
 	fDesktop(window->Desktop()),
 
+	fBackingStore(NULL),
+	fRetainableRegion(),
+	fRetainableOrigin(),
+
 	fCurrentUpdateSession(&fUpdateSessions[0]),
 	fPendingUpdateSession(&fUpdateSessions[1]),
 	fUpdateRequested(false),
@@ -177,6 +182,7 @@ Window::~Window()
 	DetachFromWindowStack(false);
 
 	delete fWindowBehaviour;
+	delete fBackingStore;
 	delete fDrawingEngine;
 
 	gDecorManager.CleanupForWindow(this);
@@ -206,6 +212,8 @@ Window::SetClipping(BRegion* stillAvailableOnScreen)
 
 	fVisibleContentRegionValid = false;
 	fEffectiveDrawingRegionValid = false;
+
+	_UpdateRetainedContents();
 }
 
 
@@ -368,6 +376,11 @@ Window::ResizeBy(int32 x, int32 y, BRegion* dirtyRegion, bool resizeStack)
 	fFrame.right += x;
 	fFrame.bottom += y;
 
+	// the layout of the contents changes, the client redraws them anyway
+	if (fBackingStore != NULL)
+		fBackingStore->MakeEmpty();
+	fRetainableRegion.MakeEmpty();
+
 	fContentRegionValid = false;
 	fEffectiveDrawingRegionValid = false;
 
@@ -412,6 +425,7 @@ Window::ScrollViewBy(View* view, int32 dx, int32 dy)
 	if (!dirty)
 		return;
 
+	DiscardRetainedContents(view);
 	view->ScrollBy(dx, dy, dirty);
 
 //fDrawingEngine->FillRegion(*dirty, (rgb_color){ 255, 0, 255, 255 });
@@ -431,6 +445,15 @@ void
 Window::CopyContents(BRegion* region, int32 xOffset, int32 yOffset)
 {
 	// executed in ServerWindow thread with the read lock held
+	if (fBackingStore != NULL && !fBackingStore->IsEmpty()) {
+		BRegion* changed = fRegionPool.GetRegion(*region);
+		if (changed != NULL) {
+			changed->OffsetBy(xOffset, yOffset);
+			DiscardRetainedContents(*changed);
+			fRegionPool.Recycle(changed);
+		}
+	}
+
 	if (!IsVisible())
 		return;
 
@@ -711,22 +734,38 @@ Window::ProcessDirtyRegion(BRegion& region)
 	// have the read lock and the desktop thread
 	// is blocking to get the write lock. IAW, this
 	// is only executed in one thread.
-	if (fDirtyRegion.CountRects() == 0) {
-		// the window needs to be informed
-		// when the dirty region was empty.
-		// NOTE: when the window thread has processed
-		// the dirty region in MessageReceived(),
-		// it will make the region empty again,
-		// when it is empty here, we need to send
-		// the message to initiate the next update round.
-		// Until the message is processed in the window
-		// thread, the desktop thread can add parts to
-		// the region as it likes.
-		ServerWindow()->RequestRedraw();
+	BRegion* dirty = &region;
+	if (fBackingStore != NULL && fBackingStore->HasExposedContents()) {
+		// what can be restored from the backing store doesn't need to be
+		// redrawn by the client
+		dirty = fRegionPool.GetRegion(region);
+		if (dirty == NULL)
+			dirty = &region;
+		else
+			_RestoreRetainedContents(*dirty);
+	}
+
+	if (dirty == &region || dirty->CountRects() > 0) {
+		if (fDirtyRegion.CountRects() == 0) {
+			// the window needs to be informed
+			// when the dirty region was empty.
+			// NOTE: when the window thread has processed
+			// the dirty region in MessageReceived(),
+			// it will make the region empty again,
+			// when it is empty here, we need to send
+			// the message to initiate the next update round.
+			// Until the message is processed in the window
+			// thread, the desktop thread can add parts to
+			// the region as it likes.
+			ServerWindow()->RequestRedraw();
+		}
+
+		fDirtyRegion.Include(dirty);
+		fDirtyCause |= UPDATE_EXPOSE;
 	}
 
-	fDirtyRegion.Include(&region);
-	fDirtyCause |= UPDATE_EXPOSE;
+	if (dirty != &region)
+		fRegionPool.Recycle(dirty);
 }
 
 
@@ -740,6 +779,10 @@ Window::RedrawDirtyRegion()
 	}
 
 	// executed from ServerWindow with the read lock held
+	if (fBackingStore != NULL)
+		fBackingStore->ForgetExposedContents();
+		// anything not restored yet is outdated now
+
 	if (IsVisible()) {
 		_DrawBorder();
 
@@ -783,6 +826,8 @@ Window::MarkContentDirty(BRegion& regionOnScreen)
 	// since this won't affect other windows, read locking
 	// is sufficient. If there was no dirty region before,
 	// an update message is triggered
+	DiscardRetainedContents(regionOnScreen);
+
 	if (fHidden || IsOffscreenWindow())
 		return;
 
@@ -796,6 +841,8 @@ void
 Window::MarkContentDirtyAsync(BRegion& regionOnScreen)
 {
 	// NOTE: see comments in ProcessDirtyRegion()
+	DiscardRetainedContents(regionOnScreen);
+
 	if (fHidden || IsOffscreenWindow())
 		return;
 
@@ -813,11 +860,27 @@ Window::MarkContentDirtyAsync(BRegion& regionOnScreen)
 void
 Window::InvalidateView(View* view, BRegion& viewRegion)
 {
-	if (view && IsVisible() && view->IsVisible()) {
-		if (!fContentRegionValid)
-			_UpdateContentRegion();
+	if (view == NULL)
+		return;
+
+	if (!fContentRegionValid)
+		_UpdateContentRegion();
+
+	view->LocalToScreenTransform().Apply(&viewRegion);
+
+	if (fBackingStore != NULL && !fBackingStore->IsEmpty()) {
+		// also if the window or view is hidden - the client will draw the
+		// new contents only when it is shown again
+		BRegion* changed = fRegionPool.GetRegion(viewRegion);
+		if (changed != NULL) {
+			changed->IntersectWith(
+				&view->ScreenAndUserClipping(&fContentRegion));
+			DiscardRetainedContents(*changed);
+			fRegionPool.Recycle(changed);
+		}
+	}
 
-		view->LocalToScreenTransform().Apply(&viewRegion);
+	if (IsVisible() && view->IsVisible()) {
 		viewRegion.IntersectWith(&VisibleContentRegion());
 		if (viewRegion.CountRects() > 0) {
 			viewRegion.IntersectWith(
@@ -831,6 +894,45 @@ Window::InvalidateView(View* view, BRegion& viewRegion)
 	}
 }
 
+
+/*!	\brief Removes \a regionOnScreen from the retained contents.
+
+	Called with the read lock held, whenever the contents of the window are
+	changed by other means than redrawing what has been exposed.
+*/
+void
+Window::DiscardRetainedContents(const BRegion& regionOnScreen)
+{
+	if (fBackingStore == NULL || fBackingStore->IsEmpty())
+		return;
+
+	BRegion* region = fRegionPool.GetRegion(regionOnScreen);
+	if (region == NULL) {
+		fBackingStore->MakeEmpty();
+		return;
+	}
+
+	region->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+	fBackingStore->Discard(*region);
+	fRegionPool.Recycle(region);
+}
+
+
+/*!	\brief Removes everything \a view can draw to from the retained
+		contents.
+*/
+void
+Window::DiscardRetainedContents(View* view)
+{
+	if (fBackingStore == NULL || fBackingStore->IsEmpty())
+		return;
+
+	if (!fContentRegionValid)
+		_UpdateContentRegion();
+
+	DiscardRetainedContents(view->ScreenAndUserClipping(&fContentRegion));
+}
+
 // DisableUpdateRequests
 void
 Window::DisableUpdateRequests()
@@ -1072,6 +1174,9 @@ Window::SetHidden(bool hidden)
 {
 	// the desktop takes care of dirty regions
 	if (fHidden != hidden) {
+		if (hidden)
+			_RetainVisibleContents();
+
 		fHidden = hidden;
 
 		fTopView->SetHidden(hidden);
@@ -1081,6 +1186,19 @@ Window::SetHidden(bool hidden)
 }
 
 
+void
+Window::SetCurrentWorkspace(int32 index)
+{
+	// this function is only called from the desktop thread
+	if (index < 0) {
+		// the window is no longer shown on the current workspace
+		_RetainVisibleContents();
+	}
+
+	fCurrentWorkspace = index;
+}
+
+
 void
 Window::SetShowLevel(int32 showLevel)
 {
@@ -2054,6 +2172,160 @@ Window::_ObeySizeLimits()
 }
 
 
+/*!	Whether the contents of this window can be restored from a copy of them:
+	windows that access the frame buffer themselves, or share their frame
+	with other windows, cannot.
+*/
+bool
+Window::_CanRetainContents()
+{
+	if (fDesktop == NULL || !fDesktop->GetBackingStoreManager().IsEnabled()
+		|| IsOffscreenWindow() || (fFlags & kWindowScreenFlag) != 0
+		|| fWindow->HasDirectFrameBufferAccess())
+		return false;
+
+	WindowStack* stack = fCurrentStack.Get();
+	return stack == NULL || stack->CountWindows() <= 1;
+}
+
+
+/*!	Retains the contents that have just been covered, and prepares the
+	exposed ones to be restored. Called from SetClipping(), before anything
+	is drawn on screen in the new configuration.
+*/
+void
+Window::_UpdateRetainedContents()
+{
+	if (!_CanRetainContents()) {
+		delete fBackingStore;
+		fBackingStore = NULL;
+		fRetainableRegion.MakeEmpty();
+		return;
+	}
+
+	BRegion* visible = fRegionPool.GetRegion(VisibleContentRegion());
+	if (visible == NULL)
+		return;
+
+	visible->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+
+	// what was visible before, and is covered now, is still on screen at
+	// the previous location
+	BRegion* covered = fRegionPool.GetRegion(fRetainableRegion);
+	if (covered != NULL) {
+		covered->Exclude(visible);
+		_RetainContents(*covered, fRetainableOrigin);
+		fRegionPool.Recycle(covered);
+	}
+
+	if (fBackingStore != NULL)
+		fBackingStore->Expose(*visible);
+
+	fRetainableRegion = *visible;
+	fRetainableOrigin = fFrame.LeftTop();
+
+	fRegionPool.Recycle(visible);
+}
+
+
+/*!	Retains everything that is visible, since the window is about to
+	disappear from the screen.
+*/
+void
+Window::_RetainVisibleContents()
+{
+	if (fRetainableRegion.CountRects() == 0)
+		return;
+
+	if (_CanRetainContents())
+		_RetainContents(fRetainableRegion, fRetainableOrigin);
+
+	fRetainableRegion.MakeEmpty();
+}
+
+
+/*!	Copies \a region from the screen into the backing store, where \a origin
+	is the screen location of the content frame. Parts that are still to be
+	redrawn are left out.
+*/
+void
+Window::_RetainContents(const BRegion& region, BPoint origin)
+{
+	if (region.CountRects() == 0)
+		return;
+
+	BRegion* retain = fRegionPool.GetRegion(region);
+	if (retain == NULL)
+		return;
+	BRegion* dirty = fRegionPool.GetRegion(fDirtyRegion);
+	if (dirty == NULL) {
+		fRegionPool.Recycle(retain);
+		return;
+	}
+
+	if (fPendingUpdateSession->IsUsed())
+		dirty->Include(&fPendingUpdateSession->DirtyRegion());
+	if (fCurrentUpdateSession->IsUsed())
+		dirty->Include(&fCurrentUpdateSession->DirtyRegion());
+	dirty->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+	retain->Exclude(dirty);
+
+	if (retain->CountRects() > 0) {
+		if (fBackingStore == NULL) {
+			fBackingStore = new(std::nothrow) BackingStore(
+				fDesktop->GetBackingStoreManager());
+		}
+		if (fBackingStore != NULL) {
+			fBackingStore->SetSize(fFrame.IntegerWidth() + 1,
+				fFrame.IntegerHeight() + 1);
+			fBackingStore->Retain(fDrawingEngine, *retain, (int32)origin.x,
+				(int32)origin.y);
+		}
+	}
+
+	fRegionPool.Recycle(retain);
+	fRegionPool.Recycle(dirty);
+}
+
+
+/*!	Restores the exposed parts of \a dirty from the backing store, and
+	removes them from it.
+*/
+void
+Window::_RestoreRetainedContents(BRegion& dirty)
+{
+	BRegion* restored = fRegionPool.GetRegion(dirty);
+	if (restored == NULL)
+		return;
+
+	int32 left = (int32)fFrame.left;
+	int32 top = (int32)fFrame.top;
+
+	restored->IntersectWith(&VisibleContentRegion());
+	restored->OffsetBy(-left, -top);
+	fBackingStore->Restore(fDrawingEngine, *restored, left, top);
+	restored->OffsetBy(left, top);
+
+	if (restored->CountRects() > 0) {
+		dirty.Exclude(restored);
+
+		bool complete = !dirty.Intersects(VisibleContentRegion().Frame());
+		if (!complete) {
+			BRegion* remaining = fRegionPool.GetRegion(dirty);
+			if (remaining != NULL) {
+				remaining->IntersectWith(&VisibleContentRegion());
+				complete = remaining->CountRects() == 0;
+				fRegionPool.Recycle(remaining);
+			}
+		}
+
+		fDesktop->GetBackingStoreManager().CountRestore(*restored, complete);
+	}
+
+	fRegionPool.Recycle(restored);
+}
+
+
 // #pragma mark - UpdateSession
 
 
@@ -64,6 +64,7 @@ namespace BPrivate {
 	class PortLink;
 };
 
+class BackingStore;
 class ClickTarget;
 class ClientLooper;
 class Decorator;
@@ -155,6 +156,11 @@ public:
 			// shortcut for invalidating just one view
 			void				InvalidateView(View* view, BRegion& viewRegion);
 
+			// the contents have changed, retained copies of them are outdated
+			void				DiscardRetainedContents(
+									const BRegion& regionOnScreen);
+			void				DiscardRetainedContents(View* view);
+
 			void				DisableUpdateRequests();
 			void				EnableUpdateRequests();
 
@@ -216,8 +222,7 @@ public:
 			void				SetMinimized(bool minimized);
 	inline	bool				IsMinimized() const { return fMinimized; }
 
-			void				SetCurrentWorkspace(int32 index)
-									{ fCurrentWorkspace = index; }
+			void				SetCurrentWorkspace(int32 index);
 			int32				CurrentWorkspace() const
 									{ return fCurrentWorkspace; }
 			bool				IsVisible() const;
@@ -329,6 +334,14 @@ protected:
 			void				_ObeySizeLimits();
 			void				_PropagatePosition();
 
+			// retaining the contents in the backing store
+			bool				_CanRetainContents();
+			void				_UpdateRetainedContents();
+			void				_RetainVisibleContents();
+			void				_RetainContents(const BRegion& region,
+									BPoint origin);
+			void				_RestoreRetainedContents(BRegion& dirty);
+
 			BString				fTitle;
 			// TODO: no fp rects anywhere
 			BRect				fFrame;
@@ -368,6 +381,13 @@ protected:
 			DrawingEngine*		fDrawingEngine;
 			::Desktop*			fDesktop;
 
+			// contents that are not visible on screen, and what of them
+			// was visible at the last clipping change (relative to the
+			// content frame, which was at fRetainableOrigin then)
+			BackingStore*		fBackingStore;
+			BRegion				fRetainableRegion;
+			BPoint				fRetainableOrigin;
+
 			// The synchronization, which client drawing commands
 			// belong to the redraw of which dirty region is handled
 			// through an UpdateSession. When the client has
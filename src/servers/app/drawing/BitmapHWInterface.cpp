@@ -16,6 +16,7 @@
 #include "Bitmap.h"
 #include "BitmapBuffer.h"
 #include "BBitmapBuffer.h"
+#include "ServerBitmap.h"
 
 #include "BitmapHWInterface.h"
 
@@ -25,6 +26,7 @@ using std::nothrow;
 BitmapHWInterface::BitmapHWInterface(ServerBitmap* bitmap)
 	:
 	HWInterface(false, false),
+	fBitmap(bitmap),
 	fBackBuffer(NULL),
 	fFrontBuffer(new(nothrow) BitmapBuffer(bitmap))
 {
@@ -213,3 +215,13 @@ BitmapHWInterface::IsDoubleBuffered() const
 
 	return HWInterface::IsDoubleBuffered();
 }
+
+
+status_t
+BitmapHWInterface::Invalidate(const BRect& frame)
+{
+	// everything that has been drawn into the bitmap ends up here
+	fBitmap->BitsChanged();
+
+	return HWInterface::Invalidate(frame);
+}
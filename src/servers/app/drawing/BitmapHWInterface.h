@@ -59,7 +59,10 @@ public:
 	virtual	RenderingBuffer*	BackBuffer() const;
 	virtual	bool				IsDoubleBuffered() const;
 
+	virtual	status_t			Invalidate(const BRect& frame);
+
 private:
+			ServerBitmap*		fBitmap;
 			BBitmapBuffer*		fBackBuffer;
 			BitmapBuffer*		fFrontBuffer;
 };
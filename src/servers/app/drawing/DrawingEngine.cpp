@@ -235,6 +235,13 @@ DrawingEngine::ConstrainClippingRegion(const BRegion* region)
 }
 
 
+const BRegion*
+DrawingEngine::ClippingRegion() const
+{
+	return fPainter->ClippingRegion();
+}
+
+
 void
 DrawingEngine::SetDrawState(const DrawState* state, int32 xOffset,
 	int32 yOffset)
@@ -1523,6 +1530,95 @@ DrawingEngine::ReadBitmap(ServerBitmap* bitmap, bool drawCursor, BRect bounds)
 // #pragma mark -
 
 
+/*!	\brief Copies the pixels of \a region from the drawing buffer into
+		\a bits.
+
+	The region has to be within the buffer described by \a bits, \a left and
+	\a top. Parts outside the drawing buffer are not touched.
+*/
+status_t
+DrawingEngine::ReadRegion(const BRegion& region, uint8* bits,
+	uint32 bytesPerRow, int32 left, int32 top)
+{
+	ASSERT_PARALLEL_LOCKED();
+
+	// TODO: assumes drawing buffer is 32 bits (which it currently always is)
+	RenderingBuffer* buffer = fGraphicsCard->DrawingBuffer();
+	if (buffer == NULL)
+		return B_ERROR;
+
+	BRegion clipped(BRect(0, 0, buffer->Width() - 1, buffer->Height() - 1));
+	clipped.IntersectWith(&region);
+	if (clipped.CountRects() == 0)
+		return B_OK;
+
+	AutoFloatingOverlaysHider _(fGraphicsCard, clipped.Frame());
+
+	uint32 bufferBytesPerRow = buffer->BytesPerRow();
+	for (int32 i = 0; i < clipped.CountRects(); i++) {
+		clipping_rect rect = clipped.RectAtInt(i);
+		uint32 bytes = (rect.right - rect.left + 1) * 4;
+
+		const uint8* src = (uint8*)buffer->Bits()
+			+ (ssize_t)rect.top * bufferBytesPerRow + (ssize_t)rect.left * 4;
+		uint8* dst = bits + (ssize_t)(rect.top - top) * bytesPerRow
+			+ (ssize_t)(rect.left - left) * 4;
+
+		for (int32 y = rect.top; y <= rect.bottom; y++) {
+			// this might be graphics card memory, see _CopyRect()
+			gfxcpy32(dst, src, bytes);
+			src += bufferBytesPerRow;
+			dst += bytesPerRow;
+		}
+	}
+
+	return B_OK;
+}
+
+
+/*!	\brief Copies the pixels of \a region from \a bits into the drawing
+		buffer. The counterpart of ReadRegion(), the clipping is ignored.
+*/
+status_t
+DrawingEngine::WriteRegion(const BRegion& region, const uint8* bits,
+	uint32 bytesPerRow, int32 left, int32 top)
+{
+	ASSERT_PARALLEL_LOCKED();
+
+	// TODO: assumes drawing buffer is 32 bits (which it currently always is)
+	RenderingBuffer* buffer = fGraphicsCard->DrawingBuffer();
+	if (buffer == NULL)
+		return B_ERROR;
+
+	BRegion clipped(BRect(0, 0, buffer->Width() - 1, buffer->Height() - 1));
+	clipped.IntersectWith(&region);
+	if (clipped.CountRects() == 0)
+		return B_OK;
+
+	AutoFloatingOverlaysHider _(fGraphicsCard, clipped.Frame());
+
+	uint32 bufferBytesPerRow = buffer->BytesPerRow();
+	for (int32 i = 0; i < clipped.CountRects(); i++) {
+		clipping_rect rect = clipped.RectAtInt(i);
+		uint32 bytes = (rect.right - rect.left + 1) * 4;
+
+		const uint8* src = bits + (ssize_t)(rect.top - top) * bytesPerRow
+			+ (ssize_t)(rect.left - left) * 4;
+		uint8* dst = (uint8*)buffer->Bits()
+			+ (ssize_t)rect.top * bufferBytesPerRow + (ssize_t)rect.left * 4;
+
+		for (int32 y = rect.top; y <= rect.bottom; y++) {
+			memcpy(dst, src, bytes);
+			src += bytesPerRow;
+			dst += bufferBytesPerRow;
+		}
+	}
+
+	fGraphicsCard->InvalidateRegion(clipped);
+	return B_OK;
+}
+
+
 BRect
 DrawingEngine::CopyRect(BRect src, int32 xOffset, int32 yOffset) const
 {
@@ -1570,6 +1666,20 @@ DrawingEngine::SetRendererOffset(int32 offsetX, int32 offsetY)
 }
 
 
+void
+DrawingEngine::GetRendererOffset(int32* offsetX, int32* offsetY) const
+{
+	fPainter->GetRendererOffset(offsetX, offsetY);
+}
+
+
+void
+DrawingEngine::SetParallelRendering(bool enabled)
+{
+	fPainter->SetParallelRendering(enabled);
+}
+
+
 void
 DrawingEngine::_CopyRect(uint8* src, uint32 width, uint32 height,
 	uint32 bytesPerRow, int32 xOffset, int32 yOffset) const
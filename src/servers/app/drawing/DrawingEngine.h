@@ -65,9 +65,18 @@ public:
 	virtual	status_t		ReadBitmap(ServerBitmap *bitmap, bool drawCursor,
 								BRect bounds);
 
+	// for retaining window contents, "bits" is a 32 bit buffer whose first
+	// pixel is at "left", "top" on screen
+	virtual	status_t		ReadRegion(const BRegion& region, uint8* bits,
+								uint32 bytesPerRow, int32 left, int32 top);
+	virtual	status_t		WriteRegion(const BRegion& region,
+								const uint8* bits, uint32 bytesPerRow,
+								int32 left, int32 top);
+
 	// clipping for all drawing functions, passing a NULL region
 	// will remove any clipping (drawing allowed everywhere)
 	virtual	void			ConstrainClippingRegion(const BRegion* region);
+			const BRegion*	ClippingRegion() const;
 
 	virtual	void			SetDrawState(const DrawState* state,
 								int32 xOffset = 0, int32 yOffset = 0);
@@ -190,6 +199,11 @@ public:
 								int32 yOffset) const;
 
 			void			SetRendererOffset(int32 offsetX, int32 offsetY);
+			void			GetRendererOffset(int32* offsetX,
+								int32* offsetY) const;
+
+	// render large drawing operations on several threads
+			void			SetParallelRendering(bool enabled);
 
 private:
 			void			_CopyRect(uint8* bits, uint32 width,
@@ -10,10 +10,12 @@
 #include "HWInterface.h"
 
 #include <new>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <driver_settings.h>
 #include <vesa/vesa_info.h>
 
 #include "drawing_support.h"
@@ -27,6 +29,27 @@
 using std::nothrow;
 
 
+static bool sParallelRendering = false;
+
+
+/*!	Rendering large drawing operations on several threads is off by default,
+	it can be turned on with "parallel_rendering true" in the app_server
+	driver settings file.
+*/
+static void
+read_parallel_rendering_setting()
+{
+	void* handle = load_driver_settings("app_server");
+	if (handle == NULL)
+		return;
+
+	sParallelRendering = get_driver_boolean_parameter(handle,
+		"parallel_rendering", false, true);
+
+	unload_driver_settings(handle);
+}
+
+
 HWInterfaceListener::HWInterfaceListener()
 {
 }
@@ -84,7 +107,14 @@ HWInterface::Initialize()
 DrawingEngine*
 HWInterface::CreateDrawingEngine()
 {
-	return new(std::nothrow) DrawingEngine(this);
+	static pthread_once_t sOnce = PTHREAD_ONCE_INIT;
+	pthread_once(&sOnce, &read_parallel_rendering_setting);
+
+	DrawingEngine* engine = new(std::nothrow) DrawingEngine(this);
+	if (engine != NULL)
+		engine->SetParallelRendering(sParallelRendering);
+
+	return engine;
 }
 
 
@@ -29,8 +29,9 @@
 #include "IntRect.h"
 
 
-AGGTextRenderer::AGGTextRenderer(renderer_subpix_type& subpixRenderer,
-		renderer_type& solidRenderer, renderer_bin_type& binRenderer,
+AGGTextRenderer::AGGTextRenderer(renderer_base& baseRenderer,
+		renderer_subpix_type& subpixRenderer, renderer_type& solidRenderer,
+		renderer_bin_type& binRenderer,
 		scanline_unpacked_type& scanline,
 		scanline_unpacked_subpix_type& subpixScanline,
 		rasterizer_subpix_type& subpixRasterizer,
@@ -47,6 +48,7 @@ AGGTextRenderer::AGGTextRenderer(renderer_subpix_type& subpixRenderer,
 	fCurves(fPathAdaptor),
 	fContour(fCurves),
 
+	fBaseRenderer(baseRenderer),
 	fSolidRenderer(solidRenderer),
 	fBinRenderer(binRenderer),
 	fSubpixRenderer(subpixRenderer),
@@ -247,7 +249,11 @@ public:
 						break;
 
 					case glyph_data_gray8:
-						if (fRenderer.fMaskedScanline != NULL) {
+						if (glyph->atlas_bits != NULL
+							&& fRenderer.fMaskedScanline == NULL) {
+							_BlendFromAtlas(glyph, x + fTransformOffset.x,
+								y + fTransformOffset.y);
+						} else if (fRenderer.fMaskedScanline != NULL) {
 							agg::render_scanlines(fRenderer.fGray8Adaptor,
 								*fRenderer.fMaskedScanline,
 								fRenderer.fSolidRenderer);
@@ -260,9 +266,14 @@ public:
 
 					case glyph_data_subpix:
 						// TODO: Handle alpha mask (fRenderer.fMaskedScanline)
-						agg::render_scanlines(fRenderer.fGray8Adaptor,
-							fRenderer.fGray8Scanline,
-							fRenderer.fSubpixRenderer);
+						if (glyph->atlas_bits != NULL) {
+							_BlendFromAtlas(glyph, x + fTransformOffset.x,
+								y + fTransformOffset.y);
+						} else {
+							agg::render_scanlines(fRenderer.fGray8Adaptor,
+								fRenderer.fGray8Scanline,
+								fRenderer.fSubpixRenderer);
+						}
 						break;
 
 					case glyph_data_outline: {
@@ -315,6 +326,61 @@ public:
 		return fBounds;
 	}
 
+private:
+	// Blends the coverage of the glyph from the atlas of the font cache
+	// entry. Like the scanlines it replaces, each run of non-empty pixels is
+	// blended as one span.
+	void _BlendFromAtlas(const GlyphCache* glyph, double x, double y)
+	{
+		bool subpix = glyph->data_type == glyph_data_subpix;
+		int32 width = glyph->bounds.x2 - glyph->bounds.x1 + 1;
+		int32 height = glyph->bounds.y2 - glyph->bounds.y1 + 1;
+
+		// same rounding as the scanline adaptors
+		int32 left = agg::iround(x) + glyph->bounds.x1;
+		int32 top = agg::iround(y) + glyph->bounds.y1;
+
+		int32 firstRow = max_c(0, fClippingFrame.top - top);
+		int32 lastRow = min_c(height - 1, fClippingFrame.bottom - top);
+
+		const uint8* row = glyph->atlas_bits
+			+ firstRow * glyph->atlas_bytes_per_row;
+		for (int32 i = firstRow; i <= lastRow; i++) {
+			int32 start = 0;
+			while (start < width) {
+				if (_IsEmpty(row, start, subpix)) {
+					start++;
+					continue;
+				}
+
+				int32 end = start + 1;
+				while (end < width && !_IsEmpty(row, end, subpix))
+					end++;
+
+				if (subpix) {
+					fRenderer.fBaseRenderer.blend_solid_hspan_subpix(
+						left + start, top + i, (end - start) * 3,
+						fRenderer.fSubpixRenderer.color(), row + start * 3);
+				} else {
+					fRenderer.fBaseRenderer.blend_solid_hspan(left + start,
+						top + i, end - start, fRenderer.fSolidRenderer.color(),
+						row + start);
+				}
+				start = end + 1;
+			}
+			row += glyph->atlas_bytes_per_row;
+		}
+	}
+
+	static inline bool _IsEmpty(const uint8* row, int32 x, bool subpix)
+	{
+		if (!subpix)
+			return row[x] == 0;
+
+		row += x * 3;
+		return (row[0] | row[1] | row[2]) == 0;
+	}
+
 private:
 	const Transformable& fTransform;
 	const BPoint&		fTransformOffset;
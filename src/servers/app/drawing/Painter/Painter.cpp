@@ -55,6 +55,7 @@
 
 #include "AlphaMask.h"
 #include "BitmapPainter.h"
+#include "BitmapScaleKernels.h"
 #include "DrawingMode.h"
 #include "GlobalSubpixelSettings.h"
 #include "PatternHandler.h"
@@ -62,6 +63,7 @@
 #include "ServerBitmap.h"
 #include "ServerFont.h"
 #include "SystemPalette.h"
+#include "TileWorkerPool.h"
 
 #include "AppServer.h"
 
@@ -88,6 +90,234 @@ using std::nothrow;
 #define CHECK_CLIPPING_NO_RETURN	if (!fValidClipping) return;
 
 
+// #pragma mark - tile jobs
+
+
+// Smaller operations are not worth distributing over several threads
+static const int64 kMinParallelArea = 256 * 256;
+
+
+/*!	Base class for the jobs that fill a rectangle with the clipping region
+	applied; calls _FillRect() for each clipping rect within a tile.
+	The clipping region and the rectangle are in the coordinate space of the
+	renderer, while _FillRect() gets the rect translated by the renderer
+	offset, ie. in the coordinate space of the rendering buffer.
+*/
+class ClippedRectJob : public TileJob {
+public:
+	ClippedRectJob(PainterAggInterface& aggInterface,
+			const BRegion* region, const clipping_rect& rect)
+		:
+		fRegion(region),
+		fRect(rect),
+		fBits(aggInterface.fBuffer.row_ptr(0)),
+		fBytesPerRow(aggInterface.fBuffer.stride()),
+		fWidth(aggInterface.fBuffer.width()),
+		fHeight(aggInterface.fBuffer.height()),
+		fOffsetX(aggInterface.fBaseRenderer.offset_x()),
+		fOffsetY(aggInterface.fBaseRenderer.offset_y())
+	{
+	}
+
+	virtual void RenderTile(int32 top, int32 bottom)
+	{
+		top = max_c(top, fRect.top);
+		bottom = min_c(bottom, fRect.bottom);
+
+		int32 count = fRegion->CountRects();
+		for (int32 i = 0; i < count; i++) {
+			clipping_rect box = fRegion->RectAtInt(i);
+			if (box.top > bottom) {
+				// the rects are sorted from top to bottom
+				break;
+			}
+
+			int32 x1 = max_c(box.left, fRect.left) - fOffsetX;
+			int32 x2 = min_c(box.right, fRect.right) - fOffsetX;
+			int32 y1 = max_c(box.top, top) - fOffsetY;
+			int32 y2 = min_c(box.bottom, bottom) - fOffsetY;
+
+			// never write outside of the buffer
+			x1 = max_c(x1, 0);
+			x2 = min_c(x2, fWidth - 1);
+			y1 = max_c(y1, 0);
+			y2 = min_c(y2, fHeight - 1);
+			if (x1 <= x2 && y1 <= y2)
+				_FillRect(x1, y1, x2, y2);
+		}
+	}
+
+protected:
+	virtual void _FillRect(int32 x1, int32 y1, int32 x2, int32 y2) = 0;
+
+protected:
+	const BRegion*		fRegion;
+	clipping_rect		fRect;
+	uint8*				fBits;
+	uint32				fBytesPerRow;
+	int32				fWidth;
+	int32				fHeight;
+	int32				fOffsetX;
+	int32				fOffsetY;
+};
+
+
+class SolidRectJob : public ClippedRectJob {
+public:
+	SolidRectJob(PainterAggInterface& aggInterface,
+			const BRegion* region, const clipping_rect& rect, uint32 color)
+		:
+		ClippedRectJob(aggInterface, region, rect),
+		fColor(color)
+	{
+	}
+
+protected:
+	virtual void _FillRect(int32 x1, int32 y1, int32 x2, int32 y2)
+	{
+		uint8* offset = fBits + x1 * 4;
+		for (; y1 <= y2; y1++)
+			gfxset32(offset + y1 * fBytesPerRow, fColor, (x2 - x1 + 1) * 4);
+	}
+
+private:
+	uint32				fColor;
+};
+
+
+class VerticalGradientRectJob : public ClippedRectJob {
+public:
+	VerticalGradientRectJob(PainterAggInterface& aggInterface,
+			const BRegion* region, const clipping_rect& rect,
+			const uint32* colors)
+		:
+		ClippedRectJob(aggInterface, region, rect),
+		fColors(colors)
+	{
+	}
+
+protected:
+	virtual void _FillRect(int32 x1, int32 y1, int32 x2, int32 y2)
+	{
+		uint8* offset = fBits + x1 * 4;
+		for (; y1 <= y2; y1++) {
+			gfxset32(offset + y1 * fBytesPerRow,
+				fColors[y1 + fOffsetY - fRect.top], (x2 - x1 + 1) * 4);
+		}
+	}
+
+private:
+	const uint32*		fColors;
+};
+
+
+class BlendRectJob : public ClippedRectJob {
+public:
+	BlendRectJob(PainterAggInterface& aggInterface,
+			const BRegion* region, const clipping_rect& rect,
+			const rgb_color& color)
+		:
+		ClippedRectJob(aggInterface, region, rect),
+		fColor(color)
+	{
+	}
+
+protected:
+	virtual void _FillRect(int32 x1, int32 y1, int32 x2, int32 y2)
+	{
+		uint8* offset = fBits + x1 * 4 + y1 * fBytesPerRow;
+		for (; y1 <= y2; y1++) {
+			gDrawingModeKernels->blend_line(offset, x2 - x1 + 1, fColor.red,
+				fColor.green, fColor.blue, fColor.alpha);
+			offset += fBytesPerRow;
+		}
+	}
+
+private:
+	rgb_color			fColor;
+};
+
+
+/*!	Passes the scanlines to a scanline storage, and counts them.
+*/
+struct ScanlineStorageCounter {
+	ScanlineStorageCounter(scanline_storage_type& storage)
+		:
+		storage(storage),
+		count(0)
+	{
+	}
+
+	void prepare()
+	{
+		storage.prepare();
+		count = 0;
+	}
+
+	template<class Scanline>
+	void render(const Scanline& scanline)
+	{
+		storage.render(scanline);
+		count++;
+	}
+
+	scanline_storage_type&	storage;
+	int32					count;
+};
+
+
+/*!	Renders the scanlines of a rasterized path from a scanline storage with
+	a solid color. Every tile uses its own renderer, but passes exactly the
+	same spans to the pixel format as rendering the path directly would.
+*/
+class ScanlineStorageJob : public TileJob {
+public:
+	ScanlineStorageJob(const PainterAggInterface& aggInterface,
+			const scanline_storage_type& storage, int32 scanlineCount)
+		:
+		fAggInterface(aggInterface),
+		fStorage(storage),
+		fScanlineCount(scanlineCount)
+	{
+	}
+
+	virtual void RenderTile(int32 top, int32 bottom)
+	{
+		pixfmt pixelFormat(fAggInterface.fPixelFormat);
+		renderer_base baseRenderer(pixelFormat);
+		baseRenderer.attach_band(fAggInterface.fBaseRenderer, top, bottom);
+
+		renderer_type renderer(baseRenderer);
+		renderer.color(fAggInterface.fRenderer.color());
+
+		// the scanlines are sorted by y, find the first one in the tile
+		int32 lower = 0;
+		int32 upper = fScanlineCount;
+		while (lower < upper) {
+			int32 middle = (lower + upper) / 2;
+			if (fStorage.scanline_by_index(middle).y < top)
+				lower = middle + 1;
+			else
+				upper = middle;
+		}
+
+		scanline_storage_type::embedded_scanline scanline(fStorage);
+		for (int32 i = lower; i < fScanlineCount; i++) {
+			scanline.init(i);
+			if (scanline.y() > bottom)
+				break;
+
+			renderer.render(scanline);
+		}
+	}
+
+private:
+	const PainterAggInterface&		fAggInterface;
+	const scanline_storage_type&	fStorage;
+	int32							fScanlineCount;
+};
+
+
 // Shortcuts for accessing internal data
 #define fBuffer					fInternal.fBuffer
 #define fPixelFormat			fInternal.fPixelFormat
@@ -107,9 +337,21 @@ using std::nothrow;
 #define fCurve					fInternal.fCurve
 
 
-static uint32 detect_simd();
+static uint32 init_simd();
 
-uint32 gSIMDFlags = detect_simd();
+uint32 gSIMDFlags = init_simd();
+
+
+#if defined(__INTEL__) || defined(__x86_64__)
+static inline uint64
+read_xcr0()
+{
+	uint32 low;
+	uint32 high;
+	asm volatile("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+	return ((uint64)high << 32) | low;
+}
+#endif
 
 
 /*!	Detect SIMD flags for use in AppServer. Checks all CPUs in the system
@@ -118,7 +360,7 @@ uint32 gSIMDFlags = detect_simd();
 static uint32
 detect_simd()
 {
-#if __INTEL__
+#if defined(__INTEL__) || defined(__x86_64__)
 	// Only scan CPUs for which we are certain the SIMD flags are properly
 	// defined.
 	const char* vendorNames[] = {
@@ -158,11 +400,22 @@ detect_simd()
 		uint32 maxStdFunc = cpuInfo.regs.eax;
 		if (vendorFound && maxStdFunc >= 1) {
 			get_cpuid(&cpuInfo, 1, 0);
+			uint32 ecx = cpuInfo.regs.ecx;
 			uint32 edx = cpuInfo.regs.edx;
 			if (edx & (1 << 23))
 				cpuSIMD |= APPSERVER_SIMD_MMX;
 			if (edx & (1 << 25))
 				cpuSIMD |= APPSERVER_SIMD_SSE;
+			if (edx & (1 << 26))
+				cpuSIMD |= APPSERVER_SIMD_SSE2;
+
+			// AVX2 also needs the OS to save the YMM registers
+			if (maxStdFunc >= 7 && (ecx & (1 << 27)) != 0
+				&& (ecx & (1 << 28)) != 0 && (read_xcr0() & 0x6) == 0x6) {
+				get_cpuid(&cpuInfo, 7, 0);
+				if (cpuInfo.regs.ebx & (1 << 5))
+					cpuSIMD |= APPSERVER_SIMD_AVX2;
+			}
 		} else {
 			// no flags can be identified
 			cpuSIMD = 0;
@@ -170,12 +423,25 @@ detect_simd()
 		systemSIMD &= cpuSIMD;
 	}
 	return systemSIMD;
-#else	// !__INTEL__
+#else
 	return 0;
 #endif
 }
 
 
+/*!	Detects the SIMD flags, and selects the drawing kernels that make use of
+	them, once when the app_server starts.
+*/
+static uint32
+init_simd()
+{
+	uint32 flags = detect_simd();
+	gDrawingModeKernels = drawing_mode_kernels_for(flags);
+	gBitmapScaleKernels = bitmap_scale_kernels_for(flags);
+	return flags;
+}
+
+
 // #pragma mark -
 
 
@@ -186,6 +452,7 @@ Painter::Painter()
 	fValidClipping(false),
 	fDrawingText(false),
 	fAttached(false),
+	fParallelRendering(false),
 
 	fPenSize(1.0),
 	fClippingRegion(NULL),
@@ -197,9 +464,9 @@ Painter::Painter()
 	fMiterLimit(B_DEFAULT_MITER_LIMIT),
 
 	fPatternHandler(),
-	fTextRenderer(fSubpixRenderer, fRenderer, fRendererBin, fUnpackedScanline,
-		fSubpixUnpackedScanline, fSubpixRasterizer, fMaskedUnpackedScanline,
-		fTransform)
+	fTextRenderer(fBaseRenderer, fSubpixRenderer, fRenderer, fRendererBin,
+		fUnpackedScanline, fSubpixUnpackedScanline, fSubpixRasterizer,
+		fMaskedUnpackedScanline, fTransform)
 {
 	fPixelFormat.SetDrawingMode(fDrawingMode, fAlphaSrcMode, fAlphaFncMode,
 		false);
@@ -974,12 +1241,11 @@ Painter::FillRect(const BRect& r, const rgb_color& c) const
 	if (!fValidClipping)
 		return;
 
-	uint8* dst = fBuffer.row_ptr(0);
-	uint32 bpr = fBuffer.stride();
-	int32 left = (int32)r.left;
-	int32 top = (int32)r.top;
-	int32 right = (int32)r.right;
-	int32 bottom = (int32)r.bottom;
+	clipping_rect rect;
+	rect.left = (int32)r.left;
+	rect.top = (int32)r.top;
+	rect.right = (int32)r.right;
+	rect.bottom = (int32)r.bottom;
 	// get a 32 bit pixel ready with the color
 	pixel32 color;
 	color.data8[0] = c.blue;
@@ -987,23 +1253,8 @@ Painter::FillRect(const BRect& r, const rgb_color& c) const
 	color.data8[2] = c.red;
 	color.data8[3] = c.alpha;
 	// fill rects, iterate over clipping boxes
-	fBaseRenderer.first_clip_box();
-	do {
-		int32 x1 = max_c(fBaseRenderer.xmin(), left);
-		int32 x2 = min_c(fBaseRenderer.xmax(), right);
-		if (x1 <= x2) {
-			int32 y1 = max_c(fBaseRenderer.ymin(), top);
-			int32 y2 = min_c(fBaseRenderer.ymax(), bottom);
-			uint8* offset = dst + x1 * 4;
-			for (; y1 <= y2; y1++) {
-//					uint32* handle = (uint32*)(offset + y1 * bpr);
-//					for (int32 x = x1; x <= x2; x++) {
-//						*handle++ = color.data32;
-//					}
-				gfxset32(offset + y1 * bpr, color.data32, (x2 - x1 + 1) * 4);
-			}
-		}
-	} while (fBaseRenderer.next_clip_box());
+	SolidRectJob job(fInternal, fClippingRegion, rect, color.data32);
+	_RenderTiles(job, rect);
 }
 
 
@@ -1032,31 +1283,15 @@ Painter::FillRectVerticalGradient(BRect r,
 	_MakeGradient(gradient, colorCount, gradientArray,
 		gradientTop - (int32)r.top, gradientArraySize);
 
-	uint8* dst = fBuffer.row_ptr(0);
-	uint32 bpr = fBuffer.stride();
-	int32 left = (int32)r.left;
-	int32 top = (int32)r.top;
-	int32 right = (int32)r.right;
-	int32 bottom = (int32)r.bottom;
+	clipping_rect rect;
+	rect.left = (int32)r.left;
+	rect.top = (int32)r.top;
+	rect.right = (int32)r.right;
+	rect.bottom = (int32)r.bottom;
 	// fill rects, iterate over clipping boxes
-	fBaseRenderer.first_clip_box();
-	do {
-		int32 x1 = max_c(fBaseRenderer.xmin(), left);
-		int32 x2 = min_c(fBaseRenderer.xmax(), right);
-		if (x1 <= x2) {
-			int32 y1 = max_c(fBaseRenderer.ymin(), top);
-			int32 y2 = min_c(fBaseRenderer.ymax(), bottom);
-			uint8* offset = dst + x1 * 4;
-			for (; y1 <= y2; y1++) {
-//					uint32* handle = (uint32*)(offset + y1 * bpr);
-//					for (int32 x = x1; x <= x2; x++) {
-//						*handle++ = gradientArray[y1 - top];
-//					}
-				gfxset32(offset + y1 * bpr, gradientArray[y1 - top],
-					(x2 - x1 + 1) * 4);
-			}
-		}
-	} while (fBaseRenderer.next_clip_box());
+	VerticalGradientRectJob job(fInternal, fClippingRegion, rect,
+		gradientArray);
+	_RenderTiles(job, rect);
 }
 
 
@@ -1502,6 +1737,24 @@ Painter::SetRendererOffset(int32 offsetX, int32 offsetY)
 }
 
 
+void
+Painter::GetRendererOffset(int32* offsetX, int32* offsetY) const
+{
+	*offsetX = fBaseRenderer.offset_x();
+	*offsetY = fBaseRenderer.offset_y();
+}
+
+
+/*!	Enables rendering large drawing operations in tiles on several threads.
+	The results are identical to rendering them on a single thread.
+*/
+void
+Painter::SetParallelRendering(bool enabled)
+{
+	fParallelRendering = enabled;
+}
+
+
 // #pragma mark - private
 
 
@@ -1720,31 +1973,82 @@ Painter::_BlendRect32(const BRect& r, const rgb_color& c) const
 	if (!fValidClipping)
 		return;
 
-	uint8* dst = fBuffer.row_ptr(0);
-	uint32 bpr = fBuffer.stride();
-
-	int32 left = (int32)r.left;
-	int32 top = (int32)r.top;
-	int32 right = (int32)r.right;
-	int32 bottom = (int32)r.bottom;
+	clipping_rect rect;
+	rect.left = (int32)r.left;
+	rect.top = (int32)r.top;
+	rect.right = (int32)r.right;
+	rect.bottom = (int32)r.bottom;
 
 	// fill rects, iterate over clipping boxes
-	fBaseRenderer.first_clip_box();
-	do {
-		int32 x1 = max_c(fBaseRenderer.xmin(), left);
-		int32 x2 = min_c(fBaseRenderer.xmax(), right);
-		if (x1 <= x2) {
-			int32 y1 = max_c(fBaseRenderer.ymin(), top);
-			int32 y2 = min_c(fBaseRenderer.ymax(), bottom);
-
-			uint8* offset = dst + x1 * 4 + y1 * bpr;
-			for (; y1 <= y2; y1++) {
-				blend_line32(offset, x2 - x1 + 1, c.red, c.green, c.blue,
-					c.alpha);
-				offset += bpr;
-			}
-		}
-	} while (fBaseRenderer.next_clip_box());
+	BlendRectJob job(fInternal, fClippingRegion, rect, c);
+	_RenderTiles(job, rect);
+}
+
+
+/*!	Renders \a job within \a bounds and the clipping region, split into
+	tiles that are rendered concurrently, if parallel rendering is enabled
+	and the area is large enough to make this worthwhile.
+*/
+void
+Painter::_RenderTiles(TileJob& job, clipping_rect bounds) const
+{
+	clipping_rect frame = fClippingRegion->FrameInt();
+	bounds.left = max_c(bounds.left, frame.left);
+	bounds.top = max_c(bounds.top, frame.top);
+	bounds.right = min_c(bounds.right, frame.right);
+	bounds.bottom = min_c(bounds.bottom, frame.bottom);
+	if (bounds.left > bounds.right || bounds.top > bounds.bottom)
+		return;
+
+	if (fParallelRendering
+		&& (int64)(bounds.right - bounds.left + 1)
+			* (bounds.bottom - bounds.top + 1) >= kMinParallelArea) {
+		TileWorkerPool* pool = TileWorkerPool::Default();
+		if (pool != NULL && pool->Render(job, bounds.top, bounds.bottom))
+			return;
+	}
+
+	job.RenderTile(bounds.top, bounds.bottom);
+}
+
+
+/*!	If parallel rendering is enabled, and the path that has been added to
+	\a rasterizer covers a large area, the scanlines are first rasterized
+	into a storage, and then rendered in tiles.
+	Returns \c false if the path has not been rendered.
+*/
+bool
+Painter::_RenderScanlinesInTiles(rasterizer_type& rasterizer) const
+{
+	if (!fParallelRendering || TileWorkerPool::Default() == NULL)
+		return false;
+
+	clipping_rect frame = fClippingRegion->FrameInt();
+	int32 left = max_c(rasterizer.min_x(), frame.left);
+	int32 top = max_c(rasterizer.min_y(), frame.top);
+	int32 right = min_c(rasterizer.max_x(), frame.right);
+	int32 bottom = min_c(rasterizer.max_y(), frame.bottom);
+	if (left > right || top > bottom
+		|| (int64)(right - left + 1) * (bottom - top + 1)
+			< kMinParallelArea) {
+		return false;
+	}
+
+	ScanlineStorageCounter counter(fInternal.fScanlineStorage);
+	agg::render_scanlines(rasterizer, fPackedScanline, counter);
+	if (counter.count == 0)
+		return true;
+
+	clipping_rect bounds;
+	bounds.left = fInternal.fScanlineStorage.min_x();
+	bounds.top = fInternal.fScanlineStorage.min_y();
+	bounds.right = fInternal.fScanlineStorage.max_x();
+	bounds.bottom = fInternal.fScanlineStorage.max_y();
+
+	ScanlineStorageJob job(fInternal, fInternal.fScanlineStorage,
+		counter.count);
+	_RenderTiles(job, bounds);
+	return true;
 }
 
 
@@ -1862,7 +2166,8 @@ Painter::_RasterizePath(VertexSource& path) const
 	} else {
 		fRasterizer.reset();
 		fRasterizer.add_path(path);
-		agg::render_scanlines(fRasterizer, fPackedScanline, fRenderer);
+		if (!_RenderScanlinesInTiles(fRasterizer))
+			agg::render_scanlines(fRasterizer, fPackedScanline, fRenderer);
 	}
 
 	return _Clipped(_BoundingBox(path));
@@ -13,6 +13,7 @@
 
 
 #include "AGGTextRenderer.h"
+#include "DrawingModeKernels.h"
 #include "FontManager.h"
 #include "PainterAggInterface.h"
 #include "PatternHandler.h"
@@ -41,11 +42,7 @@ class FontCacheReference;
 class RenderingBuffer;
 class ServerBitmap;
 class ServerFont;
-
-
-// Defines for SIMD support.
-#define APPSERVER_SIMD_MMX	(1 << 0)
-#define APPSERVER_SIMD_SSE	(1 << 1)
+class TileJob;
 
 
 class Painter {
@@ -253,6 +250,14 @@ public:
 
 			void				SetRendererOffset(int32 offsetX,
 									int32 offsetY);
+			void				GetRendererOffset(int32* offsetX,
+									int32* offsetY) const;
+
+								// renders large operations on several
+								// threads, with identical results
+			void				SetParallelRendering(bool enabled);
+	inline	bool				ParallelRendering() const
+									{ return fParallelRendering; }
 
 private:
 			float				_Align(float coord, bool round,
@@ -284,6 +289,11 @@ private:
 			void				_BlendRect32(const BRect& r,
 									const rgb_color& c) const;
 
+			void				_RenderTiles(TileJob& job,
+									clipping_rect bounds) const;
+			bool				_RenderScanlinesInTiles(
+									rasterizer_type& rasterizer) const;
+
 
 			template<class VertexSource>
 			BRect				_BoundingBox(VertexSource& path) const;
@@ -341,6 +351,7 @@ private:
 			bool				fDrawingText : 1;
 			bool				fAttached : 1;
 			bool				fIdentityTransform : 1;
+			bool				fParallelRendering : 1;
 
 			Transformable		fTransform;
 			float				fPenSize;
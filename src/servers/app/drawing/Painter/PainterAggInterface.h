@@ -24,6 +24,7 @@ struct PainterAggInterface {
 		fRasterizer(),
 		fRenderer(fBaseRenderer),
 		fRendererBin(fBaseRenderer),
+		fScanlineStorage(),
 		fSubpixPackedScanline(),
 		fSubpixUnpackedScanline(),
 		fSubpixRasterizer(),
@@ -50,6 +51,9 @@ struct PainterAggInterface {
 	// Fast mode: no antialiasing needed (horizontal/vertical lines, ...)
 	renderer_bin_type		fRendererBin;
 
+	// Parallel mode: the rasterized scanlines, to be rendered in tiles
+	scanline_storage_type	fScanlineStorage;
+
 	// Subpixel mode
 	scanline_packed_subpix_type fSubpixPackedScanline;
 	scanline_unpacked_subpix_type fSubpixUnpackedScanline;
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	A small pool of threads that render the tiles of a drawing operation
+	concurrently. The tiles are bands of rows spanning the whole width, since
+	everything the Painter draws is made of horizontal spans anyway.
+
+	The pool is shared by all Painters; only one of them can use it at a time.
+	While it is busy, the others just render on their own thread, as the
+	CPUs are already occupied in this case.
+*/
+
+
+#include "TileWorkerPool.h"
+
+#include <new>
+#include <pthread.h>
+#include <stdio.h>
+
+
+static const int32 kTileHeight = 64;
+static const int32 kMaxWorkers = 15;
+
+
+TileWorkerPool* TileWorkerPool::sDefault = NULL;
+
+
+TileJob::~TileJob()
+{
+}
+
+
+// #pragma mark -
+
+
+TileWorkerPool::TileWorkerPool()
+	:
+	fThreads(NULL),
+	fWorkerCount(0),
+	fStartSemaphore(-1),
+	fDoneSemaphore(-1),
+	fBusy(0),
+	fJob(NULL),
+	fTop(0),
+	fBottom(-1),
+	fTileCount(0),
+	fNextTile(0),
+	fPendingWorkers(0)
+{
+}
+
+
+TileWorkerPool::~TileWorkerPool()
+{
+	// deleting the semaphore lets the workers quit
+	delete_sem(fStartSemaphore);
+	delete_sem(fDoneSemaphore);
+
+	for (int32 i = 0; i < fWorkerCount; i++) {
+		status_t result;
+		wait_for_thread(fThreads[i], &result);
+	}
+
+	delete[] fThreads;
+}
+
+
+/*!	Returns the pool shared by all Painters, or \c NULL if there is only a
+	single CPU.
+*/
+/*static*/ TileWorkerPool*
+TileWorkerPool::Default()
+{
+	static pthread_once_t sOnce = PTHREAD_ONCE_INIT;
+	pthread_once(&sOnce, &_CreateDefault);
+
+	return sDefault;
+}
+
+
+/*!	Renders the rows \a top to \a bottom of \a job, split into tiles, on the
+	workers and the calling thread. Returns \c false without rendering
+	anything if the pool is in use, or if there is only a single tile; the
+	caller is then supposed to render the job itself.
+*/
+bool
+TileWorkerPool::Render(TileJob& job, int32 top, int32 bottom)
+{
+	int32 tileCount = (bottom - top) / kTileHeight + 1;
+	if (tileCount < 2)
+		return false;
+
+	if (atomic_test_and_set(&fBusy, 1, 0) != 0)
+		return false;
+
+	fJob = &job;
+	fTop = top;
+	fBottom = bottom;
+	fTileCount = tileCount;
+	fNextTile = 0;
+
+	int32 workerCount = min_c(fWorkerCount, tileCount - 1);
+	fPendingWorkers = workerCount;
+
+	release_sem_etc(fStartSemaphore, workerCount, 0);
+
+	_RenderTiles();
+
+	while (acquire_sem(fDoneSemaphore) == B_INTERRUPTED)
+		;
+
+	fJob = NULL;
+	atomic_set(&fBusy, 0);
+	return true;
+}
+
+
+status_t
+TileWorkerPool::_Init(int32 workerCount)
+{
+	fThreads = new(std::nothrow) thread_id[workerCount];
+	if (fThreads == NULL)
+		return B_NO_MEMORY;
+
+	fStartSemaphore = create_sem(0, "tile workers start");
+	if (fStartSemaphore < 0)
+		return fStartSemaphore;
+
+	fDoneSemaphore = create_sem(0, "tile workers done");
+	if (fDoneSemaphore < 0)
+		return fDoneSemaphore;
+
+	for (int32 i = 0; i < workerCount; i++) {
+		char name[B_OS_NAME_LENGTH];
+		snprintf(name, sizeof(name), "tile worker %" B_PRId32, i);
+
+		thread_id thread = spawn_thread(&_WorkerThread, name,
+			B_DISPLAY_PRIORITY, this);
+		if (thread < 0)
+			return thread;
+
+		fThreads[fWorkerCount++] = thread;
+		resume_thread(thread);
+	}
+
+	return B_OK;
+}
+
+
+void
+TileWorkerPool::_RenderTiles()
+{
+	while (true) {
+		int32 tile = atomic_add(&fNextTile, 1);
+		if (tile >= fTileCount)
+			break;
+
+		int32 top = fTop + tile * kTileHeight;
+		int32 bottom = min_c(top + kTileHeight - 1, fBottom);
+		fJob->RenderTile(top, bottom);
+	}
+}
+
+
+/*static*/ void
+TileWorkerPool::_CreateDefault()
+{
+	system_info info;
+	if (get_system_info(&info) != B_OK || info.cpu_count < 2)
+		return;
+
+	TileWorkerPool* pool = new(std::nothrow) TileWorkerPool;
+	if (pool == NULL)
+		return;
+
+	// the calling thread renders tiles, too
+	if (pool->_Init(min_c((int32)info.cpu_count - 1, kMaxWorkers)) != B_OK) {
+		delete pool;
+		return;
+	}
+
+	sDefault = pool;
+}
+
+
+/*static*/ status_t
+TileWorkerPool::_WorkerThread(void* data)
+{
+	TileWorkerPool* pool = (TileWorkerPool*)data;
+
+	while (true) {
+		status_t status = acquire_sem(pool->fStartSemaphore);
+		if (status == B_INTERRUPTED)
+			continue;
+		if (status != B_OK)
+			break;
+
+		pool->_RenderTiles();
+
+		if (atomic_add(&pool->fPendingWorkers, -1) == 1)
+			release_sem(pool->fDoneSemaphore);
+	}
+
+	return B_OK;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TILE_WORKER_POOL_H
+#define TILE_WORKER_POOL_H
+
+
+#include <OS.h>
+
+
+class TileJob {
+public:
+	virtual						~TileJob();
+
+	// Renders the rows top to bottom (inclusive). Must not touch any pixels
+	// outside of them, since the other tiles are rendered concurrently.
+	virtual	void				RenderTile(int32 top, int32 bottom) = 0;
+};
+
+
+class TileWorkerPool {
+public:
+	static	TileWorkerPool*		Default();
+
+			int32				CountWorkers() const
+									{ return fWorkerCount; }
+
+			bool				Render(TileJob& job, int32 top,
+									int32 bottom);
+
+private:
+								TileWorkerPool();
+								~TileWorkerPool();
+
+			status_t			_Init(int32 workerCount);
+			void				_RenderTiles();
+
+	static	void				_CreateDefault();
+	static	status_t			_WorkerThread(void* data);
+
+private:
+			thread_id*			fThreads;
+			int32				fWorkerCount;
+			sem_id				fStartSemaphore;
+			sem_id				fDoneSemaphore;
+
+			int32				fBusy;
+			TileJob*			fJob;
+			int32				fTop;
+			int32				fBottom;
+			int32				fTileCount;
+			int32				fNextTile;
+			int32				fPendingWorkers;
+
+	static	TileWorkerPool*		sDefault;
+};
+
+
+#endif	// TILE_WORKER_POOL_H
@@ -15,6 +15,8 @@
 #ifndef AGG_RENDERER_REGION_INCLUDED
 #define AGG_RENDERER_REGION_INCLUDED
 
+#include <limits.h>
+
 #include <Region.h>
 
 #include "agg_basics.h"
@@ -39,7 +41,9 @@ namespace agg
 			m_curr_cb(0),
 			m_bounds(m_ren.xmin(), m_ren.ymin(), m_ren.xmax(), m_ren.ymax()),
 			m_offset_x(0),
-			m_offset_y(0)
+			m_offset_y(0),
+			m_band_y1(INT_MIN),
+			m_band_y2(INT_MAX)
 		{
 		}
 
@@ -73,35 +77,28 @@ namespace agg
 		void first_clip_box()
 		{
 			m_curr_cb = 0;
-			if(m_region && m_region->CountRects() > 0)
-			{
-				clipping_rect cb = m_region->RectAtInt(0);
-				translate_to_base_ren(cb);
-				m_ren.clip_box_naked(
-					cb.left,
-					cb.top,
-					cb.right,
-					cb.bottom);
-			}
-			else
+			if(!find_clip_box(0))
 				m_ren.clip_box_naked(0, 0, -1, -1);
 		}
 
 		//--------------------------------------------------------------------
 		bool next_clip_box()
 		{
-			if(m_region && (int)(++m_curr_cb) < m_region->CountRects())
-			{
-				clipping_rect cb = m_region->RectAtInt(m_curr_cb);
-				translate_to_base_ren(cb);
-				m_ren.clip_box_naked(
-					cb.left,
-					cb.top,
-					cb.right,
-					cb.bottom);
-				return true;
-			}
-			return false;
+			return find_clip_box(m_curr_cb + 1);
+		}
+
+		//--------------------------------------------------------------------
+		// Takes over the clipping region and offset of another renderer,
+		// but restricts drawing to the rows y1 to y2 (inclusive). This
+		// allows rendering different bands of the region concurrently, each
+		// with its own renderer.
+		void attach_band(const renderer_region<PixelFormat>& other,
+			int y1, int y2)
+		{
+			set_clipping_region(other.m_region);
+			set_offset(other.m_offset_x, other.m_offset_y);
+			m_band_y1 = y1;
+			m_band_y2 = y2;
 		}
 
 		//--------------------------------------------------------------------
@@ -147,6 +144,9 @@ namespace agg
 			}
 		}
 
+		int offset_x() const { return m_offset_x; }
+		int offset_y() const { return m_offset_y; }
+
 		//--------------------------------------------------------------------
 		void translate_to_base_ren_x(int& x)
 		{
@@ -452,6 +452,40 @@ namespace agg
 		}
 
 	private:
+		//--------------------------------------------------------------------
+		bool find_clip_box(int index)
+		{
+			if(!m_region)
+				return false;
+
+			int count = m_region->CountRects();
+			for(; index < count; index++)
+			{
+				clipping_rect cb = m_region->RectAtInt(index);
+				if(cb.top > m_band_y2)
+				{
+					// the rects are sorted from top to bottom
+					break;
+				}
+				if(cb.top < m_band_y1)
+					cb.top = m_band_y1;
+				if(cb.bottom > m_band_y2)
+					cb.bottom = m_band_y2;
+				if(cb.top > cb.bottom)
+					continue;
+
+				m_curr_cb = index;
+				translate_to_base_ren(cb);
+				m_ren.clip_box_naked(
+					cb.left,
+					cb.top,
+					cb.right,
+					cb.bottom);
+				return true;
+			}
+			return false;
+		}
+
 		renderer_region(const renderer_region<PixelFormat>&);
 		const renderer_region<PixelFormat>&
 			operator = (const renderer_region<PixelFormat>&);
@@ -463,6 +497,9 @@ namespace agg
 
 		int				   m_offset_x;
 		int				   m_offset_y;
+
+		int				   m_band_y1;
+		int				   m_band_y2;
 	};
 
 
@@ -20,6 +20,7 @@
 #include "drawing_support.h"
 #include "ServerBitmap.h"
 #include "SystemPalette.h"
+#include "TileWorkerPool.h"
 
 
 // #define TRACE_BITMAP_PAINTER
@@ -30,10 +31,46 @@
 #endif
 
 
+template<class BlendType>
+class DrawBitmapNoScaleJob : public TileJob {
+public:
+	DrawBitmapNoScaleJob(PainterAggInterface& aggInterface,
+			agg::rendering_buffer& bitmap, uint32 bytesPerSourcePixel,
+			IntPoint offset, const BRect& destinationRect)
+		:
+		fAggInterface(aggInterface),
+		fBitmap(bitmap),
+		fBytesPerSourcePixel(bytesPerSourcePixel),
+		fOffset(offset),
+		fDestinationRect(destinationRect)
+	{
+	}
+
+	virtual void RenderTile(int32 top, int32 bottom)
+	{
+		pixfmt pixelFormat(fAggInterface.fPixelFormat);
+		renderer_base baseRenderer(pixelFormat);
+		baseRenderer.attach_band(fAggInterface.fBaseRenderer, top, bottom);
+
+		BlendType drawNoScale;
+		drawNoScale.Draw(fAggInterface, baseRenderer, fBitmap,
+			fBytesPerSourcePixel, fOffset, fDestinationRect);
+	}
+
+private:
+	PainterAggInterface&	fAggInterface;
+	agg::rendering_buffer&	fBitmap;
+	uint32					fBytesPerSourcePixel;
+	IntPoint				fOffset;
+	BRect					fDestinationRect;
+};
+
+
 Painter::BitmapPainter::BitmapPainter(const Painter* painter,
 	const ServerBitmap* bitmap, uint32 options)
 	:
 	fPainter(painter),
+	fServerBitmap(bitmap),
 	fStatus(B_NO_INIT),
 	fOptions(options)
 {
@@ -82,22 +119,16 @@ Painter::BitmapPainter::Draw(const BRect& sourceRect,
 	if (!_HasScale() && !_HasAffineTransform() && !_HasAlphaMask()) {
 		if (fColorSpace == B_CMAP8) {
 			if (fPainter->fDrawingMode == B_OP_COPY) {
-				DrawBitmapNoScale<CMap8Copy> drawNoScale;
-				drawNoScale.Draw(fPainter->fInternal, fBitmap, 1, fOffset,
-					fDestinationRect);
+				_DrawNoScale<CMap8Copy>(1);
 				return;
 			}
 			if (fPainter->fDrawingMode == B_OP_OVER) {
-				DrawBitmapNoScale<CMap8Over> drawNoScale;
-				drawNoScale.Draw(fPainter->fInternal, fBitmap, 1, fOffset,
-					fDestinationRect);
+				_DrawNoScale<CMap8Over>(1);
 				return;
 			}
 		} else if (fColorSpace == B_RGB32) {
 			if (fPainter->fDrawingMode == B_OP_OVER) {
-				DrawBitmapNoScale<Bgr32Over> drawNoScale;
-				drawNoScale.Draw(fPainter->fInternal, fBitmap, 4, fOffset,
-					fDestinationRect);
+				_DrawNoScale<Bgr32Over>(4);
 				return;
 			}
 		}
@@ -106,30 +137,31 @@ Painter::BitmapPainter::Draw(const BRect& sourceRect,
 	ObjectDeleter<BBitmap> convertedBitmapDeleter;
 	_ConvertColorSpace(convertedBitmapDeleter);
 
+	// strong downscaling filters a box filtered mip level of the bitmap
+	BReference<ServerBitmap> mipLevel;
+	if ((fOptions & B_FILTER_BITMAP_BILINEAR) != 0
+		&& !_HasAffineTransform() && fBitmap.buf() == fServerBitmap->Bits()) {
+		_UseMipLevel(mipLevel);
+	}
+
 	// optimized version if there is no scale
 	if (!_HasScale() && !_HasAffineTransform() && !_HasAlphaMask()) {
 		if (fPainter->fDrawingMode == B_OP_COPY) {
-			DrawBitmapNoScale<Bgr32Copy> drawNoScale;
-			drawNoScale.Draw(fPainter->fInternal, fBitmap, 4, fOffset,
-				fDestinationRect);
+			_DrawNoScale<Bgr32Copy>(4);
 			return;
 		}
 		if (fPainter->fDrawingMode == B_OP_OVER
 			|| (fPainter->fDrawingMode == B_OP_ALPHA
 				 && fPainter->fAlphaSrcMode == B_PIXEL_ALPHA
 				 && fPainter->fAlphaFncMode == B_ALPHA_OVERLAY)) {
-			DrawBitmapNoScale<Bgr32Alpha> drawNoScale;
-			drawNoScale.Draw(fPainter->fInternal, fBitmap, 4, fOffset,
-				fDestinationRect);
+			_DrawNoScale<Bgr32Alpha>(4);
 			return;
 		}
 	}
 
 	if (!_HasScale() && !_HasAffineTransform() && _HasAlphaMask()) {
 		if (fPainter->fDrawingMode == B_OP_COPY) {
-			DrawBitmapNoScale<Bgr32CopyMasked> drawNoScale;
-			drawNoScale.Draw(fPainter->fInternal, fBitmap, 4, fOffset,
-				fDestinationRect);
+			_DrawNoScale<Bgr32CopyMasked>(4);
 			return;
 		}
 	}
@@ -212,6 +244,7 @@ Painter::BitmapPainter::_DetermineTransform(BRect sourceRect,
 		sourceRect.bottom = fBitmapBounds.bottom;
 	}
 
+	fSourceRect = sourceRect;
 	fOffset.x = fDestinationRect.left - sourceRect.left;
 	fOffset.y = fDestinationRect.top - sourceRect.top;
 
@@ -314,6 +347,73 @@ Painter::BitmapPainter::_ConvertColorSpace(
 }
 
 
+/*!	Switches to the mip level that is at most twice as large as the
+	destination, if the bitmap is scaled down to half its size or less.
+	Bilinear filtering only samples 2x2 source pixels per destination
+	pixel, and would alias otherwise.
+*/
+void
+Painter::BitmapPainter::_UseMipLevel(BReference<ServerBitmap>& mipLevel)
+{
+	double scale = max_c(fScaleX, fScaleY);
+	int32 level = 0;
+	while (scale <= 0.5 && (fServerBitmap->Width() >> (level + 1)) > 1
+		&& (fServerBitmap->Height() >> (level + 1)) > 1) {
+		scale *= 2;
+		level++;
+	}
+	if (level == 0)
+		return;
+
+	ServerBitmap* bitmap = fServerBitmap->AcquireMipLevel(level);
+	if (bitmap == NULL)
+		return;
+	mipLevel.SetTo(bitmap, true);
+
+	// transform the source rect into the mip level, its right and bottom
+	// edge have to be within the level, or the filter weights would
+	// address pixels outside of it
+	const float factor = 1 << level;
+	BRect levelBounds = bitmap->Bounds();
+	BRect sourceRect;
+	sourceRect.left = fSourceRect.left / factor;
+	sourceRect.top = fSourceRect.top / factor;
+	sourceRect.right = min_c((fSourceRect.right + 1) / factor - 1,
+		levelBounds.right);
+	sourceRect.bottom = min_c((fSourceRect.bottom + 1) / factor - 1,
+		levelBounds.bottom);
+	if (!sourceRect.IsValid())
+		return;
+
+	fScaleX = (fDestinationRect.Width() + 1) / (sourceRect.Width() + 1);
+	fScaleY = (fDestinationRect.Height() + 1) / (sourceRect.Height() + 1);
+	fOffset.x = fDestinationRect.left - sourceRect.left;
+	fOffset.y = fDestinationRect.top - sourceRect.top;
+	fSourceRect = sourceRect;
+
+	fBitmap.attach(bitmap->Bits(), bitmap->Width(), bitmap->Height(),
+		bitmap->BytesPerRow());
+}
+
+
+/*!	Draws the unscaled bitmap, in tiles if the painter renders in parallel.
+*/
+template<class BlendType>
+void
+Painter::BitmapPainter::_DrawNoScale(uint32 bytesPerSourcePixel)
+{
+	DrawBitmapNoScaleJob<BlendType> job(fPainter->fInternal, fBitmap,
+		bytesPerSourcePixel, fOffset, fDestinationRect);
+
+	clipping_rect bounds;
+	bounds.left = (int32)fDestinationRect.left;
+	bounds.top = (int32)fDestinationRect.top;
+	bounds.right = (int32)fDestinationRect.right;
+	bounds.bottom = (int32)fDestinationRect.bottom;
+	fPainter->_RenderTiles(job, bounds);
+}
+
+
 template<typename sourcePixel>
 void
 Painter::BitmapPainter::_TransparentMagicToAlpha(sourcePixel* buffer,
@@ -8,6 +8,7 @@
 #define BITMAP_PAINTER_H
 
 #include <AutoDeleter.h>
+#include <Referenceable.h>
 
 #include "Painter.h"
 
@@ -34,6 +35,11 @@ private:
 
 			void				_ConvertColorSpace(ObjectDeleter<BBitmap>&
 									convertedBitmapDeleter);
+			void				_UseMipLevel(
+									BReference<ServerBitmap>& mipLevel);
+
+			template<class BlendType>
+			void				_DrawNoScale(uint32 bytesPerSourcePixel);
 
 			template<typename sourcePixel>
 			void				_TransparentMagicToAlpha(sourcePixel *buffer,
@@ -44,12 +50,14 @@ private:
 
 private:
 			const Painter*			fPainter;
+			const ServerBitmap*		fServerBitmap;
 			status_t				fStatus;
 			agg::rendering_buffer	fBitmap;
 			BRect					fBitmapBounds;
 			color_space				fColorSpace;
 			uint32					fOptions;
 
+			BRect					fSourceRect;
 			BRect					fDestinationRect;
 			double					fScaleX;
 			double					fScaleY;
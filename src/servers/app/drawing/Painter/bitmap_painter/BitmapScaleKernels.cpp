@@ -0,0 +1,294 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * Row kernels for scaling B_RGBA32 bitmaps.
+ *
+ * The vector versions are written with the generic vector extensions of
+ * the compiler instead of instruction set specific intrinsics, so that they
+ * are compiled to SSE2 on x86 and x86_64, and to NEON on ARM. All
+ * intermediate results are exact in their lanes: a row interpolation
+ * (at most 255 * 255) fits 16 bits, the column interpolation on top of it
+ * is done in 32 bit lanes.
+ *
+ */
+
+#include "BitmapScaleKernels.h"
+
+#include <string.h>
+
+#include "DrawingModeKernels.h"
+
+
+using BitmapPainterPrivate::FilterInfo;
+
+
+#if defined(__GNUC__) && __GNUC__ >= 9
+#	define BITMAP_SCALE_VECTOR_KERNELS 1
+#	if defined(__i386__) || defined(__x86_64__)
+#		define VECTOR_FUNCTION __attribute__((target("sse2")))
+#	else
+#		define VECTOR_FUNCTION
+#	endif
+
+typedef uint8 v8u8 __attribute__((vector_size(8)));
+typedef uint8 v16u8 __attribute__((vector_size(16)));
+typedef uint16 v8u16 __attribute__((vector_size(16)));
+typedef uint16 v16u16 __attribute__((vector_size(32)));
+typedef uint32 v8u32 __attribute__((vector_size(32)));
+#endif
+
+
+// #pragma mark - scalar
+
+
+static inline void
+bilinear_interpolate(uint32* t, const uint8* s, uint32 sourceBytesPerRow,
+	uint16 wLeft, uint16 wTop)
+{
+	const uint16 wRight = 255 - wLeft;
+	const uint16 wBottom = 255 - wTop;
+	const uint8* b = s + sourceBytesPerRow;
+
+	for (int32 i = 0; i < 4; i++) {
+		t[i] = ((s[i] * wLeft + s[i + 4] * wRight) * wTop
+			+ (b[i] * wLeft + b[i + 4] * wRight) * wBottom) >> 16;
+	}
+}
+
+
+static void
+bilinear_row_copy_scalar(uint8* dest, const uint8* source,
+	uint32 sourceBytesPerRow, const FilterInfo* weightsX, int32 xMin,
+	int32 xMax, uint16 wTop)
+{
+	for (int32 x = xMin; x <= xMax; x++) {
+		uint32 t[4];
+		bilinear_interpolate(t, source + weightsX[x].index, sourceBytesPerRow,
+			weightsX[x].weight, wTop);
+
+		dest[0] = t[0];
+		dest[1] = t[1];
+		dest[2] = t[2];
+		dest += 4;
+	}
+}
+
+
+static void
+bilinear_row_alpha_overlay_scalar(uint8* dest, const uint8* source,
+	uint32 sourceBytesPerRow, const FilterInfo* weightsX, int32 xMin,
+	int32 xMax, uint16 wTop)
+{
+	for (int32 x = xMin; x <= xMax; x++) {
+		uint32 t[4];
+		bilinear_interpolate(t, source + weightsX[x].index, sourceBytesPerRow,
+			weightsX[x].weight, wTop);
+
+		if (t[3] == 255) {
+			dest[0] = t[0];
+			dest[1] = t[1];
+			dest[2] = t[2];
+		} else {
+			dest[0] = ((t[0] - dest[0]) * t[3] + (dest[0] << 8)) >> 8;
+			dest[1] = ((t[1] - dest[1]) * t[3] + (dest[1] << 8)) >> 8;
+			dest[2] = ((t[2] - dest[2]) * t[3] + (dest[2] << 8)) >> 8;
+		}
+		dest += 4;
+	}
+}
+
+
+static void
+box_downscale_row_scalar(uint8* dest, const uint8* source,
+	uint32 sourceBytesPerRow, uint32 count)
+{
+	for (; count > 0; count--) {
+		const uint8* below = source + sourceBytesPerRow;
+		for (int32 i = 0; i < 4; i++) {
+			dest[i] = (source[i] + source[i + 4] + below[i] + below[i + 4] + 2)
+				>> 2;
+		}
+		source += 8;
+		dest += 4;
+	}
+}
+
+
+static const bitmap_scale_kernels kScalarKernels = {
+	bilinear_row_copy_scalar,
+	bilinear_row_alpha_overlay_scalar,
+	box_downscale_row_scalar
+};
+
+
+#if BITMAP_SCALE_VECTOR_KERNELS
+
+
+// #pragma mark - vector
+
+
+// Interpolates the two destination pixels of "weights", the result is in
+// the 16 bit lanes, four per pixel.
+VECTOR_FUNCTION static inline v8u16
+bilinear_interpolate2_vector(const uint8* source, uint32 sourceBytesPerRow,
+	const FilterInfo* weights, uint16 wTop)
+{
+	const uint8* first = source + weights[0].index;
+	const uint8* second = source + weights[1].index;
+
+	v8u8 top0;
+	v8u8 top1;
+	v8u8 bottom0;
+	v8u8 bottom1;
+	memcpy(&top0, first, sizeof(top0));
+	memcpy(&top1, second, sizeof(top1));
+	memcpy(&bottom0, first + sourceBytesPerRow, sizeof(bottom0));
+	memcpy(&bottom1, second + sourceBytesPerRow, sizeof(bottom1));
+
+	const v8u8 left = { 0, 1, 2, 3, 8, 9, 10, 11 };
+	const v8u8 right = { 4, 5, 6, 7, 12, 13, 14, 15 };
+
+	const uint16 wLeft0 = weights[0].weight;
+	const uint16 wLeft1 = weights[1].weight;
+	const v8u16 wLeft = { wLeft0, wLeft0, wLeft0, wLeft0,
+		wLeft1, wLeft1, wLeft1, wLeft1 };
+	const v8u16 wRight = 255 - wLeft;
+
+	v8u16 top = __builtin_convertvector(__builtin_shuffle(top0, top1, left),
+			v8u16) * wLeft
+		+ __builtin_convertvector(__builtin_shuffle(top0, top1, right), v8u16)
+			* wRight;
+	v8u16 bottom = __builtin_convertvector(
+			__builtin_shuffle(bottom0, bottom1, left), v8u16) * wLeft
+		+ __builtin_convertvector(__builtin_shuffle(bottom0, bottom1, right),
+			v8u16) * wRight;
+
+	v8u32 sum = __builtin_convertvector(top, v8u32) * (uint32)wTop
+		+ __builtin_convertvector(bottom, v8u32) * (uint32)(255 - wTop);
+	return __builtin_convertvector(sum >> 16, v8u16);
+}
+
+
+// Stores the color of two pixels, keeping the alpha in "dest"
+VECTOR_FUNCTION static inline void
+store_color2_vector(uint8* dest, v8u16 color)
+{
+	const v8u8 alphaMask = { 0, 0, 0, 255, 0, 0, 0, 255 };
+
+	v8u8 pixels;
+	memcpy(&pixels, dest, sizeof(pixels));
+	pixels = (pixels & alphaMask)
+		| (__builtin_convertvector(color, v8u8) & ~alphaMask);
+	memcpy(dest, &pixels, sizeof(pixels));
+}
+
+
+VECTOR_FUNCTION static void
+bilinear_row_copy_vector(uint8* dest, const uint8* source,
+	uint32 sourceBytesPerRow, const FilterInfo* weightsX, int32 xMin,
+	int32 xMax, uint16 wTop)
+{
+	int32 x = xMin;
+	for (; x < xMax; x += 2, dest += 8) {
+		store_color2_vector(dest, bilinear_interpolate2_vector(source,
+			sourceBytesPerRow, weightsX + x, wTop));
+	}
+
+	bilinear_row_copy_scalar(dest, source, sourceBytesPerRow, weightsX, x,
+		xMax, wTop);
+}
+
+
+VECTOR_FUNCTION static void
+bilinear_row_alpha_overlay_vector(uint8* dest, const uint8* source,
+	uint32 sourceBytesPerRow, const FilterInfo* weightsX, int32 xMin,
+	int32 xMax, uint16 wTop)
+{
+	const v8u16 pixelAlpha = { 3, 3, 3, 3, 7, 7, 7, 7 };
+
+	int32 x = xMin;
+	for (; x < xMax; x += 2, dest += 8) {
+		v8u16 color = bilinear_interpolate2_vector(source, sourceBytesPerRow,
+			weightsX + x, wTop);
+
+		// an opaque color replaces the pixel, which is the same as blending
+		// with an alpha of 256
+		v8u16 alpha = __builtin_shuffle(color, pixelAlpha);
+		alpha += (v8u16)(alpha == 255) & 1;
+
+		v8u8 pixels;
+		memcpy(&pixels, dest, sizeof(pixels));
+		v8u16 destColor = __builtin_convertvector(pixels, v8u16);
+
+		store_color2_vector(dest,
+			(color * alpha + destColor * (256 - alpha)) >> 8);
+	}
+
+	bilinear_row_alpha_overlay_scalar(dest, source, sourceBytesPerRow,
+		weightsX, x, xMax, wTop);
+}
+
+
+VECTOR_FUNCTION static void
+box_downscale_row_vector(uint8* dest, const uint8* source,
+	uint32 sourceBytesPerRow, uint32 count)
+{
+	const v16u16 neighbor = { 4, 5, 6, 7, 0, 1, 2, 3,
+		12, 13, 14, 15, 8, 9, 10, 11 };
+	const v16u8 pack = { 0, 1, 2, 3, 8, 9, 10, 11,
+		0, 1, 2, 3, 8, 9, 10, 11 };
+
+	for (; count >= 2; count -= 2, source += 16, dest += 8) {
+		v16u8 top;
+		v16u8 bottom;
+		memcpy(&top, source, sizeof(top));
+		memcpy(&bottom, source + sourceBytesPerRow, sizeof(bottom));
+
+		v16u16 sum = __builtin_convertvector(top, v16u16)
+			+ __builtin_convertvector(bottom, v16u16);
+		sum += __builtin_shuffle(sum, neighbor);
+
+		v16u8 result = __builtin_shuffle(
+			__builtin_convertvector((sum + 2) >> 2, v16u8), pack);
+		memcpy(dest, &result, 8);
+	}
+
+	box_downscale_row_scalar(dest, source, sourceBytesPerRow, count);
+}
+
+
+static const bitmap_scale_kernels kVectorKernels = {
+	bilinear_row_copy_vector,
+	bilinear_row_alpha_overlay_vector,
+	box_downscale_row_vector
+};
+
+
+#endif	// BITMAP_SCALE_VECTOR_KERNELS
+
+
+// #pragma mark -
+
+
+const bitmap_scale_kernels* gBitmapScaleKernels = &kScalarKernels;
+
+
+/*!	Returns the fastest kernels that only use the instruction sets given in
+	\a simdFlags. On other architectures than x86, the vector kernels only
+	use the base instruction set.
+*/
+const bitmap_scale_kernels*
+bitmap_scale_kernels_for(uint32 simdFlags)
+{
+#if BITMAP_SCALE_VECTOR_KERNELS
+#	if defined(__i386__) || defined(__x86_64__)
+	if ((simdFlags & APPSERVER_SIMD_SSE2) != 0)
+		return &kVectorKernels;
+#	else
+	return &kVectorKernels;
+#	endif
+#endif
+
+	return &kScalarKernels;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * Row kernels for scaling B_RGBA32 bitmaps, in scalar and vector versions.
+ *
+ */
+#ifndef BITMAP_SCALE_KERNELS_H
+#define BITMAP_SCALE_KERNELS_H
+
+
+#include <SupportDefs.h>
+
+
+namespace BitmapPainterPrivate {
+
+
+struct FilterInfo {
+	uint16 index;	// index into source bitmap row/column
+	uint16 weight;	// weight of the pixel at index [0..255]
+};
+
+
+} // namespace BitmapPainterPrivate
+
+
+// The scalar versions are the reference; the vector versions have to produce
+// exactly the same pixels.
+struct bitmap_scale_kernels {
+	// Bilinear interpolation of the destination pixels xMin..xMax between
+	// the "source" row and the one below it, "wTop" being the weight of the
+	// upper row. The pixel indices in "weightsX" are byte offsets into the
+	// row. The color is copied, the destination alpha is left alone
+	// (B_OP_COPY).
+	void	(*bilinear_row_copy)(uint8* dest, const uint8* source,
+				uint32 sourceBytesPerRow,
+				const BitmapPainterPrivate::FilterInfo* weightsX, int32 xMin,
+				int32 xMax, uint16 wTop);
+
+	// As above, but the interpolated color is blended by its interpolated
+	// alpha (B_OP_ALPHA with B_PIXEL_ALPHA and B_ALPHA_OVERLAY)
+	void	(*bilinear_row_alpha_overlay)(uint8* dest, const uint8* source,
+				uint32 sourceBytesPerRow,
+				const BitmapPainterPrivate::FilterInfo* weightsX, int32 xMin,
+				int32 xMax, uint16 wTop);
+
+	// Averages each 2x2 block of the "source" row and the one below it into
+	// one of the "count" destination pixels, including alpha.
+	void	(*box_downscale_row)(uint8* dest, const uint8* source,
+				uint32 sourceBytesPerRow, uint32 count);
+};
+
+
+extern const bitmap_scale_kernels* gBitmapScaleKernels;
+
+const bitmap_scale_kernels* bitmap_scale_kernels_for(uint32 simdFlags);
+
+
+#endif // BITMAP_SCALE_KERNELS_H
@@ -12,6 +12,8 @@
 
 #include <typeinfo>
 
+#include "BitmapScaleKernels.h"
+
 
 // Prototypes for assembler routines
 extern "C" {
@@ -26,12 +28,6 @@ extern uint32 gSIMDFlags;
 namespace BitmapPainterPrivate {
 
 
-struct FilterInfo {
-	uint16 index;	// index into source bitmap row/column
-	uint16 weight;	// weight of the pixel at index [0..255]
-};
-
-
 struct FilterData {
 	FilterInfo* fWeightsX;
 	FilterInfo* fWeightsY;
@@ -478,6 +474,93 @@ struct BilinearSimd : DrawBitmapBilinearOptimized<BilinearSimd> {
 #endif	// __INTEL__
 
 
+template<class ColorType, class DrawMode>
+struct BilinearKernel :
+	DrawBitmapBilinearOptimized<BilinearKernel<ColorType, DrawMode> > {
+
+	typedef void (*RowKernel)(uint8* dest, const uint8* source,
+		uint32 sourceBytesPerRow, const FilterInfo* weightsX, int32 xMin,
+		int32 xMax, uint16 wTop);
+
+	BilinearKernel(RowKernel rowKernel)
+		:
+		fRowKernel(rowKernel)
+	{
+	}
+
+	void DrawToClipRect(int32 xIndexL, int32 xIndexR, int32 y1, int32 y2)
+	{
+		// The same as the default version, but the rows are processed by
+		// the (vectorized) kernels from gBitmapScaleKernels.
+
+		// The last column/row handling does not need to be performed
+		// for all clipping rects!
+		int32 yMax = y2;
+		if (this->fWeightsY[yMax].weight == 255)
+			yMax--;
+		int32 xIndexMax = xIndexR;
+		if (this->fWeightsX[xIndexMax].weight == 255)
+			xIndexMax--;
+
+		for (; y1 <= yMax; y1++) {
+			// cache the weight of the top and bottom row
+			const uint16 wTop = this->fWeightsY[y1].weight;
+			const uint16 wBottom = 255 - this->fWeightsY[y1].weight;
+
+			// buffer offset into source (top row)
+			const uint8* src = this->fSource->row_ptr(
+				this->fWeightsY[y1].index);
+			// buffer handle for destination to be incremented per
+			// pixel
+			uint8* d = this->fDestination;
+			fRowKernel(d, src, this->fSourceBytesPerRow, this->fWeightsX,
+				xIndexL, xIndexMax, wTop);
+			// increase pointer by processed pixels
+			d += (xIndexMax - xIndexL + 1) * 4;
+
+			// last column of pixels if necessary
+			if (xIndexMax < xIndexR) {
+				const uint8* s = src + this->fWeightsX[xIndexR].index;
+				const uint8* sBottom = s + this->fSourceBytesPerRow;
+
+				uint32 t[4];
+				ColorType::InterpolateLastColumn(&t[0], s, sBottom, wTop,
+					wBottom);
+				DrawMode::Blend(d, &t[0]);
+			}
+
+			this->fDestination += this->fDestinationBytesPerRow;
+		}
+
+		// last row of pixels if necessary
+		// buffer offset into source (bottom row)
+		const uint8* src = this->fSource->row_ptr(this->fWeightsY[y2].index);
+		// buffer handle for destination to be incremented per pixel
+		uint8* d = this->fDestination;
+
+		if (yMax < y2) {
+			for (int32 x = xIndexL; x <= xIndexMax; x++) {
+				const uint8* s = src + this->fWeightsX[x].index;
+				const uint16 wLeft = this->fWeightsX[x].weight;
+				const uint16 wRight = 255 - wLeft;
+				uint32 t[4];
+				ColorType::InterpolateLastRow(&t[0], s, wLeft, wRight);
+				DrawMode::Blend(d, &t[0]);
+			}
+		}
+
+		// pixel in bottom right corner if necessary
+		if (yMax < y2 && xIndexMax < xIndexR) {
+			const uint8* s = src + this->fWeightsX[xIndexR].index;
+			*(uint32*)d = *(uint32*)s;
+		}
+	}
+
+private:
+	RowKernel	fRowKernel;
+};
+
+
 template<class ColorType, class DrawMode>
 struct DrawBitmapBilinear {
 	void
@@ -591,22 +674,37 @@ struct DrawBitmapBilinear {
 		enum {
 			kOptimizeForLowFilterRatio = 0,
 			kUseDefaultVersion,
-			kUseSIMDVersion
+			kUseSIMDVersion,
+			kUseVectorVersion
 		};
 
 		int codeSelect = kUseDefaultVersion;
 
+		// The vector kernels are preferred whenever the CPU supports them,
+		// the scalar kernels would not be faster than the default version.
+		const bool useVectorKernels = srcWidth > 1 && srcHeight > 1
+			&& gBitmapScaleKernels != bitmap_scale_kernels_for(0);
+
 		if (typeid(ColorType) == typeid(ColorTypeRgb)
 			&& typeid(DrawMode) == typeid(DrawModeCopy)) {
-			uint32 neededSIMDFlags = APPSERVER_SIMD_MMX | APPSERVER_SIMD_SSE;
-			if ((gSIMDFlags & neededSIMDFlags) == neededSIMDFlags)
+			const uint32 neededSIMDFlags
+				= APPSERVER_SIMD_MMX | APPSERVER_SIMD_SSE;
+			if (useVectorKernels)
+				codeSelect = kUseVectorVersion;
+			else if ((gSIMDFlags & neededSIMDFlags) == neededSIMDFlags) {
+#ifdef __INTEL__
 				codeSelect = kUseSIMDVersion;
-			else {
+#endif
+			} else {
 				if (scaleX == scaleY && (scaleX == 1.5 || scaleX == 2.0
 					|| scaleX == 2.5 || scaleX == 3.0)) {
 					codeSelect = kOptimizeForLowFilterRatio;
 				}
 			}
+		} else if (typeid(ColorType) == typeid(ColorTypeRgba)
+			&& typeid(DrawMode) == typeid(DrawModeAlphaOverlay)
+			&& useVectorKernels) {
+			codeSelect = kUseVectorVersion;
 		}
 
 		switch (codeSelect) {
@@ -635,6 +733,17 @@ struct DrawBitmapBilinear {
 				break;
 			}
 #endif	// __INTEL__
+
+			case kUseVectorVersion:
+			{
+				BilinearKernel<ColorType, DrawMode> bilinearPainter(
+					typeid(DrawMode) == typeid(DrawModeCopy)
+						? gBitmapScaleKernels->bilinear_row_copy
+						: gBitmapScaleKernels->bilinear_row_alpha_overlay);
+				bilinearPainter.Draw(aggInterface, destinationRect, &bitmap,
+					filterData);
+				break;
+			}
 		}
 
 #ifdef FILTER_INFOS_ON_HEAP
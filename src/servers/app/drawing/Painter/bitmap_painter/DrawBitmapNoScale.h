@@ -18,14 +18,19 @@ template<class BlendType>
 struct DrawBitmapNoScale {
 public:
 	void
-	Draw(PainterAggInterface& aggInterface, agg::rendering_buffer& bitmap,
-		uint32 bytesPerSourcePixel, IntPoint offset, BRect destinationRect)
+	Draw(PainterAggInterface& aggInterface, renderer_base& baseRenderer,
+		agg::rendering_buffer& bitmap, uint32 bytesPerSourcePixel,
+		IntPoint offset, BRect destinationRect)
 	{
 		// NOTE: this would crash if destinationRect was large enough to read
 		// outside the bitmap, so make sure this is not the case before calling
 		// this function!
 		uint8* dst = aggInterface.fBuffer.row_ptr(0);
 		const uint32 dstBPR = aggInterface.fBuffer.stride();
+		// the clipping boxes are in the coordinate space of the renderer,
+		// the buffer may be offset from it
+		const int32 dstOffsetX = baseRenderer.offset_x();
+		const int32 dstOffsetY = baseRenderer.offset_y();
 
 		const uint8* src = bitmap.row_ptr(0);
 		const uint32 srcBPR = bitmap.stride();
@@ -54,7 +59,6 @@ public:
 
 		fColorMap = SystemPalette();
 		fAlphaMask = aggInterface.fClippedAlphaMask;
-		renderer_base& baseRenderer = aggInterface.fBaseRenderer;
 
 		// copy rects, iterate over clipping boxes
 		baseRenderer.first_clip_box();
@@ -65,8 +69,9 @@ public:
 				fRect.top    = max_c(baseRenderer.ymin(), top);
 				fRect.bottom = min_c(baseRenderer.ymax(), bottom);
 				if (fRect.top <= fRect.bottom) {
-					uint8* dstHandle = dst + fRect.top * dstBPR
-						+ fRect.left * 4;
+					uint8* dstHandle = dst
+						+ (fRect.top - dstOffsetY) * dstBPR
+						+ (fRect.left - dstOffsetX) * 4;
 					const uint8* srcHandle = src
 						+ (fRect.top  - offset.y) * srcBPR
 						+ (fRect.left - offset.x) * bytesPerSourcePixel;
@@ -20,6 +20,7 @@
 #include <agg_renderer_scanline.h>
 #include <agg_scanline_bin.h>
 #include <agg_scanline_p.h>
+#include <agg_scanline_storage_aa.h>
 #include <agg_scanline_u.h>
 #include <agg_span_allocator.h>
 #include <agg_span_gradient.h>
@@ -74,6 +75,8 @@
 	typedef agg::renderer_scanline_bin_solid<renderer_base>		renderer_bin_type;
 	typedef agg::renderer_scanline_subpix_solid<renderer_base>  renderer_subpix_type;
 
+	typedef agg::scanline_storage_aa8							scanline_storage_type;
+
 	typedef agg::rasterizer_scanline_aa<>						rasterizer_type;
 	typedef agg::rasterizer_scanline_aa_subpix<>				rasterizer_subpix_type;
 
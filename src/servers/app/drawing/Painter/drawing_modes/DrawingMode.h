@@ -12,6 +12,7 @@
 
 #include "drawing_support.h"
 
+#include "DrawingModeKernels.h"
 #include "PatternHandler.h"
 #include "PixelFormat.h"
 
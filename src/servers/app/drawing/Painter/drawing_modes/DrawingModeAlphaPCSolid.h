@@ -72,19 +72,9 @@ blend_solid_hspan_alpha_pc_solid(int x, int y, unsigned len,
 						   const color_type& color, const uint8* covers,
 						   agg_buffer* buffer, const PatternHandler*)
 {
-	uint8* p = buffer->row_ptr(y) + (x << 2);
-	do {
-		uint16 alpha = color.a * *covers;
-		if (alpha) {
-			if(alpha == 255 * 255) {
-				ASSIGN_ALPHA_PC(p, color.r, color.g, color.b);
-			} else {
-				BLEND_ALPHA_PC(p, color.r, color.g, color.b, alpha);
-			}
-		}
-		covers++;
-		p += 4;
-	} while(--len);
+	gDrawingModeKernels->blend_solid_hspan_alpha_pc(
+		buffer->row_ptr(y) + (x << 2), covers, len, color.r, color.g, color.b,
+		color.a);
 }
 
 
@@ -19,24 +19,12 @@ blend_solid_hspan_alpha_po_solid_subpix(int x, int y, unsigned len,
 	const color_type& c, const uint8* covers, agg_buffer* buffer,
 	const PatternHandler* pattern)
 {
-	uint8* p = buffer->row_ptr(y) + (x << 2);
-	uint16 alphaRed;
-	uint16 alphaGreen;
-	uint16 alphaBlue;
 	const int subpixelL = gSubpixelOrderingRGB ? 2 : 0;
 	const int subpixelM = 1;
 	const int subpixelR = gSubpixelOrderingRGB ? 0 : 2;
-	do {
-		alphaRed = c.a * covers[subpixelL];
-		alphaGreen = c.a * covers[subpixelM];
-		alphaBlue = c.a * covers[subpixelR];
-		BLEND_ALPHA_PO_SUBPIX(p, c.r, c.g, c.b,
-			alphaBlue, alphaGreen, alphaRed);
-		covers += 3;
-		p += 4;
-		x++;
-		len -= 3;
-	} while (len);
+	gDrawingModeKernels->blend_solid_hspan_alpha_co_subpix(
+		buffer->row_ptr(y) + (x << 2), covers, len / 3, c.r, c.g, c.b, c.a,
+		subpixelR, subpixelM, subpixelL);
 }
 
 #endif // DRAWING_MODE_ALPHA_PO_SOLID_SUBPIX_H
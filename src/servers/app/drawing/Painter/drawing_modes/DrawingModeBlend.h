@@ -82,6 +82,13 @@ blend_solid_hspan_blend(int x, int y, unsigned len,
 						agg_buffer* buffer, const PatternHandler* pattern)
 {
 	uint8* p = buffer->row_ptr(y) + (x << 2);
+	if (pattern->IsSolid()) {
+		rgb_color color = pattern->ColorAt(x, y);
+		gDrawingModeKernels->blend_solid_hspan_blend(p, covers, len,
+			color.red, color.green, color.blue);
+		return;
+	}
+
 	do {
 		rgb_color color = pattern->ColorAt(x, y);
 		if (*covers) {
@@ -20,18 +20,12 @@ blend_solid_hspan_copy_solid_subpix(int x, int y, unsigned len,
 	const color_type& c, const uint8* covers, agg_buffer* buffer,
 	const PatternHandler* pattern)
 {
-	uint8* p = buffer->row_ptr(y) + (x << 2);
 	const int subpixelL = gSubpixelOrderingRGB ? 2 : 0;
 	const int subpixelM = 1;
 	const int subpixelR = gSubpixelOrderingRGB ? 0 : 2;
-	do {
-		BLEND_OVER_SUBPIX(p, c.r, c.g, c.b, covers[subpixelL],
-			covers[subpixelM], covers[subpixelR]);
-		covers += 3;
-		p += 4;
-		x++;
-		len -= 3;
-	} while (len);
+	gDrawingModeKernels->blend_solid_hspan_subpix(
+		buffer->row_ptr(y) + (x << 2), covers, len / 3, c.r, c.g, c.b,
+		subpixelL, subpixelM, subpixelR);
 }
 
 #endif // DRAWING_MODE_COPY_SOLID_SUBPIX_H
@@ -0,0 +1,887 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * Span kernels of the most used drawing modes on B_RGBA32.
+ *
+ * The SIMD versions compute the very same integer expressions as the
+ * scalar BLEND macros, only rearranged so that no intermediate result
+ * is negative:
+ *	((s - d) * a + (d << 8)) >> 8  ==  (s * a + d * (256 - a)) >> 8
+ * The 16 bit variant is computed in 32 bit lanes. Pixels that take a
+ * different path (zero or full cover) are masked in afterwards.
+ *
+ */
+
+#include "DrawingModeKernels.h"
+
+#include <string.h>
+
+#include "DrawingMode.h"
+
+
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__) \
+	&& __GNUC__ >= 5
+#	define DRAWING_MODE_KERNELS_X86 1
+#	include <immintrin.h>
+#	define SSE2_FUNCTION __attribute__((target("sse2")))
+#	define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+
+// #pragma mark - scalar
+
+
+static void
+blend_solid_hspan_scalar(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b)
+{
+	while (count-- > 0) {
+		if (*covers) {
+			if (*covers == 255) {
+				p[0] = b;
+				p[1] = g;
+				p[2] = r;
+				p[3] = 255;
+			} else {
+				BLEND(p, r, g, b, *covers);
+			}
+		}
+		covers++;
+		p += 4;
+	}
+}
+
+
+static void
+blend_solid_hspan_subpix_scalar(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b, int offsetBlue, int offsetGreen, int offsetRed)
+{
+	while (count-- > 0) {
+		BLEND_SUBPIX(p, r, g, b, covers[offsetBlue], covers[offsetGreen],
+			covers[offsetRed]);
+		covers += 3;
+		p += 4;
+	}
+}
+
+
+static inline void
+blend_pixel_alpha_co(uint8* p, uint8 r, uint8 g, uint8 b, uint16 alpha)
+{
+	if (alpha) {
+		if (alpha == 255 * 255) {
+			p[0] = b;
+			p[1] = g;
+			p[2] = r;
+			p[3] = 255;
+		} else {
+			BLEND16(p, r, g, b, alpha);
+		}
+	}
+}
+
+
+static void
+blend_solid_hspan_alpha_co_scalar(uint8* p, const uint8* covers,
+	uint32 count, uint8 r, uint8 g, uint8 b, uint8 alpha)
+{
+	while (count-- > 0) {
+		blend_pixel_alpha_co(p, r, g, b, alpha * *covers);
+		covers++;
+		p += 4;
+	}
+}
+
+
+static void
+blend_solid_hspan_alpha_co_subpix_scalar(uint8* p, const uint8* covers,
+	uint32 count, uint8 r, uint8 g, uint8 b, uint8 alpha, int offsetBlue,
+	int offsetGreen, int offsetRed)
+{
+	while (count-- > 0) {
+		uint16 alphaBlue = alpha * covers[offsetBlue];
+		uint16 alphaGreen = alpha * covers[offsetGreen];
+		uint16 alphaRed = alpha * covers[offsetRed];
+		BLEND16_SUBPIX(p, r, g, b, alphaBlue, alphaGreen, alphaRed);
+		covers += 3;
+		p += 4;
+	}
+}
+
+
+static inline void
+blend_pixel_alpha_pc(uint8* p, uint8 r, uint8 g, uint8 b, uint16 alpha)
+{
+	if (alpha) {
+		if (alpha == 255 * 255) {
+			p[0] = b;
+			p[1] = g;
+			p[2] = r;
+			p[3] = 255;
+		} else {
+			BLEND_COMPOSITE16(p, r, g, b, alpha);
+		}
+	}
+}
+
+
+static void
+blend_solid_hspan_alpha_pc_scalar(uint8* p, const uint8* covers,
+	uint32 count, uint8 r, uint8 g, uint8 b, uint8 alpha)
+{
+	while (count-- > 0) {
+		blend_pixel_alpha_pc(p, r, g, b, alpha * *covers);
+		covers++;
+		p += 4;
+	}
+}
+
+
+static inline void
+blend_pixel_blend(uint8* p, uint8 r, uint8 g, uint8 b, uint8 cover)
+{
+	if (cover) {
+		pixel32 _p;
+		_p.data32 = *(uint32*)p;
+		uint8 bt = (_p.data8[0] + b) >> 1;
+		uint8 gt = (_p.data8[1] + g) >> 1;
+		uint8 rt = (_p.data8[2] + r) >> 1;
+		if (cover == 255) {
+			p[0] = bt;
+			p[1] = gt;
+			p[2] = rt;
+			p[3] = 255;
+		} else {
+			BLEND(p, rt, gt, bt, cover);
+		}
+	}
+}
+
+
+static void
+blend_solid_hspan_blend_scalar(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b)
+{
+	while (count-- > 0) {
+		blend_pixel_blend(p, r, g, b, *covers);
+		covers++;
+		p += 4;
+	}
+}
+
+
+static void
+blend_line_scalar(uint8* p, uint32 count, uint8 r, uint8 g, uint8 b,
+	uint8 alpha)
+{
+	r = (r * alpha) >> 8;
+	g = (g * alpha) >> 8;
+	b = (b * alpha) >> 8;
+	alpha = 255 - alpha;
+
+	while (count-- > 0) {
+		p[0] = ((p[0] * alpha) >> 8) + b;
+		p[1] = ((p[1] * alpha) >> 8) + g;
+		p[2] = ((p[2] * alpha) >> 8) + r;
+		p[3] = 255;
+		p += 4;
+	}
+}
+
+
+static const drawing_mode_kernels kScalarKernels = {
+	blend_solid_hspan_scalar,
+	blend_solid_hspan_subpix_scalar,
+	blend_solid_hspan_alpha_co_scalar,
+	blend_solid_hspan_alpha_co_subpix_scalar,
+	blend_solid_hspan_alpha_pc_scalar,
+	blend_solid_hspan_blend_scalar,
+	blend_line_scalar
+};
+
+
+#if DRAWING_MODE_KERNELS_X86
+
+
+static inline uint32
+load_covers4(const uint8* covers)
+{
+	uint32 value;
+	memcpy(&value, covers, sizeof(value));
+	return value;
+}
+
+
+// #pragma mark - SSE2
+
+
+// Returns the 16 bit lanes of 4 per pixel values, each repeated for the
+// four channels, for the first two pixels in "low", the others in "high".
+SSE2_FUNCTION static inline void
+broadcast4_sse2(__m128i values, __m128i& low, __m128i& high)
+{
+	__m128i doubled = _mm_unpacklo_epi16(values, values);
+	low = _mm_unpacklo_epi32(doubled, doubled);
+	high = _mm_unpackhi_epi32(doubled, doubled);
+}
+
+
+// (s * a + d * (256 - a)) >> 8 for 8 bit alpha values, on two pixels
+SSE2_FUNCTION static inline __m128i
+blend8_sse2(__m128i dest, __m128i source, __m128i alpha)
+{
+	__m128i inverse = _mm_sub_epi16(_mm_set1_epi16(256), alpha);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(source, alpha),
+		_mm_mullo_epi16(dest, inverse)), 8);
+}
+
+
+// (s * a + (d << 16) - d * a) >> 16 for 16 bit alpha values, on two pixels
+SSE2_FUNCTION static inline __m128i
+blend16_sse2(__m128i dest, __m128i source, __m128i alpha)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i sourceLow = _mm_mullo_epi16(source, alpha);
+	__m128i sourceHigh = _mm_mulhi_epu16(source, alpha);
+	__m128i destLow = _mm_mullo_epi16(dest, alpha);
+	__m128i destHigh = _mm_mulhi_epu16(dest, alpha);
+
+	__m128i first = _mm_sub_epi32(
+		_mm_add_epi32(_mm_unpacklo_epi16(sourceLow, sourceHigh),
+			_mm_unpacklo_epi16(zero, dest)),
+		_mm_unpacklo_epi16(destLow, destHigh));
+	__m128i second = _mm_sub_epi32(
+		_mm_add_epi32(_mm_unpackhi_epi16(sourceLow, sourceHigh),
+			_mm_unpackhi_epi16(zero, dest)),
+		_mm_unpackhi_epi16(destLow, destHigh));
+
+	return _mm_packs_epi32(_mm_srli_epi32(first, 16),
+		_mm_srli_epi32(second, 16));
+}
+
+
+SSE2_FUNCTION static inline __m128i
+select_sse2(__m128i mask, __m128i ifSet, __m128i otherwise)
+{
+	return _mm_or_si128(_mm_and_si128(mask, ifSet),
+		_mm_andnot_si128(mask, otherwise));
+}
+
+
+// Expands the 16 bit per pixel values of 4 pixels into 32 bit lanes
+SSE2_FUNCTION static inline __m128i
+per_pixel_sse2(__m128i values)
+{
+	return _mm_unpacklo_epi16(values, _mm_setzero_si128());
+}
+
+
+SSE2_FUNCTION static inline __m128i
+color16_sse2(uint8 r, uint8 g, uint8 b)
+{
+	return _mm_setr_epi16(b, g, r, 0, b, g, r, 0);
+}
+
+
+SSE2_FUNCTION static void
+blend_solid_hspan_sse2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xff000000);
+	const __m128i color = color16_sse2(r, g, b);
+	const __m128i solid = _mm_set1_epi32(0xff000000 | (r << 16) | (g << 8)
+		| b);
+	const __m128i full = _mm_set1_epi32(255);
+
+	for (; count >= 4; count -= 4, covers += 4, p += 16) {
+		uint32 cover4 = load_covers4(covers);
+		if (cover4 == 0)
+			continue;
+		if (cover4 == 0xffffffff) {
+			_mm_storeu_si128((__m128i*)p, solid);
+			continue;
+		}
+
+		__m128i dest = _mm_loadu_si128((__m128i*)p);
+		__m128i cover = _mm_unpacklo_epi8(_mm_cvtsi32_si128(cover4), zero);
+		__m128i alphaLow;
+		__m128i alphaHigh;
+		broadcast4_sse2(cover, alphaLow, alphaHigh);
+
+		__m128i result = _mm_packus_epi16(
+			blend8_sse2(_mm_unpacklo_epi8(dest, zero), color, alphaLow),
+			blend8_sse2(_mm_unpackhi_epi8(dest, zero), color, alphaHigh));
+		result = _mm_or_si128(result, opaque);
+
+		__m128i pixelCover = per_pixel_sse2(cover);
+		result = select_sse2(_mm_cmpeq_epi32(pixelCover, full), solid, result);
+		result = select_sse2(_mm_cmpeq_epi32(pixelCover, zero), dest, result);
+		_mm_storeu_si128((__m128i*)p, result);
+	}
+
+	blend_solid_hspan_scalar(p, covers, count, r, g, b);
+}
+
+
+SSE2_FUNCTION static void
+blend_solid_hspan_subpix_sse2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b, int offsetBlue, int offsetGreen, int offsetRed)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xff000000);
+	const __m128i color = color16_sse2(r, g, b);
+
+	for (; count >= 2; count -= 2, covers += 6, p += 8) {
+		__m128i alpha = _mm_setr_epi16(covers[offsetBlue],
+			covers[offsetGreen], covers[offsetRed], 0, covers[3 + offsetBlue],
+			covers[3 + offsetGreen], covers[3 + offsetRed], 0);
+		__m128i dest = _mm_loadl_epi64((__m128i*)p);
+
+		__m128i result = blend8_sse2(_mm_unpacklo_epi8(dest, zero), color,
+			alpha);
+		result = _mm_or_si128(_mm_packus_epi16(result, result), opaque);
+		_mm_storel_epi64((__m128i*)p, result);
+	}
+
+	blend_solid_hspan_subpix_scalar(p, covers, count, r, g, b, offsetBlue,
+		offsetGreen, offsetRed);
+}
+
+
+SSE2_FUNCTION static void
+blend_solid_hspan_alpha_co_sse2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b, uint8 alpha)
+{
+	if (alpha == 0)
+		return;
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xff000000);
+	const __m128i color = color16_sse2(r, g, b);
+	const __m128i solid = _mm_set1_epi32(0xff000000 | (r << 16) | (g << 8)
+		| b);
+	const __m128i highAlpha = _mm_set1_epi16(alpha);
+	const __m128i full = _mm_set1_epi32(255 * 255);
+
+	for (; count >= 4; count -= 4, covers += 4, p += 16) {
+		uint32 cover4 = load_covers4(covers);
+		if (cover4 == 0)
+			continue;
+		if (cover4 == 0xffffffff && alpha == 255) {
+			_mm_storeu_si128((__m128i*)p, solid);
+			continue;
+		}
+
+		__m128i dest = _mm_loadu_si128((__m128i*)p);
+		__m128i pixelAlpha = _mm_mullo_epi16(
+			_mm_unpacklo_epi8(_mm_cvtsi32_si128(cover4), zero), highAlpha);
+		__m128i alphaLow;
+		__m128i alphaHigh;
+		broadcast4_sse2(pixelAlpha, alphaLow, alphaHigh);
+
+		__m128i result = _mm_packus_epi16(
+			blend16_sse2(_mm_unpacklo_epi8(dest, zero), color, alphaLow),
+			blend16_sse2(_mm_unpackhi_epi8(dest, zero), color, alphaHigh));
+		result = _mm_or_si128(result, opaque);
+
+		pixelAlpha = per_pixel_sse2(pixelAlpha);
+		result = select_sse2(_mm_cmpeq_epi32(pixelAlpha, full), solid, result);
+		result = select_sse2(_mm_cmpeq_epi32(pixelAlpha, zero), dest, result);
+		_mm_storeu_si128((__m128i*)p, result);
+	}
+
+	blend_solid_hspan_alpha_co_scalar(p, covers, count, r, g, b, alpha);
+}
+
+
+SSE2_FUNCTION static void
+blend_solid_hspan_alpha_co_subpix_sse2(uint8* p, const uint8* covers,
+	uint32 count, uint8 r, uint8 g, uint8 b, uint8 alpha, int offsetBlue,
+	int offsetGreen, int offsetRed)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xff000000);
+	const __m128i color = color16_sse2(r, g, b);
+	const __m128i highAlpha = _mm_set1_epi16(alpha);
+
+	for (; count >= 2; count -= 2, covers += 6, p += 8) {
+		__m128i pixelAlpha = _mm_mullo_epi16(_mm_setr_epi16(
+			covers[offsetBlue], covers[offsetGreen], covers[offsetRed], 0,
+			covers[3 + offsetBlue], covers[3 + offsetGreen],
+			covers[3 + offsetRed], 0), highAlpha);
+		__m128i dest = _mm_loadl_epi64((__m128i*)p);
+
+		__m128i result = blend16_sse2(_mm_unpacklo_epi8(dest, zero), color,
+			pixelAlpha);
+		result = _mm_or_si128(_mm_packus_epi16(result, result), opaque);
+		_mm_storel_epi64((__m128i*)p, result);
+	}
+
+	blend_solid_hspan_alpha_co_subpix_scalar(p, covers, count, r, g, b, alpha,
+		offsetBlue, offsetGreen, offsetRed);
+}
+
+
+SSE2_FUNCTION static void
+blend_solid_hspan_alpha_pc_sse2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b, uint8 alpha)
+{
+	if (alpha == 0)
+		return;
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xff000000);
+	const __m128i color = color16_sse2(r, g, b);
+	const __m128i solid = _mm_set1_epi32(0xff000000 | (r << 16) | (g << 8)
+		| b);
+	const __m128i highAlpha = _mm_set1_epi16(alpha);
+	const __m128i full = _mm_set1_epi32(255 * 255);
+	const __m128i divide = _mm_set1_epi16((int16)0x8081);
+
+	for (; count >= 4; count -= 4, covers += 4, p += 16) {
+		uint32 cover4 = load_covers4(covers);
+		if (cover4 == 0)
+			continue;
+
+		__m128i dest = _mm_loadu_si128((__m128i*)p);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(dest, opaque),
+				opaque)) != 0xffff) {
+			// only opaque pixels take the simple path of BLEND_COMPOSITE()
+			blend_solid_hspan_alpha_pc_scalar(p, covers, 4, r, g, b, alpha);
+			continue;
+		}
+
+		__m128i pixelAlpha = _mm_mullo_epi16(
+			_mm_unpacklo_epi8(_mm_cvtsi32_si128(cover4), zero), highAlpha);
+		// x / 255 == (x * 0x8081) >> 23 for all 16 bit x
+		__m128i blendAlpha = _mm_srli_epi16(
+			_mm_mulhi_epu16(pixelAlpha, divide), 7);
+		__m128i alphaLow;
+		__m128i alphaHigh;
+		broadcast4_sse2(blendAlpha, alphaLow, alphaHigh);
+
+		__m128i result = _mm_packus_epi16(
+			blend8_sse2(_mm_unpacklo_epi8(dest, zero), color, alphaLow),
+			blend8_sse2(_mm_unpackhi_epi8(dest, zero), color, alphaHigh));
+		result = _mm_or_si128(result, opaque);
+
+		pixelAlpha = per_pixel_sse2(pixelAlpha);
+		result = select_sse2(_mm_cmpeq_epi32(pixelAlpha, full), solid, result);
+		result = select_sse2(_mm_cmpeq_epi32(pixelAlpha, zero), dest, result);
+		_mm_storeu_si128((__m128i*)p, result);
+	}
+
+	blend_solid_hspan_alpha_pc_scalar(p, covers, count, r, g, b, alpha);
+}
+
+
+SSE2_FUNCTION static void
+blend_solid_hspan_blend_sse2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xff000000);
+	const __m128i color = color16_sse2(r, g, b);
+	const __m128i full = _mm_set1_epi32(255);
+
+	for (; count >= 4; count -= 4, covers += 4, p += 16) {
+		uint32 cover4 = load_covers4(covers);
+		if (cover4 == 0)
+			continue;
+
+		__m128i dest = _mm_loadu_si128((__m128i*)p);
+		__m128i destLow = _mm_unpacklo_epi8(dest, zero);
+		__m128i destHigh = _mm_unpackhi_epi8(dest, zero);
+		__m128i averageLow = _mm_srli_epi16(_mm_add_epi16(destLow, color), 1);
+		__m128i averageHigh = _mm_srli_epi16(_mm_add_epi16(destHigh, color),
+			1);
+		__m128i average = _mm_or_si128(
+			_mm_packus_epi16(averageLow, averageHigh), opaque);
+
+		__m128i cover = _mm_unpacklo_epi8(_mm_cvtsi32_si128(cover4), zero);
+		__m128i alphaLow;
+		__m128i alphaHigh;
+		broadcast4_sse2(cover, alphaLow, alphaHigh);
+
+		__m128i result = _mm_packus_epi16(
+			blend8_sse2(destLow, averageLow, alphaLow),
+			blend8_sse2(destHigh, averageHigh, alphaHigh));
+		result = _mm_or_si128(result, opaque);
+
+		__m128i pixelCover = per_pixel_sse2(cover);
+		result = select_sse2(_mm_cmpeq_epi32(pixelCover, full), average,
+			result);
+		result = select_sse2(_mm_cmpeq_epi32(pixelCover, zero), dest, result);
+		_mm_storeu_si128((__m128i*)p, result);
+	}
+
+	blend_solid_hspan_blend_scalar(p, covers, count, r, g, b);
+}
+
+
+SSE2_FUNCTION static void
+blend_line_sse2(uint8* p, uint32 count, uint8 r, uint8 g, uint8 b,
+	uint8 alpha)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xff000000);
+	const __m128i color = color16_sse2((r * alpha) >> 8, (g * alpha) >> 8,
+		(b * alpha) >> 8);
+	const __m128i inverse = _mm_set1_epi16(255 - alpha);
+
+	for (; count >= 4; count -= 4, p += 16) {
+		__m128i dest = _mm_loadu_si128((__m128i*)p);
+		__m128i low = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(
+			_mm_unpacklo_epi8(dest, zero), inverse), 8), color);
+		__m128i high = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(
+			_mm_unpackhi_epi8(dest, zero), inverse), 8), color);
+		_mm_storeu_si128((__m128i*)p,
+			_mm_or_si128(_mm_packus_epi16(low, high), opaque));
+	}
+
+	blend_line_scalar(p, count, r, g, b, alpha);
+}
+
+
+static const drawing_mode_kernels kSSE2Kernels = {
+	blend_solid_hspan_sse2,
+	blend_solid_hspan_subpix_sse2,
+	blend_solid_hspan_alpha_co_sse2,
+	blend_solid_hspan_alpha_co_subpix_sse2,
+	blend_solid_hspan_alpha_pc_sse2,
+	blend_solid_hspan_blend_sse2,
+	blend_line_sse2
+};
+
+
+// #pragma mark - AVX2
+
+
+// The AVX2 kernels work on 8 pixels at a time. Since unpacking works within
+// 128 bit lanes, the "low" half of the 16 bit pixels holds pixels 0, 1, 4
+// and 5, the "high" half pixels 2, 3, 6 and 7, which the final pack puts
+// back in order.
+
+
+AVX2_FUNCTION static inline void
+broadcast8_avx2(__m128i values, __m256i& low, __m256i& high)
+{
+	__m128i first = _mm_unpacklo_epi16(values, values);
+	__m128i second = _mm_unpackhi_epi16(values, values);
+	low = _mm256_inserti128_si256(_mm256_castsi128_si256(
+		_mm_unpacklo_epi32(first, first)),
+		_mm_unpacklo_epi32(second, second), 1);
+	high = _mm256_inserti128_si256(_mm256_castsi128_si256(
+		_mm_unpackhi_epi32(first, first)),
+		_mm_unpackhi_epi32(second, second), 1);
+}
+
+
+AVX2_FUNCTION static inline __m256i
+blend8_avx2(__m256i dest, __m256i source, __m256i alpha)
+{
+	__m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(256), alpha);
+	return _mm256_srli_epi16(_mm256_add_epi16(
+		_mm256_mullo_epi16(source, alpha), _mm256_mullo_epi16(dest, inverse)),
+		8);
+}
+
+
+AVX2_FUNCTION static inline __m256i
+blend16_avx2(__m256i dest, __m256i source, __m256i alpha)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i sourceLow = _mm256_mullo_epi16(source, alpha);
+	__m256i sourceHigh = _mm256_mulhi_epu16(source, alpha);
+	__m256i destLow = _mm256_mullo_epi16(dest, alpha);
+	__m256i destHigh = _mm256_mulhi_epu16(dest, alpha);
+
+	__m256i first = _mm256_sub_epi32(
+		_mm256_add_epi32(_mm256_unpacklo_epi16(sourceLow, sourceHigh),
+			_mm256_unpacklo_epi16(zero, dest)),
+		_mm256_unpacklo_epi16(destLow, destHigh));
+	__m256i second = _mm256_sub_epi32(
+		_mm256_add_epi32(_mm256_unpackhi_epi16(sourceLow, sourceHigh),
+			_mm256_unpackhi_epi16(zero, dest)),
+		_mm256_unpackhi_epi16(destLow, destHigh));
+
+	return _mm256_packs_epi32(_mm256_srli_epi32(first, 16),
+		_mm256_srli_epi32(second, 16));
+}
+
+
+// Takes 8 covers or 16 bit per pixel values, returns them in 32 bit lanes
+AVX2_FUNCTION static inline __m256i
+per_pixel_avx2(__m128i values)
+{
+	return _mm256_cvtepu16_epi32(values);
+}
+
+
+AVX2_FUNCTION static inline __m256i
+color16_avx2(uint8 r, uint8 g, uint8 b)
+{
+	return _mm256_setr_epi16(b, g, r, 0, b, g, r, 0, b, g, r, 0, b, g, r, 0);
+}
+
+
+AVX2_FUNCTION static void
+blend_solid_hspan_avx2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi32(0xff000000);
+	const __m256i color = color16_avx2(r, g, b);
+	const __m256i solid = _mm256_set1_epi32(0xff000000 | (r << 16)
+		| (g << 8) | b);
+	const __m256i full = _mm256_set1_epi32(255);
+
+	for (; count >= 8; count -= 8, covers += 8, p += 32) {
+		uint64 cover8;
+		memcpy(&cover8, covers, sizeof(cover8));
+		if (cover8 == 0)
+			continue;
+		if (cover8 == ~(uint64)0) {
+			_mm256_storeu_si256((__m256i*)p, solid);
+			continue;
+		}
+
+		__m256i dest = _mm256_loadu_si256((__m256i*)p);
+		__m128i cover = _mm_cvtepu8_epi16(_mm_loadl_epi64((__m128i*)covers));
+		__m256i alphaLow;
+		__m256i alphaHigh;
+		broadcast8_avx2(cover, alphaLow, alphaHigh);
+
+		__m256i result = _mm256_packus_epi16(
+			blend8_avx2(_mm256_unpacklo_epi8(dest, zero), color, alphaLow),
+			blend8_avx2(_mm256_unpackhi_epi8(dest, zero), color, alphaHigh));
+		result = _mm256_or_si256(result, opaque);
+
+		__m256i pixelCover = per_pixel_avx2(cover);
+		result = _mm256_blendv_epi8(result, solid,
+			_mm256_cmpeq_epi32(pixelCover, full));
+		result = _mm256_blendv_epi8(result, dest,
+			_mm256_cmpeq_epi32(pixelCover, zero));
+		_mm256_storeu_si256((__m256i*)p, result);
+	}
+
+	blend_solid_hspan_sse2(p, covers, count, r, g, b);
+}
+
+
+AVX2_FUNCTION static void
+blend_solid_hspan_alpha_co_avx2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b, uint8 alpha)
+{
+	if (alpha == 0)
+		return;
+
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi32(0xff000000);
+	const __m256i color = color16_avx2(r, g, b);
+	const __m256i solid = _mm256_set1_epi32(0xff000000 | (r << 16)
+		| (g << 8) | b);
+	const __m128i highAlpha = _mm_set1_epi16(alpha);
+	const __m256i full = _mm256_set1_epi32(255 * 255);
+
+	for (; count >= 8; count -= 8, covers += 8, p += 32) {
+		uint64 cover8;
+		memcpy(&cover8, covers, sizeof(cover8));
+		if (cover8 == 0)
+			continue;
+		if (cover8 == ~(uint64)0 && alpha == 255) {
+			_mm256_storeu_si256((__m256i*)p, solid);
+			continue;
+		}
+
+		__m256i dest = _mm256_loadu_si256((__m256i*)p);
+		__m128i pixelAlpha = _mm_mullo_epi16(
+			_mm_cvtepu8_epi16(_mm_loadl_epi64((__m128i*)covers)), highAlpha);
+		__m256i alphaLow;
+		__m256i alphaHigh;
+		broadcast8_avx2(pixelAlpha, alphaLow, alphaHigh);
+
+		__m256i result = _mm256_packus_epi16(
+			blend16_avx2(_mm256_unpacklo_epi8(dest, zero), color, alphaLow),
+			blend16_avx2(_mm256_unpackhi_epi8(dest, zero), color, alphaHigh));
+		result = _mm256_or_si256(result, opaque);
+
+		__m256i alpha32 = per_pixel_avx2(pixelAlpha);
+		result = _mm256_blendv_epi8(result, solid,
+			_mm256_cmpeq_epi32(alpha32, full));
+		result = _mm256_blendv_epi8(result, dest,
+			_mm256_cmpeq_epi32(alpha32, zero));
+		_mm256_storeu_si256((__m256i*)p, result);
+	}
+
+	blend_solid_hspan_alpha_co_sse2(p, covers, count, r, g, b, alpha);
+}
+
+
+AVX2_FUNCTION static void
+blend_solid_hspan_alpha_pc_avx2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b, uint8 alpha)
+{
+	if (alpha == 0)
+		return;
+
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi32(0xff000000);
+	const __m256i color = color16_avx2(r, g, b);
+	const __m256i solid = _mm256_set1_epi32(0xff000000 | (r << 16)
+		| (g << 8) | b);
+	const __m128i highAlpha = _mm_set1_epi16(alpha);
+	const __m256i full = _mm256_set1_epi32(255 * 255);
+	const __m128i divide = _mm_set1_epi16((int16)0x8081);
+
+	for (; count >= 8; count -= 8, covers += 8, p += 32) {
+		uint64 cover8;
+		memcpy(&cover8, covers, sizeof(cover8));
+		if (cover8 == 0)
+			continue;
+
+		__m256i dest = _mm256_loadu_si256((__m256i*)p);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(
+				_mm256_and_si256(dest, opaque), opaque)) != -1) {
+			// only opaque pixels take the simple path of BLEND_COMPOSITE()
+			blend_solid_hspan_alpha_pc_sse2(p, covers, 8, r, g, b, alpha);
+			continue;
+		}
+
+		__m128i pixelAlpha = _mm_mullo_epi16(
+			_mm_cvtepu8_epi16(_mm_loadl_epi64((__m128i*)covers)), highAlpha);
+		__m128i blendAlpha = _mm_srli_epi16(
+			_mm_mulhi_epu16(pixelAlpha, divide), 7);
+		__m256i alphaLow;
+		__m256i alphaHigh;
+		broadcast8_avx2(blendAlpha, alphaLow, alphaHigh);
+
+		__m256i result = _mm256_packus_epi16(
+			blend8_avx2(_mm256_unpacklo_epi8(dest, zero), color, alphaLow),
+			blend8_avx2(_mm256_unpackhi_epi8(dest, zero), color, alphaHigh));
+		result = _mm256_or_si256(result, opaque);
+
+		__m256i alpha32 = per_pixel_avx2(pixelAlpha);
+		result = _mm256_blendv_epi8(result, solid,
+			_mm256_cmpeq_epi32(alpha32, full));
+		result = _mm256_blendv_epi8(result, dest,
+			_mm256_cmpeq_epi32(alpha32, zero));
+		_mm256_storeu_si256((__m256i*)p, result);
+	}
+
+	blend_solid_hspan_alpha_pc_sse2(p, covers, count, r, g, b, alpha);
+}
+
+
+AVX2_FUNCTION static void
+blend_solid_hspan_blend_avx2(uint8* p, const uint8* covers, uint32 count,
+	uint8 r, uint8 g, uint8 b)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi32(0xff000000);
+	const __m256i color = color16_avx2(r, g, b);
+	const __m256i full = _mm256_set1_epi32(255);
+
+	for (; count >= 8; count -= 8, covers += 8, p += 32) {
+		uint64 cover8;
+		memcpy(&cover8, covers, sizeof(cover8));
+		if (cover8 == 0)
+			continue;
+
+		__m256i dest = _mm256_loadu_si256((__m256i*)p);
+		__m256i destLow = _mm256_unpacklo_epi8(dest, zero);
+		__m256i destHigh = _mm256_unpackhi_epi8(dest, zero);
+		__m256i averageLow = _mm256_srli_epi16(
+			_mm256_add_epi16(destLow, color), 1);
+		__m256i averageHigh = _mm256_srli_epi16(
+			_mm256_add_epi16(destHigh, color), 1);
+		__m256i average = _mm256_or_si256(
+			_mm256_packus_epi16(averageLow, averageHigh), opaque);
+
+		__m128i cover = _mm_cvtepu8_epi16(_mm_loadl_epi64((__m128i*)covers));
+		__m256i alphaLow;
+		__m256i alphaHigh;
+		broadcast8_avx2(cover, alphaLow, alphaHigh);
+
+		__m256i result = _mm256_packus_epi16(
+			blend8_avx2(destLow, averageLow, alphaLow),
+			blend8_avx2(destHigh, averageHigh, alphaHigh));
+		result = _mm256_or_si256(result, opaque);
+
+		__m256i pixelCover = per_pixel_avx2(cover);
+		result = _mm256_blendv_epi8(result, average,
+			_mm256_cmpeq_epi32(pixelCover, full));
+		result = _mm256_blendv_epi8(result, dest,
+			_mm256_cmpeq_epi32(pixelCover, zero));
+		_mm256_storeu_si256((__m256i*)p, result);
+	}
+
+	blend_solid_hspan_blend_sse2(p, covers, count, r, g, b);
+}
+
+
+AVX2_FUNCTION static void
+blend_line_avx2(uint8* p, uint32 count, uint8 r, uint8 g, uint8 b,
+	uint8 alpha)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi32(0xff000000);
+	const __m256i color = color16_avx2((r * alpha) >> 8, (g * alpha) >> 8,
+		(b * alpha) >> 8);
+	const __m256i inverse = _mm256_set1_epi16(255 - alpha);
+
+	for (; count >= 8; count -= 8, p += 32) {
+		__m256i dest = _mm256_loadu_si256((__m256i*)p);
+		__m256i low = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(
+			_mm256_unpacklo_epi8(dest, zero), inverse), 8), color);
+		__m256i high = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(
+			_mm256_unpackhi_epi8(dest, zero), inverse), 8), color);
+		_mm256_storeu_si256((__m256i*)p,
+			_mm256_or_si256(_mm256_packus_epi16(low, high), opaque));
+	}
+
+	blend_line_sse2(p, count, r, g, b, alpha);
+}
+
+
+// the subpixel kernels are limited by gathering the covers, and gain
+// nothing from the wider registers
+static const drawing_mode_kernels kAVX2Kernels = {
+	blend_solid_hspan_avx2,
+	blend_solid_hspan_subpix_sse2,
+	blend_solid_hspan_alpha_co_avx2,
+	blend_solid_hspan_alpha_co_subpix_sse2,
+	blend_solid_hspan_alpha_pc_avx2,
+	blend_solid_hspan_blend_avx2,
+	blend_line_avx2
+};
+
+
+#endif	// DRAWING_MODE_KERNELS_X86
+
+
+// #pragma mark -
+
+
+const drawing_mode_kernels* gDrawingModeKernels = &kScalarKernels;
+
+
+/*!	Returns the fastest kernels that only use the instruction sets given in
+	\a simdFlags.
+*/
+const drawing_mode_kernels*
+drawing_mode_kernels_for(uint32 simdFlags)
+{
+#if DRAWING_MODE_KERNELS_X86
+	if ((simdFlags & (APPSERVER_SIMD_SSE2 | APPSERVER_SIMD_AVX2))
+			== (APPSERVER_SIMD_SSE2 | APPSERVER_SIMD_AVX2)) {
+		return &kAVX2Kernels;
+	}
+	if ((simdFlags & APPSERVER_SIMD_SSE2) != 0)
+		return &kSSE2Kernels;
+#endif
+
+	return &kScalarKernels;
+}
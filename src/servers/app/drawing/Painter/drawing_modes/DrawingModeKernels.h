@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * Span kernels of the most used drawing modes on B_RGBA32, in scalar and
+ * SIMD versions.
+ *
+ */
+#ifndef DRAWING_MODE_KERNELS_H
+#define DRAWING_MODE_KERNELS_H
+
+
+#include <SupportDefs.h>
+
+
+// Defines for SIMD support.
+#define APPSERVER_SIMD_MMX	(1 << 0)
+#define APPSERVER_SIMD_SSE	(1 << 1)
+#define APPSERVER_SIMD_SSE2	(1 << 2)
+#define APPSERVER_SIMD_AVX2	(1 << 3)
+
+extern uint32 gSIMDFlags;
+
+
+// All kernels blend a single color into "count" pixels starting at "p".
+// The scalar versions are the reference; the SIMD versions have to produce
+// exactly the same pixels.
+struct drawing_mode_kernels {
+	// BLEND() with each cover, assigns the color for full covers
+	// (B_OP_COPY and B_OP_OVER with a solid pattern)
+	void	(*blend_solid_hspan)(uint8* p, const uint8* covers,
+				uint32 count, uint8 r, uint8 g, uint8 b);
+
+	// BLEND_SUBPIX() with three covers per pixel, the blue, green and red
+	// channel using the covers at the given offsets of each triple
+	void	(*blend_solid_hspan_subpix)(uint8* p, const uint8* covers,
+				uint32 count, uint8 r, uint8 g, uint8 b, int offsetBlue,
+				int offsetGreen, int offsetRed);
+
+	// BLEND16() with alpha * cover (B_OP_ALPHA with B_ALPHA_OVERLAY, the
+	// alpha being the one of the high color or of the solid color)
+	void	(*blend_solid_hspan_alpha_co)(uint8* p, const uint8* covers,
+				uint32 count, uint8 r, uint8 g, uint8 b, uint8 alpha);
+
+	// BLEND16_SUBPIX() with alpha * cover, see blend_solid_hspan_subpix
+	void	(*blend_solid_hspan_alpha_co_subpix)(uint8* p,
+				const uint8* covers, uint32 count, uint8 r, uint8 g, uint8 b,
+				uint8 alpha, int offsetBlue, int offsetGreen, int offsetRed);
+
+	// BLEND_COMPOSITE16() with alpha * cover (B_OP_ALPHA, B_PIXEL_ALPHA,
+	// B_ALPHA_COMPOSITE)
+	void	(*blend_solid_hspan_alpha_pc)(uint8* p, const uint8* covers,
+				uint32 count, uint8 r, uint8 g, uint8 b, uint8 alpha);
+
+	// BLEND() of the average of color and pixel with each cover (B_OP_BLEND)
+	void	(*blend_solid_hspan_blend)(uint8* p, const uint8* covers,
+				uint32 count, uint8 r, uint8 g, uint8 b);
+
+	// blends with a constant alpha and no covers, premultiplying the color
+	void	(*blend_line)(uint8* p, uint32 count, uint8 r, uint8 g, uint8 b,
+				uint8 alpha);
+};
+
+
+extern const drawing_mode_kernels* gDrawingModeKernels;
+
+const drawing_mode_kernels* drawing_mode_kernels_for(uint32 simdFlags);
+
+
+#endif // DRAWING_MODE_KERNELS_H
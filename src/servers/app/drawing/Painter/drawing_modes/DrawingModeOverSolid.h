@@ -68,19 +68,8 @@ blend_solid_hspan_over_solid(int x, int y, unsigned len,
 	if (pattern->IsSolidLow())
 		return;
 
-	uint8* p = buffer->row_ptr(y) + (x << 2);
-	do {
-		if (*covers) {
-			if (*covers == 255) {
-				ASSIGN_OVER(p, c.r, c.g, c.b);
-			} else {
-				BLEND_OVER(p, c.r, c.g, c.b, *covers);
-			}
-		}
-		covers++;
-		p += 4;
-		x++;
-	} while(--len);
+	gDrawingModeKernels->blend_solid_hspan(buffer->row_ptr(y) + (x << 2),
+		covers, len, c.r, c.g, c.b);
 }
 
 // blend_solid_vspan_over_solid
@@ -0,0 +1,580 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "BitmapTiles.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static const int32 kBucketCount = 1024;
+static const int32 kBucketShift = 54;
+	// the upper bits of the hash select the bucket
+static const size_t kMaxKeptBufferSize = 1024 * 1024;
+
+static const size_t kTileLength = kBitmapTileSize * kBitmapTileSize * 4;
+static const size_t kPackedLength = kTileLength + 1
+	+ kBitmapTileMaxOperationCount * 4;
+	// packing stops once it gets as long as the raw tile, but the last
+	// operation may overshoot
+
+
+struct BitmapTileCache::slot {
+	uint64	hash;
+	int32	next_in_bucket;
+	int32	previous;
+	int32	next;
+	bool	used;
+};
+
+
+struct BitmapTileStore::slot {
+	uint32*	pixels;
+	int32	width;
+	int32	height;
+};
+
+
+static inline int32
+operation_count(int32 count)
+{
+	return count < kBitmapTileMaxOperationCount
+		? count : kBitmapTileMaxOperationCount;
+}
+
+
+/*!	Copies the tile into \a tile, and computes a hash of its contents and
+	size. Returns whether all pixels of the tile have the same value, which
+	is then returned in \a _color.
+*/
+static bool
+read_tile(const uint8* bits, int32 bytesPerRow, int32 width, int32 height,
+	uint32* tile, uint64& _hash, uint32& _color)
+{
+	uint32 first = *(const uint32*)bits;
+	uint32 different = 0;
+	uint64 hash = ((uint64)width << 32 | height) ^ 0xcbf29ce484222325ULL;
+
+	for (int32 y = 0; y < height; y++) {
+		const uint32* row = (const uint32*)(bits + y * bytesPerRow);
+		for (int32 x = 0; x < width; x++) {
+			uint32 pixel = row[x];
+			different |= pixel ^ first;
+			hash = (hash ^ pixel) * 0x9e3779b97f4a7c15ULL;
+			hash ^= hash >> 29;
+		}
+
+		memcpy(tile, row, width * 4);
+		tile += width;
+	}
+
+	_hash = hash;
+	_color = first;
+	return different == 0;
+}
+
+
+/*!	Packs the \a width x \a height pixels of \a tile into \a packed. Returns
+	the length of the packed data, or 0 if it would not be shorter than the
+	pixels themselves.
+*/
+static size_t
+pack_tile(const uint32* tile, int32 width, int32 height, uint8* packed)
+{
+	size_t rawLength = width * height * 4;
+	size_t length = 0;
+	int32 count = width * height;
+	uint32 previous = 0;
+
+	int32 index = 0;
+	while (index < count) {
+		int32 limit = operation_count(count - index);
+
+		int32 repeat = 0;
+		while (repeat < limit && tile[index + repeat] == previous)
+			repeat++;
+
+		int32 above = 0;
+		if (index >= width) {
+			while (above < limit
+				&& tile[index + above] == tile[index + above - width]) {
+				above++;
+			}
+		}
+
+		if (repeat > 0 && repeat >= above) {
+			packed[length++] = RP_TILE_OP_REPEAT << 6 | (repeat - 1);
+			index += repeat;
+		} else if (above > 0) {
+			packed[length++] = RP_TILE_OP_COPY_ABOVE << 6 | (above - 1);
+			index += above;
+		} else {
+			// stop where one of the other operations could take over
+			int32 literal = 1;
+			while (literal < limit) {
+				int32 next = index + literal;
+				if (tile[next] == tile[next - 1]
+					|| (next >= width && tile[next] == tile[next - width])) {
+					break;
+				}
+				literal++;
+			}
+
+			packed[length++] = RP_TILE_OP_LITERAL << 6 | (literal - 1);
+			memcpy(packed + length, tile + index, literal * 4);
+			length += literal * 4;
+			index += literal;
+		}
+
+		if (length >= rawLength)
+			return 0;
+
+		previous = tile[index - 1];
+	}
+
+	return length;
+}
+
+
+static bool
+unpack_tile(const uint8* packed, size_t length, uint32* tile, int32 width,
+	int32 height)
+{
+	const uint8* end = packed + length;
+	int32 count = width * height;
+	uint32 previous = 0;
+
+	int32 index = 0;
+	while (index < count) {
+		if (packed == end)
+			return false;
+
+		uint8 operation = *packed++;
+		int32 pixels = (operation & 0x3f) + 1;
+		if (pixels > count - index)
+			return false;
+
+		switch (operation >> 6) {
+			case RP_TILE_OP_REPEAT:
+				for (int32 i = 0; i < pixels; i++)
+					tile[index + i] = previous;
+				break;
+
+			case RP_TILE_OP_COPY_ABOVE:
+				if (index < width)
+					return false;
+				for (int32 i = 0; i < pixels; i++)
+					tile[index + i] = tile[index + i - width];
+				break;
+
+			case RP_TILE_OP_LITERAL:
+				if ((size_t)(end - packed) < (size_t)pixels * 4)
+					return false;
+				memcpy(tile + index, packed, pixels * 4);
+				packed += pixels * 4;
+				break;
+
+			default:
+				return false;
+		}
+
+		index += pixels;
+		previous = tile[index - 1];
+	}
+
+	return packed == end;
+}
+
+
+//	#pragma mark - BitmapTileCache
+
+
+BitmapTileCache::BitmapTileCache()
+	:
+	fSlots(NULL),
+	fBuckets(NULL),
+	fMostRecent(-1),
+	fLeastRecent(-1),
+	fBuffer(NULL),
+	fBufferSize(0),
+	fLength(0),
+	fTile(NULL),
+	fPacked(NULL)
+{
+	fSlots = (slot*)malloc(kBitmapTileSlotCount * sizeof(slot));
+	fBuckets = (int32*)malloc(kBucketCount * sizeof(int32));
+	fTile = (uint32*)malloc(kTileLength);
+	fPacked = (uint8*)malloc(kPackedLength);
+
+	if (InitCheck() == B_OK)
+		MakeEmpty();
+}
+
+
+BitmapTileCache::~BitmapTileCache()
+{
+	free(fSlots);
+	free(fBuckets);
+	free(fBuffer);
+	free(fTile);
+	free(fPacked);
+}
+
+
+status_t
+BitmapTileCache::InitCheck() const
+{
+	if (fSlots == NULL || fBuckets == NULL || fTile == NULL || fPacked == NULL)
+		return B_NO_MEMORY;
+
+	return B_OK;
+}
+
+
+/*!	Forgets all tiles, for when the client is not known to have them anymore.
+*/
+void
+BitmapTileCache::MakeEmpty()
+{
+	for (int32 i = 0; i < kBucketCount; i++)
+		fBuckets[i] = -1;
+
+	for (int32 i = 0; i < kBitmapTileSlotCount; i++) {
+		fSlots[i].next_in_bucket = -1;
+		fSlots[i].previous = i - 1;
+		fSlots[i].next = i + 1 < kBitmapTileSlotCount ? i + 1 : -1;
+		fSlots[i].used = false;
+	}
+
+	fMostRecent = 0;
+	fLeastRecent = kBitmapTileSlotCount - 1;
+}
+
+
+status_t
+BitmapTileCache::Encode(const uint8* bits, int32 bytesPerRow, int32 width,
+	int32 height, const uint8** _data, size_t* _length)
+{
+	if (InitCheck() != B_OK)
+		return B_NO_INIT;
+	if (width <= 0 || height <= 0)
+		return B_BAD_VALUE;
+
+	if (fBufferSize > kMaxKeptBufferSize) {
+		free(fBuffer);
+		fBuffer = NULL;
+		fBufferSize = 0;
+	}
+
+	fLength = 0;
+
+	for (int32 top = 0; top < height; top += kBitmapTileSize) {
+		int32 tileHeight = height - top < kBitmapTileSize
+			? height - top : kBitmapTileSize;
+
+		for (int32 left = 0; left < width; left += kBitmapTileSize) {
+			int32 tileWidth = width - left < kBitmapTileSize
+				? width - left : kBitmapTileSize;
+			size_t rawLength = tileWidth * tileHeight * 4;
+
+			if (!_MakeSpace(1 + 2 * sizeof(uint16) + rawLength)) {
+				// we cannot know what the client got of this
+				MakeEmpty();
+				return B_NO_MEMORY;
+			}
+
+			uint64 hash;
+			uint32 color;
+			if (read_tile(bits + top * bytesPerRow + left * 4, bytesPerRow,
+					tileWidth, tileHeight, fTile, hash, color)) {
+				uint8 type = RP_TILE_SOLID;
+				_Write(&type, sizeof(type));
+				_Write(&color, sizeof(color));
+				continue;
+			}
+
+			int32 index = _Find(hash);
+			if (index >= 0) {
+				_MakeMostRecent(index);
+
+				uint8 type = RP_TILE_CACHED;
+				uint16 slot = index;
+				_Write(&type, sizeof(type));
+				_Write(&slot, sizeof(slot));
+				continue;
+			}
+
+			uint16 slot = _Insert(hash);
+			size_t packedLength = pack_tile(fTile, tileWidth, tileHeight,
+				fPacked);
+			if (packedLength > 0) {
+				uint8 type = RP_TILE_PACKED;
+				uint16 length = packedLength;
+				_Write(&type, sizeof(type));
+				_Write(&slot, sizeof(slot));
+				_Write(&length, sizeof(length));
+				_Write(fPacked, packedLength);
+			} else {
+				uint8 type = RP_TILE_RAW;
+				_Write(&type, sizeof(type));
+				_Write(&slot, sizeof(slot));
+				_Write(fTile, rawLength);
+			}
+		}
+	}
+
+	*_data = fBuffer;
+	*_length = fLength;
+	return B_OK;
+}
+
+
+int32
+BitmapTileCache::_Find(uint64 hash)
+{
+	int32 index = fBuckets[hash >> kBucketShift];
+	while (index >= 0 && fSlots[index].hash != hash)
+		index = fSlots[index].next_in_bucket;
+
+	return index;
+}
+
+
+/*!	Reuses the least recently used slot for the tile with the given hash.
+*/
+int32
+BitmapTileCache::_Insert(uint64 hash)
+{
+	int32 index = fLeastRecent;
+	slot& entry = fSlots[index];
+
+	if (entry.used) {
+		int32* link = &fBuckets[entry.hash >> kBucketShift];
+		while (*link != index)
+			link = &fSlots[*link].next_in_bucket;
+		*link = entry.next_in_bucket;
+	}
+
+	int32& bucket = fBuckets[hash >> kBucketShift];
+	entry.hash = hash;
+	entry.used = true;
+	entry.next_in_bucket = bucket;
+	bucket = index;
+
+	_MakeMostRecent(index);
+	return index;
+}
+
+
+void
+BitmapTileCache::_Unlink(int32 index)
+{
+	slot& entry = fSlots[index];
+	if (entry.previous >= 0)
+		fSlots[entry.previous].next = entry.next;
+	else
+		fMostRecent = entry.next;
+
+	if (entry.next >= 0)
+		fSlots[entry.next].previous = entry.previous;
+	else
+		fLeastRecent = entry.previous;
+}
+
+
+void
+BitmapTileCache::_MakeMostRecent(int32 index)
+{
+	if (index == fMostRecent)
+		return;
+
+	_Unlink(index);
+
+	slot& entry = fSlots[index];
+	entry.previous = -1;
+	entry.next = fMostRecent;
+	fSlots[fMostRecent].previous = index;
+	fMostRecent = index;
+}
+
+
+bool
+BitmapTileCache::_MakeSpace(size_t size)
+{
+	if (fLength + size <= fBufferSize)
+		return true;
+
+	size_t newSize = fBufferSize * 2;
+	if (newSize < fLength + size)
+		newSize = fLength + size;
+
+	uint8* newBuffer = (uint8*)realloc(fBuffer, newSize);
+	if (newBuffer == NULL)
+		return false;
+
+	fBuffer = newBuffer;
+	fBufferSize = newSize;
+	return true;
+}
+
+
+void
+BitmapTileCache::_Write(const void* data, size_t size)
+{
+	memcpy(fBuffer + fLength, data, size);
+	fLength += size;
+}
+
+
+//	#pragma mark - BitmapTileStore
+
+
+BitmapTileStore::BitmapTileStore()
+{
+	fSlots = (slot*)calloc(kBitmapTileSlotCount, sizeof(slot));
+}
+
+
+BitmapTileStore::~BitmapTileStore()
+{
+	if (fSlots != NULL) {
+		for (int32 i = 0; i < kBitmapTileSlotCount; i++)
+			free(fSlots[i].pixels);
+	}
+
+	free(fSlots);
+}
+
+
+status_t
+BitmapTileStore::InitCheck() const
+{
+	return fSlots != NULL ? B_OK : B_NO_MEMORY;
+}
+
+
+void
+BitmapTileStore::MakeEmpty()
+{
+	if (fSlots == NULL)
+		return;
+
+	for (int32 i = 0; i < kBitmapTileSlotCount; i++)
+		fSlots[i].width = fSlots[i].height = 0;
+}
+
+
+/*!	Decodes the tiled bitmap \a data into \a bits, which need to be 32 bits
+	per pixel. Returns \c B_BAD_DATA if the data is broken, or refers to
+	tiles we do not have.
+*/
+status_t
+BitmapTileStore::Decode(const uint8* data, size_t length, uint8* bits,
+	int32 bytesPerRow, int32 width, int32 height)
+{
+	if (fSlots == NULL)
+		return B_NO_INIT;
+
+	const uint8* end = data + length;
+
+	for (int32 top = 0; top < height; top += kBitmapTileSize) {
+		int32 tileHeight = height - top < kBitmapTileSize
+			? height - top : kBitmapTileSize;
+
+		for (int32 left = 0; left < width; left += kBitmapTileSize) {
+			int32 tileWidth = width - left < kBitmapTileSize
+				? width - left : kBitmapTileSize;
+			uint8* tileBits = bits + top * bytesPerRow + left * 4;
+
+			if (end - data < 1)
+				return B_BAD_DATA;
+
+			uint8 type = *data++;
+			if (type == RP_TILE_SOLID) {
+				uint32 color;
+				if (end - data < (ssize_t)sizeof(color))
+					return B_BAD_DATA;
+
+				memcpy(&color, data, sizeof(color));
+				data += sizeof(color);
+
+				for (int32 y = 0; y < tileHeight; y++) {
+					uint32* row = (uint32*)(tileBits + y * bytesPerRow);
+					for (int32 x = 0; x < tileWidth; x++)
+						row[x] = color;
+				}
+				continue;
+			}
+
+			uint16 index;
+			if (end - data < (ssize_t)sizeof(index))
+				return B_BAD_DATA;
+
+			memcpy(&index, data, sizeof(index));
+			data += sizeof(index);
+			if (index >= kBitmapTileSlotCount)
+				return B_BAD_DATA;
+
+			slot& entry = fSlots[index];
+			size_t rawLength = tileWidth * tileHeight * 4;
+
+			switch (type) {
+				case RP_TILE_CACHED:
+					if (entry.width != tileWidth || entry.height != tileHeight)
+						return B_BAD_DATA;
+					break;
+
+				case RP_TILE_RAW:
+				case RP_TILE_PACKED:
+				{
+					if (entry.pixels == NULL) {
+						entry.pixels = (uint32*)malloc(kTileLength);
+						if (entry.pixels == NULL)
+							return B_NO_MEMORY;
+					}
+
+					entry.width = entry.height = 0;
+
+					if (type == RP_TILE_RAW) {
+						if ((size_t)(end - data) < rawLength)
+							return B_BAD_DATA;
+
+						memcpy(entry.pixels, data, rawLength);
+						data += rawLength;
+					} else {
+						uint16 packedLength;
+						if (end - data < (ssize_t)sizeof(packedLength))
+							return B_BAD_DATA;
+
+						memcpy(&packedLength, data, sizeof(packedLength));
+						data += sizeof(packedLength);
+
+						if (end - data < packedLength
+							|| !unpack_tile(data, packedLength, entry.pixels,
+								tileWidth, tileHeight)) {
+							return B_BAD_DATA;
+						}
+
+						data += packedLength;
+					}
+
+					entry.width = tileWidth;
+					entry.height = tileHeight;
+					break;
+				}
+
+				default:
+					return B_BAD_DATA;
+			}
+
+			for (int32 y = 0; y < tileHeight; y++) {
+				memcpy(tileBits + y * bytesPerRow,
+					entry.pixels + y * tileWidth, tileWidth * 4);
+			}
+		}
+	}
+
+	return data == end ? B_OK : B_BAD_DATA;
+}
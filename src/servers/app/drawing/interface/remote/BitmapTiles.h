@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BITMAP_TILES_H
+#define BITMAP_TILES_H
+
+#include <SupportDefs.h>
+
+
+/*!	Tiled bitmaps are sent as a sequence of tiles of kBitmapTileSize pixels
+	square (smaller at the right and bottom edge), left to right and top to
+	bottom. Each starts with its type:
+
+	RP_TILE_CACHED	uint16 slot; the tile is the one the client kept in slot.
+	RP_TILE_SOLID	uint32 color; all pixels of the tile have that value.
+	RP_TILE_RAW		uint16 slot, followed by the pixels of the tile row by row.
+	RP_TILE_PACKED	uint16 slot, uint16 length, followed by length bytes of
+					packed pixels.
+
+	The client keeps raw and packed tiles in the given slot, replacing what
+	was there before. Packed pixels are a sequence of one byte operations,
+	the upper two bits of which are one of the RP_TILE_OP_* codes, and the
+	lower six bits the number of pixels minus one. Pixels are counted left
+	to right and top to bottom within the tile; literal pixels follow their
+	operation.
+*/
+enum {
+	RP_TILE_CACHED = 0,
+	RP_TILE_SOLID,
+	RP_TILE_RAW,
+	RP_TILE_PACKED
+};
+
+enum {
+	RP_TILE_OP_REPEAT = 0,
+		// the previous pixel, which starts out as 0
+	RP_TILE_OP_COPY_ABOVE,
+		// the pixels of the row above
+	RP_TILE_OP_LITERAL
+};
+
+static const int32 kBitmapTileSize = 64;
+static const int32 kBitmapTileSlotCount = 512;
+static const int32 kBitmapTileMaxOperationCount = 64;
+
+
+/*!	The server side of tiled bitmaps: remembers which tiles the client has
+	kept in which slots, and only sends the tiles it does not have yet.
+	Not thread safe, the encoded data has to be sent in the order it was
+	encoded in.
+*/
+class BitmapTileCache {
+public:
+								BitmapTileCache();
+								~BitmapTileCache();
+
+		status_t				InitCheck() const;
+		void					MakeEmpty();
+
+		status_t				Encode(const uint8* bits, int32 bytesPerRow,
+									int32 width, int32 height,
+									const uint8** _data, size_t* _length);
+									// the data stays valid until the next
+									// call
+
+private:
+		struct slot;
+
+		int32					_Find(uint64 hash);
+		int32					_Insert(uint64 hash);
+		void					_Unlink(int32 index);
+		void					_MakeMostRecent(int32 index);
+
+		bool					_MakeSpace(size_t size);
+		void					_Write(const void* data, size_t size);
+
+		slot*					fSlots;
+		int32*					fBuckets;
+		int32					fMostRecent;
+		int32					fLeastRecent;
+
+		uint8*					fBuffer;
+		size_t					fBufferSize;
+		size_t					fLength;
+		uint32*					fTile;
+		uint8*					fPacked;
+};
+
+
+/*!	The client side of tiled bitmaps: keeps the tiles the server told it to,
+	and decodes tiled bitmaps into 32 bit pixels.
+*/
+class BitmapTileStore {
+public:
+								BitmapTileStore();
+								~BitmapTileStore();
+
+		status_t				InitCheck() const;
+		void					MakeEmpty();
+
+		status_t				Decode(const uint8* data, size_t length,
+									uint8* bits, int32 bytesPerRow,
+									int32 width, int32 height);
+
+private:
+		struct slot;
+
+		slot*					fSlots;
+};
+
+
+#endif // BITMAP_TILES_H
@@ -20,10 +20,15 @@
 #define TRACE_ERROR(x...)	debug_printf("NetSender: " x)
 
 
-NetSender::NetSender(BNetEndpoint *endpoint, StreamingRingBuffer *source)
+static const int32 kSendBufferSize = 64 * 1024;
+
+
+NetSender::NetSender(BNetEndpoint *endpoint, StreamingRingBuffer *source,
+	bigtime_t frameInterval)
 	:
 	fEndpoint(endpoint),
 	fSource(source),
+	fFrameInterval(frameInterval),
 	fSenderThread(-1),
 	fStopThread(false)
 {
@@ -52,25 +57,50 @@ NetSender::_NetworkSenderEntry(void *data)
 status_t
 NetSender::_NetworkSender()
 {
+	uint8 *buffer = (uint8 *)malloc(kSendBufferSize);
+	if (buffer == NULL) {
+		TRACE_ERROR("no memory for the send buffer\n");
+		return B_NO_MEMORY;
+	}
+
+	status_t result = B_OK;
+	bigtime_t nextSend = 0;
 	while (!fStopThread) {
-		uint8 buffer[4096];
-		int32 readSize = fSource->Read(buffer, sizeof(buffer), true);
+		int32 readSize = fSource->Read(buffer, kSendBufferSize, true);
 		if (readSize < 0) {
 			TRACE_ERROR("read failed, stopping sender thread: %s\n",
 				strerror(readSize));
-			return readSize;
+			result = readSize;
+			break;
 		}
 
+		if (fFrameInterval > 0 && readSize < kSendBufferSize
+			&& system_time() < nextSend) {
+			// We have sent something during this frame interval already, so
+			// collect what else comes in until it is over, and send it all
+			// at once. Anything after an idle time still goes out right away.
+			int32 moreSize = fSource->Read(buffer + readSize,
+				kSendBufferSize - readSize, false, nextSend);
+			if (moreSize > 0)
+				readSize += moreSize;
+		}
+
+		uint8 *data = buffer;
 		while (readSize > 0) {
-			int32 sendSize = fEndpoint->Send(buffer, readSize);
+			int32 sendSize = fEndpoint->Send(data, readSize);
 			if (sendSize < 0) {
 				TRACE_ERROR("sending data failed: %s\n", strerror(sendSize));
+				free(buffer);
 				return sendSize;
 			}
 
+			data += sendSize;
 			readSize -= sendSize;
 		}
+
+		nextSend = system_time() + fFrameInterval;
 	}
 
-	return B_OK;
+	free(buffer);
+	return result;
 }
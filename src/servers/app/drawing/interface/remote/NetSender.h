@@ -17,7 +17,8 @@ class StreamingRingBuffer;
 class NetSender {
 public:
 								NetSender(BNetEndpoint *endpoint,
-									StreamingRingBuffer *source);
+									StreamingRingBuffer *source,
+									bigtime_t frameInterval = 0);
 								~NetSender();
 
 private:
@@ -26,6 +27,7 @@ static	int32					_NetworkSenderEntry(void *data);
 
 		BNetEndpoint *			fEndpoint;
 		StreamingRingBuffer *	fSource;
+		bigtime_t				fFrameInterval;
 
 		thread_id				fSenderThread;
 		bool					fStopThread;
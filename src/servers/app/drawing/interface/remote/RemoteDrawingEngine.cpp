@@ -10,6 +10,7 @@
 #include "RemoteMessage.h"
 
 #include "BitmapDrawingEngine.h"
+#include "BitmapTiles.h"
 #include "DrawState.h"
 #include "ServerTokenSpace.h"
 
@@ -379,7 +380,9 @@ RemoteDrawingEngine::DrawBitmap(ServerBitmap* bitmap, const BRect& _bitmapRect,
 		return;
 	}
 
-	// TODO: we may want to cache/checksum bitmaps
+	if (_DrawTiledBitmap(*bitmap, bitmapRect, viewRect, options))
+		return;
+
 	RemoteMessage message(NULL, fHWInterface->SendBuffer());
 	message.Start(RP_DRAW_BITMAP);
 	message.Add(fToken);
@@ -1068,6 +1071,41 @@ RemoteDrawingEngine::_BuildBounds(BPoint* points, int32 pointCount)
 }
 
 
+/*!	Sends the bitmap as tiles, so that only the parts the client has not
+	seen yet go over the wire. Returns \c false if the bitmap needs to be
+	sent as a whole instead.
+*/
+bool
+RemoteDrawingEngine::_DrawTiledBitmap(ServerBitmap& bitmap,
+	const BRect& bitmapRect, const BRect& viewRect, uint32 options)
+{
+	if (bitmap.ColorSpace() != B_RGB32 && bitmap.ColorSpace() != B_RGBA32)
+		return false;
+
+	BitmapTileCache* cache = fHWInterface->LockTileCache();
+	if (cache == NULL)
+		return false;
+
+	RemoteMessage message(NULL, fHWInterface->SendBuffer());
+	message.Start(RP_DRAW_BITMAP_TILED);
+	message.Add(fToken);
+	message.Add(bitmapRect);
+	message.Add(viewRect);
+	message.Add(options);
+
+	bool added = message.AddTiledBitmap(bitmap, *cache) == B_OK;
+	if (added) {
+		// the client has to get the tiles in the order the cache gave out
+		// their slots
+		message.Flush();
+	} else
+		message.Cancel();
+
+	fHWInterface->UnlockTileCache();
+	return added;
+}
+
+
 status_t
 RemoteDrawingEngine::_ExtractBitmapRegions(ServerBitmap& bitmap, uint32 options,
 	const BRect& bitmapRect, const BRect& viewRect, double xScale,
@@ -160,6 +160,9 @@ private:
 									const BRect& viewRect, double xScale,
 									double yScale, BRegion& region,
 									UtilityBitmap**& bitmaps);
+			bool				_DrawTiledBitmap(ServerBitmap& bitmap,
+									const BRect& bitmapRect,
+									const BRect& viewRect, uint32 options);
 
 			RemoteHWInterface*	fHWInterface;
 			int32				fToken;
@@ -11,6 +11,7 @@
 #include "RemoteEventStream.h"
 #include "RemoteMessage.h"
 
+#include "BitmapTiles.h"
 #include "NetReceiver.h"
 #include "NetSender.h"
 #include "StreamingRingBuffer.h"
@@ -29,6 +30,9 @@
 #define TRACE_ERROR(x...)		debug_printf("RemoteHWInterface: " x)
 
 
+static const bigtime_t kFrameInterval = 1000000 / 60;
+
+
 struct callback_info {
 	uint32				token;
 	RemoteHWInterface::CallbackFunction	callback;
@@ -42,6 +46,7 @@ RemoteHWInterface::RemoteHWInterface(const char* target)
 	fTarget(target),
 	fIsConnected(false),
 	fProtocolVersion(100),
+	fClientCapabilities(0),
 	fConnectionSpeed(0),
 	fListenPort(10901),
 	fListenEndpoint(NULL),
@@ -51,7 +56,9 @@ RemoteHWInterface::RemoteHWInterface(const char* target)
 	fReceiver(NULL),
 	fEventThread(-1),
 	fEventStream(NULL),
-	fCallbackLocker("callback locker")
+	fCallbackLocker("callback locker"),
+	fTileCacheLocker("tile cache locker"),
+	fTileCache(NULL)
 {
 	memset(&fFallbackMode, 0, sizeof(fFallbackMode));
 	fFallbackMode.virtual_width = 640;
@@ -96,6 +103,13 @@ RemoteHWInterface::RemoteHWInterface(const char* target)
 	if (fInitStatus != B_OK)
 		return;
 
+	fTileCache = new(std::nothrow) BitmapTileCache();
+	if (fTileCache != NULL && fTileCache->InitCheck() != B_OK) {
+		// tiled bitmaps are optional
+		delete fTileCache;
+		fTileCache = NULL;
+	}
+
 	fReceiver = new(std::nothrow) NetReceiver(fListenEndpoint, fReceiveBuffer,
 		_NewConnectionCallback, this);
 	if (fReceiver == NULL) {
@@ -128,6 +142,8 @@ RemoteHWInterface::~RemoteHWInterface()
 	delete fSendBuffer;
 	delete fSender;
 
+	delete fTileCache;
+
 	delete fListenEndpoint;
 
 	delete fEventStream;
@@ -198,6 +214,32 @@ RemoteHWInterface::RemoveCallback(uint32 token)
 }
 
 
+/*!	Returns the tile cache locked, if the client supports tiled bitmaps. The
+	cache has to stay locked until the message using it has been flushed.
+*/
+BitmapTileCache*
+RemoteHWInterface::LockTileCache()
+{
+	if (!fTileCacheLocker.Lock())
+		return NULL;
+
+	if (fTileCache == NULL
+		|| (fClientCapabilities & RP_CAPABILITY_TILED_BITMAPS) == 0) {
+		fTileCacheLocker.Unlock();
+		return NULL;
+	}
+
+	return fTileCache;
+}
+
+
+void
+RemoteHWInterface::UnlockTileCache()
+{
+	fTileCacheLocker.Unlock();
+}
+
+
 callback_info*
 RemoteHWInterface::_FindCallback(uint32 token)
 {
@@ -252,6 +294,17 @@ RemoteHWInterface::_EventThread()
 		switch (code) {
 			case RP_INIT_CONNECTION:
 			{
+				// older clients do not send their capabilities
+				uint32 capabilities = 0;
+				if (message.DataLeft() >= sizeof(capabilities))
+					message.Read(capabilities);
+
+				fTileCacheLocker.Lock();
+				if (fTileCache != NULL)
+					fTileCache->MakeEmpty();
+				fClientCapabilities = capabilities;
+				fTileCacheLocker.Unlock();
+
 				RemoteMessage reply(NULL, fSendBuffer);
 				reply.Start(RP_INIT_CONNECTION);
 				status_t result = reply.Flush();
@@ -330,13 +383,19 @@ RemoteHWInterface::_NewConnection(BNetEndpoint &endpoint)
 		fSender = NULL;
 	}
 
+	// the new client has none of our tiles, and may not know about them
+	fTileCacheLocker.Lock();
+	fClientCapabilities = 0;
+	fTileCacheLocker.Unlock();
+
 	fSendBuffer->MakeEmpty();
 
 	BNetEndpoint *sendEndpoint = new(std::nothrow) BNetEndpoint(endpoint);
 	if (sendEndpoint == NULL)
 		return B_NO_MEMORY;
 
-	fSender = new(std::nothrow) NetSender(sendEndpoint, fSendBuffer);
+	fSender = new(std::nothrow) NetSender(sendEndpoint, fSendBuffer,
+		kFrameInterval);
 	if (fSender == NULL) {
 		delete sendEndpoint;
 		return B_NO_MEMORY;
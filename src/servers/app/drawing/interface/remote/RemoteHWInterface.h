@@ -13,6 +13,7 @@
 #include <Locker.h>
 #include <ObjectList.h>
 
+class BitmapTileCache;
 class BNetEndpoint;
 class StreamingRingBuffer;
 class NetSender;
@@ -83,6 +84,9 @@ virtual	status_t					CopyBackToFront(const BRect& frame);
 		StreamingRingBuffer*		ReceiveBuffer() { return fReceiveBuffer; }
 		StreamingRingBuffer*		SendBuffer() { return fSendBuffer; }
 
+		BitmapTileCache*			LockTileCache();
+		void						UnlockTileCache();
+
 typedef bool (*CallbackFunction)(void* cookie, RemoteMessage& message);
 
 		status_t					AddCallback(uint32 token,
@@ -110,6 +114,7 @@ static	status_t					_NewConnectionCallback(void *cookie,
 		status_t					fInitStatus;
 		bool						fIsConnected;
 		uint32						fProtocolVersion;
+		uint32						fClientCapabilities;
 		uint32						fConnectionSpeed;
 		display_mode				fFallbackMode;
 		display_mode				fCurrentMode;
@@ -128,6 +133,9 @@ static	status_t					_NewConnectionCallback(void *cookie,
 
 		BLocker						fCallbackLocker;
 		BObjectList<callback_info>	fCallbacks;
+
+		BLocker						fTileCacheLocker;
+		BitmapTileCache*			fTileCache;
 };
 
 #endif // REMOTE_HW_INTERFACE_H
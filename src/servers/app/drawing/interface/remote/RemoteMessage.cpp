@@ -8,6 +8,8 @@
 
 #include "RemoteMessage.h"
 
+#include "BitmapTiles.h"
+
 #ifndef CLIENT_COMPILE
 #include "DrawState.h"
 #include "ServerBitmap.h"
@@ -111,6 +113,39 @@ RemoteMessage::AddBitmap(const ServerBitmap& bitmap, bool minimal)
 }
 
 
+/*!	Adds the 32 bit  bitmap as tiles, leaving out those the client already
+	has according to  cache. The message has to be flushed before the
+	cache is used for the next one.
+*/
+status_t
+RemoteMessage::AddTiledBitmap(const ServerBitmap& bitmap,
+	BitmapTileCache& cache)
+{
+	const uint8* data;
+	size_t length;
+	status_t result = cache.Encode(bitmap.Bits(), bitmap.BytesPerRow(),
+		bitmap.Width(), bitmap.Height(), &data, &length);
+	if (result != B_OK)
+		return result;
+
+	Add(bitmap.Width());
+	Add(bitmap.Height());
+	Add(bitmap.ColorSpace());
+	Add(bitmap.Flags());
+	Add((uint32)length);
+
+	if (!_MakeSpace(length)) {
+		cache.MakeEmpty();
+		return B_NO_MEMORY;
+	}
+
+	memcpy(fBuffer + fWriteIndex, data, length);
+	fWriteIndex += length;
+	fAvailable -= length;
+	return B_OK;
+}
+
+
 void
 RemoteMessage::AddFont(const ServerFont& font)
 {
@@ -382,6 +417,67 @@ RemoteMessage::ReadBitmap(BBitmap** _bitmap, bool minimal,
 }
 
 
+status_t
+RemoteMessage::ReadTiledBitmap(BBitmap** _bitmap, BitmapTileStore& store)
+{
+	int32 width, height;
+	color_space colorSpace;
+	uint32 flags, length;
+
+	Read(width);
+	Read(height);
+	Read(colorSpace);
+	Read(flags);
+	status_t result = Read(length);
+	if (result != B_OK)
+		return result;
+
+	if (length > fDataLeft || width <= 0 || height <= 0
+		|| (colorSpace != B_RGB32 && colorSpace != B_RGBA32)) {
+		return B_ERROR;
+	}
+
+	uint8* data = (uint8*)malloc(length);
+	if (data == NULL)
+		return B_NO_MEMORY;
+
+	int32 readSize = fSource->Read(data, length);
+	if ((uint32)readSize != length) {
+		free(data);
+		return readSize < 0 ? readSize : B_ERROR;
+	}
+
+	fDataLeft -= readSize;
+
+#ifndef CLIENT_COMPILE
+	flags = B_BITMAP_NO_SERVER_LINK;
+#endif
+
+	BBitmap* bitmap = new(std::nothrow) BBitmap(
+		BRect(0, 0, width - 1, height - 1), flags, colorSpace);
+	if (bitmap == NULL) {
+		free(data);
+		return B_NO_MEMORY;
+	}
+
+	result = bitmap->InitCheck();
+	if (result == B_OK) {
+		result = store.Decode(data, length, (uint8*)bitmap->Bits(),
+			bitmap->BytesPerRow(), width, height);
+	}
+
+	free(data);
+
+	if (result != B_OK) {
+		delete bitmap;
+		return result;
+	}
+
+	*_bitmap = bitmap;
+	return B_OK;
+}
+
+
 status_t
 RemoteMessage::ReadFontState(BFont& font)
 {
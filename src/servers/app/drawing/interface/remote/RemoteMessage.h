@@ -24,6 +24,8 @@
 #include <string.h>
 
 class BBitmap;
+class BitmapTileCache;
+class BitmapTileStore;
 class BFont;
 class BGradient;
 class BView;
@@ -65,6 +67,7 @@ enum {
 	RP_INVERT_RECT,
 	RP_DRAW_BITMAP,
 	RP_DRAW_BITMAP_RECTS,
+	RP_DRAW_BITMAP_TILED,
 
 	RP_STROKE_ARC = 80,
 	RP_STROKE_BEZIER,
@@ -128,6 +131,11 @@ enum {
 	RP_MODIFIERS_CHANGED
 };
 
+// optional features a client announces with RP_INIT_CONNECTION
+enum {
+	RP_CAPABILITY_TILED_BITMAPS = 0x01
+};
+
 
 class RemoteMessage {
 public:
@@ -154,6 +162,8 @@ public:
 #ifndef CLIENT_COMPILE
 		void					AddBitmap(const ServerBitmap& bitmap,
 									bool minimal = false);
+		status_t				AddTiledBitmap(const ServerBitmap& bitmap,
+									BitmapTileCache& cache);
 		void					AddFont(const ServerFont& font);
 		void					AddPattern(const Pattern& pattern);
 		void					AddDrawState(const DrawState& drawState);
@@ -180,6 +190,8 @@ public:
 									bool minimal = false,
 									color_space colorSpace = B_RGB32,
 									uint32 flags = 0);
+		status_t				ReadTiledBitmap(BBitmap** _bitmap,
+									BitmapTileStore& store);
 		status_t				ReadGradient(BGradient** _gradient);
 		status_t				ReadTransform(BAffineTransform& transform);
 		status_t				ReadArrayLine(BPoint& startPoint,
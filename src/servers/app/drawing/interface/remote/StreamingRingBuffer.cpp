@@ -74,7 +74,8 @@ StreamingRingBuffer::InitCheck()
 
 
 int32
-StreamingRingBuffer::Read(void *buffer, size_t length, bool onlyBlockOnNoData)
+StreamingRingBuffer::Read(void *buffer, size_t length, bool onlyBlockOnNoData,
+	bigtime_t deadline)
 {
 	BAutolock readerLock(fReaderLocker);
 	if (!readerLock.IsLocked())
@@ -99,11 +100,28 @@ StreamingRingBuffer::Read(void *buffer, size_t length, bool onlyBlockOnNoData)
 			status_t result;
 			do {
 				TRACE("waiting in reader\n");
-				result = acquire_sem(fReaderNotifier);
+				result = acquire_sem_etc(fReaderNotifier, 1,
+					deadline != B_INFINITE_TIMEOUT ? B_ABSOLUTE_TIMEOUT : 0,
+					deadline);
 				TRACE("done waiting in reader with status: %#" B_PRIx32 "\n",
 					result);
 			} while (result == B_INTERRUPTED);
 
+			if (result == B_TIMED_OUT) {
+				// return what we have got so far, a wake up that may still
+				// come in is harmless, as we check for data again anyway
+				if (!dataLock.Lock())
+					return B_ERROR;
+
+				fReaderWaiting = false;
+				if (fCancelRead) {
+					fCancelRead = false;
+					return B_CANCELED;
+				}
+
+				return readSize > 0 ? readSize : B_TIMED_OUT;
+			}
+
 			if (result != B_OK)
 				return result;
 
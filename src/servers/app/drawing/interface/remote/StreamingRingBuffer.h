@@ -21,7 +21,8 @@ public:
 
 		// blocking read and write
 		int32					Read(void *buffer, size_t length,
-									bool onlyBlockOnNoData = false);
+									bool onlyBlockOnNoData = false,
+									bigtime_t deadline = B_INFINITE_TIMEOUT);
 		status_t				Write(const void *buffer, size_t length);
 
 		void					MakeEmpty();
@@ -26,103 +26,288 @@
 
 #include "FontCacheEntry.h"
 
+#include <limits.h>
 #include <string.h>
 
 #include <new>
 
-#include <Autolock.h>
-
 #include <agg_array.h>
 #include <utf8_functions.h>
-#include <util/OpenHashTable.h>
 
 #include "GlobalSubpixelSettings.h"
 
 
-BLocker FontCacheEntry::sUsageUpdateLock("FontCacheEntry usage lock");
+template<typename Type> static inline Type*
+atomic_pointer_get(Type* const* pointer)
+{
+#if LONG_MAX == INT_MAX
+	return (Type*)atomic_get((int32*)pointer);
+#else
+	return (Type*)atomic_get64((int64*)pointer);
+#endif
+}
+
+
+template<typename Type> static inline void
+atomic_pointer_set(Type** pointer, Type* value)
+{
+#if LONG_MAX == INT_MAX
+	atomic_set((int32*)pointer, (int32)value);
+#else
+	atomic_set64((int64*)pointer, (int64)value);
+#endif
+}
+
 
+/*!	Open addressed hash table of the cached glyphs, which can be searched
+	without holding any lock.
 
+	Only one thread at a time adds glyphs (the one holding the write lock of
+	the entry). A glyph is completely set up before it is published by
+	storing its pointer in the table, and it is never changed nor deleted
+	afterwards, until the whole entry goes away. When the table grows, a new
+	one is published and the old one is kept around as well, since readers
+	may still be searching it; they will at worst not find the newest
+	glyphs, and then look again with the write lock held.
+*/
 class FontCacheEntry::GlyphCachePool {
 	// This class needs to be defined before any inline functions, as otherwise
 	// gcc2 will barf in debug mode.
-	struct GlyphHashTableDefinition {
-		typedef uint32		KeyType;
-		typedef	GlyphCache	ValueType;
+	struct GlyphTable {
+		uint32			size;
+		GlyphTable*		retired;
+		GlyphCache**	glyphs;
+	};
 
-		size_t HashKey(uint32 key) const
-		{
-			return key;
-		}
+	static const uint32 kInitialTableSize = 128;
 
-		size_t Hash(GlyphCache* value) const
-		{
-			return value->glyph_index;
-		}
-
-		bool Compare(uint32 key, GlyphCache* value) const
-		{
-			return value->glyph_index == key;
-		}
-
-		GlyphCache*& GetLink(GlyphCache* value) const
-		{
-			return value->hash_link;
-		}
-	};
 public:
 	GlyphCachePool()
+		:
+		fTable(NULL),
+		fCount(0)
 	{
 	}
 
 	~GlyphCachePool()
 	{
-		GlyphCache* glyph = fGlyphTable.Clear(true);
-		while (glyph != NULL) {
-			GlyphCache* next = glyph->hash_link;
-			delete glyph;
-			glyph = next;
+		if (fTable == NULL)
+			return;
+
+		for (uint32 i = 0; i < fTable->size; i++)
+			delete fTable->glyphs[i];
+
+		GlyphTable* table = fTable;
+		while (table != NULL) {
+			GlyphTable* retired = table->retired;
+			_DeleteTable(table);
+			table = retired;
 		}
 	}
 
 	status_t Init()
 	{
-		return fGlyphTable.Init();
+		fTable = _CreateTable(kInitialTableSize);
+		return fTable != NULL ? B_OK : B_NO_MEMORY;
 	}
 
-	const GlyphCache* FindGlyph(uint32 glyphIndex) const
+	const GlyphCache* FindGlyph(uint32 glyphCode) const
 	{
-		return fGlyphTable.Lookup(glyphIndex);
+		const GlyphTable* table = atomic_pointer_get(&fTable);
+		uint32 mask = table->size - 1;
+
+		// The table is never more than half full, so there is always an
+		// empty slot to end the search.
+		for (uint32 i = glyphCode & mask;; i = (i + 1) & mask) {
+			const GlyphCache* glyph = atomic_pointer_get(&table->glyphs[i]);
+			if (glyph == NULL || glyph->glyph_index == glyphCode)
+				return glyph;
+		}
 	}
 
-	GlyphCache* CacheGlyph(uint32 glyphIndex,
+	GlyphCache* AllocateGlyph(uint32 glyphCode,
 		uint32 dataSize, glyph_data_type dataType, const agg::rect_i& bounds,
 		float advanceX, float advanceY, float preciseAdvanceX,
 		float preciseAdvanceY, float insetLeft, float insetRight)
 	{
-		GlyphCache* glyph = fGlyphTable.Lookup(glyphIndex);
-		if (glyph != NULL)
-			return NULL;
-
-		glyph = new(std::nothrow) GlyphCache(glyphIndex, dataSize, dataType,
-			bounds, advanceX, advanceY, preciseAdvanceX, preciseAdvanceY,
-			insetLeft, insetRight);
+		GlyphCache* glyph = new(std::nothrow) GlyphCache(glyphCode, dataSize,
+			dataType, bounds, advanceX, advanceY, preciseAdvanceX,
+			preciseAdvanceY, insetLeft, insetRight);
 		if (glyph == NULL || glyph->data == NULL) {
 			delete glyph;
 			return NULL;
 		}
 
-		// TODO: The HashTable grows without bounds. We should cleanup
+		return glyph;
+	}
+
+	bool PublishGlyph(GlyphCache* glyph)
+	{
+		// TODO: The table grows without bounds. We should cleanup
 		// older entries from time to time.
 
-		fGlyphTable.Insert(glyph);
+		if ((fCount + 1) * 2 > fTable->size && !_Grow()) {
+			delete glyph;
+			return false;
+		}
 
-		return glyph;
+		_Insert(fTable, glyph);
+		fCount++;
+		return true;
+	}
+
+private:
+	static GlyphTable* _CreateTable(uint32 size)
+	{
+		GlyphTable* table = new(std::nothrow) GlyphTable;
+		if (table == NULL)
+			return NULL;
+
+		table->glyphs = new(std::nothrow) GlyphCache*[size];
+		if (table->glyphs == NULL) {
+			delete table;
+			return NULL;
+		}
+
+		memset(table->glyphs, 0, sizeof(GlyphCache*) * size);
+		table->size = size;
+		table->retired = NULL;
+		return table;
+	}
+
+	static void _DeleteTable(GlyphTable* table)
+	{
+		delete[] table->glyphs;
+		delete table;
+	}
+
+	static void _Insert(GlyphTable* table, GlyphCache* glyph)
+	{
+		uint32 mask = table->size - 1;
+		uint32 i = glyph->glyph_index & mask;
+		while (table->glyphs[i] != NULL)
+			i = (i + 1) & mask;
+
+		atomic_pointer_set(&table->glyphs[i], glyph);
+	}
+
+	bool _Grow()
+	{
+		GlyphTable* table = _CreateTable(fTable->size * 2);
+		if (table == NULL)
+			return false;
+
+		for (uint32 i = 0; i < fTable->size; i++) {
+			if (fTable->glyphs[i] != NULL)
+				_Insert(table, fTable->glyphs[i]);
+		}
+
+		table->retired = fTable;
+		atomic_pointer_set(&fTable, table);
+		return true;
 	}
 
 private:
-	typedef BOpenHashTable<GlyphHashTableDefinition> GlyphTable;
+	GlyphTable*	fTable;
+	uint32		fCount;
+};
+
+
+/*!	Packs the coverage bitmaps of the glyphs of an entry into a few large
+	pages, row by row ("shelves"), instead of allocating each of them on its
+	own. The pages are only freed with the atlas.
+*/
+class FontCacheEntry::GlyphAtlas {
+	struct Page {
+		Page*	next;
+
+		uint8* Bits()
+		{
+			return (uint8*)(this + 1);
+		}
+	};
+
+	static const uint32 kPageWidth = 256;
+	static const uint32 kPageHeight = 64;
 
-	GlyphTable	fGlyphTable;
+public:
+	GlyphAtlas()
+		:
+		fPages(NULL),
+		fShelfX(0),
+		fShelfTop(kPageHeight),
+		fShelfHeight(0)
+	{
+	}
+
+	~GlyphAtlas()
+	{
+		while (fPages != NULL) {
+			Page* next = fPages->next;
+			free(fPages);
+			fPages = next;
+		}
+	}
+
+	uint8* Allocate(uint32 width, uint32 height, uint32& _bytesPerRow)
+	{
+		if (width > kPageWidth || height > kPageHeight) {
+			// give huge glyphs a page of their own, behind the current one
+			Page* page = _AllocatePage(width * height);
+			if (page == NULL)
+				return NULL;
+
+			if (fPages != NULL) {
+				page->next = fPages->next;
+				fPages->next = page;
+			} else {
+				page->next = NULL;
+				fPages = page;
+				fShelfTop = kPageHeight;
+			}
+
+			_bytesPerRow = width;
+			return page->Bits();
+		}
+
+		if (fShelfX + width > kPageWidth) {
+			fShelfTop += fShelfHeight;
+			fShelfX = 0;
+			fShelfHeight = 0;
+		}
+
+		if (fShelfTop + height > kPageHeight) {
+			Page* page = _AllocatePage(kPageWidth * kPageHeight);
+			if (page == NULL)
+				return NULL;
+
+			page->next = fPages;
+			fPages = page;
+			fShelfX = 0;
+			fShelfTop = 0;
+			fShelfHeight = 0;
+		}
+
+		uint8* bits = fPages->Bits() + fShelfTop * kPageWidth + fShelfX;
+		fShelfX += width;
+		if (height > fShelfHeight)
+			fShelfHeight = height;
+
+		_bytesPerRow = kPageWidth;
+		return bits;
+	}
+
+private:
+	static Page* _AllocatePage(size_t size)
+	{
+		return (Page*)malloc(sizeof(Page) + size);
+	}
+
+private:
+	Page*		fPages;
+	uint32		fShelfX;
+	uint32		fShelfTop;
+	uint32		fShelfHeight;
 };
 
 
@@ -133,6 +318,7 @@ FontCacheEntry::FontCacheEntry()
 	:
 	MultiLocker("FontCacheEntry lock"),
 	fGlyphCache(new(std::nothrow) GlyphCachePool()),
+	fGlyphAtlas(new(std::nothrow) GlyphAtlas()),
 	fEngine(),
 	fLastUsedTime(LONGLONG_MIN),
 	fUseCounter(0)
@@ -144,6 +330,7 @@ FontCacheEntry::~FontCacheEntry()
 {
 //printf("~FontCacheEntry()\n");
 	delete fGlyphCache;
+	delete fGlyphAtlas;
 }
 
 
@@ -261,7 +448,7 @@ render_as_zero_width(uint32 glyphCode)
 const GlyphCache*
 FontCacheEntry::CachedGlyph(uint32 glyphCode)
 {
-	// Only requires a read lock.
+	// Does not require any lock, see GlyphCachePool.
 	return fGlyphCache->FindGlyph(glyphCode);
 }
 
@@ -294,8 +481,14 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 	if (glyphIndex == 0) {
 		if (render_as_zero_width(glyphCode)) {
 			// cache and return a zero width glyph
-			return fGlyphCache->CacheGlyph(glyphCode, 0, glyph_data_invalid,
-				agg::rect_i(0, 0, -1, -1), 0, 0, 0, 0, 0, 0);
+			GlyphCache* zeroWidthGlyph = fGlyphCache->AllocateGlyph(glyphCode,
+				0, glyph_data_invalid, agg::rect_i(0, 0, -1, -1), 0, 0, 0, 0,
+				0, 0);
+			if (zeroWidthGlyph == NULL
+				|| !fGlyphCache->PublishGlyph(zeroWidthGlyph)) {
+				return NULL;
+			}
+			return zeroWidthGlyph;
 		}
 
 		// reset to our engine
@@ -309,18 +502,25 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 		}
 	}
 
-	if (engine->PrepareGlyph(glyphIndex)) {
-		glyph = fGlyphCache->CacheGlyph(glyphCode,
-			engine->DataSize(), engine->DataType(), engine->Bounds(),
-			engine->AdvanceX(), engine->AdvanceY(),
-			engine->PreciseAdvanceX(), engine->PreciseAdvanceY(),
-			engine->InsetLeft(), engine->InsetRight());
+	if (!engine->PrepareGlyph(glyphIndex))
+		return NULL;
 
-		if (glyph != NULL)
-			engine->WriteGlyphTo(glyph->data);
-	}
+	GlyphCache* newGlyph = fGlyphCache->AllocateGlyph(glyphCode,
+		engine->DataSize(), engine->DataType(), engine->Bounds(),
+		engine->AdvanceX(), engine->AdvanceY(),
+		engine->PreciseAdvanceX(), engine->PreciseAdvanceY(),
+		engine->InsetLeft(), engine->InsetRight());
+	if (newGlyph == NULL)
+		return NULL;
 
-	return glyph;
+	// the glyph has to be complete before it is published to the readers
+	engine->WriteGlyphTo(newGlyph->data);
+	_AddToAtlas(newGlyph);
+
+	if (!fGlyphCache->PublishGlyph(newGlyph))
+		return NULL;
+
+	return newGlyph;
 }
 
 
@@ -384,15 +584,82 @@ FontCacheEntry::GenerateSignature(char* signature, size_t signatureSize,
 void
 FontCacheEntry::UpdateUsage()
 {
-	// this is a static lock to prevent usage of too many semaphores,
-	// but on the other hand, it is not so nice to be using a lock
-	// here at all
-	// the hope is that the time is so short to hold this lock, that
-	// there is not much contention
-	BAutolock _(sUsageUpdateLock);
-
-	fLastUsedTime = system_time();
-	fUseCounter++;
+	// This is called for every use of the entry, by all threads drawing
+	// text, so it must not serialize them on a lock.
+	atomic_set64(&fLastUsedTime, system_time());
+	atomic_add64(&fUseCounter, 1);
+}
+
+
+bigtime_t
+FontCacheEntry::LastUsed() const
+{
+	return atomic_get64(const_cast<bigtime_t*>(&fLastUsedTime));
+}
+
+
+uint64
+FontCacheEntry::UsedCount() const
+{
+	return atomic_get64(const_cast<int64*>(&fUseCounter));
+}
+
+
+/*!	Copies the coverage of a gray8 or subpix glyph into the atlas, so that
+	it can be blended row by row, without deserializing its scanlines on
+	every use. Glyphs that don't fit are still drawn from their scanlines.
+*/
+void
+FontCacheEntry::_AddToAtlas(GlyphCache* glyph)
+{
+	if (fGlyphAtlas == NULL
+		|| (glyph->data_type != glyph_data_gray8
+			&& glyph->data_type != glyph_data_subpix)
+		|| !glyph->bounds.is_valid()) {
+		return;
+	}
+
+	int32 bytesPerPixel = glyph->data_type == glyph_data_subpix ? 3 : 1;
+	int32 width = (glyph->bounds.x2 - glyph->bounds.x1 + 1) * bytesPerPixel;
+	int32 height = glyph->bounds.y2 - glyph->bounds.y1 + 1;
+
+	uint32 bytesPerRow;
+	uint8* bits = fGlyphAtlas->Allocate(width, height, bytesPerRow);
+	if (bits == NULL)
+		return;
+
+	for (int32 y = 0; y < height; y++)
+		memset(bits + y * bytesPerRow, 0, width);
+
+	// Both kinds of glyphs are stored in the same format, subpix spans
+	// just have three covers per pixel.
+	GlyphGray8Adapter adapter;
+	GlyphGray8Scanline scanline;
+	adapter.init(glyph->data, glyph->data_size, 0, 0);
+	if (adapter.rewind_scanlines()) {
+		while (adapter.sweep_scanline(scanline)) {
+			int32 y = scanline.y() - glyph->bounds.y1;
+			if (y < 0 || y >= height)
+				continue;
+
+			uint8* row = bits + y * bytesPerRow;
+			GlyphGray8Scanline::const_iterator span = scanline.begin();
+			for (uint32 count = scanline.num_spans(); count > 0; count--) {
+				int32 x = (span->x - glyph->bounds.x1) * bytesPerPixel;
+				int32 length = span->len < 0 ? -span->len : span->len;
+				if (x >= 0 && x + length <= width) {
+					if (span->len < 0)
+						memset(row + x, *span->covers, length);
+					else
+						memcpy(row + x, span->covers, length);
+				}
+				++span;
+			}
+		}
+	}
+
+	glyph->atlas_bits = bits;
+	glyph->atlas_bytes_per_row = bytesPerRow;
 }
 
 
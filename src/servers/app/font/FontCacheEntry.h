@@ -27,8 +27,6 @@
 #define FONT_CACHE_ENTRY_H
 
 
-#include <Locker.h>
-
 #include <agg_conv_curve.h>
 #include <agg_conv_contour.h>
 #include <agg_conv_transform.h>
@@ -57,7 +55,8 @@ struct GlyphCache {
 		precise_advance_y(preciseAdvanceY),
 		inset_left(insetLeft),
 		inset_right(insetRight),
-		hash_link(NULL)
+		atlas_bits(NULL),
+		atlas_bytes_per_row(0)
 	{
 	}
 
@@ -78,7 +77,12 @@ struct GlyphCache {
 	float			inset_left;
 	float			inset_right;
 
-	GlyphCache*		hash_link;
+	// The coverage of gray8 and subpix glyphs as a bitmap in the glyph
+	// atlas of the entry, with one or three bytes per pixel and the top left
+	// pixel at "bounds.x1", "bounds.y1". NULL if the glyph is not in the
+	// atlas.
+	const uint8*	atlas_bits;
+	uint32			atlas_bytes_per_row;
 };
 
 class FontCache;
@@ -129,10 +133,8 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 
 	// private to FontCache class:
 			void				UpdateUsage();
-			bigtime_t			LastUsed() const
-									{ return fLastUsedTime; }
-			uint64				UsedCount() const
-									{ return fUseCounter; }
+			bigtime_t			LastUsed() const;
+			uint64				UsedCount() const;
 
  private:
 								FontCacheEntry(const FontCacheEntry&);
@@ -141,14 +143,17 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 	static	glyph_rendering		_RenderTypeFor(const ServerFont& font,
 									bool forceVector);
 
+			void				_AddToAtlas(GlyphCache* glyph);
+
 			class GlyphCachePool;
+			class GlyphAtlas;
 
 			GlyphCachePool*		fGlyphCache;
+			GlyphAtlas*			fGlyphAtlas;
 			FontEngine			fEngine;
 
-	static	BLocker				sUsageUpdateLock;
 			bigtime_t			fLastUsedTime;
-			uint64				fUseCounter;
+			int64				fUseCounter;
 };
 
 #endif // FONT_CACHE_ENTRY_H
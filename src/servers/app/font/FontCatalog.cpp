@@ -0,0 +1,371 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Caches the families and styles of the font files on disk, so that they
+	don't have to be opened at startup.
+*/
+
+
+#include "FontCatalog.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <new>
+
+#include <Directory.h>
+#include <File.h>
+#include <FindDirectory.h>
+#include <Message.h>
+#include <Path.h>
+
+
+//#define TRACE_FONT_CATALOG
+#ifdef TRACE_FONT_CATALOG
+#	define FTRACE(x) printf x
+#else
+#	define FTRACE(x) ;
+#endif
+
+
+static const uint32 kMsgFontCatalog = 'fcat';
+static const int32 kCatalogVersion = 1;
+
+
+struct FontCatalog::entry {
+	ino_t			node;
+	bigtime_t		modified;
+	off_t			size;
+	font_style_info	info;
+	bool			used;
+		// looked up or added since the catalog was loaded
+
+	bool Matches(const struct stat& stat) const
+	{
+		return node == stat.st_ino && modified == modification_time(stat)
+			&& size == stat.st_size;
+	}
+
+	void SetTo(const struct stat& stat)
+	{
+		node = stat.st_ino;
+		modified = modification_time(stat);
+		size = stat.st_size;
+	}
+
+	static bigtime_t modification_time(const struct stat& stat)
+	{
+		return (bigtime_t)stat.st_mtim.tv_sec * 1000000
+			+ stat.st_mtim.tv_nsec / 1000;
+	}
+};
+
+
+FontCatalog::FontCatalog()
+	:
+	fDirty(false)
+{
+}
+
+
+FontCatalog::~FontCatalog()
+{
+	_MakeEmpty();
+}
+
+
+/*!	Reads the catalog from disk, replacing all current entries. A missing or
+	outdated catalog is not an error, it just leaves the catalog empty.
+*/
+status_t
+FontCatalog::Load()
+{
+	_MakeEmpty();
+
+	BPath path;
+	status_t status = _GetPath(path, false);
+	if (status != B_OK)
+		return status;
+
+	BFile file;
+	status = file.SetTo(path.Path(), B_READ_ONLY);
+	if (status != B_OK)
+		return status == B_ENTRY_NOT_FOUND ? B_OK : status;
+
+	BMessage catalog;
+	status = catalog.Unflatten(&file);
+	if (status != B_OK)
+		return status;
+
+	int32 version;
+	if (catalog.what != kMsgFontCatalog
+		|| catalog.FindInt32("version", &version) != B_OK
+		|| version != kCatalogVersion) {
+		return B_OK;
+	}
+
+	const char* fontPath;
+	for (int32 i = 0; catalog.FindString("path", i, &fontPath) == B_OK;
+			i++) {
+		entry* fontEntry = new(std::nothrow) entry;
+		if (fontEntry == NULL)
+			return B_NO_MEMORY;
+
+		font_style_info& info = fontEntry->info;
+		int32 glyphCount;
+		int32 charMapCount;
+		if (catalog.FindInt64("node", i, &fontEntry->node) != B_OK
+			|| catalog.FindInt64("modified", i, &fontEntry->modified) != B_OK
+			|| catalog.FindInt64("size", i, &fontEntry->size) != B_OK
+			|| catalog.FindString("family", i, &info.family) != B_OK
+			|| catalog.FindString("style", i, &info.style) != B_OK
+			|| catalog.FindInt32("flags", i, (int32*)&info.flags) != B_OK
+			|| catalog.FindInt32("tuned", i, &info.tuned_count) != B_OK
+			|| catalog.FindInt32("glyphs", i, &glyphCount) != B_OK
+			|| catalog.FindInt32("char maps", i, &charMapCount) != B_OK
+			|| catalog.FindFloat("ascent", i, &info.height.ascent) != B_OK
+			|| catalog.FindFloat("descent", i, &info.height.descent) != B_OK
+			|| catalog.FindFloat("leading", i, &info.height.leading)
+				!= B_OK) {
+			delete fontEntry;
+			_MakeEmpty();
+			return B_BAD_DATA;
+		}
+
+		info.glyph_count = glyphCount;
+		info.char_map_count = charMapCount;
+		fontEntry->used = false;
+
+		if (fEntries.Put(HashString(fontPath), fontEntry) != B_OK) {
+			delete fontEntry;
+			return B_NO_MEMORY;
+		}
+	}
+
+	FTRACE(("FontCatalog: loaded %" B_PRId32 " fonts\n", fEntries.Size()));
+	fDirty = false;
+	return B_OK;
+}
+
+
+/*!	Writes the catalog to disk. Entries that have not been used since the
+	catalog was loaded are dropped if their font file is gone.
+*/
+status_t
+FontCatalog::Save()
+{
+	BMessage catalog(kMsgFontCatalog);
+	status_t status = catalog.AddInt32("version", kCatalogVersion);
+
+	EntryMap::Iterator iterator = fEntries.GetIterator();
+	while (status == B_OK && iterator.HasNext()) {
+		EntryMap::Entry mapEntry = iterator.Next();
+		const char* fontPath = mapEntry.key.GetString();
+		entry* fontEntry = mapEntry.value;
+
+		struct stat stat;
+		if (!fontEntry->used && ::stat(fontPath, &stat) != 0) {
+			iterator.Remove();
+			delete fontEntry;
+			continue;
+		}
+
+		const font_style_info& info = fontEntry->info;
+		status = catalog.AddString("path", fontPath);
+		if (status == B_OK)
+			status = catalog.AddInt64("node", fontEntry->node);
+		if (status == B_OK)
+			status = catalog.AddInt64("modified", fontEntry->modified);
+		if (status == B_OK)
+			status = catalog.AddInt64("size", fontEntry->size);
+		if (status == B_OK)
+			status = catalog.AddString("family", info.family);
+		if (status == B_OK)
+			status = catalog.AddString("style", info.style);
+		if (status == B_OK)
+			status = catalog.AddInt32("flags", info.flags);
+		if (status == B_OK)
+			status = catalog.AddInt32("tuned", info.tuned_count);
+		if (status == B_OK)
+			status = catalog.AddInt32("glyphs", info.glyph_count);
+		if (status == B_OK)
+			status = catalog.AddInt32("char maps", info.char_map_count);
+		if (status == B_OK)
+			status = catalog.AddFloat("ascent", info.height.ascent);
+		if (status == B_OK)
+			status = catalog.AddFloat("descent", info.height.descent);
+		if (status == B_OK)
+			status = catalog.AddFloat("leading", info.height.leading);
+	}
+	if (status != B_OK)
+		return status;
+
+	BPath path;
+	status = _GetPath(path, true);
+	if (status != B_OK)
+		return status;
+
+	// write a new file and replace the old one with it, so that there is
+	// never a partial catalog
+	BString tempPath(path.Path());
+	tempPath << ".tmp";
+
+	BFile file;
+	status = file.SetTo(tempPath.String(),
+		B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	if (status != B_OK)
+		return status;
+
+	status = catalog.Flatten(&file);
+	if (status == B_OK)
+		status = file.Sync();
+	file.Unset();
+
+	if (status == B_OK && rename(tempPath.String(), path.Path()) != 0)
+		status = errno;
+	if (status != B_OK) {
+		unlink(tempPath.String());
+		return status;
+	}
+
+	FTRACE(("FontCatalog: saved %" B_PRId32 " fonts\n", fEntries.Size()));
+	fDirty = false;
+	return B_OK;
+}
+
+
+/*!	Returns the cached information about the font file at \a path, if the
+	file described by \a stat is still the one it was taken from.
+*/
+const font_style_info*
+FontCatalog::Lookup(const char* path, const struct stat& stat)
+{
+	entry* fontEntry = fEntries.Get(HashString(path));
+	if (fontEntry == NULL || !fontEntry->Matches(stat))
+		return NULL;
+
+	fontEntry->used = true;
+	return &fontEntry->info;
+}
+
+
+status_t
+FontCatalog::Put(const char* path, const struct stat& stat,
+	const font_style_info& info)
+{
+	HashString key(path);
+	entry* fontEntry = fEntries.Get(key);
+	if (fontEntry == NULL) {
+		fontEntry = new(std::nothrow) entry;
+		if (fontEntry == NULL)
+			return B_NO_MEMORY;
+
+		if (fEntries.Put(key, fontEntry) != B_OK) {
+			delete fontEntry;
+			return B_NO_MEMORY;
+		}
+	}
+
+	fontEntry->SetTo(stat);
+	fontEntry->info = info;
+	fontEntry->used = true;
+	fDirty = true;
+	return B_OK;
+}
+
+
+void
+FontCatalog::Remove(const char* path)
+{
+	entry* fontEntry = fEntries.Remove(HashString(path));
+	if (fontEntry == NULL)
+		return;
+
+	delete fontEntry;
+	fDirty = true;
+}
+
+
+/*!	Moves the entry of a font file that has been moved or renamed. Neither
+	its node nor its modification time change with that.
+*/
+void
+FontCatalog::Rename(const char* oldPath, const char* newPath)
+{
+	if (strcmp(oldPath, newPath) == 0)
+		return;
+
+	entry* fontEntry = fEntries.Remove(HashString(oldPath));
+	if (fontEntry == NULL)
+		return;
+
+	HashString key(newPath);
+	delete fEntries.Remove(key);
+
+	if (fEntries.Put(key, fontEntry) != B_OK)
+		delete fontEntry;
+
+	fDirty = true;
+}
+
+
+/*static*/ void
+FontCatalog::GetStyleInfo(FT_Face face, font_style_info& info)
+{
+	info.family = face->family_name;
+	info.style = face->style_name;
+
+	info.flags = 0;
+	if (FT_IS_FIXED_WIDTH(face))
+		info.flags |= FONT_STYLE_FIXED_WIDTH;
+	if (FT_IS_SCALABLE(face))
+		info.flags |= FONT_STYLE_SCALABLE;
+	if (FT_HAS_KERNING(face))
+		info.flags |= FONT_STYLE_KERNING;
+
+	info.tuned_count = face->num_fixed_sizes;
+	info.glyph_count = face->num_glyphs;
+	info.char_map_count = face->num_charmaps;
+
+	info.height.ascent = (double)face->ascender / face->units_per_EM;
+	info.height.descent = (double)-face->descender / face->units_per_EM;
+		// FT2's descent numbers are negative. Be's is positive
+
+	// FT2 doesn't provide a linegap, but according to the docs, we can
+	// calculate it because height = ascending + descending + leading
+	info.height.leading = (double)(face->height - face->ascender
+		+ face->descender) / face->units_per_EM;
+}
+
+
+/*static*/ status_t
+FontCatalog::_GetPath(BPath& path, bool create)
+{
+	status_t status = find_directory(B_SYSTEM_CACHE_DIRECTORY, &path, create);
+	if (status == B_OK)
+		status = path.Append("app_server");
+	if (status == B_OK && create)
+		status = create_directory(path.Path(), 0755);
+	if (status == B_OK)
+		status = path.Append("font_catalog");
+
+	return status;
+}
+
+
+void
+FontCatalog::_MakeEmpty()
+{
+	EntryMap::Iterator iterator = fEntries.GetIterator();
+	while (iterator.HasNext())
+		delete iterator.Next().value;
+
+	fEntries.Clear();
+	fDirty = false;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef FONT_CATALOG_H
+#define FONT_CATALOG_H
+
+
+#include <Font.h>
+#include <String.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "HashMap.h"
+#include "HashString.h"
+
+
+class BPath;
+struct stat;
+
+
+enum {
+	FONT_STYLE_FIXED_WIDTH	= 0x01,
+	FONT_STYLE_SCALABLE		= 0x02,
+	FONT_STYLE_KERNING		= 0x04
+};
+
+
+/*!	What the FontManager needs to know about a font file to register its
+	family and style, without opening it.
+*/
+struct font_style_info {
+	BString		family;
+	BString		style;
+	uint32		flags;
+	int32		tuned_count;
+	uint16		glyph_count;
+	uint16		char_map_count;
+	font_height	height;
+		// for a size of 1
+};
+
+
+/*!
+	\class FontCatalog FontCatalog.h
+	\brief On-disk cache of the style information of all font files
+
+	An entry is only valid as long as the node, modification time and size
+	of its font file are unchanged.
+*/
+class FontCatalog {
+public:
+								FontCatalog();
+								~FontCatalog();
+
+			status_t			Load();
+			status_t			Save();
+			bool				IsDirty() const
+									{ return fDirty; }
+
+			const font_style_info* Lookup(const char* path,
+									const struct stat& stat);
+			status_t			Put(const char* path, const struct stat& stat,
+									const font_style_info& info);
+			void				Remove(const char* path);
+			void				Rename(const char* oldPath,
+									const char* newPath);
+
+	static	void				GetStyleInfo(FT_Face face,
+									font_style_info& info);
+
+private:
+			struct entry;
+			typedef HashMap<HashString, entry*> EntryMap;
+
+	static	status_t			_GetPath(BPath& path, bool create);
+			void				_MakeEmpty();
+
+			EntryMap			fEntries;
+			bool				fDirty;
+};
+
+
+#endif	// FONT_CATALOG_H
@@ -21,6 +21,7 @@
 #include <File.h>
 #include <FindDirectory.h>
 #include <Message.h>
+#include <MessageRunner.h>
 #include <NodeMonitor.h>
 #include <Path.h>
 #include <String.h>
@@ -40,7 +41,12 @@
 
 // TODO: needs some more work for multi-user support
 
+static const uint32 kMsgSaveFontCatalog = 'fcsv';
+static const bigtime_t kCatalogSaveDelay = 2000000;
+	// collects the changes of a package installation in one save
+
 FT_Library gFreeTypeLibrary;
+BLocker gFreeTypeLibraryLock("FreeType library");
 FontManager *gFontManager = NULL;
 
 struct FontManager::font_directory {
@@ -111,12 +117,17 @@ FontManager::FontManager()
 	fDefaultBoldFont(NULL),
 	fDefaultFixedFont(NULL),
 
+	fCatalogSaveScheduled(false),
+
 	fScanned(false),
 	fNextID(0)
 {
 	fInitStatus = FT_Init_FreeType(&gFreeTypeLibrary) == 0 ? B_OK : B_ERROR;
 
 	if (fInitStatus == B_OK) {
+		fCatalog.Load();
+			// without a catalog, all fonts are opened once to build it
+
 		_AddSystemPaths();
 		_LoadRecentFontMappings();
 
@@ -138,6 +149,9 @@ FontManager::~FontManager()
 	delete fDefaultBoldFont;
 	delete fDefaultFixedFont;
 
+	if (fCatalog.IsDirty())
+		fCatalog.Save();
+
 	// free families before we're done with FreeType
 
 	for (int32 i = fFamilies.CountItems(); i-- > 0;) {
@@ -237,7 +251,7 @@ FontManager::MessageReceived(BMessage* message)
 								if (directory != NULL) {
 									for (int32 i = 0; i < directory->styles.CountItems(); i++) {
 										FontStyle* style = directory->styles.ItemAt(i);
-										style->UpdatePath(directory->directory);
+										_UpdateStylePath(style, directory->directory);
 									}
 								}
 								FTRACE(("directory renamed"));
@@ -250,7 +264,7 @@ FontManager::MessageReceived(BMessage* message)
 								if (style != NULL) {
 									fromDirectory->styles.RemoveItem(style, false);
 									directory->styles.AddItem(style);
-									style->UpdatePath(directory->directory);
+									_UpdateStylePath(style, directory->directory);
 								}
 								FTRACE(("font moved"));
 							} else {
@@ -292,8 +306,17 @@ FontManager::MessageReceived(BMessage* message)
 					break;
 				}
 			}
+
+			if (fCatalog.IsDirty())
+				_ScheduleCatalogSave();
 			break;
 		}
+
+		case kMsgSaveFontCatalog:
+			fCatalogSaveScheduled = false;
+			if (fCatalog.IsDirty())
+				fCatalog.Save();
+			break;
 	}
 }
 
@@ -407,6 +430,7 @@ FontManager::_RemoveStyle(font_directory& directory, FontStyle* style)
 	directory.revision++;
 
 	fStyleHashTable.RemoveItem(*style);
+	fCatalog.Remove(style->Path());
 
 	style->Release();
 }
@@ -431,6 +455,18 @@ FontManager::_RemoveStyle(dev_t device, uint64 directoryNode, uint64 node)
 }
 
 
+/*!	\brief Updates the path of a style whose font file has been moved to
+		another directory, or into a renamed one.
+*/
+void
+FontManager::_UpdateStylePath(FontStyle* style, const node_ref& directoryRef)
+{
+	BString oldPath(style->Path());
+	style->UpdatePath(directoryRef);
+	fCatalog.Rename(oldPath.String(), style->Path());
+}
+
+
 FontStyle*
 FontManager::_GetDefaultStyle(const char *familyName, const char *styleName,
 	const char *fallbackFamily, const char *fallbackStyle,
@@ -571,6 +607,9 @@ FontManager::_ScanFonts()
 
 
 /*!	\brief Adds the FontFamily/FontStyle that is represented by this path.
+
+	The font file is only opened if the FontCatalog does not know it, or if
+	it has changed since.
 */
 status_t
 FontManager::_AddFont(font_directory& directory, BEntry& entry)
@@ -585,33 +624,63 @@ FontManager::_AddFont(font_directory& directory, BEntry& entry)
 	if (status < B_OK)
 		return status;
 
-	FT_Face face;
-	FT_Error error = FT_New_Face(gFreeTypeLibrary, path.Path(), 0, &face);
-	if (error != 0)
-		return B_ERROR;
+	struct stat stat;
+	status = entry.GetStat(&stat);
+	if (status < B_OK)
+		return status;
+
+	FT_Face face = NULL;
+	font_style_info faceInfo;
+	const font_style_info* info = fCatalog.Lookup(path.Path(), stat);
+	if (info == NULL) {
+		gFreeTypeLibraryLock.Lock();
+		FT_Error error = FT_New_Face(gFreeTypeLibrary, path.Path(), 0, &face);
+		gFreeTypeLibraryLock.Unlock();
+		if (error != 0)
+			return B_ERROR;
+
+		FontCatalog::GetStyleInfo(face, faceInfo);
+		info = &faceInfo;
+
+		if (fCatalog.Put(path.Path(), stat, faceInfo) == B_OK)
+			_ScheduleCatalogSave();
+	}
 
-	FontFamily *family = _FindFamily(face->family_name);
-	if (family != NULL && family->HasStyle(face->style_name)) {
+	FontFamily *family = _FindFamily(info->family.String());
+	if (family != NULL && family->HasStyle(info->style.String())) {
 		// prevent adding the same style twice
 		// (this indicates a problem with the installed fonts maybe?)
-		FT_Done_Face(face);
+		if (face != NULL) {
+			BAutolock _(gFreeTypeLibraryLock);
+			FT_Done_Face(face);
+		}
 		return B_OK;
 	}
 
 	if (family == NULL) {
-		family = new (std::nothrow) FontFamily(face->family_name, fNextID++);
+		family = new (std::nothrow) FontFamily(info->family.String(),
+			fNextID++);
 		if (family == NULL
 			|| !fFamilies.BinaryInsert(family, compare_font_families)) {
 			delete family;
-			FT_Done_Face(face);
+			if (face != NULL) {
+				BAutolock _(gFreeTypeLibraryLock);
+				FT_Done_Face(face);
+			}
 			return B_NO_MEMORY;
 		}
 	}
 
-	FTRACE(("\tadd style: %s, %s\n", face->family_name, face->style_name));
+	FTRACE(("\tadd style: %s, %s\n", info->family.String(),
+		info->style.String()));
 
-	// the FontStyle takes over ownership of the FT_Face object
-	FontStyle *style = new (std::nothrow) FontStyle(nodeRef, path.Path(), face);
+	// the FontStyle takes over ownership of the FT_Face object, or opens
+	// the font file itself when it is needed
+	FontStyle *style;
+	if (face != NULL)
+		style = new (std::nothrow) FontStyle(nodeRef, path.Path(), face);
+	else
+		style = new (std::nothrow) FontStyle(nodeRef, path.Path(), *info);
 	if (style == NULL || !family->AddStyle(style)) {
 		delete style;
 		delete family;
@@ -628,6 +697,22 @@ FontManager::_AddFont(font_directory& directory, BEntry& entry)
 }
 
 
+/*!	\brief Saves the FontCatalog a bit later, from the FontManager thread.
+*/
+void
+FontManager::_ScheduleCatalogSave()
+{
+	if (fCatalogSaveScheduled)
+		return;
+
+	BMessage message(kMsgSaveFontCatalog);
+	if (BMessageRunner::StartSending(BMessenger(this), &message,
+			kCatalogSaveDelay, 1) == B_OK) {
+		fCatalogSaveScheduled = true;
+	}
+}
+
+
 FontManager::font_directory*
 FontManager::_FindDirectory(node_ref& nodeRef)
 {
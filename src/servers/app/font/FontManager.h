@@ -10,8 +10,10 @@
 #define FONT_MANAGER_H
 
 
+#include "FontCatalog.h"
 #include "HashTable.h"
 
+#include <Locker.h>
 #include <Looper.h>
 #include <ObjectList.h>
 
@@ -99,6 +101,8 @@ private:
 
 			void				_RemoveStyle(font_directory& directory,
 									FontStyle* style);
+			void				_UpdateStylePath(FontStyle* style,
+									const node_ref& directoryRef);
 			void				_RemoveStyle(dev_t device, uint64 directory,
 									uint64 node);
 			FontFamily*			_FindFamily(const char* family) const;
@@ -108,6 +112,7 @@ private:
 			status_t			_ScanFontDirectory(font_directory& directory);
 			status_t			_AddFont(font_directory& directory,
 									BEntry& entry);
+			void				_ScheduleCatalogSave();
 
 			FT_CharMap			_GetSupportedCharmap(const FT_Face& face);
 
@@ -124,6 +129,9 @@ private:
 
 			HashTable			fStyleHashTable;
 
+			FontCatalog			fCatalog;
+			bool				fCatalogSaveScheduled;
+
 			ServerFont*			fDefaultPlainFont;
 			ServerFont*			fDefaultBoldFont;
 			ServerFont*			fDefaultFixedFont;
@@ -133,6 +141,9 @@ private:
 };
 
 extern FT_Library gFreeTypeLibrary;
+extern BLocker gFreeTypeLibraryLock;
+	// serializes creating and destroying faces of gFreeTypeLibrary; no other
+	// lock must be acquired while holding it
 extern FontManager* gFontManager;
 
 #endif	/* FONT_MANAGER_H */
@@ -16,6 +16,7 @@
 
 #include <FontPrivate.h>
 
+#include <Autolock.h>
 #include <Entry.h>
 
 
@@ -31,25 +32,36 @@ static BLocker sFontLock("font lock");
 FontStyle::FontStyle(node_ref& nodeRef, const char* path, FT_Face face)
 	:
 	fFreeTypeFace(face),
-	fName(face->style_name),
 	fPath(path),
 	fNodeRef(nodeRef),
 	fFamily(NULL),
 	fID(0),
-	fBounds(0, 0, 0, 0),
-	fFace(_TranslateStyleToFace(face->style_name))
+	fBounds(0, 0, 0, 0)
 {
-	fName.Truncate(B_FONT_STYLE_LENGTH);
-		// make sure this style can be found using the Be API
+	font_style_info info;
+	FontCatalog::GetStyleInfo(face, info);
+	_Init(info);
+}
 
-	fHeight.ascent = (double)face->ascender / face->units_per_EM;
-	fHeight.descent = (double)-face->descender / face->units_per_EM;
-		// FT2's descent numbers are negative. Be's is positive
 
-	// FT2 doesn't provide a linegap, but according to the docs, we can
-	// calculate it because height = ascending + descending + leading
-	fHeight.leading = (double)(face->height - face->ascender + face->descender)
-		/ face->units_per_EM;
+/*!
+	\brief Constructor
+	\param filepath path to a font file
+	\param info the style information of the font file as found in the
+		   FontCatalog - the font file itself is only opened when its
+		   FreeType handle is needed
+*/
+FontStyle::FontStyle(node_ref& nodeRef, const char* path,
+	const font_style_info& info)
+	:
+	fFreeTypeFace(NULL),
+	fPath(path),
+	fNodeRef(nodeRef),
+	fFamily(NULL),
+	fID(0),
+	fBounds(0, 0, 0, 0)
+{
+	_Init(info);
 }
 
 
@@ -61,7 +73,10 @@ FontStyle::~FontStyle()
 		gFontManager->Unlock();
 	}
 
-	FT_Done_Face(fFreeTypeFace);
+	if (fFreeTypeFace != NULL) {
+		BAutolock _(gFreeTypeLibraryLock);
+		FT_Done_Face(fFreeTypeFace);
+	}
 }
 
 
@@ -104,6 +119,28 @@ FontStyle::GetHeight(float size, font_height& height) const
 }
 
 
+/*!
+	\brief Returns the FreeType handle of the font file, opening the file if
+		that has not happened yet.
+	\return The FreeType handle, or NULL if the file could not be opened
+*/
+FT_Face
+FontStyle::FreeTypeFace() const
+{
+	BAutolock _(sFontLock);
+
+	if (fFreeTypeFace == NULL) {
+		// Faces of the shared library must not be created or destroyed
+		// concurrently. The FontEngines use their own library instances.
+		BAutolock locker(gFreeTypeLibraryLock);
+		if (FT_New_Face(gFreeTypeLibrary, Path(), 0, &fFreeTypeFace) != 0)
+			fFreeTypeFace = NULL;
+	}
+
+	return fFreeTypeFace;
+}
+
+
 /*!
 	\brief Returns the path to the style's font file
 	\return The style's font file path
@@ -190,12 +227,31 @@ FontStyle::UpdateFace(FT_Face face)
 	if (name != fName)
 		return B_BAD_VALUE;
 
-	FT_Done_Face(fFreeTypeFace);
+	if (fFreeTypeFace != NULL) {
+		BAutolock _(gFreeTypeLibraryLock);
+		FT_Done_Face(fFreeTypeFace);
+	}
 	fFreeTypeFace = face;
 	return B_OK;
 }
 
 
+void
+FontStyle::_Init(const font_style_info& info)
+{
+	fName = info.style;
+	fName.Truncate(B_FONT_STYLE_LENGTH);
+		// make sure this style can be found using the Be API
+
+	fHeight = info.height;
+	fFace = _TranslateStyleToFace(info.style.String());
+	fFlags = info.flags;
+	fTunedCount = info.tuned_count;
+	fGlyphCount = info.glyph_count;
+	fCharMapCount = info.char_map_count;
+}
+
+
 void
 FontStyle::_SetFontFamily(FontFamily* family, uint16 id)
 {
@@ -20,6 +20,7 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include "FontCatalog.h"
 #include "ReferenceCounting.h"
 #include "HashTable.h"
 
@@ -58,6 +59,8 @@ class FontStyle : public ReferenceCounting, public Hashable {
 	public:
 						FontStyle(node_ref& nodeRef, const char* path,
 							FT_Face face);
+						FontStyle(node_ref& nodeRef, const char* path,
+							const font_style_info& info);
 		virtual			~FontStyle();
 
 		virtual uint32	Hash() const;
@@ -74,7 +77,7 @@ class FontStyle : public ReferenceCounting, public Hashable {
 	\return true if fixed, false if not
 */
 		bool			IsFixedWidth() const
-							{ return FT_IS_FIXED_WIDTH(fFreeTypeFace); }
+							{ return (fFlags & FONT_STYLE_FIXED_WIDTH) != 0; }
 
 
 /*	\fn bool FontStyle::IsFullAndHalfFixed()
@@ -90,42 +93,42 @@ class FontStyle : public ReferenceCounting, public Hashable {
 	\return true if scalable, false if not
 */
 		bool			IsScalable() const
-							{ return FT_IS_SCALABLE(fFreeTypeFace); }
+							{ return (fFlags & FONT_STYLE_SCALABLE) != 0; }
 /*!
 	\fn bool FontStyle::HasKerning(void)
 	\brief Determines whether the font has kerning information
 	\return true if kerning info is available, false if not
 */
 		bool			HasKerning() const
-							{ return FT_HAS_KERNING(fFreeTypeFace); }
+							{ return (fFlags & FONT_STYLE_KERNING) != 0; }
 /*!
 	\fn bool FontStyle::HasTuned(void)
 	\brief Determines whether the font contains strikes
 	\return true if it has strikes included, false if not
 */
 		bool			HasTuned() const
-							{ return FT_HAS_FIXED_SIZES(fFreeTypeFace); }
+							{ return fTunedCount > 0; }
 /*!
 	\fn bool FontStyle::TunedCount(void)
 	\brief Returns the number of strikes the style contains
 	\return The number of strikes the style contains
 */
 		int32			TunedCount() const
-							{ return fFreeTypeFace->num_fixed_sizes; }
+							{ return fTunedCount; }
 /*!
 	\fn bool FontStyle::GlyphCount(void)
 	\brief Returns the number of glyphs in the style
 	\return The number of glyphs the style contains
 */
 		uint16			GlyphCount() const
-							{ return fFreeTypeFace->num_glyphs; }
+							{ return fGlyphCount; }
 /*!
 	\fn bool FontStyle::CharMapCount(void)
 	\brief Returns the number of character maps the style contains
 	\return The number of character maps the style contains
 */
 		uint16			CharMapCount() const
-							{ return fFreeTypeFace->num_charmaps; }
+							{ return fCharMapCount; }
 
 		const char*		Name() const
 							{ return fName.String(); }
@@ -148,18 +151,20 @@ class FontStyle : public ReferenceCounting, public Hashable {
 		font_file_format FileFormat() const
 							{ return B_TRUETYPE_WINDOWS; }
 
-		FT_Face			FreeTypeFace() const
-							{ return fFreeTypeFace; }
+		FT_Face			FreeTypeFace() const;
 
 		status_t		UpdateFace(FT_Face face);
 
 	private:
 		friend class FontFamily;
+		void			_Init(const font_style_info& info);
 		uint16			_TranslateStyleToFace(const char *name) const;
 		void			_SetFontFamily(FontFamily* family, uint16 id);
 
 	private:
-		FT_Face			fFreeTypeFace;
+		mutable FT_Face	fFreeTypeFace;
+			// only opened on first use when the style comes from the
+			// FontCatalog
 		BString			fName;
 		BPath			fPath;
 		node_ref		fNodeRef;
@@ -171,6 +176,10 @@ class FontStyle : public ReferenceCounting, public Hashable {
 
 		font_height		fHeight;
 		uint16			fFace;
+		uint32			fFlags;
+		int32			fTunedCount;
+		uint16			fGlyphCount;
+		uint16			fCharMapCount;
 };
 
 #endif	// FONT_STYLE_H_
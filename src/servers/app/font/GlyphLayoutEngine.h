@@ -20,12 +20,22 @@
 
 #include <ctype.h>
 
+// How a FontCacheReference holds its entry. Looking up cached glyphs
+// does not need any lock, but using the FontEngine of the entry does,
+// and creating glyphs needs the write lock.
+enum font_cache_lock_mode {
+	FONT_CACHE_UNLOCKED = 0,
+	FONT_CACHE_READ_LOCKED,
+	FONT_CACHE_WRITE_LOCKED
+};
+
+
 class FontCacheReference {
 public:
 	FontCacheReference()
 		:
 		fCacheEntry(NULL),
-		fWriteLocked(false)
+		fLockMode(FONT_CACHE_UNLOCKED)
 	{
 	}
 
@@ -34,7 +44,7 @@ public:
 		Unset();
 	}
 
-	void SetTo(FontCacheEntry* entry, bool writeLocked)
+	void SetTo(FontCacheEntry* entry, font_cache_lock_mode lockMode)
 	{
 		// NOTE: If the semantics are changed such
 		// that the reference to a previous entry
@@ -43,7 +53,7 @@ public:
 		// responsibility of entries between
 		// references!
 		fCacheEntry = entry;
-		fWriteLocked = writeLocked;
+		fLockMode = lockMode;
 	}
 
 	void Unset()
@@ -51,9 +61,9 @@ public:
 		if (fCacheEntry == NULL)
 			return;
 
-		if (fWriteLocked)
+		if (fLockMode == FONT_CACHE_WRITE_LOCKED)
 			fCacheEntry->WriteUnlock();
-		else
+		else if (fLockMode == FONT_CACHE_READ_LOCKED)
 			fCacheEntry->ReadUnlock();
 
 		FontCache::Default()->Recycle(fCacheEntry);
@@ -64,14 +74,14 @@ public:
 		return fCacheEntry;
 	}
 
-	inline bool WriteLocked() const
+	inline font_cache_lock_mode LockMode() const
 	{
-		return fWriteLocked;
+		return fLockMode;
 	}
 
 private:
 			FontCacheEntry*		fCacheEntry;
-			bool				fWriteLocked;
+			font_cache_lock_mode fLockMode;
 };
 
 
@@ -84,7 +94,7 @@ public:
 									const FontCacheEntry* disallowedEntry,
 									const char* utf8String, int32 length,
 									FontCacheReference& cacheReference,
-									bool needsWriteLock);
+									font_cache_lock_mode lockMode);
 
 			template<class GlyphConsumer>
 	static	bool				LayoutGlyphs(GlyphConsumer& consumer,
@@ -97,6 +107,8 @@ public:
 									FontCacheReference* cacheReference = NULL);
 
 private:
+	static	bool				_ReadLock(
+									FontCacheReference& cacheReference);
 	static	bool				_WriteLockAndAcquireFallbackEntry(
 									FontCacheReference& cacheReference,
 									FontCacheEntry* entry,
@@ -133,7 +145,7 @@ GlyphLayoutEngine::IsWhiteSpace(uint32 charCode)
 inline FontCacheEntry*
 GlyphLayoutEngine::FontCacheEntryFor(const ServerFont& font, bool forceVector,
 	const FontCacheEntry* disallowedEntry, const char* utf8String, int32 length,
-	FontCacheReference& cacheReference, bool needsWriteLock)
+	FontCacheReference& cacheReference, font_cache_lock_mode lockMode)
 {
 	ASSERT(cacheReference.Entry() == NULL);
 
@@ -147,12 +159,12 @@ GlyphLayoutEngine::FontCacheEntryFor(const ServerFont& font, bool forceVector,
 		return NULL;
 	}
 
-	if (needsWriteLock) {
+	if (lockMode == FONT_CACHE_WRITE_LOCKED) {
 		if (!entry->WriteLock()) {
 			cache->Recycle(entry);
 			return NULL;
 		}
-	} else {
+	} else if (lockMode == FONT_CACHE_READ_LOCKED) {
 		if (!entry->ReadLock()) {
 			cache->Recycle(entry);
 			return NULL;
@@ -162,7 +174,7 @@ GlyphLayoutEngine::FontCacheEntryFor(const ServerFont& font, bool forceVector,
 	// At this point, we have a valid FontCacheEntry and it is locked in the
 	// proper mode. We can setup the FontCacheReference so it takes care of
 	// the locking and recycling from now and return the entry.
-	cacheReference.SetTo(entry, needsWriteLock);
+	cacheReference.SetTo(entry, lockMode);
 	return entry;
 }
 
@@ -178,6 +190,7 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 	// TODO: implement spacing modes
 	FontCacheEntry* entry = NULL;
 	FontCacheReference cacheReference;
+	FontCacheReference* reference = &cacheReference;
 	FontCacheEntry* fallbackEntry = NULL;
 	FontCacheReference fallbackCacheReference;
 	if (_cacheReference != NULL) {
@@ -189,14 +202,25 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 		// This means that the fallback entry mechanism will not do any good
 		// for the second pass, since the fallback glyphs have been stored in
 		// the original entry.
+		if (entry != NULL)
+			reference = _cacheReference;
 	}
 
+	// The glyphs are looked up without locking the entry, only kerning
+	// needs its FontEngine.
+	bool needsEngine = offsets == NULL && spacing == B_STRING_SPACING;
+
 	if (entry == NULL) {
 		entry = FontCacheEntryFor(font, consumer.NeedsVector(), NULL,
-			utf8String, length, cacheReference, false);
+			utf8String, length, cacheReference,
+			needsEngine ? FONT_CACHE_READ_LOCKED : FONT_CACHE_UNLOCKED);
 
 		if (entry == NULL)
 			return false;
+	} else if (needsEngine && reference->LockMode() == FONT_CACHE_UNLOCKED) {
+		// the entry was already used, but not locked
+		if (!_ReadLock(*reference))
+			return false;
 	} // else the entry was already used and is still locked
 
 	consumer.Start();
@@ -239,7 +263,7 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 			// the write lock will persist (in the cacheReference) so that
 			// we only have to do this switch once for the whole string.
 			if (!writeLocked) {
-				writeLocked = _WriteLockAndAcquireFallbackEntry(cacheReference,
+				writeLocked = _WriteLockAndAcquireFallbackEntry(*reference,
 					entry, font, consumer.NeedsVector(), utf8String, length,
 					fallbackCacheReference, fallbackEntry);
 			}
@@ -291,13 +315,25 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 		// FontCacheReference to the one passed by the caller. The fallback
 		// FontCacheReference is not affected by this, since it is never used
 		// during a second iteration.
-		_cacheReference->SetTo(entry, cacheReference.WriteLocked());
-		cacheReference.SetTo(NULL, false);
+		_cacheReference->SetTo(entry, cacheReference.LockMode());
+		cacheReference.SetTo(NULL, FONT_CACHE_UNLOCKED);
 	}
 	return true;
 }
 
 
+inline bool
+GlyphLayoutEngine::_ReadLock(FontCacheReference& cacheReference)
+{
+	FontCacheEntry* entry = cacheReference.Entry();
+	if (!entry->ReadLock())
+		return false;
+
+	cacheReference.SetTo(entry, FONT_CACHE_READ_LOCKED);
+	return true;
+}
+
+
 inline bool
 GlyphLayoutEngine::_WriteLockAndAcquireFallbackEntry(
 	FontCacheReference& cacheReference, FontCacheEntry* entry,
@@ -309,15 +345,14 @@ GlyphLayoutEngine::_WriteLockAndAcquireFallbackEntry(
 	// glyphs from it. We need to obtain the fallback font while we have not
 	// locked anything, since locking the FontManager with the write-lock held
 	// can obvisouly lead to a deadlock.
-	
-	bool writeLocked = entry->IsWriteLocked();
 
-	if (writeLocked) {
+	font_cache_lock_mode lockMode = cacheReference.LockMode();
+	cacheReference.SetTo(NULL, FONT_CACHE_UNLOCKED);
+
+	if (lockMode == FONT_CACHE_WRITE_LOCKED)
 		entry->WriteUnlock();
-	} else {
-		cacheReference.SetTo(NULL, false);
+	else if (lockMode == FONT_CACHE_READ_LOCKED)
 		entry->ReadUnlock();
-	}
 
 	// TODO: We always get the fallback glyphs from the Noto family, but of
 	// course the fallback font should a) contain the missing glyphs at all
@@ -348,7 +383,8 @@ GlyphLayoutEngine::_WriteLockAndAcquireFallbackEntry(
 				// "entry" in any case, which requires the write cache for
 				// sure (used FontEngine of fallbackEntry).
 				fallbackEntry = FontCacheEntryFor(fallbackFont, forceVector,
-					entry, utf8String, length, fallbackCacheReference, true);
+					entry, utf8String, length, fallbackCacheReference,
+					FONT_CACHE_WRITE_LOCKED);
 
 				if (fallbackEntry != NULL)
 					break;
@@ -366,10 +402,8 @@ GlyphLayoutEngine::_WriteLockAndAcquireFallbackEntry(
 		return false;
 	}
 
-	if (!writeLocked) {
-		// Update the FontCacheReference, since the locking kind changed.
-		cacheReference.SetTo(entry, true);
-	}
+	// Update the FontCacheReference, since the locking kind changed.
+	cacheReference.SetTo(entry, FONT_CACHE_WRITE_LOCKED);
 	return true;
 }
 
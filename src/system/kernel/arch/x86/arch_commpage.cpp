@@ -7,10 +7,50 @@
 
 #include <commpage.h>
 
+#include <cpu.h>
+#include <smp.h>
+
 #include "x86_signals.h"
 #include "x86_syscalls.h"
 
 
+static bool
+all_cpus_have_feature(enum x86_feature_type type, uint32 feature)
+{
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		if ((gCPU[i].arch.feature[type] & feature) == 0)
+			return false;
+	}
+
+	return true;
+}
+
+
+/*!	Tells userland which instruction set extensions it may use, so that
+	libroot can choose the implementation of its string functions.
+*/
+static void
+x86_initialize_commpage_cpu_features()
+{
+	uint32 features = 0;
+
+	// The CPU only reports OSXSAVE when the kernel manages the extended
+	// state with XSAVE, and only then the YMM registers are preserved when
+	// switching threads.
+	if (all_cpus_have_feature(FEATURE_7_EBX, IA32_FEATURE_AVX2)
+		&& all_cpus_have_feature(FEATURE_EXT, IA32_FEATURE_EXT_OSXSAVE)) {
+		uint32 low, high;
+		asm volatile("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+		if ((low & 0x6) == 0x6) // XMM and YMM state enabled in XCR0
+			features |= X86_CPU_FEATURE_AVX2;
+	}
+
+	fill_commpage_entry(COMMPAGE_ENTRY_X86_CPU_FEATURES, &features,
+		sizeof(features));
+}
+
+
 status_t
 arch_commpage_init(void)
 {
@@ -27,5 +67,7 @@ arch_commpage_init_post_cpus(void)
 	// initialize the signal handler code in the commpage
 	x86_initialize_commpage_signal_handler();
 
+	x86_initialize_commpage_cpu_features();
+
 	return B_OK;
 }
@@ -331,9 +331,10 @@ X86PagingMethod64Bit::PageTableForAddress(uint64* virtualPML4,
 		mapCount++;
 	}
 
-	// No proper large page support at the moment, but they are used for the
-	// physical map area. Ensure that nothing tries to treat that as normal
-	// address space.
+	// Large pages are used for the physical map area, and the translation map
+	// splits the ones it mapped itself before dealing with single pages in
+	// their range. Ensure that nothing tries to treat them as normal address
+	// space.
 	ASSERT(!(*pde & X86_64_PDE_LARGE_PAGE));
 
 	return (uint64*)pageMapper->GetPageTableAt(*pde & X86_64_PDE_ADDRESS_MASK);
@@ -355,10 +356,13 @@ X86PagingMethod64Bit::PageTableEntryForAddress(uint64* virtualPML4,
 }
 
 
-/*static*/ void
-X86PagingMethod64Bit::PutPageTableEntryInTable(uint64* entry,
-	phys_addr_t physicalAddress, uint32 attributes, uint32 memoryType,
-	bool globalPage)
+/*!	Returns the page table entry mapping \a physicalAddress with the given
+	attributes. The flags are the same for a large page's page directory
+	entry, save for X86_64_PDE_LARGE_PAGE.
+*/
+/*static*/ uint64
+X86PagingMethod64Bit::PageTableEntryFor(phys_addr_t physicalAddress,
+	uint32 attributes, uint32 memoryType, bool globalPage)
 {
 	uint64 page = (physicalAddress & X86_64_PTE_ADDRESS_MASK)
 		| X86_64_PTE_PRESENT | (globalPage ? X86_64_PTE_GLOBAL : 0)
@@ -378,8 +382,18 @@ X86PagingMethod64Bit::PutPageTableEntryInTable(uint64* entry,
 	} else if ((attributes & B_KERNEL_WRITE_AREA) != 0)
 		page |= X86_64_PTE_WRITABLE;
 
+	return page;
+}
+
+
+/*static*/ void
+X86PagingMethod64Bit::PutPageTableEntryInTable(uint64* entry,
+	phys_addr_t physicalAddress, uint32 attributes, uint32 memoryType,
+	bool globalPage)
+{
 	// put it in the page table
-	SetTableEntry(entry, page);
+	SetTableEntry(entry, PageTableEntryFor(physicalAddress, attributes,
+		memoryType, globalPage));
 }
 
 
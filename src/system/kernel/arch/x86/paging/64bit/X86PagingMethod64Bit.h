@@ -83,6 +83,10 @@ public:
 									TranslationMapPhysicalPageMapper*
 										pageMapper, int32& mapCount);
 
+	static	uint64				PageTableEntryFor(
+									phys_addr_t physicalAddress,
+									uint32 attributes, uint32 memoryType,
+									bool globalPage);
 	static	void				PutPageTableEntryInTable(
 									uint64* entry, phys_addr_t physicalAddress,
 									uint32 attributes, uint32 memoryType,
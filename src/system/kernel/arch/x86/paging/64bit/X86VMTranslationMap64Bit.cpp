@@ -35,10 +35,67 @@
 // #pragma mark - X86VMTranslationMap64Bit
 
 
+/*!	Transfers the accessed and dirty flags of \a oldEntry to the unmapped
+	page, and removes its mapping object, respectively its wiring.
+	The map must be locked.
+*/
+static void
+page_unmapped(VMArea* area, page_num_t pageNumber, uint64 oldEntry,
+	bool updatePageQueue, VMAreaMappings& queue)
+{
+	// get the page
+	vm_page* page = vm_lookup_page(pageNumber);
+	ASSERT(page != NULL);
+
+	DEBUG_PAGE_ACCESS_START(page);
+
+	// transfer the accessed/dirty flags to the page
+	if ((oldEntry & X86_64_PTE_ACCESSED) != 0)
+		page->accessed = true;
+	if ((oldEntry & X86_64_PTE_DIRTY) != 0)
+		page->modified = true;
+
+	// remove the mapping object/decrement the wired_count of the
+	// page
+	if (area->wiring == B_NO_LOCK) {
+		vm_page_mapping* mapping = NULL;
+		vm_page_mappings::Iterator iterator
+			= page->mappings.GetIterator();
+		while ((mapping = iterator.Next()) != NULL) {
+			if (mapping->area == area)
+				break;
+		}
+
+		ASSERT(mapping != NULL);
+
+		area->mappings.Remove(mapping);
+		page->mappings.Remove(mapping);
+		queue.Add(mapping);
+	} else
+		page->DecrementWiredCount();
+
+	if (!page->IsMapped()) {
+		atomic_add(&gMappedPagesCount, -1);
+
+		if (updatePageQueue) {
+			if (page->Cache()->temporary)
+				vm_page_set_state(page, PAGE_STATE_INACTIVE);
+			else if (page->modified)
+				vm_page_set_state(page, PAGE_STATE_MODIFIED);
+			else
+				vm_page_set_state(page, PAGE_STATE_CACHED);
+		}
+	}
+
+	DEBUG_PAGE_ACCESS_END(page);
+}
+
+
 X86VMTranslationMap64Bit::X86VMTranslationMap64Bit()
 	:
 	fPagingStructures(NULL)
 {
+	fLargePageReservation.count = 0;
 }
 
 
@@ -71,6 +128,13 @@ X86VMTranslationMap64Bit::~X86VMTranslationMap64Bit()
 					if ((virtualPageDir[k] & X86_64_PDE_PRESENT) == 0)
 						continue;
 
+					// large pages don't have a page table, they can be left
+					// over by UnmapArea() when the address space is deleted
+					if ((virtualPageDir[k] & X86_64_PDE_LARGE_PAGE) != 0) {
+						atomic_add(&gMappedLargePagesCount, -1);
+						continue;
+					}
+
 					address = virtualPageDir[k] & X86_64_PDE_ADDRESS_MASK;
 					page = vm_lookup_page(address / B_PAGE_SIZE);
 					if (page == NULL) {
@@ -107,6 +171,8 @@ X86VMTranslationMap64Bit::~X86VMTranslationMap64Bit()
 		fPageMapper->Delete();
 	}
 
+	vm_page_unreserve_pages(&fLargePageReservation);
+
 	fPagingStructures->RemoveReference();
 }
 
@@ -222,6 +288,58 @@ X86VMTranslationMap64Bit::Map(addr_t virtualAddress, phys_addr_t physicalAddress
 }
 
 
+size_t
+X86VMTranslationMap64Bit::LargePageSize() const
+{
+	return k64BitPageTableRange;
+}
+
+
+/*!	Fails with \c B_BUSY, if the range already has a page table, since page
+	tables are not freed when the pages in them are unmapped.
+*/
+status_t
+X86VMTranslationMap64Bit::MapLargePage(addr_t virtualAddress,
+	phys_addr_t physicalAddress, uint32 attributes, uint32 memoryType,
+	vm_page_reservation* reservation)
+{
+	TRACE("X86VMTranslationMap64Bit::MapLargePage(%#" B_PRIxADDR ", %#"
+		B_PRIxPHYSADDR ")\n", virtualAddress, physicalAddress);
+
+	ASSERT(virtualAddress % k64BitPageTableRange == 0);
+	ASSERT(physicalAddress % k64BitPageTableRange == 0);
+
+	ThreadCPUPinner pinner(thread_get_current_thread());
+
+	// Look up the page directory entry for the virtual address, allocating
+	// the tables above it if required.
+	uint64* entry = X86PagingMethod64Bit::PageDirectoryEntryForAddress(
+		fPagingStructures->VirtualPML4(), virtualAddress, fIsKernelMap,
+		true, reservation, fPageMapper, fMapCount);
+	ASSERT(entry != NULL);
+
+	if ((*entry & X86_64_PDE_PRESENT) != 0)
+		return B_BUSY;
+
+	X86PagingMethod64Bit::SetTableEntry(entry,
+		X86PagingMethod64Bit::PageTableEntryFor(physicalAddress, attributes,
+			memoryType, fIsKernelMap)
+		| X86_64_PDE_LARGE_PAGE);
+
+	// Keep a page for the page table we need when splitting the large page
+	// again. Since that happens in methods that don't get a reservation, we
+	// can't allocate it later.
+	ASSERT(reservation->count > 0);
+	reservation->count--;
+	fLargePageReservation.count++;
+
+	fMapCount += k64BitTableEntryCount;
+	atomic_add(&gMappedLargePagesCount, 1);
+
+	return B_OK;
+}
+
+
 status_t
 X86VMTranslationMap64Bit::Unmap(addr_t start, addr_t end)
 {
@@ -232,9 +350,21 @@ X86VMTranslationMap64Bit::Unmap(addr_t start, addr_t end)
 	TRACE("X86VMTranslationMap64Bit::Unmap(%#" B_PRIxADDR ", %#" B_PRIxADDR
 		")\n", start, end);
 
+	RecursiveLocker locker(fLock);
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
+		uint64* largePage = _LargePageEntryForRange(start, end);
+		if (largePage != NULL) {
+			uint64 oldEntry = X86PagingMethod64Bit::ClearTableEntry(largePage);
+			if ((oldEntry & X86_64_PDE_ACCESSED) != 0)
+				InvalidatePage(start);
+
+			_LargePageUnmapped();
+			start += k64BitPageTableRange;
+			continue;
+		}
+
 		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
 			fPagingStructures->VirtualPML4(), start, fIsKernelMap, false,
 			NULL, fPageMapper, fMapCount);
@@ -285,6 +415,10 @@ X86VMTranslationMap64Bit::DebugMarkRangePresent(addr_t start, addr_t end,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
+		uint64* largePage = _LargePageEntry(start);
+		if (largePage != NULL)
+			_SplitLargePage(largePage, start);
+
 		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
 			fPagingStructures->VirtualPML4(), start, fIsKernelMap, false,
 			NULL, fPageMapper, fMapCount);
@@ -334,6 +468,10 @@ X86VMTranslationMap64Bit::UnmapPage(VMArea* area, addr_t address,
 
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
+	uint64* largePage = _LargePageEntry(address);
+	if (largePage != NULL)
+		_SplitLargePage(largePage, address);
+
 	// Look up the page table for the virtual address.
 	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
 		fPagingStructures->VirtualPML4(), address, fIsKernelMap,
@@ -402,6 +540,29 @@ X86VMTranslationMap64Bit::UnmapPages(VMArea* area, addr_t base, size_t size,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
+		uint64* largePage = _LargePageEntryForRange(start, end);
+		if (largePage != NULL) {
+			uint64 oldEntry = X86PagingMethod64Bit::ClearTableEntry(largePage);
+			if ((oldEntry & X86_64_PDE_ACCESSED) != 0)
+				InvalidatePage(start);
+
+			if (area->cache_type != CACHE_TYPE_DEVICE) {
+				// all pages inherit the accessed and dirty flags
+				page_num_t pageNumber = (oldEntry & X86_64_PDE_ADDRESS_MASK)
+					/ B_PAGE_SIZE;
+				for (uint32 i = 0; i < k64BitTableEntryCount; i++) {
+					page_unmapped(area, pageNumber + i, oldEntry,
+						updatePageQueue, queue);
+				}
+			}
+
+			_LargePageUnmapped();
+			start += k64BitPageTableRange;
+
+			Flush();
+			continue;
+		}
+
 		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
 			fPagingStructures->VirtualPML4(), start, fIsKernelMap, false,
 			NULL, fPageMapper, fMapCount);
@@ -429,52 +590,9 @@ X86VMTranslationMap64Bit::UnmapPages(VMArea* area, addr_t base, size_t size,
 			}
 
 			if (area->cache_type != CACHE_TYPE_DEVICE) {
-				// get the page
-				vm_page* page = vm_lookup_page(
-					(oldEntry & X86_64_PTE_ADDRESS_MASK) / B_PAGE_SIZE);
-				ASSERT(page != NULL);
-
-				DEBUG_PAGE_ACCESS_START(page);
-
-				// transfer the accessed/dirty flags to the page
-				if ((oldEntry & X86_64_PTE_ACCESSED) != 0)
-					page->accessed = true;
-				if ((oldEntry & X86_64_PTE_DIRTY) != 0)
-					page->modified = true;
-
-				// remove the mapping object/decrement the wired_count of the
-				// page
-				if (area->wiring == B_NO_LOCK) {
-					vm_page_mapping* mapping = NULL;
-					vm_page_mappings::Iterator iterator
-						= page->mappings.GetIterator();
-					while ((mapping = iterator.Next()) != NULL) {
-						if (mapping->area == area)
-							break;
-					}
-
-					ASSERT(mapping != NULL);
-
-					area->mappings.Remove(mapping);
-					page->mappings.Remove(mapping);
-					queue.Add(mapping);
-				} else
-					page->DecrementWiredCount();
-
-				if (!page->IsMapped()) {
-					atomic_add(&gMappedPagesCount, -1);
-
-					if (updatePageQueue) {
-						if (page->Cache()->temporary)
-							vm_page_set_state(page, PAGE_STATE_INACTIVE);
-						else if (page->modified)
-							vm_page_set_state(page, PAGE_STATE_MODIFIED);
-						else
-							vm_page_set_state(page, PAGE_STATE_CACHED);
-					}
-				}
-
-				DEBUG_PAGE_ACCESS_END(page);
+				page_unmapped(area,
+					(oldEntry & X86_64_PTE_ADDRESS_MASK) / B_PAGE_SIZE,
+					oldEntry, updatePageQueue, queue);
 			}
 		}
 
@@ -535,6 +653,11 @@ X86VMTranslationMap64Bit::UnmapArea(VMArea* area, bool deletingAddressSpace,
 			addr_t address = area->Base()
 				+ ((page->cache_offset * B_PAGE_SIZE) - area->cache_offset);
 
+			// the pages are unmapped one by one
+			uint64* largePage = _LargePageEntry(address);
+			if (largePage != NULL)
+				_SplitLargePage(largePage, address);
+
 			uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
 				fPagingStructures->VirtualPML4(), address, fIsKernelMap,
 				false, NULL, fPageMapper, fMapCount);
@@ -683,6 +806,33 @@ X86VMTranslationMap64Bit::Protect(addr_t start, addr_t end, uint32 attributes,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
+		uint64* largePage = _LargePageEntryForRange(start, end);
+		if (largePage != NULL) {
+			// The protection flags are the same in the page directory entry,
+			// so the large page can be kept.
+			uint64 entry = *largePage;
+			uint64 oldEntry;
+			while (true) {
+				oldEntry = X86PagingMethod64Bit::TestAndSetTableEntry(
+					largePage,
+					(entry & ~(X86_64_PTE_PROTECTION_MASK
+							| X86_64_PTE_MEMORY_TYPE_MASK))
+						| newProtectionFlags
+						| X86PagingMethod64Bit::MemoryTypeToPageTableEntryFlags(
+							memoryType),
+					entry);
+				if (oldEntry == entry)
+					break;
+				entry = oldEntry;
+			}
+
+			if ((oldEntry & X86_64_PDE_ACCESSED) != 0)
+				InvalidatePage(start);
+
+			start += k64BitPageTableRange;
+			continue;
+		}
+
 		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
 			fPagingStructures->VirtualPML4(), start, fIsKernelMap, false,
 			NULL, fPageMapper, fMapCount);
@@ -740,6 +890,11 @@ X86VMTranslationMap64Bit::ClearFlags(addr_t address, uint32 flags)
 
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
+	// the flags of a single page can only be cleared in a page table
+	uint64* largePage = _LargePageEntry(address);
+	if (largePage != NULL)
+		_SplitLargePage(largePage, address);
+
 	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
 		fPagingStructures->VirtualPML4(), address, fIsKernelMap,
 		false, NULL, fPageMapper, fMapCount);
@@ -771,6 +926,14 @@ X86VMTranslationMap64Bit::ClearAccessedAndModified(VMArea* area, addr_t address,
 	RecursiveLocker locker(fLock);
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
+	uint64* largePage = _LargePageEntry(address);
+	if (largePage != NULL) {
+		if (!unmapIfUnaccessed)
+			return _ClearLargePageAccessed(largePage, address, _modified);
+
+		_SplitLargePage(largePage, address);
+	}
+
 	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
 		fPagingStructures->VirtualPML4(), address, fIsKernelMap,
 		false, NULL, fPageMapper, fMapCount);
@@ -843,3 +1006,150 @@ X86VMTranslationMap64Bit::PagingStructures() const
 {
 	return fPagingStructures;
 }
+
+
+/*!	Returns the page directory entry of the large page \a address lies in, or
+	\c NULL, if it isn't mapped by a large page.
+	The thread must be pinned.
+*/
+uint64*
+X86VMTranslationMap64Bit::_LargePageEntry(addr_t address)
+{
+	uint64* entry = X86PagingMethod64Bit::PageDirectoryEntryForAddress(
+		fPagingStructures->VirtualPML4(), address, fIsKernelMap, false, NULL,
+		fPageMapper, fMapCount);
+	if (entry == NULL
+		|| (*entry & (X86_64_PDE_PRESENT | X86_64_PDE_LARGE_PAGE))
+			!= (X86_64_PDE_PRESENT | X86_64_PDE_LARGE_PAGE)) {
+		return NULL;
+	}
+
+	return entry;
+}
+
+
+/*!	Returns the page directory entry of the large page \a start lies in, if
+	the range up to \a end (inclusive) covers all of it, so that the caller can
+	deal with it as a whole. If the range covers only a part of it, the large
+	page is split, and \c NULL is returned, as when there is no large page.
+	The thread must be pinned.
+*/
+uint64*
+X86VMTranslationMap64Bit::_LargePageEntryForRange(addr_t start, addr_t end)
+{
+	uint64* entry = _LargePageEntry(start);
+	if (entry == NULL)
+		return NULL;
+
+	if (start % k64BitPageTableRange == 0
+		&& end - start >= k64BitPageTableRange - 1) {
+		return entry;
+	}
+
+	_SplitLargePage(entry, start);
+	return NULL;
+}
+
+
+/*!	Lets the page daemon age the pages of the large page of \a entry without
+	splitting it. The accessed flag is shared by all of its pages, so it is
+	only cleared when \a address is the first page; for the other pages it is
+	just reported. The dirty flag is never cleared, since that would lose the
+	modification of all the other pages, but reported for every page.
+	The map must be locked, and the thread pinned.
+*/
+bool
+X86VMTranslationMap64Bit::_ClearLargePageAccessed(uint64* entry,
+	addr_t address, bool& _modified)
+{
+	uint64 oldEntry = *entry;
+	if (address % k64BitPageTableRange == 0) {
+		oldEntry = X86PagingMethod64Bit::ClearTableEntryFlags(entry,
+			X86_64_PDE_ACCESSED);
+		if ((oldEntry & X86_64_PDE_ACCESSED) != 0) {
+			InvalidatePage(address);
+			Flush();
+		}
+	}
+
+	_modified = (oldEntry & X86_64_PDE_DIRTY) != 0;
+	return (oldEntry & X86_64_PDE_ACCESSED) != 0;
+}
+
+
+/*!	Replaces the large page mapping of \a entry by a page table with the
+	equivalent regular entries, using the page reserved for that in
+	MapLargePage().
+	The thread must be pinned.
+*/
+void
+X86VMTranslationMap64Bit::_SplitLargePage(uint64* entry, addr_t address)
+{
+	RecursiveLocker locker(fLock);
+
+	uint64 oldEntry = *entry;
+	if ((oldEntry & X86_64_PDE_LARGE_PAGE) == 0)
+		return;
+
+	vm_page* page = vm_page_allocate_page(&fLargePageReservation,
+		PAGE_STATE_WIRED | VM_PAGE_ALLOC_CLEAR);
+
+	DEBUG_PAGE_ACCESS_END(page);
+
+	phys_addr_t physicalPageTable
+		= (phys_addr_t)page->physical_page_number * B_PAGE_SIZE;
+	uint64* pageTable = (uint64*)fPageMapper->GetPageTableAt(
+		physicalPageTable);
+
+	TRACE("X86VMTranslationMap64Bit::_SplitLargePage(): splitting large page "
+		"at %#" B_PRIxADDR " using page table %#" B_PRIxPHYSADDR "\n",
+		address, physicalPageTable);
+
+	while (true) {
+		// The page table entries get the flags of the large page, including
+		// the accessed and dirty flags.
+		phys_addr_t physicalAddress = oldEntry & X86_64_PDE_ADDRESS_MASK
+			& ~(phys_addr_t)(k64BitPageTableRange - 1);
+		uint64 flags = oldEntry
+			& ~(X86_64_PDE_ADDRESS_MASK | X86_64_PDE_LARGE_PAGE);
+		for (uint32 i = 0; i < k64BitTableEntryCount; i++)
+			pageTable[i] = (physicalAddress + i * B_PAGE_SIZE) | flags;
+
+		uint64 currentEntry = X86PagingMethod64Bit::TestAndSetTableEntry(
+			entry, (physicalPageTable & X86_64_PDE_ADDRESS_MASK)
+				| X86_64_PDE_PRESENT
+				| X86_64_PDE_WRITABLE
+				| X86_64_PDE_USER,
+			oldEntry);
+		if (currentEntry == oldEntry)
+			break;
+
+		// the processor has set the accessed or dirty flag in the meantime
+		oldEntry = currentEntry;
+	}
+
+	// Invalidating any address of the large page removes it from the TLB.
+	if ((oldEntry & X86_64_PDE_ACCESSED) != 0)
+		InvalidatePage(address);
+
+	fMapCount++;
+	atomic_add(&gMappedLargePagesCount, -1);
+	atomic_add(&gLargePageSplitCount, 1);
+}
+
+
+/*!	Updates the bookkeeping after a large page has been unmapped as a whole,
+	and returns the page reserved for splitting it.
+	The map must be locked.
+*/
+void
+X86VMTranslationMap64Bit::_LargePageUnmapped()
+{
+	fMapCount -= k64BitTableEntryCount;
+	atomic_add(&gMappedLargePagesCount, -1);
+
+	vm_page_reservation reservation;
+	reservation.count = 1;
+	fLargePageReservation.count--;
+	vm_page_unreserve_pages(&reservation);
+}
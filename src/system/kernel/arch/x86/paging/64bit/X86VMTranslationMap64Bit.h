@@ -7,6 +7,8 @@
 #define KERNEL_ARCH_X86_PAGING_64BIT_X86_VM_TRANSLATION_MAP_64BIT_H
 
 
+#include <vm/vm_page.h>
+
 #include "paging/X86VMTranslationMap.h"
 
 
@@ -28,6 +30,12 @@ struct X86VMTranslationMap64Bit final : X86VMTranslationMap {
 									vm_page_reservation* reservation);
 	virtual	status_t			Unmap(addr_t start, addr_t end);
 
+	virtual	size_t				LargePageSize() const;
+	virtual	status_t			MapLargePage(addr_t virtualAddress,
+									phys_addr_t physicalAddress,
+									uint32 attributes, uint32 memoryType,
+									vm_page_reservation* reservation);
+
 	virtual	status_t			DebugMarkRangePresent(addr_t start, addr_t end,
 									bool markPresent);
 
@@ -61,8 +69,21 @@ struct X86VMTranslationMap64Bit final : X86VMTranslationMap {
 	inline	X86PagingStructures64Bit* PagingStructures64Bit() const
 									{ return fPagingStructures; }
 
+private:
+			uint64*				_LargePageEntry(addr_t address);
+			uint64*				_LargePageEntryForRange(addr_t start,
+									addr_t end);
+			bool				_ClearLargePageAccessed(uint64* entry,
+									addr_t address, bool& _modified);
+			void				_SplitLargePage(uint64* entry,
+									addr_t address);
+			void				_LargePageUnmapped();
+
 private:
 			X86PagingStructures64Bit* fPagingStructures;
+			vm_page_reservation	fLargePageReservation;
+									// one page per large page mapped, for
+									// the page table needed to split it
 };
 
 
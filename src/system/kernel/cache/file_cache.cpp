@@ -392,9 +392,11 @@ read_into_cache(file_cache_ref* ref, void* cookie, off_t offset,
 	int32 pageIndex = 0;
 
 	// allocate pages for the cache and mark them busy
+	vm_page_allocate_pages(reservation, PAGE_STATE_CACHED | VM_PAGE_ALLOC_BUSY,
+		pages, numBytes / B_PAGE_SIZE);
+
 	for (generic_size_t pos = 0; pos < numBytes; pos += B_PAGE_SIZE) {
-		vm_page* page = pages[pageIndex++] = vm_page_allocate_page(
-			reservation, PAGE_STATE_CACHED | VM_PAGE_ALLOC_BUSY);
+		vm_page* page = pages[pageIndex++];
 
 		cache->InsertPage(page, offset + pos);
 
@@ -511,16 +513,18 @@ write_to_cache(file_cache_ref* ref, void* cookie, off_t offset,
 	bool writeThrough = false;
 
 	// allocate pages for the cache and mark them busy
+	// TODO: if space is becoming tight, and this cache is already grown
+	//	big - shouldn't we better steal the pages directly in that case?
+	//	(a working set like approach for the file cache)
+	// TODO: the pages we allocate here should have been reserved upfront
+	//	in cache_io()
+	vm_page_allocate_pages(reservation,
+		(writeThrough ? PAGE_STATE_CACHED : PAGE_STATE_MODIFIED)
+			| VM_PAGE_ALLOC_BUSY,
+		pages, numBytes / B_PAGE_SIZE);
+
 	for (generic_size_t pos = 0; pos < numBytes; pos += B_PAGE_SIZE) {
-		// TODO: if space is becoming tight, and this cache is already grown
-		//	big - shouldn't we better steal the pages directly in that case?
-		//	(a working set like approach for the file cache)
-		// TODO: the pages we allocate here should have been reserved upfront
-		//	in cache_io()
-		vm_page* page = pages[pageIndex++] = vm_page_allocate_page(
-			reservation,
-			(writeThrough ? PAGE_STATE_CACHED : PAGE_STATE_MODIFIED)
-				| VM_PAGE_ALLOC_BUSY);
+		vm_page* page = pages[pageIndex++];
 
 		page->modified = !writeThrough;
 
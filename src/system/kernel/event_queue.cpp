@@ -0,0 +1,838 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Event queues: a persistent set of objects of interest, and a list of the
+	ones that have become ready, that is filled directly from the
+	notify_select_event() hooks. In contrast to wait_for_objects(), select(),
+	and poll(), the objects are only selected once, and waiting costs only as
+	much as there are ready objects.
+*/
+
+
+#include <event_queue.h>
+
+#include <fcntl.h>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+#include <AutoDeleter.h>
+
+#include <condition_variable.h>
+#include <fs/fd.h>
+#include <lock.h>
+#include <syscall_restart.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+#include <util/DoublyLinkedList.h>
+#include <util/OpenHashTable.h>
+#include <wait_for_objects.h>
+
+
+//#define TRACE_EVENT_QUEUE
+#ifdef TRACE_EVENT_QUEUE
+#	define TRACE(x...) dprintf("event_queue: " x)
+#else
+#	define TRACE(x...) ;
+#endif
+
+
+static const int kMaxEventsPerWait = 1024;
+
+
+struct EventQueueEntry {
+	select_info			info;
+		// must be the first member, see EventQueue::Notify()
+
+	EventQueueEntry*	hash_next;
+	EventQueueEntry*	dequeue_next;
+	DoublyLinkedListLink<EventQueueEntry> link;
+		// in the ready or orphan list
+
+	int32				object;
+	int32				events;
+	void*				user_data;
+	io_context*			context;
+		// the I/O context the object FD has been selected in
+
+	// the following are protected by the queue's spinlock
+	bool				queued;
+	bool				linked;
+		// the info is attached to the FD
+	bool				invalid;
+		// the FD is gone, and won't access the info anymore
+	bool				orphaned;
+		// removed from the queue, but the FD may still access the info
+	bool				disabled;
+		// a one-shot entry that fired, but could not be deselected
+};
+
+
+struct EventQueueEntryHashDefinition {
+	typedef int32				KeyType;
+	typedef	EventQueueEntry		ValueType;
+
+	size_t HashKey(int32 key) const
+	{
+		return key;
+	}
+
+	size_t Hash(EventQueueEntry* value) const
+	{
+		return HashKey(value->object);
+	}
+
+	bool Compare(int32 key, EventQueueEntry* value) const
+	{
+		return value->object == key;
+	}
+
+	EventQueueEntry*& GetLink(EventQueueEntry* value) const
+	{
+		return value->hash_next;
+	}
+};
+
+
+typedef BOpenHashTable<EventQueueEntryHashDefinition> EventQueueEntryTable;
+typedef DoublyLinkedList<EventQueueEntry,
+	DoublyLinkedListMemberGetLink<EventQueueEntry, &EventQueueEntry::link> >
+		EventQueueEntryList;
+
+
+struct FDPutter {
+	FDPutter(file_descriptor* descriptor)
+		: descriptor(descriptor)
+	{
+	}
+
+	~FDPutter()
+	{
+		if (descriptor != NULL)
+			put_fd(descriptor);
+	}
+
+	file_descriptor*	descriptor;
+};
+
+
+class EventQueue : public select_sync {
+public:
+								EventQueue(bool kernel);
+	virtual						~EventQueue();
+
+			status_t			Init();
+			void				Close();
+
+			status_t			Control(int operation,
+									const event_wait_info& info);
+			ssize_t				Wait(event_wait_info* infos, int numInfos,
+									uint32 flags, bigtime_t timeout);
+
+	virtual	status_t			Notify(select_info* info, uint16 events);
+
+private:
+			status_t			_Add(const event_wait_info& info);
+			status_t			_Select(EventQueueEntry* entry);
+			status_t			_Deselect(EventQueueEntry* entry);
+			void				_Remove(EventQueueEntry* entry);
+			ssize_t				_DequeueEvents(event_wait_info* infos,
+									int numInfos);
+			void				_FreeOrphans();
+
+private:
+			mutex				fLock;
+			EventQueueEntryTable fEntries;
+			bool				fKernel;
+			bool				fClosed;
+
+			spinlock			fQueueLock;
+			EventQueueEntryList	fReadyList;
+			EventQueueEntryList	fOrphans;
+			ConditionVariable	fQueueCondition;
+};
+
+
+static inline uint16
+selected_events(int32 events)
+{
+	return (events & ~B_EVENT_QUEUE_FLAGS)
+		| B_EVENT_INVALID | B_EVENT_ERROR | B_EVENT_DISCONNECTED;
+}
+
+
+EventQueue::EventQueue(bool kernel)
+	:
+	fKernel(kernel),
+	fClosed(false)
+{
+	ref_count = 1;
+
+	mutex_init(&fLock, "event queue");
+	B_INITIALIZE_SPINLOCK(&fQueueLock);
+	fQueueCondition.Init(this, "event queue");
+}
+
+
+EventQueue::~EventQueue()
+{
+	// Since all attached infos hold a reference to us, none of the entries
+	// can be accessed from the outside anymore.
+	EventQueueEntry* entry = fEntries.Clear(true);
+	while (entry != NULL) {
+		EventQueueEntry* next = entry->hash_next;
+		delete entry;
+		entry = next;
+	}
+
+	while (EventQueueEntry* entry = fOrphans.RemoveHead())
+		delete entry;
+
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+EventQueue::Init()
+{
+	return fEntries.Init();
+}
+
+
+/*!	Called when the queue's FD is closed. All objects are deselected, so
+	that they release their references to the queue.
+	When the I/O context is going away, free_io_context() has already
+	detached all infos from its FDs via deselect_all_fds() before it closes
+	them, so there is nothing left to deselect in that case (and we must not
+	try, as the context is locked).
+*/
+void
+EventQueue::Close()
+{
+	MutexLocker locker(fLock);
+	InterruptsSpinLocker queueLocker(fQueueLock);
+
+	fClosed = true;
+
+	while (EventQueueEntry* entry = fReadyList.RemoveHead())
+		entry->queued = false;
+
+	fQueueCondition.NotifyAll(B_FILE_ERROR);
+
+	queueLocker.Unlock();
+
+	EventQueueEntry* entry = fEntries.Clear(true);
+	while (entry != NULL) {
+		EventQueueEntry* next = entry->hash_next;
+		_Remove(entry);
+		entry = next;
+	}
+
+	_FreeOrphans();
+}
+
+
+status_t
+EventQueue::Control(int operation, const event_wait_info& info)
+{
+	if (info.type != B_OBJECT_TYPE_FD)
+		return B_BAD_VALUE;
+
+	MutexLocker locker(fLock);
+	if (fClosed)
+		return B_FILE_ERROR;
+
+	_FreeOrphans();
+
+	EventQueueEntry* entry = fEntries.Lookup(info.object);
+	if (entry != NULL) {
+		InterruptsSpinLocker queueLocker(fQueueLock);
+		bool invalid = entry->invalid;
+		queueLocker.Unlock();
+
+		if (invalid) {
+			// the FD has been closed, and its index may have been reused
+			_Remove(entry);
+			entry = NULL;
+		}
+	}
+
+	switch (operation) {
+		case B_EVENT_QUEUE_ADD:
+			if (entry != NULL)
+				return B_FILE_EXISTS;
+			return _Add(info);
+
+		case B_EVENT_QUEUE_MODIFY:
+		{
+			if (entry == NULL)
+				return B_ENTRY_NOT_FOUND;
+
+			status_t status = _Deselect(entry);
+			if (status == B_BUSY) {
+				// the FD is just being closed
+				return B_FILE_ERROR;
+			}
+			if (status != B_OK)
+				return status;
+
+			entry->events = info.events;
+			entry->user_data = info.user_data;
+			return _Select(entry);
+		}
+
+		case B_EVENT_QUEUE_REMOVE:
+			if (entry == NULL)
+				return B_ENTRY_NOT_FOUND;
+			_Remove(entry);
+			return B_OK;
+	}
+
+	return B_BAD_VALUE;
+}
+
+
+ssize_t
+EventQueue::Wait(event_wait_info* infos, int numInfos, uint32 flags,
+	bigtime_t timeout)
+{
+	bool nonBlocking = false;
+	if ((flags & B_RELATIVE_TIMEOUT) != 0) {
+		// we may have to wait several times
+		if (timeout <= 0)
+			nonBlocking = true;
+		else {
+			timeout += system_time();
+			flags = (flags & ~B_RELATIVE_TIMEOUT) | B_ABSOLUTE_TIMEOUT;
+		}
+	}
+
+	while (true) {
+		InterruptsSpinLocker queueLocker(fQueueLock);
+
+		while (fReadyList.IsEmpty()) {
+			if (fClosed)
+				return B_FILE_ERROR;
+			if (nonBlocking)
+				return B_WOULD_BLOCK;
+
+			ConditionVariableEntry waitEntry;
+			fQueueCondition.Add(&waitEntry);
+			queueLocker.Unlock();
+
+			status_t status = waitEntry.Wait(
+				(flags & (B_RELATIVE_TIMEOUT | B_ABSOLUTE_TIMEOUT))
+					| B_CAN_INTERRUPT, timeout);
+			if (status != B_OK)
+				return status;
+
+			queueLocker.Lock();
+		}
+
+		queueLocker.Unlock();
+
+		MutexLocker locker(fLock);
+		_FreeOrphans();
+
+		ssize_t count = _DequeueEvents(infos, numInfos);
+		if (count != 0)
+			return count;
+
+		// all events were spurious, or someone else got them first
+	}
+}
+
+
+/*!	Called by the objects via notify_select_event(), possibly with
+	interrupts disabled.
+*/
+status_t
+EventQueue::Notify(select_info* info, uint16 events)
+{
+	EventQueueEntry* entry = (EventQueueEntry*)info;
+
+	InterruptsSpinLocker locker(fQueueLock);
+
+	atomic_or(&info->events, events);
+
+	if ((events & B_EVENT_INVALID) != 0) {
+		// This is the last time the info is accessed by the object.
+		entry->invalid = true;
+		entry->linked = false;
+	}
+
+	if (fClosed || entry->orphaned || entry->queued
+		|| (entry->disabled && (events & B_EVENT_INVALID) == 0)
+		|| (selected_events(entry->events) & events) == 0)
+		return B_OK;
+
+	fReadyList.Add(entry);
+	entry->queued = true;
+
+	fQueueCondition.NotifyOne();
+	return B_OK;
+}
+
+
+status_t
+EventQueue::_Add(const event_wait_info& info)
+{
+	// only FDs that actually support select() make sense here
+	io_context* context = get_current_io_context(fKernel);
+	file_descriptor* descriptor = get_fd(context, info.object);
+	if (descriptor == NULL)
+		return B_FILE_ERROR;
+
+	bool selectable = descriptor->ops->fd_select != NULL;
+	put_fd(descriptor);
+
+	if (!selectable)
+		return B_NOT_SUPPORTED;
+
+	EventQueueEntry* entry = new(std::nothrow) EventQueueEntry;
+	if (entry == NULL)
+		return B_NO_MEMORY;
+
+	entry->info.next = NULL;
+	entry->info.sync = this;
+	entry->info.events = 0;
+	entry->info.selected_events = 0;
+	entry->hash_next = NULL;
+	entry->object = info.object;
+	entry->events = info.events;
+	entry->user_data = info.user_data;
+	entry->context = NULL;
+	entry->queued = false;
+	entry->linked = false;
+	entry->invalid = false;
+	entry->orphaned = false;
+	entry->disabled = false;
+
+	status_t status = fEntries.Insert(entry);
+	if (status != B_OK) {
+		delete entry;
+		return status;
+	}
+
+	status = _Select(entry);
+	if (status != B_OK) {
+		fEntries.Remove(entry);
+
+		// The info is not attached to the FD, and won't be accessed anymore
+		InterruptsSpinLocker queueLocker(fQueueLock);
+		if (entry->queued)
+			fReadyList.Remove(entry);
+		queueLocker.Unlock();
+
+		delete entry;
+	}
+
+	return status;
+}
+
+
+/*!	Attaches the entry's info to its FD. If any of the selected events are
+	already pending, the entry is queued right away.
+	You need to hold fLock when calling this method.
+*/
+status_t
+EventQueue::_Select(EventQueueEntry* entry)
+{
+	ASSERT_LOCKED_MUTEX(&fLock);
+
+	entry->info.next = NULL;
+	entry->info.events = 0;
+	entry->info.selected_events = selected_events(entry->events);
+	entry->context = get_current_io_context(fKernel);
+
+	status_t status = select_fd(entry->object, &entry->info, fKernel);
+
+	InterruptsSpinLocker queueLocker(fQueueLock);
+
+	entry->disabled = false;
+
+	if (status != B_OK) {
+		// The FD is gone; report it like a closed one, so that it doesn't
+		// linger in the queue unnoticed.
+		entry->invalid = true;
+		atomic_or(&entry->info.events, B_EVENT_INVALID);
+
+		if (!fClosed && !entry->queued) {
+			fReadyList.Add(entry);
+			entry->queued = true;
+			fQueueCondition.NotifyOne();
+		}
+		return status;
+	}
+
+	if (!entry->invalid)
+		entry->linked = true;
+
+	return B_OK;
+}
+
+
+/*!	Detaches the entry's info from its FD, and removes the entry from the
+	ready list.
+	Returns \c B_BUSY if the FD is concurrently being closed and may still
+	access the info; in this case it will eventually be notified with
+	\c B_EVENT_INVALID. Returns \c B_NOT_ALLOWED when the FD belongs to
+	another I/O context than the current one (the queue has been inherited),
+	as it cannot be reached from here; the info stays attached to it.
+	You need to hold fLock when calling this method.
+*/
+status_t
+EventQueue::_Deselect(EventQueueEntry* entry)
+{
+	ASSERT_LOCKED_MUTEX(&fLock);
+
+	InterruptsSpinLocker queueLocker(fQueueLock);
+
+	if (entry->queued) {
+		fReadyList.Remove(entry);
+		entry->queued = false;
+	}
+
+	if (!entry->linked)
+		return B_OK;
+	if (entry->context != get_current_io_context(fKernel))
+		return B_NOT_ALLOWED;
+
+	queueLocker.Unlock();
+
+	status_t status = deselect_fd(entry->object, &entry->info, fKernel);
+
+	queueLocker.Lock();
+
+	if (entry->queued) {
+		fReadyList.Remove(entry);
+		entry->queued = false;
+	}
+
+	if (status == B_OK)
+		entry->linked = false;
+
+	return entry->linked ? B_BUSY : B_OK;
+}
+
+
+/*!	Removes the entry from the queue, and deletes it, or leaves that to
+	_FreeOrphans() if its FD may still access it.
+	You need to hold fLock when calling this method.
+*/
+void
+EventQueue::_Remove(EventQueueEntry* entry)
+{
+	fEntries.Remove(entry);
+
+	if (_Deselect(entry) == B_OK) {
+		delete entry;
+		return;
+	}
+
+	InterruptsSpinLocker queueLocker(fQueueLock);
+	if (!entry->linked) {
+		// the B_EVENT_INVALID notification came in just now
+		queueLocker.Unlock();
+		delete entry;
+		return;
+	}
+
+	entry->orphaned = true;
+	fOrphans.Add(entry);
+}
+
+
+/*!	Moves up to \a numInfos ready entries from the ready list to \a infos,
+	and rearms them according to their mode.
+	Level-triggered entries are selected again before they are reported, so
+	that events that have been consumed in the mean time are not reported;
+	if they are still pending, this also queues the entry for the next wait.
+	When the queue has been inherited, its FDs cannot be selected again from
+	here; level-triggered entries then stay queued with their events instead.
+	You need to hold fLock when calling this method.
+*/
+ssize_t
+EventQueue::_DequeueEvents(event_wait_info* infos, int numInfos)
+{
+	ASSERT_LOCKED_MUTEX(&fLock);
+
+	// Detach the entries from the ready list first; rearming them may queue
+	// them again.
+	EventQueueEntry* pending = NULL;
+	EventQueueEntry** _last = &pending;
+
+	InterruptsSpinLocker queueLocker(fQueueLock);
+
+	for (int i = 0; i < numInfos; i++) {
+		EventQueueEntry* entry = fReadyList.RemoveHead();
+		if (entry == NULL)
+			break;
+
+		entry->queued = false;
+		entry->dequeue_next = NULL;
+		*_last = entry;
+		_last = &entry->dequeue_next;
+	}
+
+	queueLocker.Unlock();
+
+	ssize_t count = 0;
+
+	while (pending != NULL) {
+		EventQueueEntry* entry = pending;
+		pending = entry->dequeue_next;
+
+		int32 selected = selected_events(entry->events);
+		int32 events = atomic_get_and_set(&entry->info.events, 0) & selected;
+
+		if (!entry->invalid) {
+			if ((entry->events & B_EVENT_ONE_SHOT) != 0) {
+				// disabled until it's modified again
+				if (_Deselect(entry) == B_NOT_ALLOWED) {
+					// the info stays attached, but must not fire again
+					InterruptsSpinLocker queueLocker(fQueueLock);
+					entry->disabled = true;
+				}
+			} else if ((entry->events & B_EVENT_EDGE_TRIGGERED) == 0) {
+				status_t status = _Deselect(entry);
+				if (status == B_BUSY) {
+					// the FD is being closed, B_EVENT_INVALID will follow
+					continue;
+				}
+
+				if (status == B_NOT_ALLOWED) {
+					// We cannot select the FD again to check whether the
+					// events are still pending, so we report them, and keep
+					// them queued for the next wait.
+					InterruptsSpinLocker queueLocker(fQueueLock);
+					atomic_or(&entry->info.events, events);
+					if (events != 0 && !entry->invalid && !entry->queued
+						&& !fClosed) {
+						fReadyList.Add(entry);
+						entry->queued = true;
+					}
+				} else {
+					events = 0;
+					if (!entry->invalid) {
+						_Select(entry);
+						events = atomic_get(&entry->info.events) & selected;
+					}
+				}
+			}
+		}
+
+		if (entry->invalid) {
+			// the FD has been closed
+			InterruptsSpinLocker queueLocker(fQueueLock);
+			if (entry->queued) {
+				fReadyList.Remove(entry);
+				entry->queued = false;
+			}
+			queueLocker.Unlock();
+
+			events |= B_EVENT_INVALID;
+		}
+
+		if (events != 0) {
+			infos[count].object = entry->object;
+			infos[count].type = B_OBJECT_TYPE_FD;
+			infos[count].events = events;
+			infos[count].user_data = entry->user_data;
+			count++;
+		}
+
+		if (entry->invalid) {
+			fEntries.Remove(entry);
+			delete entry;
+		}
+	}
+
+	return count;
+}
+
+
+/*!	Deletes all orphaned entries that are no longer accessed by their FDs.
+	You need to hold fLock when calling this method.
+*/
+void
+EventQueue::_FreeOrphans()
+{
+	EventQueueEntryList freeList;
+
+	InterruptsSpinLocker queueLocker(fQueueLock);
+
+	EventQueueEntryList::Iterator iterator = fOrphans.GetIterator();
+	while (EventQueueEntry* entry = iterator.Next()) {
+		if (!entry->linked) {
+			iterator.Remove();
+			freeList.Add(entry);
+		}
+	}
+
+	queueLocker.Unlock();
+
+	while (EventQueueEntry* entry = freeList.RemoveHead())
+		delete entry;
+}
+
+
+//	#pragma mark - FD ops
+
+
+static status_t
+event_queue_close(file_descriptor* descriptor)
+{
+	EventQueue* queue = (EventQueue*)descriptor->cookie;
+	queue->Close();
+	return B_OK;
+}
+
+
+static void
+event_queue_free(file_descriptor* descriptor)
+{
+	EventQueue* queue = (EventQueue*)descriptor->cookie;
+	put_select_sync(queue);
+}
+
+
+static struct fd_ops sEventQueueFDOps = {
+	NULL,	// fd_read
+	NULL,	// fd_write
+	NULL,	// fd_seek
+	NULL,	// fd_ioctl
+	NULL,	// fd_set_flags
+	NULL,	// fd_select
+	NULL,	// fd_deselect
+	NULL,	// fd_read_dir
+	NULL,	// fd_rewind_dir
+	NULL,	// fd_read_stat
+	NULL,	// fd_write_stat
+	&event_queue_close,
+	&event_queue_free
+};
+
+
+static status_t
+get_event_queue(int fd, bool kernel, file_descriptor*& _descriptor)
+{
+	file_descriptor* descriptor = get_fd(get_current_io_context(kernel), fd);
+	if (descriptor == NULL)
+		return B_FILE_ERROR;
+
+	if (descriptor->type != FDTYPE_EVENT_QUEUE) {
+		put_fd(descriptor);
+		return B_BAD_VALUE;
+	}
+
+	_descriptor = descriptor;
+	return B_OK;
+}
+
+
+//	#pragma mark - syscalls
+
+
+int
+_user_event_queue_create(int openFlags)
+{
+	EventQueue* queue = new(std::nothrow) EventQueue(false);
+	if (queue == NULL)
+		return B_NO_MEMORY;
+
+	status_t status = queue->Init();
+	if (status != B_OK) {
+		put_select_sync(queue);
+		return status;
+	}
+
+	file_descriptor* descriptor = alloc_fd();
+	if (descriptor == NULL) {
+		put_select_sync(queue);
+		return B_NO_MEMORY;
+	}
+
+	descriptor->type = FDTYPE_EVENT_QUEUE;
+	descriptor->ops = &sEventQueueFDOps;
+	descriptor->cookie = queue;
+	descriptor->open_mode = O_RDWR;
+
+	io_context* context = get_current_io_context(false);
+	int fd = new_fd(context, descriptor);
+	if (fd < 0) {
+		free(descriptor);
+		put_select_sync(queue);
+		return fd;
+	}
+
+	mutex_lock(&context->io_mutex);
+	fd_set_close_on_exec(context, fd, (openFlags & O_CLOEXEC) != 0);
+	mutex_unlock(&context->io_mutex);
+
+	TRACE("created queue %p, fd %d\n", queue, fd);
+	return fd;
+}
+
+
+status_t
+_user_event_queue_control(int queue, int operation, event_wait_info* userInfo)
+{
+	event_wait_info info;
+	if (userInfo == NULL || !IS_USER_ADDRESS(userInfo)
+		|| user_memcpy(&info, userInfo, sizeof(info)) != B_OK)
+		return B_BAD_ADDRESS;
+
+	file_descriptor* descriptor;
+	status_t status = get_event_queue(queue, false, descriptor);
+	if (status != B_OK)
+		return status;
+	FDPutter _(descriptor);
+
+	return ((EventQueue*)descriptor->cookie)->Control(operation, info);
+}
+
+
+ssize_t
+_user_event_queue_wait(int queue, event_wait_info* userInfos, int numInfos,
+	uint32 flags, bigtime_t timeout)
+{
+	syscall_restart_handle_timeout_pre(flags, timeout);
+
+	if (numInfos <= 0)
+		return B_BAD_VALUE;
+	if (numInfos > kMaxEventsPerWait)
+		numInfos = kMaxEventsPerWait;
+
+	if (userInfos == NULL || !IS_USER_ADDRESS(userInfos))
+		return B_BAD_ADDRESS;
+
+	file_descriptor* descriptor;
+	status_t status = get_event_queue(queue, false, descriptor);
+	if (status != B_OK)
+		return status;
+	FDPutter _(descriptor);
+
+	event_wait_info* infos
+		= (event_wait_info*)malloc(sizeof(event_wait_info) * numInfos);
+	if (infos == NULL)
+		return B_NO_MEMORY;
+	MemoryDeleter infosDeleter(infos);
+
+	ssize_t result = ((EventQueue*)descriptor->cookie)->Wait(infos, numInfos,
+		flags, timeout);
+
+	if (result > 0) {
+		if (user_memcpy(userInfos, infos, sizeof(event_wait_info) * result)
+				!= B_OK)
+			return B_BAD_ADDRESS;
+		return result;
+	}
+
+	return syscall_restart_handle_timeout_post(result, timeout);
+}
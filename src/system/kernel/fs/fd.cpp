@@ -191,6 +191,47 @@ new_fd(struct io_context* context, struct file_descriptor* descriptor)
 }
 
 
+/*!	Inserts the specified descriptor into the given slot of the FD table of
+	the provided I/O context. A descriptor previously occupying the slot is
+	closed. Like new_fd(), this takes over the caller's reference to the
+	descriptor on success.
+*/
+status_t
+replace_fd(struct io_context* context, int fd,
+	struct file_descriptor* descriptor)
+{
+	mutex_lock(&context->io_mutex);
+
+	if (fd < 0 || (uint32)fd >= context->table_size) {
+		mutex_unlock(&context->io_mutex);
+		return B_FILE_ERROR;
+	}
+
+	struct file_descriptor* evicted = context->fds[fd];
+	select_info* selectInfos = context->select_infos[fd];
+	context->select_infos[fd] = NULL;
+
+	TFD(NewFD(context, fd, descriptor));
+
+	context->fds[fd] = descriptor;
+	atomic_add(&descriptor->open_count, 1);
+	fd_set_close_on_exec(context, fd, false);
+
+	if (evicted == NULL)
+		context->num_used_fds++;
+
+	mutex_unlock(&context->io_mutex);
+
+	if (evicted != NULL) {
+		deselect_select_infos(evicted, selectInfos, true);
+		close_fd(evicted);
+		put_fd(evicted);
+	}
+
+	return B_OK;
+}
+
+
 /*!	Reduces the descriptor's reference counter, and frees all resources
 	when it's no longer used.
 */
@@ -527,6 +568,7 @@ deselect_select_infos(file_descriptor* descriptor, select_info* infos,
 	select_info* info = infos;
 	while (info != NULL) {
 		select_sync* sync = info->sync;
+		select_info* next = info->next;
 
 		// deselect the selected events
 		uint16 eventsToDeselect = info->selected_events & ~B_EVENT_INVALID;
@@ -539,8 +581,10 @@ deselect_select_infos(file_descriptor* descriptor, select_info* infos,
 			}
 		}
 
+		// The info must not be accessed after this notification anymore, as
+		// its owner may delete it after having been told it is invalid.
 		notify_select_events(info, B_EVENT_INVALID);
-		info = info->next;
+		info = next;
 
 		if (putSyncObjects)
 			put_select_sync(sync);
@@ -548,6 +592,27 @@ deselect_select_infos(file_descriptor* descriptor, select_info* infos,
 }
 
 
+/*!	Deselects all select infos that are still attached to the file
+	descriptors of the \a context, and tells their owners that they have
+	become invalid. Used when the context is going away.
+	You need to hold the context's io_mutex when calling this function.
+*/
+void
+deselect_all_fds(struct io_context* context)
+{
+	ASSERT_LOCKED_MUTEX(&context->io_mutex);
+
+	for (uint32 i = 0; i < context->table_size; i++) {
+		select_info* infos = context->select_infos[i];
+		if (infos == NULL || context->fds[i] == NULL)
+			continue;
+
+		context->select_infos[i] = NULL;
+		deselect_select_infos(context->fds[i], infos, true);
+	}
+}
+
+
 status_t
 select_fd(int32 fd, struct select_info* info, bool kernel)
 {
@@ -651,7 +716,7 @@ deselect_fd(int32 fd, struct select_info* info, bool kernel)
 
 	// If not found, someone else beat us to it.
 	if (*infoLocation != info)
-		return B_OK;
+		return B_ENTRY_NOT_FOUND;
 
 	*infoLocation = info->next;
 
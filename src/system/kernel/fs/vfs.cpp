@@ -418,6 +418,8 @@ static inline void put_vnode(struct vnode* vnode);
 static status_t fs_unmount(char* path, dev_t mountID, uint32 flags,
 	bool kernel);
 static int open_vnode(struct vnode* vnode, int openMode, bool kernel);
+static int create_vnode(struct vnode* directory, const char* name,
+	int openMode, int perms, bool kernel);
 
 
 static struct fd_ops sFileOps = {
@@ -3643,6 +3645,10 @@ free_io_context(io_context* context)
 
 	mutex_lock(&context->io_mutex);
 
+	// Event queues may still watch some of our FDs; let them know these are
+	// gone, so that they release their references.
+	deselect_all_fds(context);
+
 	for (i = 0; i < context->table_size; i++) {
 		if (struct file_descriptor* descriptor = context->fds[i]) {
 			close_fd(descriptor);
@@ -4908,6 +4914,78 @@ vfs_exec_io_context(io_context* context)
 }
 
 
+/*!	Opens \a path like the current team would, with its credentials, and
+	puts the new file descriptor into slot \a fd of the given I/O context,
+	closing any descriptor that was there before. This is used by the main
+	thread of a team created by posix_spawn() to apply the open actions before
+	the team's image is loaded.
+*/
+status_t
+vfs_open_in_io_context(io_context* context, int fd, const char* path,
+	int openMode, int perms)
+{
+	KPath pathBuffer(path, KPath::DEFAULT, B_PATH_NAME_LENGTH + 1);
+	if (pathBuffer.InitCheck() != B_OK)
+		return B_NO_MEMORY;
+
+	// The path is resolved relative to the current team's root and working
+	// directory, but the file is opened in the kernel team until it is moved
+	// to its final place.
+	int kernelFD;
+	if ((openMode & O_CREAT) != 0) {
+		char name[B_FILE_NAME_LENGTH];
+		struct vnode* directory;
+		status_t status = path_to_dir_vnode(pathBuffer.LockBuffer(),
+			&directory, name, false);
+		if (status != B_OK)
+			return status;
+
+		kernelFD = create_vnode(directory, name, openMode, perms, true);
+		put_vnode(directory);
+	} else {
+		bool traverse = (openMode & (O_NOTRAVERSE | O_NOFOLLOW)) == 0;
+		struct vnode* vnode;
+		ino_t parentID;
+		status_t status = fd_and_path_to_vnode(-1, pathBuffer.LockBuffer(),
+			traverse, &vnode, &parentID, false);
+		if (status != B_OK)
+			return status;
+
+		if ((openMode & O_NOFOLLOW) != 0 && S_ISLNK(vnode->Type())) {
+			put_vnode(vnode);
+			return B_LINK_LIMIT;
+		}
+
+		kernelFD = open_vnode(vnode, openMode, true);
+		if (kernelFD >= 0) {
+			// The vnode reference has been transferred to the FD
+			cache_node_opened(vnode, FDTYPE_FILE, vnode->cache,
+				vnode->device, parentID, vnode->id, NULL);
+		} else
+			put_vnode(vnode);
+	}
+
+	if (kernelFD < 0)
+		return kernelFD;
+
+	io_context* kernelContext = get_current_io_context(true);
+	struct file_descriptor* descriptor = get_fd(kernelContext, kernelFD);
+
+	status_t status = replace_fd(context, fd, descriptor);
+	if (status == B_OK) {
+		if ((openMode & O_CLOEXEC) != 0) {
+			mutex_lock(&context->io_mutex);
+			fd_set_close_on_exec(context, fd, true);
+			mutex_unlock(&context->io_mutex);
+		}
+	} else
+		put_fd(descriptor);
+
+	close_fd_index(kernelContext, kernelFD);
+	return status;
+}
+
+
 /*! Sets up a new io_control structure, and inherits the properties
 	of the parent io_control if it is given.
 */
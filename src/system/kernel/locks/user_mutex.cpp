@@ -10,74 +10,109 @@
 #include <user_mutex_defs.h>
 
 #include <condition_variable.h>
+#include <cpu.h>
 #include <kernel.h>
 #include <lock.h>
 #include <smp.h>
 #include <syscall_restart.h>
 #include <util/AutoLock.h>
-#include <util/OpenHashTable.h>
 #include <vm/vm.h>
 #include <vm/VMArea.h>
 
 
+struct UserMutexBucket;
 struct UserMutexEntry;
 typedef DoublyLinkedList<UserMutexEntry> UserMutexEntryList;
 
 struct UserMutexEntry : public DoublyLinkedListLinkImpl<UserMutexEntry> {
 	addr_t				address;
+	UserMutexBucket*	bucket;
 	ConditionVariable	condition;
 	bool				locked;
+	bool				requeued;
+	int32*				requeueMutex;
+	addr_t				requeueAddress;
 	UserMutexEntryList	otherEntries;
 	UserMutexEntry*		hashNext;
 };
 
-struct UserMutexHashDefinition {
-	typedef addr_t			KeyType;
-	typedef UserMutexEntry	ValueType;
+/*!	The waiters are spread over a fixed number of buckets, each with its own
+	spinlock, so that threads contending for unrelated user mutexes don't
+	serialize on a single lock in the kernel. Each bucket holds a chain of the
+	first waiters for the addresses hashing to it; further waiters for the
+	same address are queued in the first one's \c otherEntries list.
+	Since the pages of the mutexes are wired while they are accessed, their
+	values can be changed with the bucket lock held.
+*/
+struct UserMutexBucket {
+	spinlock			lock;
+	UserMutexEntry*		entries;
+} CACHE_LINE_ALIGN;
 
-	size_t HashKey(addr_t key) const
-	{
-		return key >> 2;
-	}
 
-	size_t Hash(const UserMutexEntry* value) const
-	{
-		return HashKey(value->address);
-	}
+static const uint32 kUserMutexBucketBits = 8;
+static const uint32 kUserMutexBucketCount = 1 << kUserMutexBucketBits;
 
-	bool Compare(addr_t key, const UserMutexEntry* value) const
-	{
-		return value->address == key;
-	}
+static UserMutexBucket sUserMutexBuckets[kUserMutexBucketCount];
 
-	UserMutexEntry*& GetLink(UserMutexEntry* value) const
-	{
-		return value->hashNext;
-	}
-};
 
-typedef BOpenHashTable<UserMutexHashDefinition> UserMutexTable;
+static inline UserMutexBucket*
+get_user_mutex_bucket(addr_t address)
+{
+	uint64 key = (uint64)address >> 2;
+	uint32 hash = ((uint32)key ^ (uint32)(key >> 32)) * 0x9e3779b1;
+	return &sUserMutexBuckets[hash >> (32 - kUserMutexBucketBits)];
+}
 
 
-static UserMutexTable sUserMutexTable;
-static mutex sUserMutexTableLock = MUTEX_INITIALIZER("user mutex table");
+static UserMutexEntry*
+lookup_user_mutex_entry(UserMutexBucket* bucket, addr_t address)
+{
+	UserMutexEntry* entry = bucket->entries;
+	while (entry != NULL && entry->address != address)
+		entry = entry->hashNext;
+	return entry;
+}
 
 
 static void
-add_user_mutex_entry(UserMutexEntry* entry)
+insert_user_mutex_entry(UserMutexBucket* bucket, UserMutexEntry* entry)
 {
-	UserMutexEntry* firstEntry = sUserMutexTable.Lookup(entry->address);
+	entry->hashNext = bucket->entries;
+	bucket->entries = entry;
+}
+
+
+static void
+unlink_user_mutex_entry(UserMutexBucket* bucket, UserMutexEntry* entry)
+{
+	UserMutexEntry** link = &bucket->entries;
+	while (*link != entry)
+		link = &(*link)->hashNext;
+	*link = entry->hashNext;
+}
+
+
+static void
+add_user_mutex_entry(UserMutexBucket* bucket, UserMutexEntry* entry)
+{
+	entry->bucket = bucket;
+
+	UserMutexEntry* firstEntry = lookup_user_mutex_entry(bucket,
+		entry->address);
 	if (firstEntry != NULL)
 		firstEntry->otherEntries.Add(entry);
 	else
-		sUserMutexTable.Insert(entry);
+		insert_user_mutex_entry(bucket, entry);
 }
 
 
 static bool
 remove_user_mutex_entry(UserMutexEntry* entry)
 {
-	UserMutexEntry* firstEntry = sUserMutexTable.Lookup(entry->address);
+	UserMutexBucket* bucket = entry->bucket;
+	UserMutexEntry* firstEntry = lookup_user_mutex_entry(bucket,
+		entry->address);
 	if (firstEntry != entry) {
 		// The entry is not the first entry in the table. Just remove it from
 		// the first entry's list.
@@ -87,12 +122,12 @@ remove_user_mutex_entry(UserMutexEntry* entry)
 
 	// The entry is the first entry in the table. Remove it from the table and,
 	// if any, add the next entry to the table.
-	sUserMutexTable.Remove(entry);
+	unlink_user_mutex_entry(bucket, entry);
 
 	firstEntry = entry->otherEntries.RemoveHead();
 	if (firstEntry != NULL) {
 		firstEntry->otherEntries.MoveFrom(&entry->otherEntries);
-		sUserMutexTable.Insert(firstEntry);
+		insert_user_mutex_entry(bucket, firstEntry);
 		return true;
 	}
 
@@ -100,15 +135,38 @@ remove_user_mutex_entry(UserMutexEntry* entry)
 }
 
 
+/*!	Locks the bucket \a entry is currently queued in. The entry might be
+	moved to another bucket by user_mutex_requeue_locked() as long as the
+	bucket isn't locked.
+*/
+static void
+lock_user_mutex_entry_bucket(UserMutexEntry& entry,
+	InterruptsSpinLocker& locker)
+{
+	while (true) {
+		UserMutexBucket* bucket = entry.bucket;
+		locker.SetTo(bucket->lock, false);
+		if (entry.bucket == bucket)
+			return;
+		locker.Unlock();
+	}
+}
+
+
 static status_t
-user_mutex_wait_locked(int32* mutex, addr_t physicalAddress, const char* name,
-	uint32 flags, bigtime_t timeout, MutexLocker& locker, bool& lastWaiter)
+user_mutex_wait_locked(int32* mutex, addr_t physicalAddress,
+	UserMutexBucket* bucket, int32* requeueMutex, addr_t requeueAddress,
+	const char* name, uint32 flags, bigtime_t timeout,
+	InterruptsSpinLocker& locker, bool& lastWaiter, bool& requeued)
 {
 	// add the entry to the table
 	UserMutexEntry entry;
 	entry.address = physicalAddress;
 	entry.locked = false;
-	add_user_mutex_entry(&entry);
+	entry.requeued = false;
+	entry.requeueMutex = requeueMutex;
+	entry.requeueAddress = requeueAddress;
+	add_user_mutex_entry(bucket, &entry);
 
 	// wait
 	ConditionVariableEntry waitEntry;
@@ -117,7 +175,18 @@ user_mutex_wait_locked(int32* mutex, addr_t physicalAddress, const char* name,
 
 	locker.Unlock();
 	status_t error = waitEntry.Wait(flags, timeout);
-	locker.Lock();
+	lock_user_mutex_entry_bucket(entry, locker);
+
+	// Once we have been requeued, what we were waiting for with the timeout
+	// has happened; we are only waiting for our turn on the mutex now, and
+	// must not give up on it anymore.
+	while (error == B_TIMED_OUT && entry.requeued && !entry.locked) {
+		entry.condition.Add(&waitEntry);
+		locker.Unlock();
+		error = waitEntry.Wait(
+			flags & ~(uint32)(B_RELATIVE_TIMEOUT | B_ABSOLUTE_TIMEOUT), 0);
+		lock_user_mutex_entry_bucket(entry, locker);
+	}
 
 	if (error != B_OK && entry.locked)
 		error = B_OK;
@@ -131,13 +200,20 @@ user_mutex_wait_locked(int32* mutex, addr_t physicalAddress, const char* name,
 		lastWaiter = false;
 	}
 
+	requeued = entry.requeued;
 	return error;
 }
 
 
+/*!	Locks \a mutex. If \a requeueMutex is given, the waiting thread may be
+	moved over to its wait queue by _user_mutex_requeue(). When it has been
+	handed \a requeueMutex then, \c B_USER_MUTEX_REQUEUED is returned.
+*/
 static status_t
 user_mutex_lock_locked(int32* mutex, addr_t physicalAddress,
-	const char* name, uint32 flags, bigtime_t timeout, MutexLocker& locker)
+	UserMutexBucket* bucket, int32* requeueMutex, addr_t requeueAddress,
+	const char* name, uint32 flags, bigtime_t timeout,
+	InterruptsSpinLocker& locker)
 {
 	// mark the mutex locked + waiting
 	set_ac();
@@ -155,23 +231,30 @@ user_mutex_lock_locked(int32* mutex, addr_t physicalAddress,
 	}
 
 	bool lastWaiter;
-	status_t error = user_mutex_wait_locked(mutex, physicalAddress, name,
-		flags, timeout, locker, lastWaiter);
+	bool requeued;
+	status_t error = user_mutex_wait_locked(mutex, physicalAddress, bucket,
+		requeueMutex, requeueAddress, name, flags, timeout, locker, lastWaiter,
+		requeued);
 
 	if (lastWaiter) {
 		set_ac();
-		atomic_and(mutex, ~(int32)B_USER_MUTEX_WAITING);
+		atomic_and(requeued ? requeueMutex : mutex,
+			~(int32)B_USER_MUTEX_WAITING);
 		clear_ac();
 	}
 
+	if (requeued && error == B_OK)
+		return B_USER_MUTEX_REQUEUED;
+
 	return error;
 }
 
 
 static void
-user_mutex_unlock_locked(int32* mutex, addr_t physicalAddress, uint32 flags)
+user_mutex_unlock_locked(int32* mutex, addr_t physicalAddress,
+	UserMutexBucket* bucket, uint32 flags)
 {
-	UserMutexEntry* entry = sUserMutexTable.Lookup(physicalAddress);
+	UserMutexEntry* entry = lookup_user_mutex_entry(bucket, physicalAddress);
 	if (entry == NULL) {
 		// no one is waiting -- clear locked flag
 		set_ac();
@@ -200,7 +283,7 @@ user_mutex_unlock_locked(int32* mutex, addr_t physicalAddress, uint32 flags)
 		}
 
 		// dequeue the first thread and mark the mutex uncontended
-		sUserMutexTable.Remove(entry);
+		unlink_user_mutex_entry(bucket, entry);
 		set_ac();
 		atomic_and(mutex, ~(int32)B_USER_MUTEX_WAITING);
 		clear_ac();
@@ -215,9 +298,122 @@ user_mutex_unlock_locked(int32* mutex, addr_t physicalAddress, uint32 flags)
 }
 
 
+/*!	Unblocks the first \a wakeCount threads waiting on \a mutex, like
+	user_mutex_unlock_locked() does with the first one. Of the remaining ones,
+	those that released \a toMutex when they started waiting are moved to the
+	wait queue of \a toMutex, so that they are handed it one after the other,
+	instead of all of them being woken up just to find it locked. If
+	\a toMutex isn't locked, the first of them gets it right away.
+	Waiters that can't be moved stay queued on \a mutex.
+	Both buckets must be locked.
+*/
+static void
+user_mutex_requeue_locked(int32* mutex, addr_t physicalAddress,
+	UserMutexBucket* bucket, int32* toMutex, addr_t toPhysicalAddress,
+	UserMutexBucket* toBucket, int32 wakeCount)
+{
+	UserMutexEntry* entry = lookup_user_mutex_entry(bucket, physicalAddress);
+	if (entry == NULL) {
+		// no one is waiting -- clear locked flag
+		set_ac();
+		atomic_and(mutex, ~(int32)B_USER_MUTEX_LOCKED);
+		clear_ac();
+		return;
+	}
+
+	set_ac();
+	int32 oldValue = atomic_or(mutex, B_USER_MUTEX_LOCKED);
+	clear_ac();
+
+	if ((oldValue & B_USER_MUTEX_DISABLED) != 0) {
+		user_mutex_unlock_locked(mutex, physicalAddress, bucket,
+			B_USER_MUTEX_UNBLOCK_ALL);
+		return;
+	}
+
+	unlink_user_mutex_entry(bucket, entry);
+
+	UserMutexEntryList entries;
+	entries.MoveFrom(&entry->otherEntries);
+	entries.Add(entry, false);
+
+	UserMutexEntryList remainingEntries;
+	bool toMutexChecked = false;
+	bool canRequeue = toMutex != NULL;
+
+	while (UserMutexEntry* waiter = entries.RemoveHead()) {
+		if (wakeCount > 0) {
+			wakeCount--;
+			waiter->locked = true;
+			waiter->condition.NotifyOne();
+			continue;
+		}
+
+		if (!canRequeue || waiter->requeueMutex == NULL
+			|| waiter->requeueAddress != toPhysicalAddress) {
+			remainingEntries.Add(waiter);
+			continue;
+		}
+
+		waiter->requeued = true;
+
+		if (!toMutexChecked) {
+			toMutexChecked = true;
+
+			// mark the target mutex locked + waiting, as if the waiter had
+			// called user_mutex_lock_locked() on it
+			set_ac();
+			int32 oldToValue = atomic_or(toMutex,
+				B_USER_MUTEX_LOCKED | B_USER_MUTEX_WAITING);
+			clear_ac();
+
+			if ((oldToValue & B_USER_MUTEX_DISABLED) != 0) {
+				set_ac();
+				atomic_and(toMutex, ~(int32)B_USER_MUTEX_WAITING);
+				clear_ac();
+				canRequeue = false;
+				waiter->requeued = false;
+				remainingEntries.Add(waiter);
+				continue;
+			}
+
+			if ((oldToValue
+					& (B_USER_MUTEX_LOCKED | B_USER_MUTEX_WAITING)) == 0) {
+				// it wasn't locked, so the waiter owns it now
+				waiter->locked = true;
+				waiter->condition.NotifyOne();
+				continue;
+			}
+		}
+
+		waiter->address = toPhysicalAddress;
+		add_user_mutex_entry(toBucket, waiter);
+	}
+
+	if (toMutexChecked && canRequeue
+		&& lookup_user_mutex_entry(toBucket, toPhysicalAddress) == NULL) {
+		set_ac();
+		atomic_and(toMutex, ~(int32)B_USER_MUTEX_WAITING);
+		clear_ac();
+	}
+
+	UserMutexEntry* firstEntry = remainingEntries.RemoveHead();
+	if (firstEntry != NULL) {
+		firstEntry->otherEntries.MoveFrom(&remainingEntries);
+		insert_user_mutex_entry(bucket, firstEntry);
+	} else {
+		// mark the mutex uncontended
+		set_ac();
+		atomic_and(mutex, ~(int32)B_USER_MUTEX_WAITING);
+		clear_ac();
+	}
+}
+
+
 static status_t
 user_mutex_sem_acquire_locked(int32* sem, addr_t physicalAddress,
-	const char* name, uint32 flags, bigtime_t timeout, MutexLocker& locker)
+	UserMutexBucket* bucket, const char* name, uint32 flags,
+	bigtime_t timeout, InterruptsSpinLocker& locker)
 {
 	// The semaphore may have been released in the meantime, and we also
 	// need to mark it as contended if it isn't already.
@@ -234,8 +430,9 @@ user_mutex_sem_acquire_locked(int32* sem, addr_t physicalAddress,
 	}
 
 	bool lastWaiter;
-	status_t error = user_mutex_wait_locked(sem, physicalAddress, name, flags,
-		timeout, locker, lastWaiter);
+	bool requeued;
+	status_t error = user_mutex_wait_locked(sem, physicalAddress, bucket,
+		NULL, 0, name, flags, timeout, locker, lastWaiter, requeued);
 
 	if (lastWaiter) {
 		set_ac();
@@ -248,9 +445,10 @@ user_mutex_sem_acquire_locked(int32* sem, addr_t physicalAddress,
 
 
 static void
-user_mutex_sem_release_locked(int32* sem, addr_t physicalAddress)
+user_mutex_sem_release_locked(int32* sem, addr_t physicalAddress,
+	UserMutexBucket* bucket)
 {
-	UserMutexEntry* entry = sUserMutexTable.Lookup(physicalAddress);
+	UserMutexEntry* entry = lookup_user_mutex_entry(bucket, physicalAddress);
 	if (!entry) {
 		// no waiters - mark as uncontended and release
 		set_ac();
@@ -293,9 +491,11 @@ user_mutex_lock(int32* mutex, const char* name, uint32 flags, bigtime_t timeout)
 
 	// get the lock
 	{
-		MutexLocker locker(sUserMutexTableLock);
-		error = user_mutex_lock_locked(mutex, wiringInfo.physicalAddress, name,
-			flags, timeout, locker);
+		UserMutexBucket* bucket
+			= get_user_mutex_bucket(wiringInfo.physicalAddress);
+		InterruptsSpinLocker locker(bucket->lock);
+		error = user_mutex_lock_locked(mutex, wiringInfo.physicalAddress,
+			bucket, NULL, 0, name, flags, timeout, locker);
 	}
 
 	// unwire the page
@@ -323,14 +523,25 @@ user_mutex_switch_lock(int32* fromMutex, int32* toMutex, const char* name,
 		return error;
 	}
 
-	// unlock the first mutex and lock the second one
+	// Unlock the first mutex and lock the second one. The mutexes may live in
+	// different buckets, so this isn't atomic with respect to the table, but
+	// the locked flag of the second mutex, which has been set by the caller,
+	// ensures that an unlock in between isn't lost.
 	{
-		MutexLocker locker(sUserMutexTableLock);
+		UserMutexBucket* bucket
+			= get_user_mutex_bucket(fromWiringInfo.physicalAddress);
+		InterruptsSpinLocker locker(bucket->lock);
 		user_mutex_unlock_locked(fromMutex, fromWiringInfo.physicalAddress,
-			flags);
+			bucket, flags);
+	}
 
+	{
+		UserMutexBucket* bucket
+			= get_user_mutex_bucket(toWiringInfo.physicalAddress);
+		InterruptsSpinLocker locker(bucket->lock);
 		error = user_mutex_lock_locked(toMutex, toWiringInfo.physicalAddress,
-			name, flags, timeout, locker);
+			bucket, fromMutex, fromWiringInfo.physicalAddress, name, flags,
+			timeout, locker);
 	}
 
 	// unwire the pages
@@ -347,11 +558,29 @@ user_mutex_switch_lock(int32* fromMutex, int32* toMutex, const char* name,
 void
 user_mutex_init()
 {
-	if (sUserMutexTable.Init() != B_OK)
-		panic("user_mutex_init(): Failed to init table!");
+	for (uint32 i = 0; i < kUserMutexBucketCount; i++) {
+		B_INITIALIZE_SPINLOCK(&sUserMutexBuckets[i].lock);
+		sUserMutexBuckets[i].entries = NULL;
+	}
+}
+
+
+#if B_DEBUG_SPINLOCK_CONTENTION
+
+
+uint64
+user_mutex_get_spinlock_counter()
+{
+	uint64 count = 0;
+	for (uint32 i = 0; i < kUserMutexBucketCount; i++)
+		count += get_spinlock_counter(&sUserMutexBuckets[i].lock);
+	return count;
 }
 
 
+#endif	// B_DEBUG_SPINLOCK_CONTENTION
+
+
 // #pragma mark - syscalls
 
 
@@ -385,8 +614,11 @@ _user_mutex_unlock(int32* mutex, uint32 flags)
 		return error;
 
 	{
-		MutexLocker locker(sUserMutexTableLock);
-		user_mutex_unlock_locked(mutex, wiringInfo.physicalAddress, flags);
+		UserMutexBucket* bucket
+			= get_user_mutex_bucket(wiringInfo.physicalAddress);
+		InterruptsSpinLocker locker(bucket->lock);
+		user_mutex_unlock_locked(mutex, wiringInfo.physicalAddress, bucket,
+			flags);
 	}
 
 	vm_unwire_page(&wiringInfo);
@@ -410,6 +642,62 @@ _user_mutex_switch_lock(int32* fromMutex, int32* toMutex, const char* name,
 }
 
 
+status_t
+_user_mutex_requeue(int32* mutex, int32* toMutex, int32 wakeCount)
+{
+	if (mutex == NULL || !IS_USER_ADDRESS(mutex) || (addr_t)mutex % 4 != 0
+		|| (toMutex != NULL
+			&& (!IS_USER_ADDRESS(toMutex) || (addr_t)toMutex % 4 != 0))) {
+		return B_BAD_ADDRESS;
+	}
+	if (wakeCount < 0)
+		return B_BAD_VALUE;
+
+	// wire the pages and get the physical addresses
+	VMPageWiringInfo wiringInfo;
+	status_t error = vm_wire_page(B_CURRENT_TEAM, (addr_t)mutex, true,
+		&wiringInfo);
+	if (error != B_OK)
+		return error;
+
+	VMPageWiringInfo toWiringInfo;
+	if (toMutex != NULL) {
+		error = vm_wire_page(B_CURRENT_TEAM, (addr_t)toMutex, true,
+			&toWiringInfo);
+		if (error != B_OK) {
+			vm_unwire_page(&wiringInfo);
+			return error;
+		}
+	} else
+		toWiringInfo.physicalAddress = 0;
+
+	{
+		UserMutexBucket* bucket
+			= get_user_mutex_bucket(wiringInfo.physicalAddress);
+		UserMutexBucket* toBucket = toMutex != NULL
+			? get_user_mutex_bucket(toWiringInfo.physicalAddress) : bucket;
+
+		// lock both buckets, in a fixed order
+		UserMutexBucket* firstBucket = min_c(bucket, toBucket);
+		UserMutexBucket* secondBucket = max_c(bucket, toBucket);
+		InterruptsSpinLocker locker(firstBucket->lock);
+		SpinLocker secondLocker(secondBucket != firstBucket
+			? &secondBucket->lock : NULL);
+
+		user_mutex_requeue_locked(mutex, wiringInfo.physicalAddress, bucket,
+			toWiringInfo.physicalAddress != wiringInfo.physicalAddress
+				? toMutex : NULL,
+			toWiringInfo.physicalAddress, toBucket, wakeCount);
+	}
+
+	if (toMutex != NULL)
+		vm_unwire_page(&toWiringInfo);
+	vm_unwire_page(&wiringInfo);
+
+	return B_OK;
+}
+
+
 status_t
 _user_mutex_sem_acquire(int32* sem, const char* name, uint32 flags,
 	bigtime_t timeout)
@@ -427,9 +715,11 @@ _user_mutex_sem_acquire(int32* sem, const char* name, uint32 flags,
 		return error;
 
 	{
-		MutexLocker locker(sUserMutexTableLock);
+		UserMutexBucket* bucket
+			= get_user_mutex_bucket(wiringInfo.physicalAddress);
+		InterruptsSpinLocker locker(bucket->lock);
 		error = user_mutex_sem_acquire_locked(sem, wiringInfo.physicalAddress,
-			name, flags | B_CAN_INTERRUPT, timeout, locker);
+			bucket, name, flags | B_CAN_INTERRUPT, timeout, locker);
 	}
 
 	vm_unwire_page(&wiringInfo);
@@ -451,8 +741,10 @@ _user_mutex_sem_release(int32* sem)
 		return error;
 
 	{
-		MutexLocker locker(sUserMutexTableLock);
-		user_mutex_sem_release_locked(sem, wiringInfo.physicalAddress);
+		UserMutexBucket* bucket
+			= get_user_mutex_bucket(wiringInfo.physicalAddress);
+		InterruptsSpinLocker locker(bucket->lock);
+		user_mutex_sem_release_locked(sem, wiringInfo.physicalAddress, bucket);
 	}
 
 	vm_unwire_page(&wiringInfo);
@@ -24,10 +24,13 @@
 #include <AutoDeleter.h>
 
 #include <arch/int.h>
+#include <cpu.h>
 #include <heap.h>
 #include <kernel.h>
 #include <Notifications.h>
 #include <sem.h>
+#include <slab/Slab.h>
+#include <smp.h>
 #include <syscall_restart.h>
 #include <team.h>
 #include <tracing.h>
@@ -57,10 +60,15 @@
 
 // Locking:
 // * sPortsLock: Protects the sPorts and sPortsByName hash tables.
+// * port_cache::lock: Protects the per-CPU cache of recently looked up ports.
+//   Every cached port holds a reference. Lookups only lock the cache of the
+//   CPU they are running on, and only fall back to sPortsLock when the port
+//   isn't in there. Ports are removed from all caches when they are deleted.
 // * sTeamListLock[]: Protects Team::port_list. Lock index for given team is
 //   (Team::id % kTeamListLockCount).
 // * Port::lock: Protects all Port members save team_link, hash_link, lock and
-//   state. id is immutable.
+//   state. id is immutable. It also protects the PortReaders waiting on the
+//   port.
 //
 // Port::state ensures atomicity by providing a linearization point for adding
 // and removing ports to the hash tables and the team port list.
@@ -99,6 +107,18 @@ struct port_message : DoublyLinkedListLinkImpl<port_message> {
 
 typedef DoublyLinkedList<port_message> MessageList;
 
+
+/*!	A thread blocking in read_port_etc(), waiting for a message. A writer
+	that finds a waiting reader hands its message over directly, instead of
+	queuing it.
+*/
+struct PortReader : DoublyLinkedListLinkImpl<PortReader> {
+	ConditionVariable	condition;
+	port_message*		message;
+};
+
+typedef DoublyLinkedList<PortReader> ReaderList;
+
 } // namespace
 
 
@@ -131,6 +151,7 @@ struct Port : public KernelReferenceable {
 		// messages read from port since creation
 	select_info*		select_infos;
 	MessageList			messages;
+	ReaderList			waiting_readers;
 
 	Port(team_id owner, int32 queueLength, char* name)
 		:
@@ -444,6 +465,19 @@ static const size_t kBufferGrowRate = kInitialPortBufferSize;
 #define MAX_QUEUE_LENGTH 4096
 #define PORT_MAX_MESSAGE_SIZE (256 * 1024)
 
+// Messages with up to this many bytes are allocated from object caches,
+// larger ones from the heap.
+static const size_t kMessageCacheSizes[] = { 64, 256, 1024, 4096 };
+static const int32 kMessageCacheCount
+	= sizeof(kMessageCacheSizes) / sizeof(kMessageCacheSizes[0]);
+
+static const uint32 kPortCacheSize = 16;
+
+struct port_cache {
+	spinlock	lock;
+	Port*		ports[kPortCacheSize];
+} CACHE_LINE_ALIGN;
+
 static int32 sMaxPorts = 4096;
 static int32 sUsedPorts;
 
@@ -455,6 +489,8 @@ static int32 sWaitingForSpace;
 static port_id sNextPortID = 1;
 static bool sPortsActive = false;
 static rw_lock sPortsLock = RW_LOCK_INITIALIZER("ports list");
+static port_cache sPortCaches[SMP_MAX_CPUS];
+static object_cache* sMessageCaches[kMessageCacheCount];
 
 enum {
 	kTeamListLockCount = 8
@@ -623,17 +659,97 @@ notify_port_select_events(Port* port, uint16 events)
 }
 
 
+/*!	Returns a reference to the port with the given ID, be it active or not.
+	Recently used ports are found in the current CPU's port cache, all
+	others are looked up in sPorts, and then added to that cache.
+*/
 static BReference<Port>
-get_locked_port(port_id id) GCC_2_NRV(portRef)
+lookup_port(port_id id) GCC_2_NRV(portRef)
 {
 #if __GNUC__ >= 3
 	BReference<Port> portRef;
 #endif
+	const uint32 slot = (uint32)id % kPortCacheSize;
+
+	cpu_status state = disable_interrupts();
+	port_cache* cache = &sPortCaches[smp_get_current_cpu()];
+	acquire_spinlock(&cache->lock);
+
+	Port* port = cache->ports[slot];
+	if (port != NULL && port->id == id)
+		portRef.SetTo(port);
+
+	release_spinlock(&cache->lock);
+	restore_interrupts(state);
+
+	if (portRef != NULL)
+		return portRef;
+
 	{
 		ReadLocker portsLocker(sPortsLock);
 		portRef.SetTo(sPorts.Lookup(id));
 	}
 
+	if (portRef == NULL || portRef->state != Port::kActive)
+		return portRef;
+
+	// Remember the port. Since a port is removed from the caches only after
+	// it has been marked deleted, it must not be added anymore after that.
+	Port* evicted = NULL;
+
+	state = disable_interrupts();
+	cache = &sPortCaches[smp_get_current_cpu()];
+	acquire_spinlock(&cache->lock);
+
+	if (atomic_get(&portRef->state) == Port::kActive
+		&& cache->ports[slot] != portRef.Get()) {
+		evicted = cache->ports[slot];
+		cache->ports[slot] = portRef.Get();
+		portRef->AcquireReference();
+	}
+
+	release_spinlock(&cache->lock);
+	restore_interrupts(state);
+
+	if (evicted != NULL)
+		evicted->ReleaseReference();
+
+	return portRef;
+}
+
+
+/*!	Removes the port from the port caches of all CPUs. The caller must have
+	a reference to the port, and it must have been marked deleted already.
+*/
+static void
+remove_port_from_caches(Port* port)
+{
+	const uint32 slot = (uint32)port->id % kPortCacheSize;
+	const int32 cpuCount = smp_get_num_cpus();
+
+	for (int32 i = 0; i < cpuCount; i++) {
+		port_cache& cache = sPortCaches[i];
+
+		InterruptsSpinLocker locker(cache.lock);
+		if (cache.ports[slot] != port)
+			continue;
+
+		cache.ports[slot] = NULL;
+		locker.Unlock();
+
+		port->ReleaseReference();
+	}
+}
+
+
+static BReference<Port>
+get_locked_port(port_id id) GCC_2_NRV(portRef)
+{
+#if __GNUC__ >= 3
+	BReference<Port> portRef;
+#endif
+	portRef = lookup_port(id);
+
 	if (portRef != NULL && portRef->state == Port::kActive)
 		mutex_lock(&portRef->lock);
 	else
@@ -649,8 +765,7 @@ get_port(port_id id) GCC_2_NRV(portRef)
 #if __GNUC__ >= 3
 	BReference<Port> portRef;
 #endif
-	ReadLocker portsLocker(sPortsLock);
-	portRef.SetTo(sPorts.Lookup(id));
+	portRef = lookup_port(id);
 
 	return portRef;
 }
@@ -664,11 +779,31 @@ is_port_closed(Port* port)
 }
 
 
+/*!	Returns the index of the object cache messages with a buffer of the
+	given size are allocated from, or -1 if they are allocated from the heap.
+*/
+static inline int32
+message_cache_index(size_t bufferSize)
+{
+	for (int32 i = 0; i < kMessageCacheCount; i++) {
+		if (bufferSize <= kMessageCacheSizes[i])
+			return i;
+	}
+
+	return -1;
+}
+
+
 static void
 put_port_message(port_message* message)
 {
 	const size_t size = sizeof(port_message) + message->size;
-	free(message);
+
+	int32 cacheIndex = message_cache_index(message->size);
+	if (cacheIndex >= 0)
+		object_cache_free(sMessageCaches[cacheIndex], message, 0);
+	else
+		free(message);
 
 	atomic_add(&sTotalSpaceCommited, -size);
 	if (sWaitingForSpace > 0)
@@ -731,7 +866,13 @@ get_port_message(int32 code, size_t bufferSize, uint32 flags, bigtime_t timeout,
 		}
 
 		// Quota is fulfilled, try to allocate the buffer
-		port_message* message = (port_message*)malloc(size);
+		port_message* message;
+		int32 cacheIndex = message_cache_index(bufferSize);
+		if (cacheIndex >= 0) {
+			message = (port_message*)object_cache_alloc(
+				sMessageCaches[cacheIndex], 0);
+		} else
+			message = (port_message*)malloc(size);
 		if (message != NULL) {
 			message->code = code;
 			message->size = bufferSize;
@@ -790,6 +931,19 @@ copy_port_message(port_message* message, int32* _code, void* buffer,
 }
 
 
+/*!	Wakes up all threads waiting in read_port_etc(). They remove themselves
+	from the port's list of waiting readers.
+	The port must be locked.
+*/
+static void
+notify_waiting_readers(Port* port, status_t result)
+{
+	ReaderList::Iterator iterator = port->waiting_readers.GetIterator();
+	while (PortReader* reader = iterator.Next())
+		reader->condition.NotifyAll(result);
+}
+
+
 static void
 uninit_port(Port* port)
 {
@@ -800,6 +954,7 @@ uninit_port(Port* port)
 
 	// Release the threads that were blocking on this port.
 	// read_port() will see the B_BAD_PORT_ID return value, and act accordingly
+	notify_waiting_readers(port, B_BAD_PORT_ID);
 	port->read_condition.NotifyAll(B_BAD_PORT_ID);
 	port->write_condition.NotifyAll(B_BAD_PORT_ID);
 	sNotificationService.Notify(PORT_REMOVED, port->id);
@@ -894,6 +1049,7 @@ delete_owned_ports(Team* team)
 
 	// Uninitialize ports and release team port list references
 	while (Port* port = (Port*)list_remove_head_item(&deletionList)) {
+		remove_port_from_caches(port);
 		atomic_add(&sUsedPorts, -1);
 		uninit_port(port);
 		port->ReleaseReference();
@@ -944,6 +1100,21 @@ port_init(kernel_args *args)
 
 	sNoSpaceCondition.Init(&sPorts, "port space");
 
+	for (int32 i = 0; i < SMP_MAX_CPUS; i++)
+		B_INITIALIZE_SPINLOCK(&sPortCaches[i].lock);
+
+	for (int32 i = 0; i < kMessageCacheCount; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "port messages %" B_PRIuSIZE,
+			kMessageCacheSizes[i]);
+		sMessageCaches[i] = create_object_cache(name,
+			sizeof(port_message) + kMessageCacheSizes[i], 8, NULL, NULL, NULL);
+		if (sMessageCaches[i] == NULL) {
+			panic("Failed to create the port message caches!");
+			return B_NO_MEMORY;
+		}
+	}
+
 	// add debugger commands
 	add_debugger_command_etc("ports", &dump_port_list,
 		"Dump a list of all active ports (for team, with name, etc.)",
@@ -1083,6 +1254,7 @@ close_port(port_id id)
 	notify_port_select_events(portRef, B_EVENT_INVALID);
 	portRef->select_infos = NULL;
 
+	notify_waiting_readers(portRef, B_BAD_PORT_ID);
 	portRef->read_condition.NotifyAll(B_BAD_PORT_ID);
 	portRef->write_condition.NotifyAll(B_BAD_PORT_ID);
 
@@ -1131,6 +1303,7 @@ delete_port(port_id id)
 		portRef->ReleaseReference();
 	}
 
+	remove_port_from_caches(portRef);
 	uninit_port(portRef);
 
 	T(Delete(portRef));
@@ -1462,10 +1635,52 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 		return B_BAD_PORT_ID;
 	}
 
+	port_message* message = NULL;
+
 	while (portRef->read_count == 0) {
 		if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout <= 0)
 			return B_WOULD_BLOCK;
 
+		if (!peekOnly) {
+			// Wait for a writer to hand us its message
+			PortReader reader;
+			reader.message = NULL;
+			reader.condition.Init(&reader, "port reader");
+
+			ConditionVariableEntry entry;
+			reader.condition.Add(&entry);
+			portRef->waiting_readers.Add(&reader);
+
+			locker.Unlock();
+
+			status_t status = entry.Wait(flags, timeout);
+
+			// The reader must not go away before the writer is done with it,
+			// and we need to be sure whether we got a message or not.
+			locker.SetTo(portRef->lock, false);
+
+			if (reader.message != NULL) {
+				message = reader.message;
+				break;
+			}
+
+			portRef->waiting_readers.Remove(&reader);
+
+			if (portRef->state != Port::kActive
+				|| (is_port_closed(portRef) && portRef->messages.IsEmpty())) {
+				// the port is no longer there
+				T(Read(id, 0, 0, 0, B_BAD_PORT_ID));
+				return B_BAD_PORT_ID;
+			}
+
+			if (status != B_OK) {
+				T(Read(portRef, 0, status));
+				return status;
+			}
+
+			continue;
+		}
+
 		// We need to wait for a message to appear
 		ConditionVariableEntry entry;
 		portRef->read_condition.Add(&entry);
@@ -1496,32 +1711,34 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 		}
 	}
 
-	// determine tail & get the length of the message
-	port_message* message = portRef->messages.Head();
 	if (message == NULL) {
-		panic("port %" B_PRId32 ": no messages found\n", portRef->id);
-		return B_ERROR;
-	}
+		// determine tail & get the length of the message
+		message = portRef->messages.Head();
+		if (message == NULL) {
+			panic("port %" B_PRId32 ": no messages found\n", portRef->id);
+			return B_ERROR;
+		}
 
-	if (peekOnly) {
-		size_t size = copy_port_message(message, _code, buffer, bufferSize,
-			userCopy);
+		if (peekOnly) {
+			size_t size = copy_port_message(message, _code, buffer,
+				bufferSize, userCopy);
 
-		T(Read(portRef, message->code, size));
+			T(Read(portRef, message->code, size));
 
-		portRef->read_condition.NotifyOne();
-			// we only peeked, but didn't grab the message
-		return size;
-	}
+			portRef->read_condition.NotifyOne();
+				// we only peeked, but didn't grab the message
+			return size;
+		}
 
-	portRef->messages.RemoveHead();
-	portRef->total_count++;
-	portRef->write_count++;
-	portRef->read_count--;
+		portRef->messages.RemoveHead();
+		portRef->total_count++;
+		portRef->write_count++;
+		portRef->read_count--;
 
-	notify_port_select_events(portRef, B_EVENT_WRITE);
-	portRef->write_condition.NotifyOne();
-		// make one spot in queue available again for write
+		notify_port_select_events(portRef, B_EVENT_WRITE);
+		portRef->write_condition.NotifyOne();
+			// make one spot in queue available again for write
+	}
 
 	T(Read(portRef, message->code, std::min(bufferSize, message->size)));
 
@@ -1667,6 +1884,25 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 		}
 	}
 
+	if (!portRef->waiting_readers.IsEmpty() && portRef->read_count == 0) {
+		// Someone is already waiting for a message, give it ours directly.
+		// Its spot in the queue is free again right away.
+		PortReader* reader = portRef->waiting_readers.RemoveHead();
+		reader->message = message;
+		portRef->total_count++;
+		portRef->write_count++;
+
+		T(Write(id, portRef->read_count, portRef->write_count, message->code,
+			message->size, B_OK));
+
+		reader->condition.NotifyOne();
+
+		// like a read would, let the next writer have the freed slot
+		notify_port_select_events(portRef, B_EVENT_WRITE);
+		portRef->write_condition.NotifyOne();
+		return B_OK;
+	}
+
 	portRef->messages.Add(message);
 	portRef->read_count++;
 
@@ -45,11 +45,6 @@
 #endif
 
 
-#define BLOCKABLE_SIGNALS	\
-	(~(KILL_SIGNALS | SIGNAL_TO_MASK(SIGSTOP)	\
-	| SIGNAL_TO_MASK(SIGNAL_DEBUG_THREAD)	\
-	| SIGNAL_TO_MASK(SIGNAL_CONTINUE_THREAD)	\
-	| SIGNAL_TO_MASK(SIGNAL_CANCEL_THREAD)))
 #define STOP_SIGNALS \
 	(SIGNAL_TO_MASK(SIGSTOP) | SIGNAL_TO_MASK(SIGTSTP) \
 	| SIGNAL_TO_MASK(SIGTTIN) | SIGNAL_TO_MASK(SIGTTOU))
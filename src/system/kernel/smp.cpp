@@ -28,6 +28,7 @@
 #include <int.h>
 #include <spinlock_contention.h>
 #include <thread.h>
+#include <user_mutex.h>
 #include <util/atomic.h>
 #if DEBUG_SPINLOCK_LATENCIES
 #	include <safemode.h>
@@ -982,7 +983,7 @@ process_pending_ici(int32 currentCPU)
 #if B_DEBUG_SPINLOCK_CONTENTION
 
 
-static uint64
+uint64
 get_spinlock_counter(spinlock* lock)
 {
 	uint32 high;
@@ -1010,6 +1011,7 @@ spinlock_contention_syscall(const char* subsystem, uint32 function,
 
 	info.thread_spinlock_counter = get_spinlock_counter(&gThreadSpinlock);
 	info.team_spinlock_counter = get_spinlock_counter(&gTeamSpinlock);
+	info.user_mutex_spinlock_counter = user_mutex_get_spinlock_counter();
 
 	if (!IS_USER_ADDRESS(buffer)
 		|| user_memcpy(buffer, &info, sizeof(info)) != B_OK) {
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <spawn.h>
 #include <sys/wait.h>
 
 #include <OS.h>
@@ -32,6 +33,7 @@
 #include <elf.h>
 #include <file_cache.h>
 #include <find_directory_private.h>
+#include <fs/fd.h>
 #include <fs/KPath.h>
 #include <heap.h>
 #include <int.h>
@@ -44,6 +46,7 @@
 #include <posix/realtime_sem.h>
 #include <posix/xsi_semaphore.h>
 #include <sem.h>
+#include <spawn_defs.h>
 #include <syscall_process_info.h>
 #include <syscall_restart.h>
 #include <syscalls.h>
@@ -72,6 +75,8 @@ struct team_key {
 	team_id id;
 };
 
+struct team_spawn_info;
+
 struct team_arg {
 	char	*path;
 	char	**flat_args;
@@ -82,10 +87,21 @@ struct team_arg {
 	uint32	flags;
 	port_id	error_port;
 	uint32	error_token;
+	const team_spawn_info* spawn_info;
+		// only valid until the team has been loaded
 };
 
 #define TEAM_ARGS_FLAG_NO_ASLR	0x01
 
+// what posix_spawn() asks for in addition to what load_image() does
+struct team_spawn_info {
+	const char*						path;
+	mode_t							umask;
+	const struct spawn_file_action*	file_actions;
+	int32							file_action_count;
+	struct spawn_attributes			attributes;
+};
+
 
 namespace {
 
@@ -168,6 +184,10 @@ static const size_t kTeamUserDataReservedSize	= 128 * B_PAGE_SIZE;
 static const size_t kTeamUserDataInitialSize	= 4 * B_PAGE_SIZE;
 
 
+static thread_id wait_for_child(pid_t child, uint32 flags, siginfo_t& _info,
+	team_usage_info& _usage_info);
+
+
 // #pragma mark - TeamListIterator
 
 
@@ -465,6 +485,9 @@ Team::Team(team_id id, bool kernel)
 	dead_threads_user_time = 0;
 	cpu_clock_offset = 0;
 
+	minor_faults = 0;
+	major_faults = 0;
+
 	// dead threads
 	list_init(&dead_threads);
 	dead_threads_count = 0;
@@ -1161,6 +1184,8 @@ _dump_team_info(Team* team)
 	kprintf("thread_list:      %p\n", team->thread_list);
 	kprintf("group_id:         %" B_PRId32 "\n", team->group_id);
 	kprintf("session_id:       %" B_PRId32 "\n", team->session_id);
+	kprintf("minor faults:     %" B_PRId64 "\n", team->minor_faults);
+	kprintf("major faults:     %" B_PRId64 "\n", team->major_faults);
 }
 
 
@@ -1503,6 +1528,7 @@ create_team_arg(struct team_arg** _teamArg, const char* path, char** flatArgs,
 	teamArg->umask = umask;
 	teamArg->error_port = port;
 	teamArg->error_token = token;
+	teamArg->spawn_info = NULL;
 
 	// determine the flags from the environment
 	const char* const* env = flatArgs + argCount + 1;
@@ -1518,6 +1544,91 @@ create_team_arg(struct team_arg** _teamArg, const char* path, char** flatArgs,
 }
 
 
+/*!	Applies the file actions of posix_spawn() in the given order to the I/O
+	context of a team that hasn't started yet. This is done by the team's main
+	thread, so that files are opened with the team's credentials, which
+	may differ from the parent's due to POSIX_SPAWN_RESETIDS.
+*/
+static status_t
+apply_spawn_file_actions(io_context* context,
+	const struct spawn_file_action* actions, int32 count)
+{
+	for (int32 i = 0; i < count; i++) {
+		const struct spawn_file_action& action = actions[i];
+		status_t status;
+
+		switch (action.type) {
+			case SPAWN_FILE_ACTION_OPEN:
+				status = vfs_open_in_io_context(context, action.fd, action.path,
+					action.open_mode, action.permissions);
+				break;
+
+			case SPAWN_FILE_ACTION_CLOSE:
+				status = close_fd_index(context, action.fd);
+				break;
+
+			case SPAWN_FILE_ACTION_DUP2:
+			{
+				file_descriptor* descriptor = get_fd(context, action.source_fd);
+				if (descriptor == NULL
+					|| (descriptor->open_mode & O_DISCONNECTED) != 0) {
+					if (descriptor != NULL)
+						put_fd(descriptor);
+					status = B_FILE_ERROR;
+					break;
+				}
+
+				if (action.source_fd == action.fd) {
+					// the descriptor is just supposed to survive the exec
+					put_fd(descriptor);
+					mutex_lock(&context->io_mutex);
+					fd_set_close_on_exec(context, action.fd, false);
+					mutex_unlock(&context->io_mutex);
+					status = B_OK;
+					break;
+				}
+
+				status = replace_fd(context, action.fd, descriptor);
+				if (status != B_OK)
+					put_fd(descriptor);
+				break;
+			}
+
+			default:
+				status = B_BAD_VALUE;
+				break;
+		}
+
+		if (status != B_OK)
+			return status;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Wakes up the thread waiting for the current team to be loaded, and lets
+	it know that loading failed with \a result.
+*/
+static void
+team_loading_failed(status_t result)
+{
+	Team* team = thread_get_current_thread()->team;
+
+	TeamLocker teamLocker(team);
+
+	if (team->loading_info != NULL) {
+		struct team_loading_info* loadingInfo = team->loading_info;
+		team->loading_info = NULL;
+
+		loadingInfo->result = result;
+		loadingInfo->done = true;
+
+		thread_continue(loadingInfo->thread);
+	}
+}
+
+
 static status_t
 team_create_thread_start_internal(void* args)
 {
@@ -1534,6 +1645,26 @@ team_create_thread_start_internal(void* args)
 
 	thread = thread_get_current_thread();
 	team = thread->team;
+
+	if (teamArgs->spawn_info != NULL) {
+		// The spawning thread waits until we're loaded, so its spawn info is
+		// still valid. The set-user/group-id permission of the executable
+		// must not apply to the file actions yet.
+		const team_spawn_info* spawnInfo = teamArgs->spawn_info;
+		teamArgs->spawn_info = NULL;
+
+		err = apply_spawn_file_actions(team->io_context,
+			spawnInfo->file_actions, spawnInfo->file_action_count);
+		if (err != B_OK) {
+			free_team_arg(teamArgs);
+			team_loading_failed(err);
+			return err;
+		}
+
+		vfs_exec_io_context(team->io_context);
+		update_set_id_user_and_group(team, teamArgs->path);
+	}
+
 	cache_node_launched(teamArgs->arg_count, teamArgs->flat_args);
 
 	TRACE(("team_create_thread_start: entry thread %" B_PRId32 "\n",
@@ -1671,10 +1802,18 @@ team_create_thread_start(void* args)
 }
 
 
+/*!	Creates a new team running the image given by the flat arguments. If
+	\a spawnInfo is given, the team is set up the way posix_spawn() requires:
+	it is loaded from the path given there instead of the first argument, and
+	starts with the environment an exec*() would leave after applying the
+	file actions and attributes. In this case the team's main thread also
+	runs right away, once loading has succeeded.
+*/
 static thread_id
 load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	int32 envCount, int32 priority, team_id parentID, uint32 flags,
-	port_id errorPort, uint32 errorToken)
+	port_id errorPort, uint32 errorToken,
+	const team_spawn_info* spawnInfo = NULL)
 {
 	char** flatArgs = _flatArgs;
 	thread_id thread;
@@ -1688,7 +1827,8 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	if (flatArgs == NULL || argCount == 0)
 		return B_BAD_VALUE;
 
-	const char* path = flatArgs[0];
+	const char* path = spawnInfo != NULL ? spawnInfo->path : flatArgs[0];
+	uint32 spawnFlags = spawnInfo != NULL ? spawnInfo->attributes.flags : 0;
 
 	TRACE(("load_image_internal: name '%s', args = %p, argCount = %" B_PRId32
 		"\n", path, flatArgs, argCount));
@@ -1732,6 +1872,26 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	// inherit the parent's user/group
 	inherit_parent_user_and_group(team, parent);
 
+	if (spawnInfo != NULL) {
+		if ((spawnFlags & POSIX_SPAWN_RESETIDS) != 0) {
+			team->effective_uid = team->real_uid;
+			team->effective_gid = team->real_gid;
+		}
+
+		// keep ignored signals ignored, as exec*() would
+		team->InheritSignalActions(parent);
+		team->ResetSignalsOnExec();
+
+		if ((spawnFlags & POSIX_SPAWN_SETSIGDEF) != 0) {
+			for (uint32 i = 1; i <= MAX_SIGNAL_NUMBER; i++) {
+				if ((spawnInfo->attributes.default_signals
+						& SIGNAL_TO_MASK(i)) != 0) {
+					team->SignalActionFor(i).sa_handler = SIG_DFL;
+				}
+			}
+		}
+	}
+
 	// get a reference to the parent's I/O context -- we need it to create ours
 	parentIOContext = parent->io_context;
 	vfs_get_io_context(parentIOContext);
@@ -1739,19 +1899,23 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	team->Unlock();
 	parent->UnlockTeamAndProcessGroup();
 
-	// check the executable's set-user/group-id permission
-	update_set_id_user_and_group(team, path);
+	// check the executable's set-user/group-id permission -- a spawned team
+	// does that itself, after the file actions
+	if (spawnInfo == NULL)
+		update_set_id_user_and_group(team, path);
 
 	status = create_team_arg(&teamArgs, path, flatArgs, flatArgsSize, argCount,
-		envCount, (mode_t)-1, errorPort, errorToken);
+		envCount, spawnInfo != NULL ? spawnInfo->umask : (mode_t)-1,
+		errorPort, errorToken);
 	if (status != B_OK)
 		goto err1;
 
 	_flatArgs = NULL;
 		// args are owned by the team_arg structure now
 
-	// create a new io_context for this team
-	team->io_context = vfs_new_io_context(parentIOContext, true);
+	// create a new io_context for this team -- the file actions of a spawn
+	// may still refer to descriptors that are closed on exec
+	team->io_context = vfs_new_io_context(parentIOContext, spawnInfo == NULL);
 	if (!team->io_context) {
 		status = B_NO_MEMORY;
 		goto err2;
@@ -1762,7 +1926,11 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	parentIOContext = NULL;
 
 	// remove any fds that have the CLOEXEC flag set (emulating BeOS behaviour)
-	vfs_exec_io_context(team->io_context);
+	// -- the main thread of a spawned team does that after the file actions
+	if (spawnInfo == NULL)
+		vfs_exec_io_context(team->io_context);
+	else
+		teamArgs->spawn_info = spawnInfo;
 
 	// create an address space for this team
 	status = VMAddressSpace::Create(team->id, USER_BASE, USER_SIZE, false,
@@ -1809,6 +1977,21 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	// afterwards, so cache the team's ID.
 	teamID = team->id;
 
+	if ((spawnFlags & POSIX_SPAWN_SETPGROUP) != 0) {
+		// we are the parent, so we may move the team around in our session
+		pid_t group = _user_setpgid(teamID,
+			spawnInfo->attributes.process_group);
+		if (group < 0) {
+			status = group;
+			goto err6;
+		}
+	}
+
+	if (spawnInfo != NULL) {
+		// the parent must not change the process group anymore
+		atomic_or(&team->flags, TEAM_FLAG_EXEC_DONE);
+	}
+
 	// Create a kernel thread, but under the context of the new team
 	// The new thread will take over ownership of teamArgs.
 	{
@@ -1816,6 +1999,13 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 			threadName, B_NORMAL_PRIORITY, teamArgs, teamID, mainThread);
 		threadAttributes.additional_stack_size = sizeof(user_space_program_args)
 			+ teamArgs->flat_args_size;
+		if (spawnInfo != NULL) {
+			// the signal mask survives exec*()
+			threadAttributes.signal_mask
+				= (spawnFlags & POSIX_SPAWN_SETSIGMASK) != 0
+					? spawnInfo->attributes.signal_mask & BLOCKABLE_SIGNALS
+					: thread_get_current_thread()->sig_block_mask;
+		}
 		thread = thread_create_thread(threadAttributes, false);
 		if (thread < 0) {
 			status = thread;
@@ -1842,13 +2032,28 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 		while (!loadingInfo.done)
 			thread_suspend();
 
-		if (loadingInfo.result < B_OK)
+		if (loadingInfo.result < B_OK) {
+			if (spawnInfo != NULL) {
+				// The caller never learns about the team, so don't leave it
+				// behind as a zombie.
+				siginfo_t info;
+				team_usage_info usageInfo;
+				wait_for_child(teamID, WEXITED, info, usageInfo);
+			}
 			return loadingInfo.result;
+		}
 	}
 
 	// notify the debugger
 	user_debug_team_created(teamID);
 
+	if (spawnInfo != NULL) {
+		// The runtime loader suspends the main thread when it's done, so
+		// that load_image() callers can still prepare things before it runs.
+		// There is nothing left to do for a spawn.
+		resume_thread(thread);
+	}
+
 	return thread;
 
 err6:
@@ -3950,6 +4155,113 @@ _user_fork(void)
 }
 
 
+thread_id
+_user_spawn(const char* userPath, const char* const* userFlatArgs,
+	size_t flatArgsSize, int32 argCount, int32 envCount, mode_t umask,
+	const struct spawn_file_action* userFileActions, int32 fileActionCount,
+	const struct spawn_attributes* userAttributes)
+{
+	if (argCount < 1 || fileActionCount < 0
+		|| fileActionCount > MAX_SPAWN_FILE_ACTIONS) {
+		return B_BAD_VALUE;
+	}
+
+	team_spawn_info spawnInfo;
+	spawnInfo.umask = umask;
+	spawnInfo.file_action_count = fileActionCount;
+
+	char path[B_PATH_NAME_LENGTH];
+	if (!IS_USER_ADDRESS(userPath))
+		return B_BAD_ADDRESS;
+	ssize_t pathLength = user_strlcpy(path, userPath, sizeof(path));
+	if (pathLength < B_OK)
+		return B_BAD_ADDRESS;
+	if (pathLength >= B_PATH_NAME_LENGTH)
+		return B_NAME_TOO_LONG;
+	spawnInfo.path = path;
+
+	if (userAttributes != NULL) {
+		if (!IS_USER_ADDRESS(userAttributes)
+			|| user_memcpy(&spawnInfo.attributes, userAttributes,
+				sizeof(spawn_attributes)) != B_OK) {
+			return B_BAD_ADDRESS;
+		}
+	} else
+		memset(&spawnInfo.attributes, 0, sizeof(spawn_attributes));
+
+	// copy the file actions and the paths of the open actions
+	spawn_file_action* fileActions = NULL;
+	if (fileActionCount > 0) {
+		if (userFileActions == NULL || !IS_USER_ADDRESS(userFileActions))
+			return B_BAD_ADDRESS;
+
+		size_t actionsSize = fileActionCount * sizeof(spawn_file_action);
+		fileActions = (spawn_file_action*)malloc(actionsSize);
+		if (fileActions == NULL)
+			return B_NO_MEMORY;
+		if (user_memcpy(fileActions, userFileActions, actionsSize) != B_OK) {
+			free(fileActions);
+			return B_BAD_ADDRESS;
+		}
+	}
+	MemoryDeleter fileActionsDeleter(fileActions);
+
+	int32 openActionCount = 0;
+	for (int32 i = 0; i < fileActionCount; i++) {
+		if (fileActions[i].type == SPAWN_FILE_ACTION_OPEN)
+			openActionCount++;
+	}
+
+	char* paths = NULL;
+	if (openActionCount > 0) {
+		paths = (char*)malloc(openActionCount * B_PATH_NAME_LENGTH);
+		if (paths == NULL)
+			return B_NO_MEMORY;
+	}
+	MemoryDeleter pathsDeleter(paths);
+
+	char* nextPath = paths;
+	for (int32 i = 0; i < fileActionCount; i++) {
+		spawn_file_action& action = fileActions[i];
+		if (action.type != SPAWN_FILE_ACTION_OPEN)
+			continue;
+
+		if (action.path == NULL || !IS_USER_ADDRESS(action.path))
+			return B_BAD_ADDRESS;
+
+		ssize_t length = user_strlcpy(nextPath, action.path,
+			B_PATH_NAME_LENGTH);
+		if (length < B_OK)
+			return B_BAD_ADDRESS;
+		if (length >= B_PATH_NAME_LENGTH)
+			return B_NAME_TOO_LONG;
+
+		action.path = nextPath;
+		nextPath += B_PATH_NAME_LENGTH;
+	}
+
+	spawnInfo.file_actions = fileActions;
+
+	// copy and relocate the flat arguments
+	char** flatArgs;
+	status_t error = copy_user_process_args(userFlatArgs, flatArgsSize,
+		argCount, envCount, flatArgs);
+	if (error != B_OK)
+		return error;
+
+	// wait for the team to be loaded, so that the caller learns whether the
+	// spawn actually succeeded
+	thread_id thread = load_image_internal(flatArgs, _ALIGN(flatArgsSize),
+		argCount, envCount, B_NORMAL_PRIORITY, B_CURRENT_TEAM,
+		B_WAIT_TILL_LOADED, -1, 0, &spawnInfo);
+
+	free(flatArgs);
+		// load_image_internal() unset our variable if it took over ownership
+
+	return thread;
+}
+
+
 pid_t
 _user_wait_for_child(thread_id child, uint32 flags, siginfo_t* userInfo,
 	team_usage_info* usageInfo)
@@ -4383,6 +4695,8 @@ _user_get_extended_team_info(team_id teamID, uint32 flags, void* buffer,
 			gid_t	real_gid;
 			uid_t	effective_uid;
 			gid_t	effective_gid;
+			int64	minor_faults;
+			int64	major_faults;
 			char	name[B_OS_NAME_LENGTH];
 		};
 
@@ -4413,6 +4727,8 @@ _user_get_extended_team_info(team_id teamID, uint32 flags, void* buffer,
 			teamClone->real_gid = team->real_gid;
 			teamClone->effective_uid = team->effective_uid;
 			teamClone->effective_gid = team->effective_gid;
+			teamClone->minor_faults = atomic_get64(&team->minor_faults);
+			teamClone->major_faults = atomic_get64(&team->major_faults);
 
 			// also fetch a reference to the I/O context
 			ioContext = team->io_context;
@@ -4429,7 +4745,10 @@ _user_get_extended_team_info(team_id teamID, uint32 flags, void* buffer,
 			|| info.AddInt32("uid", teamClone->real_uid) != B_OK
 			|| info.AddInt32("gid", teamClone->real_gid) != B_OK
 			|| info.AddInt32("euid", teamClone->effective_uid) != B_OK
-			|| info.AddInt32("egid", teamClone->effective_gid) != B_OK) {
+			|| info.AddInt32("egid", teamClone->effective_gid) != B_OK
+			|| info.AddInt64("minor faults", teamClone->minor_faults) != B_OK
+			|| info.AddInt64("major faults", teamClone->major_faults)
+				!= B_OK) {
 			return B_NO_MEMORY;
 		}
 
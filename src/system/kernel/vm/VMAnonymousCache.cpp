@@ -490,58 +490,26 @@ status_t
 VMAnonymousCache::Resize(off_t newSize, int priority)
 {
 	// If the cache size shrinks, drop all swap pages beyond the new size.
-	if (fAllocatedSwapSize > 0) {
-		off_t oldPageCount = (virtual_end + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
-		swap_block* swapBlock = NULL;
+	_FreeSwapPageRange(newSize + B_PAGE_SIZE - 1,
+		virtual_end + B_PAGE_SIZE - 1);
 
-		for (off_t pageIndex = (newSize + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
-			pageIndex < oldPageCount && fAllocatedSwapSize > 0; pageIndex++) {
-
-			WriteLocker locker(sSwapHashLock);
-
-			// Get the swap slot index for the page.
-			swap_addr_t blockIndex = pageIndex & SWAP_BLOCK_MASK;
-			if (swapBlock == NULL || blockIndex == 0) {
-				swap_hash_key key = { this, pageIndex };
-				swapBlock = sSwapHashTable.Lookup(key);
+	return VMCache::Resize(newSize, priority);
+}
 
-				if (swapBlock == NULL) {
-					pageIndex = ROUNDUP(pageIndex + 1, SWAP_BLOCK_PAGES);
-					continue;
-				}
-			}
 
-			swap_addr_t slotIndex = swapBlock->swap_slots[blockIndex];
-			vm_page* page;
-			if (slotIndex != SWAP_SLOT_NONE
-				&& ((page = LookupPage((off_t)pageIndex * B_PAGE_SIZE)) == NULL
-					|| !page->busy)) {
-					// TODO: We skip (i.e. leak) swap space of busy pages, since
-					// there could be I/O going on (paging in/out). Waiting is
-					// not an option as 1. unlocking the cache means that new
-					// swap pages could be added in a range we've already
-					// cleared (since the cache still has the old size) and 2.
-					// we'd risk a deadlock in case we come from the file cache
-					// and the FS holds the node's write-lock. We should mark
-					// the page invalid and let the one responsible clean up.
-					// There's just no such mechanism yet.
-				swap_slot_dealloc(slotIndex, 1);
-				fAllocatedSwapSize -= B_PAGE_SIZE;
-
-				swapBlock->swap_slots[blockIndex] = SWAP_SLOT_NONE;
-				if (--swapBlock->used == 0) {
-					// All swap pages have been freed -- we can discard the swap
-					// block.
-					sSwapHashTable.RemoveUnchecked(swapBlock);
-					object_cache_free(sSwapBlockCache, swapBlock,
-						CACHE_DONT_WAIT_FOR_MEMORY
-							| CACHE_DONT_LOCK_KERNEL_SPACE);
-				}
-			}
-		}
-	}
+status_t
+VMAnonymousCache::Discard(off_t offset, off_t size)
+{
+	// Free the pages first: this waits for busy pages, so that their swap
+	// space isn't skipped below. The only ones left are those that are just
+	// being written; the page writer frees them together with their swap
+	// space when it's done.
+	status_t status = VMCache::Discard(offset, size);
+	if (status != B_OK)
+		return status;
 
-	return VMCache::Resize(newSize, priority);
+	_FreeSwapPageRange(offset, offset + size);
+	return B_OK;
 }
 
 
@@ -966,6 +934,75 @@ VMAnonymousCache::_SwapBlockGetAddress(off_t pageIndex)
 }
 
 
+/*!	Drops the swap space of all pages from \a fromOffset up to \a toOffset.
+	Both are rounded down to the start of their pages.
+*/
+void
+VMAnonymousCache::_FreeSwapPageRange(off_t fromOffset, off_t toOffset)
+{
+	if (fAllocatedSwapSize == 0)
+		return;
+
+	off_t endPageIndex = toOffset >> PAGE_SHIFT;
+	swap_block* swapBlock = NULL;
+
+	for (off_t pageIndex = fromOffset >> PAGE_SHIFT;
+		pageIndex < endPageIndex && fAllocatedSwapSize > 0; pageIndex++) {
+
+		WriteLocker locker(sSwapHashLock);
+
+		// Get the swap slot index for the page.
+		swap_addr_t blockIndex = pageIndex & SWAP_BLOCK_MASK;
+		if (swapBlock == NULL || blockIndex == 0) {
+			swap_hash_key key = { this, pageIndex };
+			swapBlock = sSwapHashTable.Lookup(key);
+
+			if (swapBlock == NULL) {
+				// skip to the last page of the block; the loop's increment
+				// moves on to the first page of the next one
+				pageIndex = ROUNDUP(pageIndex + 1, SWAP_BLOCK_PAGES) - 1;
+				continue;
+			}
+		}
+
+		swap_addr_t slotIndex = swapBlock->swap_slots[blockIndex];
+		vm_page* page;
+		if (slotIndex != SWAP_SLOT_NONE
+			&& ((page = LookupPage((off_t)pageIndex * B_PAGE_SIZE)) == NULL
+				|| !page->busy)) {
+				// We skip swap space of busy pages, since there could be I/O
+				// going on (paging in/out). Waiting is not an option as 1.
+				// unlocking the cache means that new swap pages could be
+				// added in a range we've already cleared (since the cache
+				// still has the old size) and 2. we'd risk a deadlock in case
+				// we come from the file cache and the FS holds the node's
+				// write-lock. Pages that are being written have had their
+				// busy_writing flag cleared by VMCache::_FreePageRange(), and
+				// the page writer frees them and their swap space when it's
+				// done. Discard() waits for all other busy pages first.
+				// TODO: Resize() still leaks the swap space of pages that are
+				// being read in.
+			swap_slot_dealloc(slotIndex, 1);
+			fAllocatedSwapSize -= B_PAGE_SIZE;
+
+			swapBlock->swap_slots[blockIndex] = SWAP_SLOT_NONE;
+			if (--swapBlock->used == 0) {
+				// All swap pages have been freed -- we can discard the swap
+				// block.
+				sSwapHashTable.RemoveUnchecked(swapBlock);
+				object_cache_free(sSwapBlockCache, swapBlock,
+					CACHE_DONT_WAIT_FOR_MEMORY
+						| CACHE_DONT_LOCK_KERNEL_SPACE);
+				swapBlock = NULL;
+
+				// the rest of the block has no swap space left
+				pageIndex = ROUNDUP(pageIndex + 1, SWAP_BLOCK_PAGES) - 1;
+			}
+		}
+	}
+}
+
+
 status_t
 VMAnonymousCache::_Commit(off_t size, int priority)
 {
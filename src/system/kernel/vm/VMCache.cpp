@@ -1104,37 +1104,8 @@ VMCache::Resize(off_t newSize, int priority)
 	if (newPageCount < oldPageCount) {
 		// we need to remove all pages in the cache outside of the new virtual
 		// size
-		for (VMCachePagesTree::Iterator it
-					= pages.GetIterator(newPageCount, true, true);
-				vm_page* page = it.Next();) {
-			if (page->busy) {
-				if (page->busy_writing) {
-					// We cannot wait for the page to become available
-					// as we might cause a deadlock this way
-					page->busy_writing = false;
-						// this will notify the writer to free the page
-				} else {
-					// wait for page to become unbusy
-					WaitForPageEvents(page, PAGE_EVENT_NOT_BUSY, true);
-
-					// restart from the start of the list
-					it = pages.GetIterator(newPageCount, true, true);
-				}
-				continue;
-			}
-
-			// remove the page and put it into the free queue
-			DEBUG_PAGE_ACCESS_START(page);
-			vm_remove_all_page_mappings(page);
-			ASSERT(page->WiredCount() == 0);
-				// TODO: Find a real solution! If the page is wired
-				// temporarily (e.g. by lock_memory()), we actually must not
-				// unmap it!
-			RemovePage(page);
-			vm_page_free(this, page);
-				// Note: When iterating through a IteratableSplayTree
-				// removing the current node is safe.
-		}
+		while (_FreePageRange(pages.GetIterator(newPageCount, true, true)))
+			;
 	}
 
 	virtual_end = newSize;
@@ -1142,6 +1113,26 @@ VMCache::Resize(off_t newSize, int priority)
 }
 
 
+/*!	Frees all pages in the given range of the cache, without writing them
+	back first; they read as zeros afterwards. The range is not removed from
+	the cache, and the cache's commitment stays the same.
+	The cache must be locked. The lock might be released temporarily while
+	waiting for busy pages.
+*/
+status_t
+VMCache::Discard(off_t offset, off_t size)
+{
+	this->AssertLocked();
+
+	page_num_t startPage = offset >> PAGE_SHIFT;
+	page_num_t endPage = (offset + size + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
+	while (_FreePageRange(pages.GetIterator(startPage, true, true), &endPage))
+		;
+
+	return B_OK;
+}
+
+
 /*!	You have to call this function with the VMCache lock held. */
 status_t
 VMCache::FlushAndRemoveAllPages()
@@ -1370,6 +1361,48 @@ VMCache::Dump(bool showPages) const
 }
 
 
+/*!	Frees the pages the iterator returns, up to \a toPage if given.
+	Returns \c true, if it had to wait for a busy page, and the caller has to
+	start over with a new iterator, since the cache lock was released in the
+	meantime.
+*/
+bool
+VMCache::_FreePageRange(VMCachePagesTree::Iterator it, page_num_t* toPage)
+{
+	for (vm_page* page = it.Next();
+			page != NULL && (toPage == NULL || page->cache_offset < *toPage);
+			page = it.Next()) {
+		if (page->busy) {
+			if (page->busy_writing) {
+				// We cannot wait for the page to become available
+				// as we might cause a deadlock this way
+				page->busy_writing = false;
+					// this will notify the writer to free the page
+				continue;
+			}
+
+			// wait for page to become unbusy
+			WaitForPageEvents(page, PAGE_EVENT_NOT_BUSY, true);
+			return true;
+		}
+
+		// remove the page and put it into the free queue
+		DEBUG_PAGE_ACCESS_START(page);
+		vm_remove_all_page_mappings(page);
+		ASSERT(page->WiredCount() == 0);
+			// TODO: Find a real solution! If the page is wired
+			// temporarily (e.g. by lock_memory()), we actually must not
+			// unmap it!
+		RemovePage(page);
+		vm_page_free(this, page);
+			// Note: When iterating through a IteratableSplayTree
+			// removing the current node is safe.
+	}
+
+	return false;
+}
+
+
 /*!	Wakes up threads waiting for page events.
 	\param page The page for which events occurred.
 	\param events The mask of events that occurred.
@@ -42,6 +42,8 @@ public:
 	inline	void				PrependUnlocked(vm_page* page);
 	inline	void				RemoveUnlocked(vm_page* page);
 	inline	vm_page*			RemoveHeadUnlocked();
+	inline	uint32				RemoveHeadUnlocked(PageList& pages,
+									uint32 count);
 	inline	void				RequeueUnlocked(vm_page* page, bool tail);
 
 	inline	vm_page*			Head() const;
@@ -233,6 +235,29 @@ VMPageQueue::RemoveHeadUnlocked()
 }
 
 
+/*!	Moves up to \a count pages from the head of the queue to the end of
+	\a pages.
+	\return The number of pages moved.
+*/
+uint32
+VMPageQueue::RemoveHeadUnlocked(PageList& pages, uint32 count)
+{
+	InterruptsSpinLocker locker(fLock);
+
+	uint32 removed = 0;
+	while (removed < count) {
+		vm_page* page = RemoveHead();
+		if (page == NULL)
+			break;
+
+		pages.Add(page);
+		removed++;
+	}
+
+	return removed;
+}
+
+
 void
 VMPageQueue::RequeueUnlocked(vm_page* page, bool tail)
 {
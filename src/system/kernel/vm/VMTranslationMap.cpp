@@ -31,6 +31,33 @@ VMTranslationMap::~VMTranslationMap()
 }
 
 
+/*!	Returns the size of the large pages MapLargePage() can map, or 0, if the
+	map doesn't support them.
+*/
+size_t
+VMTranslationMap::LargePageSize() const
+{
+	return 0;
+}
+
+
+/*!	Maps a physically contiguous range of LargePageSize() bytes with a single
+	large page entry. Both addresses must be aligned to the large page size.
+	The large page is transparently split into regular page entries again, if
+	any of the other methods is applied to only a part of it, or to a single
+	page of it. Since that must not fail, the reservation must also contain
+	the page needed for the page table then.
+	The map must be locked.
+*/
+status_t
+VMTranslationMap::MapLargePage(addr_t virtualAddress,
+	phys_addr_t physicalAddress, uint32 attributes, uint32 memoryType,
+	vm_page_reservation* reservation)
+{
+	return B_NOT_SUPPORTED;
+}
+
+
 status_t
 VMTranslationMap::DebugMarkRangePresent(addr_t start, addr_t end,
 	bool markPresent)
@@ -20,6 +20,7 @@
 
 #include <OS.h>
 #include <KernelExport.h>
+#include <driver_settings.h>
 
 #include <AutoDeleter.h>
 
@@ -251,6 +252,12 @@ static off_t sNeededMemory;
 static mutex sAvailableMemoryLock = MUTEX_INITIALIZER("available memory lock");
 static uint32 sPageFaults;
 
+// fault-around: number of pages around a read fault on a file mapping that
+// are mapped, too, if they are already in the cache
+static const int32 kMaxFaultAroundPages = 32;
+static int32 sFaultAroundPages = 16;
+static int64 sFaultAroundMappedPages;
+
 static VMPhysicalPageMapper* sPhysicalPageMapper;
 
 #if DEBUG_CACHE_LIST
@@ -1018,6 +1025,58 @@ wait_if_address_range_is_wired(VMAddressSpace* addressSpace, addr_t base,
 }
 
 
+/*!	Throws away the pages in the given range of the current team's address
+	space, so that they read as zeros afterwards. Only anonymous memory that
+	no one else can see is affected: areas sharing their cache with other
+	areas or caches, or having a source cache, are left alone. So are wired
+	areas, as their pages must stay resident.
+*/
+static status_t
+discard_address_range(addr_t address, size_t size)
+{
+	AddressSpaceWriteLocker locker;
+	do {
+		status_t status = locker.SetTo(team_get_current_team_id());
+		if (status != B_OK)
+			return status;
+	} while (wait_if_address_range_is_wired(locker.AddressSpace(), address,
+			size, &locker));
+
+	addr_t end = address + size;
+	for (VMAddressSpace::AreaIterator it
+				= locker.AddressSpace()->GetAreaIterator();
+			VMArea* area = it.Next();) {
+		if (area->Base() >= end)
+			break;
+
+		addr_t areaEnd = area->Base() + area->Size();
+		if (areaEnd <= address || (area->protection & B_KERNEL_AREA) != 0
+			|| area->wiring != B_NO_LOCK) {
+			continue;
+		}
+
+		VMCache* cache = vm_area_get_locked_cache(area);
+		if (cache->type != CACHE_TYPE_RAM || cache->source != NULL
+			|| cache->areas != area || area->cache_next != NULL
+			|| !cache->consumers.IsEmpty()) {
+			vm_area_put_locked_cache(cache);
+			continue;
+		}
+
+		addr_t rangeBase = std::max(address, area->Base());
+		addr_t rangeSize = std::min(end, areaEnd) - rangeBase;
+
+		unmap_pages(area, rangeBase, rangeSize);
+		cache->Discard(area->cache_offset + (rangeBase - area->Base()),
+			rangeSize);
+
+		vm_area_put_locked_cache(cache);
+	}
+
+	return B_OK;
+}
+
+
 /*!	Prepares an area to be used for vm_set_kernel_area_debug_protection().
 	It must be called in a situation where the kernel address space may be
 	locked.
@@ -1185,6 +1244,90 @@ vm_reserve_address_range(team_id team, void** _address, uint32 addressSpec,
 }
 
 
+/*!	Maps the physically contiguous pages at \a physicalAddress with a single
+	large page at \a address, and inserts them into the area's cache at
+	\a offset. Fails, if the translation map can't map a large page there.
+	The pages of a B_NO_LOCK area get a mapping object each, so that the page
+	daemon can deal with them one by one; the translation map splits the large
+	page when that happens.
+	The area's cache must be locked.
+*/
+static status_t
+map_large_page(VMArea* area, phys_addr_t physicalAddress, addr_t address,
+	off_t offset, uint32 protection, vm_page_reservation* reservation)
+{
+	VMTranslationMap* map = area->address_space->TranslationMap();
+	size_t pageCount = map->LargePageSize() / B_PAGE_SIZE;
+
+	bool isKernelSpace = area->address_space == VMAddressSpace::Kernel();
+	uint32 mappingFlags = CACHE_DONT_WAIT_FOR_MEMORY
+		| (isKernelSpace ? CACHE_DONT_LOCK_KERNEL_SPACE : 0);
+
+	VMAreaMappings mappings;
+	if (area->wiring == B_NO_LOCK) {
+		for (size_t i = 0; i < pageCount; i++) {
+			vm_page_mapping* mapping = (vm_page_mapping*)object_cache_alloc(
+				gPageMappingsObjectCache, mappingFlags);
+			if (mapping == NULL)
+				break;
+
+			mappings.Add(mapping);
+		}
+	}
+
+	status_t status = B_NO_MEMORY;
+	if (area->wiring != B_NO_LOCK || (size_t)mappings.Count() == pageCount) {
+		map->Lock();
+		status = map->MapLargePage(address, physicalAddress, protection,
+			area->MemoryType(), reservation);
+
+		if (status == B_OK && area->wiring == B_NO_LOCK) {
+			for (size_t i = 0; i < pageCount; i++) {
+				vm_page_mapping* mapping = mappings.RemoveHead();
+				mapping->page = vm_lookup_page(physicalAddress / B_PAGE_SIZE
+					+ i);
+				mapping->area = area;
+
+				mapping->page->mappings.Add(mapping);
+				area->mappings.Add(mapping);
+			}
+
+			atomic_add(&gMappedPagesCount, pageCount);
+		}
+		map->Unlock();
+	}
+
+	while (vm_page_mapping* mapping = mappings.RemoveHead())
+		object_cache_free(gPageMappingsObjectCache, mapping, mappingFlags);
+
+	if (status != B_OK)
+		return status;
+
+	for (size_t i = 0; i < pageCount; i++) {
+		vm_page* page = vm_lookup_page(physicalAddress / B_PAGE_SIZE + i);
+		area->cache->InsertPage(page, offset + i * B_PAGE_SIZE);
+		if (area->wiring != B_NO_LOCK)
+			increment_page_wired_count(page);
+
+		DEBUG_PAGE_ACCESS_END(page);
+	}
+
+	return B_OK;
+}
+
+
+/*!	Frees the \a pageCount pages of the page run starting with \a run, that
+	vm_page_allocate_page_run() returned.
+*/
+static void
+free_page_run(vm_page* run, page_num_t pageCount)
+{
+	page_num_t pageNumber = run->physical_page_number;
+	for (page_num_t i = 0; i < pageCount; i++)
+		vm_page_set_state(vm_lookup_page(pageNumber + i), PAGE_STATE_FREE);
+}
+
+
 area_id
 vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 	uint32 wiring, uint32 protection, uint32 flags, addr_t guardSize,
@@ -1288,6 +1431,14 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 			return B_BAD_VALUE;
 	}
 
+	// Pageable areas with large pages are populated right away, so they must
+	// not overcommit.
+	if ((protection & B_LARGE_PAGE_AREA) != 0
+		&& wiring != B_FULL_LOCK && wiring != B_CONTIGUOUS
+		&& (wiring != B_NO_LOCK || canOvercommit)) {
+		return B_BAD_VALUE;
+	}
+
 	// Optimization: For a single-page contiguous allocation without low/high
 	// memory restriction B_FULL_LOCK wiring suffices.
 	if (wiring == B_CONTIGUOUS && size == B_PAGE_SIZE
@@ -1296,19 +1447,56 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 		wiring = B_FULL_LOCK;
 	}
 
-	// For full lock or contiguous areas we're also going to map the pages and
-	// thus need to reserve pages for the mapping backend upfront.
+	// For full lock or contiguous areas, and pageable areas with large pages,
+	// we're also going to map the pages and thus need to reserve pages for
+	// the mapping backend upfront. Getting the physical page runs for large
+	// pages may have to wait, so we don't try when we mustn't.
+	bool tryLargePages = (protection & B_LARGE_PAGE_AREA) != 0 && !isStack
+		&& (flags & CREATE_AREA_DONT_WAIT) == 0;
 	addr_t reservedMapPages = 0;
-	if (wiring == B_FULL_LOCK || wiring == B_CONTIGUOUS) {
+	size_t largePageSize = 0;
+	if (wiring == B_FULL_LOCK || wiring == B_CONTIGUOUS
+		|| (wiring == B_NO_LOCK && tryLargePages)) {
 		AddressSpaceWriteLocker locker;
 		status_t status = locker.SetTo(team);
 		if (status != B_OK)
 			return status;
 
 		VMTranslationMap* map = locker.AddressSpace()->TranslationMap();
-		reservedMapPages = map->MaxPagesNeededToMap(0, size - 1);
+
+		if (tryLargePages) {
+			largePageSize = map->LargePageSize();
+			if (size < largePageSize)
+				largePageSize = 0;
+		}
+
+		if (wiring != B_NO_LOCK || largePageSize != 0)
+			reservedMapPages = map->MaxPagesNeededToMap(0, size - 1);
 	}
 
+	// Large pages need the virtual and the physical address to be aligned
+	// accordingly.
+	virtual_address_restrictions largePageAddressRestrictions;
+	if (largePageSize != 0) {
+		if (virtualAddressRestrictions->address_specification
+				!= B_EXACT_ADDRESS
+			&& virtualAddressRestrictions->alignment < largePageSize) {
+			largePageAddressRestrictions = *virtualAddressRestrictions;
+			largePageAddressRestrictions.alignment = largePageSize;
+			virtualAddressRestrictions = &largePageAddressRestrictions;
+		}
+
+		if (wiring == B_CONTIGUOUS
+			&& physicalAddressRestrictions->alignment < largePageSize) {
+			stackPhysicalRestrictions = *physicalAddressRestrictions;
+			stackPhysicalRestrictions.alignment = largePageSize;
+			physicalAddressRestrictions = &stackPhysicalRestrictions;
+		}
+	}
+
+	vm_page** largePageRuns = NULL;
+	page_num_t largePageRunCount = 0;
+
 	int priority;
 	if (team != VMAddressSpace::KernelID())
 		priority = VM_PRIORITY_USER;
@@ -1345,6 +1533,32 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 	if (wiring == B_FULL_LOCK)
 		reservedPages += size / B_PAGE_SIZE;
 
+	// For full lock and pageable areas get the physical page runs for the
+	// large pages first. We just take as many as we can get.
+	if ((wiring == B_FULL_LOCK || wiring == B_NO_LOCK) && largePageSize != 0) {
+		largePageRuns = (vm_page**)malloc(
+			size / largePageSize * sizeof(vm_page*));
+		if (largePageRuns != NULL) {
+			physical_address_restrictions runRestrictions = {};
+			runRestrictions.alignment = largePageSize;
+			uint32 runState = wiring == B_NO_LOCK
+				? PAGE_STATE_ACTIVE : PAGE_STATE_WIRED;
+
+			while (largePageRunCount < size / largePageSize) {
+				vm_page* run = vm_page_allocate_page_run(
+					runState | pageAllocFlags, largePageSize / B_PAGE_SIZE,
+					&runRestrictions, priority);
+				if (run == NULL)
+					break;
+
+				largePageRuns[largePageRunCount++] = run;
+			}
+		}
+
+		if (wiring == B_FULL_LOCK)
+			reservedPages -= largePageRunCount * (largePageSize / B_PAGE_SIZE);
+	}
+
 	vm_page_reservation reservation;
 	if (reservedPages > 0) {
 		if ((flags & CREATE_AREA_DONT_WAIT) != 0) {
@@ -1413,17 +1627,61 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 
 	switch (wiring) {
 		case B_NO_LOCK:
+		{
+			// The page runs we got are mapped as large pages at the aligned
+			// addresses, all other pages are mapped in as needed. The pages
+			// stay pageable; the page daemon splits a large page when it
+			// takes one of them.
+			if (largePageRunCount == 0)
+				break;
+
+			page_num_t largePageRunIndex = 0;
+			addr_t lastAddress = area->Base() + (area->Size() - 1);
+
+			for (addr_t address = ROUNDUP(area->Base(), largePageSize);
+					largePageRunIndex < largePageRunCount
+						&& address < lastAddress
+						&& lastAddress - address >= largePageSize - 1;
+					address += largePageSize) {
+				vm_page* run = largePageRuns[largePageRunIndex];
+				if (map_large_page(area,
+						(phys_addr_t)run->physical_page_number * B_PAGE_SIZE,
+						address, address - area->Base(), protection,
+						&reservation) == B_OK) {
+					largePageRunIndex++;
+				}
+			}
+
+			// free the page runs we couldn't map
+			while (largePageRunIndex < largePageRunCount) {
+				free_page_run(largePageRuns[largePageRunIndex++],
+					largePageSize / B_PAGE_SIZE);
+			}
+			break;
+		}
+
 		case B_LAZY_LOCK:
 			// do nothing - the pages are mapped in as needed
 			break;
 
 		case B_FULL_LOCK:
 		{
-			// Allocate and map all pages for this area
+			// Allocate and map all pages for this area. The page runs we got
+			// are mapped as large pages where possible, otherwise their pages
+			// are used one by one, before any others are allocated. The
+			// remaining pages are allocated in batches.
+
+			page_num_t largePageRunIndex = 0;
+			page_num_t runPageNumber = 0;
+			page_num_t runPagesLeft = 0;
+			addr_t lastAddress = area->Base() + (area->Size() - 1);
+
+			vm_page* pages[32];
+			addr_t pageCount = 0;
+			addr_t pageIndex = 0;
 
 			off_t offset = 0;
-			for (addr_t address = area->Base();
-					address < area->Base() + (area->Size() - 1);
+			for (addr_t address = area->Base(); address < lastAddress;
 					address += B_PAGE_SIZE, offset += B_PAGE_SIZE) {
 #ifdef DEBUG_KERNEL_STACKS
 #	ifdef STACK_GROWS_DOWNWARDS
@@ -1435,14 +1693,50 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 #	endif
 					continue;
 #endif
-				vm_page* page = vm_page_allocate_page(&reservation,
-					PAGE_STATE_WIRED | pageAllocFlags);
+				if (runPagesLeft == 0 && largePageRunIndex < largePageRunCount) {
+					vm_page* run = largePageRuns[largePageRunIndex++];
+					if (address % largePageSize == 0
+						&& lastAddress - address >= largePageSize - 1
+						&& map_large_page(area,
+							(phys_addr_t)run->physical_page_number
+								* B_PAGE_SIZE,
+							address, offset, protection, &reservation)
+								== B_OK) {
+						address += largePageSize - B_PAGE_SIZE;
+						offset += largePageSize - B_PAGE_SIZE;
+						continue;
+					}
+
+					runPageNumber = run->physical_page_number;
+					runPagesLeft = largePageSize / B_PAGE_SIZE;
+				}
+
+				vm_page* page;
+				if (runPagesLeft > 0) {
+					page = vm_lookup_page(runPageNumber++);
+					runPagesLeft--;
+				} else {
+					if (pageIndex == pageCount) {
+						// all page runs have been used up at this point
+						pageCount = std::min((addr_t)B_COUNT_OF(pages),
+							(lastAddress - address) / B_PAGE_SIZE + 1);
+						pageIndex = 0;
+						vm_page_allocate_pages(&reservation,
+							PAGE_STATE_WIRED | pageAllocFlags, pages,
+							pageCount);
+					}
+					page = pages[pageIndex++];
+				}
 				cache->InsertPage(page, offset);
 				map_page(area, page, address, protection, &reservation);
 
 				DEBUG_PAGE_ACCESS_END(page);
 			}
 
+			// free the pages we didn't need (the stack guard pages)
+			while (pageIndex < pageCount)
+				vm_page_set_state(pages[pageIndex++], PAGE_STATE_FREE);
+
 			break;
 		}
 
@@ -1501,9 +1795,22 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 
 			map->Lock();
 
-			for (virtualAddress = area->Base(); virtualAddress < area->Base()
-					+ (area->Size() - 1); virtualAddress += B_PAGE_SIZE,
-					offset += B_PAGE_SIZE, physicalAddress += B_PAGE_SIZE) {
+			addr_t lastAddress = area->Base() + (area->Size() - 1);
+			for (virtualAddress = area->Base(); virtualAddress < lastAddress;
+					virtualAddress += B_PAGE_SIZE, offset += B_PAGE_SIZE,
+					physicalAddress += B_PAGE_SIZE) {
+				if (largePageSize != 0
+					&& virtualAddress % largePageSize == 0
+					&& physicalAddress % largePageSize == 0
+					&& lastAddress - virtualAddress >= largePageSize - 1
+					&& map_large_page(area, physicalAddress, virtualAddress,
+						offset, protection, &reservation) == B_OK) {
+					virtualAddress += largePageSize - B_PAGE_SIZE;
+					offset += largePageSize - B_PAGE_SIZE;
+					physicalAddress += largePageSize - B_PAGE_SIZE;
+					continue;
+				}
+
 				page = vm_lookup_page(physicalAddress / B_PAGE_SIZE);
 				if (page == NULL)
 					panic("couldn't lookup physical page just allocated\n");
@@ -1531,6 +1838,7 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 
 	if (reservedPages > 0)
 		vm_page_unreserve_pages(&reservation);
+	free(largePageRuns);
 
 	TRACE(("vm_create_anonymous_area: done\n"));
 
@@ -1552,6 +1860,10 @@ err1:
 	}
 
 err0:
+	for (page_num_t i = 0; i < largePageRunCount; i++)
+		free_page_run(largePageRuns[i], largePageSize / B_PAGE_SIZE);
+	free(largePageRuns);
+
 	if (reservedPages > 0)
 		vm_page_unreserve_pages(&reservation);
 	if (reservedMemory > 0)
@@ -3413,6 +3725,31 @@ dump_available_memory(int argc, char** argv)
 }
 
 
+static int
+dump_fault_around(int argc, char** argv)
+{
+	if (argc > 2) {
+		print_debugger_command_usage(argv[0]);
+		return 0;
+	}
+
+	if (argc == 2) {
+		uint64 pages = parse_expression(argv[1]);
+		if (pages > (uint64)kMaxFaultAroundPages) {
+			kprintf("at most %" B_PRId32 " pages are supported\n",
+				kMaxFaultAroundPages);
+			return 0;
+		}
+		sFaultAroundPages = pages;
+	}
+
+	kprintf("fault-around window: %" B_PRId32 " pages%s\n", sFaultAroundPages,
+		sFaultAroundPages <= 1 ? " (disabled)" : "");
+	kprintf("pages mapped:        %" B_PRId64 "\n", sFaultAroundMappedPages);
+	return 0;
+}
+
+
 static int
 dump_mapping_info(int argc, char** argv)
 {
@@ -4096,6 +4433,13 @@ vm_init(kernel_args* args)
 #endif
 	add_debugger_command("avail", &dump_available_memory,
 		"Dump available memory");
+	add_debugger_command_etc("fault_around", &dump_fault_around,
+		"Print or set the fault-around window",
+		"[ <pages> ]\n"
+		"Prints how many pages around a read fault on a file mapping are\n"
+		"mapped as well, if they are already cached, and how many pages have\n"
+		"been mapped that way. If <pages> is given, the window is set to it.\n"
+		"0 or 1 disable fault-around.\n", 0);
 	add_debugger_command("dl", &display_mem, "dump memory long words (64-bit)");
 	add_debugger_command("dw", &display_mem, "dump memory words (32-bit)");
 	add_debugger_command("ds", &display_mem, "dump memory shorts (16-bit)");
@@ -4161,6 +4505,17 @@ vm_init_post_thread(kernel_args* args)
 status_t
 vm_init_post_modules(kernel_args* args)
 {
+	void* settings = load_driver_settings("virtual_memory");
+	if (settings != NULL) {
+		const char* pages = get_driver_parameter(settings,
+			"fault_around_pages", NULL, NULL);
+		if (pages != NULL) {
+			sFaultAroundPages = std::min(std::max((int32)strtol(pages, NULL,
+				10), (int32)0), kMaxFaultAroundPages);
+		}
+		unload_driver_settings(settings);
+	}
+
 	return arch_vm_init_post_modules(args);
 }
 
@@ -4361,18 +4716,22 @@ struct PageFaultContext {
 	off_t					cacheOffset;
 	vm_page_reservation		reservation;
 	bool					isWrite;
+	int32					faultAroundPages;
 
 	// return values
 	vm_page*				page;
 	bool					restart;
 	bool					pageAllocated;
+	bool					majorFault;
 
 
 	PageFaultContext(VMAddressSpace* addressSpace, bool isWrite)
 		:
 		addressSpaceLocker(addressSpace, true),
 		map(addressSpace->TranslationMap()),
-		isWrite(isWrite)
+		isWrite(isWrite),
+		faultAroundPages(0),
+		majorFault(false)
 	{
 	}
 
@@ -4456,6 +4815,7 @@ fault_get_page(PageFaultContext& context)
 			context.UnlockAll();
 
 			// read the page in
+			context.majorFault = true;
 			generic_io_vec vec;
 			vec.base = (phys_addr_t)page->physical_page_number * B_PAGE_SIZE;
 			generic_size_t bytesRead = vec.length = B_PAGE_SIZE;
@@ -4501,6 +4861,9 @@ fault_get_page(PageFaultContext& context)
 		cache = context.isWrite ? context.topCache : lastCache;
 
 		// allocate a clean page
+		// TODO: Faults in anonymous memory still allocate one page at a
+		// time. vm_page_allocate_pages() could serve the neighbouring pages,
+		// too, but that needs a fault-around policy for them first.
 		page = vm_page_allocate_page(&context.reservation,
 			PAGE_STATE_ACTIVE | VM_PAGE_ALLOC_CLEAR);
 		FTRACE(("vm_soft_fault: just allocated page 0x%" B_PRIxPHYSADDR "\n",
@@ -4543,6 +4906,141 @@ fault_get_page(PageFaultContext& context)
 }
 
 
+/*!	Returns the window of addresses fault-around may map pages in for a fault
+	at \a address. The window is aligned to its size, so that it doesn't
+	cross page table boundaries unnecessarily.
+*/
+static inline void
+fault_around_window(int32 pages, addr_t address, addr_t& _start, addr_t& _end)
+{
+	addr_t windowSize = (addr_t)pages * B_PAGE_SIZE;
+	_start = ROUNDDOWN(address, windowSize);
+	_end = _start + (windowSize - 1);
+}
+
+
+/*!	Maps the pages around \a faultAddress that are already resident in the
+	cache of \c context.page read-only, so that they don't have to be faulted
+	in one by one. Pages that are busy, shadowed by a page in one of the caches
+	above, or already mapped are left alone, and nothing is read in.
+	The address space and the caches from the top cache down to the cache of
+	\c context.page must be locked.
+*/
+static void
+fault_around(PageFaultContext& context, VMArea* area, addr_t faultAddress)
+{
+	VMCache* pageCache = context.page->Cache();
+
+	addr_t start;
+	addr_t end;
+	fault_around_window(context.faultAroundPages, faultAddress, start, end);
+	start = std::max(start, area->Base());
+	end = std::min(end, area->Base() + (area->Size() - 1));
+
+	// collect the candidates
+	vm_page* pages[kMaxFaultAroundPages];
+	addr_t addresses[kMaxFaultAroundPages];
+	int32 count = 0;
+
+	for (addr_t address = start; address < end; address += B_PAGE_SIZE) {
+		if (address == faultAddress
+			|| (get_area_page_protection(area, address) & B_READ_AREA) == 0) {
+			continue;
+		}
+
+		off_t cacheOffset = address - area->Base() + area->cache_offset;
+		vm_page* page = pageCache->LookupPage(cacheOffset);
+		if (page == NULL || page->busy)
+			continue;
+
+		bool shadowed = false;
+		for (VMCache* cache = context.topCache; cache != pageCache;
+				cache = cache->source) {
+			if (cache->LookupPage(cacheOffset) != NULL
+				|| cache->HasPage(cacheOffset)) {
+				shadowed = true;
+				break;
+			}
+		}
+		if (shadowed)
+			continue;
+
+		pages[count] = page;
+		addresses[count] = address;
+		count++;
+	}
+
+	if (count == 0)
+		return;
+
+	// Allocate the mapping objects before locking the translation map, we
+	// don't want to allocate memory with it held.
+	vm_page_mapping* mappings[kMaxFaultAroundPages];
+	int32 mappingCount = 0;
+	for (; mappingCount < count; mappingCount++) {
+		mappings[mappingCount] = (vm_page_mapping*)object_cache_alloc(
+			gPageMappingsObjectCache, CACHE_DONT_WAIT_FOR_MEMORY);
+		if (mappings[mappingCount] == NULL)
+			break;
+	}
+	count = mappingCount;
+
+	// map all pages that aren't mapped yet in one go
+	VMTranslationMap* map = context.map;
+	int32 mapped = 0;
+
+	map->Lock();
+
+	for (int32 i = 0; i < count; i++) {
+		vm_page* page = pages[i];
+
+		phys_addr_t physicalAddress;
+		uint32 flags;
+		if (map->Query(addresses[i], &physicalAddress, &flags) == B_OK
+			&& (flags & PAGE_PRESENT) != 0) {
+			pages[i] = NULL;
+			continue;
+		}
+
+		map->Map(addresses[i], page->physical_page_number * B_PAGE_SIZE,
+			get_area_page_protection(area, addresses[i])
+				& ~(B_WRITE_AREA | B_KERNEL_WRITE_AREA),
+			area->MemoryType(), &context.reservation);
+
+		vm_page_mapping* mapping = mappings[mapped++];
+		mapping->page = page;
+		mapping->area = area;
+
+		if (!page->IsMapped())
+			atomic_add(&gMappedPagesCount, 1);
+		else
+			pages[i] = NULL;
+				// no need to touch its state below
+
+		page->mappings.Add(mapping);
+		area->mappings.Add(mapping);
+	}
+
+	map->Unlock();
+
+	for (int32 i = mapped; i < mappingCount; i++)
+		object_cache_free(gPageMappingsObjectCache, mappings[i], 0);
+
+	// As in map_page(), newly mapped pages must leave the cached queue.
+	for (int32 i = 0; i < count; i++) {
+		vm_page* page = pages[i];
+		if (page != NULL && (page->State() == PAGE_STATE_CACHED
+				|| page->State() == PAGE_STATE_INACTIVE)) {
+			DEBUG_PAGE_ACCESS_START(page);
+			vm_page_set_state(page, PAGE_STATE_ACTIVE);
+			DEBUG_PAGE_ACCESS_END(page);
+		}
+	}
+
+	atomic_add64(&sFaultAroundMappedPages, mapped);
+}
+
+
 /*!	Makes sure the address in the given address space is mapped.
 
 	\param addressSpace The address space.
@@ -4569,11 +5067,22 @@ vm_soft_fault(VMAddressSpace* addressSpace, addr_t originalAddress,
 
 	addressSpace->IncrementFaultCount();
 
+	// Read faults in userland may map the cached pages around the faulting one
+	// as well (cf. fault_around()).
+	if (isUser && !isWrite && wirePage == NULL)
+		context.faultAroundPages = sFaultAroundPages;
+
 	// We may need up to 2 pages plus pages needed for mapping them -- reserving
 	// the pages upfront makes sure we don't have any cache locked, so that the
 	// page daemon/thief can do their job without problems.
-	size_t reservePages = 2 + context.map->MaxPagesNeededToMap(originalAddress,
-		originalAddress);
+	addr_t mapStart = originalAddress;
+	addr_t mapEnd = originalAddress;
+	if (context.faultAroundPages > 1) {
+		fault_around_window(context.faultAroundPages, originalAddress,
+			mapStart, mapEnd);
+	}
+	size_t reservePages = 2 + context.map->MaxPagesNeededToMap(mapStart,
+		mapEnd);
 	context.addressSpaceLocker.Unlock();
 	vm_page_reserve_pages(&context.reservation, reservePages,
 		addressSpace == VMAddressSpace::Kernel()
@@ -4778,9 +5287,24 @@ vm_soft_fault(VMAddressSpace* addressSpace, addr_t originalAddress,
 
 		DEBUG_PAGE_ACCESS_END(context.page);
 
+		if (context.faultAroundPages > 1 && !context.pageAllocated
+			&& area->wiring == B_NO_LOCK
+			&& context.page->Cache()->type == CACHE_TYPE_VNODE) {
+			fault_around(context, area, address);
+		}
+
 		break;
 	}
 
+	if (status == B_OK) {
+		// account the fault to the team, if it happened in its address space
+		Thread* thread = thread_get_current_thread();
+		if (thread != NULL && thread->team->id == addressSpace->ID()) {
+			atomic_add64(context.majorFault ? &thread->team->major_faults
+				: &thread->team->minor_faults, 1);
+		}
+	}
+
 	return status;
 }
 
@@ -6326,7 +6850,7 @@ _user_create_area(const char* userName, void** userAddress, uint32 addressSpec,
 		case B_ANY_KERNEL_BLOCK_ADDRESS:
 			return B_BAD_VALUE;
 	}
-	if ((protection & ~B_USER_AREA_FLAGS) != 0)
+	if ((protection & ~(B_USER_AREA_FLAGS | B_LARGE_PAGE_AREA)) != 0)
 		return B_BAD_VALUE;
 
 	if (!IS_USER_ADDRESS(userName)
@@ -6674,10 +7198,34 @@ _user_sync_memory(void* _address, size_t size, uint32 flags)
 
 
 status_t
-_user_memory_advice(void* address, size_t size, uint32 advice)
+_user_memory_advice(void* _address, size_t size, uint32 advice)
 {
-	// TODO: Implement!
-	return B_OK;
+	addr_t address = (addr_t)_address;
+	if ((address % B_PAGE_SIZE) != 0)
+		return B_BAD_VALUE;
+
+	size = PAGE_ALIGN(size);
+	if (address + size < address || !IS_USER_ADDRESS(address)
+		|| !IS_USER_ADDRESS(address + size)) {
+		// weird error code required by POSIX
+		return B_NO_MEMORY;
+	}
+
+	switch (advice) {
+		case POSIX_MADV_NORMAL:
+		case POSIX_MADV_SEQUENTIAL:
+		case POSIX_MADV_RANDOM:
+		case POSIX_MADV_WILLNEED:
+		case POSIX_MADV_DONTNEED:
+			// TODO: Implement!
+			return B_OK;
+
+		case MADV_FREE:
+			return discard_address_range(address, size);
+
+		default:
+			return B_BAD_VALUE;
+	}
 }
 
 
@@ -23,10 +23,12 @@
 #include <block_cache.h>
 #include <boot/kernel_args.h>
 #include <condition_variable.h>
+#include <cpu.h>
 #include <elf.h>
 #include <heap.h>
 #include <kernel.h>
 #include <low_resource_manager.h>
+#include <smp.h>
 #include <thread.h>
 #include <tracing.h>
 #include <util/AutoLock.h>
@@ -101,6 +103,8 @@ static const int32 kPageUsageAdvance = 3;
 static const int32 kPageUsageDecline = 1;
 
 int32 gMappedPagesCount;
+int32 gMappedLargePagesCount;
+int32 gLargePageSplitCount;
 
 static VMPageQueue sPageQueues[PAGE_STATE_COUNT];
 
@@ -133,6 +137,37 @@ static mutex sPageDeficitLock = MUTEX_INITIALIZER("page deficit");
 static rw_lock sFreePageQueuesLock
 	= RW_LOCK_INITIALIZER("free/clear page queues");
 
+// Every CPU keeps a few free and clear pages for itself, so that most page
+// allocations and frees don't have to touch the global queues. The lists are
+// refilled from and drained to the queues in batches. They may only be used
+// by their CPU, with interrupts disabled and sFreePageQueuesLock read locked,
+// or by whoever holds sFreePageQueuesLock write locked, who might also
+// drain them. The pages keep their free or clear state, and are accounted for
+// in sUnreservedFreePages, just like the ones in the queues.
+// Additionally, every CPU keeps a few pages reserved, so that not every small
+// reservation has to touch sUnreservedFreePages.
+struct page_cache {
+	VMPageQueue::PageList	pages[2];
+	uint32					count[2];
+		// free and clear pages
+	int32					reserved;
+
+	// statistics
+	uint64					allocations;
+	uint64					allocationMisses;
+	uint64					frees;
+	uint64					drains;
+	int64					reservations;
+	int64					reservationMisses;
+} CACHE_LINE_ALIGN;
+
+static const uint32 kPageCacheBatchSize = 16;
+static const uint32 kPageCacheMaxPages = 4 * kPageCacheBatchSize;
+static const int32 kPageCacheMaxReserved = 2 * kPageCacheBatchSize;
+
+static page_cache sPageCaches[SMP_MAX_CPUS];
+static bool sPageCachesEnabled = false;
+
 #ifdef TRACK_PAGE_USAGE_STATS
 static page_num_t sPageUsageArrays[512];
 static page_num_t* sPageUsage = sPageUsageArrays;
@@ -760,6 +795,30 @@ private:
 #endif	// VM_PAGE_ALLOCATION_TRACKING_AVAILABLE
 
 
+/*!	Returns the number of free and clear pages in the CPU page caches. This
+	is not a snapshot, as the caches aren't locked.
+*/
+static page_num_t
+page_cache_free_pages()
+{
+	page_num_t count = 0;
+	for (int32 i = 0; i < smp_get_num_cpus(); i++)
+		count += sPageCaches[i].count[0] + sPageCaches[i].count[1];
+	return count;
+}
+
+
+/*!	Returns the number of pages the CPUs have reserved for themselves. */
+static int32
+page_cache_reserved_pages()
+{
+	int32 count = 0;
+	for (int32 i = 0; i < smp_get_num_cpus(); i++)
+		count += atomic_get(&sPageCaches[i].reserved);
+	return count;
+}
+
+
 static int
 find_page(int argc, char **argv)
 {
@@ -1093,10 +1152,14 @@ dump_page_stats(int argc, char **argv)
 	kprintf("free: %" B_PRIuSIZE "\n", counter[PAGE_STATE_FREE]);
 	kprintf("clear: %" B_PRIuSIZE "\n", counter[PAGE_STATE_CLEAR]);
 
-	kprintf("unreserved free pages: %" B_PRId32 "\n", sUnreservedFreePages);
+	kprintf("unreserved free pages: %" B_PRId32 " (+ %" B_PRId32
+		" reserved by the CPUs)\n", sUnreservedFreePages,
+		page_cache_reserved_pages());
 	kprintf("unsatisfied page reservations: %" B_PRId32 "\n",
 		sUnsatisfiedPageReservations);
 	kprintf("mapped pages: %" B_PRId32 "\n", gMappedPagesCount);
+	kprintf("mapped large pages: %" B_PRId32 " (%" B_PRId32 " split so far)\n",
+		gMappedLargePagesCount, gLargePageSplitCount);
 	kprintf("longest free pages run: %" B_PRIuPHYSADDR " pages (at %"
 		B_PRIuPHYSADDR ")\n", longestFreeRun.Length(),
 		sPages[longestFreeRun.start].physical_page_number);
@@ -1117,6 +1180,8 @@ dump_page_stats(int argc, char **argv)
 		sFreePageQueue.Count());
 	kprintf("clear queue: %p, count = %" B_PRIuPHYSADDR "\n", &sClearPageQueue,
 		sClearPageQueue.Count());
+	kprintf("CPU page caches: count = %" B_PRIuPHYSADDR "\n",
+		page_cache_free_pages());
 	kprintf("modified queue: %p, count = %" B_PRIuPHYSADDR " (%" B_PRId32
 		" temporary, %" B_PRIuPHYSADDR " swappable, " "inactive: %"
 		B_PRIuPHYSADDR ")\n", &sModifiedPageQueue, sModifiedPageQueue.Count(),
@@ -1131,6 +1196,50 @@ dump_page_stats(int argc, char **argv)
 }
 
 
+static uint32
+percent(uint64 part, uint64 total)
+{
+	return total > 0 ? part * 100 / total : 100;
+}
+
+
+static int
+dump_page_caches(int argc, char** argv)
+{
+	kprintf("cpu   free  clear  reserved  allocations  hits       frees  "
+		"drains  reservations  hits\n");
+
+	uint64 allocations = 0;
+	uint64 allocationMisses = 0;
+	int64 reservations = 0;
+	int64 reservationMisses = 0;
+
+	for (int32 i = 0; i < smp_get_num_cpus(); i++) {
+		page_cache& cache = sPageCaches[i];
+		kprintf("%3" B_PRId32 "  %5" B_PRIu32 "  %5" B_PRIu32 "  %8" B_PRId32
+			"  %11" B_PRIu64 "  %3" B_PRIu32 "%%  %10" B_PRIu64 "  %6" B_PRIu64
+			"  %12" B_PRId64 "  %3" B_PRIu32 "%%\n", i, cache.count[0],
+			cache.count[1], cache.reserved, cache.allocations,
+			percent(cache.allocations - cache.allocationMisses,
+				cache.allocations),
+			cache.frees, cache.drains, cache.reservations,
+			percent(cache.reservations - cache.reservationMisses,
+				cache.reservations));
+
+		allocations += cache.allocations;
+		allocationMisses += cache.allocationMisses;
+		reservations += cache.reservations;
+		reservationMisses += cache.reservationMisses;
+	}
+
+	kprintf("\nallocations served from the caches: %" B_PRIu32 "%%\n",
+		percent(allocations - allocationMisses, allocations));
+	kprintf("reservations served from the caches: %" B_PRIu32 "%%\n",
+		percent(reservations - reservationMisses, reservations));
+	return 0;
+}
+
+
 #if VM_PAGE_ALLOCATION_TRACKING_AVAILABLE
 
 static caller_info*
@@ -1382,7 +1491,8 @@ vm_page::SetState(uint8 newState)
 static void
 get_page_stats(page_stats& _pageStats)
 {
-	_pageStats.totalFreePages = sUnreservedFreePages;
+	_pageStats.totalFreePages = sUnreservedFreePages
+		+ page_cache_reserved_pages();
 	_pageStats.cachedPages = sCachedPageQueue.Count();
 	_pageStats.unsatisfiedReservations = sUnsatisfiedPageReservations;
 	// TODO: We don't get an actual snapshot here!
@@ -1455,12 +1565,248 @@ wake_up_page_reservation_waiters()
 static inline void
 unreserve_pages(uint32 count)
 {
+	if (sPageCachesEnabled && count <= kPageCacheBatchSize
+		&& atomic_get(&sUnsatisfiedPageReservations) == 0
+		&& atomic_get(&sUnreservedFreePages)
+			>= (int32)kPageReserveForPriority[VM_PRIORITY_USER]) {
+		// keep the pages reserved for the current CPU, if it has room for them
+		// (it doesn't matter when we're migrated to another one meanwhile);
+		// when pages are getting short, the pages have to go back to where
+		// reservations of higher priority can get them
+		page_cache& cache = sPageCaches[smp_get_current_cpu()];
+		int32 reserved = atomic_get(&cache.reserved);
+		while (reserved + (int32)count <= kPageCacheMaxReserved) {
+			int32 oldReserved = atomic_test_and_set(&cache.reserved,
+				reserved + count, reserved);
+			if (oldReserved == reserved)
+				return;
+			reserved = oldReserved;
+		}
+	}
+
 	atomic_add(&sUnreservedFreePages, count);
 	if (atomic_get(&sUnsatisfiedPageReservations) != 0)
 		wake_up_page_reservation_waiters();
 }
 
 
+/*!	Returns the pages the CPUs keep reserved to \c sUnreservedFreePages, and
+	wakes up the waiters that can be satisfied now.
+	\return The number of pages returned.
+*/
+static int32
+flush_page_reservation_caches()
+{
+	if (!sPageCachesEnabled)
+		return 0;
+
+	int32 count = 0;
+	for (int32 i = 0; i < smp_get_num_cpus(); i++)
+		count += atomic_get_and_set(&sPageCaches[i].reserved, 0);
+
+	if (count > 0) {
+		atomic_add(&sUnreservedFreePages, count);
+		if (atomic_get(&sUnsatisfiedPageReservations) != 0)
+			wake_up_page_reservation_waiters();
+	}
+
+	return count;
+}
+
+
+/*!	Tries to reserve \a count pages from the ones the current CPU keeps
+	reserved, refilling them from \c sUnreservedFreePages if necessary.
+	Only pages that a reservation of user priority could get are used for
+	this, so that reservations of any priority can be satisfied this way.
+*/
+static bool
+reserve_pages_from_cache(uint32 count)
+{
+	if (!sPageCachesEnabled || count > kPageCacheBatchSize)
+		return false;
+
+	page_cache& cache = sPageCaches[smp_get_current_cpu()];
+	atomic_add64(&cache.reservations, 1);
+
+	int32 reserved = atomic_get(&cache.reserved);
+	while (reserved >= (int32)count) {
+		int32 oldReserved = atomic_test_and_set(&cache.reserved,
+			reserved - count, reserved);
+		if (oldReserved == reserved)
+			return true;
+		reserved = oldReserved;
+	}
+
+	atomic_add64(&cache.reservationMisses, 1);
+
+	if (atomic_get(&sUnsatisfiedPageReservations) != 0)
+		return false;
+
+	uint32 refilled = reserve_some_pages(count + kPageCacheBatchSize,
+		kPageReserveForPriority[VM_PRIORITY_USER]);
+	if (refilled < count) {
+		if (refilled > 0) {
+			atomic_add(&sUnreservedFreePages, refilled);
+			if (atomic_get(&sUnsatisfiedPageReservations) != 0)
+				wake_up_page_reservation_waiters();
+		}
+		return false;
+	}
+
+	atomic_add(&cache.reserved, refilled - count);
+	return true;
+}
+
+
+static inline VMPageQueue&
+free_page_queue(bool clear)
+{
+	return clear ? sClearPageQueue : sFreePageQueue;
+}
+
+
+/*!	Moves all pages in the CPU page caches back to the free and clear queues.
+	The caller must hold \c sFreePageQueuesLock write locked.
+*/
+static void
+drain_page_caches()
+{
+	for (int32 i = 0; i < smp_get_num_cpus(); i++) {
+		page_cache& cache = sPageCaches[i];
+		for (int32 clear = 0; clear < 2; clear++) {
+			if (cache.count[clear] == 0)
+				continue;
+
+			free_page_queue(clear).AppendUnlocked(cache.pages[clear],
+				cache.count[clear]);
+			cache.count[clear] = 0;
+			cache.drains++;
+		}
+	}
+}
+
+
+/*!	Takes a page off the \a cache's free or clear list, refilling the list
+	from the respective queue, if it's empty.
+	The caller must hold \c sFreePageQueuesLock read locked and have
+	interrupts disabled.
+*/
+static vm_page*
+page_cache_remove_page(page_cache& cache, bool clear)
+{
+	VMPageQueue::PageList& pages = cache.pages[clear];
+	if (cache.count[clear] == 0) {
+		cache.count[clear] = free_page_queue(clear).RemoveHeadUnlocked(pages,
+			kPageCacheBatchSize);
+		if (cache.count[clear] == 0)
+			return NULL;
+	}
+
+	cache.count[clear]--;
+	return pages.RemoveHead();
+}
+
+
+/*!	Removes \a count reserved pages from the free and clear queues, preferring
+	clear ones, if \a clear is \c true, and free ones otherwise.
+	The caller must hold \c sFreePageQueuesLock read locked. The lock might be
+	released temporarily.
+*/
+static void
+remove_free_pages(bool clear, vm_page** pages, uint32 count,
+	ReadLocker& locker)
+{
+	uint32 removed = 0;
+
+	if (sPageCachesEnabled) {
+		InterruptsLocker interruptsLocker;
+		page_cache& cache = sPageCaches[smp_get_current_cpu()];
+
+		for (; removed < count; removed++) {
+			cache.allocations++;
+			if (cache.count[clear] == 0)
+				cache.allocationMisses++;
+
+			vm_page* page = page_cache_remove_page(cache, clear);
+			if (page == NULL)
+				page = page_cache_remove_page(cache, !clear);
+			if (page == NULL)
+				break;
+
+			pages[removed] = page;
+		}
+	} else {
+		for (; removed < count; removed++) {
+			vm_page* page = free_page_queue(clear).RemoveHeadUnlocked();
+			if (page == NULL)
+				page = free_page_queue(!clear).RemoveHeadUnlocked();
+			if (page == NULL)
+				break;
+
+			pages[removed] = page;
+		}
+	}
+
+	if (removed == count)
+		return;
+
+	// Unlikely, but possible: the pages we have reserved are in the caches of
+	// other CPUs, or have moved between the queues after we checked the first
+	// one. Grab the write lock to make sure this doesn't happen again.
+	locker.Unlock();
+
+	WriteLocker writeLocker(sFreePageQueuesLock);
+	drain_page_caches();
+
+	for (; removed < count; removed++) {
+		vm_page* page = free_page_queue(clear).RemoveHead();
+		if (page == NULL)
+			page = free_page_queue(!clear).RemoveHead();
+
+		if (page == NULL) {
+			panic("Had reserved page, but there is none!");
+			break;
+		}
+
+		pages[removed] = page;
+	}
+
+	writeLocker.Unlock();
+	locker.Lock();
+}
+
+
+/*!	Adds a page to the free or clear queue, by way of the current CPU's page
+	cache. The caller must hold \c sFreePageQueuesLock read locked.
+*/
+static void
+add_free_page(vm_page* page, bool clear)
+{
+	if (!sPageCachesEnabled) {
+		free_page_queue(clear).PrependUnlocked(page);
+		return;
+	}
+
+	InterruptsLocker interruptsLocker;
+	page_cache& cache = sPageCaches[smp_get_current_cpu()];
+	VMPageQueue::PageList& pages = cache.pages[clear];
+
+	cache.frees++;
+	pages.Add(page, false);
+	if (++cache.count[clear] <= kPageCacheMaxPages)
+		return;
+
+	// return the pages that have been in the cache the longest
+	VMPageQueue::PageList drainedPages;
+	for (uint32 i = 0; i < kPageCacheBatchSize; i++)
+		drainedPages.Add(pages.RemoveTail(), false);
+
+	cache.count[clear] -= kPageCacheBatchSize;
+	cache.drains++;
+	free_page_queue(clear).AppendUnlocked(drainedPages, kPageCacheBatchSize);
+}
+
+
 static void
 free_page(vm_page* page, bool clear)
 {
@@ -1515,13 +1861,8 @@ free_page(vm_page* page, bool clear)
 
 	DEBUG_PAGE_ACCESS_END(page);
 
-	if (clear) {
-		page->SetState(PAGE_STATE_CLEAR);
-		sClearPageQueue.PrependUnlocked(page);
-	} else {
-		page->SetState(PAGE_STATE_FREE);
-		sFreePageQueue.PrependUnlocked(page);
-	}
+	page->SetState(clear ? PAGE_STATE_CLEAR : PAGE_STATE_FREE);
+	add_free_page(page, clear);
 
 	locker.Unlock();
 }
@@ -1686,6 +2027,7 @@ mark_page_range_in_use(page_num_t startPage, page_num_t length, bool wired)
 	}
 
 	WriteLocker locker(sFreePageQueuesLock);
+	drain_page_caches();
 
 	for (page_num_t i = 0; i < length; i++) {
 		vm_page *page = &sPages[startPage + i];
@@ -1993,47 +2335,47 @@ PageWriteWrapper::Done(status_t result)
 
 	bool success = true;
 
-	if (result == B_OK) {
+	if (!fPage->busy_writing) {
+		// The busy_writing flag was cleared. That means the cache has been
+		// shrunk or the range discarded while we were trying to write the
+		// page, and we have to free it now, no matter whether writing it
+		// succeeded.
+#if ENABLE_SWAP_SUPPORT
+		// The swap space it might just have got isn't needed anymore either.
+		if (fCache->temporary)
+			swap_free_page_swap_space(fPage);
+#endif
+		vm_remove_all_page_mappings(fPage);
+// TODO: Unmapping should already happen when resizing the cache!
+		fCache->RemovePage(fPage);
+		free_page(fPage, false);
+		unreserve_pages(1);
+	} else if (result == B_OK) {
 		// put it into the active/inactive queue
 		move_page_to_appropriate_queue(fPage);
 		fPage->busy_writing = false;
 		DEBUG_PAGE_ACCESS_END(fPage);
 	} else {
-		// Writing the page failed. One reason would be that the cache has been
-		// shrunk and the page does no longer belong to the file. Otherwise the
-		// actual I/O failed, in which case we'll simply keep the page modified.
-
-		if (!fPage->busy_writing) {
-			// The busy_writing flag was cleared. That means the cache has been
-			// shrunk while we were trying to write the page and we have to free
-			// it now.
-			vm_remove_all_page_mappings(fPage);
-// TODO: Unmapping should already happen when resizing the cache!
-			fCache->RemovePage(fPage);
-			free_page(fPage, false);
-			unreserve_pages(1);
-		} else {
-			// Writing the page failed -- mark the page modified and move it to
-			// an appropriate queue other than the modified queue, so we don't
-			// keep trying to write it over and over again. We keep
-			// non-temporary pages in the modified queue, though, so they don't
-			// get lost in the inactive queue.
-			dprintf("PageWriteWrapper: Failed to write page %p: %s\n", fPage,
-				strerror(result));
-
-			fPage->modified = true;
-			if (!fCache->temporary)
-				set_page_state(fPage, PAGE_STATE_MODIFIED);
-			else if (fPage->IsMapped())
-				set_page_state(fPage, PAGE_STATE_ACTIVE);
-			else
-				set_page_state(fPage, PAGE_STATE_INACTIVE);
-
-			fPage->busy_writing = false;
-			DEBUG_PAGE_ACCESS_END(fPage);
-
-			success = false;
-		}
+		// Writing the page failed -- mark the page modified and move it to
+		// an appropriate queue other than the modified queue, so we don't
+		// keep trying to write it over and over again. We keep
+		// non-temporary pages in the modified queue, though, so they don't
+		// get lost in the inactive queue.
+		dprintf("PageWriteWrapper: Failed to write page %p: %s\n", fPage,
+			strerror(result));
+
+		fPage->modified = true;
+		if (!fCache->temporary)
+			set_page_state(fPage, PAGE_STATE_MODIFIED);
+		else if (fPage->IsMapped())
+			set_page_state(fPage, PAGE_STATE_ACTIVE);
+		else
+			set_page_state(fPage, PAGE_STATE_INACTIVE);
+
+		fPage->busy_writing = false;
+		DEBUG_PAGE_ACCESS_END(fPage);
+
+		success = false;
 	}
 
 	fCache->NotifyPageEvents(fPage, PAGE_EVENT_NOT_BUSY);
@@ -2947,6 +3289,10 @@ page_daemon(void* /*unused*/)
 	while (true) {
 		sPageDaemonCondition.ClearActivated();
 
+		// don't let anyone wait for pages the CPUs keep reserved
+		if (atomic_get(&sUnsatisfiedPageReservations) != 0)
+			flush_page_reservation_caches();
+
 		// evaluate the free pages situation
 		page_stats pageStats;
 		get_page_stats(pageStats);
@@ -2982,13 +3328,24 @@ page_daemon(void* /*unused*/)
 static uint32
 reserve_pages(uint32 count, int priority, bool dontWait)
 {
+	if (reserve_pages_from_cache(count))
+		return 0;
+
 	int32 dontTouch = kPageReserveForPriority[priority];
+	bool cachesFlushed = false;
 
 	while (true) {
 		count -= reserve_some_pages(count, dontTouch);
 		if (count == 0)
 			return 0;
 
+		if (!cachesFlushed) {
+			// get back the pages the CPUs keep reserved before trying harder
+			cachesFlushed = true;
+			if (flush_page_reservation_caches() > 0)
+				continue;
+		}
+
 		if (sUnsatisfiedPageReservations == 0) {
 			count -= free_cached_pages(count, dontWait);
 			if (count == 0)
@@ -3266,6 +3623,9 @@ vm_page_init(kernel_args *args)
 
 	new (&sPageReservationWaiters) PageReservationWaiterList;
 
+	for (int32 i = 0; i < SMP_MAX_CPUS; i++)
+		new (&sPageCaches[i]) page_cache;
+
 	// map in the new free page table
 	sPages = (vm_page *)vm_allocate_early(args, sNumPages * sizeof(vm_page),
 		~0L, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA, 0);
@@ -3343,6 +3703,8 @@ vm_page_init_post_area(kernel_args *args)
 
 	add_debugger_command("page_stats", &dump_page_stats,
 		"Dump statistics about page usage");
+	add_debugger_command("page_caches", &dump_page_caches,
+		"Dump the CPU page caches and their hit rates");
 	add_debugger_command_etc("page", &dump_page,
 		"Dump page info",
 		"[ \"-p\" | \"-v\" ] [ \"-m\" ] <address>\n"
@@ -3403,6 +3765,9 @@ vm_page_init_post_thread(kernel_args *args)
 	new (&sFreePageCondition) ConditionVariable;
 	sFreePageCondition.Publish(&sFreePageQueue, "free page");
 
+	// from now on we know which CPU we're running on
+	sPageCachesEnabled = true;
+
 	// create a kernel thread to clear out pages
 
 	thread_id thread = spawn_kernel_thread(&page_scrubber, "page scrubber",
@@ -3505,84 +3870,83 @@ vm_page_try_reserve_pages(vm_page_reservation* reservation, uint32 count,
 
 vm_page *
 vm_page_allocate_page(vm_page_reservation* reservation, uint32 flags)
+{
+	vm_page* page;
+	vm_page_allocate_pages(reservation, flags, &page, 1);
+	return page;
+}
+
+
+/*!	Allocates \a count pages at once, as if vm_page_allocate_page() was called
+	for each of them, but going through the locks only once per 32 pages.
+	The pages are stored in \a pages.
+*/
+void
+vm_page_allocate_pages(vm_page_reservation* reservation, uint32 flags,
+	vm_page** pages, uint32 count)
 {
 	uint32 pageState = flags & VM_PAGE_ALLOC_STATE;
 	ASSERT(pageState != PAGE_STATE_FREE);
 	ASSERT(pageState != PAGE_STATE_CLEAR);
 
-	ASSERT(reservation->count > 0);
-	reservation->count--;
+	ASSERT(reservation->count >= count);
+	reservation->count -= count;
 
-	VMPageQueue* queue;
-	VMPageQueue* otherQueue;
+	bool clear = (flags & VM_PAGE_ALLOC_CLEAR) != 0;
 
-	if ((flags & VM_PAGE_ALLOC_CLEAR) != 0) {
-		queue = &sClearPageQueue;
-		otherQueue = &sFreePageQueue;
-	} else {
-		queue = &sFreePageQueue;
-		otherQueue = &sClearPageQueue;
-	}
-
-	ReadLocker locker(sFreePageQueuesLock);
+	while (count > 0) {
+		// work in chunks, so we can remember which pages need to be cleared
+		uint32 chunkSize = std::min(count, (uint32)32);
+		uint32 pagesToClear = 0;
+		VMPageQueue::PageList allocatedPages;
 
-	vm_page* page = queue->RemoveHeadUnlocked();
-	if (page == NULL) {
-		// if the primary queue was empty, grab the page from the
-		// secondary queue
-		page = otherQueue->RemoveHeadUnlocked();
-
-		if (page == NULL) {
-			// Unlikely, but possible: the page we have reserved has moved
-			// between the queues after we checked the first queue. Grab the
-			// write locker to make sure this doesn't happen again.
-			locker.Unlock();
-			WriteLocker writeLocker(sFreePageQueuesLock);
+		ReadLocker locker(sFreePageQueuesLock);
 
-			page = queue->RemoveHead();
-			if (page == NULL)
-				otherQueue->RemoveHead();
+		remove_free_pages(clear, pages, chunkSize, locker);
 
-			if (page == NULL) {
-				panic("Had reserved page, but there is none!");
-				return NULL;
-			}
+		for (uint32 i = 0; i < chunkSize; i++) {
+			vm_page* page = pages[i];
+			if (page->CacheRef() != NULL)
+				panic("supposed to be free page %p has cache\n", page);
 
-			// downgrade to read lock
-			locker.Lock();
-		}
-	}
+			DEBUG_PAGE_ACCESS_START(page);
 
-	if (page->CacheRef() != NULL)
-		panic("supposed to be free page %p has cache\n", page);
+			// clear the page, if we had to take it from the free queue and a
+			// clear page was requested
+			if (clear && page->State() != PAGE_STATE_CLEAR)
+				pagesToClear |= 1u << i;
 
-	DEBUG_PAGE_ACCESS_START(page);
+			page->SetState(pageState);
+			page->busy = (flags & VM_PAGE_ALLOC_BUSY) != 0;
+			page->usage_count = 0;
+			page->accessed = false;
+			page->modified = false;
 
-	int oldPageState = page->State();
-	page->SetState(pageState);
-	page->busy = (flags & VM_PAGE_ALLOC_BUSY) != 0;
-	page->usage_count = 0;
-	page->accessed = false;
-	page->modified = false;
+			if (pageState < PAGE_STATE_FIRST_UNQUEUED)
+				allocatedPages.Add(page);
+		}
 
-	locker.Unlock();
+		locker.Unlock();
 
-	if (pageState < PAGE_STATE_FIRST_UNQUEUED)
-		sPageQueues[pageState].AppendUnlocked(page);
+		if (pageState < PAGE_STATE_FIRST_UNQUEUED)
+			sPageQueues[pageState].AppendUnlocked(allocatedPages, chunkSize);
 
-	// clear the page, if we had to take it from the free queue and a clear
-	// page was requested
-	if ((flags & VM_PAGE_ALLOC_CLEAR) != 0 && oldPageState != PAGE_STATE_CLEAR)
-		clear_page(page);
+		for (uint32 i = 0; i < chunkSize; i++) {
+			vm_page* page = pages[i];
+			if ((pagesToClear & (1u << i)) != 0)
+				clear_page(page);
 
 #if VM_PAGE_ALLOCATION_TRACKING_AVAILABLE
-	page->allocation_tracking_info.Init(
-		TA(AllocatePage(page->physical_page_number)));
+			page->allocation_tracking_info.Init(
+				TA(AllocatePage(page->physical_page_number)));
 #else
-	TA(AllocatePage(page->physical_page_number));
+			TA(AllocatePage(page->physical_page_number));
 #endif
+		}
 
-	return page;
+		pages += chunkSize;
+		count -= chunkSize;
+	}
 }
 
 
@@ -3834,6 +4198,7 @@ vm_page_allocate_page_run(uint32 flags, page_num_t length,
 	vm_page_reserve_pages(&reservation, length, priority);
 
 	WriteLocker freeClearQueueLocker(sFreePageQueuesLock);
+	drain_page_caches();
 
 	// First we try to get a run with free pages only. If that fails, we also
 	// consider cached pages. If there are only few free pages and many cached
@@ -3899,6 +4264,7 @@ vm_page_allocate_page_run(uint32 flags, page_num_t length,
 			// apparently a cached page couldn't be allocated -- skip it and
 			// continue
 			freeClearQueueLocker.Lock();
+			drain_page_caches();
 		}
 
 		start += i + 1;
@@ -4049,7 +4415,8 @@ vm_page_num_available_pages(void)
 page_num_t
 vm_page_num_free_pages(void)
 {
-	int32 count = sUnreservedFreePages + sCachedPageQueue.Count();
+	int32 count = sUnreservedFreePages + page_cache_reserved_pages()
+		+ sCachedPageQueue.Count();
 	return count > 0 ? count : 0;
 }
 
@@ -4057,7 +4424,7 @@ vm_page_num_free_pages(void)
 page_num_t
 vm_page_num_unused_pages(void)
 {
-	int32 count = sUnreservedFreePages;
+	int32 count = sUnreservedFreePages + page_cache_reserved_pages();
 	return count > 0 ? count : 0;
 }
 
@@ -4095,7 +4462,7 @@ vm_page_get_stats(system_info *info)
 	// So taking out the cached (including modified non-temporary), free and
 	// clear ones leaves us with all used pages.
 	uint32 subtractPages = info->cached_pages + sFreePageQueue.Count()
-		+ sClearPageQueue.Count();
+		+ sClearPageQueue.Count() + page_cache_free_pages();
 	info->used_pages = subtractPages > info->max_pages
 		? 0 : info->max_pages - subtractPages;
 
@@ -74,6 +74,8 @@ _thread_do_exit_work(void)
 	__gRuntimeLoader->destroy_thread_tls();
 
 	__pthread_destroy_thread();
+
+	__heap_thread_exit();
 }
 
 
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _MALLOC_ALLOCATOR_H
+#define _MALLOC_ALLOCATOR_H
+
+
+#include <OS.h>
+
+#include <locks.h>
+
+
+/*!	The heap is made of segments of kSegmentSize bytes, aligned to their
+	size, so that the segment of any allocation can be found by masking its
+	address. A segment starts with its header, followed by pages that are
+	handed out in runs, the spans.
+
+	Small allocations are served from spans that are split into objects of
+	one size class. Every thread has its own heap, which owns the spans it
+	allocates from; only the owner allocates from a span, and returns objects
+	to it directly. Other threads push the objects they free onto the span's
+	remote free list, which the owner collects when it runs out of objects.
+	Full spans are detached from their heap, and queued for anyone to adopt
+	once an object of theirs is freed again.
+
+	Large allocations are spans of their own, huge ones, and those that are
+	aligned to kSegmentSize or more, get an area of their own. Free page runs
+	are given back to the system after a while: their pages are discarded,
+	and the heap area is shrunk, if possible.
+*/
+
+
+namespace BPrivate {
+
+
+static const size_t kSegmentSize = 4 * 1024 * 1024;
+static const uint32 kSegmentPages = kSegmentSize / B_PAGE_SIZE;
+
+static const size_t kMinAlignment = 16;
+static const size_t kMaxSmallSize = 32 * 1024;
+static const size_t kMaxLargeSize = kSegmentSize / 4;
+static const uint32 kSizeClassCount = 40;
+
+static const bigtime_t kPurgeInterval = 500000;
+static const bigtime_t kPurgeDelay = 2000000;
+	// free pages are discarded after they have not been used for that long
+
+enum {
+	SEGMENT_PAGES = 'sgPg',
+	SEGMENT_HUGE = 'sgHg'
+};
+
+enum {
+	SPAN_FREE = 0,
+	SPAN_PURGING,
+	SPAN_SMALL,
+	SPAN_LARGE
+};
+
+
+struct thread_heap;
+
+struct free_object {
+	free_object*	next;
+};
+
+struct heap_span {
+	heap_span*		next;
+	heap_span*		previous;
+		// in the list of its heap, its queue, or its free run bin
+
+	free_object*	free_list;
+	free_object*	remote_free_list;
+		// pushed to atomically by other threads; kSpanDetached while the
+		// span has neither an owner nor is queued
+	addr_t			unused;
+	addr_t			end;
+		// the objects between the two have not been used yet
+
+	thread_heap*	owner;
+	uint32			object_size;
+	uint16			used;
+	uint16			size_class;
+
+	uint32			page_count;
+	uint8			kind;
+	bool			dirty;
+	bigtime_t		free_time;
+};
+
+struct segment_header {
+	uint32			kind;
+	uint32			object_offset;
+		// of the allocation in huge segments
+	size_t			size;
+		// the size of the area of huge segments
+	size_t			object_size;
+	segment_header*	next;
+	bigtime_t		free_time;
+};
+
+struct heap_segment : segment_header {
+	uint16			page_map[kSegmentPages];
+		// the first page of the span every page belongs to
+	heap_span		spans[kSegmentPages];
+		// indexed by the first page of the span
+};
+
+static const uint32 kSegmentHeaderPages
+	= (sizeof(heap_segment) + B_PAGE_SIZE - 1) / B_PAGE_SIZE;
+static const uint32 kMaxSpanPages = kSegmentPages - kSegmentHeaderPages;
+
+
+static inline addr_t
+round_up(addr_t value, addr_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+
+static inline heap_segment*
+segment_for(const void* address)
+{
+	return (heap_segment*)((addr_t)address & ~(addr_t)(kSegmentSize - 1));
+}
+
+
+static inline heap_span*
+span_for(heap_segment* segment, const void* address)
+{
+	uint32 page = ((addr_t)address - (addr_t)segment) / B_PAGE_SIZE;
+	return &segment->spans[segment->page_map[page]];
+}
+
+
+static inline addr_t
+span_base(heap_span* span)
+{
+	heap_segment* segment = segment_for(span);
+	return (addr_t)segment + (span - segment->spans) * B_PAGE_SIZE;
+}
+
+
+/*!	Allocations that are aligned to kSegmentSize or more have an area of
+	their own without a segment header; all others come after one.
+*/
+static inline bool
+is_aligned_allocation(const void* address)
+{
+	return ((addr_t)address & (kSegmentSize - 1)) == 0;
+}
+
+
+// segments.cpp
+
+status_t	init_segments();
+void		lock_segments();
+void		unlock_segments();
+void		reinit_segments_after_fork();
+
+heap_span*	allocate_span(uint32 pageCount, size_t alignment, uint8 kind);
+void		free_span(heap_span* span);
+
+void*		allocate_huge(size_t size, size_t alignment, bool clear);
+void		free_huge(segment_header* segment);
+bool		resize_huge(segment_header* segment, size_t size);
+
+void*		allocate_aligned(size_t size, size_t alignment);
+void		free_aligned(void* address);
+size_t		aligned_allocation_size(void* address);
+
+bool		purge_needed();
+void		purge_segments();
+
+void		get_segment_stats(size_t& totalBytes, size_t& spanBytes,
+				size_t& spanCount, size_t& freeRunCount);
+
+// thread_heap.cpp
+
+status_t	init_thread_heaps();
+void*		heap_allocate(size_t size, size_t alignment, bool clear);
+void		heap_free(void* address);
+void*		heap_reallocate(void* address, size_t size);
+size_t		heap_object_size(void* address);
+void		heap_thread_exit();
+void		heap_before_fork();
+void		heap_after_fork_child();
+void		heap_after_fork_parent();
+
+
+}	// namespace BPrivate
+
+
+#endif	// _MALLOC_ALLOCATOR_H
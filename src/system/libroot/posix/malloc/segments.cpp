@@ -0,0 +1,739 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <libroot_private.h>
+#include <syscalls.h>
+
+
+//#define TRACE_SEGMENTS
+#ifdef TRACE_SEGMENTS
+#	define TRACE(x) debug_printf x
+#else
+#	define TRACE(x) ;
+#endif
+
+
+namespace BPrivate {
+
+
+#if B_HAIKU_64_BIT
+static const addr_t kHeapReservationBase = 0x1000000000;
+static const addr_t kHeapReservationSize = 0x1000000000;
+#else
+static const addr_t kHeapReservationBase = 0x18000000;
+static const addr_t kHeapReservationSize = 0x48000000;
+#endif
+
+static const uint32 kBinCount = 64;
+	// free runs of up to kBinCount - 1 pages have a bin of their own, all
+	// larger ones share the last one
+static const int32 kPurgeBatchSize = 64;
+static const int32 kHugeCacheSize = 4;
+static const size_t kMaxCachedHugeSize = 64 * 1024 * 1024;
+
+
+static mutex sSegmentLock = MUTEX_INITIALIZER("heap segments");
+static heap_span* sFreeRuns[kBinCount];
+static uint32 sDirtyPages;
+static bigtime_t sLastPurge;
+static int32 sPurging;
+static heap_span* sPurgeRuns[kPurgeBatchSize];
+static int32 sPurgeRunCount;
+	// the runs that are out of the bins while their pages are discarded
+
+static addr_t sReservationBase;
+static addr_t sReservationEnd;
+static area_id sHeapArea = -1;
+static addr_t sHeapAreaBase;
+static size_t sHeapAreaSize;
+
+static size_t sSegmentBytes;
+static size_t sSpanPages;
+static size_t sSpanCount;
+static size_t sFreeRunCount;
+
+static mutex sHugeLock = MUTEX_INITIALIZER("heap huge areas");
+static segment_header* sHugeCache;
+static int32 sHugeCacheCount;
+static size_t sHugeBytes;
+static size_t sHugeCachedBytes;
+static size_t sHugeCount;
+
+
+static uint32
+area_protection()
+{
+	uint32 protection = B_READ_AREA | B_WRITE_AREA;
+	if (__gABIVersion < B_HAIKU_ABI_GCC_2_HAIKU)
+		protection |= B_EXECUTE_AREA;
+	return protection;
+}
+
+
+/*!	Creates an area that is aligned to \a alignment, which must be a power
+	of two of at least kSegmentSize, at an arbitrary address.
+*/
+static area_id
+create_aligned_area(const char* name, size_t size, size_t alignment,
+	void** _address)
+{
+	if (size + alignment < size)
+		return B_NO_MEMORY;
+
+	addr_t reserved;
+	status_t status = _kern_reserve_address_range(&reserved,
+		B_RANDOMIZED_ANY_ADDRESS, size + alignment);
+	if (status != B_OK)
+		return status;
+
+	void* address = (void*)round_up(reserved, alignment);
+	area_id area = create_area(name, &address, B_EXACT_ADDRESS, size,
+		B_NO_LOCK, area_protection());
+
+	_kern_unreserve_address_range(reserved, size + alignment);
+
+	if (area >= 0)
+		*_address = address;
+	return area;
+}
+
+
+static inline uint32
+bin_for(uint32 pageCount)
+{
+	return pageCount < kBinCount ? pageCount - 1 : kBinCount - 1;
+}
+
+
+static void
+insert_free_run(heap_span* run)
+{
+	heap_span*& bin = sFreeRuns[bin_for(run->page_count)];
+	run->previous = NULL;
+	run->next = bin;
+	if (bin != NULL)
+		bin->previous = run;
+	bin = run;
+
+	if (run->dirty)
+		sDirtyPages += run->page_count;
+	sFreeRunCount++;
+}
+
+
+static void
+remove_free_run(heap_span* run)
+{
+	if (run->previous != NULL)
+		run->previous->next = run->next;
+	else
+		sFreeRuns[bin_for(run->page_count)] = run->next;
+	if (run->next != NULL)
+		run->next->previous = run->previous;
+
+	if (run->dirty)
+		sDirtyPages -= run->page_count;
+	sFreeRunCount--;
+}
+
+
+static heap_span*
+set_span(heap_segment* segment, uint32 first, uint32 count, uint8 kind)
+{
+	heap_span* span = &segment->spans[first];
+	span->page_count = count;
+	span->kind = kind;
+
+	if (kind == SPAN_FREE) {
+		// only the ends are needed to merge free runs
+		segment->page_map[first] = first;
+		segment->page_map[first + count - 1] = first;
+	} else {
+		for (uint32 i = 0; i < count; i++)
+			segment->page_map[first + i] = first;
+	}
+
+	return span;
+}
+
+
+/*!	Adds the given pages as free run, merging it with the free runs before
+	and after it.
+*/
+static void
+add_free_run(heap_segment* segment, uint32 first, uint32 count, bool dirty,
+	bigtime_t freeTime)
+{
+	if (first > kSegmentHeaderPages) {
+		heap_span* previous = &segment->spans[segment->page_map[first - 1]];
+		if (previous->kind == SPAN_FREE) {
+			remove_free_run(previous);
+			if (previous->dirty) {
+				if (!dirty || previous->free_time > freeTime)
+					freeTime = previous->free_time;
+				dirty = true;
+			}
+
+			uint32 previousFirst = previous - segment->spans;
+			count += first - previousFirst;
+			first = previousFirst;
+		}
+	}
+
+	if (first + count < kSegmentPages) {
+		heap_span* next = &segment->spans[first + count];
+		if (next->kind == SPAN_FREE) {
+			remove_free_run(next);
+			if (next->dirty) {
+				if (!dirty || next->free_time > freeTime)
+					freeTime = next->free_time;
+				dirty = true;
+			}
+
+			count += next->page_count;
+		}
+	}
+
+	heap_span* run = set_span(segment, first, count, SPAN_FREE);
+	run->dirty = dirty;
+	run->free_time = freeTime;
+	insert_free_run(run);
+}
+
+
+static heap_span*
+find_free_run(uint32 pageCount)
+{
+	for (uint32 bin = bin_for(pageCount); bin < kBinCount; bin++) {
+		for (heap_span* run = sFreeRuns[bin]; run != NULL; run = run->next) {
+			if (run->page_count >= pageCount)
+				return run;
+		}
+	}
+
+	return NULL;
+}
+
+
+/*!	Adds another segment to the heap, preferably by growing the heap area.
+	The segment lock must be held.
+*/
+static heap_span*
+create_segment()
+{
+	heap_segment* segment;
+	if (sHeapArea >= 0
+		&& resize_area(sHeapArea, sHeapAreaSize + kSegmentSize) == B_OK) {
+		segment = (heap_segment*)(sHeapAreaBase + sHeapAreaSize);
+		sHeapAreaSize += kSegmentSize;
+	} else {
+		// Another area is in the way, or we are out of memory. Start a new
+		// heap area, right behind the current one if that is still within
+		// our reservation.
+		void* address = (void*)(sHeapAreaBase + sHeapAreaSize);
+		area_id area = -1;
+		if ((addr_t)address >= sReservationBase
+			&& (addr_t)address + kSegmentSize <= sReservationEnd) {
+			area = create_area("heap", &address, B_EXACT_ADDRESS,
+				kSegmentSize, B_NO_LOCK, area_protection());
+			if (area == B_NO_MEMORY)
+				return NULL;
+		}
+		if (area < 0)
+			area = create_aligned_area("heap", kSegmentSize, kSegmentSize,
+				&address);
+		if (area < 0)
+			return NULL;
+
+		TRACE(("heap: new heap area %" B_PRId32 " at %p\n", area, address));
+
+		sHeapArea = area;
+		sHeapAreaBase = (addr_t)address;
+		sHeapAreaSize = kSegmentSize;
+		segment = (heap_segment*)address;
+	}
+
+	sSegmentBytes += kSegmentSize;
+
+	// the area is cleared, so only the free run needs to be set up
+	segment->kind = SEGMENT_PAGES;
+
+	heap_span* run = set_span(segment, kSegmentHeaderPages, kMaxSpanPages,
+		SPAN_FREE);
+	run->dirty = false;
+	insert_free_run(run);
+
+	return run;
+}
+
+
+/*!	Gives the segments at the end of the heap area back to the system, as
+	long as they are entirely free, and their pages have been purged already.
+	The segment lock must be held.
+*/
+static void
+shrink_heap_area()
+{
+	while (sHeapAreaSize > kSegmentSize) {
+		heap_segment* segment = (heap_segment*)(sHeapAreaBase + sHeapAreaSize
+			- kSegmentSize);
+		heap_span* run = &segment->spans[kSegmentHeaderPages];
+		if (run->kind != SPAN_FREE || run->page_count != kMaxSpanPages
+			|| run->dirty) {
+			return;
+		}
+
+		remove_free_run(run);
+		if (resize_area(sHeapArea, sHeapAreaSize - kSegmentSize) != B_OK) {
+			insert_free_run(run);
+			return;
+		}
+
+		sHeapAreaSize -= kSegmentSize;
+		sSegmentBytes -= kSegmentSize;
+	}
+}
+
+
+status_t
+init_segments()
+{
+	// Reserve a large range for the heap, so that it can grow without
+	// running into other areas. They may get reclaimed by other areas,
+	// though, but the maximum size of the heap is guaranteed until the space
+	// is really needed.
+	addr_t base = kHeapReservationBase;
+	if (_kern_reserve_address_range(&base, B_RANDOMIZED_BASE_ADDRESS,
+			kHeapReservationSize) == B_OK) {
+		sReservationBase = base;
+		sReservationEnd = base + kHeapReservationSize;
+		sHeapAreaBase = round_up(base, kSegmentSize);
+	}
+
+	mutex_lock(&sSegmentLock);
+	heap_span* run = create_segment();
+	mutex_unlock(&sSegmentLock);
+
+	return run != NULL ? B_OK : B_NO_MEMORY;
+}
+
+
+void
+lock_segments()
+{
+	mutex_lock(&sSegmentLock);
+	mutex_lock(&sHugeLock);
+}
+
+
+void
+unlock_segments()
+{
+	mutex_unlock(&sHugeLock);
+	mutex_unlock(&sSegmentLock);
+}
+
+
+void
+reinit_segments_after_fork()
+{
+	mutex_init_etc(&sSegmentLock, "heap segments", MUTEX_FLAG_ADAPTIVE);
+	mutex_init_etc(&sHugeLock, "heap huge areas", MUTEX_FLAG_ADAPTIVE);
+
+	// If we forked while another thread was purging, that thread does not
+	// exist here, so we have to put its runs back, and allow purging again.
+	for (int32 i = 0; i < sPurgeRunCount; i++) {
+		heap_segment* segment = segment_for(sPurgeRuns[i]);
+		add_free_run(segment, sPurgeRuns[i] - segment->spans,
+			sPurgeRuns[i]->page_count, true, system_time());
+	}
+	sPurgeRunCount = 0;
+	atomic_set(&sPurging, 0);
+
+	// the areas have been copied, and got new IDs
+	if (sHeapArea >= 0) {
+		sHeapArea = area_for((void*)sHeapAreaBase);
+		if (sHeapArea < 0) {
+			debug_printf("heap: thread %" B_PRId32 ", heap area at %p not "
+				"found after fork()!\n", find_thread(NULL),
+				(void*)sHeapAreaBase);
+			exit(1);
+		}
+	}
+}
+
+
+/*!	Allocates a span of \a pageCount pages, whose start is aligned to
+	\a alignment, which must be a power of two.
+*/
+heap_span*
+allocate_span(uint32 pageCount, size_t alignment, uint8 kind)
+{
+	uint32 extraPages = alignment > B_PAGE_SIZE
+		? alignment / B_PAGE_SIZE - 1 : 0;
+	uint32 neededPages = pageCount + extraPages;
+	if (neededPages > kMaxSpanPages)
+		return NULL;
+
+	mutex_lock(&sSegmentLock);
+
+	heap_span* run = find_free_run(neededPages);
+	if (run == NULL) {
+		run = create_segment();
+		if (run == NULL) {
+			mutex_unlock(&sSegmentLock);
+			return NULL;
+		}
+	}
+
+	remove_free_run(run);
+
+	heap_segment* segment = segment_for(run);
+	uint32 first = run - segment->spans;
+	uint32 count = run->page_count;
+	bool dirty = run->dirty;
+	bigtime_t freeTime = run->free_time;
+
+	uint32 skipPages = 0;
+	if (extraPages > 0) {
+		addr_t base = (addr_t)segment + first * B_PAGE_SIZE;
+		skipPages = (round_up(base, alignment) - base) / B_PAGE_SIZE;
+	}
+
+	heap_span* span = set_span(segment, first + skipPages, pageCount, kind);
+
+	// put back what is left over before and after the span
+	if (skipPages > 0)
+		add_free_run(segment, first, skipPages, dirty, freeTime);
+	if (skipPages + pageCount < count) {
+		add_free_run(segment, first + skipPages + pageCount,
+			count - skipPages - pageCount, dirty, freeTime);
+	}
+
+	sSpanPages += pageCount;
+	sSpanCount++;
+
+	mutex_unlock(&sSegmentLock);
+
+	return span;
+}
+
+
+void
+free_span(heap_span* span)
+{
+	heap_segment* segment = segment_for(span);
+	bigtime_t now = system_time();
+
+	mutex_lock(&sSegmentLock);
+
+	sSpanPages -= span->page_count;
+	sSpanCount--;
+
+	add_free_run(segment, span - segment->spans, span->page_count, true, now);
+
+	mutex_unlock(&sSegmentLock);
+}
+
+
+//	#pragma mark - huge allocations
+
+
+void*
+allocate_huge(size_t size, size_t alignment, bool clear)
+{
+	if (alignment < kMinAlignment)
+		alignment = kMinAlignment;
+	if (alignment >= kSegmentSize)
+		return NULL;
+
+	size_t offset = round_up(sizeof(segment_header), alignment);
+	size_t areaSize = round_up(offset + size, B_PAGE_SIZE);
+	if (areaSize < size)
+		return NULL;
+
+	// reuse a recently freed area, if there is one of about the right size
+	segment_header* segment = NULL;
+
+	mutex_lock(&sHugeLock);
+
+	segment_header* previous = NULL;
+	for (segment_header* cached = sHugeCache; cached != NULL;
+			cached = cached->next) {
+		if (cached->size >= areaSize && cached->size / 2 < areaSize) {
+			if (previous != NULL)
+				previous->next = cached->next;
+			else
+				sHugeCache = cached->next;
+			sHugeCacheCount--;
+			sHugeCachedBytes -= cached->size;
+			segment = cached;
+			break;
+		}
+		previous = cached;
+	}
+
+	mutex_unlock(&sHugeLock);
+
+	if (segment != NULL) {
+		if (clear)
+			memset((uint8*)segment + offset, 0, size);
+	} else {
+		void* address;
+		area_id area = create_aligned_area("heap huge", areaSize,
+			kSegmentSize, &address);
+		if (area < 0)
+			return NULL;
+
+		segment = (segment_header*)address;
+		segment->kind = SEGMENT_HUGE;
+		segment->size = areaSize;
+
+		mutex_lock(&sHugeLock);
+		sHugeBytes += areaSize;
+		sHugeCount++;
+		mutex_unlock(&sHugeLock);
+	}
+
+	segment->object_offset = offset;
+	segment->object_size = size;
+	segment->next = NULL;
+
+	return (uint8*)segment + offset;
+}
+
+
+void
+free_huge(segment_header* segment)
+{
+	mutex_lock(&sHugeLock);
+
+	if (sHugeCacheCount < kHugeCacheSize
+		&& segment->size <= kMaxCachedHugeSize) {
+		segment->free_time = system_time();
+		segment->next = sHugeCache;
+		sHugeCache = segment;
+		sHugeCacheCount++;
+		sHugeCachedBytes += segment->size;
+
+		mutex_unlock(&sHugeLock);
+		return;
+	}
+
+	sHugeBytes -= segment->size;
+	sHugeCount--;
+
+	mutex_unlock(&sHugeLock);
+
+	delete_area(area_for(segment));
+}
+
+
+/*!	Allocates an area of its own for an allocation that is aligned to at
+	least kSegmentSize. It starts where its segment header would have to be,
+	so it has none; see is_aligned_allocation().
+*/
+void*
+allocate_aligned(size_t size, size_t alignment)
+{
+	size_t areaSize = size > 0 ? round_up(size, B_PAGE_SIZE) : B_PAGE_SIZE;
+	if (areaSize < size)
+		return NULL;
+
+	void* address;
+	area_id area = create_aligned_area("heap aligned", areaSize, alignment,
+		&address);
+	if (area < 0)
+		return NULL;
+
+	mutex_lock(&sHugeLock);
+	sHugeBytes += areaSize;
+	sHugeCount++;
+	mutex_unlock(&sHugeLock);
+
+	// the pages of a new area are cleared already
+	return address;
+}
+
+
+void
+free_aligned(void* address)
+{
+	size_t size = aligned_allocation_size(address);
+
+	mutex_lock(&sHugeLock);
+	sHugeBytes -= size;
+	sHugeCount--;
+	mutex_unlock(&sHugeLock);
+
+	delete_area(area_for(address));
+}
+
+
+size_t
+aligned_allocation_size(void* address)
+{
+	area_info info;
+	if (get_area_info(area_for(address), &info) != B_OK)
+		return 0;
+
+	return info.size;
+}
+
+
+/*!	Tries to resize the area of a huge allocation in place.
+*/
+bool
+resize_huge(segment_header* segment, size_t size)
+{
+	size_t areaSize = round_up(segment->object_offset + size, B_PAGE_SIZE);
+	if (areaSize < size)
+		return false;
+
+	if (areaSize != segment->size) {
+		if (resize_area(area_for(segment), areaSize) != B_OK)
+			return false;
+
+		mutex_lock(&sHugeLock);
+		sHugeBytes += areaSize - segment->size;
+		mutex_unlock(&sHugeLock);
+
+		segment->size = areaSize;
+	}
+
+	segment->object_size = size;
+	return true;
+}
+
+
+//	#pragma mark - purging
+
+
+bool
+purge_needed()
+{
+	// the thread heaps purge their queues at the same time, so this does
+	// not depend on the amount of dirty pages alone
+	return system_time() - sLastPurge >= kPurgeInterval;
+}
+
+
+/*!	Discards the pages of the free runs that have not been used for
+	kPurgeDelay, shrinks the heap area if possible, and deletes the huge
+	areas that have been cached for that long.
+*/
+void
+purge_segments()
+{
+	if (atomic_test_and_set(&sPurging, 1, 0) != 0)
+		return;
+
+	bigtime_t now = system_time();
+	heap_span** runs = sPurgeRuns;
+	int32 count = 0;
+
+	mutex_lock(&sSegmentLock);
+
+	sLastPurge = now;
+
+	// only walk the bins if there is anything to discard
+	for (uint32 bin = 0; sDirtyPages > 0 && bin < kBinCount
+			&& count < kPurgeBatchSize; bin++) {
+		heap_span* run = sFreeRuns[bin];
+		while (run != NULL && count < kPurgeBatchSize) {
+			heap_span* next = run->next;
+			if (run->dirty && now - run->free_time >= kPurgeDelay) {
+				// take it out while we discard its pages, so that it is
+				// neither used nor merged in the meantime
+				remove_free_run(run);
+				run->kind = SPAN_PURGING;
+				runs[count++] = run;
+			}
+			run = next;
+		}
+	}
+	sPurgeRunCount = count;
+
+	mutex_unlock(&sSegmentLock);
+
+	for (int32 i = 0; i < count; i++) {
+		_kern_memory_advice((void*)span_base(runs[i]),
+			runs[i]->page_count * B_PAGE_SIZE, MADV_FREE);
+	}
+
+	mutex_lock(&sSegmentLock);
+
+	for (int32 i = 0; i < count; i++) {
+		heap_segment* segment = segment_for(runs[i]);
+		add_free_run(segment, runs[i] - segment->spans, runs[i]->page_count,
+			false, 0);
+	}
+	sPurgeRunCount = 0;
+
+	shrink_heap_area();
+
+	mutex_unlock(&sSegmentLock);
+
+	// delete the huge areas that have not been reused
+	segment_header* expired = NULL;
+
+	mutex_lock(&sHugeLock);
+
+	segment_header* previous = NULL;
+	segment_header* segment = sHugeCache;
+	while (segment != NULL) {
+		segment_header* next = segment->next;
+		if (now - segment->free_time >= kPurgeDelay) {
+			if (previous != NULL)
+				previous->next = next;
+			else
+				sHugeCache = next;
+			sHugeCacheCount--;
+			sHugeCachedBytes -= segment->size;
+			sHugeBytes -= segment->size;
+			sHugeCount--;
+
+			segment->next = expired;
+			expired = segment;
+		} else
+			previous = segment;
+		segment = next;
+	}
+
+	mutex_unlock(&sHugeLock);
+
+	while (expired != NULL) {
+		segment_header* next = expired->next;
+		delete_area(area_for(expired));
+		expired = next;
+	}
+
+	atomic_set(&sPurging, 0);
+}
+
+
+void
+get_segment_stats(size_t& totalBytes, size_t& spanBytes, size_t& spanCount,
+	size_t& freeRunCount)
+{
+	lock_segments();
+
+	totalBytes = sSegmentBytes + sHugeBytes;
+	spanBytes = sSpanPages * B_PAGE_SIZE + sHugeBytes - sHugeCachedBytes;
+	spanCount = sSpanCount + sHugeCount - sHugeCacheCount;
+	freeRunCount = sFreeRunCount + sHugeCacheCount;
+
+	unlock_segments();
+}
+
+
+}	// namespace BPrivate
@@ -0,0 +1,794 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "allocator.h"
+
+#include <string.h>
+
+#include <TLS.h>
+
+#include <tls.h>
+
+
+namespace BPrivate {
+
+
+struct size_class_info {
+	uint32	size;
+	uint16	page_count;
+	uint16	capacity;
+};
+
+struct thread_heap {
+	heap_span*		spans[kSizeClassCount];
+		// the spans the heap allocates from, the first one is used until
+		// it runs out of objects
+	thread_heap*	next;
+	thread_heap*	previous;
+	thread_id		thread;
+};
+
+struct span_queue {
+	mutex			lock;
+	heap_span*		first;
+		// detached spans that objects have been freed to since
+};
+
+
+static const uint32 kClassSizes[kSizeClassCount] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256, 320, 384, 448, 512,
+	640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+	2560, 3072, 3584, 4096, 5120, 6144, 7168, 8192,
+	10240, 12288, 14336, 16384, 20480, 24576, 28672, 32768
+};
+
+static free_object* const kSpanDetached = (free_object*)1;
+	// the remote free list of a detached span; objects are aligned, so it
+	// cannot be confused with one of them
+
+static const uint32 kMinObjectsPerSpan = 8;
+static const uint32 kMinSpanPages = 4;
+
+static size_class_info sSizeClasses[kSizeClassCount];
+static uint8 sSmallSizeClasses[1024 / 16 + 1];
+	// indexed by the size rounded up to 16 bytes
+static uint8 sLargeSizeClasses[kMaxSmallSize / 128 + 1];
+	// indexed by the size rounded up to 128 bytes
+
+static span_queue sQueues[kSizeClassCount];
+
+static mutex sHeapListLock = MUTEX_INITIALIZER("thread heaps");
+static thread_heap* sHeaps;
+static thread_heap* sFreeHeaps;
+
+static mutex sSharedHeapLock = MUTEX_INITIALIZER("shared heap");
+static thread_heap sSharedHeap;
+	// used by threads that allocate after their heap has been released, as
+	// from destructors that run after the thread exit hook; their own heap
+	// would never be released again
+
+
+template<typename Type> static inline Type*
+atomic_pointer_get(Type** pointer)
+{
+#if B_HAIKU_64_BIT
+	return (Type*)atomic_get64((int64*)pointer);
+#else
+	return (Type*)atomic_get((int32*)pointer);
+#endif
+}
+
+
+template<typename Type> static inline Type*
+atomic_pointer_get_and_set(Type** pointer, Type* value)
+{
+#if B_HAIKU_64_BIT
+	return (Type*)atomic_get_and_set64((int64*)pointer, (int64)(addr_t)value);
+#else
+	return (Type*)atomic_get_and_set((int32*)pointer, (int32)(addr_t)value);
+#endif
+}
+
+
+template<typename Type> static inline Type*
+atomic_pointer_test_and_set(Type** pointer, Type* value, Type* testAgainst)
+{
+#if B_HAIKU_64_BIT
+	return (Type*)atomic_test_and_set64((int64*)pointer, (int64)(addr_t)value,
+		(int64)(addr_t)testAgainst);
+#else
+	return (Type*)atomic_test_and_set((int32*)pointer, (int32)(addr_t)value,
+		(int32)(addr_t)testAgainst);
+#endif
+}
+
+
+static void
+init_size_classes()
+{
+	for (uint32 i = 0; i < kSizeClassCount; i++) {
+		size_class_info& info = sSizeClasses[i];
+		info.size = kClassSizes[i];
+
+		// a span has room for at least kMinObjectsPerSpan objects, and
+		// wastes as little as possible at its end
+		uint32 minPages = (info.size * kMinObjectsPerSpan + B_PAGE_SIZE - 1)
+			/ B_PAGE_SIZE;
+		if (minPages < kMinSpanPages)
+			minPages = kMinSpanPages;
+
+		uint32 bestPages = minPages;
+		uint32 bestWaste = B_PAGE_SIZE * minPages % info.size;
+		for (uint32 pages = minPages + 1; pages <= minPages + minPages / 4;
+				pages++) {
+			uint32 waste = B_PAGE_SIZE * pages % info.size;
+			if (waste * bestPages < bestWaste * pages) {
+				bestPages = pages;
+				bestWaste = waste;
+			}
+		}
+
+		info.page_count = bestPages;
+		info.capacity = B_PAGE_SIZE * bestPages / info.size;
+	}
+
+	uint32 sizeClass = 0;
+	for (uint32 i = 0; i < sizeof(sSmallSizeClasses); i++) {
+		while (sSizeClasses[sizeClass].size < i * 16)
+			sizeClass++;
+		sSmallSizeClasses[i] = sizeClass;
+	}
+
+	sizeClass = 0;
+	for (uint32 i = 0; i < sizeof(sLargeSizeClasses); i++) {
+		while (sSizeClasses[sizeClass].size < i * 128)
+			sizeClass++;
+		sLargeSizeClasses[i] = sizeClass;
+	}
+}
+
+
+static inline uint32
+size_class_for(size_t size)
+{
+	if (size <= 1024)
+		return sSmallSizeClasses[(size + 15) / 16];
+	return sLargeSizeClasses[(size + 127) / 128];
+}
+
+
+//	#pragma mark - spans
+
+
+static inline bool
+span_has_free_objects(heap_span* span)
+{
+	return span->free_list != NULL || span->unused < span->end;
+}
+
+
+static inline void*
+allocate_from_span(heap_span* span)
+{
+	free_object* object = span->free_list;
+	if (object != NULL)
+		span->free_list = object->next;
+	else {
+		object = (free_object*)span->unused;
+		span->unused += span->object_size;
+	}
+
+	span->used++;
+	return object;
+}
+
+
+static void
+insert_span(thread_heap* heap, heap_span* span)
+{
+	heap_span*& first = heap->spans[span->size_class];
+	span->previous = NULL;
+	span->next = first;
+	if (first != NULL)
+		first->previous = span;
+	first = span;
+}
+
+
+static void
+remove_span(thread_heap* heap, heap_span* span)
+{
+	if (span->previous != NULL)
+		span->previous->next = span->next;
+	else
+		heap->spans[span->size_class] = span->next;
+	if (span->next != NULL)
+		span->next->previous = span->previous;
+}
+
+
+/*!	Moves the objects other threads have freed to the span's own free list.
+	Must only be called by the span's owner, or with the lock of the queue
+	the span is in held.
+*/
+static void
+collect_remote_frees(heap_span* span)
+{
+	if (atomic_pointer_get(&span->remote_free_list) == NULL)
+		return;
+
+	free_object* first = atomic_pointer_get_and_set(&span->remote_free_list,
+		(free_object*)NULL);
+
+	free_object* last = first;
+	uint32 count = 1;
+	while (last->next != NULL) {
+		last = last->next;
+		count++;
+	}
+
+	last->next = span->free_list;
+	span->free_list = first;
+	span->used -= count;
+}
+
+
+/*!	Lets go of a span that has no free objects left. Returns \c false, if
+	objects have been freed to it in the meantime, and the owner keeps it.
+	The state of the span lives in its remote free list, so that a thread
+	freeing an object to it learns with the same atomic operation whether it
+	has to queue the span; it must not touch the span afterwards otherwise,
+	as the owner may free it any time.
+*/
+static bool
+detach_span(heap_span* span)
+{
+	thread_heap* heap = span->owner;
+	span->owner = NULL;
+
+	if (atomic_pointer_test_and_set(&span->remote_free_list, kSpanDetached,
+			(free_object*)NULL) == NULL) {
+		return true;
+	}
+
+	span->owner = heap;
+	return false;
+}
+
+
+static void
+queue_span(heap_span* span)
+{
+	span_queue& queue = sQueues[span->size_class];
+
+	mutex_lock(&queue.lock);
+
+	span->previous = NULL;
+	span->next = queue.first;
+	if (queue.first != NULL)
+		queue.first->previous = span;
+	queue.first = span;
+
+	mutex_unlock(&queue.lock);
+}
+
+
+static heap_span*
+dequeue_span(uint32 sizeClass)
+{
+	span_queue& queue = sQueues[sizeClass];
+	if (queue.first == NULL)
+		return NULL;
+
+	mutex_lock(&queue.lock);
+
+	heap_span* span = queue.first;
+	if (span != NULL) {
+		queue.first = span->next;
+		if (span->next != NULL)
+			span->next->previous = NULL;
+	}
+
+	mutex_unlock(&queue.lock);
+	return span;
+}
+
+
+static void
+free_remote(heap_span* span, free_object* object)
+{
+	free_object* first;
+	do {
+		first = atomic_pointer_get(&span->remote_free_list);
+		object->next = first != kSpanDetached ? first : NULL;
+	} while (atomic_pointer_test_and_set(&span->remote_free_list, object,
+			first) != first);
+
+	// If the span has been detached, the first one to free an object to it
+	// makes it available to all heaps again. No one else knows about the
+	// span until then, so it cannot have been freed.
+	if (first == kSpanDetached)
+		queue_span(span);
+}
+
+
+static heap_span*
+create_small_span(uint32 sizeClass)
+{
+	const size_class_info& info = sSizeClasses[sizeClass];
+	heap_span* span = allocate_span(info.page_count, B_PAGE_SIZE, SPAN_SMALL);
+	if (span == NULL)
+		return NULL;
+
+	span->free_list = NULL;
+	span->remote_free_list = NULL;
+	span->unused = span_base(span);
+	span->end = span->unused + info.capacity * info.size;
+	span->owner = NULL;
+	span->object_size = info.size;
+	span->used = 0;
+	span->size_class = sizeClass;
+
+	return span;
+}
+
+
+/*!	Frees the spans in the queues that all objects have been freed of.
+*/
+static void
+purge_queues()
+{
+	heap_span* empty = NULL;
+
+	for (uint32 i = 0; i < kSizeClassCount; i++) {
+		span_queue& queue = sQueues[i];
+		if (queue.first == NULL)
+			continue;
+
+		mutex_lock(&queue.lock);
+
+		heap_span* span = queue.first;
+		while (span != NULL) {
+			heap_span* next = span->next;
+
+			collect_remote_frees(span);
+			if (span->used == 0) {
+				if (span->previous != NULL)
+					span->previous->next = next;
+				else
+					queue.first = next;
+				if (next != NULL)
+					next->previous = span->previous;
+
+				span->next = empty;
+				empty = span;
+			}
+
+			span = next;
+		}
+
+		mutex_unlock(&queue.lock);
+	}
+
+	while (empty != NULL) {
+		heap_span* next = empty->next;
+		free_span(empty);
+		empty = next;
+	}
+}
+
+
+static void
+purge_if_needed()
+{
+	if (!purge_needed())
+		return;
+
+	purge_queues();
+	purge_segments();
+}
+
+
+//	#pragma mark - thread heaps
+
+
+static thread_heap*
+create_heap()
+{
+	mutex_lock(&sHeapListLock);
+
+	thread_heap* heap = sFreeHeaps;
+	if (heap != NULL)
+		sFreeHeaps = heap->next;
+	else {
+		heap_span* span = allocate_span(
+			(sizeof(thread_heap) + B_PAGE_SIZE - 1) / B_PAGE_SIZE, B_PAGE_SIZE,
+			SPAN_LARGE);
+		if (span == NULL) {
+			mutex_unlock(&sHeapListLock);
+			return NULL;
+		}
+
+		heap = (thread_heap*)span_base(span);
+	}
+
+	memset(heap->spans, 0, sizeof(heap->spans));
+	heap->thread = find_thread(NULL);
+
+	heap->previous = NULL;
+	heap->next = sHeaps;
+	if (sHeaps != NULL)
+		sHeaps->previous = heap;
+	sHeaps = heap;
+
+	mutex_unlock(&sHeapListLock);
+
+	tls_set(TLS_MALLOC_HEAP_SLOT, heap);
+	return heap;
+}
+
+
+static inline thread_heap*
+current_heap()
+{
+	thread_heap* heap = (thread_heap*)tls_get(TLS_MALLOC_HEAP_SLOT);
+	if (heap != NULL)
+		return heap;
+
+	return create_heap();
+}
+
+
+/*!	Hands all spans of the heap over to the other heaps, or back to the
+	segments if they are empty.
+*/
+static void
+release_heap_spans(thread_heap* heap)
+{
+	for (uint32 i = 0; i < kSizeClassCount; i++) {
+		while (heap->spans[i] != NULL) {
+			heap_span* span = heap->spans[i];
+			remove_span(heap, span);
+
+			collect_remote_frees(span);
+			if (span->used == 0) {
+				span->owner = NULL;
+				free_span(span);
+				continue;
+			}
+
+			if (!span_has_free_objects(span) && detach_span(span))
+				continue;
+
+			span->owner = NULL;
+			queue_span(span);
+		}
+	}
+}
+
+
+static void*
+allocate_small_slow(thread_heap* heap, uint32 sizeClass)
+{
+	purge_if_needed();
+
+	// look for a span with free objects, and detach the full ones on the way
+	heap_span* span = heap->spans[sizeClass];
+	while (span != NULL) {
+		heap_span* next = span->next;
+
+		collect_remote_frees(span);
+		if (span_has_free_objects(span)) {
+			if (span != heap->spans[sizeClass]) {
+				remove_span(heap, span);
+				insert_span(heap, span);
+			}
+			return allocate_from_span(span);
+		}
+
+		remove_span(heap, span);
+		if (!detach_span(span)) {
+			collect_remote_frees(span);
+			insert_span(heap, span);
+			return allocate_from_span(span);
+		}
+
+		span = next;
+	}
+
+	// adopt a span other threads have freed objects to
+	while ((span = dequeue_span(sizeClass)) != NULL) {
+		span->owner = heap;
+
+		collect_remote_frees(span);
+		if (span_has_free_objects(span) || !detach_span(span)) {
+			collect_remote_frees(span);
+			insert_span(heap, span);
+			return allocate_from_span(span);
+		}
+	}
+
+	span = create_small_span(sizeClass);
+	if (span == NULL)
+		return NULL;
+
+	span->owner = heap;
+	insert_span(heap, span);
+	return allocate_from_span(span);
+}
+
+
+static inline void*
+allocate_small(thread_heap* heap, uint32 sizeClass)
+{
+	heap_span* span = heap->spans[sizeClass];
+	if (span != NULL && span_has_free_objects(span))
+		return allocate_from_span(span);
+
+	return allocate_small_slow(heap, sizeClass);
+}
+
+
+static void
+free_empty_span(thread_heap* heap, heap_span* span)
+{
+	// keep the last span of its size class around
+	if (span->previous == NULL && span->next == NULL)
+		return;
+
+	remove_span(heap, span);
+	span->owner = NULL;
+	free_span(span);
+
+	purge_if_needed();
+}
+
+
+static void*
+allocate_large(size_t size, size_t alignment, bool clear)
+{
+	purge_if_needed();
+
+	heap_span* span = allocate_span(
+		round_up(size, B_PAGE_SIZE) / B_PAGE_SIZE, alignment, SPAN_LARGE);
+	if (span == NULL)
+		return NULL;
+
+	void* address = (void*)span_base(span);
+	if (clear)
+		memset(address, 0, size);
+
+	return address;
+}
+
+
+//	#pragma mark - private API
+
+
+status_t
+init_thread_heaps()
+{
+	init_size_classes();
+
+	for (uint32 i = 0; i < kSizeClassCount; i++)
+		mutex_init_etc(&sQueues[i].lock, "heap span queue", MUTEX_FLAG_ADAPTIVE);
+
+	return init_segments();
+}
+
+
+void*
+heap_allocate(size_t size, size_t alignment, bool clear)
+{
+	if (alignment >= kSegmentSize)
+		return allocate_aligned(size, alignment);
+
+	if (size <= kMaxSmallSize && alignment <= B_PAGE_SIZE) {
+		uint32 sizeClass = size_class_for(size < alignment ? alignment : size);
+
+		// the objects are aligned to their size, as far as it is a power of
+		// two
+		if (alignment > kMinAlignment) {
+			while (sizeClass < kSizeClassCount
+				&& sSizeClasses[sizeClass].size % alignment != 0) {
+				sizeClass++;
+			}
+		}
+
+		if (sizeClass < kSizeClassCount) {
+			thread_heap* heap = current_heap();
+			if (heap == NULL)
+				return NULL;
+
+			void* address;
+			if (heap == &sSharedHeap) {
+				mutex_lock(&sSharedHeapLock);
+				address = allocate_small(heap, sizeClass);
+				mutex_unlock(&sSharedHeapLock);
+			} else
+				address = allocate_small(heap, sizeClass);
+			if (address != NULL && clear)
+				memset(address, 0, size);
+			return address;
+		}
+	}
+
+	if (alignment < B_PAGE_SIZE)
+		alignment = B_PAGE_SIZE;
+
+	if (size <= kMaxLargeSize && alignment <= kMaxLargeSize)
+		return allocate_large(size, alignment, clear);
+
+	return allocate_huge(size, alignment, clear);
+}
+
+
+void
+heap_free(void* address)
+{
+	if (is_aligned_allocation(address)) {
+		free_aligned(address);
+		return;
+	}
+
+	heap_segment* segment = segment_for(address);
+	if (segment->kind == SEGMENT_HUGE) {
+		free_huge(segment);
+		return;
+	}
+
+	heap_span* span = span_for(segment, address);
+	if (span->kind == SPAN_LARGE) {
+		free_span(span);
+		purge_if_needed();
+		return;
+	}
+
+	free_object* object = (free_object*)address;
+
+	// Only the owner may use the span's free list. If it has no owner, we
+	// cannot be it, so there is no need to create a heap just yet. The spans
+	// of the shared heap are only used with its lock held.
+	thread_heap* heap = (thread_heap*)tls_get(TLS_MALLOC_HEAP_SLOT);
+	if (heap == NULL || span->owner != heap || heap == &sSharedHeap) {
+		free_remote(span, object);
+		return;
+	}
+
+	object->next = span->free_list;
+	span->free_list = object;
+
+	if (--span->used == 0)
+		free_empty_span(heap, span);
+}
+
+
+void*
+heap_reallocate(void* address, size_t size)
+{
+	heap_segment* segment = segment_for(address);
+	size_t oldSize;
+	if (is_aligned_allocation(address)) {
+		oldSize = aligned_allocation_size(address);
+		if (size <= oldSize && size > oldSize / 2)
+			return address;
+	} else if (segment->kind == SEGMENT_HUGE) {
+		if (size > kMaxLargeSize && resize_huge(segment, size))
+			return address;
+
+		oldSize = segment->object_size;
+	} else {
+		heap_span* span = span_for(segment, address);
+		if (span->kind == SPAN_SMALL) {
+			// like the previous allocator, keep small objects where they are
+			// when they shrink
+			oldSize = span->object_size;
+			if (size <= oldSize)
+				return address;
+		} else {
+			oldSize = span->page_count * B_PAGE_SIZE;
+			if (size <= oldSize && size > oldSize / 2)
+				return address;
+		}
+	}
+
+	void* newAddress = heap_allocate(size, kMinAlignment, false);
+	if (newAddress == NULL)
+		return NULL;
+
+	memcpy(newAddress, address, oldSize < size ? oldSize : size);
+	heap_free(address);
+
+	return newAddress;
+}
+
+
+size_t
+heap_object_size(void* address)
+{
+	if (is_aligned_allocation(address))
+		return aligned_allocation_size(address);
+
+	heap_segment* segment = segment_for(address);
+	if (segment->kind == SEGMENT_HUGE)
+		return segment->size - segment->object_offset;
+
+	heap_span* span = span_for(segment, address);
+	if (span->kind == SPAN_SMALL)
+		return span->object_size;
+
+	return span->page_count * B_PAGE_SIZE;
+}
+
+
+void
+heap_thread_exit()
+{
+	thread_heap* heap = (thread_heap*)tls_get(TLS_MALLOC_HEAP_SLOT);
+	if (heap == &sSharedHeap)
+		return;
+
+	// anything the thread allocates from now on comes from the shared heap
+	tls_set(TLS_MALLOC_HEAP_SLOT, &sSharedHeap);
+	if (heap == NULL)
+		return;
+
+	release_heap_spans(heap);
+
+	mutex_lock(&sHeapListLock);
+
+	if (heap->previous != NULL)
+		heap->previous->next = heap->next;
+	else
+		sHeaps = heap->next;
+	if (heap->next != NULL)
+		heap->next->previous = heap->previous;
+
+	heap->next = sFreeHeaps;
+	sFreeHeaps = heap;
+
+	mutex_unlock(&sHeapListLock);
+}
+
+
+void
+heap_before_fork()
+{
+	mutex_lock(&sSharedHeapLock);
+	mutex_lock(&sHeapListLock);
+	for (uint32 i = 0; i < kSizeClassCount; i++)
+		mutex_lock(&sQueues[i].lock);
+	lock_segments();
+}
+
+
+void
+heap_after_fork_child()
+{
+	// The heaps of the other threads stay as they were when we forked; they
+	// might have been in use, so we cannot touch them. Their objects can
+	// still be freed, though.
+	mutex_init_etc(&sSharedHeapLock, "shared heap", MUTEX_FLAG_ADAPTIVE);
+	mutex_init_etc(&sHeapListLock, "thread heaps", MUTEX_FLAG_ADAPTIVE);
+	for (uint32 i = 0; i < kSizeClassCount; i++)
+		mutex_init_etc(&sQueues[i].lock, "heap span queue", MUTEX_FLAG_ADAPTIVE);
+	reinit_segments_after_fork();
+}
+
+
+void
+heap_after_fork_parent()
+{
+	unlock_segments();
+	for (uint32 i = 0; i < kSizeClassCount; i++)
+		mutex_unlock(&sQueues[i].lock);
+	mutex_unlock(&sHeapListLock);
+	mutex_unlock(&sSharedHeapLock);
+}
+
+
+}	// namespace BPrivate
@@ -86,14 +86,22 @@ cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, bigtime_t timeout)
 		(int32*)&cond->lock, "pthread condition",
 		timeout == B_INFINITE_TIMEOUT ? 0 : flags, timeout);
 
-	if (status == B_INTERRUPTED) {
-		// EINTR is not an allowed return value. We either have to restart
-		// waiting -- which we can't atomically -- or return a spurious 0.
+	if (status == B_USER_MUTEX_REQUEUED) {
+		// we have been moved over to the mutex by a broadcast, and the kernel
+		// has already handed it to us
+		mutex->owner = find_thread(NULL);
+		mutex->owner_count = 1;
 		status = 0;
+	} else {
+		if (status == B_INTERRUPTED) {
+			// EINTR is not an allowed return value. We either have to restart
+			// waiting -- which we can't atomically -- or return a spurious 0.
+			status = 0;
+		}
+
+		pthread_mutex_lock(mutex);
 	}
 
-	pthread_mutex_lock(mutex);
-
 	cond->waiter_count--;
 	// If there are no more waiters, we can change mutexes.
 	if (cond->waiter_count == 0)
@@ -109,6 +117,17 @@ cond_signal(pthread_cond_t* cond, bool broadcast)
 	if (cond->waiter_count == 0)
 		return;
 
+	pthread_mutex_t* mutex = cond->mutex;
+	if (broadcast && mutex != NULL && (cond->flags & COND_FLAG_SHARED) == 0) {
+		// Wake up only one waiter, and move the others over to the mutex, so
+		// that they get it one after the other, instead of all waking up
+		// just to block on it again.
+		if (_kern_mutex_requeue((int32*)&cond->lock, (int32*)&mutex->lock, 1)
+				== B_OK) {
+			return;
+		}
+	}
+
 	// release the condition lock
 	_kern_mutex_unlock((int32*)&cond->lock,
 		broadcast ? B_USER_MUTEX_UNBLOCK_ALL : 0);
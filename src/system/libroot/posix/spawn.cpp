@@ -11,10 +11,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <libroot_private.h>
 #include <signal_defs.h>
+#include <spawn_defs.h>
 #include <syscalls.h>
+#include <umask.h>
 
 
 enum action_type {
@@ -328,152 +332,173 @@ posix_spawnattr_setsigmask(posix_spawnattr_t *_attr, const sigset_t *sigmask)
 
 
 static int
-process_spawnattr(const posix_spawnattr_t *_attr)
+do_spawn(pid_t *_pid, const char *path, char *const argv[],
+	char *const environment[], const struct spawn_file_action *fileActions,
+	int32 fileActionCount, const struct spawn_attributes *attributes,
+	bool useDefaultInterpreter)
 {
-	if (_attr == NULL)
-		return 0;
+	int32 argCount = 0;
+	while (argv[argCount] != NULL)
+		argCount++;
 
-	struct _posix_spawnattr *attr = *_attr;
-	if (attr == NULL)
+	int32 envCount = 0;
+	while (environment[envCount] != NULL)
+		envCount++;
+
+	if (argCount == 0)
 		return EINVAL;
 
-	if ((attr->flags & POSIX_SPAWN_SETSIGMASK) != 0)
-		sigprocmask(SIG_SETMASK, &attr->sigmask, NULL);
-
-	if ((attr->flags & POSIX_SPAWN_SETSIGDEF) != 0) {
-		struct sigaction action;
-		action.sa_handler = SIG_DFL;
-		action.sa_flags = 0;
-		action.sa_userdata = NULL;
-		sigemptyset(&action.sa_mask);
-		for (int i = 1; i <= MAX_SIGNAL_NUMBER; i++) {
-			if (sigismember(&attr->sigdefault, i) == 1
-				&& sigaction(i, &action, NULL) != 0) {
-				return errno;
-			}
-		}
+	// test validity of the executable, and support scripts like exec*() does
+	char invoker[B_FILE_NAME_LENGTH];
+	status_t status = __test_executable(path, invoker);
+	if (status < B_OK) {
+		if (status != B_NOT_AN_EXECUTABLE || !useDefaultInterpreter)
+			return status;
+
+		strcpy(invoker, "/bin/sh");
 	}
 
-	if ((attr->flags & POSIX_SPAWN_RESETIDS) != 0) {
-		if (setegid(getgid()) != 0)
-			return errno;
-		if (seteuid(getuid()) != 0)
-			return errno;
+	char** newArgs = NULL;
+	if (invoker[0] != '\0') {
+		status = __parse_invoke_line(invoker, &newArgs, &argv, &argCount,
+			path);
+		if (status < B_OK)
+			return status;
+
+		path = newArgs[0];
 	}
 
-	if ((attr->flags & POSIX_SPAWN_SETPGROUP) != 0) {
-		if (setpgid(0, attr->pgroup) != 0)
-			return errno;
+	char** flatArgs = NULL;
+	size_t flatArgsSize;
+	status = __flatten_process_args(newArgs != NULL ? newArgs : argv, argCount,
+		environment, &envCount, path, &flatArgs, &flatArgsSize);
+
+	if (status == B_OK) {
+		thread_id thread = _kern_spawn(path, flatArgs, flatArgsSize, argCount,
+			envCount, __gUmask, fileActions, fileActionCount, attributes);
+		if (thread >= 0) {
+			if (_pid != NULL)
+				*_pid = thread;
+		} else
+			status = thread;
+
+		free(flatArgs);
 	}
 
-	return 0;
+	free(newArgs);
+	return status;
 }
 
 
 static int
-process_file_actions(const posix_spawn_file_actions_t *_actions, int *errfd)
+do_posix_spawn(pid_t *_pid, const char *path,
+	const posix_spawn_file_actions_t *_actions,
+	const posix_spawnattr_t *_attr, char *const argv[], char *const envp[],
+	bool envpath)
 {
-	if (_actions == NULL)
-		return 0;
+	if (path == NULL || argv == NULL)
+		return EINVAL;
 
-	struct _posix_spawn_file_actions* actions = *_actions;
-	if (actions == NULL)
+	struct _posix_spawn_file_actions* actions = NULL;
+	if (_actions != NULL && (actions = *_actions) == NULL)
 		return EINVAL;
 
-	for (int i = 0; i < actions->count; i++) {
-		struct _file_action *action = &actions->actions[i];
+	struct _posix_spawnattr* attr = NULL;
+	if (_attr != NULL && (attr = *_attr) == NULL)
+		return EINVAL;
 
-		if (action->fd == *errfd) {
-			int newfd = dup(action->fd);
-			if (newfd == -1)
-				return errno;
-			close(action->fd);
-			fcntl(newfd, F_SETFD, FD_CLOEXEC);
-			*errfd = newfd;
-		}
+	// The kernel sets up the new team as it would look after the file
+	// actions, the attributes, and the exec*() have been applied in a forked
+	// child, so that we don't have to copy our address space.
+	struct spawn_attributes attributes;
+	memset(&attributes, 0, sizeof(attributes));
+	if (attr != NULL) {
+		attributes.flags = attr->flags;
+		attributes.process_group = attr->pgroup;
+		attributes.signal_mask = attr->sigmask;
+		attributes.default_signals = attr->sigdefault;
+	}
 
-		if (action->type == file_action_close) {
-			if (close(action->fd) != 0)
-				return errno;
-		} else if (action->type == file_action_open) {
-			int fd = open(action->action.open_action.path,
-				action->action.open_action.oflag,
-				action->action.open_action.mode);
-			if (fd == -1)
-				return errno;
-			if (fd != action->fd) {
-				if (dup2(action->fd, fd) != 0)
-					return errno;
-				if (close(fd) != 0)
-					return errno;
+	struct spawn_file_action* fileActions = NULL;
+	int32 fileActionCount = actions != NULL ? actions->count : 0;
+	if (fileActionCount > 0) {
+		fileActions = (struct spawn_file_action*)malloc(
+			fileActionCount * sizeof(struct spawn_file_action));
+		if (fileActions == NULL)
+			return ENOMEM;
+
+		for (int32 i = 0; i < fileActionCount; i++) {
+			const struct _file_action& action = actions->actions[i];
+			struct spawn_file_action& fileAction = fileActions[i];
+			memset(&fileAction, 0, sizeof(fileAction));
+			fileAction.fd = action.fd;
+
+			switch (action.type) {
+				case file_action_open:
+					fileAction.type = SPAWN_FILE_ACTION_OPEN;
+					fileAction.path = action.action.open_action.path;
+					fileAction.open_mode = action.action.open_action.oflag;
+					fileAction.permissions = action.action.open_action.mode
+						& ~__gUmask;
+					break;
+				case file_action_close:
+					fileAction.type = SPAWN_FILE_ACTION_CLOSE;
+					break;
+				case file_action_dup2:
+					fileAction.type = SPAWN_FILE_ACTION_DUP2;
+					fileAction.source_fd = action.action.dup2_action.srcfd;
+					break;
 			}
-		} else if (action->type == file_action_dup2) {
-			if (dup2(action->action.dup2_action.srcfd, action->fd) != 0)
-				return errno;
 		}
 	}
 
-	return 0;
-}
-
-
-static int
-do_posix_spawn(pid_t *_pid, const char *path,
-	const posix_spawn_file_actions_t *actions,
-	const posix_spawnattr_t *attrp, char *const argv[], char *const envp[],
-	bool envpath)
-{
-	int err = 0;
-	int fds[2];
-	pid_t pid;
-
-	if (pipe(fds) != 0)
-		return errno;
-	if (fcntl(fds[0], F_SETFD, FD_CLOEXEC) != 0
-		|| fcntl(fds[1], F_SETFD, FD_CLOEXEC) != 0) {
-		goto fail;
-	}
-	pid = vfork();
-	if (pid == -1)
-		goto fail;
-
-	if (pid != 0) {
-		// parent
-		if (_pid != NULL)
-			*_pid = pid;
-		close(fds[1]);
-		read(fds[0], &err, sizeof(err));
-		if (err != 0)
-			waitpid(pid, NULL, WNOHANG);
-		close(fds[0]);
-		return err;
-	}
-
-	// child
-	close(fds[0]);
+	char *const *environment = envp != NULL ? envp : environ;
+	int err;
+
+	if (!envpath || strchr(path, '/') != NULL) {
+		err = do_spawn(_pid, path, argv, environment, fileActions,
+			fileActionCount, &attributes, envpath);
+	} else {
+		// path is just a leaf name, so we have to look it up in the PATH,
+		// like execvpe() does
+		err = B_ENTRY_NOT_FOUND;
+
+		const char* paths = getenv("PATH");
+		int fileNameLen = strlen(path);
+
+		const char* pathEnd = paths != NULL ? paths - 1 : NULL;
+		while (pathEnd != NULL) {
+			paths = pathEnd + 1;
+			pathEnd = strchr(paths, ':');
+			int pathLen = (pathEnd ? pathEnd - paths : strlen(paths));
+
+			// We skip empty paths and those that would become too long.
+			if (pathLen == 0
+				|| pathLen + 1 + fileNameLen >= B_PATH_NAME_LENGTH) {
+				continue;
+			}
 
-	err = process_spawnattr(attrp);
-	if (err == 0)
-		err = process_file_actions(actions, &fds[1]);
-	if (err != 0)
-		goto fail_child;
+			char candidate[B_PATH_NAME_LENGTH];
+			memcpy(candidate, paths, pathLen);
+			candidate[pathLen] = '\0';
 
-	if (envpath)
-		execvpe(path, argv, envp != NULL ? envp : environ);
-	else
-		execve(path, argv, envp != NULL ? envp : environ);
+			if (candidate[pathLen - 1] != '/')
+				strcat(candidate, "/");
+			strcat(candidate, path);
 
-	err = errno;
+			struct stat st;
+			if (stat(candidate, &st) != 0 || !S_ISREG(st.st_mode))
+				continue;
 
-fail_child:
-	write(fds[1], &err, sizeof(err));
-	close(fds[1]);
-	_exit(127);
+			if (access(candidate, X_OK) == 0) {
+				err = do_spawn(_pid, candidate, argv, environment, fileActions,
+					fileActionCount, &attributes, true);
+				break;
+			}
+		}
+	}
 
-fail:
-	err = errno;
-	close(fds[0]);
-	close(fds[1]);
+	free(fileActions);
 	return err;
 }
 
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SIMD_STRING_H
+#define SIMD_STRING_H
+
+
+#include <stdint.h>
+
+#include <SupportDefs.h>
+
+#include "x86_64_string.h"
+
+
+/*!	The string functions, written against a vector type that provides its
+	size (kSize), Load() (aligned), LoadUnaligned(), Broadcast(), Equal(),
+	Or(), and Mask() (one bit per byte, like pmovmskb, kFullMask when all are
+	set). They are instantiated once for SSE2 and once for AVX2, in separate
+	files that are compiled for the respective instruction set.
+
+	Aligned loads never cross a page boundary, so they may read past the end
+	of a string, as long as they start before it. Unaligned loads are only
+	done when the whole vector is known to be accessible.
+*/
+
+
+namespace {
+
+
+static const size_t kPageSize = 4096;
+
+
+template<typename Vector>
+static inline bool
+crosses_page(const void* address)
+{
+	return ((uintptr_t)address & (kPageSize - 1))
+		> kPageSize - Vector::kSize;
+}
+
+
+template<typename Vector>
+static inline const char*
+align_down(const char* address)
+{
+	return (const char*)((uintptr_t)address & ~(uintptr_t)(Vector::kSize - 1));
+}
+
+
+template<typename Vector>
+static inline uint32_t
+zero_mask(typename Vector::Type value)
+{
+	return Vector::Mask(Vector::Equal(value, Vector::Broadcast(0)));
+}
+
+
+template<typename Vector>
+static size_t
+simd_strlen(const char* string)
+{
+	const char* block = align_down<Vector>(string);
+	uint32_t mask = zero_mask<Vector>(Vector::Load(block))
+		>> (string - block);
+	if (mask != 0)
+		return __builtin_ctz(mask);
+
+	block += Vector::kSize;
+	while (true) {
+		mask = zero_mask<Vector>(Vector::Load(block));
+		if (mask != 0)
+			return block - string + __builtin_ctz(mask);
+		block += Vector::kSize;
+	}
+}
+
+
+template<typename Vector>
+static size_t
+simd_strnlen(const char* string, size_t count)
+{
+	if (count == 0)
+		return 0;
+
+	const char* block = align_down<Vector>(string);
+	uint32_t mask = zero_mask<Vector>(Vector::Load(block))
+		>> (string - block);
+	if (mask != 0)
+		return min_c((size_t)__builtin_ctz(mask), count);
+
+	size_t length = block + Vector::kSize - string;
+	while (length < count) {
+		mask = zero_mask<Vector>(Vector::Load(string + length));
+		if (mask != 0)
+			return min_c(length + __builtin_ctz(mask), count);
+		length += Vector::kSize;
+	}
+
+	return count;
+}
+
+
+template<typename Vector>
+static void*
+simd_memchr(const void* buffer, int c, size_t count)
+{
+	if (count == 0)
+		return NULL;
+
+	const char* start = (const char*)buffer;
+	typename Vector::Type value = Vector::Broadcast((char)c);
+
+	const char* block = align_down<Vector>(start);
+	uint32_t mask = Vector::Mask(Vector::Equal(Vector::Load(block), value))
+		>> (start - block);
+	if (mask != 0) {
+		size_t index = __builtin_ctz(mask);
+		return index < count ? (void*)(start + index) : NULL;
+	}
+
+	size_t offset = block + Vector::kSize - start;
+	while (offset < count) {
+		mask = Vector::Mask(Vector::Equal(Vector::Load(start + offset),
+			value));
+		if (mask != 0) {
+			offset += __builtin_ctz(mask);
+			return offset < count ? (void*)(start + offset) : NULL;
+		}
+		offset += Vector::kSize;
+	}
+
+	return NULL;
+}
+
+
+/*!	Returns a pointer to the first occurrence of \a c, or to the terminating
+	null character, whatever comes first.
+*/
+template<typename Vector>
+static char*
+simd_strchrnul(const char* string, int c)
+{
+	typename Vector::Type value = Vector::Broadcast((char)c);
+	typename Vector::Type zero = Vector::Broadcast(0);
+
+	const char* block = align_down<Vector>(string);
+	typename Vector::Type data = Vector::Load(block);
+	uint32_t mask = Vector::Mask(Vector::Or(Vector::Equal(data, value),
+		Vector::Equal(data, zero))) >> (string - block);
+	if (mask != 0)
+		return (char*)string + __builtin_ctz(mask);
+
+	while (true) {
+		block += Vector::kSize;
+		data = Vector::Load(block);
+		mask = Vector::Mask(Vector::Or(Vector::Equal(data, value),
+			Vector::Equal(data, zero)));
+		if (mask != 0)
+			return (char*)block + __builtin_ctz(mask);
+	}
+}
+
+
+template<typename Vector>
+static char*
+simd_strchr(const char* string, int c)
+{
+	char* found = simd_strchrnul<Vector>(string, c);
+	return *found == (char)c ? found : NULL;
+}
+
+
+template<typename Vector>
+static char*
+simd_strrchr(const char* string, int c)
+{
+	typename Vector::Type value = Vector::Broadcast((char)c);
+	const char* last = NULL;
+
+	const char* block = align_down<Vector>(string);
+	size_t skip = string - block;
+	while (true) {
+		typename Vector::Type data = Vector::Load(block);
+		uint32_t zeros = zero_mask<Vector>(data) >> skip << skip;
+		uint32_t matches = Vector::Mask(Vector::Equal(data, value))
+			>> skip << skip;
+
+		if (zeros != 0) {
+			// ignore everything after the terminating null character
+			matches &= zeros ^ (zeros - 1);
+		}
+		if (matches != 0)
+			last = block + 31 - __builtin_clz(matches);
+		if (zeros != 0)
+			return (char*)last;
+
+		block += Vector::kSize;
+		skip = 0;
+	}
+}
+
+
+template<typename Vector>
+static int
+simd_memcmp(const void* _a, const void* _b, size_t count)
+{
+	const unsigned char* a = (const unsigned char*)_a;
+	const unsigned char* b = (const unsigned char*)_b;
+
+	if (count < Vector::kSize) {
+		if (count == 0)
+			return 0;
+		if (crosses_page<Vector>(a) || crosses_page<Vector>(b)) {
+			for (size_t i = 0; i < count; i++) {
+				if (a[i] != b[i])
+					return a[i] - b[i];
+			}
+			return 0;
+		}
+
+		uint32_t mask = ~Vector::Mask(Vector::Equal(Vector::LoadUnaligned(a),
+			Vector::LoadUnaligned(b))) & ((1u << count) - 1);
+		if (mask == 0)
+			return 0;
+		size_t index = __builtin_ctz(mask);
+		return a[index] - b[index];
+	}
+
+	size_t offset = 0;
+	while (true) {
+		if (offset + Vector::kSize > count) {
+			// compare the last vector, overlapping the previous one
+			offset = count - Vector::kSize;
+		}
+
+		uint32_t mask = Vector::Mask(Vector::Equal(
+			Vector::LoadUnaligned(a + offset),
+			Vector::LoadUnaligned(b + offset))) ^ Vector::kFullMask;
+		if (mask != 0) {
+			offset += __builtin_ctz(mask);
+			return a[offset] - b[offset];
+		}
+
+		offset += Vector::kSize;
+		if (offset >= count)
+			return 0;
+	}
+}
+
+
+template<typename Vector>
+static int
+simd_strcmp(const char* _a, const char* _b)
+{
+	const unsigned char* a = (const unsigned char*)_a;
+	const unsigned char* b = (const unsigned char*)_b;
+
+	size_t offset = 0;
+	while (true) {
+		if (crosses_page<Vector>(a + offset)
+			|| crosses_page<Vector>(b + offset)) {
+			// one of the strings might end on this page, go byte by byte
+			for (size_t end = offset + Vector::kSize; offset < end;
+					offset++) {
+				int difference = a[offset] - b[offset];
+				if (difference != 0 || a[offset] == '\0')
+					return difference;
+			}
+			continue;
+		}
+
+		typename Vector::Type data = Vector::LoadUnaligned(a + offset);
+		uint32_t mask = (Vector::Mask(Vector::Equal(data,
+				Vector::LoadUnaligned(b + offset))) ^ Vector::kFullMask)
+			| zero_mask<Vector>(data);
+		if (mask != 0) {
+			offset += __builtin_ctz(mask);
+			return a[offset] - b[offset];
+		}
+
+		offset += Vector::kSize;
+	}
+}
+
+
+}	// namespace
+
+
+#endif	// SIMD_STRING_H
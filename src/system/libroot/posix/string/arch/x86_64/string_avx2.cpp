@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <immintrin.h>
+
+#include "simd_string.h"
+
+
+namespace {
+
+
+struct AVX2Vector {
+	typedef __m256i Type;
+
+	static const size_t kSize = 32;
+	static const uint32_t kFullMask = 0xffffffff;
+
+	static inline Type Load(const void* address)
+	{
+		return _mm256_load_si256((const __m256i*)address);
+	}
+
+	static inline Type LoadUnaligned(const void* address)
+	{
+		return _mm256_loadu_si256((const __m256i*)address);
+	}
+
+	static inline Type Broadcast(char value)
+	{
+		return _mm256_set1_epi8(value);
+	}
+
+	static inline Type Equal(Type a, Type b)
+	{
+		return _mm256_cmpeq_epi8(a, b);
+	}
+
+	static inline Type Or(Type a, Type b)
+	{
+		return _mm256_or_si256(a, b);
+	}
+
+	static inline uint32_t Mask(Type value)
+	{
+		return (uint32_t)_mm256_movemask_epi8(value);
+	}
+};
+
+
+}	// namespace
+
+
+const x86_string_functions gX86AVX2StringFunctions = {
+	simd_strlen<AVX2Vector>,
+	simd_strnlen<AVX2Vector>,
+	simd_memchr<AVX2Vector>,
+	simd_strchr<AVX2Vector>,
+	simd_strchrnul<AVX2Vector>,
+	simd_strrchr<AVX2Vector>,
+	simd_memcmp<AVX2Vector>,
+	simd_strcmp<AVX2Vector>
+};
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <emmintrin.h>
+
+#include "simd_string.h"
+
+
+namespace {
+
+
+struct SSE2Vector {
+	typedef __m128i Type;
+
+	static const size_t kSize = 16;
+	static const uint32_t kFullMask = 0xffff;
+
+	static inline Type Load(const void* address)
+	{
+		return _mm_load_si128((const __m128i*)address);
+	}
+
+	static inline Type LoadUnaligned(const void* address)
+	{
+		return _mm_loadu_si128((const __m128i*)address);
+	}
+
+	static inline Type Broadcast(char value)
+	{
+		return _mm_set1_epi8(value);
+	}
+
+	static inline Type Equal(Type a, Type b)
+	{
+		return _mm_cmpeq_epi8(a, b);
+	}
+
+	static inline Type Or(Type a, Type b)
+	{
+		return _mm_or_si128(a, b);
+	}
+
+	static inline uint32_t Mask(Type value)
+	{
+		return (uint32_t)_mm_movemask_epi8(value);
+	}
+};
+
+
+}	// namespace
+
+
+const x86_string_functions gX86SSE2StringFunctions = {
+	simd_strlen<SSE2Vector>,
+	simd_strnlen<SSE2Vector>,
+	simd_memchr<SSE2Vector>,
+	simd_strchr<SSE2Vector>,
+	simd_strchrnul<SSE2Vector>,
+	simd_strrchr<SSE2Vector>,
+	simd_memcmp<SSE2Vector>,
+	simd_strcmp<SSE2Vector>
+};
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "x86_64_string.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include <commpage_defs.h>
+
+
+extern "C" const void* __gCommPageAddress;
+
+static const x86_string_functions* sStringFunctions;
+
+
+/*!	Chooses the implementation of the string functions, depending on the
+	extensions the kernel allows userland to use. Before libroot has been
+	initialized, the SSE2 versions are used, as they always work.
+*/
+static const x86_string_functions*
+select_string_functions()
+{
+	const uintptr_t* commPage = (const uintptr_t*)__gCommPageAddress;
+	if (commPage == NULL)
+		return &gX86SSE2StringFunctions;
+
+	const x86_string_functions* functions = &gX86SSE2StringFunctions;
+	uintptr_t featuresOffset = commPage[COMMPAGE_ENTRY_X86_CPU_FEATURES];
+	if (featuresOffset != 0) {
+		uint32_t features = *(const uint32_t*)((uintptr_t)commPage
+			+ featuresOffset);
+		if ((features & X86_CPU_FEATURE_AVX2) != 0)
+			functions = &gX86AVX2StringFunctions;
+	}
+
+	sStringFunctions = functions;
+	return functions;
+}
+
+
+static inline const x86_string_functions*
+string_functions()
+{
+	const x86_string_functions* functions = sStringFunctions;
+	if (__builtin_expect(functions == NULL, 0))
+		return select_string_functions();
+	return functions;
+}
+
+
+extern "C" size_t
+strlen(const char* string)
+{
+	return string_functions()->strlen(string);
+}
+
+
+extern "C" size_t
+strnlen(const char* string, size_t count)
+{
+	return string_functions()->strnlen(string, count);
+}
+
+
+extern "C" void*
+memchr(const void* buffer, int c, size_t count)
+{
+	return string_functions()->memchr(buffer, c, count);
+}
+
+
+extern "C" char*
+strchr(const char* string, int c)
+{
+	return string_functions()->strchr(string, c);
+}
+
+
+extern "C" char*
+index(const char* string, int c)
+{
+	return string_functions()->strchr(string, c);
+}
+
+
+extern "C" char*
+strchrnul(const char* string, int c)
+{
+	return string_functions()->strchrnul(string, c);
+}
+
+
+extern "C" char*
+strrchr(const char* string, int c)
+{
+	return string_functions()->strrchr(string, c);
+}
+
+
+extern "C" char*
+rindex(const char* string, int c)
+{
+	return string_functions()->strrchr(string, c);
+}
+
+
+extern "C" int
+memcmp(const void* a, const void* b, size_t count)
+{
+	return string_functions()->memcmp(a, b, count);
+}
+
+
+extern "C" int
+strcmp(const char* a, const char* b)
+{
+	return string_functions()->strcmp(a, b);
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef X86_64_STRING_H
+#define X86_64_STRING_H
+
+
+#include <stddef.h>
+
+
+struct x86_string_functions {
+	size_t	(*strlen)(const char* string);
+	size_t	(*strnlen)(const char* string, size_t count);
+	void*	(*memchr)(const void* buffer, int c, size_t count);
+	char*	(*strchr)(const char* string, int c);
+	char*	(*strchrnul)(const char* string, int c);
+	char*	(*strrchr)(const char* string, int c);
+	int		(*memcmp)(const void* a, const void* b, size_t count);
+	int		(*strcmp)(const char* a, const char* b);
+};
+
+
+extern const x86_string_functions gX86SSE2StringFunctions;
+extern const x86_string_functions gX86AVX2StringFunctions;
+
+
+#endif	// X86_64_STRING_H
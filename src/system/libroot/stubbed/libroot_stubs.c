@@ -15,11 +15,6 @@ int _ZN8BPrivate7Libroot14gLocaleBackendE;
 int _ZN8BPrivate7Libroot14gPosixLanginfoE;
 int _ZN8BPrivate7Libroot16gPosixLCTimeInfoE;
 int _ZN8BPrivate7Libroot16gPosixLocaleConvE;
-int _ZN8BPrivate9hoardHeap10_sizeTableE;
-int _ZN8BPrivate9hoardHeap10_thresholdE;
-int _ZN8BPrivate9hoardHeap14_numProcessorsE;
-int _ZN8BPrivate9hoardHeap15fMaxThreadHeapsE;
-int _ZN8BPrivate9hoardHeap18_numProcessorsMaskE;
 int __bss_start;
 int __ctype32_wctrans;
 int __ctype32_wctype;
@@ -317,40 +312,44 @@ void _ZN16DoublyLinkedListI15AtExitInfoBlock31DoublyLinkedListStandardGetLinkIS0
 void _ZN16DoublyLinkedListI15AtExitInfoBlock31DoublyLinkedListStandardGetLinkIS0_EED2Ev() {}
 void _ZN16SinglyLinkedListI10AtExitInfo31SinglyLinkedListStandardGetLinkIS0_EED1Ev() {}
 void _ZN16SinglyLinkedListI10AtExitInfo31SinglyLinkedListStandardGetLinkIS0_EED2Ev() {}
-void _ZN8BPrivate10hoardYieldEv() {}
-void _ZN8BPrivate10superblock14makeSuperblockEiPNS_11processHeapE() {}
-void _ZN8BPrivate10superblockC1EiiPNS_9hoardHeapE() {}
-void _ZN8BPrivate10superblockC2EiiPNS_9hoardHeapE() {}
-void _ZN8BPrivate10threadHeap6mallocEm() {}
-void _ZN8BPrivate10threadHeapC1Ev() {}
-void _ZN8BPrivate10threadHeapC2Ev() {}
-void _ZN8BPrivate11hoardUnlockER5mutex() {}
-void _ZN8BPrivate11hoardUnsbrkEPvl() {}
-void _ZN8BPrivate11processHeap4freeEPv() {}
-void _ZN8BPrivate11processHeap5statsEv() {}
-void _ZN8BPrivate11processHeapC1Ev() {}
-void _ZN8BPrivate11processHeapC2Ev() {}
+void _ZN8BPrivate11resize_hugeEPNS_14segment_headerEm() {}
+void _ZN8BPrivate12purge_neededEv() {}
 void _ZN8BPrivate13KMessageField10AddElementEPKvi() {}
 void _ZN8BPrivate13KMessageField11AddElementsEPKvii() {}
 void _ZN8BPrivate13KMessageField5SetToEPNS_8KMessageEi() {}
 void _ZN8BPrivate13KMessageField5UnsetEv() {}
 void _ZN8BPrivate13KMessageFieldC1Ev() {}
 void _ZN8BPrivate13KMessageFieldC2Ev() {}
-void _ZN8BPrivate13hoardLockInitER5mutexPKc() {}
+void _ZN8BPrivate13allocate_hugeEmmb() {}
+void _ZN8BPrivate13allocate_spanEjmh() {}
+void _ZN8BPrivate13heap_allocateEmmb() {}
+void _ZN8BPrivate13init_segmentsEv() {}
+void _ZN8BPrivate13lock_segmentsEv() {}
+void _ZN8BPrivate14purge_segmentsEv() {}
 void _ZN8BPrivate15get_launch_dataEPKcRNS_8KMessageE() {}
+void _ZN8BPrivate15heap_reallocateEPvm() {}
+void _ZN8BPrivate15unlock_segmentsEv() {}
 void _ZN8BPrivate15user_group_lockEv() {}
+void _ZN8BPrivate16heap_before_forkEv() {}
+void _ZN8BPrivate16heap_object_sizeEPv() {}
+void _ZN8BPrivate16heap_thread_exitEv() {}
 void _ZN8BPrivate16parse_group_lineEPcRS0_S1_RjPS0_Ri() {}
+void _ZN8BPrivate17get_segment_statsERmS0_S0_S0_() {}
+void _ZN8BPrivate17init_thread_heapsEv() {}
 void _ZN8BPrivate17parse_passwd_lineEPcRS0_S1_RjS2_S1_S1_S1_() {}
 void _ZN8BPrivate17user_group_unlockEv() {}
 void _ZN8BPrivate20copy_group_to_bufferEPK5groupPS0_Pcm() {}
 void _ZN8BPrivate20copy_group_to_bufferEPKcS1_jPKS1_iP5groupPcm() {}
 void _ZN8BPrivate21copy_passwd_to_bufferEPK6passwdPS0_Pcm() {}
 void _ZN8BPrivate21copy_passwd_to_bufferEPKcS1_jjS1_S1_S1_P6passwdPcm() {}
+void _ZN8BPrivate21heap_after_fork_childEv() {}
 void _ZN8BPrivate21parse_shadow_pwd_lineEPcRS0_S1_RiS2_S2_S2_S2_S2_S2_() {}
 void _ZN8BPrivate22get_extended_team_infoEijRNS_8KMessageE() {}
 void _ZN8BPrivate22get_launch_daemon_portEv() {}
+void _ZN8BPrivate22heap_after_fork_parentEv() {}
 void _ZN8BPrivate25copy_shadow_pwd_to_bufferEPK4spwdPS0_Pcm() {}
 void _ZN8BPrivate25copy_shadow_pwd_to_bufferEPKcS1_iiiiiiiP4spwdPcm() {}
+void _ZN8BPrivate26reinit_segments_after_forkEv() {}
 void _ZN8BPrivate29send_request_to_launch_daemonERNS_8KMessageES1_() {}
 void _ZN8BPrivate33get_registrar_authentication_portEv() {}
 void _ZN8BPrivate33set_registrar_authentication_portEi() {}
@@ -420,17 +419,9 @@ void _ZN8BPrivate8KMessageC2Ej() {}
 void _ZN8BPrivate8KMessageC2Ev() {}
 void _ZN8BPrivate8KMessageD1Ev() {}
 void _ZN8BPrivate8KMessageD2Ev() {}
-void _ZN8BPrivate9hoardHeap12initNumProcsEv() {}
-void _ZN8BPrivate9hoardHeap14moveSuperblockEPNS_10superblockEiii() {}
-void _ZN8BPrivate9hoardHeap16insertSuperblockEiPNS_10superblockEPNS_11processHeapE() {}
-void _ZN8BPrivate9hoardHeap16removeSuperblockEPNS_10superblockEi() {}
-void _ZN8BPrivate9hoardHeap19removeMaxSuperblockEi() {}
-void _ZN8BPrivate9hoardHeap5reuseEi() {}
-void _ZN8BPrivate9hoardHeap9freeBlockERPNS_5blockERPNS_10superblockEiPNS_11processHeapE() {}
-void _ZN8BPrivate9hoardHeapC1Ev() {}
-void _ZN8BPrivate9hoardHeapC2Ev() {}
-void _ZN8BPrivate9hoardLockER5mutex() {}
-void _ZN8BPrivate9hoardSbrkEl() {}
+void _ZN8BPrivate9free_hugeEPNS_14segment_headerE() {}
+void _ZN8BPrivate9free_spanEPNS_9heap_spanE() {}
+void _ZN8BPrivate9heap_freeEPv() {}
 void _ZN8DateMask10IsCompleteEv() {}
 void _ZN8DateMask7HasTimeEv() {}
 void _ZN9__gnu_cxx20recursive_init_errorD0Ev() {}
@@ -849,6 +840,7 @@ void __heap_after_fork_child() {}
 void __heap_after_fork_parent() {}
 void __heap_before_fork() {}
 void __heap_terminate_after() {}
+void __heap_thread_exit() {}
 void __hypot() {}
 void __hypotf() {}
 void __hypotl() {}
@@ -1388,6 +1380,9 @@ void _kern_dup() {}
 void _kern_dup2() {}
 void _kern_entry_ref_to_path() {}
 void _kern_estimate_max_scheduling_latency() {}
+void _kern_event_queue_control() {}
+void _kern_event_queue_create() {}
+void _kern_event_queue_wait() {}
 void _kern_exec() {}
 void _kern_exit_team() {}
 void _kern_exit_thread() {}
@@ -1467,6 +1462,7 @@ void _kern_memory_advice() {}
 void _kern_mount() {}
 void _kern_move_partition() {}
 void _kern_mutex_lock() {}
+void _kern_mutex_requeue() {}
 void _kern_mutex_sem_acquire() {}
 void _kern_mutex_sem_release() {}
 void _kern_mutex_switch_lock() {}
@@ -1571,6 +1567,7 @@ void _kern_snooze_etc() {}
 void _kern_sockatmark() {}
 void _kern_socket() {}
 void _kern_socketpair() {}
+void _kern_spawn() {}
 void _kern_spawn_thread() {}
 void _kern_start_watching() {}
 void _kern_start_watching_disks() {}
@@ -394,14 +394,10 @@ void __17__class_type_infoPCcPCQ217__class_type_info9base_infoUl() {}
 void __8bad_cast() {}
 void __9exception() {}
 void __9type_infoPCc() {}
-void __Q28BPrivate10superblockiiPQ28BPrivate9hoardHeap() {}
-void __Q28BPrivate10threadHeap() {}
-void __Q28BPrivate11processHeap() {}
 void __Q28BPrivate13KMessageField() {}
 void __Q28BPrivate6SHA256() {}
 void __Q28BPrivate8KMessage() {}
 void __Q28BPrivate8KMessageUl() {}
-void __Q28BPrivate9hoardHeap() {}
 void __Q38BPrivate7Libroot13LocaleBackend() {}
 void __Q38BPrivate7Libroot16LocaleDataBridge() {}
 void __Q38BPrivate7Libroot20LocaleTimeDataBridge() {}
@@ -704,6 +700,7 @@ void __heap_after_fork_child() {}
 void __heap_after_fork_parent() {}
 void __heap_before_fork() {}
 void __heap_terminate_after() {}
+void __heap_thread_exit() {}
 void __hypot() {}
 void __hypotf() {}
 void __hypotl() {}
@@ -1299,6 +1296,9 @@ void _kern_dup() {}
 void _kern_dup2() {}
 void _kern_entry_ref_to_path() {}
 void _kern_estimate_max_scheduling_latency() {}
+void _kern_event_queue_control() {}
+void _kern_event_queue_create() {}
+void _kern_event_queue_wait() {}
 void _kern_exec() {}
 void _kern_exit_team() {}
 void _kern_exit_thread() {}
@@ -1378,6 +1378,7 @@ void _kern_memory_advice() {}
 void _kern_mount() {}
 void _kern_move_partition() {}
 void _kern_mutex_lock() {}
+void _kern_mutex_requeue() {}
 void _kern_mutex_sem_acquire() {}
 void _kern_mutex_sem_release() {}
 void _kern_mutex_switch_lock() {}
@@ -1482,6 +1483,7 @@ void _kern_snooze_etc() {}
 void _kern_sockatmark() {}
 void _kern_socket() {}
 void _kern_socketpair() {}
+void _kern_spawn() {}
 void _kern_spawn_thread() {}
 void _kern_start_watching() {}
 void _kern_start_watching_disks() {}
@@ -1601,7 +1603,8 @@ void acosl() {}
 void acquire_sem() {}
 void acquire_sem_etc() {}
 void alarm() {}
-void align__Q28BPrivate9hoardHeapUl() {}
+void allocate_huge__8BPrivateUlUlb() {}
+void allocate_span__8BPrivateUlUlUc() {}
 void alphasort() {}
 void area_for() {}
 void asctime() {}
@@ -1728,7 +1731,6 @@ void closedir() {}
 void closelog() {}
 void closelog_team() {}
 void closelog_thread() {}
-void computeFullness__Q28BPrivate10superblock() {}
 void confstr() {}
 void conj() {}
 void conjf() {}
@@ -1949,8 +1951,8 @@ void fputws_unlocked() {}
 void fread() {}
 void fread_unlocked() {}
 void free() {}
-void freeBlock__Q28BPrivate9hoardHeapRPQ28BPrivate5blockRPQ28BPrivate10superblockiPQ28BPrivate11processHeap() {}
-void free__Q28BPrivate11processHeapPv() {}
+void free_huge__8BPrivatePQ28BPrivate14segment_header() {}
+void free_span__8BPrivatePQ28BPrivate9heap_span() {}
 void freopen() {}
 void frexp() {}
 void frexpf() {}
@@ -2015,8 +2017,6 @@ void gamma() {}
 void gammaf() {}
 void gammal() {}
 void gcvt() {}
-void getNumAvailable__Q28BPrivate10superblock() {}
-void getNumBlocks__Q28BPrivate10superblock() {}
 void get_architecture() {}
 void get_architectures() {}
 void get_cpu_info() {}
@@ -2043,6 +2043,7 @@ void get_pthread_thread_id() {}
 void get_registrar_authentication_port__8BPrivatev() {}
 void get_scheduler_mode() {}
 void get_secondary_architectures() {}
+void get_segment_stats__8BPrivateRUlN31() {}
 void get_sem_count() {}
 void get_stack_frame() {}
 void get_system_info() {}
@@ -2110,13 +2111,15 @@ void hcreate() {}
 void hcreate_r() {}
 void hdestroy() {}
 void hdestroy_r() {}
+void heap_after_fork_child__8BPrivatev() {}
+void heap_after_fork_parent__8BPrivatev() {}
+void heap_allocate__8BPrivateUlUlb() {}
+void heap_before_fork__8BPrivatev() {}
+void heap_free__8BPrivatePv() {}
+void heap_object_size__8BPrivatePv() {}
+void heap_reallocate__8BPrivatePvUl() {}
+void heap_thread_exit__8BPrivatev() {}
 void heapsort() {}
-void hoardLockInit__8BPrivateR5mutexPCc() {}
-void hoardLock__8BPrivateR5mutex() {}
-void hoardSbrk__8BPrivatel() {}
-void hoardUnlock__8BPrivateR5mutex() {}
-void hoardUnsbrk__8BPrivatePvl() {}
-void hoardYield__8BPrivatev() {}
 void hsearch() {}
 void hsearch_r() {}
 void hypot() {}
@@ -2128,19 +2131,18 @@ void ilogbl() {}
 void imaxabs() {}
 void imaxdiv() {}
 void index() {}
-void initNumProcs__Q28BPrivate9hoardHeap() {}
 void init_des() {}
+void init_segments__8BPrivatev() {}
+void init_thread_heaps__8BPrivatev() {}
 void initgroups() {}
 void initialize_before() {}
 void initstate() {}
 void initstate_r() {}
-void insertSuperblock__Q28BPrivate9hoardHeapiPQ28BPrivate10superblockPQ28BPrivate11processHeap() {}
 void insque() {}
 void install_default_debugger() {}
 void install_team_debugger() {}
 void internal_path_for_path__FPcUlPCcT219path_base_directoryT2UlT0Ul() {}
 void ioctl() {}
-void isValid__Q28BPrivate10superblock() {}
 void is_computer_on() {}
 void is_computer_on_fire() {}
 void isalnum() {}
@@ -2224,6 +2226,7 @@ void load_image() {}
 void localeconv() {}
 void localtime() {}
 void localtime_r() {}
+void lock_segments__8BPrivatev() {}
 void lockf() {}
 void log() {}
 void log10() {}
@@ -2253,9 +2256,7 @@ void lroundf() {}
 void lroundl() {}
 void lsearch() {}
 void lseek() {}
-void makeSuperblock__Q28BPrivate10superblockiPQ28BPrivate11processHeap() {}
 void malloc() {}
-void malloc__Q28BPrivate10threadHeapUl() {}
 void malloc_usable_size() {}
 void matherr() {}
 void mblen() {}
@@ -2290,7 +2291,6 @@ void modf() {}
 void modff() {}
 void modfl() {}
 void mount() {}
-void moveSuperblock__Q28BPrivate9hoardHeapPQ28BPrivate10superblockiii() {}
 void mprotect() {}
 void mrand48() {}
 void mrand48_r() {}
@@ -2468,6 +2468,8 @@ void pthread_spin_trylock() {}
 void pthread_spin_unlock() {}
 void pthread_testcancel() {}
 void ptsname() {}
+void purge_needed__8BPrivatev() {}
+void purge_segments__8BPrivatev() {}
 void putc() {}
 void putc_unlocked() {}
 void putchar() {}
@@ -2517,14 +2519,13 @@ void regerror() {}
 void regexec() {}
 void regfree() {}
 void register_printf_function() {}
+void reinit_segments_after_fork__8BPrivatev() {}
 void release_sem() {}
 void release_sem_etc() {}
 void remainder() {}
 void remainderf() {}
 void remainderl() {}
 void remove() {}
-void removeMaxSuperblock__Q28BPrivate9hoardHeapi() {}
-void removeSuperblock__Q28BPrivate9hoardHeapPQ28BPrivate10superblocki() {}
 void remove_team_debugger() {}
 void remque() {}
 void remquo() {}
@@ -2534,8 +2535,8 @@ void rename() {}
 void rename_thread() {}
 void renameat() {}
 void resize_area() {}
+void resize_huge__8BPrivatePQ28BPrivate14segment_headerUl() {}
 void resume_thread() {}
-void reuse__Q28BPrivate9hoardHeapi() {}
 void rewind() {}
 void rewinddir() {}
 void rindex() {}
@@ -2667,7 +2668,6 @@ void srand48_r() {}
 void srandom() {}
 void srandom_r() {}
 void sscanf() {}
-void stats__Q28BPrivate11processHeap() {}
 void statvfs() {}
 void stime() {}
 void stpcpy() {}
@@ -2794,6 +2794,7 @@ void unlink() {}
 void unlinkat() {}
 void unload_add_on() {}
 void unload_driver_settings() {}
+void unlock_segments__8BPrivatev() {}
 void unlockpt() {}
 void unmount() {}
 void unsetenv() {}
@@ -195,10 +195,39 @@ load_dependencies(image_t* image)
 }
 
 
+/*!	Returns whether the symbol lookup statistics should be printed, as
+	requested by "LD_DEBUG=statistics".
+*/
+static bool
+symbol_lookup_statistics_enabled()
+{
+	const char* debug = getenv("LD_DEBUG");
+	return debug != NULL && strstr(debug, "statistics") != NULL;
+}
+
+
+static void
+print_symbol_lookup_statistics(image_t* image, ssize_t imageCount)
+{
+	SymbolLookupStatistics& statistics = gSymbolLookupStatistics;
+
+	printf("runtime_loader: relocated %" B_PRIdSSIZE " images for %s in %"
+		B_PRIdBIGTIME " us\n", imageCount, image->name,
+		statistics.relocation_time);
+	printf("runtime_loader:   %" B_PRIu32 " symbol lookups, %" B_PRIu32
+		" of them cached\n", statistics.lookups, statistics.cached_lookups);
+	printf("runtime_loader:   %" B_PRIu32 " images searched, %" B_PRIu32
+		" rejected by bloom filters, %" B_PRIu32 " symbol names compared\n",
+		statistics.images_searched, statistics.bloom_filter_rejects,
+		statistics.symbols_compared);
+}
+
+
 static status_t
-relocate_image(image_t *rootImage, image_t *image)
+relocate_image(image_t *rootImage, image_t *image,
+	SymbolResolutionCache* resolutionCache)
 {
-	SymbolLookupCache cache(image);
+	SymbolLookupCache cache(image, resolutionCache);
 
 	status_t status = arch_relocate_image(rootImage, image, &cache);
 	if (status < B_OK) {
@@ -221,9 +250,17 @@ relocate_dependencies(image_t *image)
 	if (count < B_OK)
 		return count;
 
+	bool printStatistics = symbol_lookup_statistics_enabled();
+	bigtime_t startTime = 0;
+	if (printStatistics) {
+		memset(&gSymbolLookupStatistics, 0, sizeof(gSymbolLookupStatistics));
+		startTime = _kern_system_time();
+	}
+
 	// relocate
+	SymbolResolutionCache resolutionCache;
 	for (ssize_t i = 0; i < count; i++) {
-		status_t status = relocate_image(image, list[i]);
+		status_t status = relocate_image(image, list[i], &resolutionCache);
 		if (status < B_OK) {
 			free(list);
 			return status;
@@ -231,6 +268,13 @@ relocate_dependencies(image_t *image)
 	}
 
 	free(list);
+
+	if (printStatistics) {
+		gSymbolLookupStatistics.relocation_time
+			= _kern_system_time() - startTime;
+		print_symbol_lookup_statistics(image, count);
+	}
+
 	return B_OK;
 }
 
@@ -250,6 +250,7 @@ parse_dynamic_segment(image_t* image)
 	int sonameOffset = -1;
 
 	image->symhash = 0;
+	image->gnu_hash = NULL;
 	image->syms = 0;
 	image->strtab = 0;
 
@@ -266,6 +267,20 @@ parse_dynamic_segment(image_t* image)
 				image->symhash
 					= (uint32*)(d[i].d_un.d_ptr + image->regions[0].delta);
 				break;
+			case DT_GNU_HASH:
+			{
+				uint32* table
+					= (uint32*)(d[i].d_un.d_ptr + image->regions[0].delta);
+
+				// we need at least one bucket, and a power of two of bloom
+				// filter words
+				uint32 bloomSize = table[2];
+				if (table[0] > 0 && bloomSize > 0
+					&& (bloomSize & (bloomSize - 1)) == 0) {
+					image->gnu_hash = table;
+				}
+				break;
+			}
 			case DT_STRTAB:
 				image->strtab
 					= (char*)(d[i].d_un.d_ptr + image->regions[0].delta);
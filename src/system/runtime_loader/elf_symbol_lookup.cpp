@@ -41,6 +41,9 @@ equals_image_name(image_t* image, const char* name)
 }
 
 
+SymbolLookupStatistics gSymbolLookupStatistics;
+
+
 // #pragma mark -
 
 
@@ -63,6 +66,19 @@ elf_hash(const char* _name)
 }
 
 
+uint32
+elf_gnu_hash(const char* _name)
+{
+	const uint8* name = (const uint8*)_name;
+
+	uint32 hash = 5381;
+	while (*name)
+		hash = hash * 33 + *name++;
+
+	return hash;
+}
+
+
 void
 patch_defined_symbol(image_t* image, const char* name, void** symbol,
 	int32* type)
@@ -104,120 +120,232 @@ is_symbol_visible(elf_sym* symbol)
 }
 
 
-elf_sym*
-find_symbol(image_t* image, const SymbolLookupInfo& lookupInfo, bool allowLocal)
+/*!	Checks whether the symbol at \a index, that has the name looked up,
+	fulfills the other requirements of the lookup.
+	Returns \c true, if the search of the image is over, then \a _symbol is
+	set to the symbol found, or to \c NULL, if the image must not be used.
+	Otherwise the symbol is skipped, or remembered in \a versionedSymbol, if
+	it is one of the versions that is only good if there is no other one.
+*/
+static bool
+check_symbol(image_t* image, const SymbolLookupInfo& lookupInfo, uint32 index,
+	bool allowLocal, elf_sym*& _symbol, elf_sym*& versionedSymbol,
+	uint32& versionedSymbolCount)
 {
-	if (image->dynamic_ptr == 0)
-		return NULL;
+	elf_sym* symbol = &image->syms[index];
+	if (symbol->st_shndx == SHN_UNDEF
+		|| (!allowLocal && !is_symbol_visible(symbol))) {
+		return false;
+	}
 
-	elf_sym* versionedSymbol = NULL;
-	uint32 versionedSymbolCount = 0;
+	// check if the type matches
+	uint32 type = symbol->Type();
+	if ((lookupInfo.type == B_SYMBOL_TYPE_TEXT && type != STT_FUNC)
+		|| (lookupInfo.type == B_SYMBOL_TYPE_DATA
+			&& type != STT_OBJECT)) {
+		return false;
+	}
 
-	uint32 bucket = lookupInfo.hash % HASHTABSIZE(image);
+	// check the version
 
-	for (uint32 i = HASHBUCKETS(image)[bucket]; i != STN_UNDEF;
-			i = HASHCHAINS(image)[i]) {
-		elf_sym* symbol = &image->syms[i];
+	// Handle the simple cases -- the image doesn't have version
+	// information -- first.
+	if (image->symbol_versions == NULL) {
+		if (lookupInfo.version == NULL) {
+			// No specific symbol version was requested either, so the
+			// symbol is just fine.
+			_symbol = symbol;
+			return true;
+		}
 
-		if (symbol->st_shndx != SHN_UNDEF
-			&& (allowLocal || is_symbol_visible(symbol))
-			&& !strcmp(SYMNAME(image, symbol), lookupInfo.name)) {
-
-			// check if the type matches
-			uint32 type = symbol->Type();
-			if ((lookupInfo.type == B_SYMBOL_TYPE_TEXT && type != STT_FUNC)
-				|| (lookupInfo.type == B_SYMBOL_TYPE_DATA
-					&& type != STT_OBJECT)) {
-				continue;
-			}
+		// A specific version is requested. If it's the dependency
+		// referred to by the requested version, it's apparently an
+		// older version of the dependency and we're not happy.
+		if (equals_image_name(image, lookupInfo.version->file_name)) {
+			// TODO: That should actually be kind of fatal!
+			_symbol = NULL;
+			return true;
+		}
 
-			// check the version
+		// This is some other image. We accept the symbol.
+		_symbol = symbol;
+		return true;
+	}
 
-			// Handle the simple cases -- the image doesn't have version
-			// information -- first.
-			if (image->symbol_versions == NULL) {
-				if (lookupInfo.version == NULL) {
-					// No specific symbol version was requested either, so the
-					// symbol is just fine.
-					return symbol;
-				}
+	// The image has version information. Let's see what we've got.
+	uint32 versionID = image->symbol_versions[index];
+	uint32 versionIndex = VER_NDX(versionID);
+	elf_version_info& version = image->versions[versionIndex];
 
-				// A specific version is requested. If it's the dependency
-				// referred to by the requested version, it's apparently an
-				// older version of the dependency and we're not happy.
-				if (equals_image_name(image, lookupInfo.version->file_name)) {
-					// TODO: That should actually be kind of fatal!
-					return NULL;
-				}
+	// skip local versions
+	if (versionIndex == VER_NDX_LOCAL)
+		return false;
 
-				// This is some other image. We accept the symbol.
-				return symbol;
-			}
+	if (lookupInfo.version != NULL) {
+		// a specific version is requested
 
-			// The image has version information. Let's see what we've got.
-			uint32 versionID = image->symbol_versions[i];
-			uint32 versionIndex = VER_NDX(versionID);
-			elf_version_info& version = image->versions[versionIndex];
+		// compare the versions
+		if (version.hash == lookupInfo.version->hash
+			&& strcmp(version.name, lookupInfo.version->name) == 0) {
+			// versions match
+			_symbol = symbol;
+			return true;
+		}
 
-			// skip local versions
-			if (versionIndex == VER_NDX_LOCAL)
-				continue;
+		// The versions don't match. We're still fine with the
+		// base version, if it is public and we're not looking for
+		// the default version.
+		if ((versionID & VER_NDX_FLAG_HIDDEN) == 0
+			&& versionIndex == VER_NDX_GLOBAL
+			&& (lookupInfo.flags & LOOKUP_FLAG_DEFAULT_VERSION)
+				== 0) {
+			// TODO: Revise the default version case! That's how
+			// FreeBSD implements it, but glibc doesn't handle it
+			// specially.
+			_symbol = symbol;
+			return true;
+		}
+	} else {
+		// No specific version requested, but the image has version
+		// information. This can happen in either of these cases:
+		//
+		// * The dependent object was linked against an older version
+		//   of the now versioned dependency.
+		// * The symbol is looked up via find_image_symbol() or dlsym().
+		//
+		// In the first case we return the base version of the symbol
+		// (VER_NDX_GLOBAL or VER_NDX_INITIAL), or, if that doesn't
+		// exist, the unique, non-hidden versioned symbol.
+		//
+		// In the second case we want to return the public default
+		// version of the symbol. The handling is pretty similar to the
+		// first case, with the exception that we treat VER_NDX_INITIAL
+		// as regular version.
+
+		// VER_NDX_GLOBAL is always good, VER_NDX_INITIAL is fine, if
+		// we don't look for the default version.
+		if (versionIndex == VER_NDX_GLOBAL
+			|| ((lookupInfo.flags & LOOKUP_FLAG_DEFAULT_VERSION) == 0
+				&& versionIndex == VER_NDX_INITIAL)) {
+			_symbol = symbol;
+			return true;
+		}
 
-			if (lookupInfo.version != NULL) {
-				// a specific version is requested
+		// If not hidden, remember the version -- we'll return it, if
+		// it is the only one.
+		if ((versionID & VER_NDX_FLAG_HIDDEN) == 0) {
+			versionedSymbolCount++;
+			versionedSymbol = symbol;
+		}
+	}
 
-				// compare the versions
-				if (version.hash == lookupInfo.version->hash
-					&& strcmp(version.name, lookupInfo.version->name) == 0) {
-					// versions match
-					return symbol;
-				}
+	return false;
+}
 
-				// The versions don't match. We're still fine with the
-				// base version, if it is public and we're not looking for
-				// the default version.
-				if ((versionID & VER_NDX_FLAG_HIDDEN) == 0
-					&& versionIndex == VER_NDX_GLOBAL
-					&& (lookupInfo.flags & LOOKUP_FLAG_DEFAULT_VERSION)
-						== 0) {
-					// TODO: Revise the default version case! That's how
-					// FreeBSD implements it, but glibc doesn't handle it
-					// specially.
-					return symbol;
-				}
-			} else {
-				// No specific version requested, but the image has version
-				// information. This can happen in either of these cases:
-				//
-				// * The dependent object was linked against an older version
-				//   of the now versioned dependency.
-				// * The symbol is looked up via find_image_symbol() or dlsym().
-				//
-				// In the first case we return the base version of the symbol
-				// (VER_NDX_GLOBAL or VER_NDX_INITIAL), or, if that doesn't
-				// exist, the unique, non-hidden versioned symbol.
-				//
-				// In the second case we want to return the public default
-				// version of the symbol. The handling is pretty similar to the
-				// first case, with the exception that we treat VER_NDX_INITIAL
-				// as regular version.
-
-				// VER_NDX_GLOBAL is always good, VER_NDX_INITIAL is fine, if
-				// we don't look for the default version.
-				if (versionIndex == VER_NDX_GLOBAL
-					|| ((lookupInfo.flags & LOOKUP_FLAG_DEFAULT_VERSION) == 0
-						&& versionIndex == VER_NDX_INITIAL)) {
-					return symbol;
-				}
 
-				// If not hidden, remember the version -- we'll return it, if
-				// it is the only one.
-				if ((versionID & VER_NDX_FLAG_HIDDEN) == 0) {
-					versionedSymbolCount++;
-					versionedSymbol = symbol;
-				}
+/*!	Looks up the symbol via the image's DT_GNU_HASH table, which only
+	contains the symbols the image defines and exports.
+	Returns \c false, if there are too many symbols of that name to check
+	them in the right order; the SysV hash table has to be used then.
+*/
+static bool
+find_gnu_hash_symbol(image_t* image, const SymbolLookupInfo& lookupInfo,
+	elf_sym*& _symbol)
+{
+	_symbol = NULL;
+
+	const uint32* table = image->gnu_hash;
+	uint32 bucketCount = table[0];
+	uint32 symbolOffset = table[1];
+	uint32 bloomSize = table[2];
+	uint32 bloomShift = table[3];
+	const addr_t* bloom = (const addr_t*)(table + 4);
+	const uint32* buckets = (const uint32*)(bloom + bloomSize);
+	const uint32* chains = buckets + bucketCount - symbolOffset;
+
+	// Most images don't have the symbol, and the bloom filter knows that
+	// without looking at the hash table.
+	const uint32 kBloomBits = sizeof(addr_t) * 8;
+	uint32 hash = lookupInfo.gnu_hash;
+	addr_t word = bloom[(hash / kBloomBits) & (bloomSize - 1)];
+	if (((word >> (hash % kBloomBits))
+			& (word >> ((hash >> bloomShift) % kBloomBits)) & 1) == 0) {
+		gSymbolLookupStatistics.bloom_filter_rejects++;
+		return true;
+	}
+
+	uint32 index = buckets[hash % bucketCount];
+	if (index < symbolOffset)
+		return true;
+
+	// The SysV hash chains run from the highest symbol index down, and the
+	// symbol we find may depend on the order we check them in. The chains
+	// of the GNU hash table are sorted the other way around, so we collect
+	// the symbols of that name, and check them backwards.
+	uint32 matches[8];
+	uint32 matchCount = 0;
+	while (true) {
+		uint32 chainHash = chains[index];
+		if ((chainHash | 1) == (hash | 1)) {
+			gSymbolLookupStatistics.symbols_compared++;
+			if (strcmp(SYMNAME(image, &image->syms[index]), lookupInfo.name)
+					== 0) {
+				if (matchCount == B_COUNT_OF(matches))
+					return false;
+				matches[matchCount++] = index;
 			}
 		}
+
+		if ((chainHash & 1) != 0)
+			break;
+		index++;
+	}
+
+	elf_sym* versionedSymbol = NULL;
+	uint32 versionedSymbolCount = 0;
+
+	while (matchCount > 0) {
+		if (check_symbol(image, lookupInfo, matches[--matchCount], false,
+				_symbol, versionedSymbol, versionedSymbolCount)) {
+			return true;
+		}
+	}
+
+	if (versionedSymbolCount == 1)
+		_symbol = versionedSymbol;
+	return true;
+}
+
+
+elf_sym*
+find_symbol(image_t* image, const SymbolLookupInfo& lookupInfo, bool allowLocal)
+{
+	if (image->dynamic_ptr == 0)
+		return NULL;
+
+	gSymbolLookupStatistics.images_searched++;
+
+	elf_sym* symbol;
+	if (image->gnu_hash != NULL && !allowLocal
+		&& find_gnu_hash_symbol(image, lookupInfo, symbol)) {
+		return symbol;
+	}
+
+	elf_sym* versionedSymbol = NULL;
+	uint32 versionedSymbolCount = 0;
+
+	uint32 bucket = lookupInfo.hash % HASHTABSIZE(image);
+
+	for (uint32 i = HASHBUCKETS(image)[bucket]; i != STN_UNDEF;
+			i = HASHCHAINS(image)[i]) {
+		gSymbolLookupStatistics.symbols_compared++;
+		if (strcmp(SYMNAME(image, &image->syms[i]), lookupInfo.name) != 0)
+			continue;
+
+		if (check_symbol(image, lookupInfo, i, allowLocal, symbol,
+				versionedSymbol, versionedSymbolCount)) {
+			return symbol;
+		}
 	}
 
 	return versionedSymbolCount == 1 ? versionedSymbol : NULL;
@@ -482,6 +610,146 @@ find_undefined_symbol_add_on(image_t* rootImage, image_t* image,
 }
 
 
+// #pragma mark - SymbolResolutionCache
+
+
+struct SymbolResolutionCache::Entry {
+	const char*				name;
+		// NULL, if the entry is unused
+	const elf_version_info*	version;
+	uint32					hash;
+	int32					type;
+	elf_sym*				symbol;
+	image_t*				image;
+};
+
+
+static bool
+equals_version(const elf_version_info* a, const elf_version_info* b)
+{
+	if (a == b)
+		return true;
+	if (a == NULL || b == NULL || a->hash != b->hash
+		|| strcmp(a->name, b->name) != 0) {
+		return false;
+	}
+
+	// the file name decides whether images without versions are used
+	if (a->file_name == NULL || b->file_name == NULL)
+		return a->file_name == b->file_name;
+	return strcmp(a->file_name, b->file_name) == 0;
+}
+
+
+SymbolResolutionCache::SymbolResolutionCache()
+	:
+	fEntries(NULL),
+	fSize(0),
+	fCount(0)
+{
+}
+
+
+SymbolResolutionCache::~SymbolResolutionCache()
+{
+	free(fEntries);
+}
+
+
+bool
+SymbolResolutionCache::Lookup(const SymbolLookupInfo& lookupInfo,
+	elf_sym** _symbol, image_t** _image)
+{
+	Entry* entry = _Find(lookupInfo);
+	if (entry == NULL || entry->name == NULL)
+		return false;
+
+	*_symbol = entry->symbol;
+	*_image = entry->image;
+	return true;
+}
+
+
+void
+SymbolResolutionCache::Add(const SymbolLookupInfo& lookupInfo,
+	elf_sym* symbol, image_t* image)
+{
+	// keep the table at most three quarters full
+	if ((fCount + 1) * 4 > fSize * 3 && !_Resize())
+		return;
+
+	Entry* entry = _Find(lookupInfo);
+	if (entry->name == NULL)
+		fCount++;
+
+	entry->name = lookupInfo.name;
+	entry->version = lookupInfo.version;
+	entry->hash = lookupInfo.gnu_hash;
+	entry->type = lookupInfo.type;
+	entry->symbol = symbol;
+	entry->image = symbol != NULL ? image : NULL;
+}
+
+
+bool
+SymbolResolutionCache::_Resize()
+{
+	uint32 newSize = fSize != 0 ? fSize * 2 : 1024;
+	Entry* entries = (Entry*)malloc(newSize * sizeof(Entry));
+	if (entries == NULL)
+		return false;
+
+	memset(entries, 0, newSize * sizeof(Entry));
+
+	Entry* oldEntries = fEntries;
+	uint32 oldSize = fSize;
+	fEntries = entries;
+	fSize = newSize;
+
+	for (uint32 i = 0; i < oldSize; i++) {
+		Entry& oldEntry = oldEntries[i];
+		if (oldEntry.name == NULL)
+			continue;
+
+		uint32 index = oldEntry.hash & (fSize - 1);
+		while (fEntries[index].name != NULL)
+			index = (index + 1) & (fSize - 1);
+		fEntries[index] = oldEntry;
+	}
+
+	free(oldEntries);
+	return true;
+}
+
+
+/*!	Returns the entry for the lookup, or the unused one it would go to. */
+SymbolResolutionCache::Entry*
+SymbolResolutionCache::_Find(const SymbolLookupInfo& lookupInfo)
+{
+	if (fSize == 0)
+		return NULL;
+
+	uint32 index = lookupInfo.gnu_hash & (fSize - 1);
+	while (true) {
+		Entry* entry = &fEntries[index];
+		if (entry->name == NULL)
+			return entry;
+
+		if (entry->hash == lookupInfo.gnu_hash
+			&& entry->type == lookupInfo.type
+			&& strcmp(entry->name, lookupInfo.name) == 0
+			&& equals_version(entry->version, lookupInfo.version)) {
+			return entry;
+		}
+
+		index = (index + 1) & (fSize - 1);
+	}
+}
+
+
+// #pragma mark -
+
+
 int
 resolve_symbol(image_t* rootImage, image_t* image, elf_sym* sym,
 	SymbolLookupCache* cache, addr_t* symAddress, image_t** symbolImage)
@@ -518,9 +786,34 @@ resolve_symbol(image_t* rootImage, image_t* image, elf_sym* sym,
 				versionInfo = image->versions + versionIndex;
 		}
 
-		// search the symbol
-		sharedSym = rootImage->find_undefined_symbol(rootImage, image,
-			SymbolLookupInfo(symName, type, versionInfo, 0, sym), &sharedImage);
+		SymbolLookupInfo lookupInfo(symName, type, versionInfo, 0, sym);
+
+		// Unless the image is linked symbolically, or is an add-on that
+		// resolves its own symbols in a special way, the symbol will be found
+		// in the same place for all images.
+		SymbolResolutionCache* resolutionCache = cache->ResolutionCache();
+		if ((image->flags & RFLAG_SYMBOLIC) != 0
+			|| (rootImage->find_undefined_symbol
+					!= find_undefined_symbol_global
+				&& (rootImage->find_undefined_symbol
+						!= find_undefined_symbol_add_on
+					|| image == rootImage))) {
+			resolutionCache = NULL;
+		}
+
+		gSymbolLookupStatistics.lookups++;
+
+		if (resolutionCache != NULL
+			&& resolutionCache->Lookup(lookupInfo, &sharedSym, &sharedImage)) {
+			gSymbolLookupStatistics.cached_lookups++;
+		} else {
+			// search the symbol
+			sharedSym = rootImage->find_undefined_symbol(rootImage, image,
+				lookupInfo, &sharedImage);
+
+			if (resolutionCache != NULL)
+				resolutionCache->Add(lookupInfo, sharedSym, sharedImage);
+		}
 	}
 
 	enum {
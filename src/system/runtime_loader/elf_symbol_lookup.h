@@ -17,12 +17,14 @@
 
 
 uint32 elf_hash(const char* name);
+uint32 elf_gnu_hash(const char* name);
 
 
 struct SymbolLookupInfo {
 	const char*				name;
 	int32					type;
 	uint32					hash;
+	uint32					gnu_hash;
 	uint32					flags;
 	const elf_version_info*	version;
 	elf_sym*				requestingSymbol;
@@ -34,6 +36,7 @@ struct SymbolLookupInfo {
 		name(name),
 		type(type),
 		hash(hash),
+		gnu_hash(elf_gnu_hash(name)),
 		flags(flags),
 		version(version),
 		requestingSymbol(requestingSymbol)
@@ -47,6 +50,7 @@ struct SymbolLookupInfo {
 		name(name),
 		type(type),
 		hash(elf_hash(name)),
+		gnu_hash(elf_gnu_hash(name)),
 		flags(flags),
 		version(version),
 		requestingSymbol(requestingSymbol)
@@ -55,13 +59,56 @@ struct SymbolLookupInfo {
 };
 
 
+/*!	Remembers where the symbols have been found that were looked up while
+	relocating a group of images. Unless an image is linked symbolically,
+	where a symbol is found does not depend on the image that refers to it,
+	so the images can share their lookups.
+*/
+struct SymbolResolutionCache {
+								SymbolResolutionCache();
+								~SymbolResolutionCache();
+
+			bool				Lookup(const SymbolLookupInfo& lookupInfo,
+									elf_sym** _symbol, image_t** _image);
+			void				Add(const SymbolLookupInfo& lookupInfo,
+									elf_sym* symbol, image_t* image);
+
+private:
+			struct Entry;
+
+			bool				_Resize();
+			Entry*				_Find(const SymbolLookupInfo& lookupInfo);
+
+			Entry*				fEntries;
+			uint32				fSize;
+			uint32				fCount;
+};
+
+
+struct SymbolLookupStatistics {
+	uint32		lookups;
+		// undefined symbols looked up
+	uint32		cached_lookups;
+		// of those, the ones found in the resolution cache
+	uint32		images_searched;
+	uint32		bloom_filter_rejects;
+	uint32		symbols_compared;
+		// symbol names compared to the one looked up
+	bigtime_t	relocation_time;
+};
+
+extern SymbolLookupStatistics gSymbolLookupStatistics;
+
+
 struct SymbolLookupCache {
-	SymbolLookupCache(image_t* image)
+	SymbolLookupCache(image_t* image,
+			SymbolResolutionCache* resolutionCache = NULL)
 		:
 		fTableSize(image->symhash != NULL ? image->symhash[1] : 0),
 		fValues(NULL),
 		fDSOs(NULL),
-		fValuesResolved(NULL)
+		fValuesResolved(NULL),
+		fResolutionCache(resolutionCache)
 	{
 		if (fTableSize > 0) {
 			fValues = (addr_t*)malloc(sizeof(addr_t) * fTableSize);
@@ -114,11 +161,17 @@ struct SymbolLookupCache {
 		}
 	}
 
+	SymbolResolutionCache* ResolutionCache() const
+	{
+		return fResolutionCache;
+	}
+
 private:
-	size_t		fTableSize;
-	addr_t*		fValues;
-	image_t**	fDSOs;
-	uint32*		fValuesResolved;
+	size_t					fTableSize;
+	addr_t*					fValues;
+	image_t**				fDSOs;
+	uint32*					fValuesResolved;
+	SymbolResolutionCache*	fResolutionCache;
 };
 
 
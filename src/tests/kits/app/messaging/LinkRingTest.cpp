@@ -0,0 +1,248 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Sends link messages of random sizes through a link ring, and checks that
+	they all arrive complete and in order, also when the ring wraps, is full,
+	or the receiver waits for it. Then compares how many small messages per
+	second go through the ring and through a port alone.
+*/
+
+
+#include <LinkRing.h>
+#include <PortLink.h>
+#include <Rect.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+using BPrivate::link_ring;
+
+
+static const int32 kCheckedMessages = 20000;
+static const int32 kTimedMessages = 500000;
+static const int32 kMessagesPerFlush = 4;
+static const uint32 kPortMessageCode = 'port';
+
+static port_id sPort;
+static link_ring* sRing;
+static sem_id sSpaceSemaphore;
+
+
+static uint32
+hash(int32 index)
+{
+	return (uint32)index * 2654435761UL;
+}
+
+
+static int32
+message_size(int32 index)
+{
+	// mostly small messages, and now and then one that almost fills a link
+	// buffer, so that the ring wraps in all kinds of places
+	uint32 value = hash(index);
+	if (value % 50 == 0)
+		return 60000 + (value >> 8) % 4000;
+	return 4 + (value >> 8) % 200;
+}
+
+
+static status_t
+checked_sender(void* /*data*/)
+{
+	BPrivate::PortLink link(sPort, -1);
+	link.Sender().SetRing(sRing, sSpaceSemaphore);
+
+	uint8 buffer[64000];
+	for (int32 i = 0; i < kCheckedMessages; i++) {
+		int32 size = message_size(i);
+		memset(buffer, i & 0xff, size);
+
+		link.StartMessage(i);
+		link.Attach<int32>(size);
+		link.Attach(buffer, size);
+
+		if (hash(i) % 7 == 0 && link.Flush() != B_OK) {
+			fprintf(stderr, "flushing message %d failed!\n", (int)i);
+			exit(1);
+		}
+		if (hash(i) % 997 == 0) {
+			// let the receiver go to sleep
+			snooze(1000);
+		}
+	}
+
+	link.Flush();
+	return B_OK;
+}
+
+
+static status_t
+timed_sender(void* data)
+{
+	BPrivate::PortLink link(sPort, -1);
+	if (data != NULL)
+		link.Sender().SetRing(sRing, sSpaceSemaphore);
+
+	for (int32 i = 0; i < kTimedMessages; i++) {
+		link.StartMessage(1);
+		link.Attach<BRect>(BRect(i, i, i + 10, i + 10));
+
+		if (i % kMessagesPerFlush == 0)
+			link.Flush();
+	}
+
+	link.StartMessage(0);
+	link.Flush();
+	return B_OK;
+}
+
+
+static void
+init_ring()
+{
+	memset(sRing, 0, sizeof(link_ring));
+
+	// get rid of any wake-up calls left in the port
+	int32 code;
+	while (read_port_etc(sPort, &code, NULL, 0, B_RELATIVE_TIMEOUT, 0) >= 0)
+		;
+}
+
+
+static int
+check_messages()
+{
+	init_ring();
+
+	BPrivate::PortLink link(-1, sPort);
+	link.Receiver().SetRing(sRing, sSpaceSemaphore);
+
+	thread_id thread = spawn_thread(checked_sender, "sender",
+		B_NORMAL_PRIORITY, NULL);
+	resume_thread(thread);
+
+	uint8 buffer[64000];
+	bool portMessageSent = false;
+	bool portMessageReceived = false;
+
+	for (int32 i = 0; i < kCheckedMessages;) {
+		if (!portMessageSent && i == kCheckedMessages / 2) {
+			// a message from someone else must get through a busy ring
+			BPrivate::LinkSender other(sPort);
+			other.StartMessage(kPortMessageCode);
+			other.Flush();
+			portMessageSent = true;
+		}
+
+		int32 code;
+		if (link.GetNextMessage(code) != B_OK) {
+			fprintf(stderr, "getting message %d failed!\n", (int)i);
+			return 1;
+		}
+
+		if ((uint32)code == kPortMessageCode) {
+			portMessageReceived = true;
+			continue;
+		}
+
+		int32 size;
+		if (code != i || link.Read<int32>(&size) != B_OK
+			|| size != message_size(i) || link.Read(buffer, size) != B_OK) {
+			fprintf(stderr, "message %d is wrong (code %d)!\n", (int)i,
+				(int)code);
+			return 1;
+		}
+
+		for (int32 j = 0; j < size; j++) {
+			if (buffer[j] != (i & 0xff)) {
+				fprintf(stderr, "contents of message %d are wrong!\n", (int)i);
+				return 1;
+			}
+		}
+
+		i++;
+	}
+
+	status_t status;
+	wait_for_thread(thread, &status);
+
+	if (!portMessageReceived) {
+		int32 code;
+		if (link.GetNextMessage(code, 0) != B_OK
+			|| (uint32)code != kPortMessageCode) {
+			fprintf(stderr, "port message did not arrive!\n");
+			return 1;
+		}
+	}
+
+	int32 code;
+	if (link.Receiver().HasMessages()
+		|| link.GetNextMessage(code, 0) == B_OK) {
+		fprintf(stderr, "there are messages left!\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+
+static bigtime_t
+time_messages(bool useRing)
+{
+	init_ring();
+
+	BPrivate::PortLink link(-1, sPort);
+	if (useRing)
+		link.Receiver().SetRing(sRing, sSpaceSemaphore);
+
+	bigtime_t startTime = system_time();
+
+	thread_id thread = spawn_thread(timed_sender, "sender", B_NORMAL_PRIORITY,
+		useRing ? sRing : NULL);
+	resume_thread(thread);
+
+	int32 code;
+	while (link.GetNextMessage(code) == B_OK && code != 0)
+		;
+
+	bigtime_t time = system_time() - startTime;
+
+	status_t status;
+	wait_for_thread(thread, &status);
+	return time;
+}
+
+
+int
+main()
+{
+	sPort = create_port(100, "link ring");
+	sRing = (link_ring*)malloc(sizeof(link_ring));
+	sSpaceSemaphore = create_sem(0, "link ring space");
+	if (sPort < 0 || sRing == NULL || sSpaceSemaphore < 0) {
+		fprintf(stderr, "Could not create port, ring, or semaphore!\n");
+		return 1;
+	}
+
+	if (check_messages() != 0)
+		return 1;
+
+	bigtime_t portTime = time_messages(false);
+	bigtime_t ringTime = time_messages(true);
+
+	printf("%d messages, flushed every %d:\n", (int)kTimedMessages,
+		(int)kMessagesPerFlush);
+	printf("  port: %8" B_PRId64 " us, %10.0f messages/s\n", portTime,
+		kTimedMessages * 1000000.0 / portTime);
+	printf("  ring: %8" B_PRId64 " us, %10.0f messages/s\n", ringTime,
+		kTimedMessages * 1000000.0 / ringTime);
+
+	puts("All OK!");
+	return 0;
+}
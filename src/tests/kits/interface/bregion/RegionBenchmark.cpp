@@ -0,0 +1,402 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Records the region operations app_server does to recompute the clipping
+	of a stack of windows while the top one is dragged around, and replays
+	them: once checking every result against the point sets of its inputs,
+	then many times to see how fast they are.
+*/
+
+
+#include <Region.h>
+
+#include <OS.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+enum {
+	kSet,
+	kCopy,
+	kIncludeRect,
+	kIncludeRegion,
+	kExcludeRect,
+	kExcludeRegion,
+	kIntersect,
+	kOffset
+};
+
+struct region_op {
+	int32			op;
+	int32			target;
+	int32			source;
+	clipping_rect	rect;
+};
+
+static const int32 kWindowCount = 16;
+static const int32 kDragSteps = 400;
+static const int32 kReplayCount = 50;
+static const int32 kMaxOps = 200000;
+
+static const int32 kScreenWidth = 1920;
+static const int32 kScreenHeight = 1080;
+
+// region slots
+static const int32 kScreen = 0;
+static const int32 kAvailable = 1;
+static const int32 kOldVisible = 2;
+static const int32 kExposed = 3;
+static const int32 kCopied = 4;
+static const int32 kTemp = 5;
+static const int32 kShape = 6;
+static const int32 kVisible = kShape + kWindowCount;
+static const int32 kDirty = kVisible + kWindowCount;
+static const int32 kSlotCount = kDirty + kWindowCount;
+
+static region_op sOps[kMaxOps];
+static int32 sOpCount;
+static BRegion sRegions[kSlotCount];
+
+
+static void
+record(int32 op, int32 target, int32 source, clipping_rect rect)
+{
+	if (sOpCount == kMaxOps) {
+		fprintf(stderr, "Too many ops!\n");
+		exit(1);
+	}
+
+	region_op& entry = sOps[sOpCount++];
+	entry.op = op;
+	entry.target = target;
+	entry.source = source;
+	entry.rect = rect;
+}
+
+
+static void
+record(int32 op, int32 target, int32 source)
+{
+	clipping_rect rect = { 0, 0, -1, -1 };
+	record(op, target, source, rect);
+}
+
+
+static void
+record(int32 op, int32 target, clipping_rect rect)
+{
+	record(op, target, -1, rect);
+}
+
+
+static clipping_rect
+make_rect(int32 left, int32 top, int32 right, int32 bottom)
+{
+	clipping_rect rect = { left, top, right, bottom };
+	return rect;
+}
+
+
+static int32
+random_value(int32 max)
+{
+	return rand() % max;
+}
+
+
+/*!	Records what Desktop does when the top window moves: the clipping of all
+	windows is rebuilt from top to bottom, and the parts that changed are
+	redrawn, or copied for the moved window.
+*/
+static void
+record_drag()
+{
+	clipping_rect frames[kWindowCount];
+	srand(42);
+	for (int32 i = 0; i < kWindowCount; i++) {
+		int32 width = 200 + random_value(700);
+		int32 height = 150 + random_value(500);
+		int32 left = random_value(kScreenWidth - width);
+		int32 top = 20 + random_value(kScreenHeight - height - 20);
+		frames[i] = make_rect(left, top, left + width, top + height);
+	}
+
+	record(kSet, kScreen, make_rect(0, 0, kScreenWidth - 1,
+		kScreenHeight - 1));
+
+	int32 deltaX = 7;
+	int32 deltaY = 3;
+	for (int32 step = 0; step <= kDragSteps; step++) {
+		if (step > 0) {
+			record(kCopy, kOldVisible, kVisible);
+
+			if (frames[0].left + deltaX < 0
+				|| frames[0].right + deltaX >= kScreenWidth)
+				deltaX = -deltaX;
+			if (frames[0].top + deltaY < 20
+				|| frames[0].bottom + deltaY >= kScreenHeight)
+				deltaY = -deltaY;
+
+			frames[0].left += deltaX;
+			frames[0].right += deltaX;
+			frames[0].top += deltaY;
+			frames[0].bottom += deltaY;
+		}
+
+		record(kCopy, kAvailable, kScreen);
+
+		for (int32 i = 0; i < kWindowCount; i++) {
+			// the border and a tab, like with the default decorator
+			clipping_rect& frame = frames[i];
+			int32 tabWidth = (frame.right - frame.left) / (2 + i % 3);
+			record(kSet, kShape + i, frame);
+			record(kIncludeRect, kShape + i, make_rect(frame.left - 1,
+				frame.top - 18, frame.left + tabWidth, frame.top - 1));
+
+			record(kCopy, kVisible + i, kShape + i);
+			record(kIntersect, kVisible + i, kAvailable);
+			record(kExcludeRegion, kAvailable, kVisible + i);
+		}
+
+		if (step == 0)
+			continue;
+
+		// the moved window copies what it can, and has the rest redrawn
+		record(kCopy, kCopied, kOldVisible);
+		record(kOffset, kCopied, -1, make_rect(deltaX, deltaY, 0, 0));
+		record(kIntersect, kCopied, kVisible);
+
+		record(kCopy, kDirty, kVisible);
+		record(kExcludeRegion, kDirty, kCopied);
+
+		// everything it uncovered is redrawn by the other windows, and the
+		// desktop background
+		record(kCopy, kExposed, kOldVisible);
+		record(kExcludeRegion, kExposed, kVisible);
+
+		for (int32 i = 1; i < kWindowCount; i++) {
+			if (step % 10 == 0) {
+				// the windows have redrawn
+				record(kSet, kDirty + i, make_rect(0, 0, -1, -1));
+			}
+			record(kCopy, kTemp, kExposed);
+			record(kIntersect, kTemp, kVisible + i);
+			record(kIncludeRegion, kDirty + i, kTemp);
+		}
+
+		record(kIntersect, kExposed, kAvailable);
+		record(kExcludeRect, kAvailable, make_rect(0, 0, kScreenWidth - 1,
+			19));
+	}
+}
+
+
+static void
+replay_op(const region_op& op)
+{
+	BRegion& target = sRegions[op.target];
+	switch (op.op) {
+		case kSet:
+			target.Set(op.rect);
+			break;
+		case kCopy:
+			target = sRegions[op.source];
+			break;
+		case kIncludeRect:
+			target.Include(op.rect);
+			break;
+		case kIncludeRegion:
+			target.Include(&sRegions[op.source]);
+			break;
+		case kExcludeRect:
+			target.Exclude(op.rect);
+			break;
+		case kExcludeRegion:
+			target.Exclude(&sRegions[op.source]);
+			break;
+		case kIntersect:
+			target.IntersectWith(&sRegions[op.source]);
+			break;
+		case kOffset:
+			target.OffsetBy(op.rect.left, op.rect.top);
+			break;
+	}
+}
+
+
+static void
+add_edges(const BRegion& region, int32* xs, int32& xCount, int32* ys,
+	int32& yCount)
+{
+	for (int32 i = 0; i < region.CountRects(); i++) {
+		clipping_rect rect = region.RectAtInt(i);
+		xs[xCount++] = rect.left;
+		xs[xCount++] = rect.right + 1;
+		ys[yCount++] = rect.top;
+		ys[yCount++] = rect.bottom + 1;
+	}
+}
+
+
+static bool
+expected(const region_op& op, const BRegion& before, int32 x, int32 y)
+{
+	bool inTarget = before.Contains(x, y);
+	bool inSource = false;
+	if (op.source == op.target)
+		inSource = inTarget;
+	else if (op.source >= 0)
+		inSource = sRegions[op.source].Contains(x, y);
+	else {
+		inSource = x >= op.rect.left && x <= op.rect.right
+			&& y >= op.rect.top && y <= op.rect.bottom;
+	}
+
+	switch (op.op) {
+		case kSet:
+			return inSource;
+		case kCopy:
+			return inSource;
+		case kIncludeRect:
+		case kIncludeRegion:
+			return inTarget || inSource;
+		case kExcludeRect:
+		case kExcludeRegion:
+			return inTarget && !inSource;
+		case kIntersect:
+			return inTarget && inSource;
+		case kOffset:
+			return before.Contains(x - op.rect.left, y - op.rect.top);
+	}
+
+	return false;
+}
+
+
+static bool
+check_structure(const BRegion& region)
+{
+	// y-x-banded, sorted, and no two rects of a band touching
+	clipping_rect bounds = { 0, 0, -1, -1 };
+	for (int32 i = 0; i < region.CountRects(); i++) {
+		clipping_rect rect = region.RectAtInt(i);
+		if (rect.left > rect.right || rect.top > rect.bottom)
+			return false;
+
+		if (i == 0)
+			bounds = rect;
+		else {
+			clipping_rect previous = region.RectAtInt(i - 1);
+			if (rect.top == previous.top) {
+				if (rect.bottom != previous.bottom
+					|| rect.left <= previous.right + 1)
+					return false;
+			} else if (rect.top <= previous.bottom)
+				return false;
+
+			if (rect.left < bounds.left)
+				bounds.left = rect.left;
+			if (rect.right > bounds.right)
+				bounds.right = rect.right;
+			bounds.bottom = rect.bottom;
+		}
+	}
+
+	if (region.CountRects() == 0)
+		return true;
+
+	clipping_rect frame = region.FrameInt();
+	return memcmp(&frame, &bounds, sizeof(clipping_rect)) == 0;
+}
+
+
+static int
+check_ops()
+{
+	static int32 xs[8192];
+	static int32 ys[8192];
+
+	for (int32 i = 0; i < sOpCount; i++) {
+		const region_op& op = sOps[i];
+		BRegion before(sRegions[op.target]);
+
+		int32 xCount = 0;
+		int32 yCount = 0;
+		add_edges(before, xs, xCount, ys, yCount);
+		if (op.source >= 0)
+			add_edges(sRegions[op.source], xs, xCount, ys, yCount);
+		else if (op.op == kOffset) {
+			for (int32 j = 0; j < before.CountRects(); j++) {
+				clipping_rect rect = before.RectAtInt(j);
+				xs[xCount++] = rect.left + op.rect.left;
+				xs[xCount++] = rect.right + 1 + op.rect.left;
+				ys[yCount++] = rect.top + op.rect.top;
+				ys[yCount++] = rect.bottom + 1 + op.rect.top;
+			}
+		} else {
+			xs[xCount++] = op.rect.left;
+			xs[xCount++] = op.rect.right + 1;
+			ys[yCount++] = op.rect.top;
+			ys[yCount++] = op.rect.bottom + 1;
+		}
+
+		replay_op(op);
+
+		const BRegion& result = sRegions[op.target];
+		if (!check_structure(result)) {
+			fprintf(stderr, "op %d: result is not a valid region!\n", (int)i);
+			result.PrintToStream();
+			return 1;
+		}
+
+		// the point sets can only differ between the edges of the inputs,
+		// so looking at one point per cell of their grid is enough
+		for (int32 yIndex = 0; yIndex < yCount; yIndex++) {
+			for (int32 xIndex = 0; xIndex < xCount; xIndex++) {
+				int32 x = xs[xIndex];
+				int32 y = ys[yIndex];
+				if (result.Contains(x, y) != expected(op, before, x, y)) {
+					fprintf(stderr, "op %d (%d): wrong at %d, %d!\n", (int)i,
+						(int)op.op, (int)x, (int)y);
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+int
+main()
+{
+	record_drag();
+
+	if (check_ops() != 0)
+		return 1;
+
+	int32 rects = 0;
+	for (int32 i = 0; i < kSlotCount; i++)
+		rects += sRegions[i].CountRects();
+
+	bigtime_t startTime = system_time();
+	for (int32 i = 0; i < kReplayCount; i++) {
+		for (int32 j = 0; j < sOpCount; j++)
+			replay_op(sOps[j]);
+	}
+	bigtime_t time = system_time() - startTime;
+
+	printf("%d ops per replay, %d rects in the end\n", (int)sOpCount,
+		(int)rects);
+	printf("%d replays: %" B_PRId64 " us, %.0f ops/s\n", (int)kReplayCount,
+		time, (double)sOpCount * kReplayCount * 1000000.0 / time);
+
+	puts("All OK!");
+	return 0;
+}
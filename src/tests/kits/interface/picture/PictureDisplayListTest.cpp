@@ -0,0 +1,634 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Records a picture with all kinds of ops, and checks that playing its
+	compiled display list results in exactly the same callbacks as playing it
+	with PicturePlayer, also when the data is truncated anywhere. Then
+	compares how long both take to replay the picture.
+*/
+
+
+#include <AffineTransform.h>
+#include <DataIO.h>
+#include <PictureDataWriter.h>
+#include <PicturePlayer.h>
+#include <PictureProtocol.h>
+#include <Region.h>
+#include <Shape.h>
+
+#include <stdio.h>
+#include <string.h>
+
+
+using BPrivate::PictureDisplayList;
+using BPrivate::PicturePlayer;
+
+
+static const int32 kTimedPlays = 2000;
+
+static uint32 sHash;
+static int32 sCalls;
+static bool sHashing = true;
+
+
+static void
+log_call(int32 index, const void* data = NULL, size_t size = 0)
+{
+	sCalls++;
+	if (!sHashing)
+		return;
+
+	// FNV-1a over the callback index and its arguments
+	sHash = (sHash ^ (uint32)index) * 16777619;
+
+	const uint8* bytes = (const uint8*)data;
+	for (size_t i = 0; i < size; i++)
+		sHash = (sHash ^ bytes[i]) * 16777619;
+}
+
+
+template<typename T>
+static void
+log_value(const T& value)
+{
+	log_call(-1, &value, sizeof(T));
+}
+
+
+static void
+move_pen_by(void*, const BPoint& delta)
+{
+	log_call(0, &delta, sizeof(delta));
+}
+
+
+static void
+stroke_line(void*, const BPoint& start, const BPoint& end)
+{
+	log_call(1, &start, sizeof(start));
+	log_value(end);
+}
+
+
+static void
+draw_rect(void*, const BRect& rect, bool fill)
+{
+	log_call(2, &rect, sizeof(rect));
+	log_value(fill);
+}
+
+
+static void
+draw_round_rect(void*, const BRect& rect, const BPoint& radii, bool fill)
+{
+	log_call(3, &rect, sizeof(rect));
+	log_value(radii);
+	log_value(fill);
+}
+
+
+static void
+draw_bezier(void*, size_t numPoints, const BPoint points[], bool fill)
+{
+	log_call(4, points, numPoints * sizeof(BPoint));
+	log_value(fill);
+}
+
+
+static void
+draw_arc(void*, const BPoint& center, const BPoint& radii, float startTheta,
+	float arcTheta, bool fill)
+{
+	log_call(5, &center, sizeof(center));
+	log_value(radii);
+	log_value(startTheta);
+	log_value(arcTheta);
+	log_value(fill);
+}
+
+
+static void
+draw_ellipse(void*, const BRect& rect, bool fill)
+{
+	log_call(6, &rect, sizeof(rect));
+	log_value(fill);
+}
+
+
+static void
+draw_polygon(void*, size_t numPoints, const BPoint points[], bool isClosed,
+	bool fill)
+{
+	log_call(7, points, numPoints * sizeof(BPoint));
+	log_value(isClosed);
+	log_value(fill);
+}
+
+
+static void
+draw_shape(void*, const BShape& shape, bool fill)
+{
+	BRect bounds = shape.Bounds();
+	log_call(8, &bounds, sizeof(bounds));
+	log_value(fill);
+}
+
+
+static void
+draw_string(void*, const char* string, size_t length, float deltaSpace,
+	float deltaNonSpace)
+{
+	log_call(9, string, length);
+	log_value(deltaSpace);
+	log_value(deltaNonSpace);
+}
+
+
+static void
+draw_pixels(void*, const BRect& source, const BRect& destination,
+	uint32 width, uint32 height, size_t bytesPerRow, color_space colorSpace,
+	uint32 flags, const void* data, size_t length)
+{
+	log_call(10, data, length);
+	log_value(source);
+	log_value(destination);
+	log_value(width);
+	log_value(height);
+	log_value(bytesPerRow);
+	log_value(colorSpace);
+	log_value(flags);
+}
+
+
+static void
+draw_picture(void*, const BPoint& where, int32 token)
+{
+	log_call(11, &where, sizeof(where));
+	log_value(token);
+}
+
+
+static void
+set_clipping_rects(void*, size_t numRects, const BRect rects[])
+{
+	log_call(12, rects, numRects * sizeof(BRect));
+}
+
+
+static void
+clip_to_picture(void*, int32 token, const BPoint& where, bool inverse)
+{
+	log_call(13, &token, sizeof(token));
+	log_value(where);
+	log_value(inverse);
+}
+
+
+static void
+push_state(void*)
+{
+	log_call(14);
+}
+
+
+static void
+pop_state(void*)
+{
+	log_call(15);
+}
+
+
+static void
+enter_state_change(void*)
+{
+	log_call(16);
+}
+
+
+static void
+exit_state_change(void*)
+{
+	log_call(17);
+}
+
+
+static void
+enter_font_state(void*)
+{
+	log_call(18);
+}
+
+
+static void
+exit_font_state(void*)
+{
+	log_call(19);
+}
+
+
+static void
+set_origin(void*, const BPoint& origin)
+{
+	log_call(20, &origin, sizeof(origin));
+}
+
+
+static void
+set_pen_location(void*, const BPoint& location)
+{
+	log_call(21, &location, sizeof(location));
+}
+
+
+static void
+set_drawing_mode(void*, drawing_mode mode)
+{
+	log_call(22, &mode, sizeof(mode));
+}
+
+
+static void
+set_line_mode(void*, cap_mode capMode, join_mode joinMode, float miterLimit)
+{
+	log_call(23, &capMode, sizeof(capMode));
+	log_value(joinMode);
+	log_value(miterLimit);
+}
+
+
+static void
+set_pen_size(void*, float size)
+{
+	log_call(24, &size, sizeof(size));
+}
+
+
+static void
+set_fore_color(void*, const rgb_color& color)
+{
+	log_call(25, &color, sizeof(color));
+}
+
+
+static void
+set_back_color(void*, const rgb_color& color)
+{
+	log_call(26, &color, sizeof(color));
+}
+
+
+static void
+set_stipple_pattern(void*, const pattern& stipplePattern)
+{
+	log_call(27, &stipplePattern, sizeof(stipplePattern));
+}
+
+
+static void
+set_scale(void*, float scale)
+{
+	log_call(28, &scale, sizeof(scale));
+}
+
+
+static void
+set_font_family(void*, const char* family, size_t length)
+{
+	log_call(29, family, length);
+}
+
+
+static void
+set_font_style(void*, const char* style, size_t length)
+{
+	log_call(30, style, length);
+}
+
+
+static void
+set_font_spacing(void*, uint8 spacing)
+{
+	log_call(31, &spacing, sizeof(spacing));
+}
+
+
+static void
+set_font_size(void*, float size)
+{
+	log_call(32, &size, sizeof(size));
+}
+
+
+static void
+set_font_rotation(void*, float rotation)
+{
+	log_call(33, &rotation, sizeof(rotation));
+}
+
+
+static void
+set_font_encoding(void*, uint8 encoding)
+{
+	log_call(34, &encoding, sizeof(encoding));
+}
+
+
+static void
+set_font_flags(void*, uint32 flags)
+{
+	log_call(35, &flags, sizeof(flags));
+}
+
+
+static void
+set_font_shear(void*, float shear)
+{
+	log_call(36, &shear, sizeof(shear));
+}
+
+
+static void
+set_font_face(void*, uint16 face)
+{
+	log_call(37, &face, sizeof(face));
+}
+
+
+static void
+set_blending_mode(void*, source_alpha sourceAlpha,
+	alpha_function alphaFunction)
+{
+	log_call(38, &sourceAlpha, sizeof(sourceAlpha));
+	log_value(alphaFunction);
+}
+
+
+static void
+set_transform(void*, const BAffineTransform& transform)
+{
+	double values[6] = { transform.sx, transform.shy, transform.shx,
+		transform.sy, transform.tx, transform.ty };
+	log_call(39, values, sizeof(values));
+}
+
+
+static void
+translate_by(void*, double x, double y)
+{
+	log_call(40, &x, sizeof(x));
+	log_value(y);
+}
+
+
+static void
+scale_by(void*, double x, double y)
+{
+	log_call(41, &x, sizeof(x));
+	log_value(y);
+}
+
+
+static void
+rotate_by(void*, double angleRadians)
+{
+	log_call(42, &angleRadians, sizeof(angleRadians));
+}
+
+
+static void
+blend_layer(void*, Layer* layer)
+{
+	log_call(43, &layer, sizeof(layer));
+}
+
+
+static void
+clip_to_rect(void*, const BRect& rect, bool inverse)
+{
+	log_call(44, &rect, sizeof(rect));
+	log_value(inverse);
+}
+
+
+static void
+clip_to_shape(void*, int32 opCount, const uint32 opList[], int32 pointCount,
+	const BPoint pointList[], bool inverse)
+{
+	log_call(45, opList, opCount * sizeof(uint32));
+	log_call(-1, pointList, pointCount * sizeof(BPoint));
+	log_value(inverse);
+}
+
+
+static const BPrivate::picture_player_callbacks kLogCallbacks = {
+	move_pen_by,
+	stroke_line,
+	draw_rect,
+	draw_round_rect,
+	draw_bezier,
+	draw_arc,
+	draw_ellipse,
+	draw_polygon,
+	draw_shape,
+	draw_string,
+	draw_pixels,
+	draw_picture,
+	set_clipping_rects,
+	clip_to_picture,
+	push_state,
+	pop_state,
+	enter_state_change,
+	exit_state_change,
+	enter_font_state,
+	exit_font_state,
+	set_origin,
+	set_pen_location,
+	set_drawing_mode,
+	set_line_mode,
+	set_pen_size,
+	set_fore_color,
+	set_back_color,
+	set_stipple_pattern,
+	set_scale,
+	set_font_family,
+	set_font_style,
+	set_font_spacing,
+	set_font_size,
+	set_font_rotation,
+	set_font_encoding,
+	set_font_flags,
+	set_font_shear,
+	set_font_face,
+	set_blending_mode,
+	set_transform,
+	translate_by,
+	scale_by,
+	rotate_by,
+	blend_layer,
+	clip_to_rect,
+	clip_to_shape
+};
+
+
+class PictureRecorder : public PictureDataWriter {
+public:
+	PictureRecorder(BPositionIO* data)
+		:
+		PictureDataWriter(data)
+	{
+	}
+
+	void Record(int32 round)
+	{
+		float offset = round * 3.5f;
+		rgb_color color = { (uint8)round, 100, 200, 255 };
+
+		BeginOp(B_PIC_ENTER_STATE_CHANGE);
+		WriteSetOrigin(BPoint(offset, 2));
+		WriteSetPenSize(1.5f + round);
+		WriteSetHighColor(color);
+		WriteSetLowColor(color);
+		WriteSetDrawingMode(B_OP_ALPHA);
+		WriteSetLineMode(B_ROUND_CAP, B_BEVEL_JOIN, 4);
+		WriteSetPattern(B_MIXED_COLORS);
+		WriteSetScale(1.25f);
+		BeginOp(B_PIC_ENTER_FONT_STATE);
+		WriteSetFontFamily("Noto Sans");
+		WriteSetFontStyle("Bold");
+		WriteSetFontSize(12 + round);
+		WriteSetFontFace(B_BOLD_FACE);
+		WriteSetFontFlags(B_DISABLE_ANTIALIASING);
+		EndOp();
+		EndOp();
+
+		WritePushState();
+		WriteTranslateBy(offset, 1);
+		WriteScaleBy(2, 0.5);
+		WriteRotateBy(0.25);
+		WriteStrokeLine(BPoint(0, 0), BPoint(offset, 10));
+		WriteDrawRect(BRect(1, 2, 30 + offset, 40), round % 2 == 0);
+		WriteDrawRoundRect(BRect(1, 2, 30, 40), BPoint(3, 4), true);
+		WriteDrawEllipse(BRect(5, 5, 50, 20 + offset), false);
+		WriteDrawArc(BPoint(10, 10), BPoint(5, 6), 0.5f, 2.5f, true);
+
+		BPoint points[5] = { BPoint(0, 0), BPoint(10, offset), BPoint(20, 5),
+			BPoint(3, 4), BPoint(7, 8) };
+		WriteDrawPolygon(5, points, round % 3 == 0, false);
+		WriteDrawPolygon(3, points, false, true);
+		WriteDrawBezier(points, round % 2 != 0);
+
+		uint32 ops[2] = { 0x10000000 | 1, 0x20000000 | 3 };
+		WriteDrawShape(2, ops, 4, points, true);
+		WriteClipToShape(2, ops, 4, points, round % 2 == 0);
+		WriteClipToRect(BRect(0, 0, 100, 100 + offset), true);
+
+		escapement_delta delta = { 0.5f, 1.5f };
+		WriteDrawString(BPoint(offset, 20), "Hello, picture!", 15, delta);
+
+		uint32 pixels[16];
+		for (int32 i = 0; i < 16; i++)
+			pixels[i] = i * 0x01020304 + round;
+		WriteDrawBitmap(BRect(0, 0, 3, 3), BRect(10, 10, 13 + offset, 13), 4,
+			4, 16, B_RGBA32, 0, pixels, sizeof(pixels));
+
+		BRegion region(BRect(0, 0, 10, 10));
+		region.Include(BRect(20, 20, 30, 40 + offset));
+		WriteSetClipping(region);
+		WriteClearClipping();
+		WriteDrawPicture(BPoint(offset, 5), 42 + round);
+		WriteClipToPicture(43, BPoint(1, offset), round % 2 != 0);
+		WriteSetTransform(BAffineTransform(1, 0.5, 0.25, 2, offset, 3));
+		WritePopState();
+	}
+};
+
+
+static uint32
+play_with_player(const void* data, size_t size, status_t& status)
+{
+	sHash = 2166136261UL;
+	sCalls = 0;
+
+	PicturePlayer player(data, size, NULL);
+	status = player.Play(kLogCallbacks, sizeof(kLogCallbacks), NULL);
+	return sHash;
+}
+
+
+static uint32
+play_display_list(const void* data, size_t size, status_t& status)
+{
+	sHash = 2166136261UL;
+	sCalls = 0;
+
+	PictureDisplayList displayList;
+	displayList.Compile(data, size);
+	status = displayList.Play(kLogCallbacks, sizeof(kLogCallbacks), NULL);
+	return sHash;
+}
+
+
+int
+main()
+{
+	BMallocIO data;
+	PictureRecorder recorder(&data);
+	for (int32 round = 0; round < 20; round++)
+		recorder.Record(round);
+
+	const uint8* buffer = (const uint8*)data.Buffer();
+	size_t size = data.BufferLength();
+
+	status_t playerStatus;
+	uint32 playerHash = play_with_player(buffer, size, playerStatus);
+	int32 playerCalls = sCalls;
+
+	status_t listStatus;
+	uint32 listHash = play_display_list(buffer, size, listStatus);
+	if (playerStatus != B_OK || listStatus != B_OK || listHash != playerHash
+		|| sCalls != playerCalls) {
+		fprintf(stderr, "Playing the display list differs: %" B_PRId32
+			" calls instead of %" B_PRId32 "!\n", sCalls, playerCalls);
+		return 1;
+	}
+
+	// damaged data must be handled the same way, too
+	for (size_t length = 0; length < size; length += 7) {
+		playerHash = play_with_player(buffer, length, playerStatus);
+		playerCalls = sCalls;
+		listHash = play_display_list(buffer, length, listStatus);
+
+		if (listStatus != playerStatus || listHash != playerHash
+			|| sCalls != playerCalls) {
+			fprintf(stderr, "Data truncated to %" B_PRIuSIZE " bytes is "
+				"played differently!\n", length);
+			return 1;
+		}
+	}
+
+	// only measure the playing itself
+	sHashing = false;
+
+	bigtime_t startTime = system_time();
+	for (int32 i = 0; i < kTimedPlays; i++)
+		play_with_player(buffer, size, playerStatus);
+	bigtime_t playerTime = system_time() - startTime;
+
+	startTime = system_time();
+	PictureDisplayList displayList;
+	displayList.Compile(buffer, size);
+	for (int32 i = 0; i < kTimedPlays; i++)
+		displayList.Play(kLogCallbacks, sizeof(kLogCallbacks), NULL);
+	bigtime_t listTime = system_time() - startTime;
+
+	printf("%" B_PRId32 " plays of %" B_PRIuSIZE " bytes, %" B_PRId32
+		" ops:\n", kTimedPlays, size, displayList.CountOps());
+	printf("  PicturePlayer:      %8" B_PRId64 " us\n", playerTime);
+	printf("  PictureDisplayList: %8" B_PRId64 " us\n", listTime);
+
+	puts("All OK!");
+	return 0;
+}
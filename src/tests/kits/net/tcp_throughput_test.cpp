@@ -0,0 +1,164 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the bulk TCP throughput over the loopback interface (or any other
+	local address), ie. the per-packet overhead of the network stack.
+*/
+
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const size_t kBufferSize = 65536;
+
+
+static void
+usage(const char* programName)
+{
+	fprintf(stderr, "usage: %s [-a <address>] [-s <megabytes>] "
+		"[-w <write size>]\n", programName);
+	exit(1);
+}
+
+
+static void
+run_sender(const sockaddr_in& address, size_t totalBytes, size_t writeSize)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		fprintf(stderr, "sender: socket() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	if (connect(fd, (const sockaddr*)&address, sizeof(address)) != 0) {
+		fprintf(stderr, "sender: connect() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	char* buffer = (char*)malloc(writeSize);
+	memset(buffer, 'x', writeSize);
+
+	while (totalBytes > 0) {
+		ssize_t bytesWritten = write(fd, buffer,
+			totalBytes < writeSize ? totalBytes : writeSize);
+		if (bytesWritten <= 0) {
+			fprintf(stderr, "sender: write() failed: %s\n", strerror(errno));
+			exit(1);
+		}
+
+		totalBytes -= bytesWritten;
+	}
+
+	free(buffer);
+	close(fd);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const char* addressString = "127.0.0.1";
+	size_t totalBytes = 256 * 1024 * 1024;
+	size_t writeSize = kBufferSize;
+
+	int option;
+	while ((option = getopt(argc, argv, "a:s:w:h")) != -1) {
+		switch (option) {
+			case 'a':
+				addressString = optarg;
+				break;
+			case 's':
+				totalBytes = (size_t)strtoul(optarg, NULL, 0) * 1024 * 1024;
+				break;
+			case 'w':
+				writeSize = strtoul(optarg, NULL, 0);
+				if (writeSize == 0)
+					usage(argv[0]);
+				break;
+			default:
+				usage(argv[0]);
+				break;
+		}
+	}
+
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0) {
+		fprintf(stderr, "socket() failed: %s\n", strerror(errno));
+		return 1;
+	}
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = inet_addr(addressString);
+	socklen_t addressLength = sizeof(address);
+
+	if (bind(listener, (sockaddr*)&address, addressLength) != 0
+		|| getsockname(listener, (sockaddr*)&address, &addressLength) != 0
+		|| listen(listener, 1) != 0) {
+		fprintf(stderr, "failed to set up listener: %s\n", strerror(errno));
+		return 1;
+	}
+
+	pid_t child = fork();
+	if (child < 0) {
+		fprintf(stderr, "fork() failed: %s\n", strerror(errno));
+		return 1;
+	}
+	if (child == 0) {
+		close(listener);
+		run_sender(address, totalBytes, writeSize);
+		exit(0);
+	}
+
+	int fd = accept(listener, NULL, NULL);
+	if (fd < 0) {
+		fprintf(stderr, "accept() failed: %s\n", strerror(errno));
+		return 1;
+	}
+
+	char* buffer = (char*)malloc(kBufferSize);
+	size_t bytesReceived = 0;
+	bigtime_t startTime = system_time();
+
+	while (true) {
+		ssize_t bytesRead = read(fd, buffer, kBufferSize);
+		if (bytesRead < 0) {
+			fprintf(stderr, "read() failed: %s\n", strerror(errno));
+			return 1;
+		}
+		if (bytesRead == 0)
+			break;
+
+		bytesReceived += bytesRead;
+	}
+
+	bigtime_t duration = system_time() - startTime;
+
+	int status;
+	waitpid(child, &status, 0);
+
+	close(fd);
+	close(listener);
+	free(buffer);
+
+	printf("%" B_PRIuSIZE " bytes in %g s, %g MB/s (writes of %" B_PRIuSIZE
+		" bytes)\n", bytesReceived, duration / 1000000.0,
+		bytesReceived / (double)duration, writeSize);
+
+	return bytesReceived == totalBytes ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Sends small UDP datagrams from many threads concurrently to many
+	different loopback destinations, and reports the aggregate send rate.
+	This mostly measures the route lookup, and how well it scales with the
+	number of senders.
+*/
+
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const int kMaxThreads = 64;
+static const uint16 kPort = 9;
+	// discard
+
+
+struct sender_args {
+	int			index;
+	int			destinations;
+	bigtime_t	duration;
+	int64		packets;
+	int64		errors;
+};
+
+
+static void
+usage(const char* programName)
+{
+	fprintf(stderr, "usage: %s [-t <threads>] [-d <destinations>] "
+		"[-s <seconds>]\n", programName);
+	exit(1);
+}
+
+
+static void*
+sender_thread(void* _args)
+{
+	sender_args* args = (sender_args*)_args;
+
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		fprintf(stderr, "socket() failed: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_port = htons(kPort);
+
+	char data[32];
+	memset(data, 'x', sizeof(data));
+
+	int destination = args->index;
+	bigtime_t endTime = system_time() + args->duration;
+
+	while (system_time() < endTime) {
+		for (int i = 0; i < 256; i++) {
+			// 127.0.0.0/8 is routed to the loopback interface
+			uint32 host = 1 + destination++ % args->destinations;
+			address.sin_addr.s_addr = htonl((INADDR_LOOPBACK & 0xff000000)
+				| (host & 0xffffff));
+
+			if (sendto(fd, data, sizeof(data), 0, (sockaddr*)&address,
+					sizeof(address)) == (ssize_t)sizeof(data))
+				args->packets++;
+			else
+				args->errors++;
+		}
+	}
+
+	close(fd);
+	return NULL;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int threadCount = 4;
+	int destinations = 256;
+	int seconds = 5;
+
+	int option;
+	while ((option = getopt(argc, argv, "t:d:s:h")) != -1) {
+		switch (option) {
+			case 't':
+				threadCount = atoi(optarg);
+				if (threadCount < 1 || threadCount > kMaxThreads)
+					usage(argv[0]);
+				break;
+			case 'd':
+				destinations = atoi(optarg);
+				if (destinations < 1)
+					usage(argv[0]);
+				break;
+			case 's':
+				seconds = atoi(optarg);
+				if (seconds < 1)
+					usage(argv[0]);
+				break;
+			default:
+				usage(argv[0]);
+				break;
+		}
+	}
+
+	pthread_t threads[kMaxThreads];
+	sender_args args[kMaxThreads];
+
+	for (int i = 0; i < threadCount; i++) {
+		args[i].index = i;
+		args[i].destinations = destinations;
+		args[i].duration = seconds * 1000000LL;
+		args[i].packets = 0;
+		args[i].errors = 0;
+
+		if (pthread_create(&threads[i], NULL, &sender_thread, &args[i]) != 0) {
+			fprintf(stderr, "could not create thread %d\n", i);
+			return 1;
+		}
+	}
+
+	int64 packets = 0;
+	int64 errors = 0;
+	for (int i = 0; i < threadCount; i++) {
+		pthread_join(threads[i], NULL);
+		packets += args[i].packets;
+		errors += args[i].errors;
+	}
+
+	printf("%d threads, %d destinations: %" B_PRId64 " packets in %d s, "
+		"%g packets/s, %" B_PRId64 " errors\n", threadCount, destinations,
+		packets, seconds, packets / (double)seconds, errors);
+
+	return errors == 0 ? 0 : 1;
+}
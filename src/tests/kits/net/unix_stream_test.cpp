@@ -0,0 +1,159 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Transfers a data pattern over an AF_UNIX stream socket pair between two
+	processes, verifies it on the receiving side, and reports the throughput.
+	Varying the write and read sizes covers both the buffered and the direct
+	transfer paths.
+*/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static void
+usage(const char* programName)
+{
+	fprintf(stderr, "usage: %s [-s <megabytes>] [-w <write size>] "
+		"[-r <read size>]\n", programName);
+	exit(1);
+}
+
+
+static inline uint8
+pattern(size_t offset)
+{
+	return (uint8)(offset ^ (offset >> 8) ^ (offset >> 16));
+}
+
+
+static void
+run_sender(int fd, size_t totalBytes, size_t writeSize)
+{
+	uint8* buffer = (uint8*)malloc(writeSize);
+	size_t offset = 0;
+
+	while (offset < totalBytes) {
+		size_t size = totalBytes - offset < writeSize
+			? totalBytes - offset : writeSize;
+		for (size_t i = 0; i < size; i++)
+			buffer[i] = pattern(offset + i);
+
+		size_t written = 0;
+		while (written < size) {
+			ssize_t bytesWritten = write(fd, buffer + written, size - written);
+			if (bytesWritten <= 0) {
+				fprintf(stderr, "sender: write() failed: %s\n",
+					strerror(errno));
+				exit(1);
+			}
+			written += bytesWritten;
+		}
+
+		offset += size;
+	}
+
+	free(buffer);
+	close(fd);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	size_t totalBytes = 256 * 1024 * 1024;
+	size_t writeSize = 256 * 1024;
+	size_t readSize = 256 * 1024;
+
+	int option;
+	while ((option = getopt(argc, argv, "s:w:r:h")) != -1) {
+		switch (option) {
+			case 's':
+				totalBytes = (size_t)strtoul(optarg, NULL, 0) * 1024 * 1024;
+				break;
+			case 'w':
+				writeSize = strtoul(optarg, NULL, 0);
+				if (writeSize == 0)
+					usage(argv[0]);
+				break;
+			case 'r':
+				readSize = strtoul(optarg, NULL, 0);
+				if (readSize == 0)
+					usage(argv[0]);
+				break;
+			default:
+				usage(argv[0]);
+				break;
+		}
+	}
+
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+		fprintf(stderr, "socketpair() failed: %s\n", strerror(errno));
+		return 1;
+	}
+
+	pid_t child = fork();
+	if (child < 0) {
+		fprintf(stderr, "fork() failed: %s\n", strerror(errno));
+		return 1;
+	}
+	if (child == 0) {
+		close(fds[0]);
+		run_sender(fds[1], totalBytes, writeSize);
+		exit(0);
+	}
+
+	close(fds[1]);
+
+	uint8* buffer = (uint8*)malloc(readSize);
+	size_t bytesReceived = 0;
+	bool corrupted = false;
+	bigtime_t startTime = system_time();
+
+	while (true) {
+		ssize_t bytesRead = read(fds[0], buffer, readSize);
+		if (bytesRead < 0) {
+			fprintf(stderr, "read() failed: %s\n", strerror(errno));
+			return 1;
+		}
+		if (bytesRead == 0)
+			break;
+
+		for (ssize_t i = 0; i < bytesRead && !corrupted; i++) {
+			if (buffer[i] != pattern(bytesReceived + i)) {
+				fprintf(stderr, "data mismatch at offset %" B_PRIuSIZE "\n",
+					bytesReceived + i);
+				corrupted = true;
+			}
+		}
+
+		bytesReceived += bytesRead;
+	}
+
+	bigtime_t duration = system_time() - startTime;
+
+	int status;
+	waitpid(child, &status, 0);
+
+	close(fds[0]);
+	free(buffer);
+
+	printf("%" B_PRIuSIZE " bytes in %g s, %g MB/s (writes of %" B_PRIuSIZE
+		", reads of %" B_PRIuSIZE " bytes)\n", bytesReceived,
+		duration / 1000000.0, bytesReceived / (double)duration, writeSize,
+		readSize);
+
+	return bytesReceived == totalBytes && !corrupted ? 0 : 1;
+}
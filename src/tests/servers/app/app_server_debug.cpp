@@ -40,7 +40,7 @@ send_debug_message(team_id team, int32 code)
 void
 usage()
 {
-	fprintf(stderr, "usage: %s -[ab] <team-id> [...]\n", __progname);
+	fprintf(stderr, "usage: %s -[abs] [<team-id> ...]\n", __progname);
 	exit(1);
 }
 
@@ -53,15 +53,18 @@ main(int argc, char** argv)
 
 	bool dumpAllocator = false;
 	bool dumpBitmaps = false;
+	bool dumpBackingStores = false;
 
 	int32 i = 1;
-	while (argv[i][0] == '-') {
+	while (i < argc && argv[i][0] == '-') {
 		const char* arg = &argv[i][1];
 		while (arg[0]) {
 			if (arg[0] == 'a')
 				dumpAllocator = true;
 			else if (arg[0] == 'b')
 				dumpBitmaps = true;
+			else if (arg[0] == 's')
+				dumpBackingStores = true;
 			else
 				usage();
 
@@ -70,6 +73,10 @@ main(int argc, char** argv)
 		i++;
 	}
 
+	// the backing stores are not per application
+	if (dumpBackingStores)
+		send_debug_message(-1, AS_DUMP_BACKING_STORES);
+
 	for (int32 i = 1; i < argc; i++) {
 		team_id team = atoi(argv[i]);
 		if (team <= 0)
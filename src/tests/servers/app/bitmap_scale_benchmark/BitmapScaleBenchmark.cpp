@@ -0,0 +1,231 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Draws a bitmap with bilinear filtering at scale factors from 0.05 to 4,
+	once with the scalar and once with the vector scaling kernels. Prints the
+	time of the first draw, which includes building the mip levels, and the
+	average time of the following ones. Fails if the kernels, or the two
+	drawings, differ in a single pixel.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+#include <Region.h>
+#include <View.h>
+
+#include "BitmapScaleKernels.h"
+#include "DrawingModeKernels.h"
+#include "FontManager.h"
+#include "MallocBuffer.h"
+#include "Painter.h"
+#include "ServerBitmap.h"
+
+
+using BitmapPainterPrivate::FilterInfo;
+
+
+static const uint32 kBitmapWidth = 800;
+static const uint32 kBitmapHeight = 600;
+static const uint32 kBufferWidth = kBitmapWidth * 4;
+static const uint32 kBufferHeight = kBitmapHeight * 4;
+static const int32 kLoops = 10;
+static const int32 kRandomRuns = 20000;
+
+static const float kScales[] = {
+	0.05f, 0.1f, 0.2f, 0.33f, 0.5f, 0.75f, 1.5f, 2.0f, 3.0f, 4.0f
+};
+
+
+static void
+fill_bitmap(UtilityBitmap* bitmap)
+{
+	uint8* bits = bitmap->Bits();
+	int32 bytesPerRow = bitmap->BytesPerRow();
+
+	// fine stripes and a gradient, the stripes alias without filtering
+	for (int32 y = 0; y < bitmap->Height(); y++) {
+		uint8* row = bits + y * bytesPerRow;
+		for (int32 x = 0; x < bitmap->Width(); x++) {
+			row[0] = (x & 1) != 0 ? 255 : 0;
+			row[1] = y * 255 / bitmap->Height();
+			row[2] = ((x + y) & 2) != 0 ? 200 : 40;
+			row[3] = x * 255 / bitmap->Width();
+			row += 4;
+		}
+	}
+}
+
+
+static int
+compare_kernels(const bitmap_scale_kernels* kernels)
+{
+	const bitmap_scale_kernels* reference = bitmap_scale_kernels_for(0);
+
+	// two source rows of 64 pixels, and one extra destination pixel on each
+	// side to catch writes out of the span
+	uint8 source[2 * 64 * 4];
+	uint8 expected[66 * 4];
+	uint8 result[66 * 4];
+	FilterInfo weights[64];
+
+	int failures = 0;
+	for (int32 run = 0; run < kRandomRuns; run++) {
+		for (size_t i = 0; i < sizeof(source); i++)
+			source[i] = (rand() % 4) == 0 ? 255 : rand() & 0xff;
+		for (size_t i = 0; i < sizeof(expected); i++)
+			expected[i] = rand() & 0xff;
+		memcpy(result, expected, sizeof(result));
+
+		uint32 count = rand() % 64;
+		for (uint32 i = 0; i < count; i++) {
+			weights[i].index = (rand() % 63) * 4;
+			weights[i].weight = (rand() % 4) == 0 ? 255 : rand() % 256;
+		}
+		uint16 wTop = (rand() % 4) == 0 ? 255 : rand() % 256;
+
+		switch (run % 3) {
+			case 0:
+				reference->bilinear_row_copy(expected + 4, source, 64 * 4,
+					weights, 0, count - 1, wTop);
+				kernels->bilinear_row_copy(result + 4, source, 64 * 4,
+					weights, 0, count - 1, wTop);
+				break;
+			case 1:
+				reference->bilinear_row_alpha_overlay(expected + 4, source,
+					64 * 4, weights, 0, count - 1, wTop);
+				kernels->bilinear_row_alpha_overlay(result + 4, source,
+					64 * 4, weights, 0, count - 1, wTop);
+				break;
+			case 2:
+				reference->box_downscale_row(expected + 4, source, 64 * 4,
+					count / 2);
+				kernels->box_downscale_row(result + 4, source, 64 * 4,
+					count / 2);
+				break;
+		}
+
+		if (memcmp(expected, result, sizeof(result)) != 0)
+			failures++;
+	}
+
+	return failures;
+}
+
+
+static bigtime_t
+draw(Painter& painter, const ServerBitmap* bitmap, float scale,
+	drawing_mode mode)
+{
+	BRect destination(0, 0, kBitmapWidth * scale - 1,
+		kBitmapHeight * scale - 1);
+
+	painter.SetDrawingMode(mode);
+	bigtime_t startTime = system_time();
+	painter.DrawBitmap(bitmap, bitmap->Bounds(), destination,
+		B_FILTER_BITMAP_BILINEAR);
+	return system_time() - startTime;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	gFontManager = new FontManager;
+	if (gFontManager->InitCheck() != B_OK) {
+		fprintf(stderr, "Could not initialize the font manager\n");
+		return 1;
+	}
+
+	MallocBuffer scalarBuffer(kBufferWidth, kBufferHeight);
+	MallocBuffer vectorBuffer(kBufferWidth, kBufferHeight);
+	if (scalarBuffer.InitCheck() != B_OK
+		|| vectorBuffer.InitCheck() != B_OK) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	BRegion clipping(BRect(0, 0, kBufferWidth - 1, kBufferHeight - 1));
+
+	Painter scalar;
+	scalar.AttachToBuffer(&scalarBuffer);
+	scalar.ConstrainClipping(&clipping);
+
+	Painter vector;
+	vector.AttachToBuffer(&vectorBuffer);
+	vector.ConstrainClipping(&clipping);
+
+	const bitmap_scale_kernels* vectorKernels
+		= bitmap_scale_kernels_for(gSIMDFlags);
+
+	int failures = 0;
+	if (vectorKernels != bitmap_scale_kernels_for(0)) {
+		int differences = compare_kernels(vectorKernels);
+		if (differences > 0) {
+			printf("%d rows differ from the scalar kernels\n", differences);
+			failures++;
+		}
+	} else
+		printf("No vector kernels on this CPU\n");
+
+	drawing_mode modes[] = { B_OP_COPY, B_OP_ALPHA };
+	const char* modeNames[] = { "B_OP_COPY", "B_OP_ALPHA" };
+
+	printf("%-6s %-11s %12s %12s %12s\n", "scale", "mode", "first (us)",
+		"scalar (us)", "vector (us)");
+
+	for (size_t i = 0; i < sizeof(kScales) / sizeof(kScales[0]); i++) {
+		for (int32 m = 0; m < 2; m++) {
+			// a new bitmap each time, so that the first draw has to build
+			// the mip levels
+			UtilityBitmap* bitmap = new UtilityBitmap(
+				BRect(0, 0, kBitmapWidth - 1, kBitmapHeight - 1), B_RGBA32,
+				0);
+			if (!bitmap->IsValid()) {
+				fprintf(stderr, "Out of memory\n");
+				return 1;
+			}
+			fill_bitmap(bitmap);
+
+			memset(scalarBuffer.Bits(), 0xff,
+				scalarBuffer.BytesPerRow() * scalarBuffer.Height());
+			memset(vectorBuffer.Bits(), 0xff,
+				vectorBuffer.BytesPerRow() * vectorBuffer.Height());
+
+			gBitmapScaleKernels = vectorKernels;
+			bigtime_t firstTime = draw(vector, bitmap, kScales[i], modes[m]);
+
+			bigtime_t scalarTime = 0;
+			bigtime_t vectorTime = 0;
+			for (int32 loop = 0; loop < kLoops; loop++) {
+				gBitmapScaleKernels = bitmap_scale_kernels_for(0);
+				scalarTime += draw(scalar, bitmap, kScales[i], modes[m]);
+				gBitmapScaleKernels = vectorKernels;
+				vectorTime += draw(vector, bitmap, kScales[i], modes[m]);
+			}
+
+			// B_OP_ALPHA blends repeatedly, so compare after the same
+			// number of draws
+			draw(scalar, bitmap, kScales[i], modes[m]);
+			bool identical = memcmp(scalarBuffer.Bits(), vectorBuffer.Bits(),
+				scalarBuffer.BytesPerRow() * scalarBuffer.Height()) == 0;
+			if (!identical)
+				failures++;
+
+			printf("%-6.2f %-11s %12" B_PRId64 " %12" B_PRId64 " %12" B_PRId64
+				"%s\n", kScales[i], modeNames[m], firstTime,
+				scalarTime / kLoops, vectorTime / kLoops,
+				identical ? "" : "  MISMATCH");
+
+			bitmap->ReleaseReference();
+		}
+	}
+
+	return failures > 0 ? 1 : 0;
+}
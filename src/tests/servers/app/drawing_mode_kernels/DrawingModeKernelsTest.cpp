@@ -0,0 +1,269 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares the SIMD drawing mode kernels of the app_server with the scalar
+	ones on random spans, and prints the throughput of each of them.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+#include "DrawingModeKernels.h"
+
+
+static const int32 kRandomRuns = 20000;
+static const uint32 kMaxSpan = 70;
+static const uint32 kBenchmarkSpan = 1920;
+static const int32 kBenchmarkLoops = 5000;
+
+
+enum kernel_type {
+	BLEND_SOLID_HSPAN = 0,
+	BLEND_SOLID_HSPAN_SUBPIX,
+	BLEND_SOLID_HSPAN_ALPHA_CO,
+	BLEND_SOLID_HSPAN_ALPHA_CO_SUBPIX,
+	BLEND_SOLID_HSPAN_ALPHA_PC,
+	BLEND_SOLID_HSPAN_BLEND,
+	BLEND_LINE,
+
+	KERNEL_COUNT
+};
+
+static const char* kKernelNames[] = {
+	"blend_solid_hspan",
+	"blend_solid_hspan_subpix",
+	"blend_solid_hspan_alpha_co",
+	"blend_solid_hspan_alpha_co_subpix",
+	"blend_solid_hspan_alpha_pc",
+	"blend_solid_hspan_blend",
+	"blend_line"
+};
+
+
+struct span_arguments {
+	uint32	count;
+	uint8	red;
+	uint8	green;
+	uint8	blue;
+	uint8	alpha;
+	int		offsets[3];
+};
+
+
+static uint8
+random_byte()
+{
+	// favor the values that take special paths in the kernels
+	switch (rand() % 8) {
+		case 0:
+			return 0;
+		case 1:
+			return 255;
+		default:
+			return rand() & 0xff;
+	}
+}
+
+
+static void
+random_covers(uint8* covers, uint32 count)
+{
+	// runs of equal covers, like the rasterizer produces them
+	uint32 i = 0;
+	while (i < count) {
+		uint32 run = 1 + rand() % 12;
+		uint8 cover = random_byte();
+		bool constant = (rand() & 1) != 0;
+		for (; run > 0 && i < count; run--, i++)
+			covers[i] = constant ? cover : random_byte();
+	}
+}
+
+
+static void
+random_pixels(uint8* pixels, uint32 count)
+{
+	bool opaque = (rand() & 1) != 0;
+	for (uint32 i = 0; i < count * 4; i++) {
+		pixels[i] = rand() & 0xff;
+		if (opaque && (i & 3) == 3)
+			pixels[i] = (rand() % 16) != 0 ? 255 : random_byte();
+	}
+}
+
+
+static void
+run_kernel(const drawing_mode_kernels* kernels, int32 type, uint8* pixels,
+	const uint8* covers, const span_arguments& args)
+{
+	switch (type) {
+		case BLEND_SOLID_HSPAN:
+			kernels->blend_solid_hspan(pixels, covers, args.count, args.red,
+				args.green, args.blue);
+			break;
+		case BLEND_SOLID_HSPAN_SUBPIX:
+			kernels->blend_solid_hspan_subpix(pixels, covers, args.count,
+				args.red, args.green, args.blue, args.offsets[0],
+				args.offsets[1], args.offsets[2]);
+			break;
+		case BLEND_SOLID_HSPAN_ALPHA_CO:
+			kernels->blend_solid_hspan_alpha_co(pixels, covers, args.count,
+				args.red, args.green, args.blue, args.alpha);
+			break;
+		case BLEND_SOLID_HSPAN_ALPHA_CO_SUBPIX:
+			kernels->blend_solid_hspan_alpha_co_subpix(pixels, covers,
+				args.count, args.red, args.green, args.blue, args.alpha,
+				args.offsets[0], args.offsets[1], args.offsets[2]);
+			break;
+		case BLEND_SOLID_HSPAN_ALPHA_PC:
+			kernels->blend_solid_hspan_alpha_pc(pixels, covers, args.count,
+				args.red, args.green, args.blue, args.alpha);
+			break;
+		case BLEND_SOLID_HSPAN_BLEND:
+			kernels->blend_solid_hspan_blend(pixels, covers, args.count,
+				args.red, args.green, args.blue);
+			break;
+		case BLEND_LINE:
+			kernels->blend_line(pixels, args.count, args.red, args.green,
+				args.blue, args.alpha);
+			break;
+	}
+}
+
+
+static int
+compare_kernels(const drawing_mode_kernels* kernels, const char* name)
+{
+	const drawing_mode_kernels* reference = drawing_mode_kernels_for(0);
+
+	// one extra pixel on each side to catch writes out of the span, and
+	// room to misalign the start
+	uint8 expected[(kMaxSpan + 3) * 4];
+	uint8 result[(kMaxSpan + 3) * 4];
+	uint8 covers[kMaxSpan * 3];
+
+	int failures = 0;
+	for (int32 type = 0; type < KERNEL_COUNT; type++) {
+		for (int32 run = 0; run < kRandomRuns; run++) {
+			span_arguments args;
+			args.count = rand() % kMaxSpan;
+			args.red = random_byte();
+			args.green = random_byte();
+			args.blue = random_byte();
+			args.alpha = random_byte();
+			args.offsets[0] = rand() % 3;
+			args.offsets[1] = (args.offsets[0] + 1 + rand() % 2) % 3;
+			args.offsets[2] = 3 - args.offsets[0] - args.offsets[1];
+
+			bool subpixel = type == BLEND_SOLID_HSPAN_SUBPIX
+				|| type == BLEND_SOLID_HSPAN_ALPHA_CO_SUBPIX;
+			random_covers(covers, subpixel ? args.count * 3 : args.count);
+			random_pixels(expected, kMaxSpan + 3);
+			memcpy(result, expected, sizeof(result));
+
+			int offset = 4 + 4 * (rand() % 2);
+			run_kernel(reference, type, expected + offset, covers, args);
+			run_kernel(kernels, type, result + offset, covers, args);
+
+			if (memcmp(expected, result, sizeof(result)) != 0) {
+				if (failures++ < 10) {
+					printf("%s %s differs: %" B_PRIu32 " pixels, color %u %u "
+						"%u, alpha %u\n", name, kKernelNames[type], args.count,
+						args.red, args.green, args.blue, args.alpha);
+				}
+			}
+		}
+	}
+
+	return failures;
+}
+
+
+static void
+benchmark(const drawing_mode_kernels* kernels, const char* name)
+{
+	uint8* pixels = (uint8*)malloc(kBenchmarkSpan * 4);
+	uint8* covers = (uint8*)malloc(kBenchmarkSpan * 3);
+	random_pixels(pixels, kBenchmarkSpan);
+	random_covers(covers, kBenchmarkSpan * 3);
+
+	span_arguments args;
+	args.count = kBenchmarkSpan;
+	args.red = 60;
+	args.green = 120;
+	args.blue = 200;
+	args.alpha = 180;
+	args.offsets[0] = 2;
+	args.offsets[1] = 1;
+	args.offsets[2] = 0;
+
+	printf("%s:\n", name);
+	for (int32 type = 0; type < KERNEL_COUNT; type++) {
+		bigtime_t startTime = system_time();
+		for (int32 loop = 0; loop < kBenchmarkLoops; loop++)
+			run_kernel(kernels, type, pixels, covers, args);
+		bigtime_t time = system_time() - startTime;
+
+		printf("  %-36s %8.1f MPixel/s\n", kKernelNames[type],
+			(double)kBenchmarkSpan * kBenchmarkLoops / (time > 0 ? time : 1));
+	}
+
+	free(pixels);
+	free(covers);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	struct {
+		const char*	name;
+		uint32		flags;
+	} variants[] = {
+		{ "scalar", 0 },
+		{ "SSE2", APPSERVER_SIMD_SSE2 },
+		{ "AVX2", APPSERVER_SIMD_SSE2 | APPSERVER_SIMD_AVX2 }
+	};
+
+	uint32 supported = 0;
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		supported |= APPSERVER_SIMD_SSE2;
+	if (__builtin_cpu_supports("avx2"))
+		supported |= APPSERVER_SIMD_AVX2;
+#endif
+
+	srand(argc > 1 ? atoi(argv[1]) : 1);
+
+	int failures = 0;
+	const drawing_mode_kernels* previous = NULL;
+	for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+		if ((variants[i].flags & supported) != variants[i].flags)
+			continue;
+
+		const drawing_mode_kernels* kernels
+			= drawing_mode_kernels_for(variants[i].flags);
+		if (kernels == previous)
+			continue;
+		previous = kernels;
+
+		if (variants[i].flags != 0)
+			failures += compare_kernels(kernels, variants[i].name);
+		benchmark(kernels, variants[i].name);
+	}
+
+	if (failures > 0) {
+		printf("%d spans differ from the scalar kernels\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Makes the app_server open and close FreeType faces concurrently: some
+	threads ask for the glyph shapes of all installed styles, which opens
+	their faces on first use, while the main thread keeps adding and removing
+	a copy of a font file, which opens and closes a face in the FontManager.
+	Fails if the app_server stops answering.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Application.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <FindDirectory.h>
+#include <Font.h>
+#include <OS.h>
+#include <Path.h>
+#include <Shape.h>
+
+
+static const char* kAppSignature
+	= "application/x-vnd.Haiku-FontFaceStress";
+static const int32 kThreadCount = 4;
+static const bigtime_t kStallTimeout = 10000000;
+
+
+static int32 sProgress = 0;
+static bool sQuit = false;
+
+
+static status_t
+find_font_file(BDirectory& directory, BPath& path)
+{
+	BEntry entry;
+	while (directory.GetNextEntry(&entry) == B_OK) {
+		if (entry.IsDirectory()) {
+			BDirectory subDirectory(&entry);
+			if (find_font_file(subDirectory, path) == B_OK)
+				return B_OK;
+			continue;
+		}
+
+		char name[B_FILE_NAME_LENGTH];
+		entry.GetName(name);
+		size_t length = strlen(name);
+		if (length > 4 && strcasecmp(name + length - 4, ".ttf") == 0)
+			return entry.GetPath(&path);
+	}
+
+	return B_ENTRY_NOT_FOUND;
+}
+
+
+static status_t
+copy_file(const char* source, const char* target)
+{
+	BFile sourceFile(source, B_READ_ONLY);
+	BFile targetFile(target, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	status_t status = sourceFile.InitCheck();
+	if (status == B_OK)
+		status = targetFile.InitCheck();
+
+	char buffer[65536];
+	while (status == B_OK) {
+		ssize_t bytesRead = sourceFile.Read(buffer, sizeof(buffer));
+		if (bytesRead <= 0) {
+			status = bytesRead;
+			break;
+		}
+
+		ssize_t bytesWritten = targetFile.Write(buffer, bytesRead);
+		if (bytesWritten != bytesRead)
+			status = bytesWritten < 0 ? bytesWritten : B_IO_ERROR;
+	}
+
+	return status;
+}
+
+
+static status_t
+query_shapes(void* /*data*/)
+{
+	BShape shape;
+	BShape* shapes[1] = { &shape };
+
+	while (!sQuit) {
+		int32 familyCount = count_font_families();
+		for (int32 i = 0; i < familyCount && !sQuit; i++) {
+			font_family family;
+			if (get_font_family(i, &family) != B_OK)
+				continue;
+
+			int32 styleCount = count_font_styles(family);
+			for (int32 j = 0; j < styleCount && !sQuit; j++) {
+				font_style style;
+				if (get_font_style(family, j, &style) != B_OK)
+					continue;
+
+				BFont font;
+				font.SetFamilyAndStyle(family, style);
+				font.GetGlyphShapes("a", 1, shapes);
+
+				atomic_add(&sProgress, 1);
+			}
+		}
+	}
+
+	return B_OK;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	bigtime_t duration = 10000000;
+	if (argc > 1)
+		duration = atoi(argv[1]) * 1000000LL;
+
+	BApplication app(kAppSignature);
+
+	BPath systemFonts;
+	BPath userFonts;
+	if (find_directory(B_SYSTEM_FONTS_DIRECTORY, &systemFonts) != B_OK
+		|| find_directory(B_USER_NONPACKAGED_FONTS_DIRECTORY, &userFonts,
+			true) != B_OK) {
+		fprintf(stderr, "could not find the font directories\n");
+		return 1;
+	}
+
+	BDirectory directory(systemFonts.Path());
+	BPath source;
+	if (find_font_file(directory, source) != B_OK) {
+		fprintf(stderr, "no font file found in %s\n", systemFonts.Path());
+		return 1;
+	}
+
+	thread_id threads[kThreadCount];
+	for (int32 i = 0; i < kThreadCount; i++) {
+		threads[i] = spawn_thread(&query_shapes, "query shapes",
+			B_NORMAL_PRIORITY, NULL);
+		resume_thread(threads[i]);
+	}
+
+	bigtime_t endTime = system_time() + duration;
+	bigtime_t lastProgressTime = system_time();
+	int32 lastProgress = 0;
+	int32 copies = 0;
+	bool copyFailed = false;
+	bool stalled = false;
+
+	while (system_time() < endTime) {
+		BPath target(userFonts.Path());
+		char name[B_FILE_NAME_LENGTH];
+		snprintf(name, sizeof(name), "font_face_stress_%" B_PRId32 ".ttf",
+			copies++);
+		target.Append(name);
+
+		if (copy_file(source.Path(), target.Path()) != B_OK) {
+			fprintf(stderr, "could not copy %s to %s\n", source.Path(),
+				target.Path());
+			copyFailed = true;
+			break;
+		}
+		snooze(50000);
+		BEntry(target.Path()).Remove();
+		snooze(50000);
+
+		int32 progress = atomic_get(&sProgress);
+		if (progress != lastProgress) {
+			lastProgress = progress;
+			lastProgressTime = system_time();
+		} else if (system_time() - lastProgressTime > kStallTimeout) {
+			stalled = true;
+			break;
+		}
+	}
+
+	sQuit = true;
+
+	if (stalled) {
+		// the threads are most likely stuck in the app_server
+		fprintf(stderr, "no progress for %g seconds, the app_server seems "
+			"to be deadlocked\n", kStallTimeout / 1000000.0);
+		return 1;
+	}
+
+	for (int32 i = 0; i < kThreadCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	if (copyFailed)
+		return 1;
+
+	printf("%" B_PRId32 " font copies added and removed, %" B_PRId32
+		" faces queried\n", copies, atomic_get(&sProgress));
+	return 0;
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Renders a few typical large drawing operations with the Painter, once on
+	the calling thread only, and once split into tiles on all CPUs. Prints
+	the time each took, and fails if the results differ in a single pixel.
+	Also checks that rects are filled at the right place into buffers that
+	are offset from the drawing coordinates, like those of layers.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+#include <Region.h>
+
+#include "AppServer.h"
+#include "FontManager.h"
+#include "MallocBuffer.h"
+#include "Painter.h"
+#include "ServerBitmap.h"
+#include "ServerTokenSpace.h"
+
+
+// The globals from AppServer.cpp, which is not linked in
+port_id gAppServerPort = -1;
+BTokenSpace gTokenSpace;
+
+
+static const uint32 kWidth = 3840;
+static const uint32 kHeight = 2160;
+static const int32 kLoops = 20;
+
+
+enum {
+	FILL_RECT = 0,
+	FILL_ELLIPSE,
+	FILL_POLYGON,
+	DRAW_BITMAP,
+	DRAW_BITMAP_ALPHA,
+
+	TEST_COUNT
+};
+
+static const char* kTestNames[] = {
+	"FillRect",
+	"FillEllipse",
+	"FillPolygon",
+	"DrawBitmap (B_OP_COPY)",
+	"DrawBitmap (B_OP_ALPHA)"
+};
+
+
+static void
+fill_bitmap(UtilityBitmap* bitmap)
+{
+	uint8* bits = bitmap->Bits();
+	int32 bytesPerRow = bitmap->BytesPerRow();
+
+	for (int32 y = 0; y < bitmap->Height(); y++) {
+		uint8* row = bits + y * bytesPerRow;
+		for (int32 x = 0; x < bitmap->Width(); x++) {
+			row[0] = x;
+			row[1] = y;
+			row[2] = x ^ y;
+			row[3] = (x + y) & 0xff;
+			row += 4;
+		}
+	}
+}
+
+
+static void
+run_test(Painter& painter, int32 test, const ServerBitmap* bitmap)
+{
+	BRect bounds(0, 0, kWidth - 1, kHeight - 1);
+	rgb_color color = { 60, 120, 200, 160 };
+
+	switch (test) {
+		case FILL_RECT:
+			painter.FillRect(bounds.InsetByCopy(10, 10), color);
+			break;
+
+		case FILL_ELLIPSE:
+			painter.SetHighColor(color);
+			painter.DrawEllipse(bounds.InsetByCopy(20, 20), true);
+			break;
+
+		case FILL_POLYGON:
+		{
+			BPoint points[] = {
+				BPoint(10, 10),
+				BPoint(kWidth - 10, kHeight / 3),
+				BPoint(kWidth / 2, kHeight - 10),
+				BPoint(kWidth / 3, kHeight / 2),
+				BPoint(30, kHeight - 30)
+			};
+			painter.SetHighColor(color);
+			painter.DrawPolygon(points, 5, true, true);
+			break;
+		}
+
+		case DRAW_BITMAP:
+		case DRAW_BITMAP_ALPHA:
+			painter.SetDrawingMode(test == DRAW_BITMAP_ALPHA
+				? B_OP_ALPHA : B_OP_COPY);
+			painter.DrawBitmap(bitmap, bitmap->Bounds(),
+				bitmap->Bounds().OffsetByCopy(5, 7), 0);
+			painter.SetDrawingMode(B_OP_COPY);
+			break;
+	}
+}
+
+
+/*!	Fills a rect into a buffer that starts at (1000, 2000) in drawing
+	coordinates, and checks that exactly the pixels of the rect were set.
+*/
+static bool
+test_renderer_offset(bool parallel)
+{
+	const int32 kOffsetX = 1000;
+	const int32 kOffsetY = 2000;
+	const int32 kSize = 512;
+	const int32 kInset = 8;
+
+	MallocBuffer buffer(kSize, kSize);
+	if (buffer.InitCheck() != B_OK)
+		return false;
+	memset(buffer.Bits(), 0, buffer.BytesPerRow() * buffer.Height());
+
+	BRect frame(kOffsetX, kOffsetY, kOffsetX + kSize - 1,
+		kOffsetY + kSize - 1);
+	BRegion clipping(frame);
+
+	Painter painter;
+	painter.AttachToBuffer(&buffer);
+	painter.SetRendererOffset(kOffsetX, kOffsetY);
+	painter.ConstrainClipping(&clipping);
+	painter.SetParallelRendering(parallel);
+
+	rgb_color color = { 60, 120, 200, 255 };
+	painter.FillRect(frame.InsetByCopy(kInset, kInset), color);
+
+	for (int32 y = 0; y < kSize; y++) {
+		const uint8* pixel = (const uint8*)buffer.Bits()
+			+ y * buffer.BytesPerRow();
+		for (int32 x = 0; x < kSize; x++, pixel += 4) {
+			bool inside = x >= kInset && x < kSize - kInset
+				&& y >= kInset && y < kSize - kInset;
+			bool filled = pixel[0] == color.blue && pixel[1] == color.green
+				&& pixel[2] == color.red && pixel[3] == color.alpha;
+			bool empty = pixel[0] == 0 && pixel[1] == 0 && pixel[2] == 0
+				&& pixel[3] == 0;
+			if (inside ? !filled : !empty) {
+				printf("FillRect with renderer offset (%s): wrong pixel at "
+					"(%" B_PRId32 ", %" B_PRId32 ")\n",
+					parallel ? "parallel" : "serial", x, y);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+static bigtime_t
+benchmark(Painter& painter, MallocBuffer& buffer, int32 test,
+	const ServerBitmap* bitmap)
+{
+	bigtime_t total = 0;
+	for (int32 loop = 0; loop < kLoops; loop++) {
+		memset(buffer.Bits(), 0xff, buffer.BytesPerRow() * buffer.Height());
+
+		bigtime_t startTime = system_time();
+		run_test(painter, test, bitmap);
+		total += system_time() - startTime;
+	}
+
+	return total / kLoops;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	gFontManager = new FontManager;
+	if (gFontManager->InitCheck() != B_OK) {
+		fprintf(stderr, "Could not initialize the font manager\n");
+		return 1;
+	}
+
+	MallocBuffer serialBuffer(kWidth, kHeight);
+	MallocBuffer parallelBuffer(kWidth, kHeight);
+	UtilityBitmap bitmap(BRect(0, 0, kWidth - 20, kHeight - 20), B_RGBA32, 0);
+	if (serialBuffer.InitCheck() != B_OK
+		|| parallelBuffer.InitCheck() != B_OK
+		|| bitmap.Bits() == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	fill_bitmap(&bitmap);
+
+	// a clipping region with a hole, like a window partially covered by
+	// another one
+	BRegion clipping(BRect(0, 0, kWidth - 1, kHeight - 1));
+	clipping.Exclude(BRect(kWidth / 4, kHeight / 4, kWidth / 2, kHeight / 2));
+
+	Painter serial;
+	serial.AttachToBuffer(&serialBuffer);
+	serial.ConstrainClipping(&clipping);
+
+	Painter parallel;
+	parallel.AttachToBuffer(&parallelBuffer);
+	parallel.ConstrainClipping(&clipping);
+	parallel.SetParallelRendering(true);
+
+	int failures = 0;
+	if (!test_renderer_offset(false))
+		failures++;
+	if (!test_renderer_offset(true))
+		failures++;
+
+	for (int32 test = 0; test < TEST_COUNT; test++) {
+		bigtime_t serialTime = benchmark(serial, serialBuffer, test, &bitmap);
+		bigtime_t parallelTime = benchmark(parallel, parallelBuffer, test,
+			&bitmap);
+
+		bool identical = memcmp(serialBuffer.Bits(), parallelBuffer.Bits(),
+			serialBuffer.BytesPerRow() * serialBuffer.Height()) == 0;
+		if (!identical)
+			failures++;
+
+		printf("%-24s serial %7" B_PRId64 " us, parallel %7" B_PRId64
+			" us (%.2fx)%s\n", kTestNames[test], serialTime, parallelTime,
+			parallelTime > 0 ? (double)serialTime / parallelTime : 0.0,
+			identical ? "" : "  MISMATCH");
+	}
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,381 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Renders the bitmaps a few typical interactions make an application draw,
+	and sends them through the tile cache of the remote HWInterface and back
+	through the client side tile store, like over a connection to the
+	remote desktop client. Checks that every bitmap arrives unchanged, and
+	prints how many bytes each step of an interaction takes compared to
+	plain bitmaps, and how long it would take to get them to the client.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+#include "BitmapTiles.h"
+
+
+static const double kLinkSpeed = 10000000.0 / 8;
+	// bytes per second of a 10 MBit/s connection
+
+static const size_t kMessageHeaderSize = 6 + 4 + 2 * 16 + 4;
+	// message header, token, bitmap and view rect, options
+static const size_t kBitmapHeaderSize = 6 * 4;
+static const size_t kTiledBitmapHeaderSize = 5 * 4;
+
+static const uint32 kBackground = 0xffd8d8d8;
+static const uint32 kDocument = 0xffffffff;
+static const uint32 kText = 0xff000000;
+static const uint32 kHighlight = 0xff3070c0;
+
+
+struct frame {
+	uint32*	bits;
+	int32	width;
+	int32	height;
+};
+
+typedef void (*render_func)(frame& frame, int32 step);
+
+struct interaction {
+	const char*	name;
+	int32		width;
+	int32		height;
+	int32		steps;
+	render_func	render;
+};
+
+
+static uint32
+hash(uint32 value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352d;
+	value ^= value >> 15;
+	value *= 0x846ca68b;
+	value ^= value >> 16;
+	return value;
+}
+
+
+static void
+fill_rect(frame& frame, int32 left, int32 top, int32 right, int32 bottom,
+	uint32 color)
+{
+	if (left < 0)
+		left = 0;
+	if (top < 0)
+		top = 0;
+	if (right >= frame.width)
+		right = frame.width - 1;
+	if (bottom >= frame.height)
+		bottom = frame.height - 1;
+
+	for (int32 y = top; y <= bottom; y++) {
+		uint32* row = frame.bits + y * frame.width;
+		for (int32 x = left; x <= right; x++)
+			row[x] = color;
+	}
+}
+
+
+/*!	Draws a made up glyph of 7 x 12 pixels, with some anti-aliasing.
+*/
+static void
+draw_glyph(frame& frame, int32 left, int32 top, uint32 character)
+{
+	static const uint32 kShades[] = { 0xff808080, 0xff404040, kText };
+
+	for (int32 y = 2; y < 11; y++) {
+		uint32 bits = hash(character * 16 + y);
+		for (int32 x = 0; x < 6; x++) {
+			int32 px = left + x;
+			int32 py = top + y;
+			if (px < 0 || py < 0 || px >= frame.width || py >= frame.height)
+				continue;
+
+			uint32 value = (bits >> (x * 3)) & 7;
+			if (value >= 5)
+				frame.bits[py * frame.width + px] = kShades[value - 5];
+		}
+	}
+}
+
+
+static void
+draw_text_line(frame& frame, int32 left, int32 top, int32 line, int32 length)
+{
+	for (int32 i = 0; i < length; i++) {
+		uint32 character = hash(line * 131 + i) % 40;
+		if (character >= 34)
+			continue;
+
+		draw_glyph(frame, left + i * 7, top, character);
+	}
+}
+
+
+static void
+draw_icon(frame& frame, int32 left, int32 top, int32 kind, bool selected)
+{
+	for (int32 y = 0; y < 32; y++) {
+		for (int32 x = 0; x < 32; x++) {
+			int32 dx = x - 16;
+			int32 dy = y - 16;
+			int32 distance = dx * dx + dy * dy;
+			if (distance > 15 * 15)
+				continue;
+
+			uint32 shade = 255 - distance / 2;
+			uint32 color = 0xff000000 | (shade << (kind * 8 % 24))
+				| (kind * 40 << 8);
+			if (selected)
+				color = (color >> 1 & 0x7f7f7f7f) + (kHighlight >> 1 & 0x7f7f7f);
+
+			int32 px = left + x;
+			int32 py = top + y;
+			if (px >= 0 && py >= 0 && px < frame.width && py < frame.height)
+				frame.bits[py * frame.width + px] = color | 0xff000000;
+		}
+	}
+}
+
+
+static void
+draw_button(frame& frame, int32 left, int32 top, int32 width, int32 height,
+	bool highlighted)
+{
+	uint32 color = highlighted ? 0xffe8eef8 : kBackground;
+	fill_rect(frame, left, top, left + width - 1, top + height - 1, 0xff989898);
+	for (int32 y = 1; y < height - 1; y++) {
+		// a slight gradient
+		uint32 shade = y * 2;
+		uint32 rowColor = color - (shade | shade << 8 | shade << 16);
+		fill_rect(frame, left + 1, top + y, left + width - 2, top + y,
+			rowColor);
+	}
+}
+
+
+//	#pragma mark - interactions
+
+
+static void
+render_typing(frame& frame, int32 step)
+{
+	fill_rect(frame, 0, 0, frame.width - 1, frame.height - 1, kDocument);
+
+	int32 lines = 12;
+	for (int32 line = 0; line < lines; line++)
+		draw_text_line(frame, 4, 4 + line * 15, line, 80);
+
+	// the line being typed, and the cursor behind it
+	draw_text_line(frame, 4, 4 + lines * 15, lines, step + 1);
+	fill_rect(frame, 5 + (step + 1) * 7, 4 + lines * 15,
+		5 + (step + 1) * 7, 4 + lines * 15 + 13, kText);
+}
+
+
+static void
+render_scrolling(frame& frame, int32 step)
+{
+	fill_rect(frame, 0, 0, frame.width - 1, frame.height - 1, kDocument);
+
+	int32 offset = step * 15;
+	int32 first = offset / 15;
+	for (int32 line = first; line < first + frame.height / 15 + 1; line++) {
+		draw_text_line(frame, 4, 4 + line * 15 - offset, line,
+			40 + hash(line) % 40);
+	}
+
+	// the scroll bar
+	fill_rect(frame, frame.width - 14, 0, frame.width - 1, frame.height - 1,
+		kBackground);
+	fill_rect(frame, frame.width - 13, step * 4, frame.width - 2,
+		step * 4 + 60, 0xffa0a0a0);
+}
+
+
+static void
+render_menu(frame& frame, int32 step)
+{
+	render_scrolling(frame, 0);
+
+	// the menu bar
+	fill_rect(frame, 0, 0, frame.width - 1, 19, kBackground);
+	for (int32 i = 0; i < 5; i++)
+		draw_text_line(frame, 8 + i * 60, 3, 1000 + i, 5);
+
+	if (step % 2 == 0) {
+		// the open menu, with the item under the mouse highlighted
+		fill_rect(frame, 60, 20, 220, 260, 0xffeeeeee);
+		fill_rect(frame, 60 + 1, 20 + 16 + (step / 2 % 10) * 22, 220 - 1,
+			20 + 16 + (step / 2 % 10) * 22 + 20, kHighlight);
+		for (int32 i = 0; i < 10; i++)
+			draw_text_line(frame, 70, 20 + 20 + i * 22, 2000 + i, 15);
+	}
+}
+
+
+static void
+render_toolbar(frame& frame, int32 step)
+{
+	fill_rect(frame, 0, 0, frame.width - 1, frame.height - 1, kBackground);
+
+	for (int32 i = 0; i < 8; i++) {
+		draw_button(frame, 4 + i * 48, 2, 44, 28, i == step % 8);
+		draw_icon(frame, 4 + i * 48 + 6, 0, i % 3, false);
+	}
+}
+
+
+static void
+render_icons(frame& frame, int32 step)
+{
+	fill_rect(frame, 0, 0, frame.width - 1, frame.height - 1, kDocument);
+
+	for (int32 i = 0; i < 48; i++) {
+		int32 left = 20 + (i % 8) * 76;
+		int32 top = 16 + (i / 8) * 76;
+		bool selected = i == step % 48;
+		draw_icon(frame, left + 22, top, i % 4, selected);
+		if (selected) {
+			fill_rect(frame, left, top + 36, left + 75, top + 50,
+				kHighlight);
+		}
+		draw_text_line(frame, left + 4, top + 37, 3000 + i, 10);
+	}
+}
+
+
+static void
+render_video(frame& frame, int32 step)
+{
+	for (int32 y = 0; y < frame.height; y++) {
+		for (int32 x = 0; x < frame.width; x++) {
+			frame.bits[y * frame.width + x]
+				= hash(step * 1000003 + y * frame.width + x) | 0xff000000;
+		}
+	}
+}
+
+
+static const interaction kInteractions[] = {
+	{ "typing text", 600, 400, 40, render_typing },
+	{ "scrolling a document", 600, 400, 30, render_scrolling },
+	{ "opening a menu", 800, 600, 20, render_menu },
+	{ "hovering the toolbar", 400, 32, 16, render_toolbar },
+	{ "selecting icons", 640, 480, 24, render_icons },
+	{ "playing a video", 320, 240, 10, render_video }
+};
+
+
+int
+main()
+{
+	BitmapTileCache cache;
+	BitmapTileStore store;
+	if (cache.InitCheck() != B_OK || store.InitCheck() != B_OK) {
+		fprintf(stderr, "Could not create the tile cache!\n");
+		return 1;
+	}
+
+	printf("%-22s %12s %12s %6s %10s %10s %10s %10s\n", "per step",
+		"plain bytes", "tiled bytes", "ratio", "encode us", "decode us",
+		"plain ms", "tiled ms");
+
+	size_t totalPlain = 0;
+	size_t totalTiled = 0;
+
+	for (size_t i = 0; i < sizeof(kInteractions) / sizeof(kInteractions[0]);
+			i++) {
+		const interaction& interaction = kInteractions[i];
+
+		frame source;
+		source.width = interaction.width;
+		source.height = interaction.height;
+		source.bits = (uint32*)malloc(source.width * source.height * 4);
+
+		uint32* decoded = (uint32*)malloc(source.width * source.height * 4);
+		if (source.bits == NULL || decoded == NULL) {
+			fprintf(stderr, "Out of memory!\n");
+			return 1;
+		}
+
+		size_t plainBytes = 0;
+		size_t tiledBytes = 0;
+		bigtime_t encodeTime = 0;
+		bigtime_t decodeTime = 0;
+
+		for (int32 step = 0; step < interaction.steps; step++) {
+			interaction.render(source, step);
+
+			bigtime_t startTime = system_time();
+
+			const uint8* data;
+			size_t length;
+			if (cache.Encode((const uint8*)source.bits, source.width * 4,
+					source.width, source.height, &data, &length) != B_OK) {
+				fprintf(stderr, "%s: encoding step %d failed!\n",
+					interaction.name, (int)step);
+				return 1;
+			}
+
+			bigtime_t encodedTime = system_time();
+
+			if (store.Decode(data, length, (uint8*)decoded, source.width * 4,
+					source.width, source.height) != B_OK) {
+				fprintf(stderr, "%s: decoding step %d failed!\n",
+					interaction.name, (int)step);
+				return 1;
+			}
+
+			decodeTime += system_time() - encodedTime;
+			encodeTime += encodedTime - startTime;
+
+			if (memcmp(source.bits, decoded, source.width * source.height * 4)
+					!= 0) {
+				fprintf(stderr, "%s: step %d arrived changed!\n",
+					interaction.name, (int)step);
+				return 1;
+			}
+
+			plainBytes += kMessageHeaderSize + kBitmapHeaderSize
+				+ source.width * source.height * 4;
+			tiledBytes += kMessageHeaderSize + kTiledBitmapHeaderSize + length;
+		}
+
+		int32 steps = interaction.steps;
+		double plainLatency = 1000.0 * plainBytes / steps / kLinkSpeed;
+		double tiledLatency = 1000.0 * tiledBytes / steps / kLinkSpeed
+			+ (encodeTime + decodeTime) / 1000.0 / steps;
+
+		printf("%-22s %12lu %12lu %5.1f%% %10.0f %10.0f %10.2f %10.2f\n",
+			interaction.name, (unsigned long)(plainBytes / steps),
+			(unsigned long)(tiledBytes / steps), 100.0 * tiledBytes / plainBytes,
+			(double)encodeTime / steps, (double)decodeTime / steps,
+			plainLatency, tiledLatency);
+
+		totalPlain += plainBytes;
+		totalTiled += tiledBytes;
+
+		free(source.bits);
+		free(decoded);
+	}
+
+	printf("\nall interactions: %lu plain bytes, %lu tiled bytes (%.1f%%)\n",
+		(unsigned long)totalPlain, (unsigned long)totalTiled,
+		100.0 * totalTiled / totalPlain);
+	printf("latency is the time to get a step to the client at %.0f MBit/s\n",
+		kLinkSpeed * 8 / 1000000);
+
+	puts("All OK!");
+	return 0;
+}
@@ -0,0 +1,373 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Checks the level- and edge-triggered modes of event queues, that closing
+	a queue releases its entries, that a queue inherited by a child still
+	reports its events, and compares the cost of waiting for a few ready FDs
+	among many with poll().
+*/
+
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <event_queue_defs.h>
+#include <syscalls.h>
+
+
+static const int kReadyCount = 16;
+static const int kLoops = 1000;
+static const int kCloseLoops = 100;
+
+
+struct pipe_pair {
+	int	read;
+	int	write;
+};
+
+
+static int sFailures = 0;
+
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+				#condition); \
+			sFailures++; \
+		} \
+	} while (false)
+
+
+static inline int
+ready_index(int count, int first, int i)
+{
+	return (first + i * (count / kReadyCount)) % count;
+}
+
+
+static void
+make_ready(pipe_pair* pipes, int count, int first)
+{
+	for (int i = 0; i < kReadyCount; i++)
+		write(pipes[ready_index(count, first, i)].write, "x", 1);
+}
+
+
+static void
+make_unready(pipe_pair* pipes, int count, int first)
+{
+	char buffer[16];
+	for (int i = 0; i < kReadyCount; i++) {
+		read(pipes[ready_index(count, first, i)].read, buffer,
+			sizeof(buffer));
+	}
+}
+
+
+static int
+add_all(int queue, pipe_pair* pipes, int count, int32 events)
+{
+	for (int i = 0; i < count; i++) {
+		event_wait_info info;
+		info.object = pipes[i].read;
+		info.type = B_OBJECT_TYPE_FD;
+		info.events = events;
+		info.user_data = &pipes[i];
+
+		status_t status = _kern_event_queue_control(queue, B_EVENT_QUEUE_ADD,
+			&info);
+		if (status != B_OK) {
+			fprintf(stderr, "adding FD %d failed: %s\n", pipes[i].read,
+				strerror(status));
+			return status;
+		}
+	}
+
+	return B_OK;
+}
+
+
+static void
+test_modes(pipe_pair* pipes, int count)
+{
+	event_wait_info infos[kReadyCount * 2];
+
+	// level-triggered: reported until the data has been read
+	int queue = _kern_event_queue_create(0);
+	CHECK(queue >= 0);
+	CHECK(add_all(queue, pipes, count, B_EVENT_READ) == B_OK);
+
+	CHECK(_kern_event_queue_wait(queue, infos, kReadyCount * 2,
+		B_RELATIVE_TIMEOUT, 0) == B_WOULD_BLOCK);
+
+	make_ready(pipes, count, 0);
+	CHECK(_kern_event_queue_wait(queue, infos, kReadyCount * 2,
+		B_RELATIVE_TIMEOUT, 100000) == kReadyCount);
+	CHECK(_kern_event_queue_wait(queue, infos, kReadyCount * 2,
+		B_RELATIVE_TIMEOUT, 100000) == kReadyCount);
+	for (int i = 0; i < kReadyCount; i++) {
+		pipe_pair* pipe = (pipe_pair*)infos[i].user_data;
+		CHECK(pipe != NULL && pipe->read == infos[i].object);
+		CHECK((infos[i].events & B_EVENT_READ) != 0);
+	}
+
+	make_unready(pipes, count, 0);
+	CHECK(_kern_event_queue_wait(queue, infos, kReadyCount * 2,
+		B_RELATIVE_TIMEOUT, 0) == B_WOULD_BLOCK);
+	close(queue);
+
+	// edge-triggered: reported once per change
+	queue = _kern_event_queue_create(0);
+	CHECK(queue >= 0);
+	CHECK(add_all(queue, pipes, count, B_EVENT_READ | B_EVENT_EDGE_TRIGGERED)
+		== B_OK);
+
+	make_ready(pipes, count, 0);
+	CHECK(_kern_event_queue_wait(queue, infos, kReadyCount * 2,
+		B_RELATIVE_TIMEOUT, 100000) == kReadyCount);
+	CHECK(_kern_event_queue_wait(queue, infos, kReadyCount * 2,
+		B_RELATIVE_TIMEOUT, 0) == B_WOULD_BLOCK);
+	make_unready(pipes, count, 0);
+
+	// removing an FD
+	event_wait_info info;
+	info.object = pipes[0].read;
+	info.type = B_OBJECT_TYPE_FD;
+	info.events = 0;
+	info.user_data = NULL;
+	CHECK(_kern_event_queue_control(queue, B_EVENT_QUEUE_REMOVE, &info)
+		== B_OK);
+	CHECK(_kern_event_queue_control(queue, B_EVENT_QUEUE_REMOVE, &info)
+		== B_ENTRY_NOT_FOUND);
+	close(queue);
+}
+
+
+static uint64
+used_pages()
+{
+	system_info info;
+	get_system_info(&info);
+	return info.used_pages;
+}
+
+
+static void
+test_close(pipe_pair* pipes, int count)
+{
+	// Closing a queue while the FDs it watches stay open must deselect them;
+	// otherwise, the entries would keep the queue alive until the FDs are
+	// closed.
+	uint64 usedPages = used_pages();
+
+	for (int loop = 0; loop < kCloseLoops; loop++) {
+		int queue = _kern_event_queue_create(0);
+		CHECK(queue >= 0);
+		CHECK(add_all(queue, pipes, count, B_EVENT_READ) == B_OK);
+
+		make_ready(pipes, count, loop);
+		close(queue);
+		make_unready(pipes, count, loop);
+	}
+
+	// the entries of all queues together would be several MB
+	int64 leakedPages = (int64)(used_pages() - usedPages);
+	if (leakedPages > 256)
+		fprintf(stderr, "%" B_PRId64 " pages leaked\n", leakedPages);
+	CHECK(leakedPages <= 256);
+
+	// the FDs must still work as before
+	struct pollfd pollFD;
+	pollFD.fd = pipes[0].read;
+	pollFD.events = POLLIN;
+	CHECK(poll(&pollFD, 1, 0) == 0);
+	write(pipes[0].write, "x", 1);
+	CHECK(poll(&pollFD, 1, 100) == 1);
+
+	char buffer[16];
+	read(pipes[0].read, buffer, sizeof(buffer));
+}
+
+
+static void
+test_inherited(pipe_pair* pipes)
+{
+	// The child cannot select the FDs of the queue again, as they belong to
+	// its parent's I/O context; the events must be reported anyway.
+	int queue = _kern_event_queue_create(0);
+	CHECK(queue >= 0);
+
+	event_wait_info info;
+	info.object = pipes[0].read;
+	info.type = B_OBJECT_TYPE_FD;
+	info.events = B_EVENT_READ;
+	info.user_data = &pipes[0];
+	CHECK(_kern_event_queue_control(queue, B_EVENT_QUEUE_ADD, &info)
+		== B_OK);
+
+	info.object = pipes[1].read;
+	info.events = B_EVENT_READ | B_EVENT_ONE_SHOT;
+	info.user_data = &pipes[1];
+	CHECK(_kern_event_queue_control(queue, B_EVENT_QUEUE_ADD, &info)
+		== B_OK);
+
+	pid_t child = fork();
+	if (child == 0) {
+		sFailures = 0;
+
+		write(pipes[0].write, "x", 1);
+		write(pipes[1].write, "x", 1);
+
+		event_wait_info infos[4];
+		CHECK(_kern_event_queue_wait(queue, infos, 4, B_RELATIVE_TIMEOUT,
+			100000) == 2);
+
+		// the level-triggered entry stays ready, the one-shot one is disabled
+		write(pipes[1].write, "x", 1);
+		ssize_t ready = _kern_event_queue_wait(queue, infos, 4,
+			B_RELATIVE_TIMEOUT, 100000);
+		CHECK(ready == 1);
+		if (ready == 1) {
+			CHECK(infos[0].object == pipes[0].read);
+			CHECK(infos[0].user_data == &pipes[0]);
+			CHECK((infos[0].events & B_EVENT_READ) != 0);
+		}
+
+		_exit(sFailures > 0 ? 1 : 0);
+	}
+
+	CHECK(child > 0);
+	if (child > 0) {
+		int status;
+		CHECK(waitpid(child, &status, 0) == child);
+		CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+
+	close(queue);
+
+	char buffer[16];
+	read(pipes[0].read, buffer, sizeof(buffer));
+	read(pipes[1].read, buffer, sizeof(buffer));
+}
+
+
+static void
+benchmark(pipe_pair* pipes, int count)
+{
+	struct pollfd* pollFDs
+		= (struct pollfd*)malloc(sizeof(struct pollfd) * count);
+	for (int i = 0; i < count; i++) {
+		pollFDs[i].fd = pipes[i].read;
+		pollFDs[i].events = POLLIN;
+	}
+
+	bigtime_t pollTime = 0;
+	for (int loop = 0; loop < kLoops; loop++) {
+		make_ready(pipes, count, loop);
+
+		bigtime_t startTime = system_time();
+		int ready = poll(pollFDs, count, 1000);
+		pollTime += system_time() - startTime;
+
+		if (ready != kReadyCount) {
+			fprintf(stderr, "poll() returned %d\n", ready);
+			sFailures++;
+		}
+
+		make_unready(pipes, count, loop);
+	}
+
+	free(pollFDs);
+
+	int queue = _kern_event_queue_create(0);
+	if (queue < 0 || add_all(queue, pipes, count, B_EVENT_READ) != B_OK) {
+		sFailures++;
+		return;
+	}
+
+	event_wait_info infos[kReadyCount];
+	bigtime_t queueTime = 0;
+	for (int loop = 0; loop < kLoops; loop++) {
+		make_ready(pipes, count, loop);
+
+		bigtime_t startTime = system_time();
+		ssize_t ready = _kern_event_queue_wait(queue, infos, kReadyCount,
+			B_RELATIVE_TIMEOUT, 1000000);
+		queueTime += system_time() - startTime;
+
+		if (ready != kReadyCount) {
+			fprintf(stderr, "event queue returned %d\n", (int)ready);
+			sFailures++;
+		}
+
+		make_unready(pipes, count, loop);
+	}
+
+	close(queue);
+
+	printf("%d FDs, %d ready: poll() %g us, event queue %g us per wait\n",
+		count, kReadyCount, (double)pollTime / kLoops,
+		(double)queueTime / kLoops);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int count = 1000;
+	if (argc > 1)
+		count = atoi(argv[1]);
+	if (count < kReadyCount) {
+		fprintf(stderr, "usage: %s [<number of FDs>]\n", argv[0]);
+		return 1;
+	}
+
+	struct rlimit limit;
+	limit.rlim_cur = limit.rlim_max = count * 2 + 32;
+	if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+		fprintf(stderr, "could not raise the FD limit: %s\n",
+			strerror(errno));
+		return 1;
+	}
+
+	pipe_pair* pipes = (pipe_pair*)malloc(sizeof(pipe_pair) * count);
+	for (int i = 0; i < count; i++) {
+		int fds[2];
+		if (pipe(fds) != 0) {
+			fprintf(stderr, "pipe() failed: %s\n", strerror(errno));
+			return 1;
+		}
+		pipes[i].read = fds[0];
+		pipes[i].write = fds[1];
+	}
+
+	test_modes(pipes, count);
+	test_close(pipes, count);
+	test_inherited(pipes);
+	benchmark(pipes, count);
+
+	for (int i = 0; i < count; i++) {
+		close(pipes[i].read);
+		close(pipes[i].write);
+	}
+	free(pipes);
+
+	if (sFailures > 0) {
+		printf("%d checks failed\n", sFailures);
+		return 1;
+	}
+
+	return 0;
+}
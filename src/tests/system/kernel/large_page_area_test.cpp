@@ -0,0 +1,208 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Creates wired and pageable areas that ask to be mapped with large pages,
+	and changes the protection of, resizes, and unmaps parts of them, which
+	makes the kernel split the large pages again. A pageable area is also
+	copied on write by fork(). The contents must survive all of that.
+	Overcommitting and lazily locked areas must not accept the flag. The
+	"page_stats" KDL command shows how many large pages are mapped and how
+	many have been split.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <vm_defs.h>
+
+
+static const size_t kLargePageSize = 2 * 1024 * 1024;
+static const size_t kAreaSize = 4 * kLargePageSize;
+
+static int32 sFailures;
+
+
+static void
+fill(uint32* buffer, size_t size)
+{
+	for (size_t i = 0; i < size / sizeof(uint32); i++)
+		buffer[i] = i ^ 0x5a5a5a5a;
+}
+
+
+static bool
+check(const char* test, const uint32* buffer, size_t start, size_t end)
+{
+	for (size_t i = start / sizeof(uint32); i < end / sizeof(uint32); i++) {
+		if (buffer[i] != (i ^ 0x5a5a5a5a)) {
+			printf("%s: unexpected value at offset %#lx\n", test,
+				(unsigned long)(i * sizeof(uint32)));
+			sFailures++;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static void
+test(const char* name, uint32 lock)
+{
+	void* address;
+	area_id area = create_area(name, &address, B_ANY_ADDRESS, kAreaSize, lock,
+		B_READ_AREA | B_WRITE_AREA | B_LARGE_PAGE_AREA);
+	if (area < 0) {
+		printf("%s: failed to create area: %s\n", name, strerror(area));
+		sFailures++;
+		return;
+	}
+
+#ifdef __x86_64__
+	if ((addr_t)address % kLargePageSize != 0) {
+		printf("%s: area at %p is not aligned to large pages\n", name,
+			address);
+		sFailures++;
+	}
+#endif
+
+	uint32* buffer = (uint32*)address;
+	uint8* bytes = (uint8*)address;
+	fill(buffer, kAreaSize);
+	check(name, buffer, 0, kAreaSize);
+
+	// the protection of the whole area doesn't need to split anything
+	if (set_area_protection(area, B_READ_AREA) != B_OK
+		|| set_area_protection(area, B_READ_AREA | B_WRITE_AREA) != B_OK) {
+		printf("%s: set_area_protection() failed\n", name);
+		sFailures++;
+	}
+	check(name, buffer, 0, kAreaSize);
+
+	// write protect a page in the second large page
+	if (mprotect(bytes + kLargePageSize + B_PAGE_SIZE, B_PAGE_SIZE,
+			PROT_READ) != 0) {
+		printf("%s: mprotect() failed\n", name);
+		sFailures++;
+	}
+	check(name, buffer, 0, kAreaSize);
+	mprotect(bytes + kLargePageSize + B_PAGE_SIZE, B_PAGE_SIZE,
+		PROT_READ | PROT_WRITE);
+	fill(buffer, kAreaSize);
+
+	// shrink the area to end in the middle of the last large page
+	size_t size = kAreaSize - kLargePageSize / 2;
+	if (resize_area(area, size) != B_OK) {
+		printf("%s: resize_area() failed\n", name);
+		sFailures++;
+		size = kAreaSize;
+	}
+	check(name, buffer, 0, size);
+
+	// unmap two pages in the middle of the first large page
+	size_t hole = kLargePageSize / 2;
+	if (munmap(bytes + hole, 2 * B_PAGE_SIZE) != 0) {
+		printf("%s: munmap() failed\n", name);
+		sFailures++;
+	}
+	check(name, buffer, 0, hole);
+	check(name, buffer, hole + 2 * B_PAGE_SIZE, size);
+
+	// the rest must still be writable
+	fill(buffer, hole);
+	check(name, buffer, 0, hole);
+
+	// unmap the large pages that are left as a whole
+	munmap(bytes + 2 * kLargePageSize, size - 2 * kLargePageSize);
+	check(name, buffer, hole + 2 * B_PAGE_SIZE, 2 * kLargePageSize);
+
+	munmap(bytes, 2 * kLargePageSize);
+}
+
+
+static void
+test_copy_on_write()
+{
+	const char* name = "large page copy on write";
+	void* address;
+	area_id area = create_area(name, &address, B_ANY_ADDRESS, kAreaSize,
+		B_NO_LOCK, B_READ_AREA | B_WRITE_AREA | B_LARGE_PAGE_AREA);
+	if (area < 0) {
+		printf("%s: failed to create area: %s\n", name, strerror(area));
+		sFailures++;
+		return;
+	}
+
+	uint32* buffer = (uint32*)address;
+	fill(buffer, kAreaSize);
+
+	// the child's writes must neither be seen by, nor lose the contents of
+	// the parent
+	pid_t child = fork();
+	if (child == 0) {
+		memset(buffer + kLargePageSize / sizeof(uint32), 0, B_PAGE_SIZE);
+		_exit(buffer[kLargePageSize / sizeof(uint32)] == 0
+			&& buffer[kLargePageSize / sizeof(uint32) - 1]
+				== ((kLargePageSize / sizeof(uint32) - 1) ^ 0x5a5a5a5a)
+			? 0 : 1);
+	}
+
+	int status;
+	if (child < 0 || waitpid(child, &status, 0) != child
+		|| !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		printf("%s: the child failed\n", name);
+		sFailures++;
+	}
+	check(name, buffer, 0, kAreaSize);
+
+	delete_area(area);
+}
+
+
+static void
+test_refused(const char* name, uint32 lock, uint32 protection)
+{
+	void* address;
+	area_id area = create_area(name, &address, B_ANY_ADDRESS, kAreaSize, lock,
+		B_READ_AREA | B_WRITE_AREA | B_LARGE_PAGE_AREA | protection);
+	if (area != B_BAD_VALUE) {
+		printf("%s: creating the area did not fail with B_BAD_VALUE: %s\n",
+			name, strerror(area));
+		sFailures++;
+		if (area >= 0)
+			delete_area(area);
+	}
+}
+
+
+int
+main()
+{
+	test("large page full lock", B_FULL_LOCK);
+	test("large page contiguous", B_CONTIGUOUS);
+	test("large page no lock", B_NO_LOCK);
+	test_copy_on_write();
+
+	// these areas are not populated when they are created
+	test_refused("large page overcommitting", B_NO_LOCK,
+		B_OVERCOMMITTING_AREA);
+	test_refused("large page lazy lock", B_LAZY_LOCK, 0);
+
+	if (sFailures != 0) {
+		printf("%" B_PRId32 " tests failed!\n", sFailures);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how long it takes to launch a program and wait for it to exit,
+	/bin/true by default. It also starts itself once to print the minor and
+	major page faults a team incurs until main() is reached. Comparing the
+	results with fault-around enabled and disabled (see the "fault_around"
+	KDL command) shows what it saves during startup.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <image.h>
+#include <OS.h>
+
+#include <extended_system_info.h>
+#include <extended_system_info_defs.h>
+#include <util/KMessage.h>
+
+
+static const char* const kFaultsArgument = "--print-faults";
+
+
+static int
+print_faults()
+{
+	KMessage info;
+	status_t error = BPrivate::get_extended_team_info(getpid(),
+		B_TEAM_INFO_BASIC, info);
+	if (error != B_OK) {
+		fprintf(stderr, "Failed to get the team info: %s\n", strerror(error));
+		return 1;
+	}
+
+	int64 minorFaults;
+	int64 majorFaults;
+	if (info.FindInt64("minor faults", &minorFaults) != B_OK
+		|| info.FindInt64("major faults", &majorFaults) != B_OK) {
+		fprintf(stderr, "The kernel doesn't count page faults per team.\n");
+		return 1;
+	}
+
+	printf("page faults until main(): %" B_PRId64 " minor, %" B_PRId64
+		" major\n", minorFaults, majorFaults);
+	return 0;
+}
+
+
+static bigtime_t
+launch(int argc, const char** argv)
+{
+	bigtime_t startTime = system_time();
+
+	thread_id thread = load_image(argc, argv, (const char**)environ);
+	if (thread < 0) {
+		fprintf(stderr, "Failed to launch \"%s\": %s\n", argv[0],
+			strerror(thread));
+		exit(1);
+	}
+
+	status_t result;
+	wait_for_thread(thread, &result);
+
+	return system_time() - startTime;
+}
+
+
+int
+main(int argc, const char** argv)
+{
+	if (argc == 2 && strcmp(argv[1], kFaultsArgument) == 0)
+		return print_faults();
+
+	if (argc > 1 && (strcmp(argv[1], "-h") == 0
+			|| strcmp(argv[1], "--help") == 0)) {
+		fprintf(stderr, "Usage: %s [ <count> [ <program> [ <arguments> ] ] ]\n",
+			argv[0]);
+		return 1;
+	}
+
+	int32 count = argc > 1 ? atoi(argv[1]) : 100;
+	const char* defaultArgs[] = { "/bin/true", NULL };
+	const char** programArgs = argc > 2 ? argv + 2 : defaultArgs;
+	int programArgCount = argc > 2 ? argc - 2 : 1;
+
+	if (count <= 0) {
+		fprintf(stderr, "Invalid count \"%s\"\n", argv[1]);
+		return 1;
+	}
+
+	// the first launch fills the file cache
+	launch(programArgCount, programArgs);
+
+	bigtime_t totalTime = 0;
+	bigtime_t minTime = B_INFINITE_TIMEOUT;
+	for (int32 i = 0; i < count; i++) {
+		bigtime_t time = launch(programArgCount, programArgs);
+		totalTime += time;
+		if (time < minTime)
+			minTime = time;
+	}
+
+	printf("%s: %" B_PRId32 " launches, %" B_PRId64 " us average, %" B_PRId64
+		" us minimum\n", programArgs[0], count, totalTime / count, minTime);
+
+	// launch ourselves to see the faults it took to get here
+	image_info info;
+	int32 cookie = 0;
+	while (get_next_image_info(B_CURRENT_TEAM, &cookie, &info) == B_OK) {
+		if (info.type == B_APP_IMAGE) {
+			const char* faultsArgs[] = { info.name, kFaultsArgument, NULL };
+			launch(2, faultsArgs);
+			break;
+		}
+	}
+
+	return 0;
+}
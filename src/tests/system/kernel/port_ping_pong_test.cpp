@@ -0,0 +1,133 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the round trip time of messages sent back and forth between two
+	threads over a pair of ports, for different message sizes. The echoing
+	thread either waits in read_port() directly, or first waits for the
+	message size with port_buffer_size(), like BLooper does. Every message is
+	checked to come back unchanged.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const size_t kMessageSizes[] = { 0, 64, 256, 1024, 4096, 16384 };
+static const int32 kRoundTrips = 50000;
+
+static port_id sRequestPort;
+static port_id sReplyPort;
+static bool sQueryBufferSize;
+
+
+static status_t
+echo_thread(void*)
+{
+	char* buffer = (char*)malloc(65536);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	while (true) {
+		ssize_t size;
+		if (sQueryBufferSize) {
+			size = port_buffer_size(sRequestPort);
+			if (size < 0)
+				break;
+		} else
+			size = 65536;
+
+		int32 code;
+		size = read_port(sRequestPort, &code, buffer, size);
+		if (size < 0)
+			break;
+
+		if (write_port(sReplyPort, code, buffer, size) != B_OK)
+			break;
+	}
+
+	free(buffer);
+	return B_OK;
+}
+
+
+static bool
+run(size_t messageSize, bool queryBufferSize)
+{
+	sRequestPort = create_port(1, "ping pong request");
+	sReplyPort = create_port(1, "ping pong reply");
+	sQueryBufferSize = queryBufferSize;
+
+	thread_id thread = spawn_thread(echo_thread, "ping pong echo",
+		B_NORMAL_PRIORITY, NULL);
+	resume_thread(thread);
+
+	char* message = (char*)malloc(messageSize + 1);
+	char* reply = (char*)malloc(messageSize + 1);
+	for (size_t i = 0; i < messageSize; i++)
+		message[i] = (char)i;
+
+	bool ok = true;
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < kRoundTrips; i++) {
+		if (messageSize > 0)
+			message[0] = (char)i;
+
+		if (write_port(sRequestPort, i, message, messageSize) != B_OK) {
+			ok = false;
+			break;
+		}
+
+		int32 code;
+		ssize_t size = read_port(sReplyPort, &code, reply, messageSize);
+		if (size != (ssize_t)messageSize || code != i
+			|| memcmp(message, reply, messageSize) != 0) {
+			ok = false;
+			break;
+		}
+	}
+
+	bigtime_t time = system_time() - startTime;
+
+	delete_port(sRequestPort);
+	delete_port(sReplyPort);
+
+	status_t result;
+	wait_for_thread(thread, &result);
+
+	free(message);
+	free(reply);
+
+	printf("%6lu bytes, %-16s %8.2f us per round trip\n",
+		(unsigned long)messageSize,
+		queryBufferSize ? "port_buffer_size" : "read_port",
+		1.0 * time / kRoundTrips);
+
+	return ok;
+}
+
+
+int
+main()
+{
+	bool ok = true;
+	for (size_t i = 0; i < sizeof(kMessageSizes) / sizeof(kMessageSizes[0]);
+			i++) {
+		ok &= run(kMessageSizes[i], false);
+		ok &= run(kMessageSizes[i], true);
+	}
+
+	if (!ok) {
+		fprintf(stderr, "Messages got lost or corrupted!\n");
+		return 1;
+	}
+
+	return 0;
+}
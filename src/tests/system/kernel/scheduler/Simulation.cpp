@@ -0,0 +1,566 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "Simulation.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <cpu.h>
+#include <thread.h>
+
+
+enum {
+	EVENT_WAKE_UP,
+	EVENT_BURST_END,
+	EVENT_TIMER,
+	EVENT_RESCHEDULE
+};
+
+
+Simulation* Simulation::sCurrent;
+
+
+Simulation::Simulation(const SimulationOptions& options,
+	const Workload& workload)
+	:
+	fOptions(options),
+	fWorkload(workload),
+	fCPUCount(0),
+	fNow(0),
+	fCurrentCPU(0),
+	fNextSequence(0),
+	fIdleThreads(NULL),
+	fThreads(NULL),
+	fThreadCount(0),
+	fBurstGeneration(NULL),
+	fBusyTime(NULL),
+	fCoreWork(NULL),
+	fPackageWork(NULL)
+{
+	memset(&fTeam, 0, sizeof(fTeam));
+	memset(&fResult, 0, sizeof(fResult));
+}
+
+
+Simulation::~Simulation()
+{
+	if (sCurrent == this)
+		sCurrent = NULL;
+
+	delete[] fIdleThreads;
+	delete[] fThreads;
+	delete[] fBurstGeneration;
+	delete[] fBusyTime;
+	delete[] fCoreWork;
+	delete[] fPackageWork;
+}
+
+
+/*!	Runs the whole simulation. Since the scheduler keeps its state in
+	globals and can be initialized only once, this may be called only once
+	per process.
+*/
+status_t
+Simulation::Run(scheduler_mode mode, SimulationResult& result)
+{
+	if (sCurrent != NULL)
+		return B_NOT_ALLOWED;
+	sCurrent = this;
+
+	status_t status = _Init(mode);
+	if (status != B_OK)
+		return status;
+
+	while (!fEvents.empty()) {
+		Event event = fEvents.top();
+		if (event.time > fOptions.duration)
+			break;
+		fEvents.pop();
+
+		fNow = event.time;
+		fCurrentCPU = event.cpu;
+		_HandleEvent(event);
+
+		// this is where the kernel would leave the interrupt handler
+		if (gCPU[fCurrentCPU].invoke_scheduler)
+			_Reschedule(fCurrentCPU, B_THREAD_READY);
+	}
+
+	fNow = fOptions.duration;
+	for (int32 i = 0; i < fCPUCount; i++)
+		_AccountRunTime(i);
+
+	_ComputeResult(result);
+	return B_OK;
+}
+
+
+void
+Simulation::AddTimer(timer* timer, bigtime_t time)
+{
+	uint64 sequence = fNextSequence;
+	fTimers[timer] = sequence;
+
+	_AddEvent(time, EVENT_TIMER, timer->cpu, NULL, 0, timer, sequence);
+}
+
+
+bool
+Simulation::CancelTimer(timer* timer)
+{
+	// the event stays in the queue, but is ignored
+	return fTimers.erase(timer) != 0;
+}
+
+
+void
+Simulation::SendReschedule(int32 cpu)
+{
+	_AddEvent(fNow, EVENT_RESCHEDULE, cpu, NULL);
+}
+
+
+Thread*
+Simulation::GetThread(thread_id id)
+{
+	if (id > 0 && id <= fCPUCount)
+		return &fIdleThreads[id - 1];
+	if (id > fCPUCount && id <= fCPUCount + fThreadCount)
+		return &fThreads[id - fCPUCount - 1].thread;
+	return NULL;
+}
+
+
+void
+Simulation::MapThreads(void (*function)(Thread* thread, void* data),
+	void* data)
+{
+	for (int32 i = 0; i < fCPUCount; i++)
+		function(&fIdleThreads[i], data);
+
+	for (int32 i = 0; i < fThreadCount; i++) {
+		if (!fThreads[i].exited)
+			function(&fThreads[i].thread, data);
+	}
+}
+
+
+// #pragma mark - SchedulerListener
+
+
+void
+Simulation::ThreadEnqueuedInRunQueue(Thread* thread)
+{
+}
+
+
+void
+Simulation::ThreadRemovedFromRunQueue(Thread* thread)
+{
+}
+
+
+void
+Simulation::ThreadScheduled(Thread* oldThread, Thread* newThread)
+{
+	if (oldThread == newThread)
+		return;
+
+	fResult.contextSwitches++;
+
+	SimulatedThread* thread = (SimulatedThread*)newThread->simulator_data;
+	if (thread == NULL)
+		return;
+
+	fResult.dispatches++;
+
+	int32 threadClass = thread->description->threadClass;
+	if (thread->wokenUp >= 0) {
+		fLatencies[threadClass].push_back(fNow - thread->wokenUp);
+		thread->wokenUp = -1;
+	}
+
+	// the first dispatch of a thread doesn't find anything in the caches
+	int32 lastCPU = thread->lastCPU;
+	if (lastCPU < 0)
+		return;
+
+	int32 cpu = fCurrentCPU;
+	int32 core = _CoreOf(cpu);
+	int32 package = _PackageOf(cpu);
+
+	if (_PackageOf(lastCPU) != package)
+		fResult.packageMigrations++;
+	else if (_CoreOf(lastCPU) != core)
+		fResult.coreMigrations++;
+	else if (lastCPU != cpu)
+		fResult.cpuMigrations++;
+
+	bigtime_t refillTime = 0;
+	if (_CoreOf(lastCPU) == core
+		&& fCoreWork[core] - thread->coreWorkWhenLeft
+			<= fOptions.coreCacheWindow) {
+		fResult.warmDispatches++;
+	} else if (_PackageOf(lastCPU) == package
+		&& fPackageWork[package] - thread->packageWorkWhenLeft
+			<= fOptions.packageCacheWindow) {
+		fResult.coreColdDispatches++;
+		refillTime = fOptions.coreRefillTime;
+	} else {
+		fResult.packageColdDispatches++;
+		refillTime = fOptions.packageRefillTime;
+	}
+
+	fResult.refillTime += refillTime;
+	if (fOptions.chargeRefill)
+		thread->remaining += refillTime;
+}
+
+
+// #pragma mark - private
+
+
+status_t
+Simulation::_Init(scheduler_mode mode)
+{
+	kernel_emu_init_cpus(fOptions.packages, fOptions.coresPerPackage,
+		fOptions.threadsPerCore);
+
+	fCPUCount = smp_get_num_cpus();
+	fThreadCount = fWorkload.CountThreads();
+
+	fIdleThreads = new Thread[fCPUCount];
+	fThreads = new SimulatedThread[fThreadCount];
+	fBurstGeneration = new uint32[fCPUCount];
+	fBusyTime = new bigtime_t[fCPUCount];
+	fCoreWork = new bigtime_t[fOptions.packages * fOptions.coresPerPackage];
+	fPackageWork = new bigtime_t[fOptions.packages];
+
+	memset(fBurstGeneration, 0, sizeof(uint32) * fCPUCount);
+	memset(fBusyTime, 0, sizeof(bigtime_t) * fCPUCount);
+	memset(fCoreWork, 0,
+		sizeof(bigtime_t) * fOptions.packages * fOptions.coresPerPackage);
+	memset(fPackageWork, 0, sizeof(bigtime_t) * fOptions.packages);
+
+	B_INITIALIZE_SPINLOCK(&fTeam.time_lock);
+
+	// boot: the current thread of each CPU is its idle thread
+	fCurrentCPU = 0;
+	scheduler_init();
+
+	status_t status = scheduler_set_operation_mode(mode);
+	if (status != B_OK)
+		return status;
+
+	for (int32 i = 0; i < fCPUCount; i++) {
+		Thread* thread = &fIdleThreads[i];
+		_InitThread(thread, i + 1, "idle thread", B_IDLE_PRIORITY);
+		thread->state = B_THREAD_RUNNING;
+		thread->cpu = &gCPU[i];
+		gCPU[i].running_thread = thread;
+
+		status = scheduler_on_thread_create(thread, true);
+		if (status != B_OK)
+			return status;
+	}
+
+	for (int32 i = 0; i < fCPUCount; i++)
+		scheduler_on_thread_init(&fIdleThreads[i]);
+
+	// The workload's threads are created by the boot thread on CPU 0, and
+	// started at their start time.
+	for (int32 i = 0; i < fThreadCount; i++) {
+		SimulatedThread* thread = &fThreads[i];
+		thread->description = &fWorkload.ThreadAt(i);
+		thread->phase = 0;
+		thread->remaining = thread->description->phases[0].run;
+		thread->runningSince = -1;
+		thread->wokenUp = -1;
+		thread->exited = false;
+		thread->exitTime = -1;
+		thread->lastCPU = -1;
+		thread->coreWorkWhenLeft = 0;
+		thread->packageWorkWhenLeft = 0;
+
+		_InitThread(&thread->thread, fCPUCount + i + 1,
+			thread->description->name, thread->description->priority);
+		thread->thread.simulator_data = thread;
+
+		status = scheduler_on_thread_create(&thread->thread, false);
+		if (status != B_OK)
+			return status;
+		scheduler_on_thread_init(&thread->thread);
+
+		_AddEvent(thread->description->start, EVENT_WAKE_UP, 0, thread);
+	}
+
+	scheduler_add_listener(this);
+	scheduler_enable_scheduling();
+
+	for (int32 i = 0; i < fCPUCount; i++) {
+		fCurrentCPU = i;
+		gCPU[i].invoke_scheduler = false;
+		scheduler_start();
+	}
+
+	return B_OK;
+}
+
+
+void
+Simulation::_InitThread(Thread* thread, thread_id id, const char* name,
+	int32 priority)
+{
+	memset(thread, 0, sizeof(Thread));
+
+	thread->id = id;
+	thread->name = name;
+	thread->priority = priority;
+	thread->state = B_THREAD_SUSPENDED;
+	thread->team = &fTeam;
+	B_INITIALIZE_SPINLOCK(&thread->scheduler_lock);
+	B_INITIALIZE_SPINLOCK(&thread->time_lock);
+}
+
+
+void
+Simulation::_AddEvent(bigtime_t time, int32 type, int32 cpu,
+	SimulatedThread* thread, uint32 generation, timer* kernelTimer,
+	uint64 timerSequence)
+{
+	Event event;
+	event.time = time;
+	event.sequence = fNextSequence++;
+	event.type = type;
+	event.cpu = cpu;
+	event.thread = thread;
+	event.generation = generation;
+	event.kernelTimer = kernelTimer;
+	event.timerSequence = timerSequence;
+
+	fEvents.push(event);
+}
+
+
+void
+Simulation::_HandleEvent(const Event& event)
+{
+	switch (event.type) {
+		case EVENT_WAKE_UP:
+			_WakeUp(event.thread, event.cpu);
+			break;
+
+		case EVENT_BURST_END:
+			// the thread might have been preempted in the meantime
+			if (event.generation == fBurstGeneration[event.cpu])
+				_BurstEnded(event.cpu);
+			break;
+
+		case EVENT_TIMER:
+		{
+			TimerMap::iterator it = fTimers.find(event.kernelTimer);
+			if (it == fTimers.end() || it->second != event.timerSequence)
+				break;
+			fTimers.erase(it);
+
+			timer* kernelTimer = event.kernelTimer;
+			if (kernelTimer->hook(kernelTimer) == B_INVOKE_SCHEDULER)
+				gCPU[event.cpu].invoke_scheduler = true;
+			break;
+		}
+
+		case EVENT_RESCHEDULE:
+			scheduler_reschedule_ici();
+			break;
+	}
+}
+
+
+void
+Simulation::_WakeUp(SimulatedThread* thread, int32 cpu)
+{
+	if (fOptions.verbose) {
+		printf("%10" B_PRId64 " cpu %2" B_PRId32 ": wake up %s\n", fNow, cpu,
+			thread->description->name);
+	}
+
+	thread->wokenUp = fNow;
+	fResult.wakeUps[thread->description->threadClass]++;
+
+	scheduler_enqueue_in_run_queue(&thread->thread);
+}
+
+
+void
+Simulation::_BurstEnded(int32 cpu)
+{
+	SimulatedThread* thread
+		= (SimulatedThread*)gCPU[cpu].running_thread->simulator_data;
+	const ThreadDescription* description = thread->description;
+
+	_AccountRunTime(cpu);
+
+	bigtime_t sleep = description->phases[thread->phase].sleep;
+	if (++thread->phase == description->phases.size()) {
+		if (!description->repeat) {
+			if (fOptions.verbose) {
+				printf("%10" B_PRId64 " cpu %2" B_PRId32 ": %s exits\n", fNow,
+					cpu, description->name);
+			}
+
+			thread->exited = true;
+			thread->exitTime = fNow;
+			_Reschedule(cpu, THREAD_STATE_FREE_ON_RESCHED);
+			return;
+		}
+
+		thread->phase = 0;
+	}
+
+	thread->remaining = description->phases[thread->phase].run;
+
+	if (sleep == 0) {
+		_Dispatch(cpu);
+		return;
+	}
+
+	_Reschedule(cpu, B_THREAD_WAITING);
+
+	// the thread is woken up by a timer on the CPU it went to sleep on
+	_AddEvent(fNow + sleep, EVENT_WAKE_UP, cpu, thread);
+}
+
+
+void
+Simulation::_Reschedule(int32 cpu, int32 nextState)
+{
+	_AccountRunTime(cpu);
+
+	Thread* oldThread = gCPU[cpu].running_thread;
+	gCPU[cpu].invoke_scheduler = false;
+
+	scheduler_reschedule(nextState);
+
+	Thread* newThread = gCPU[cpu].running_thread;
+	if (newThread != oldThread) {
+		// see arch_thread_context_switch()
+		oldThread->cpu = NULL;
+
+		SimulatedThread* thread = (SimulatedThread*)oldThread->simulator_data;
+		if (thread != NULL) {
+			thread->runningSince = -1;
+			thread->lastCPU = cpu;
+			thread->coreWorkWhenLeft = fCoreWork[_CoreOf(cpu)];
+			thread->packageWorkWhenLeft = fPackageWork[_PackageOf(cpu)];
+		}
+
+		if (fOptions.verbose) {
+			printf("%10" B_PRId64 " cpu %2" B_PRId32 ": %s -> %s\n", fNow,
+				cpu, oldThread->name, newThread->name);
+		}
+	}
+
+	_Dispatch(cpu);
+}
+
+
+void
+Simulation::_AccountRunTime(int32 cpu)
+{
+	SimulatedThread* thread
+		= (SimulatedThread*)gCPU[cpu].running_thread->simulator_data;
+	if (thread == NULL || thread->runningSince < 0)
+		return;
+
+	bigtime_t runTime = fNow - thread->runningSince;
+	thread->runningSince = fNow;
+	thread->remaining -= runTime;
+
+	fBusyTime[cpu] += runTime;
+	fCoreWork[_CoreOf(cpu)] += runTime;
+	fPackageWork[_PackageOf(cpu)] += runTime;
+	fResult.cpuTime[thread->description->threadClass] += runTime;
+}
+
+
+/*!	Lets the thread the scheduler chose for \a cpu run until its current
+	burst ends, unless something happens in the meantime.
+*/
+void
+Simulation::_Dispatch(int32 cpu)
+{
+	fBurstGeneration[cpu]++;
+
+	SimulatedThread* thread
+		= (SimulatedThread*)gCPU[cpu].running_thread->simulator_data;
+	if (thread == NULL)
+		return;
+
+	thread->runningSince = fNow;
+	_AddEvent(fNow + std::max(thread->remaining, bigtime_t(0)),
+		EVENT_BURST_END, cpu, thread, fBurstGeneration[cpu]);
+}
+
+
+void
+Simulation::_ComputeResult(SimulationResult& result)
+{
+	fResult.duration = fOptions.duration;
+	fResult.cpuCount = fCPUCount;
+
+	for (int32 i = 0; i < fCPUCount; i++)
+		fResult.busyTime += fBusyTime[i];
+
+	for (int32 i = 0; i < THREAD_CLASS_COUNT; i++) {
+		std::vector<bigtime_t>& latencies = fLatencies[i];
+		if (latencies.empty())
+			continue;
+
+		std::sort(latencies.begin(), latencies.end());
+
+		static const int32 kPercentiles[] = { 50, 90, 99, 100 };
+		for (int32 j = 0; j < PERCENTILE_COUNT; j++) {
+			// nearest rank
+			size_t rank = (latencies.size() * kPercentiles[j] + 99) / 100;
+			fResult.latency[i][j] = latencies[std::max(rank, size_t(1)) - 1];
+		}
+	}
+
+	for (int32 i = 0; i < fThreadCount; i++) {
+		const SimulatedThread& thread = fThreads[i];
+		if (thread.description->threadClass != THREAD_CLASS_BATCH)
+			continue;
+
+		fResult.batchThreads++;
+		if (!thread.exited)
+			continue;
+
+		bigtime_t completion = thread.exitTime - thread.description->start;
+		fResult.batchThreadsFinished++;
+		fResult.batchCompletionTotal += completion;
+		fResult.batchCompletionMax
+			= std::max(fResult.batchCompletionMax, completion);
+	}
+
+	result = fResult;
+}
+
+
+int32
+Simulation::_CoreOf(int32 cpu) const
+{
+	return cpu / fOptions.threadsPerCore;
+}
+
+
+int32
+Simulation::_PackageOf(int32 cpu) const
+{
+	return cpu / (fOptions.threadsPerCore * fOptions.coresPerPackage);
+}
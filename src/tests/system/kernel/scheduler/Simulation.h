@@ -0,0 +1,225 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+
+#include <map>
+#include <queue>
+#include <vector>
+
+#include <OS.h>
+
+#include <kscheduler.h>
+#include <listeners.h>
+
+#include "Workload.h"
+
+
+struct SimulationOptions {
+	int32			packages;
+	int32			coresPerPackage;
+	int32			threadsPerCore;
+
+	bigtime_t		duration;
+
+	// How much other work may run on a core or a package until the data a
+	// thread left in its caches is considered gone.
+	bigtime_t		coreCacheWindow;
+	bigtime_t		packageCacheWindow;
+
+	// Estimated time a thread needs to refill its caches after having lost
+	// them, and whether the simulated threads are charged for it.
+	bigtime_t		coreRefillTime;
+	bigtime_t		packageRefillTime;
+	bool			chargeRefill;
+
+	bool			verbose;
+};
+
+
+enum {
+	PERCENTILE_50,
+	PERCENTILE_90,
+	PERCENTILE_99,
+	PERCENTILE_MAX,
+
+	PERCENTILE_COUNT
+};
+
+
+/*!	Plain data, so that it can be passed from the process that ran the
+	simulation to the one that compares the scheduler modes.
+*/
+struct SimulationResult {
+	bigtime_t		duration;
+	int32			cpuCount;
+
+	bigtime_t		busyTime;
+	int64			contextSwitches;
+	int64			dispatches;
+
+	int64			wakeUps[THREAD_CLASS_COUNT];
+	bigtime_t		latency[THREAD_CLASS_COUNT][PERCENTILE_COUNT];
+	bigtime_t		cpuTime[THREAD_CLASS_COUNT];
+
+	// dispatches on another logical CPU of the same core, on another core
+	// of the same package, and on another package than the previous one
+	int64			cpuMigrations;
+	int64			coreMigrations;
+	int64			packageMigrations;
+
+	// how the caches were found when a thread was dispatched again
+	int64			warmDispatches;
+	int64			coreColdDispatches;
+	int64			packageColdDispatches;
+	bigtime_t		refillTime;
+
+	int32			batchThreads;
+	int32			batchThreadsFinished;
+	bigtime_t		batchCompletionTotal;
+	bigtime_t		batchCompletionMax;
+};
+
+
+/*!	Runs a workload on the unchanged kernel scheduler in simulated time.
+	Everything happens in the order of a single event queue, so that runs
+	with the same workload and options always give the same results.
+*/
+class Simulation : private SchedulerListener {
+public:
+								Simulation(const SimulationOptions& options,
+									const Workload& workload);
+	virtual						~Simulation();
+
+			status_t			Run(scheduler_mode mode,
+									SimulationResult& result);
+
+	static	Simulation*			Current()	{ return sCurrent; }
+
+			bigtime_t			Now() const	{ return fNow; }
+			int32				CurrentCPU() const	{ return fCurrentCPU; }
+			int32				CPUCount() const	{ return fCPUCount; }
+			bool				Verbose() const	{ return fOptions.verbose; }
+
+			// services of the emulated kernel
+			void				AddTimer(timer* timer, bigtime_t time);
+			bool				CancelTimer(timer* timer);
+			void				SendReschedule(int32 cpu);
+			Thread*				GetThread(thread_id id);
+			void				MapThreads(
+									void (*function)(Thread* thread,
+										void* data),
+									void* data);
+
+private:
+			struct SimulatedThread {
+				Thread				thread;
+				const ThreadDescription* description;
+
+				size_t				phase;
+				bigtime_t			remaining;
+				bigtime_t			runningSince;
+				bigtime_t			wokenUp;
+				bool				exited;
+				bigtime_t			exitTime;
+
+				// where the thread ran last, and how much work its core and
+				// package had done when it left
+				int32				lastCPU;
+				bigtime_t			coreWorkWhenLeft;
+				bigtime_t			packageWorkWhenLeft;
+			};
+
+			struct Event {
+				bigtime_t			time;
+				uint64				sequence;
+				int32				type;
+				int32				cpu;
+				SimulatedThread*	thread;
+				uint32				generation;
+				timer*				kernelTimer;
+				uint64				timerSequence;
+			};
+
+			struct EventCompare {
+				bool operator()(const Event& a, const Event& b) const
+				{
+					if (a.time != b.time)
+						return a.time > b.time;
+					return a.sequence > b.sequence;
+				}
+			};
+
+			typedef std::priority_queue<Event, std::vector<Event>,
+				EventCompare> EventQueue;
+			typedef std::map<timer*, uint64> TimerMap;
+
+	// SchedulerListener
+	virtual	void				ThreadEnqueuedInRunQueue(Thread* thread);
+	virtual	void				ThreadRemovedFromRunQueue(Thread* thread);
+	virtual	void				ThreadScheduled(Thread* oldThread,
+									Thread* newThread);
+
+			status_t			_Init(scheduler_mode mode);
+			void				_InitThread(Thread* thread, thread_id id,
+									const char* name, int32 priority);
+
+			void				_AddEvent(bigtime_t time, int32 type,
+									int32 cpu, SimulatedThread* thread,
+									uint32 generation = 0,
+									timer* kernelTimer = NULL,
+									uint64 timerSequence = 0);
+			void				_HandleEvent(const Event& event);
+
+			void				_WakeUp(SimulatedThread* thread, int32 cpu);
+			void				_BurstEnded(int32 cpu);
+			void				_Reschedule(int32 cpu, int32 nextState);
+
+			void				_AccountRunTime(int32 cpu);
+			void				_Dispatch(int32 cpu);
+
+			void				_ComputeResult(SimulationResult& result);
+
+			int32				_CoreOf(int32 cpu) const;
+			int32				_PackageOf(int32 cpu) const;
+
+private:
+	static	Simulation*			sCurrent;
+
+			SimulationOptions	fOptions;
+			const Workload&		fWorkload;
+			int32				fCPUCount;
+
+			bigtime_t			fNow;
+			int32				fCurrentCPU;
+			EventQueue			fEvents;
+			uint64				fNextSequence;
+			TimerMap			fTimers;
+
+			Team				fTeam;
+			Thread*				fIdleThreads;
+			SimulatedThread*	fThreads;
+			int32				fThreadCount;
+
+			// per CPU
+			uint32*				fBurstGeneration;
+			bigtime_t*			fBusyTime;
+
+			// all work done so far by the cores and packages
+			bigtime_t*			fCoreWork;
+			bigtime_t*			fPackageWork;
+
+			std::vector<bigtime_t> fLatencies[THREAD_CLASS_COUNT];
+			SimulationResult	fResult;
+};
+
+
+// kernel_emu.cpp
+void kernel_emu_init_cpus(int32 packages, int32 coresPerPackage,
+	int32 threadsPerCore);
+
+
+#endif	// SIMULATION_H
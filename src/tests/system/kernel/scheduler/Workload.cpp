@@ -0,0 +1,245 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "Workload.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char* const kClassNames[THREAD_CLASS_COUNT] = {
+	"latency",
+	"batch"
+};
+
+static const int32 kLatencyPriorities[] = {
+	B_NORMAL_PRIORITY,
+	B_DISPLAY_PRIORITY,
+	B_URGENT_DISPLAY_PRIORITY,
+	B_REAL_TIME_DISPLAY_PRIORITY
+};
+
+static const int32 kLatencyPhaseCount = 8;
+
+
+/*!	A small xorshift generator, so that the same seed gives the same workload
+	on every host.
+*/
+class WorkloadRandom {
+public:
+	WorkloadRandom(uint32 seed)
+		:
+		fState(seed != 0 ? seed : 0x9e3779b9)
+	{
+	}
+
+	uint32 Next()
+	{
+		fState ^= fState << 13;
+		fState ^= fState >> 17;
+		fState ^= fState << 5;
+		return fState;
+	}
+
+	bigtime_t Between(bigtime_t min, bigtime_t max)
+	{
+		return min + Next() % (max - min + 1);
+	}
+
+private:
+	uint32	fState;
+};
+
+
+Workload::Workload()
+{
+}
+
+
+status_t
+Workload::Load(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Could not open workload \"%s\"\n", path);
+		return B_ENTRY_NOT_FOUND;
+	}
+
+	fThreads.clear();
+
+	char line[4096];
+	int32 lineNumber = 0;
+	status_t status = B_OK;
+	while (status == B_OK && fgets(line, sizeof(line), file) != NULL) {
+		lineNumber++;
+		status = _ParseLine(line, lineNumber);
+	}
+
+	fclose(file);
+
+	if (status == B_OK && fThreads.empty()) {
+		fprintf(stderr, "%s: no threads defined\n", path);
+		return B_BAD_DATA;
+	}
+
+	return status;
+}
+
+
+void
+Workload::Generate(uint32 seed, int32 latencyThreads, int32 batchThreads,
+	bigtime_t duration)
+{
+	WorkloadRandom random(seed);
+	fThreads.clear();
+
+	// Latency sensitive threads run briefly after having waited for input,
+	// a timer, or another thread, and come back periodically.
+	for (int32 i = 0; i < latencyThreads; i++) {
+		ThreadDescription thread;
+		snprintf(thread.name, sizeof(thread.name), "latency_%" B_PRId32, i);
+		thread.priority = kLatencyPriorities[random.Next()
+			% (sizeof(kLatencyPriorities) / sizeof(kLatencyPriorities[0]))];
+		thread.threadClass = THREAD_CLASS_LATENCY;
+		thread.start = random.Between(0, 20000);
+		thread.repeat = true;
+
+		bigtime_t period = random.Between(1000, 20000);
+		for (int32 j = 0; j < kLatencyPhaseCount; j++) {
+			ThreadPhase phase;
+			phase.run = random.Between(20, 500);
+			phase.sleep = period + random.Between(0, period / 4);
+			thread.phases.push_back(phase);
+		}
+
+		fThreads.push_back(thread);
+	}
+
+	// Batch threads compute in long bursts with short waits for I/O in
+	// between, and exit when their work is done.
+	for (int32 i = 0; i < batchThreads; i++) {
+		ThreadDescription thread;
+		snprintf(thread.name, sizeof(thread.name), "batch_%" B_PRId32, i);
+		thread.priority = random.Next() % 2 == 0
+			? B_LOW_PRIORITY : B_NORMAL_PRIORITY;
+		thread.threadClass = THREAD_CLASS_BATCH;
+		thread.start = random.Between(0, duration / 10);
+		thread.repeat = false;
+
+		bigtime_t work = random.Between(duration / 8, duration / 3);
+		while (work > 0) {
+			ThreadPhase phase;
+			phase.run = min_c(random.Between(2000, 20000), work);
+			phase.sleep = random.Between(0, 500);
+			thread.phases.push_back(phase);
+
+			work -= phase.run;
+		}
+
+		fThreads.push_back(thread);
+	}
+}
+
+
+void
+Workload::Write(FILE* file) const
+{
+	fprintf(file, "# <name> <priority> latency|batch <start> <run>/<sleep>..."
+		" [repeat]\n");
+
+	for (size_t i = 0; i < fThreads.size(); i++) {
+		const ThreadDescription& thread = fThreads[i];
+		fprintf(file, "%s %" B_PRId32 " %s %" B_PRId64, thread.name,
+			thread.priority, ClassName(thread.threadClass), thread.start);
+
+		for (size_t j = 0; j < thread.phases.size(); j++) {
+			fprintf(file, " %" B_PRId64 "/%" B_PRId64, thread.phases[j].run,
+				thread.phases[j].sleep);
+		}
+
+		fprintf(file, "%s\n", thread.repeat ? " repeat" : "");
+	}
+}
+
+
+/*static*/ const char*
+Workload::ClassName(int32 threadClass)
+{
+	return kClassNames[threadClass];
+}
+
+
+status_t
+Workload::_ParseLine(char* line, int32 lineNumber)
+{
+	const char* const kSeparators = " \t\r\n";
+
+	char* name = strtok(line, kSeparators);
+	if (name == NULL || name[0] == '#')
+		return B_OK;
+
+	ThreadDescription thread;
+	strlcpy(thread.name, name, sizeof(thread.name));
+	thread.repeat = false;
+
+	const char* priority = strtok(NULL, kSeparators);
+	const char* threadClass = strtok(NULL, kSeparators);
+	const char* start = strtok(NULL, kSeparators);
+	if (priority == NULL || threadClass == NULL || start == NULL) {
+		fprintf(stderr, "line %" B_PRId32 ": expected priority, class, and "
+			"start time\n", lineNumber);
+		return B_BAD_DATA;
+	}
+
+	thread.priority = atoi(priority);
+	if (thread.priority < B_LOWEST_ACTIVE_PRIORITY
+		|| thread.priority > B_REAL_TIME_PRIORITY) {
+		fprintf(stderr, "line %" B_PRId32 ": invalid priority %s\n",
+			lineNumber, priority);
+		return B_BAD_DATA;
+	}
+
+	thread.threadClass = -1;
+	for (int32 i = 0; i < THREAD_CLASS_COUNT; i++) {
+		if (strcmp(threadClass, kClassNames[i]) == 0)
+			thread.threadClass = i;
+	}
+	if (thread.threadClass < 0) {
+		fprintf(stderr, "line %" B_PRId32 ": unknown thread class \"%s\"\n",
+			lineNumber, threadClass);
+		return B_BAD_DATA;
+	}
+
+	thread.start = strtoll(start, NULL, 10);
+
+	while (const char* token = strtok(NULL, kSeparators)) {
+		if (strcmp(token, "repeat") == 0) {
+			thread.repeat = true;
+			continue;
+		}
+
+		char* end;
+		ThreadPhase phase;
+		phase.run = strtoll(token, &end, 10);
+		phase.sleep = *end == '/' ? strtoll(end + 1, &end, 10) : -1;
+		if (*end != '\0' || phase.run <= 0 || phase.sleep < 0) {
+			fprintf(stderr, "line %" B_PRId32 ": invalid phase \"%s\"\n",
+				lineNumber, token);
+			return B_BAD_DATA;
+		}
+
+		thread.phases.push_back(phase);
+	}
+
+	if (thread.phases.empty()) {
+		fprintf(stderr, "line %" B_PRId32 ": thread \"%s\" has no phases\n",
+			lineNumber, thread.name);
+		return B_BAD_DATA;
+	}
+
+	fThreads.push_back(thread);
+	return B_OK;
+}
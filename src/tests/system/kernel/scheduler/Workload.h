@@ -0,0 +1,75 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+
+#include <stdio.h>
+
+#include <vector>
+
+#include <OS.h>
+
+
+enum thread_class {
+	THREAD_CLASS_LATENCY,
+	THREAD_CLASS_BATCH,
+
+	THREAD_CLASS_COUNT
+};
+
+
+struct ThreadPhase {
+	bigtime_t	run;
+	bigtime_t	sleep;
+};
+
+
+struct ThreadDescription {
+	char		name[B_OS_NAME_LENGTH];
+	int32		priority;
+	int32		threadClass;
+	bigtime_t	start;
+	bool		repeat;
+
+	std::vector<ThreadPhase> phases;
+};
+
+
+/*!	The threads a simulation runs. Each thread alternates between running
+	for and sleeping for the times given by its phases. A thread that
+	doesn't repeat its phases exits after the last one.
+
+	Workloads are either generated, or read from a text file with one thread
+	per line:
+		<name> <priority> latency|batch <start> <run>/<sleep>... [repeat]
+	All times are in microseconds. Empty lines and lines starting with '#'
+	are ignored.
+*/
+class Workload {
+public:
+								Workload();
+
+			status_t			Load(const char* path);
+			void				Generate(uint32 seed, int32 latencyThreads,
+									int32 batchThreads, bigtime_t duration);
+			void				Write(FILE* file) const;
+
+			int32				CountThreads() const
+									{ return fThreads.size(); }
+			const ThreadDescription& ThreadAt(int32 index) const
+									{ return fThreads[index]; }
+
+	static	const char*			ClassName(int32 threadClass);
+
+private:
+			status_t			_ParseLine(char* line, int32 lineNumber);
+
+private:
+			std::vector<ThreadDescription> fThreads;
+};
+
+
+#endif	// WORKLOAD_H
@@ -0,0 +1,432 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	The parts of the kernel the scheduler depends on, implemented on top of
+	the simulation. Interrupts stay disabled while the simulation runs, and
+	since everything happens on a single host thread, the locks don't need
+	to do anything.
+*/
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <KernelExport.h>
+
+#include <cpu.h>
+#include <debug.h>
+#include <int.h>
+#include <smp.h>
+#include <thread.h>
+#include <util/Random.h>
+
+#include "Simulation.h"
+
+
+cpu_ent gCPU[SMP_MAX_CPUS];
+uint32 gCPUCacheLevelCount = 2;
+
+static int32 sCPUCount;
+static cpu_topology_node sTopologyRoot;
+static bool sInterruptsEnabled;
+static uint32 sRandomState = 0x2545f491;
+
+
+static cpu_topology_node*
+new_topology_node(cpu_topology_level level, int id, int childCount)
+{
+	cpu_topology_node* node = new cpu_topology_node;
+	node->level = level;
+	node->id = id;
+	node->children_count = childCount;
+	node->children = childCount > 0
+		? new cpu_topology_node*[childCount] : NULL;
+	return node;
+}
+
+
+/*!	Sets up the CPU structures and the topology tree the way the CPU
+	detection code would on a machine with the given layout. The logical
+	CPUs of a core, and the cores of a package, are numbered consecutively.
+*/
+void
+kernel_emu_init_cpus(int32 packages, int32 coresPerPackage,
+	int32 threadsPerCore)
+{
+	sCPUCount = packages * coresPerPackage * threadsPerCore;
+
+	sTopologyRoot.level = CPU_TOPOLOGY_LEVELS;
+	sTopologyRoot.id = 0;
+	sTopologyRoot.children_count = packages;
+	sTopologyRoot.children = new cpu_topology_node*[packages];
+
+	int32 cpu = 0;
+	for (int32 package = 0; package < packages; package++) {
+		cpu_topology_node* packageNode = new_topology_node(
+			CPU_TOPOLOGY_PACKAGE, package, coresPerPackage);
+		sTopologyRoot.children[package] = packageNode;
+
+		for (int32 core = 0; core < coresPerPackage; core++) {
+			cpu_topology_node* coreNode = new_topology_node(CPU_TOPOLOGY_CORE,
+				package * coresPerPackage + core, threadsPerCore);
+			packageNode->children[core] = coreNode;
+
+			for (int32 smt = 0; smt < threadsPerCore; smt++, cpu++) {
+				coreNode->children[smt] = new_topology_node(CPU_TOPOLOGY_SMT,
+					cpu, 0);
+
+				cpu_ent* entry = &gCPU[cpu];
+				entry->cpu_num = cpu;
+				entry->topology_id[CPU_TOPOLOGY_SMT] = smt;
+				entry->topology_id[CPU_TOPOLOGY_CORE] = core;
+				entry->topology_id[CPU_TOPOLOGY_PACKAGE] = package;
+				list_init(&entry->irqs);
+				B_INITIALIZE_SPINLOCK(&entry->irqs_lock);
+			}
+		}
+	}
+}
+
+
+// #pragma mark - CPUs
+
+
+const cpu_topology_node*
+get_cpu_topology(void)
+{
+	return &sTopologyRoot;
+}
+
+
+void
+cpu_set_scheduler_mode(enum scheduler_mode mode)
+{
+}
+
+
+status_t
+increase_cpu_performance(int delta)
+{
+	// there is no cpufreq module, which also turns off CPU load tracking
+	return B_NOT_SUPPORTED;
+}
+
+
+status_t
+decrease_cpu_performance(int delta)
+{
+	return B_NOT_SUPPORTED;
+}
+
+
+int32
+smp_get_num_cpus(void)
+{
+	return sCPUCount;
+}
+
+
+int32
+smp_get_current_cpu(void)
+{
+	return Simulation::Current()->CurrentCPU();
+}
+
+
+void
+smp_send_ici(int32 targetCPU, int32 message, addr_t data, addr_t data2,
+	addr_t data3, void* dataPointer, uint32 flags)
+{
+	if (message != SMP_MSG_RESCHEDULE)
+		panic("smp_send_ici(): unsupported message %" B_PRId32, message);
+
+	Simulation::Current()->SendReschedule(targetCPU);
+}
+
+
+// #pragma mark - interrupts and locks
+
+
+cpu_status
+disable_interrupts(void)
+{
+	cpu_status state = sInterruptsEnabled;
+	sInterruptsEnabled = false;
+	return state;
+}
+
+
+void
+restore_interrupts(cpu_status status)
+{
+	sInterruptsEnabled = status != 0;
+}
+
+
+bool
+are_interrupts_enabled(void)
+{
+	return sInterruptsEnabled;
+}
+
+
+void
+assign_io_interrupt_to_cpu(long vector, int32 cpu)
+{
+}
+
+
+void
+acquire_spinlock(spinlock* lock)
+{
+}
+
+
+void
+release_spinlock(spinlock* lock)
+{
+}
+
+
+bool
+try_acquire_write_spinlock(rw_spinlock* lock)
+{
+	return true;
+}
+
+
+void
+acquire_write_spinlock(rw_spinlock* lock)
+{
+}
+
+
+void
+release_write_spinlock(rw_spinlock* lock)
+{
+}
+
+
+bool
+try_acquire_read_spinlock(rw_spinlock* lock)
+{
+	return true;
+}
+
+
+void
+acquire_read_spinlock(rw_spinlock* lock)
+{
+}
+
+
+void
+release_read_spinlock(rw_spinlock* lock)
+{
+}
+
+
+bool
+try_acquire_write_seqlock(seqlock* lock)
+{
+	return true;
+}
+
+
+void
+acquire_write_seqlock(seqlock* lock)
+{
+}
+
+
+void
+release_write_seqlock(seqlock* lock)
+{
+}
+
+
+uint32
+acquire_read_seqlock(seqlock* lock)
+{
+	return 0;
+}
+
+
+bool
+release_read_seqlock(seqlock* lock, uint32 count)
+{
+	return true;
+}
+
+
+// #pragma mark - timers
+
+
+bigtime_t
+system_time(void)
+{
+	Simulation* simulation = Simulation::Current();
+	return simulation != NULL ? simulation->Now() : 0;
+}
+
+
+status_t
+add_timer(timer* event, timer_hook hook, bigtime_t period, int32 flags)
+{
+	bigtime_t scheduleTime;
+	switch (flags) {
+		case B_ONE_SHOT_ABSOLUTE_TIMER:
+			scheduleTime = period;
+			break;
+		case B_ONE_SHOT_RELATIVE_TIMER:
+			scheduleTime = system_time() + period;
+			break;
+		default:
+			panic("add_timer(): unsupported timer flags %#" B_PRIx32, flags);
+			return B_BAD_VALUE;
+	}
+
+	event->schedule_time = scheduleTime;
+	event->period = 0;
+	event->hook = hook;
+	event->flags = flags;
+	event->cpu = smp_get_current_cpu();
+
+	Simulation::Current()->AddTimer(event, scheduleTime);
+	return B_OK;
+}
+
+
+bool
+cancel_timer(timer* event)
+{
+	return Simulation::Current()->CancelTimer(event);
+}
+
+
+// #pragma mark - threads
+
+
+/*static*/ Thread*
+Thread::Get(thread_id id)
+{
+	return Simulation::Current()->GetThread(id);
+}
+
+
+void
+thread_map(void (*function)(Thread* thread, void* data), void* data)
+{
+	Simulation::Current()->MapThreads(function, data);
+}
+
+
+void
+arch_thread_context_switch(Thread* from, Thread* to)
+{
+	// In the kernel, "from" continues only when it is scheduled again, and
+	// then has a CPU. Here it returns right away, and the scheduler looks at
+	// its CPU once more. The simulator resets it afterwards.
+	from->cpu = to->cpu;
+}
+
+
+// #pragma mark - random numbers
+
+
+/*!	The simulation has to be reproducible, so all random numbers come from
+	a fixed sequence.
+*/
+unsigned int
+random_value(void)
+{
+	sRandomState = sRandomState * 1103515245 + 12345;
+	return (sRandomState >> 1) & MAX_RANDOM_VALUE;
+}
+
+
+unsigned int
+fast_random_value(void)
+{
+	return random_value() & MAX_FAST_RANDOM_VALUE;
+}
+
+
+unsigned int
+secure_random_value(void)
+{
+	return random_value() << 1 | (random_value() & 1);
+}
+
+
+// #pragma mark - debugging
+
+
+void
+dprintf(const char* format, ...)
+{
+	if (Simulation::Current() != NULL && !Simulation::Current()->Verbose())
+		return;
+
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+}
+
+
+void
+dvprintf(const char* format, va_list args)
+{
+	if (Simulation::Current() != NULL && !Simulation::Current()->Verbose())
+		return;
+
+	vfprintf(stderr, format, args);
+}
+
+
+void
+dprintf_no_syslog(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	dvprintf(format, args);
+	va_end(args);
+}
+
+
+void
+kprintf(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	vfprintf(stdout, format, args);
+	va_end(args);
+}
+
+
+void
+panic(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	fprintf(stderr, "PANIC: ");
+	vfprintf(stderr, format, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+
+	abort();
+}
+
+
+status_t
+add_debugger_command_etc(const char* name, debugger_command_hook func,
+	const char* description, const char* usage, uint32 flags)
+{
+	// there is no kernel debugger
+	return B_OK;
+}
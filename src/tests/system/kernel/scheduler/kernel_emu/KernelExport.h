@@ -0,0 +1,16 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_EMU_KERNEL_EXPORT_H
+#define _KERNEL_EMU_KERNEL_EXPORT_H
+
+
+// The host's <stdio.h> declares a dprintf() of its own that takes a file
+// descriptor, so the kernel's is renamed.
+#define dprintf kernel_emu_dprintf
+
+#include_next <KernelExport.h>
+
+
+#endif	/* _KERNEL_EMU_KERNEL_EXPORT_H */
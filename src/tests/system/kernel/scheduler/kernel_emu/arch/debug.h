@@ -0,0 +1,12 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef KERNEL_ARCH_DEBUG_H
+#define KERNEL_ARCH_DEBUG_H
+
+
+// Only needed for scheduler tracing, which the simulator doesn't support.
+
+
+#endif	/* KERNEL_ARCH_DEBUG_H */
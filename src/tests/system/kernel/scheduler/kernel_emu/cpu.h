@@ -0,0 +1,95 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_CPU_H
+#define _KERNEL_CPU_H
+
+
+#include <int.h>
+#include <smp.h>
+#include <timer.h>
+#include <scheduler.h>
+
+
+namespace BKernel {
+	struct Thread;
+}
+
+using BKernel::Thread;
+
+
+typedef enum cpu_topology_level {
+	CPU_TOPOLOGY_SMT,
+	CPU_TOPOLOGY_CORE,
+	CPU_TOPOLOGY_PACKAGE,
+
+	//
+	CPU_TOPOLOGY_LEVELS
+} cpu_topology_level;
+
+typedef struct cpu_topology_node {
+	cpu_topology_level	level;
+
+	int					id;
+
+	cpu_topology_node**	children;
+	int					children_count;
+} cpu_topology_node;
+
+
+/* CPU local data structure, reduced to what the scheduler uses */
+typedef struct cpu_ent {
+	int				cpu_num;
+
+	bool			preempted;
+	timer			quantum_timer;
+
+	// keeping track of CPU activity
+	seqlock			active_time_lock;
+	bigtime_t		active_time;
+	bigtime_t		interrupt_time;
+	bigtime_t		last_kernel_time;
+	bigtime_t		last_user_time;
+
+	Thread*			running_thread;
+	Thread*			previous_thread;
+	bool			invoke_scheduler;
+	bool			disabled;
+
+	// CPU topology information
+	int				topology_id[CPU_TOPOLOGY_LEVELS];
+
+	// IRQs assigned to this CPU
+	struct list		irqs;
+	spinlock		irqs_lock;
+} cpu_ent;
+
+
+extern cpu_ent gCPU[];
+extern uint32 gCPUCacheLevelCount;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const cpu_topology_node* get_cpu_topology(void);
+
+void cpu_set_scheduler_mode(enum scheduler_mode mode);
+status_t increase_cpu_performance(int delta);
+status_t decrease_cpu_performance(int delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+static inline cpu_ent*
+get_cpu_struct(void)
+{
+	return &gCPU[smp_get_current_cpu()];
+}
+
+
+#endif	/* _KERNEL_CPU_H */
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_DEBUG_H
+#define _KERNEL_DEBUG_H
+
+
+#include <KernelExport.h>
+
+
+namespace BKernel {
+	struct Thread;
+}
+
+using BKernel::Thread;
+
+
+// The simulator always checks the scheduler's assertions.
+#define KDEBUG 1
+
+#define ASSERT(x) \
+	do {																	\
+		if (!(x)) {															\
+			panic("ASSERT FAILED (%s:%d): %s", __FILE__, __LINE__, #x);		\
+		}																	\
+	} while (0)
+
+#define ASSERT_PRINT(x, format, args...) \
+	do {																	\
+		if (!(x)) {															\
+			panic("ASSERT FAILED (%s:%d): %s; " format, __FILE__, __LINE__,	\
+				#x, args);													\
+		}																	\
+	} while (0)
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void		dprintf_no_syslog(const char* format, ...)
+					__attribute__ ((format (__printf__, 1, 2)));
+extern status_t	add_debugger_command_etc(const char* name,
+					debugger_command_hook func, const char* description,
+					const char* usage, uint32 flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/* _KERNEL_DEBUG_H */
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_INT_H
+#define _KERNEL_INT_H
+
+
+#include <KernelExport.h>
+
+#include <util/list.h>
+
+
+// The simulator doesn't have any devices, the per CPU IRQ lists stay empty.
+struct irq_assignment {
+	list_link	link;
+
+	uint32		irq;
+	uint32		count;
+
+	int32		handlers_count;
+
+	int32		load;
+	int32		cpu;
+};
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool are_interrupts_enabled(void);
+
+void assign_io_interrupt_to_cpu(long vector, int32 cpu);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/* _KERNEL_INT_H */
@@ -0,0 +1,21 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_KERNEL_H
+#define _KERNEL_KERNEL_H
+
+
+#include <new>
+
+#include <SupportDefs.h>
+
+
+#define CACHE_LINE_SIZE		64
+#define CACHE_LINE_ALIGN	__attribute__((aligned(CACHE_LINE_SIZE)))
+
+// the most CPUs the simulator can be configured with
+#define SMP_MAX_CPUS		64
+
+
+#endif	/* _KERNEL_KERNEL_H */
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef KERNEL_SMP_H
+#define KERNEL_SMP_H
+
+
+#include <KernelExport.h>
+
+#include <kernel.h>
+
+
+// intercpu messages
+enum {
+	SMP_MSG_INVALIDATE_PAGE_RANGE = 0,
+	SMP_MSG_INVALIDATE_PAGE_LIST,
+	SMP_MSG_USER_INVALIDATE_PAGES,
+	SMP_MSG_GLOBAL_INVALIDATE_PAGES,
+	SMP_MSG_CPU_HALT,
+	SMP_MSG_CALL_FUNCTION,
+	SMP_MSG_RESCHEDULE
+};
+
+enum {
+	SMP_MSG_FLAG_ASYNC		= 0x0,
+	SMP_MSG_FLAG_SYNC		= 0x1,
+	SMP_MSG_FLAG_FREE_ARG	= 0x2,
+};
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32 smp_get_num_cpus(void);
+int32 smp_get_current_cpu(void);
+
+/*!	Only SMP_MSG_RESCHEDULE is supported. It is delivered to the target CPU
+	as an event at the current simulated time.
+*/
+void smp_send_ici(int32 targetCPU, int32 message, addr_t data, addr_t data2,
+	addr_t data3, void* dataPointer, uint32 flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/* KERNEL_SMP_H */
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _THREAD_H
+#define _THREAD_H
+
+
+#include <thread_types.h>
+
+
+#define syscall_64_bit_return_value()
+
+
+/*!	Simulated threads are never deleted while the simulation runs, so a
+	reference doesn't need to do anything.
+*/
+template<typename Type>
+class BReference {
+public:
+	BReference(Type* object, bool alreadyHasReference)
+	{
+	}
+};
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void thread_map(void (*function)(Thread* thread, void* data), void* data);
+
+/*!	Only records the switch, the simulator takes care of running \a to.
+	\c from->cpu is kept until the scheduler is done with it, see
+	kernel_emu.cpp.
+*/
+void arch_thread_context_switch(Thread* from, Thread* to);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+static inline Thread*
+thread_get_current_thread(void)
+{
+	return gCPU[smp_get_current_cpu()].running_thread;
+}
+
+
+static inline void
+arch_thread_set_current_thread(Thread* thread)
+{
+	// the running thread is taken from the CPU structure already
+}
+
+
+static inline bool
+thread_is_idle_thread(Thread* thread)
+{
+	return thread->priority == B_IDLE_PRIORITY;
+}
+
+
+// Simulated threads have no user timers, so these are never called.
+
+static inline void
+user_timer_stop_cpu_timers(Thread* thread, Thread* nextThread)
+{
+}
+
+
+static inline void
+user_timer_continue_cpu_timers(Thread* thread, Thread* previousThread)
+{
+}
+
+
+static inline void
+user_timer_check_team_user_timers(Team* team)
+{
+}
+
+
+#endif	/* _THREAD_H */
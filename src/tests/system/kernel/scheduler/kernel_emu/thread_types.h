@@ -0,0 +1,86 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_THREAD_TYPES_H
+#define _KERNEL_THREAD_TYPES_H
+
+
+#include <cpu.h>
+
+#include <util/DoublyLinkedList.h>
+
+
+enum additional_thread_state {
+	THREAD_STATE_FREE_ON_RESCHED = 7, // free the thread structure upon reschedule
+//	THREAD_STATE_BIRTH	// thread is being created
+};
+
+#define THREAD_MIN_SET_PRIORITY				B_LOWEST_ACTIVE_PRIORITY
+#define THREAD_MAX_SET_PRIORITY				B_REAL_TIME_PRIORITY
+
+#define	THREAD_FLAGS_DEBUGGER_INSTALLED		0x0008
+
+
+namespace Scheduler {
+	struct ThreadData;
+}
+
+
+namespace BKernel {
+
+
+/*!	The team and thread structures, reduced to what the scheduler uses. */
+struct Team {
+	spinlock		time_lock;
+
+	bool HasActiveCPUTimeUserTimers() const
+		{ return false; }
+	bool HasActiveUserTimeUserTimers() const
+		{ return false; }
+};
+
+
+struct Thread {
+	thread_id		id;
+	const char*		name;
+	int32			priority;
+	int32			state;
+	int32			flags;
+	bool			has_yielded;
+
+	cpu_ent*		cpu;
+	cpu_ent*		previous_cpu;
+	int32			pinned_to_cpu;
+	spinlock		scheduler_lock;
+
+	Scheduler::ThreadData*	scheduler_data;
+
+	Team*			team;
+
+	spinlock		time_lock;
+	bigtime_t		kernel_time;
+	bigtime_t		user_time;
+	bigtime_t		last_time;
+
+	// used by the simulator to find its bookkeeping
+	void*			simulator_data;
+
+	bool HasActiveCPUTimeUserTimers() const
+		{ return false; }
+
+	void AcquireReference()
+		{ }
+
+	static Thread* Get(thread_id id);
+};
+
+
+}	// namespace BKernel
+
+
+using BKernel::Team;
+using BKernel::Thread;
+
+
+#endif	/* _KERNEL_THREAD_TYPES_H */
@@ -0,0 +1,14 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_TIMER_H
+#define _KERNEL_TIMER_H
+
+
+// The timer structure and add_timer()/cancel_timer() are declared in
+// <KernelExport.h>; the simulator turns timers into events.
+#include <KernelExport.h>
+
+
+#endif	/* _KERNEL_TIMER_H */
@@ -0,0 +1,14 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef KERNEL_TRACING_H
+#define KERNEL_TRACING_H
+
+
+// The simulator collects its own statistics, the kernel tracing buffer is
+// not emulated.
+#define SCHEDULER_TRACING	0
+
+
+#endif	/* KERNEL_TRACING_H */
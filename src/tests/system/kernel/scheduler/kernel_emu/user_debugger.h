@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_USER_DEBUGGER_H
+#define _KERNEL_USER_DEBUGGER_H
+
+
+#include <thread_types.h>
+
+
+// Simulated threads are never debugged.
+
+static inline void
+user_debug_thread_unscheduled(Thread* thread)
+{
+}
+
+
+static inline void
+user_debug_thread_scheduled(Thread* thread)
+{
+}
+
+
+#endif	/* _KERNEL_USER_DEBUGGER_H */
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef KERNEL_UTIL_AUTO_LOCKER_H
+#define KERNEL_UTIL_AUTO_LOCKER_H
+
+
+// The interrupt and spinlock lockers of the kernel's <util/AutoLock.h>. The
+// mutex and thread lockers are left out, the scheduler doesn't use them.
+
+
+#include <KernelExport.h>
+
+#include <shared/AutoLocker.h>
+
+#include <int.h>
+#include <thread.h>
+
+
+namespace BPrivate {
+
+
+class InterruptsLocking {
+public:
+	inline bool Lock(int* lockable)
+	{
+		*lockable = disable_interrupts();
+		return true;
+	}
+
+	inline void Unlock(int* lockable)
+	{
+		restore_interrupts(*lockable);
+	}
+};
+
+
+class InterruptsLocker : public AutoLocker<int, InterruptsLocking> {
+public:
+	inline InterruptsLocker(bool alreadyLocked = false,
+		bool lockIfNotLocked = true)
+		: AutoLocker<int, InterruptsLocking>(&fState, alreadyLocked,
+			lockIfNotLocked)
+	{
+	}
+
+private:
+	int	fState;
+};
+
+
+class SpinLocking {
+public:
+	inline bool Lock(spinlock* lockable)
+	{
+		acquire_spinlock(lockable);
+		return true;
+	}
+
+	inline void Unlock(spinlock* lockable)
+	{
+		release_spinlock(lockable);
+	}
+};
+
+typedef AutoLocker<spinlock, SpinLocking> SpinLocker;
+
+
+class InterruptsSpinLocking {
+public:
+// NOTE: work-around for annoying GCC 4+ "fState may be used uninitialized"
+// warning.
+#if __GNUC__ >= 4
+	InterruptsSpinLocking()
+		:
+		fState(0)
+	{
+	}
+#endif
+
+	inline bool Lock(spinlock* lockable)
+	{
+		fState = disable_interrupts();
+		acquire_spinlock(lockable);
+		return true;
+	}
+
+	inline void Unlock(spinlock* lockable)
+	{
+		release_spinlock(lockable);
+		restore_interrupts(fState);
+	}
+
+private:
+	int	fState;
+};
+
+typedef AutoLocker<spinlock, InterruptsSpinLocking> InterruptsSpinLocker;
+
+
+class ReadSpinLocking {
+public:
+	inline bool Lock(rw_spinlock* lockable)
+	{
+		acquire_read_spinlock(lockable);
+		return true;
+	}
+
+	inline void Unlock(rw_spinlock* lockable)
+	{
+		release_read_spinlock(lockable);
+	}
+};
+
+typedef AutoLocker<rw_spinlock, ReadSpinLocking> ReadSpinLocker;
+
+
+class InterruptsReadSpinLocking {
+public:
+	InterruptsReadSpinLocking()
+		:
+		fState(0)
+	{
+	}
+
+	inline bool Lock(rw_spinlock* lockable)
+	{
+		fState = disable_interrupts();
+		acquire_read_spinlock(lockable);
+		return true;
+	}
+
+	inline void Unlock(rw_spinlock* lockable)
+	{
+		release_read_spinlock(lockable);
+		restore_interrupts(fState);
+	}
+
+private:
+	int	fState;
+};
+
+typedef AutoLocker<rw_spinlock, InterruptsReadSpinLocking>
+	InterruptsReadSpinLocker;
+
+
+class WriteSpinLocking {
+public:
+	inline bool Lock(rw_spinlock* lockable)
+	{
+		acquire_write_spinlock(lockable);
+		return true;
+	}
+
+	inline void Unlock(rw_spinlock* lockable)
+	{
+		release_write_spinlock(lockable);
+	}
+};
+
+typedef AutoLocker<rw_spinlock, WriteSpinLocking> WriteSpinLocker;
+
+
+class InterruptsWriteSpinLocking {
+public:
+	InterruptsWriteSpinLocking()
+		:
+		fState(0)
+	{
+	}
+
+	inline bool Lock(rw_spinlock* lockable)
+	{
+		fState = disable_interrupts();
+		acquire_write_spinlock(lockable);
+		return true;
+	}
+
+	inline void Unlock(rw_spinlock* lockable)
+	{
+		release_write_spinlock(lockable);
+		restore_interrupts(fState);
+	}
+
+private:
+	int	fState;
+};
+
+typedef AutoLocker<rw_spinlock, InterruptsWriteSpinLocking>
+	InterruptsWriteSpinLocker;
+
+
+class WriteSequentialLocking {
+public:
+	inline bool Lock(seqlock* lockable)
+	{
+		acquire_write_seqlock(lockable);
+		return true;
+	}
+
+	inline void Unlock(seqlock* lockable)
+	{
+		release_write_seqlock(lockable);
+	}
+};
+
+typedef AutoLocker<seqlock, WriteSequentialLocking> WriteSequentialLocker;
+
+
+class InterruptsWriteSequentialLocking {
+public:
+	InterruptsWriteSequentialLocking()
+		:
+		fState(0)
+	{
+	}
+
+	inline bool Lock(seqlock* lockable)
+	{
+		fState = disable_interrupts();
+		acquire_write_seqlock(lockable);
+		return true;
+	}
+
+	inline void Unlock(seqlock* lockable)
+	{
+		release_write_seqlock(lockable);
+		restore_interrupts(fState);
+	}
+
+private:
+	int	fState;
+};
+
+typedef AutoLocker<seqlock, InterruptsWriteSequentialLocking>
+	InterruptsWriteSequentialLocker;
+
+
+}	// namespace BPrivate
+
+using BPrivate::AutoLocker;
+using BPrivate::InterruptsLocker;
+using BPrivate::SpinLocker;
+using BPrivate::InterruptsSpinLocker;
+using BPrivate::ReadSpinLocker;
+using BPrivate::InterruptsReadSpinLocker;
+using BPrivate::WriteSpinLocker;
+using BPrivate::InterruptsWriteSpinLocker;
+using BPrivate::WriteSequentialLocker;
+using BPrivate::InterruptsWriteSequentialLocker;
+
+
+#endif	// KERNEL_UTIL_AUTO_LOCKER_H
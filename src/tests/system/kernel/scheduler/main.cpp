@@ -1,390 +1,434 @@
-#include "override_types.h"
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
 
+
+/*!	Runs the kernel's scheduler in a discrete event simulation on the build
+	host. A generated or recorded workload is replayed in each scheduler
+	mode, and the wake-up latencies, the migrations, and how often threads
+	lose their caches are compared.
+*/
+
+
+#include <errno.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#include <KernelExport.h>
-#include <List.h>
-#include <Locker.h>
-#include <String.h>
-#include <TLS.h>
-
-#include <cpu.h>
-#include <kscheduler.h>
-#include <timer.h>
-
-
-const static option kOptions[] = {
-	{"time", required_argument, NULL, 't'},
-	{"cpu", required_argument, NULL, 'c'},
-};
-
-const bigtime_t kQuantum = 3000;
-const uint32 kMaxCPUCount = 64;
-
-class Thread {
-public:
-	Thread(const char* name, int32 priority);
-	virtual ~Thread();
-
-	struct thread* GetThread() { return &fThread; }
-	virtual void Rescheduled() { fOnCPU[fThread.cpu->cpu_num]++; }
-
-	virtual bigtime_t NextQuantum() { return kQuantum; }
-	virtual bigtime_t NextState() { return B_THREAD_READY; }
-	virtual bigtime_t NextReady() { return 0; }
-
-protected:
-	struct thread	fThread;
-	int32			fOnCPU[kMaxCPUCount];
-};
-
-class IdleThread : public Thread {
-public:
-	IdleThread();
-	virtual ~IdleThread();
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Simulation.h"
+#include "Workload.h"
+
+
+extern const char* __progname;
+static const char* kCommandName = __progname;
+
+static const char* kUsage =
+	"Usage: %s [ <options> ]\n"
+	"Simulates the kernel scheduler running a workload and reports the\n"
+	"scheduling latencies, migrations, and cache affinity losses of each\n"
+	"scheduler mode.\n"
+	"\n"
+	"Options:\n"
+	"  -t, --topology <p>x<c>x<s>\n"
+	"                 - Simulate <p> packages with <c> cores of <s> logical\n"
+	"                   CPUs each. Default is 1x4x2.\n"
+	"  -d, --duration <ms>\n"
+	"                 - Simulated time. Default is 2000 ms.\n"
+	"  -m, --mode low_latency|power_saving|both\n"
+	"                 - The scheduler modes to simulate. Default is both.\n"
+	"  -w, --workload <file>\n"
+	"                 - Replay the workload in <file> instead of generating\n"
+	"                   one.\n"
+	"  -o, --dump-workload <file>\n"
+	"                 - Write the workload to <file>, \"-\" for stdout.\n"
+	"  -s, --seed <seed>\n"
+	"                 - Seed of the generated workload. Default is 1.\n"
+	"  -l, --latency-threads <count>\n"
+	"                 - Latency sensitive threads generated. Default is 16.\n"
+	"  -b, --batch-threads <count>\n"
+	"                 - Batch threads generated. Default is 8.\n"
+	"  --core-window <us>\n"
+	"  --package-window <us>\n"
+	"                 - Work other threads may do on a core, respectively a\n"
+	"                   package, before a thread's data is gone from its\n"
+	"                   caches. Defaults are 1000 and 10000 us.\n"
+	"  --core-refill <us>\n"
+	"  --package-refill <us>\n"
+	"                 - Estimated time needed to refill the core's, respectively\n"
+	"                   the package's, caches. Defaults are 20 and 100 us.\n"
+	"  --charge-refill\n"
+	"                 - Make the threads run longer by the refill times.\n"
+	"  -v, --verbose  - Print the scheduler's decisions.\n"
+	"  -h, --help     - Print this usage info.\n"
+;
+
+enum {
+	OPTION_CORE_WINDOW = 256,
+	OPTION_PACKAGE_WINDOW,
+	OPTION_CORE_REFILL,
+	OPTION_PACKAGE_REFILL,
+	OPTION_CHARGE_REFILL
 };
 
-class CPU {
-public:
-	CPU(int32 num);
-	~CPU();
-
-	cpu_ent* GetCPU() { return &fCPU; }
-	int32 Index() { return fCPU.cpu_num; }
-
-	struct thread* CurrentThread()
-		{ return fCurrentThread->GetThread(); }
-	void SetCurrentThread(struct thread* thread)
-		{ fCurrentThread = thread->object; }
-
-	void Quit();
-
-private:
-	void _Run();
-	static status_t _Run(void* self);
-
-	struct cpu_ent	fCPU;
-	thread_id		fThread;
-	Thread*			fCurrentThread;
-	IdleThread		fIdleThread;
-	int32			fRescheduleCount;
-	bool			fQuit;
+static const char* const kModeNames[] = {
+	"low_latency",
+	"power_saving"
 };
+static const int32 kModeCount = sizeof(kModeNames) / sizeof(kModeNames[0]);
 
-class Timer {
-public:
-	Timer();
-	~Timer();
 
-	void AddTimer(bigtime_t time);
-};
-
-thread_queue dead_q;
-
-static BLocker sThreadLock;
-static BList sThreads;
-static int32 sNextThreadID = 1;
-static int32 sCPUIndexSlot;
-static CPU* sCPU[kMaxCPUCount];
-static size_t sCPUCount;
-
-
-//	#pragma mark -
-
-
-Thread::Thread(const char* name, int32 priority)
-{
-	memset(&fThread, 0, sizeof(struct thread));
-	fThread.name = strdup(name);
-	fThread.id = sNextThreadID++;
-	fThread.priority = fThread.next_priority = priority;
-	fThread.state = fThread.next_state = B_THREAD_READY;
-	fThread.object = this;
-	fThread.last_time = system_time();
-	
-	memset(&fOnCPU, 0, sizeof(fOnCPU));
-}
-
-
-Thread::~Thread()
-{
-	printf("  %p %10Ld  %s, prio %ld, cpu:", &fThread, fThread.kernel_time,
-		fThread.name, fThread.priority);
-	for (uint32 i = 0; i < kMaxCPUCount; i++) {
-		if (fOnCPU[i])
-			printf(" [%ld] %ld", i, fOnCPU[i]);
-	}
-	putchar('\n');
-	free(fThread.name);
-}
-
-
-//	#pragma mark -
-
-
-IdleThread::IdleThread()
-	: Thread("idle thread", B_IDLE_PRIORITY)
-{
-}
-
-
-IdleThread::~IdleThread()
-{
-}
-
-
-//	#pragma mark -
-
-
-CPU::CPU(int32 num)
-	:
-	fRescheduleCount(0),
-	fQuit(false)
-{
-	memset(&fCPU, 0, sizeof(struct cpu_ent));
-	fCPU.cpu_num = num;
-
-	fCurrentThread = &fIdleThread;
-	fIdleThread.GetThread()->cpu = &fCPU;
-
-	fThread = spawn_thread(&_Run, (BString("cpu ") << num).String(),
-		B_NORMAL_PRIORITY, this);
-	resume_thread(fThread);
-}
-
-
-CPU::~CPU()
-{
-}
-
-
-void
-CPU::Quit()
+static void
+print_usage_and_exit(bool error)
 {
-	fQuit = true;
-
-	status_t status;
-	wait_for_thread(fThread, &status);
+	fprintf(error ? stderr : stdout, kUsage, kCommandName);
+	exit(error ? 1 : 0);
 }
 
 
-void
-CPU::_Run()
+static bigtime_t
+parse_time(const char* argument, bigtime_t unit)
 {
-	tls_set(sCPUIndexSlot, this);
-	printf("CPU %d has started.\n", fCPU.cpu_num);
-
-	while (!fQuit) {
-		fRescheduleCount++;
-
-		grab_thread_lock();
-		scheduler_reschedule();
-		release_thread_lock();
-
-		fCurrentThread->Rescheduled();
-		snooze(fCurrentThread->NextQuantum());
-		fCurrentThread->GetThread()->next_state = fCurrentThread->NextState();
+	char* end;
+	long long value = strtoll(argument, &end, 10);
+	if (*end != '\0' || value < 0) {
+		fprintf(stderr, "%s: invalid time \"%s\"\n", kCommandName, argument);
+		exit(1);
 	}
 
-	thread_info info;
-	get_thread_info(find_thread(NULL), &info);
-
-	printf("CPU %d has halted, user %Ld, %ld rescheduled.\n",
-		fCPU.cpu_num, info.user_time, fRescheduleCount);
-	delete this;
+	return value * unit;
 }
 
 
-status_t
-CPU::_Run(void* self)
+/*!	Runs the simulation in a child process, since the scheduler can only be
+	initialized once per process.
+*/
+static status_t
+run_simulation(const SimulationOptions& options, const Workload& workload,
+	scheduler_mode mode, SimulationResult& result)
 {
-	CPU* cpu = (CPU*)self;
-	cpu->_Run();
-	return B_OK;
-}
-
-
-//	#pragma mark - Emulation
-
+	int fds[2];
+	if (pipe(fds) != 0)
+		return errno;
 
-extern "C" void
-kprintf(const char *format,...)
-{
-	va_list args;
-	va_start(args, format);
-	printf("\33[35m");
-	vprintf(format, args);
-	printf("\33[0m");
+	// don't let the child print what is still buffered
 	fflush(stdout);
-	va_end(args);
-}
-
-
-void
-thread_enqueue(struct thread *t, struct thread_queue *q)
-{
-}
-
-
-struct thread *
-thread_get_current_thread(void)
-{
-	CPU* cpu = (CPU*)tls_get(sCPUIndexSlot);
-	return cpu->CurrentThread();
-}
-
-
-void
-grab_thread_lock(void)
-{
-	sThreadLock.Lock();
-}
-
-
-void
-release_thread_lock(void)
-{
-	sThreadLock.Unlock();
-}
-
 
-void
-arch_thread_context_switch(struct thread *t_from, struct thread *t_to)
-{
-}
-
-
-void
-arch_thread_set_current_thread(struct thread *thread)
-{
-	CPU* cpu = (CPU*)tls_get(sCPUIndexSlot);
-	//printf("[%ld]  %p  %s\n", cpu->Index(), thread, thread->name);
-	return cpu->SetCurrentThread(thread);
-}
-
-
-int
-add_debugger_command(char *name, int (*func)(int, char **), char *desc)
-{
-	return B_OK;
-}
+	pid_t child = fork();
+	if (child < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return errno;
+	}
 
+	if (child == 0) {
+		close(fds[0]);
 
-cpu_status
-disable_interrupts()
-{
-	return 0;
-}
+		Simulation simulation(options, workload);
+		SimulationResult childResult;
+		status_t status = simulation.Run(mode, childResult);
+		if (status == B_OK
+			&& write(fds[1], &childResult, sizeof(childResult))
+				!= (ssize_t)sizeof(childResult)) {
+			status = B_IO_ERROR;
+		}
 
+		fflush(stdout);
+		_exit(status == B_OK ? 0 : 1);
+	}
 
-void
-restore_interrupts(cpu_status status)
-{
-}
+	close(fds[1]);
 
+	status_t status = B_OK;
+	if (read(fds[0], &result, sizeof(result)) != (ssize_t)sizeof(result))
+		status = B_ERROR;
+	close(fds[0]);
 
-extern "C" status_t
-_local_timer_cancel_event(int cpu, timer *event)
-{
-	return B_OK;
-}
-
+	int childStatus;
+	if (waitpid(child, &childStatus, 0) < 0 || !WIFEXITED(childStatus)
+		|| WEXITSTATUS(childStatus) != 0) {
+		status = B_ERROR;
+	}
 
-status_t
-add_timer(timer *event, timer_hook hook, bigtime_t period, int32 flags)
-{
-	return B_OK;
+	return status;
 }
 
 
-int32
-smp_get_current_cpu(void)
+static double
+percent(int64 part, int64 total)
 {
-	return thread_get_current_thread()->cpu->cpu_num;
+	return total != 0 ? 100.0 * part / total : 0.0;
 }
 
 
-//	#pragma mark -
-
-
 static void
-start_cpus(uint32 count)
+print_result(const char* mode, const SimulationResult& result)
 {
-	sCPUIndexSlot = tls_allocate();
-	sCPUCount = count;
-
-	for (size_t i = 0; i < count; i++) {
-		sCPU[i] = new CPU(i);
+	printf("%s\n", mode);
+
+	printf("  CPU utilization:   %.1f%% of %" B_PRId32 " CPUs\n",
+		percent(result.busyTime, result.duration * result.cpuCount),
+		result.cpuCount);
+	printf("  context switches:  %" B_PRId64 "\n", result.contextSwitches);
+
+	for (int32 i = 0; i < THREAD_CLASS_COUNT; i++) {
+		printf("  %-8s threads:  %" B_PRId64 " wake-ups, %" B_PRId64 " us CPU,"
+			" latency p50 %" B_PRId64 ", p90 %" B_PRId64 ", p99 %" B_PRId64
+			", max %" B_PRId64 " us\n", Workload::ClassName(i),
+			result.wakeUps[i], result.cpuTime[i],
+			result.latency[i][PERCENTILE_50], result.latency[i][PERCENTILE_90],
+			result.latency[i][PERCENTILE_99],
+			result.latency[i][PERCENTILE_MAX]);
 	}
-}
-
 
-static void
-stop_cpus()
-{
-	for (size_t i = 0; i < sCPUCount; i++) {
-		sCPU[i]->Quit();
+	printf("  migrations:        %" B_PRId64 " to another logical CPU, %"
+		B_PRId64 " to another core, %" B_PRId64 " to another package\n",
+		result.cpuMigrations, result.coreMigrations, result.packageMigrations);
+
+	int64 dispatches = result.warmDispatches + result.coreColdDispatches
+		+ result.packageColdDispatches;
+	printf("  caches:            %.1f%% warm, %.1f%% lost core caches, %.1f%%"
+		" lost package caches, %" B_PRId64 " us refill\n",
+		percent(result.warmDispatches, dispatches),
+		percent(result.coreColdDispatches, dispatches),
+		percent(result.packageColdDispatches, dispatches), result.refillTime);
+
+	if (result.batchThreads > 0) {
+		printf("  batch completion:  %" B_PRId32 " of %" B_PRId32 " finished",
+			result.batchThreadsFinished, result.batchThreads);
+		if (result.batchThreadsFinished > 0) {
+			printf(", average %" B_PRId64 " us, max %" B_PRId64 " us",
+				result.batchCompletionTotal / result.batchThreadsFinished,
+				result.batchCompletionMax);
+		}
+		printf("\n");
 	}
-}
-
 
-static void
-add_thread(Thread* thread)
-{
-	grab_thread_lock();
-	sThreads.AddItem(thread);
-	scheduler_enqueue_in_run_queue(thread->GetThread());
-	release_thread_lock();
+	printf("\n");
 }
 
 
 static void
-delete_threads()
+print_comparison(const SimulationResult* results, const bool* simulated)
 {
-	for (int32 i = 0; i < sThreads.CountItems(); i++) {
-		delete (Thread*)sThreads.ItemAt(i);
+	printf("%-32s", "");
+	for (int32 i = 0; i < kModeCount; i++) {
+		if (simulated[i])
+			printf(" %14s", kModeNames[i]);
 	}
+	printf("\n");
+
+#define PRINT_ROW(title, format, value)							\
+	do {														\
+		printf("%-32s", title);									\
+		for (int32 i = 0; i < kModeCount; i++) {				\
+			if (simulated[i]) {									\
+				const SimulationResult& result = results[i];	\
+				printf(" %14" format, value);					\
+			}													\
+		}														\
+		printf("\n");											\
+	} while (false)
+
+	PRINT_ROW("latency threads p99 (us)", B_PRId64,
+		result.latency[THREAD_CLASS_LATENCY][PERCENTILE_99]);
+	PRINT_ROW("latency threads max (us)", B_PRId64,
+		result.latency[THREAD_CLASS_LATENCY][PERCENTILE_MAX]);
+	PRINT_ROW("batch threads p99 (us)", B_PRId64,
+		result.latency[THREAD_CLASS_BATCH][PERCENTILE_99]);
+	PRINT_ROW("context switches", B_PRId64, result.contextSwitches);
+	PRINT_ROW("core migrations", B_PRId64, result.coreMigrations);
+	PRINT_ROW("package migrations", B_PRId64, result.packageMigrations);
+	PRINT_ROW("lost core caches (%)", ".1f",
+		percent(result.coreColdDispatches + result.packageColdDispatches,
+			result.warmDispatches + result.coreColdDispatches
+				+ result.packageColdDispatches));
+	PRINT_ROW("cache refill time (us)", B_PRId64, result.refillTime);
+	PRINT_ROW("batch threads finished", B_PRId32,
+		result.batchThreadsFinished);
+
+#undef PRINT_ROW
 }
 
 
 int
-main(int argc, char** argv)
+main(int argc, const char* const* argv)
 {
-	bigtime_t runTime = 1000000;
-	uint32 cpuCount = 1;
-
-	char option;
-	while ((option = getopt_long(argc, argv, "", kOptions, NULL)) != -1) {
-		switch (option) {
+	SimulationOptions options;
+	options.packages = 1;
+	options.coresPerPackage = 4;
+	options.threadsPerCore = 2;
+	options.duration = 2000000;
+	options.coreCacheWindow = 1000;
+	options.packageCacheWindow = 10000;
+	options.coreRefillTime = 20;
+	options.packageRefillTime = 100;
+	options.chargeRefill = false;
+	options.verbose = false;
+
+	const char* mode = "both";
+	const char* workloadFile = NULL;
+	const char* dumpFile = NULL;
+	uint32 seed = 1;
+	int32 latencyThreads = 16;
+	int32 batchThreads = 8;
+
+	while (true) {
+		static struct option sLongOptions[] = {
+			{ "topology", required_argument, 0, 't' },
+			{ "duration", required_argument, 0, 'd' },
+			{ "mode", required_argument, 0, 'm' },
+			{ "workload", required_argument, 0, 'w' },
+			{ "dump-workload", required_argument, 0, 'o' },
+			{ "seed", required_argument, 0, 's' },
+			{ "latency-threads", required_argument, 0, 'l' },
+			{ "batch-threads", required_argument, 0, 'b' },
+			{ "core-window", required_argument, 0, OPTION_CORE_WINDOW },
+			{ "package-window", required_argument, 0,
+				OPTION_PACKAGE_WINDOW },
+			{ "core-refill", required_argument, 0, OPTION_CORE_REFILL },
+			{ "package-refill", required_argument, 0,
+				OPTION_PACKAGE_REFILL },
+			{ "charge-refill", no_argument, 0, OPTION_CHARGE_REFILL },
+			{ "verbose", no_argument, 0, 'v' },
+			{ "help", no_argument, 0, 'h' },
+			{ 0, 0, 0, 0 }
+		};
+
+		opterr = 0; // don't print errors
+		int c = getopt_long(argc, (char**)argv, "+b:d:hl:m:o:s:t:vw:",
+			sLongOptions, NULL);
+		if (c == -1)
+			break;
+
+		switch (c) {
 			case 't':
-				runTime *= strtol(optarg, 0, NULL);
-				if (runTime <= 0) {
-					fprintf(stderr, "Invalid run time.\n");
+				if (sscanf(optarg, "%" B_SCNd32 "x%" B_SCNd32 "x%" B_SCNd32,
+						&options.packages, &options.coresPerPackage,
+						&options.threadsPerCore) != 3
+					|| options.packages < 1 || options.coresPerPackage < 1
+					|| options.threadsPerCore < 1
+					|| options.packages * options.coresPerPackage
+						* options.threadsPerCore > SMP_MAX_CPUS) {
+					fprintf(stderr, "%s: invalid topology \"%s\"\n",
+						kCommandName, optarg);
 					exit(1);
 				}
 				break;
-			case 'c':
-				cpuCount = strtol(optarg, 0, NULL);
-				if (cpuCount <= 0 || cpuCount > 64) {
-					fprintf(stderr, "Invalid CPU count (allowed: 1-64).\n");
-					exit(1);
-				}
+			case 'd':
+				options.duration = parse_time(optarg, 1000);
+				break;
+			case 'm':
+				mode = optarg;
+				break;
+			case 'w':
+				workloadFile = optarg;
+				break;
+			case 'o':
+				dumpFile = optarg;
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'l':
+				latencyThreads = atoi(optarg);
+				break;
+			case 'b':
+				batchThreads = atoi(optarg);
+				break;
+			case OPTION_CORE_WINDOW:
+				options.coreCacheWindow = parse_time(optarg, 1);
+				break;
+			case OPTION_PACKAGE_WINDOW:
+				options.packageCacheWindow = parse_time(optarg, 1);
+				break;
+			case OPTION_CORE_REFILL:
+				options.coreRefillTime = parse_time(optarg, 1);
+				break;
+			case OPTION_PACKAGE_REFILL:
+				options.packageRefillTime = parse_time(optarg, 1);
+				break;
+			case OPTION_CHARGE_REFILL:
+				options.chargeRefill = true;
+				break;
+			case 'v':
+				options.verbose = true;
+				break;
+			case 'h':
+				print_usage_and_exit(false);
+				break;
+
+			default:
+				print_usage_and_exit(true);
 				break;
 		}
 	}
 
-	start_cpus(cpuCount);
+	if (optind != argc || latencyThreads < 0 || batchThreads < 0)
+		print_usage_and_exit(true);
 
-	add_thread(new Thread("test 1", 5));
-	add_thread(new Thread("test 2", 10));
-	add_thread(new Thread("test 3", 15));
+	bool simulate[kModeCount];
+	for (int32 i = 0; i < kModeCount; i++) {
+		simulate[i] = strcmp(mode, "both") == 0
+			|| strcmp(mode, kModeNames[i]) == 0;
+	}
+	if (!simulate[SCHEDULER_MODE_LOW_LATENCY]
+		&& !simulate[SCHEDULER_MODE_POWER_SAVING]) {
+		fprintf(stderr, "%s: unknown scheduler mode \"%s\"\n", kCommandName,
+			mode);
+		exit(1);
+	}
+
+	Workload workload;
+	if (workloadFile != NULL) {
+		if (workload.Load(workloadFile) != B_OK)
+			exit(1);
+	} else if (latencyThreads + batchThreads > 0) {
+		workload.Generate(seed, latencyThreads, batchThreads,
+			options.duration);
+	} else {
+		fprintf(stderr, "%s: the workload doesn't have any threads\n",
+			kCommandName);
+		exit(1);
+	}
 
-	snooze(runTime);
+	if (dumpFile != NULL) {
+		FILE* file = strcmp(dumpFile, "-") == 0
+			? stdout : fopen(dumpFile, "w");
+		if (file == NULL) {
+			fprintf(stderr, "%s: failed to create \"%s\"\n", kCommandName,
+				dumpFile);
+			exit(1);
+		}
+		workload.Write(file);
+		if (file != stdout)
+			fclose(file);
+	}
+
+	printf("%" B_PRId32 " threads on %" B_PRId32 "x%" B_PRId32 "x%" B_PRId32
+		" CPUs for %" B_PRId64 " ms\n\n", workload.CountThreads(),
+		options.packages, options.coresPerPackage, options.threadsPerCore,
+		options.duration / 1000);
+	fflush(stdout);
+
+	SimulationResult results[kModeCount];
+	for (int32 i = 0; i < kModeCount; i++) {
+		if (!simulate[i])
+			continue;
+
+		if (run_simulation(options, workload, (scheduler_mode)i, results[i])
+				!= B_OK) {
+			fprintf(stderr, "%s: simulating %s mode failed\n", kCommandName,
+				kModeNames[i]);
+			exit(1);
+		}
+
+		print_result(kModeNames[i], results[i]);
+	}
 
-	stop_cpus();
-	delete_threads();
+	print_comparison(results, simulate);
 	return 0;
 }
@@ -4,6 +4,7 @@
  */
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,6 +20,24 @@
 #define panic printf
 
 
+static const int32 kLockGroupCount = 16;
+static const int32 kThreadsPerGroup = 4;
+static const int32 kLockIterations = 100000;
+static const int32 kBroadcastRounds = 5000;
+
+
+struct lock_group {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	condition;
+	pthread_cond_t	acknowledged;
+	int32			generation;
+	int32			acknowledgeCount;
+	int32			counter;
+};
+
+static lock_group sLockGroups[kLockGroupCount];
+
+
 struct dummy_spinlock {
 	vint32	lock;
 	vint32	count_low;
@@ -199,9 +218,134 @@ time_string(double timeInUsecs, char* buffer)
 }
 
 
+static void*
+mutex_thread(void* data)
+{
+	lock_group* group = (lock_group*)data;
+	for (int32 i = 0; i < kLockIterations; i++) {
+		pthread_mutex_lock(&group->mutex);
+		group->counter++;
+		pthread_mutex_unlock(&group->mutex);
+	}
+	return NULL;
+}
+
+
+static void*
+waiter_thread(void* data)
+{
+	lock_group* group = (lock_group*)data;
+	int32 generation = 0;
+
+	pthread_mutex_lock(&group->mutex);
+	while (generation < kBroadcastRounds) {
+		while (group->generation == generation)
+			pthread_cond_wait(&group->condition, &group->mutex);
+		generation = group->generation;
+
+		if (++group->acknowledgeCount == kThreadsPerGroup)
+			pthread_cond_signal(&group->acknowledged);
+	}
+	pthread_mutex_unlock(&group->mutex);
+	return NULL;
+}
+
+
+static void*
+broadcast_thread(void* data)
+{
+	lock_group* group = (lock_group*)data;
+
+	pthread_mutex_lock(&group->mutex);
+	for (int32 i = 0; i < kBroadcastRounds; i++) {
+		group->acknowledgeCount = 0;
+		group->generation++;
+		pthread_cond_broadcast(&group->condition);
+
+		while (group->acknowledgeCount < kThreadsPerGroup)
+			pthread_cond_wait(&group->acknowledged, &group->mutex);
+	}
+	pthread_mutex_unlock(&group->mutex);
+	return NULL;
+}
+
+
+/*!	Runs  threadsPerGroup threads with  function for each of the lock
+	groups, and waits for all of them to finish.
+*/
+static bigtime_t
+run_lock_groups(void* (*function)(void*), int32 threadsPerGroup,
+	void* (*extraFunction)(void*))
+{
+	pthread_t threads[kLockGroupCount * (kThreadsPerGroup + 1)];
+	int32 threadCount = 0;
+
+	bigtime_t startTime = system_time();
+	for (int32 i = 0; i < kLockGroupCount; i++) {
+		for (int32 j = 0; j < threadsPerGroup; j++) {
+			pthread_create(&threads[threadCount++], NULL, function,
+				&sLockGroups[i]);
+		}
+		if (extraFunction != NULL) {
+			pthread_create(&threads[threadCount++], NULL, extraFunction,
+				&sLockGroups[i]);
+		}
+	}
+
+	for (int32 i = 0; i < threadCount; i++)
+		pthread_join(threads[i], NULL);
+
+	return system_time() - startTime;
+}
+
+
+/*!	Many threads contending for independent pthread mutexes, and condition
+	variable broadcasts waking up several waiters that all need the same
+	mutex. All of this ends up in the kernel's user mutex code.
+*/
+static void
+user_mutex_benchmark()
+{
+	for (int32 i = 0; i < kLockGroupCount; i++) {
+		lock_group& group = sLockGroups[i];
+		pthread_mutex_init(&group.mutex, NULL);
+		pthread_cond_init(&group.condition, NULL);
+		pthread_cond_init(&group.acknowledged, NULL);
+		group.generation = 0;
+		group.acknowledgeCount = 0;
+		group.counter = 0;
+	}
+
+	char buffer[128];
+	bigtime_t time = run_lock_groups(mutex_thread, kThreadsPerGroup, NULL);
+	printf("%" B_PRId32 " x %" B_PRId32 " threads locking mutexes: %s\n",
+		kLockGroupCount, kThreadsPerGroup, time_string(time, buffer));
+
+	for (int32 i = 0; i < kLockGroupCount; i++) {
+		if (sLockGroups[i].counter != kThreadsPerGroup * kLockIterations) {
+			fprintf(stderr, "Error: mutex %" B_PRId32 " didn't exclude!\n",
+				i);
+			exit(1);
+		}
+	}
+
+	time = run_lock_groups(waiter_thread, kThreadsPerGroup, broadcast_thread);
+	printf("%" B_PRId32 " x %" B_PRId32 " threads waiting for broadcasts: "
+		"%s\n", kLockGroupCount, kThreadsPerGroup, time_string(time, buffer));
+}
+
+
 int
 main(int argc, char** argv)
 {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s ( <command> [ <arguments> ] | "
+			"--user-mutex )\n", argv[0]);
+		exit(1);
+	}
+
+	bool userMutexBenchmark = strcmp(argv[1], "--user-mutex") == 0;
+
 	// get the initial contention info
 	spinlock_contention_info startInfo;
 	status_t error = _kern_generic_syscall(SPINLOCK_CONTENTION,
@@ -220,6 +364,11 @@ main(int argc, char** argv)
 	}
 
 	if (child == 0) {
+		if (userMutexBenchmark) {
+			user_mutex_benchmark();
+			exit(0);
+		}
+
 		execvp(argv[1], argv + 1);
 		fprintf(stderr, "Error: exec() failed: %s\n", strerror(errno));
 		exit(1);
@@ -249,10 +398,13 @@ main(int argc, char** argv)
 		time_string(tickTime, buffer));
 
 	// print results
-	static const char* const kLockNames[] = { "thread", "team", NULL };
+	static const char* const kLockNames[] = { "thread", "team", "user mutex",
+		NULL };
 	uint64 lockCounts[] = {
 		endInfo.thread_spinlock_counter - startInfo.thread_spinlock_counter,
-		endInfo.team_spinlock_counter - startInfo.team_spinlock_counter
+		endInfo.team_spinlock_counter - startInfo.team_spinlock_counter,
+		endInfo.user_mutex_spinlock_counter
+			- startInfo.user_mutex_spinlock_counter
 	};
 
 	printf("\nlock             counter            time   wasted %% CPU\n");
@@ -0,0 +1,444 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares the libroot allocator against the Hoard based one it replaced,
+	which is built from a copy of its sources kept with this test.
+	Runs a number of threads that allocate and free objects of different
+	sizes on their own, pairs of threads where one thread frees what the
+	other allocated, and measures how much memory is kept after a spike of
+	allocations has been freed again. Every object is checked for being
+	intact before it is freed.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+extern "C" {
+	status_t hoard___init_heap(void);
+	void* hoard_malloc(size_t size);
+	void hoard_free(void* address);
+}
+
+
+struct allocator_info {
+	const char*	name;
+	void*		(*allocate)(size_t size);
+	void		(*free)(void* address);
+};
+
+struct size_range {
+	const char*	name;
+	size_t		min;
+	size_t		max;
+};
+
+struct local_args {
+	const allocator_info*	allocator;
+	size_t					min_size;
+	size_t					max_size;
+	uint32					seed;
+	bool					failed;
+};
+
+struct ring_buffer {
+	void* volatile		slots[256];
+	volatile int32		head;
+	volatile int32		tail;
+};
+
+struct pair_args {
+	const allocator_info*	allocator;
+	ring_buffer*			ring;
+	uint32					seed;
+	bool					failed;
+};
+
+
+static const allocator_info kAllocators[] = {
+	{ "libroot", malloc, free },
+	{ "hoard", hoard_malloc, hoard_free }
+};
+static const int32 kAllocatorCount
+	= sizeof(kAllocators) / sizeof(kAllocators[0]);
+
+static const size_range kSizeRanges[] = {
+	{ "16-128", 16, 128 },
+	{ "16-1024", 16, 1024 },
+	{ "1k-32k", 1024, 32768 }
+};
+
+static const int32 kThreadCounts[] = { 1, 2, 4, 8 };
+static const int32 kPairCounts[] = { 1, 2, 4 };
+
+static const int32 kLocalIterations = 400000;
+static const int32 kLocalSlots = 1024;
+static const int32 kPairIterations = 200000;
+static const size_t kSpikeSize = 64 * 1024 * 1024;
+static const int32 kSpikeThreads = 4;
+
+
+static inline uint32
+random_next(uint32& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+
+static inline size_t
+random_size(uint32& state, size_t min, size_t max)
+{
+	return min + random_next(state) % (max - min + 1);
+}
+
+
+/*!	Marks the first and the last word of the object, and stores its size. */
+static inline void
+write_pattern(void* address, size_t size)
+{
+	size_t* words = (size_t*)address;
+	words[0] = size;
+	words[1] = (size_t)address ^ 0x5a5a5a5a;
+	memcpy((uint8*)address + size - sizeof(size_t), &words[1],
+		sizeof(size_t));
+}
+
+
+static inline bool
+check_pattern(void* address)
+{
+	size_t* words = (size_t*)address;
+	size_t size = words[0];
+	size_t tag;
+	memcpy(&tag, (uint8*)address + size - sizeof(size_t), sizeof(size_t));
+	return words[1] == ((size_t)address ^ 0x5a5a5a5a) && tag == words[1];
+}
+
+
+static size_t
+ram_size()
+{
+	size_t size = 0;
+	area_info info;
+	ssize_t cookie = 0;
+	while (get_next_area_info(B_CURRENT_TEAM, &cookie, &info) == B_OK)
+		size += info.ram_size;
+
+	return size;
+}
+
+
+static bigtime_t
+run_threads(thread_func function, void** arguments, int32 count)
+{
+	thread_id threads[16];
+	for (int32 i = 0; i < count; i++) {
+		threads[i] = spawn_thread(function, "malloc benchmark",
+			B_NORMAL_PRIORITY, arguments[i]);
+	}
+
+	bigtime_t startTime = system_time();
+	for (int32 i = 0; i < count; i++)
+		resume_thread(threads[i]);
+
+	for (int32 i = 0; i < count; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	return system_time() - startTime;
+}
+
+
+//	#pragma mark - workloads
+
+
+static status_t
+local_thread(void* _args)
+{
+	local_args* args = (local_args*)_args;
+	const allocator_info* allocator = args->allocator;
+
+	void* slots[kLocalSlots];
+	memset(slots, 0, sizeof(slots));
+
+	uint32 state = args->seed;
+	for (int32 i = 0; i < kLocalIterations; i++) {
+		void*& slot = slots[random_next(state) % kLocalSlots];
+		if (slot != NULL) {
+			if (!check_pattern(slot))
+				args->failed = true;
+			allocator->free(slot);
+		}
+
+		size_t size = random_size(state, args->min_size, args->max_size);
+		slot = allocator->allocate(size);
+		if (slot == NULL) {
+			args->failed = true;
+			break;
+		}
+		write_pattern(slot, size);
+	}
+
+	for (int32 i = 0; i < kLocalSlots; i++) {
+		if (slots[i] == NULL)
+			continue;
+		if (!check_pattern(slots[i]))
+			args->failed = true;
+		allocator->free(slots[i]);
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+producer_thread(void* _args)
+{
+	pair_args* args = (pair_args*)_args;
+	ring_buffer* ring = args->ring;
+
+	uint32 state = args->seed;
+	for (int32 i = 0; i < kPairIterations; i++) {
+		size_t size = random_size(state, 16, 512);
+		void* address = args->allocator->allocate(size);
+		if (address == NULL) {
+			args->failed = true;
+			size = 0;
+		} else
+			write_pattern(address, size);
+
+		int32 head = ring->head;
+		while (head - ring->tail == 256)
+			snooze(0);
+
+		ring->slots[head % 256] = address;
+		atomic_set((int32*)&ring->head, head + 1);
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+consumer_thread(void* _args)
+{
+	pair_args* args = (pair_args*)_args;
+	ring_buffer* ring = args->ring;
+
+	for (int32 i = 0; i < kPairIterations; i++) {
+		int32 tail = ring->tail;
+		while (atomic_get((int32*)&ring->head) == tail)
+			snooze(0);
+
+		void* address = ring->slots[tail % 256];
+		ring->tail = tail + 1;
+
+		if (address == NULL)
+			continue;
+		if (!check_pattern(address))
+			args->failed = true;
+		args->allocator->free(address);
+	}
+
+	return B_OK;
+}
+
+
+static bool
+run_local(const allocator_info& allocator, const size_range& range,
+	int32 threadCount)
+{
+	local_args args[16];
+	void* arguments[16];
+	for (int32 i = 0; i < threadCount; i++) {
+		args[i].allocator = &allocator;
+		args[i].min_size = range.min;
+		args[i].max_size = range.max;
+		args[i].seed = 0x1234567 + i * 7919;
+		args[i].failed = false;
+		arguments[i] = &args[i];
+	}
+
+	bigtime_t time = run_threads(local_thread, arguments, threadCount);
+
+	bool failed = false;
+	for (int32 i = 0; i < threadCount; i++)
+		failed |= args[i].failed;
+
+	printf("  %-8s %-8s %2d threads %10.1f ns/op\n", allocator.name,
+		range.name, (int)threadCount,
+		time * 1000.0 / kLocalIterations);
+	return !failed;
+}
+
+
+static bool
+run_pairs(const allocator_info& allocator, int32 pairCount)
+{
+	ring_buffer rings[8];
+	pair_args args[16];
+	void* arguments[16];
+	for (int32 i = 0; i < pairCount; i++) {
+		rings[i].head = 0;
+		rings[i].tail = 0;
+
+		for (int32 j = 0; j < 2; j++) {
+			pair_args& pairArgs = args[i * 2 + j];
+			pairArgs.allocator = &allocator;
+			pairArgs.ring = &rings[i];
+			pairArgs.seed = 0x7654321 + i * 104729;
+			pairArgs.failed = false;
+			arguments[i * 2 + j] = &pairArgs;
+		}
+	}
+
+	// the producers and consumers take turns in the argument list
+	thread_id threads[16];
+	for (int32 i = 0; i < pairCount * 2; i++) {
+		threads[i] = spawn_thread(i % 2 == 0 ? producer_thread
+				: consumer_thread, "malloc benchmark", B_NORMAL_PRIORITY,
+			arguments[i]);
+	}
+
+	bigtime_t startTime = system_time();
+	for (int32 i = 0; i < pairCount * 2; i++)
+		resume_thread(threads[i]);
+	for (int32 i = 0; i < pairCount * 2; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+	bigtime_t time = system_time() - startTime;
+
+	bool failed = false;
+	for (int32 i = 0; i < pairCount * 2; i++)
+		failed |= args[i].failed;
+
+	printf("  %-8s %2d pairs %10.1f ns/object\n", allocator.name,
+		(int)pairCount, time * 1000.0 / kPairIterations);
+	return !failed;
+}
+
+
+static status_t
+spike_thread(void* _args)
+{
+	local_args* args = (local_args*)_args;
+	const allocator_info* allocator = args->allocator;
+
+	size_t count = kSpikeSize / kSpikeThreads / 256;
+	void** objects = (void**)malloc(count * sizeof(void*));
+	if (objects == NULL) {
+		args->failed = true;
+		return B_OK;
+	}
+
+	uint32 state = args->seed;
+	for (size_t i = 0; i < count; i++) {
+		size_t size = random_size(state, 16, 496);
+		objects[i] = allocator->allocate(size);
+		if (objects[i] == NULL) {
+			args->failed = true;
+			count = i;
+			break;
+		}
+		write_pattern(objects[i], size);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (!check_pattern(objects[i]))
+			args->failed = true;
+		allocator->free(objects[i]);
+	}
+
+	free(objects);
+	return B_OK;
+}
+
+
+static bool
+run_spike(const allocator_info& allocator)
+{
+	size_t before = ram_size();
+
+	local_args args[kSpikeThreads];
+	void* arguments[kSpikeThreads];
+	for (int32 i = 0; i < kSpikeThreads; i++) {
+		args[i].allocator = &allocator;
+		args[i].seed = 0x2468ace + i * 31;
+		args[i].failed = false;
+		arguments[i] = &args[i];
+	}
+
+	run_threads(spike_thread, arguments, kSpikeThreads);
+	size_t afterFree = ram_size();
+
+	// give the allocator some time to return the memory, and then some
+	// activity to do it in
+	snooze(3000000);
+	for (int32 i = 0; i < 16; i++) {
+		void* address = allocator.allocate(64 * 1024);
+		allocator.free(address);
+		snooze(100000);
+	}
+	size_t afterDecay = ram_size();
+
+	bool failed = false;
+	for (int32 i = 0; i < kSpikeThreads; i++)
+		failed |= args[i].failed;
+
+	printf("  %-8s %7lu KB after free, %7lu KB after 4.6 s\n", allocator.name,
+		(unsigned long)(afterFree > before ? afterFree - before : 0) / 1024,
+		(unsigned long)(afterDecay > before ? afterDecay - before : 0) / 1024);
+	return !failed;
+}
+
+
+int
+main()
+{
+	if (hoard___init_heap() != B_OK) {
+		fprintf(stderr, "Could not initialize the Hoard heap!\n");
+		return 1;
+	}
+
+	bool ok = true;
+
+	puts("threads allocating and freeing on their own:");
+	for (size_t i = 0; i < sizeof(kSizeRanges) / sizeof(kSizeRanges[0]); i++) {
+		for (size_t j = 0; j < sizeof(kThreadCounts) / sizeof(kThreadCounts[0]);
+				j++) {
+			for (int32 k = 0; k < kAllocatorCount; k++)
+				ok &= run_local(kAllocators[k], kSizeRanges[i], kThreadCounts[j]);
+		}
+	}
+
+	puts("\nproducers allocating, consumers freeing:");
+	for (size_t i = 0; i < sizeof(kPairCounts) / sizeof(kPairCounts[0]); i++) {
+		for (int32 k = 0; k < kAllocatorCount; k++)
+			ok &= run_pairs(kAllocators[k], kPairCounts[i]);
+	}
+
+	printf("\nmemory kept after %lu MB have been allocated and freed:\n",
+		(unsigned long)kSpikeSize / 1024 / 1024);
+	for (int32 k = 0; k < kAllocatorCount; k++)
+		ok &= run_spike(kAllocators[k]);
+
+	if (!ok) {
+		fprintf(stderr, "Objects have been corrupted!\n");
+		return 1;
+	}
+
+	puts("All OK!");
+	return 0;
+}
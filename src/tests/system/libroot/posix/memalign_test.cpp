@@ -120,6 +120,10 @@ main(int argc, char *argv[])
 {
 	allocate_random_no_alignment(1024, B_PAGE_SIZE * 128);
 	allocate_random_random_alignment(1024, B_PAGE_SIZE * 128);
+	for (size_t alignment = 4 * 1024 * 1024; alignment <= 64 * 1024 * 1024;
+			alignment *= 4) {
+		allocate_random_fixed_alignment(8, B_PAGE_SIZE * 128, alignment);
+	}
 
 #ifdef MALLOC_DEBUG
 	dump_heap_list(0, NULL);
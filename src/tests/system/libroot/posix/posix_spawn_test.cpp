@@ -1,10 +1,273 @@
 #include <errno.h>
+#include <fcntl.h>
 #include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 
+extern char** environ;
+
+static const char* kTestFile = "/tmp/posix_spawn_test_file";
+
+static int sFailures = 0;
+
+
+static void
+check(bool condition, const char* what)
+{
+	printf("%s: %s\n", what, condition ? "ok" : "FAILED");
+	if (!condition)
+		sFailures++;
+}
+
+
+/*!	Runs \a command with the shell, and returns its exit status, or -1 if
+	it could not be started.
+*/
+static int
+run_shell(const char* command, const posix_spawn_file_actions_t* actions,
+	const posix_spawnattr_t* attributes, pid_t* _pid = NULL)
+{
+	char* args[] = { (char*)"/bin/sh", (char*)"-c", (char*)command, NULL };
+
+	pid_t pid;
+	if (posix_spawn(&pid, args[0], actions, attributes, args, environ) != 0)
+		return -1;
+	if (_pid != NULL)
+		*_pid = pid;
+
+	int status;
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+		return -1;
+
+	return WEXITSTATUS(status);
+}
+
+
+static bool
+file_contains(const char* path, const char* expected)
+{
+	char buffer[256];
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	ssize_t bytesRead = read(fd, buffer, sizeof(buffer) - 1);
+	close(fd);
+	if (bytesRead < 0)
+		return false;
+
+	buffer[bytesRead] = '\0';
+	return strcmp(buffer, expected) == 0;
+}
+
+
+static void
+test_open_dup2_close()
+{
+	// the actions must be performed in order: the file is opened as fd 9,
+	// becomes the child's stdout, and fd 9 is closed again
+	unlink(kTestFile);
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, 9, kTestFile,
+		O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	posix_spawn_file_actions_adddup2(&actions, 9, 1);
+	posix_spawn_file_actions_addclose(&actions, 9);
+
+	int status = run_shell("echo hello; (echo fail >&9) 2>/dev/null && exit 3;"
+		" exit 0", &actions, NULL);
+	posix_spawn_file_actions_destroy(&actions);
+
+	check(status == 0, "open/dup2/close: fd 9 closed in the child");
+	check(file_contains(kTestFile, "hello\n"),
+		"open/dup2/close: stdout went to the opened file");
+
+	unlink(kTestFile);
+}
+
+
+static void
+test_dup2_same_fd()
+{
+	// dup2() onto itself clears FD_CLOEXEC, so the child inherits the fd
+	unlink(kTestFile);
+
+	int fd = open(kTestFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || dup2(fd, 9) != 9) {
+		check(false, "dup2 same fd: setup");
+		return;
+	}
+	close(fd);
+	fcntl(9, F_SETFD, FD_CLOEXEC);
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, 9, 9);
+
+	int status = run_shell("echo inherited >&9", &actions, NULL);
+	posix_spawn_file_actions_destroy(&actions);
+	close(9);
+
+	check(status == 0 && file_contains(kTestFile, "inherited\n"),
+		"dup2 same fd: FD_CLOEXEC cleared in the child");
+
+	// without the action, the fd must not be inherited
+	fd = open(kTestFile, O_WRONLY | O_TRUNC | O_CLOEXEC);
+	if (fd >= 0 && fd != 9) {
+		dup2(fd, 9);
+		close(fd);
+		fcntl(9, F_SETFD, FD_CLOEXEC);
+	}
+
+	status = run_shell("(echo leaked >&9) 2>/dev/null", NULL, NULL);
+	close(9);
+
+	check(status != 0 && file_contains(kTestFile, ""),
+		"dup2 same fd: FD_CLOEXEC fd not inherited otherwise");
+
+	unlink(kTestFile);
+}
+
+
+static void
+test_open_umask()
+{
+	unlink(kTestFile);
+	mode_t oldMask = umask(022);
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, 9, kTestFile,
+		O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	int status = run_shell("exit 0", &actions, NULL);
+	posix_spawn_file_actions_destroy(&actions);
+	umask(oldMask);
+
+	struct stat st;
+	check(status == 0 && stat(kTestFile, &st) == 0
+			&& (st.st_mode & 0777) == 0644,
+		"open: umask applied to the created file");
+
+	unlink(kTestFile);
+}
+
+
+static void
+test_reset_ids()
+{
+	// With POSIX_SPAWN_RESETIDS, the open actions must use the reset
+	// effective user ID. This needs root to switch the real user ID.
+	if (geteuid() != 0) {
+		printf("POSIX_SPAWN_RESETIDS: skipped, needs root\n");
+		return;
+	}
+
+	unlink(kTestFile);
+	int fd = open(kTestFile, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		check(false, "POSIX_SPAWN_RESETIDS: setup");
+		return;
+	}
+	close(fd);
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, 9, kTestFile, O_RDONLY, 0);
+
+	posix_spawnattr_t attributes;
+	posix_spawnattr_init(&attributes);
+	posix_spawnattr_setflags(&attributes, POSIX_SPAWN_RESETIDS);
+
+	char* args[] = { (char*)"/bin/sh", (char*)"-c", (char*)"exit 0", NULL };
+	pid_t pid;
+	int error = -1;
+	if (setreuid(1000, 0) == 0) {
+		error = posix_spawn(&pid, args[0], &actions, &attributes, args,
+			environ);
+		setreuid(0, 0);
+	}
+	posix_spawn_file_actions_destroy(&actions);
+	posix_spawnattr_destroy(&attributes);
+
+	if (error == 0)
+		waitpid(pid, NULL, 0);
+
+	check(error == EACCES,
+		"POSIX_SPAWN_RESETIDS: open actions use the reset user ID");
+
+	unlink(kTestFile);
+}
+
+
+static void
+test_set_process_group()
+{
+	// The child waits for its stdin to be closed, so that its process group
+	// can be checked while it is still running.
+	int pipes[2];
+	if (pipe(pipes) != 0) {
+		check(false, "POSIX_SPAWN_SETPGROUP: setup");
+		return;
+	}
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, pipes[0], 0);
+	posix_spawn_file_actions_addclose(&actions, pipes[0]);
+	posix_spawn_file_actions_addclose(&actions, pipes[1]);
+
+	posix_spawnattr_t attributes;
+	posix_spawnattr_init(&attributes);
+	posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+	posix_spawnattr_setpgroup(&attributes, 0);
+
+	char* args[] = { (char*)"/bin/sh", (char*)"-c", (char*)"read line",
+		NULL };
+	pid_t pid;
+	int error = posix_spawn(&pid, args[0], &actions, &attributes, args,
+		environ);
+	posix_spawn_file_actions_destroy(&actions);
+	posix_spawnattr_destroy(&attributes);
+	close(pipes[0]);
+
+	if (error != 0) {
+		close(pipes[1]);
+		check(false, "POSIX_SPAWN_SETPGROUP: spawn");
+		return;
+	}
+
+	pid_t group = getpgid(pid);
+	close(pipes[1]);
+	waitpid(pid, NULL, 0);
+
+	check(group == pid && group != getpgrp(),
+		"POSIX_SPAWN_SETPGROUP: child leads a new process group");
+}
+
+
+static void
+test_missing_binary()
+{
+	char* args[] = { (char*)"/tmp/posix_spawn_test_missing", NULL };
+	unlink(args[0]);
+
+	pid_t pid = -1;
+	int error = posix_spawn(&pid, args[0], NULL, NULL, args, environ);
+	check(error == ENOENT, "posix_spawn: ENOENT for a missing binary");
+
+	error = posix_spawnp(&pid, "posix_spawn_test_missing", NULL, NULL, args,
+		environ);
+	check(error == ENOENT, "posix_spawnp: ENOENT for a missing binary");
+}
+
+
 int main()
 {
 
@@ -45,6 +308,17 @@ int main()
 		printf("posix_spawn: waitpid %d, %d\n", waitpid_res, errno);
 	}
 
+	test_open_dup2_close();
+	test_dup2_same_fd();
+	test_open_umask();
+	test_reset_ids();
+	test_set_process_group();
+	test_missing_binary();
+
+	if (sFailures > 0) {
+		printf("%d check(s) failed\n", sFailures);
+		return 1;
+	}
 	return 0;
 }
 
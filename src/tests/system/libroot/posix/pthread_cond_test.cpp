@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Checks that timed waiters that have been signalled by a broadcast while
+	the mutex is held succeed, even if they only get the mutex after their
+	timeout, and that a timed wait without a signal still times out.
+*/
+
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static const int kWaiterCount = 4;
+static const long kTimeout = 500000;
+	// in microseconds
+
+
+static pthread_mutex_t sMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sCondition = PTHREAD_COND_INITIALIZER;
+static int sWaiting = 0;
+static bool sSignalled = false;
+
+
+static void
+get_deadline(struct timespec& deadline, long timeout)
+{
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += timeout % 1000000 * 1000;
+	deadline.tv_sec += timeout / 1000000 + deadline.tv_nsec / 1000000000;
+	deadline.tv_nsec %= 1000000000;
+}
+
+
+static void*
+waiter_thread(void*)
+{
+	pthread_mutex_lock(&sMutex);
+
+	struct timespec deadline;
+	get_deadline(deadline, kTimeout);
+
+	sWaiting++;
+	int status = 0;
+	while (!sSignalled && status == 0)
+		status = pthread_cond_timedwait(&sCondition, &sMutex, &deadline);
+
+	pthread_mutex_unlock(&sMutex);
+	return (void*)(long)status;
+}
+
+
+static bool
+test_broadcast_with_mutex_held()
+{
+	pthread_t threads[kWaiterCount];
+	for (int i = 0; i < kWaiterCount; i++)
+		pthread_create(&threads[i], NULL, &waiter_thread, NULL);
+
+	// wait until all of them are waiting
+	while (true) {
+		pthread_mutex_lock(&sMutex);
+		if (sWaiting == kWaiterCount)
+			break;
+		pthread_mutex_unlock(&sMutex);
+		usleep(10000);
+	}
+
+	// Signal them, but keep the mutex until their timeout has passed. Some
+	// of them are moved over to the mutex, and must not give up on it.
+	sSignalled = true;
+	pthread_cond_broadcast(&sCondition);
+	usleep(kTimeout * 2);
+	pthread_mutex_unlock(&sMutex);
+
+	bool ok = true;
+	for (int i = 0; i < kWaiterCount; i++) {
+		void* result;
+		pthread_join(threads[i], &result);
+		if ((long)result != 0) {
+			fprintf(stderr, "waiter %d failed: %s\n", i,
+				strerror((long)result));
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+
+static bool
+test_timeout()
+{
+	pthread_mutex_lock(&sMutex);
+
+	struct timespec deadline;
+	get_deadline(deadline, kTimeout / 5);
+	int status = pthread_cond_timedwait(&sCondition, &sMutex, &deadline);
+
+	pthread_mutex_unlock(&sMutex);
+
+	if (status != ETIMEDOUT) {
+		fprintf(stderr, "timed wait without a signal returned: %s\n",
+			strerror(status));
+		return false;
+	}
+
+	return true;
+}
+
+
+int
+main()
+{
+	bool ok = test_broadcast_with_mutex_held();
+	ok &= test_timeout();
+
+	if (!ok)
+		return 1;
+
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares how long it takes to start a short-lived program with
+	posix_spawn() and with fork() followed by exec*(), first from a small
+	process, and then after the process has filled a large memory area
+	(1 GB by default) that fork() has to copy. Each measurement includes
+	waiting for the child to exit.
+*/
+
+
+#include <errno.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <OS.h>
+
+
+extern char** environ;
+
+
+struct spawn_method {
+	const char*	name;
+	status_t	(*start)(const char* path, char* const* args, pid_t& _pid);
+};
+
+
+static status_t
+start_posix_spawn(const char* path, char* const* args, pid_t& _pid)
+{
+	return posix_spawn(&_pid, path, NULL, NULL, args, environ);
+}
+
+
+static status_t
+start_fork_exec(const char* path, char* const* args, pid_t& _pid)
+{
+	pid_t pid = fork();
+	if (pid < 0)
+		return errno;
+
+	if (pid == 0) {
+		execve(path, args, environ);
+		_exit(127);
+	}
+
+	_pid = pid;
+	return B_OK;
+}
+
+
+static const spawn_method kMethods[] = {
+	{ "posix_spawn", start_posix_spawn },
+	{ "fork+exec", start_fork_exec }
+};
+static const int32 kMethodCount = sizeof(kMethods) / sizeof(kMethods[0]);
+
+
+static status_t
+measure(const spawn_method& method, const char* path, int32 iterations,
+	bigtime_t* times)
+{
+	char* args[] = { (char*)path, NULL };
+
+	for (int32 i = 0; i < iterations; i++) {
+		bigtime_t start = system_time();
+
+		pid_t pid;
+		status_t status = method.start(path, args, pid);
+		if (status != B_OK) {
+			fprintf(stderr, "%s: starting \"%s\" failed: %s\n", method.name,
+				path, strerror(status));
+			return status;
+		}
+
+		int exitStatus;
+		if (waitpid(pid, &exitStatus, 0) != pid) {
+			status = errno;
+			fprintf(stderr, "%s: waitpid() failed: %s\n", method.name,
+				strerror(status));
+			return status;
+		}
+
+		times[i] = system_time() - start;
+
+		if (!WIFEXITED(exitStatus) || WEXITSTATUS(exitStatus) != 0) {
+			fprintf(stderr, "%s: \"%s\" did not exit successfully\n",
+				method.name, path);
+			return B_ERROR;
+		}
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+run(const char* title, const char* path, int32 iterations)
+{
+	bigtime_t* times = new bigtime_t[iterations];
+
+	printf("%s\n", title);
+	printf("  %-12s %10s %10s %10s %10s\n", "method", "min", "median",
+		"average", "max");
+
+	status_t status = B_OK;
+	for (int32 i = 0; i < kMethodCount; i++) {
+		status = measure(kMethods[i], path, iterations, times);
+		if (status != B_OK)
+			break;
+
+		std::sort(times, times + iterations);
+
+		bigtime_t total = 0;
+		for (int32 j = 0; j < iterations; j++)
+			total += times[j];
+
+		printf("  %-12s %8" B_PRId64 "us %8" B_PRId64 "us %8" B_PRId64
+			"us %8" B_PRId64 "us\n", kMethods[i].name, times[0],
+			times[iterations / 2], total / iterations, times[iterations - 1]);
+	}
+
+	delete[] times;
+	return status;
+}
+
+
+static void
+usage(const char* program)
+{
+	fprintf(stderr, "Usage: %s [-i <iterations>] [-m <parent size in MB>] "
+		"[<program>]\n"
+		"Starts <program> (default: /bin/true) over and over with "
+		"posix_spawn() and\nwith fork() and exec*(), first from a small "
+		"process, and then from one that\nuses the given amount of memory "
+		"(default: 1024 MB).\n", program);
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 iterations = 100;
+	size_t parentSize = 1024;
+	const char* path = "/bin/true";
+
+	int option;
+	while ((option = getopt(argc, argv, "hi:m:")) != -1) {
+		switch (option) {
+			case 'i':
+				iterations = atoi(optarg);
+				break;
+			case 'm':
+				parentSize = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+
+	if (optind < argc)
+		path = argv[optind++];
+	if (optind < argc || iterations < 1)
+		usage(argv[0]);
+
+	if (run("small parent:", path, iterations) != B_OK)
+		return 1;
+
+	// Fill the memory, so that every page of it is actually there and has
+	// to be dealt with by fork().
+	parentSize *= 1024 * 1024;
+	void* address;
+	area_id area = create_area("spawn benchmark ballast", &address,
+		B_ANY_ADDRESS, parentSize, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+	if (area < 0) {
+		fprintf(stderr, "Could not create a %" B_PRIuSIZE " MB area: %s\n",
+			parentSize / 1024 / 1024, strerror(area));
+		return 1;
+	}
+	memset(address, 0xcc, parentSize);
+
+	char title[64];
+	snprintf(title, sizeof(title), "%" B_PRIuSIZE " MB parent:",
+		parentSize / 1024 / 1024);
+	status_t status = run(title, path, iterations);
+
+	delete_area(area);
+	return status == B_OK ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares the generic string functions to the SSE2 and AVX2 versions
+	libroot chooses from on x86_64, for strings of different lengths.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+#include <x86_64_string.h>
+
+
+extern "C" {
+	size_t generic_strlen(const char* string);
+	size_t generic_strnlen(const char* string, size_t count);
+	void* generic_memchr(const void* buffer, int c, size_t count);
+	char* generic_strchr(const char* string, int c);
+	char* generic_strchrnul(const char* string, int c);
+	char* generic_strrchr(const char* string, int c);
+	int generic_memcmp(const void* a, const void* b, size_t count);
+	int generic_strcmp(const char* a, const char* b);
+}
+
+
+static const x86_string_functions kGenericFunctions = {
+	generic_strlen,
+	generic_strnlen,
+	generic_memchr,
+	generic_strchr,
+	generic_strchrnul,
+	generic_strrchr,
+	generic_memcmp,
+	generic_strcmp
+};
+
+static const char* const kFunctionNames[] = {
+	"strlen", "strnlen", "memchr", "strchr", "strchrnul", "strrchr", "memcmp",
+	"strcmp"
+};
+static const int32 kFunctionCount
+	= sizeof(kFunctionNames) / sizeof(kFunctionNames[0]);
+
+static const size_t kLengths[] = { 8, 32, 128, 1024, 16384 };
+static const int32 kLengthCount = sizeof(kLengths) / sizeof(kLengths[0]);
+static const size_t kBytesPerRun = 256 * 1024 * 1024;
+
+
+/*!	Calls \a function of \a functions \a count times on strings of \a length
+	characters that don't contain the character searched for, so that the
+	whole string has to be looked at.
+*/
+static bigtime_t
+run(const x86_string_functions& functions, int32 function, const char* a,
+	const char* b, size_t length, int32 count)
+{
+	volatile size_t sink = 0;
+	size_t result = 0;
+
+	bigtime_t startTime = system_time();
+	for (int32 i = 0; i < count; i++) {
+		switch (function) {
+			case 0:
+				result += functions.strlen(a);
+				break;
+			case 1:
+				result += functions.strnlen(a, length + 1);
+				break;
+			case 2:
+				result += (size_t)functions.memchr(a, '#', length);
+				break;
+			case 3:
+				result += (size_t)functions.strchr(a, '#');
+				break;
+			case 4:
+				result += (size_t)functions.strchrnul(a, '#');
+				break;
+			case 5:
+				result += (size_t)functions.strrchr(a, '#');
+				break;
+			case 6:
+				result += functions.memcmp(a, b, length);
+				break;
+			case 7:
+				result += functions.strcmp(a, b);
+				break;
+		}
+	}
+	bigtime_t time = system_time() - startTime;
+
+	sink = result;
+	(void)sink;
+	return time;
+}
+
+
+int
+main()
+{
+	size_t maxLength = kLengths[kLengthCount - 1];
+	char* a = (char*)malloc(maxLength + 64);
+	char* b = (char*)malloc(maxLength + 64);
+	if (a == NULL || b == NULL) {
+		fprintf(stderr, "Could not allocate the strings!\n");
+		return 1;
+	}
+
+	const x86_string_functions* variants[] = {
+		&kGenericFunctions, &gX86SSE2StringFunctions, &gX86AVX2StringFunctions
+	};
+	const char* variantNames[] = { "generic", "sse2", "avx2" };
+	int32 variantCount = __builtin_cpu_supports("avx2") ? 3 : 2;
+
+	printf("%-10s %6s", "function", "length");
+	for (int32 variant = 0; variant < variantCount; variant++)
+		printf(" %15s", variantNames[variant]);
+	puts("   (ns per call)");
+
+	for (int32 function = 0; function < kFunctionCount; function++) {
+		for (int32 i = 0; i < kLengthCount; i++) {
+			size_t length = kLengths[i];
+
+			// start the strings at an odd address, as they often do
+			char* stringA = a + 1;
+			char* stringB = b + 3;
+			for (size_t j = 0; j < length; j++)
+				stringA[j] = stringB[j] = 'a' + j % 26;
+			stringA[length] = stringB[length] = '\0';
+
+			int32 count = kBytesPerRun / length / 16;
+			printf("%-10s %6lu", kFunctionNames[function],
+				(unsigned long)length);
+			for (int32 variant = 0; variant < variantCount; variant++) {
+				bigtime_t time = run(*variants[variant], function, stringA,
+					stringB, length, count);
+				printf(" %15.2f", time * 1000.0 / count);
+			}
+			putchar('\n');
+		}
+	}
+
+	free(a);
+	free(b);
+	return 0;
+}
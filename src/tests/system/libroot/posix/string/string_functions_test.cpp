@@ -0,0 +1,344 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Checks the string functions against straightforward reference versions,
+	for all alignments, and with the strings placed right in front of an
+	unmapped page, so that reading beyond what they are allowed to crashes.
+	On x86_64, all implementations libroot chooses from are tested, not only
+	the one it uses on this machine.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <OS.h>
+
+#ifdef __x86_64__
+#	include <x86_64_string.h>
+#endif
+
+
+struct string_functions {
+	const char*	name;
+	size_t		(*strlen)(const char* string);
+	size_t		(*strnlen)(const char* string, size_t count);
+	void*		(*memchr)(const void* buffer, int c, size_t count);
+	char*		(*strchr)(const char* string, int c);
+	char*		(*strchrnul)(const char* string, int c);
+	char*		(*strrchr)(const char* string, int c);
+	int			(*memcmp)(const void* a, const void* b, size_t count);
+	int			(*strcmp)(const char* a, const char* b);
+};
+
+
+static const size_t kMaxLength = 300;
+static const size_t kMaxTail = 64;
+static const char kCharacters[] = { 'a', 'x', (char)0xe6, (char)0x80 };
+
+static int32 sFailures;
+
+
+static void
+failed(const string_functions& functions, const char* function,
+	size_t length, size_t tail, size_t position)
+{
+	if (sFailures++ < 20) {
+		printf("%s %s() failed: length %lu, %lu bytes before the page end, "
+			"position %lu\n", functions.name, function, (unsigned long)length,
+			(unsigned long)tail, (unsigned long)position);
+	}
+}
+
+
+/*!	Returns two pages that are followed by an unmapped one. */
+static char*
+allocate_guarded_buffer()
+{
+	char* buffer = (char*)mmap(NULL, 3 * B_PAGE_SIZE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buffer == MAP_FAILED)
+		return NULL;
+
+	if (mprotect(buffer + 2 * B_PAGE_SIZE, B_PAGE_SIZE, PROT_NONE) != 0)
+		return NULL;
+
+	return buffer;
+}
+
+
+static inline int
+sign(int value)
+{
+	return value < 0 ? -1 : value > 0 ? 1 : 0;
+}
+
+
+/*!	Fills \a string with \a length characters that are not \a avoid, and
+	terminates it.
+*/
+static void
+fill_string(char* string, size_t length, char avoid)
+{
+	for (size_t i = 0; i < length; i++) {
+		char c = 'A' + i % 23;
+		string[i] = c != avoid ? c : 'z';
+	}
+	string[length] = '\0';
+}
+
+
+//	#pragma mark - reference implementations
+
+
+static size_t
+reference_strnlen(const char* string, size_t count)
+{
+	size_t length = 0;
+	while (length < count && string[length] != '\0')
+		length++;
+	return length;
+}
+
+
+static const char*
+reference_memchr(const char* buffer, char c, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (buffer[i] == c)
+			return buffer + i;
+	}
+	return NULL;
+}
+
+
+static const char*
+reference_strrchr(const char* string, char c)
+{
+	const char* last = NULL;
+	for (;; string++) {
+		if (*string == c)
+			last = string;
+		if (*string == '\0')
+			return last;
+	}
+}
+
+
+static int
+reference_memcmp(const char* a, const char* b, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		int difference = (uint8)a[i] - (uint8)b[i];
+		if (difference != 0)
+			return difference;
+	}
+	return 0;
+}
+
+
+static int
+reference_strcmp(const char* a, const char* b)
+{
+	for (size_t i = 0;; i++) {
+		int difference = (uint8)a[i] - (uint8)b[i];
+		if (difference != 0 || a[i] == '\0')
+			return difference;
+	}
+}
+
+
+//	#pragma mark - tests
+
+
+static void
+test_lengths(const string_functions& functions, char* pageEnd)
+{
+	for (size_t length = 0; length <= kMaxLength; length++) {
+		for (size_t tail = 0; tail < kMaxTail; tail++) {
+			char* string = pageEnd - tail - length - 1;
+			fill_string(string, length, '\0');
+
+			if (functions.strlen(string) != length)
+				failed(functions, "strlen", length, tail, 0);
+
+			size_t counts[] = { 0, length / 2, length, length + 1 };
+			for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+				if (functions.strnlen(string, counts[i])
+						!= reference_strnlen(string, counts[i])) {
+					failed(functions, "strnlen", length, tail, counts[i]);
+				}
+			}
+		}
+	}
+}
+
+
+static void
+test_searching(const string_functions& functions, char* pageEnd)
+{
+	for (size_t length = 0; length <= kMaxLength; length++) {
+		for (size_t tail = 0; tail < kMaxTail; tail++) {
+			char* string = pageEnd - tail - length - 1;
+
+			for (size_t i = 0; i < sizeof(kCharacters); i++) {
+				char c = kCharacters[i];
+				fill_string(string, length, c);
+
+				// put the character at no, one, and two positions
+				size_t positions[] = { length, length / 3, length - 1 };
+				for (size_t j = 0; j < 3; j++) {
+					size_t position = positions[j];
+					if (position < length)
+						string[position] = c;
+
+					if (functions.memchr(string, (uint8)c, length + 1)
+							!= reference_memchr(string, c, length + 1)) {
+						failed(functions, "memchr", length, tail, position);
+					}
+					if (functions.memchr(string, (uint8)c, length / 2)
+							!= reference_memchr(string, c, length / 2)) {
+						failed(functions, "memchr", length, tail, position);
+					}
+
+					const char* first = reference_memchr(string, c, length);
+					if (functions.strchr(string, (uint8)c) != first)
+						failed(functions, "strchr", length, tail, position);
+					if (functions.strchrnul(string, (uint8)c)
+							!= (first != NULL ? first : string + length)) {
+						failed(functions, "strchrnul", length, tail, position);
+					}
+					if (functions.strrchr(string, (uint8)c)
+							!= reference_strrchr(string, c)) {
+						failed(functions, "strrchr", length, tail, position);
+					}
+				}
+			}
+
+			// the terminating null character can be searched for, too
+			fill_string(string, length, '\0');
+			if (functions.strchr(string, '\0') != string + length
+				|| functions.strchrnul(string, '\0') != string + length) {
+				failed(functions, "strchr", length, tail, length);
+			}
+			if (functions.strrchr(string, '\0') != string + length)
+				failed(functions, "strrchr", length, tail, length);
+			if (functions.memchr(string, '\0', length + 1) != string + length)
+				failed(functions, "memchr", length, tail, length);
+		}
+	}
+}
+
+
+static void
+test_comparing(const string_functions& functions, char* pageEndA,
+	char* pageEndB)
+{
+	for (size_t length = 0; length <= kMaxLength / 2; length++) {
+		for (size_t tailA = 0; tailA < kMaxTail / 2; tailA++) {
+			for (size_t tailB = 0; tailB < kMaxTail / 2; tailB++) {
+				char* a = pageEndA - tailA - length - 1;
+				char* b = pageEndB - tailB - length - 1;
+				fill_string(a, length, '\0');
+				fill_string(b, length, '\0');
+
+				// differ at no position, and at the first, the middle, and
+				// the last one, with characters below and above 0x80
+				size_t positions[] = { length, 0, length / 2, length - 1 };
+				for (size_t i = 0; i < 4; i++) {
+					size_t position = positions[i];
+					if (position > length)
+						continue;
+
+					for (size_t j = 0; j < sizeof(kCharacters); j++) {
+						char saved = b[position];
+						if (position < length)
+							b[position] = kCharacters[j];
+
+						if (sign(functions.memcmp(a, b, length))
+								!= sign(reference_memcmp(a, b, length))) {
+							failed(functions, "memcmp", length, tailA,
+								position);
+						}
+						if (sign(functions.strcmp(a, b))
+								!= sign(reference_strcmp(a, b))
+							|| sign(functions.strcmp(b, a))
+								!= sign(reference_strcmp(b, a))) {
+							failed(functions, "strcmp", length, tailA,
+								position);
+						}
+
+						b[position] = saved;
+					}
+				}
+
+				// a prefix of the other string
+				if (length > 0) {
+					b[length - 1] = '\0';
+					if (sign(functions.strcmp(a, b)) != 1
+						|| sign(functions.strcmp(b, a)) != -1) {
+						failed(functions, "strcmp", length, tailA, length - 1);
+					}
+				}
+			}
+		}
+	}
+}
+
+
+static void
+test(const string_functions& functions, char* bufferA, char* bufferB)
+{
+	int32 failures = sFailures;
+
+	char* pageEndA = bufferA + 2 * B_PAGE_SIZE;
+	char* pageEndB = bufferB + 2 * B_PAGE_SIZE;
+	test_lengths(functions, pageEndA);
+	test_searching(functions, pageEndA);
+	test_comparing(functions, pageEndA, pageEndB);
+
+	printf("%s: %s\n", functions.name, sFailures == failures ? "ok" : "FAILED");
+}
+
+
+int
+main()
+{
+	char* bufferA = allocate_guarded_buffer();
+	char* bufferB = allocate_guarded_buffer();
+	if (bufferA == NULL || bufferB == NULL) {
+		fprintf(stderr, "Could not allocate the buffers!\n");
+		return 1;
+	}
+
+	string_functions libroot = { "libroot", strlen, strnlen, memchr, strchr,
+		strchrnul, strrchr, memcmp, strcmp };
+	test(libroot, bufferA, bufferB);
+
+#ifdef __x86_64__
+	const x86_string_functions* variants[] = {
+		&gX86SSE2StringFunctions, &gX86AVX2StringFunctions
+	};
+	const char* names[] = { "sse2", "avx2" };
+	for (int i = 0; i < 2; i++) {
+		if (i == 1 && !__builtin_cpu_supports("avx2")) {
+			printf("avx2: not supported\n");
+			continue;
+		}
+
+		const x86_string_functions& variant = *variants[i];
+		string_functions functions = { names[i], variant.strlen,
+			variant.strnlen, variant.memchr, variant.strchr,
+			variant.strchrnul, variant.strrchr, variant.memcmp,
+			variant.strcmp };
+		test(functions, bufferA, bufferB);
+	}
+#endif
+
+	return sFailures == 0 ? 0 : 1;
+}
@@ -29,6 +29,7 @@ const RP_COPY_RECT_NO_CLIPPING = 61;
 const RP_INVERT_RECT = 62;
 const RP_DRAW_BITMAP = 63;
 const RP_DRAW_BITMAP_RECTS = 64;
+const RP_DRAW_BITMAP_TILED = 65;
 
 const RP_STROKE_ARC = 80;
 const RP_STROKE_BEZIER = 81;
@@ -92,6 +93,24 @@ const RP_UNMAPPED_KEY_UP = 243;
 const RP_MODIFIERS_CHANGED = 244;
 
 
+// capabilities announced with RP_INIT_CONNECTION
+const RP_CAPABILITY_TILED_BITMAPS = 0x01;
+
+
+// tiled bitmaps, see BitmapTiles.h
+const RP_TILE_CACHED = 0;
+const RP_TILE_SOLID = 1;
+const RP_TILE_RAW = 2;
+const RP_TILE_PACKED = 3;
+
+const RP_TILE_OP_REPEAT = 0;
+const RP_TILE_OP_COPY_ABOVE = 1;
+const RP_TILE_OP_LITERAL = 2;
+
+const kBitmapTileSize = 64;
+const kBitmapTileSlotCount = 512;
+
+
 // drawing_mode
 const B_OP_COPY = 0;
 const B_OP_OVER = 1;
@@ -658,32 +677,10 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 	var imageData = context.createImageData(this.width, this.height);
 	switch (this.colorSpace) {
 		case B_RGBA32:
-			remoteMessage.dataView.readInto(imageData.data);
-			var output = new Uint32Array(imageData.data.buffer);
-
-			for (var i = 0; i < imageData.data.length / 4; i++) {
-				output[i] = (output[i] & 0xff) << 16 | (output[i] >> 16 & 0xff)
-					| (output[i] & 0xff00ff00);
-			}
-
-			if (unsetAlpha) {
-				for (var i = 0; i < imageData.data.length / 4; i++)
-					output[i] |= 0xff000000;
-			}
-
-			break;
-
 		case B_RGB32:
 			remoteMessage.dataView.readInto(imageData.data);
-			var output = new Uint32Array(imageData.data.buffer);
-
-			for (var i = 0; i < imageData.data.length / 4; i++) {
-				output[i] = (output[i] & 0xff) << 16 | (output[i] >> 16 & 0xff)
-					| (output[i] & 0xff00) | 0xff000000;
-
-				if (!unsetAlpha && output[i] == B_TRANSPARENT_MAGIC_RGBA32)
-					output[i] &= 0x00ffffff;
-			}
+			this.convertPixels(new Uint32Array(imageData.data.buffer),
+				unsetAlpha);
 			break;
 
 		case B_RGB24:
@@ -768,6 +765,258 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 }
 
 
+RemoteBitmap.prototype.readTiledFrom = function(remoteMessage, unsetAlpha,
+	tileStore)
+{
+	this.width = remoteMessage.dataView.readUint32();
+	this.height = remoteMessage.dataView.readUint32();
+	this.colorSpace = remoteMessage.dataView.readUint32();
+	this.flags = remoteMessage.dataView.readUint32();
+
+	var length = remoteMessage.dataView.readUint32();
+	var where = remoteMessage.dataView.dataView.byteOffset
+		+ remoteMessage.dataView.position;
+	var data = remoteMessage.buffer.subarray(where, where + length);
+	remoteMessage.dataView.position += length;
+
+	this.canvas = document.createElement('canvas');
+	this.canvas.width = this.width;
+	this.canvas.height = this.height;
+
+	var context = this.canvas.getContext('2d');
+	var imageData = context.createImageData(this.width, this.height);
+	var output = new Uint32Array(imageData.data.buffer);
+
+	tileStore.decode(data, output, this.width, this.height);
+	this.convertPixels(output, unsetAlpha);
+
+	context.putImageData(imageData, 0, 0);
+	return this;
+}
+
+
+RemoteBitmap.prototype.convertPixels = function(output, unsetAlpha)
+{
+	if (this.colorSpace == B_RGBA32) {
+		for (var i = 0; i < output.length; i++) {
+			output[i] = (output[i] & 0xff) << 16 | (output[i] >> 16 & 0xff)
+				| (output[i] & 0xff00ff00);
+		}
+
+		if (unsetAlpha) {
+			for (var i = 0; i < output.length; i++)
+				output[i] |= 0xff000000;
+		}
+
+		return;
+	}
+
+	for (var i = 0; i < output.length; i++) {
+		output[i] = (output[i] & 0xff) << 16 | (output[i] >> 16 & 0xff)
+			| (output[i] & 0xff00) | 0xff000000;
+
+		if (!unsetAlpha && output[i] == B_TRANSPARENT_MAGIC_RGBA32)
+			output[i] &= 0x00ffffff;
+	}
+}
+
+
+function RemoteTileStore()
+{
+	this.makeEmpty();
+}
+
+
+RemoteTileStore.prototype.makeEmpty = function()
+{
+	this.slots = new Array(kBitmapTileSlotCount);
+}
+
+
+RemoteTileStore.prototype.decode = function(data, output, width, height)
+{
+	var view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+	var position = 0;
+
+	for (var top = 0; top < height; top += kBitmapTileSize) {
+		var tileHeight = Math.min(kBitmapTileSize, height - top);
+
+		for (var left = 0; left < width; left += kBitmapTileSize) {
+			var tileWidth = Math.min(kBitmapTileSize, width - left);
+			var type = view.getUint8(position++);
+
+			if (type == RP_TILE_SOLID) {
+				var color = view.getUint32(position, true);
+				position += 4;
+
+				for (var y = 0; y < tileHeight; y++) {
+					var start = (top + y) * width + left;
+					output.fill(color, start, start + tileWidth);
+				}
+				continue;
+			}
+
+			var slot = view.getUint16(position, true);
+			position += 2;
+			if (slot >= kBitmapTileSlotCount)
+				throw 'invalid tile slot ' + slot;
+
+			var tile;
+			switch (type) {
+				case RP_TILE_CACHED:
+					tile = this.slots[slot];
+					if (!tile || tile.width != tileWidth
+						|| tile.height != tileHeight) {
+						throw 'unknown tile in slot ' + slot;
+					}
+					break;
+
+				case RP_TILE_RAW:
+					var length = tileWidth * tileHeight * 4;
+					tile = {
+						width: tileWidth,
+						height: tileHeight,
+						pixels: new Uint32Array(
+							data.slice(position, position + length).buffer)
+					};
+					position += length;
+					this.slots[slot] = tile;
+					break;
+
+				case RP_TILE_PACKED:
+					var length = view.getUint16(position, true);
+					position += 2;
+					tile = {
+						width: tileWidth,
+						height: tileHeight,
+						pixels: this.unpack(data.subarray(position,
+							position + length), tileWidth, tileHeight)
+					};
+					position += length;
+					this.slots[slot] = tile;
+					break;
+
+				default:
+					throw 'unknown tile type ' + type;
+			}
+
+			for (var y = 0; y < tileHeight; y++) {
+				output.set(tile.pixels.subarray(y * tileWidth,
+					(y + 1) * tileWidth), (top + y) * width + left);
+			}
+		}
+	}
+}
+
+
+RemoteTileStore.prototype.unpack = function(data, width, height)
+{
+	var view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+	var pixels = new Uint32Array(width * height);
+	var position = 0;
+	var previous = 0;
+
+	var index = 0;
+	while (index < pixels.length) {
+		var operation = view.getUint8(position++);
+		var count = (operation & 0x3f) + 1;
+		if (count > pixels.length - index)
+			throw 'packed tile overflows';
+
+		switch (operation >> 6) {
+			case RP_TILE_OP_REPEAT:
+				pixels.fill(previous, index, index + count);
+				break;
+
+			case RP_TILE_OP_COPY_ABOVE:
+				if (index < width)
+					throw 'packed tile copies from above the first row';
+
+				// may overlap with what we are writing, so no copyWithin()
+				for (var i = index; i < index + count; i++)
+					pixels[i] = pixels[i - width];
+				break;
+
+			case RP_TILE_OP_LITERAL:
+				for (var i = index; i < index + count; i++) {
+					pixels[i] = view.getUint32(position, true);
+					position += 4;
+				}
+				break;
+
+			default:
+				throw 'unknown packed tile operation ' + operation;
+		}
+
+		index += count;
+		previous = pixels[index - 1];
+	}
+
+	return pixels;
+}
+
+
+/*!	Counts what comes in, and how long it takes the server to start
+	answering an interaction, that is a click, key press, or wheel turn.
+	Open the page with "?statistics" to have it logged every few seconds, or
+	call gSession.statistics.report() from the console.
+*/
+function RemoteStatistics()
+{
+	this.reset();
+}
+
+
+RemoteStatistics.prototype.reset = function()
+{
+	this.bytes = 0;
+	this.messages = 0;
+	this.interactions = 0;
+	this.answered = 0;
+	this.latencySum = 0;
+	this.maxLatency = 0;
+	this.interactionStart = undefined;
+	this.startTime = performance.now();
+}
+
+
+RemoteStatistics.prototype.interactionStarted = function()
+{
+	this.interactions++;
+	if (this.interactionStart === undefined)
+		this.interactionStart = performance.now();
+}
+
+
+RemoteStatistics.prototype.received = function(byteCount, messageCount)
+{
+	this.bytes += byteCount;
+	this.messages += messageCount;
+
+	if (this.interactionStart !== undefined && messageCount > 0) {
+		var latency = performance.now() - this.interactionStart;
+		this.latencySum += latency;
+		this.maxLatency = Math.max(this.maxLatency, latency);
+		this.answered++;
+		this.interactionStart = undefined;
+	}
+}
+
+
+RemoteStatistics.prototype.report = function()
+{
+	var seconds = (performance.now() - this.startTime) / 1000;
+	var interactions = Math.max(this.interactions, 1);
+	var answered = Math.max(this.answered, 1);
+
+	return this.bytes + ' bytes in ' + this.messages + ' messages, '
+		+ Math.round(this.bytes / seconds) + ' bytes/s, '
+		+ Math.round(this.bytes / interactions) + ' bytes per interaction, '
+		+ 'latency ' + (this.latencySum / answered).toFixed(1) + ' ms average, '
+		+ this.maxLatency.toFixed(1) + ' ms max';
+}
+
+
 function RemotePattern(remoteMessage)
 {
 	this.data = new Uint8Array(8);
@@ -1294,6 +1543,23 @@ RemoteState.prototype.messageReceived = function(remoteMessage, reply)
 				viewRect.top, viewRect.width(), viewRect.height());
 			break;
 
+		case RP_DRAW_BITMAP_TILED:
+			this.applyContext();
+
+			var bitmapRect = new RemoteRect(remoteMessage);
+			var viewRect = new RemoteRect(remoteMessage);
+			var options = remoteMessage.dataView.readUint32();
+
+			if (options != 0)
+				console.warn('bitmap options not supported: ' + options);
+
+			var bitmap = new RemoteBitmap().readTiledFrom(remoteMessage,
+				this.unsetAlpha, this.session.tileStore);
+			context.drawImage(bitmap.canvas, bitmapRect.left, bitmapRect.top,
+				bitmapRect.width(), bitmapRect.height(), viewRect.left,
+				viewRect.top, viewRect.width(), viewRect.height());
+			break;
+
 		case RP_DRAW_BITMAP_RECTS:
 			this.applyContext();
 
@@ -1769,6 +2035,9 @@ function RemoteDesktopSession(targetElement, width, height, targetAddress,
 
 	this.receiveMessage = new RemoteMessage();
 
+	this.tileStore = new RemoteTileStore();
+	this.statistics = new RemoteStatistics();
+
 	this.container = document.createElement('div');
 	this.container.className = 'session';
 	this.container.style.position = 'relative';
@@ -1834,6 +2103,7 @@ RemoteDesktopSession.prototype.onMessage = function(message)
 		data = new Uint8Array(data);
 
 	var byteOffset = 0;
+	var messageCount = 0;
 	while (true) {
 		try {
 			if (!this.receiveMessage.attach(data, byteOffset))
@@ -1852,8 +2122,11 @@ RemoteDesktopSession.prototype.onMessage = function(message)
 		}
 
 		byteOffset += this.receiveMessage.size();
+		messageCount++;
 	}
 
+	this.statistics.received(message.data.byteLength, messageCount);
+
 	if (data.byteLength > byteOffset)
 		this.messageRemainder = data.slice(byteOffset);
 }
@@ -2037,7 +2310,10 @@ RemoteDesktopSession.prototype.removeClipping = function()
 
 RemoteDesktopSession.prototype.init = function()
 {
+	this.tileStore.makeEmpty();
+
 	this.sendMessage.start(RP_INIT_CONNECTION);
+	this.sendMessage.dataView.writeUint32(RP_CAPABILITY_TILED_BITMAPS);
 	this.sendMessage.flush();
 }
 
@@ -2067,6 +2343,7 @@ RemoteDesktopSession.prototype.onMouseMove = function(event)
 RemoteDesktopSession.prototype.onMouseDown = function(event)
 {
 	this.canvas.focus();
+	this.statistics.interactionStarted();
 	this.sendMessage.start(RP_MOUSE_DOWN);
 	this.sendMessage.dataView.writeFloat32(event.offsetX);
 	this.sendMessage.dataView.writeFloat32(event.offsetY);
@@ -2079,6 +2356,7 @@ RemoteDesktopSession.prototype.onMouseDown = function(event)
 
 RemoteDesktopSession.prototype.onMouseUp = function(event)
 {
+	this.statistics.interactionStarted();
 	this.sendMessage.start(RP_MOUSE_UP);
 	this.sendMessage.dataView.writeFloat32(event.offsetX);
 	this.sendMessage.dataView.writeFloat32(event.offsetY);
@@ -2168,6 +2446,7 @@ RemoteDesktopSession.prototype.onKeyDownUp = function(event)
 		return;
 	}
 
+	this.statistics.interactionStarted();
 	this.sendMessage.start(keyDown ? RP_KEY_DOWN : RP_KEY_UP);
 	if (event.key.length == 1)
 		this.sendMessage.dataView.writeString(event.key);
@@ -2188,6 +2467,7 @@ RemoteDesktopSession.prototype.onKeyDownUp = function(event)
 
 RemoteDesktopSession.prototype.onKeyPress = function(event)
 {
+	this.statistics.interactionStarted();
 	this.sendMessage.start(RP_KEY_DOWN);
 	this.sendMessage.dataView.writeUint32(1);
 	this.sendMessage.dataView.writeUint8(event.which);
@@ -2202,6 +2482,7 @@ RemoteDesktopSession.prototype.onKeyPress = function(event)
 
 RemoteDesktopSession.prototype.onWheel = function(event)
 {
+	this.statistics.interactionStarted();
 	this.sendMessage.start(RP_MOUSE_WHEEL_CHANGED);
 	this.sendMessage.dataView.writeFloat32(event.deltaX);
 	this.sendMessage.dataView.writeFloat32(event.deltaY);
@@ -2238,4 +2519,11 @@ function init()
 			gSession = new RemoteDesktopSession(document.body, widthInput.value,
 				heightInput.value, targetAddressInput.value, onDisconnect);
 		};
+
+	if (new URLSearchParams(window.location.search).has('statistics')) {
+		window.setInterval(function() {
+				if (gSession)
+					console.log('statistics: ' + gSession.statistics.report());
+			}, 5000);
+	}
 }